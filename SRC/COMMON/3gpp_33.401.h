@@ -58,4 +58,10 @@
  */
 #define MAX_EPS_AUTH_VECTORS          1
 
+/* Vectors of an S6A AIA (Number-Of-Requested-Vectors, TS 29.272 7.3.15).
+ * The MME may prefetch them, the vectors not used at once are kept for the next
+ * authentications of the UE and used in SQN order, see nas_auth_vectors.c.
+ */
+#define MAX_EPS_AUTH_VECTORS_PREFETCH 5
+
 #endif /* FILE_3GPP_33_401_SEEN */
@@ -29,6 +29,7 @@
 
 #define _GNU_SOURCE
 #include <pthread.h>
+#include <sched.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
@@ -40,10 +41,6 @@
 #include <sys/epoll.h>
 #include <sys/eventfd.h>
 
-
-
-#include "liblfds611.h"
-
 #include "assertions.h"
 #include "intertask_interface.h"
 #include "intertask_interface_dump.h"
@@ -87,13 +84,15 @@ typedef enum task_state_s {
   TASK_STATE_NOT_CONFIGURED, TASK_STATE_STARTING, TASK_STATE_READY, TASK_STATE_ENDED, TASK_STATE_MAX,
 } task_state_t;
 
-/* This list acts as a FIFO of messages received by tasks (RRC, NAS, ...) */
-typedef struct message_list_s {
-  MessageDef                             *msg;  ///< Pointer to the message
-
-  message_number_t                        message_number;       ///< Unique message number
-  uint32_t                                message_priority;     ///< Message priority
-} message_list_t;
+/* FIFO of messages received by a task (RRC, NAS, ...), intrusive multiple producers
+   single consumer queue (D. Vyukov): messages are linked by their header so that
+   enqueuing does not allocate, any thread can enqueue, only the task thread dequeues.
+*/
+typedef struct message_queue_s {
+  MessageHeader                          *head;  ///< Last enqueued message, exchanged by producers
+  MessageHeader                          *tail;  ///< Next message to dequeue, consumer only
+  MessageHeader                           stub;  ///< Keeps the queue non empty for producers
+} message_queue_t;
 
 typedef struct thread_desc_s {
   /*
@@ -132,6 +131,17 @@ typedef struct thread_desc_s {
 
   int                                     epoll_nb_events;
 
+  /*
+   * Set while the thread is about to block in epoll_wait, senders only
+   * * * signal the thread fd in this case (wakeups coalescing).
+   */
+  int                                     waiting;
+
+  /*
+   * Messages the thread can still dequeue before polling again its fds
+   */
+  int                                     batch_left;
+
   //#ifdef RTAI
   /*
    * Flag to mark real time thread
@@ -149,7 +159,7 @@ typedef struct task_desc_s {
   /*
    * Queue of messages belonging to the task
    */
-  struct lfds611_queue_state             *message_queue;
+  message_queue_t                         message_queue;
 } task_desc_t;
 
 typedef struct itti_desc_s {
@@ -188,6 +198,77 @@ typedef struct itti_desc_s {
 
 static itti_desc_t                      itti_desc;
 
+static inline void
+itti_queue_init (
+  message_queue_t * queue)
+{
+  queue->stub.nextInQueue = NULL;
+  queue->head = &queue->stub;
+  queue->tail = &queue->stub;
+}
+
+/* element is a message or the stub of the queue */
+static inline void
+itti_queue_push (
+  message_queue_t * queue,
+  void *element)
+{
+  MessageHeader                          *header = (MessageHeader *) element;
+  MessageHeader                          *prev;
+
+  header->nextInQueue = NULL;
+  prev = __atomic_exchange_n (&queue->head, header, __ATOMIC_SEQ_CST);
+  /*
+   * Until this store the consumer cannot reach header (nor the messages enqueued after it)
+   */
+  __atomic_store_n (&prev->nextInQueue, header, __ATOMIC_RELEASE);
+}
+
+static inline bool
+itti_queue_is_empty (
+  message_queue_t * queue)
+{
+  return (__atomic_load_n (&queue->head, __ATOMIC_SEQ_CST) == &queue->stub);
+}
+
+/* Returns NULL if the queue is empty or if a producer did not complete its push yet */
+static inline MessageDef               *
+itti_queue_pop (
+  message_queue_t * queue)
+{
+  MessageHeader                          *tail = queue->tail;
+  MessageHeader                          *next = __atomic_load_n (&tail->nextInQueue, __ATOMIC_ACQUIRE);
+
+  if (tail == &queue->stub) {
+    if (next == NULL) {
+      return NULL;
+    }
+
+    queue->tail = next;
+    tail = next;
+    next = __atomic_load_n (&next->nextInQueue, __ATOMIC_ACQUIRE);
+  }
+
+  if (next == NULL) {
+    if (tail != __atomic_load_n (&queue->head, __ATOMIC_ACQUIRE)) {
+      return NULL;
+    }
+
+    /*
+     * tail is the last message, put back the stub behind it to dequeue it
+     */
+    itti_queue_push (queue, &queue->stub);
+    next = __atomic_load_n (&tail->nextInQueue, __ATOMIC_ACQUIRE);
+
+    if (next == NULL) {
+      return NULL;
+    }
+  }
+
+  queue->tail = next;
+  return (MessageDef *) (void *) tail;
+}
+
 void                                   *
 itti_malloc (
   task_id_t origin_task_id,
@@ -381,7 +462,6 @@ itti_send_msg_to_task (
 {
   thread_id_t                             destination_thread_id;
   task_id_t                               origin_task_id;
-  message_list_t                         *new;
   uint32_t                                priority;
   message_number_t                        message_number;
   uint32_t                                message_id;
@@ -421,26 +501,20 @@ itti_send_msg_to_task (
       AssertFatal (itti_desc.threads[destination_thread_id].task_state == TASK_STATE_READY,
                    "Task %s Cannot send message %s (%d) to thread %d, it is not in ready state (%d)!\n",
                    itti_get_task_name (origin_task_id), itti_desc.messages_info[message_id].name, message_id, destination_thread_id, itti_desc.threads[destination_thread_id].task_state);
-      /*
-       * Allocate new list element
-       */
-      new = (message_list_t *) itti_malloc (origin_task_id, destination_task_id, sizeof (struct message_list_s));
-      /*
-       * Fill in members
-       */
-      new->msg = message;
-      new->message_number = message_number;
-      new->message_priority = priority;
       /*
        * Enqueue message in destination task queue
        */
-      lfds611_queue_enqueue (itti_desc.tasks[destination_task_id].message_queue, new);
+      itti_queue_push (&itti_desc.tasks[destination_task_id].message_queue, message);
       VCD_SIGNAL_DUMPER_DUMP_FUNCTION_BY_NAME (VCD_SIGNAL_DUMPER_FUNCTIONS_ITTI_ENQUEUE_MESSAGE, VCD_FUNCTION_OUT);
       {
         /*
-         * Only use event fd for tasks, subtasks will pool the queue
+         * Only use event fd for tasks, subtasks will pool the queue.
+         * * * The thread is only signaled if it is waiting, it dequeues
+         * * * all pending messages before waiting again.
          */
-        if (TASK_GET_PARENT_TASK_ID (destination_task_id) == TASK_UNKNOWN) {
+        if ((TASK_GET_PARENT_TASK_ID (destination_task_id) == TASK_UNKNOWN) &&
+            (__atomic_load_n (&itti_desc.threads[destination_thread_id].waiting, __ATOMIC_SEQ_CST)) &&
+            (__atomic_exchange_n (&itti_desc.threads[destination_thread_id].waiting, 0, __ATOMIC_SEQ_CST))) {
           ssize_t                                 write_ret;
           eventfd_t                               sem_counter = 1;
 
@@ -538,21 +612,45 @@ itti_get_events (
   return itti_desc.threads[thread_id].epoll_nb_events;
 }
 
-static inline void
+static inline int
 itti_receive_msg_internal_event_fd (
   task_id_t task_id,
   uint8_t polling,
-  MessageDef ** received_msg)
+  MessageDef ** received_msgs,
+  int max_msgs)
 {
   thread_id_t                             thread_id;
+  message_queue_t                        *queue;
   int                                     epoll_ret = 0;
   int                                     epoll_timeout = 0;
+  int                                     nb_msgs = 0;
   int                                     i;
 
   AssertFatal (task_id < itti_desc.task_max, "Task id (%d) is out of range (%d)!\n", task_id, itti_desc.task_max);
-  AssertFatal (received_msg != NULL, "Received message is NULL!\n");
+  AssertFatal (received_msgs != NULL, "Received message is NULL!\n");
+  AssertFatal (max_msgs > 0, "No room for received messages!\n");
   thread_id = TASK_GET_THREAD_ID (task_id);
-  *received_msg = NULL;
+  queue = &itti_desc.tasks[task_id].message_queue;
+
+  if (itti_desc.threads[thread_id].batch_left > 0) {
+    /*
+     * Messages enqueued since the last epoll_wait, the other fds have
+     * * * already been reported with the first messages of the batch.
+     */
+    if (max_msgs > itti_desc.threads[thread_id].batch_left) {
+      max_msgs = itti_desc.threads[thread_id].batch_left;
+    }
+
+    while ((nb_msgs < max_msgs) && ((received_msgs[nb_msgs] = itti_queue_pop (queue)) != NULL)) {
+      nb_msgs++;
+    }
+
+    if (nb_msgs > 0) {
+      itti_desc.threads[thread_id].batch_left -= nb_msgs;
+      itti_desc.threads[thread_id].epoll_nb_events = 0;
+      return nb_msgs;
+    }
+  }
 
   if (polling) {
     /*
@@ -562,26 +660,32 @@ itti_receive_msg_internal_event_fd (
     epoll_timeout = 0;
   } else {
     /*
-     * timeout = -1 causes the epoll_wait to wait indefinitely.
+     * Tell senders to signal the thread fd, then check the queue: a message
+     * * * enqueued before is seen here, a message enqueued after is signaled.
      */
-    epoll_timeout = -1;
+    __atomic_store_n (&itti_desc.threads[thread_id].waiting, 1, __ATOMIC_SEQ_CST);
+
+    if (itti_queue_is_empty (queue)) {
+      /*
+       * timeout = -1 causes the epoll_wait to wait indefinitely.
+       */
+      epoll_timeout = -1;
+    } else {
+      __atomic_store_n (&itti_desc.threads[thread_id].waiting, 0, __ATOMIC_SEQ_CST);
+      epoll_timeout = 0;
+    }
   }
 
   do {
     epoll_ret = epoll_wait (itti_desc.threads[thread_id].epoll_fd, itti_desc.threads[thread_id].events, itti_desc.threads[thread_id].nb_events, epoll_timeout);
   } while (epoll_ret < 0 && errno == EINTR);
 
+  __atomic_store_n (&itti_desc.threads[thread_id].waiting, 0, __ATOMIC_SEQ_CST);
+
   if (epoll_ret < 0) {
     AssertFatal (0, "epoll_wait failed for task %s: %s!\n", itti_get_task_name (task_id), strerror (errno));
   }
 
-  if (epoll_ret == 0 && polling) {
-    /*
-     * No data to read -> return
-     */
-    return;
-  }
-
   itti_desc.threads[thread_id].epoll_nb_events = epoll_ret;
 
   for (i = 0; i < epoll_ret; i++) {
@@ -589,35 +693,37 @@ itti_receive_msg_internal_event_fd (
      * Check if there is an event for ITTI for the event fd
      */
     if ((itti_desc.threads[thread_id].events[i].events & EPOLLIN) && (itti_desc.threads[thread_id].events[i].data.fd == itti_desc.threads[thread_id].task_event_fd)) {
-      struct message_list_s                  *message = NULL;
       eventfd_t                               sem_counter;
       ssize_t                                 read_ret;
-      int                                     result;
 
       /*
-       * Read will always return 1
+       * Reset the counter, one wakeup may stand for many messages
        */
       read_ret = read (itti_desc.threads[thread_id].task_event_fd, &sem_counter, sizeof (sem_counter));
       AssertFatal (read_ret == sizeof (sem_counter), "Read from task message FD (%d) failed (%d/%d)!\n", thread_id, (int)read_ret, (int)sizeof (sem_counter));
-
-      if (lfds611_queue_dequeue (itti_desc.tasks[task_id].message_queue, (void **)&message) == 0) {
-        /*
-         * No element in list -> this should not happen
-         */
-        AssertFatal (0, "No message in queue for task %d while there are %d events and some for the messages queue!\n", task_id, epoll_ret);
-      }
-
-      AssertFatal (message != NULL, "Message from message queue is NULL!\n");
-      *received_msg = message->msg;
-      result = itti_free (ITTI_MSG_ORIGIN_ID (message->msg), message);
-      AssertFatal (result == EXIT_SUCCESS, "Failed to free memory (%d)!\n", result);
       /*
        * Mark that the event has been processed
        */
       itti_desc.threads[thread_id].events[i].events &= ~EPOLLIN;
-      return;
+      break;
+    }
+  }
+
+  while (nb_msgs < max_msgs) {
+    if ((received_msgs[nb_msgs] = itti_queue_pop (queue)) != NULL) {
+      nb_msgs++;
+    } else if ((nb_msgs > 0) || itti_queue_is_empty (queue)) {
+      break;
+    } else {
+      /*
+       * A sender is between the two steps of itti_queue_push()
+       */
+      sched_yield ();
     }
   }
+
+  itti_desc.threads[thread_id].batch_left = (nb_msgs > 0) ? ITTI_RECEIVE_BATCH_MAX - nb_msgs : 0;
+  return nb_msgs;
 }
 
 void
@@ -626,29 +732,34 @@ itti_receive_msg (
   MessageDef ** received_msg)
 {
   VCD_SIGNAL_DUMPER_DUMP_VARIABLE_BY_NAME (VCD_SIGNAL_DUMPER_VARIABLE_ITTI_RECV_MSG, __sync_and_and_fetch (&itti_desc.vcd_receive_msg, ~(1L << task_id)));
-  itti_receive_msg_internal_event_fd (task_id, 0, received_msg);
+  AssertFatal (received_msg != NULL, "Received message is NULL!\n");
+  *received_msg = NULL;
+  itti_receive_msg_internal_event_fd (task_id, 0, received_msg, 1);
   VCD_SIGNAL_DUMPER_DUMP_VARIABLE_BY_NAME (VCD_SIGNAL_DUMPER_VARIABLE_ITTI_RECV_MSG, __sync_or_and_fetch (&itti_desc.vcd_receive_msg, 1L << task_id));
 }
 
+int
+itti_receive_msgs (
+  task_id_t task_id,
+  MessageDef ** received_msgs,
+  int max_msgs)
+{
+  int                                     nb_msgs;
+
+  VCD_SIGNAL_DUMPER_DUMP_VARIABLE_BY_NAME (VCD_SIGNAL_DUMPER_VARIABLE_ITTI_RECV_MSG, __sync_and_and_fetch (&itti_desc.vcd_receive_msg, ~(1L << task_id)));
+  nb_msgs = itti_receive_msg_internal_event_fd (task_id, 0, received_msgs, max_msgs);
+  VCD_SIGNAL_DUMPER_DUMP_VARIABLE_BY_NAME (VCD_SIGNAL_DUMPER_VARIABLE_ITTI_RECV_MSG, __sync_or_and_fetch (&itti_desc.vcd_receive_msg, 1L << task_id));
+  return nb_msgs;
+}
+
 void
 itti_poll_msg (
   task_id_t task_id,
   MessageDef ** received_msg)
 {
   AssertFatal (task_id < itti_desc.task_max, "Task id (%d) is out of range (%d)!\n", task_id, itti_desc.task_max);
-  *received_msg = NULL;
   VCD_SIGNAL_DUMPER_DUMP_VARIABLE_BY_NAME (VCD_SIGNAL_DUMPER_VARIABLE_ITTI_POLL_MSG, __sync_or_and_fetch (&itti_desc.vcd_poll_msg, 1L << task_id));
-  {
-    struct message_list_s                  *message;
-
-    if (lfds611_queue_dequeue (itti_desc.tasks[task_id].message_queue, (void **)&message) == 1) {
-      int                                     result;
-
-      *received_msg = message->msg;
-      result = itti_free (ITTI_MSG_ORIGIN_ID (*received_msg), message);
-      AssertFatal (result == EXIT_SUCCESS, "Failed to free memory (%d)!\n", result);
-    }
-  }
+  *received_msg = itti_queue_pop (&itti_desc.tasks[task_id].message_queue);
 
   if (*received_msg == NULL) {
     ITTI_DEBUG (ITTI_DEBUG_POLL, " No message in queue[(%u:%s)]\n", task_id, itti_get_task_name (task_id));
@@ -731,10 +842,6 @@ itti_mark_task_ready (
 #if ENABLE_ITTI_ANALYZER
   itti_dump_thread_use_ring_buffer ();
 #endif
-  /*
-   * Mark the thread as using LFDS queue
-   */
-  lfds611_queue_use (itti_desc.tasks[task_id].message_queue);
   itti_desc.threads[thread_id].task_state = TASK_STATE_READY;
   itti_desc.ready_tasks++;
 
@@ -784,7 +891,6 @@ itti_init (
 {
   task_id_t                               task_id;
   thread_id_t                             thread_id;
-  int                                     ret;
 
   itti_desc.message_number = 1;
   ITTI_DEBUG (ITTI_DEBUG_INIT, " Init: %d tasks, %d threads, %d messages\n", task_max, thread_max, messages_id_max);
@@ -815,12 +921,7 @@ itti_init (
                 itti_desc.tasks_info[task_id].parent_task != TASK_UNKNOWN ? "sub-" : "",
                 itti_desc.tasks_info[task_id].name,
                 itti_desc.tasks_info[task_id].parent_task != TASK_UNKNOWN ? " with parent " : "", itti_desc.tasks_info[task_id].parent_task != TASK_UNKNOWN ? itti_get_task_name (itti_desc.tasks_info[task_id].parent_task) : "");
-    ITTI_DEBUG (ITTI_DEBUG_INIT, " Creating queue of message of size %u\n", itti_desc.tasks_info[task_id].queue_size);
-    ret = lfds611_queue_new (&itti_desc.tasks[task_id].message_queue, itti_desc.tasks_info[task_id].queue_size);
-
-    if (0 == ret) {
-      AssertFatal (0, "lfds611_queue_new failed for task %s!\n", itti_get_task_name (task_id));
-    }
+    itti_queue_init (&itti_desc.tasks[task_id].message_queue);
   }
 
   /*
@@ -837,7 +938,7 @@ itti_init (
       AssertFatal (0, "Failed to create new epoll fd: %s!\n", strerror (errno));
     }
 
-    itti_desc.threads[thread_id].task_event_fd = eventfd (0, EFD_SEMAPHORE);
+    itti_desc.threads[thread_id].task_event_fd = eventfd (0, 0);
 
     if (itti_desc.threads[thread_id].task_event_fd == -1) {
       /*
@@ -869,10 +970,12 @@ itti_init (
   itti_desc.created_tasks = 0;
   itti_desc.ready_tasks = 0;
 
-  itti_desc.memory_pools_handle = memory_pools_create (5);
+  itti_desc.memory_pools_handle = memory_pools_create (6);
   memory_pools_add_pool (itti_desc.memory_pools_handle, 1000 + ITTI_QUEUE_MAX_ELEMENTS, 50);
   memory_pools_add_pool (itti_desc.memory_pools_handle, 1000 + (2 * ITTI_QUEUE_MAX_ELEMENTS), 100);
   memory_pools_add_pool (itti_desc.memory_pools_handle, 10000, 1000);
+  // UDP datagrams, received in place by TASK_UDP
+  memory_pools_add_pool (itti_desc.memory_pools_handle, 1000 + (ITTI_QUEUE_MAX_ELEMENTS / 16), 4096);
   memory_pools_add_pool (itti_desc.memory_pools_handle, 400, 20050);
   memory_pools_add_pool (itti_desc.memory_pools_handle, 100, 30050);
   {
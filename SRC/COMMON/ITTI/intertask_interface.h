@@ -147,6 +147,16 @@ int itti_get_events(task_id_t task_id, struct epoll_event **events);
  **/
 void itti_receive_msg(task_id_t task_id, MessageDef **received_msg);
 
+/** \brief Retrieves up to max_msgs messages in the queue associated to task_id.
+ * If the queue is empty, the thread is blocked till a new message arrives or
+ * an event occurs on a fd monitored by the task (see itti_get_events()).
+ \param task_id Task ID of the receiving task
+ \param received_msgs Array filled with the received messages
+ \param max_msgs Size of received_msgs
+ @returns the number of received messages
+ **/
+int itti_receive_msgs(task_id_t task_id, MessageDef **received_msgs, int max_msgs);
+
 /** \brief Try to retrieves a message in the queue associated to task_id.
  \param task_id Task ID of the receiving task
  \param received_msg Pointer to the allocated message
@@ -757,6 +757,18 @@ itti_dump_queue_message (
   return 0;
 }
 
+/*------------------------------------------------------------------------------*/
+int
+itti_dump_has_consumer (
+  void)
+{
+  /*
+   * Racy read on purpose: a consumer connecting meanwhile only misses the messages
+   * that the producers chose not to build.
+   */
+  return (itti_dump_running && ((dump_file != NULL) || (itti_dump_queue.nb_connected > 0)));
+}
+
 /* This function should be called by each thread that will use the ring buffer */
 void
 itti_dump_thread_use_ring_buffer (
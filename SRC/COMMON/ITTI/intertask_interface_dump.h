@@ -33,6 +33,10 @@
 int itti_dump_queue_message(task_id_t sender_task, message_number_t message_number, MessageDef *message_p, const char *message_name,
                             const uint32_t message_size);
 
+/* Returns non zero if a dump file is open or an analyzer is connected, lets tasks skip
+   building messages destined only to the dump (e.g. text logs sent to TASK_UNKNOWN) */
+int itti_dump_has_consumer(void);
+
 int itti_dump_init(const char * const messages_definition_xml, const char * const dump_file_name);
 
 void itti_dump_exit(void);
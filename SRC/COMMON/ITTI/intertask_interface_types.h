@@ -134,6 +134,8 @@ typedef struct MessageHeader_s {
   MessageHeaderSize ittiMsgSize;         /**< Message size (not including header size) */
 
   itti_lte_time_t lte_time;       /**< Reference LTE time */
+
+  struct MessageHeader_s *nextInQueue; /**< Link in the queue of the destination task, internal to ITTI */
 } MessageHeader;
 
 /** @struct MessageDef
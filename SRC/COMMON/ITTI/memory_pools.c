@@ -27,6 +27,12 @@
  * either expressed or implied, of the FreeBSD Project.
  */
 
+#define _GNU_SOURCE             // required for pthread_getname_np()
+#include <stddef.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+
 #include "assertions.h"
 #include "memory_pools.h"
 #include "dynamic_memory_check.h"
@@ -50,27 +56,27 @@ uint64_t                                vcd_mp_free;
 
 #define MEMORY_POOL_ITEM_INFO_NUMBER    2
 
+/* Maximum number of items moved at once between a thread magazine and its pool */
+#define MEMORY_POOL_MAGAZINE_BATCH_MAX  32
+
 /*------------------------------------------------------------------------------*/
 typedef int32_t                         items_group_position_t;
 typedef int32_t                         items_group_index_t;
 
-typedef union items_group_positions_u {
-  uint64_t                                all;
-  struct {
-    items_group_position_t                  put;
-    items_group_position_t                  get;
-  } ind;
-} items_group_positions_t;
-
+/*
+ * Free items of a pool, a stack of item indexes shared by all threads.
+ * Threads only access it by batches through their magazines, so a spin lock
+ * (one atomic operation per batch) is enough.
+ */
 typedef struct items_group_s {
-  items_group_position_t                  number_plus_one;
+  items_group_position_t                  number;
   volatile uint32_t                       minimum;
-  volatile items_group_positions_t        positions;
-  volatile items_group_index_t           *indexes;
+  volatile items_group_position_t         free;
+  volatile int                            lock;
+  items_group_index_t                    *indexes;
 } items_group_t;
 
 /*------------------------------------------------------------------------------*/
-static const items_group_position_t     ITEMS_GROUP_POSITION_INVALID = -1;
 static const items_group_index_t        ITEMS_GROUP_INDEX_INVALID = -1;
 
 /*------------------------------------------------------------------------------*/
@@ -100,7 +106,7 @@ typedef struct memory_pool_item_end_s {
 
 typedef struct memory_pool_item_s {
   memory_pool_item_start_t                start;
-  memory_pool_data_t                      data[0];
+  memory_pool_data_t                      data[0] __attribute__ ((aligned (8))); ///< ITTI links messages through pointers in their header
   memory_pool_item_end_t                  end;
 } memory_pool_item_t;
 
@@ -110,10 +116,35 @@ typedef struct memory_pool_s {
   pool_id_t                               pool_id;
   uint32_t                                item_data_number;
   uint32_t                                pool_item_size;
+  uint32_t                                magazine_batch;       ///< 0 when items are not cached by threads
   items_group_t                           items_group_free;
   memory_pool_item_t                     *items;
 } memory_pool_t;
 
+/*
+ * Free items of a pool cached by a thread, allocations and frees are served
+ * from it without any atomic operation. It holds up to two batches so that a
+ * thread alternating allocations and frees does not move a batch each time.
+ */
+typedef struct memory_pool_magazine_s {
+  uint32_t                                rounds;
+  items_group_index_t                     indexes[2 * MEMORY_POOL_MAGAZINE_BATCH_MAX];
+} memory_pool_magazine_t;
+
+typedef struct memory_pools_thread_stats_s {
+  uint64_t                                allocations;
+  uint64_t                                allocation_hits;      ///< served from the thread magazines
+  uint64_t                                frees;
+  uint64_t                                free_hits;            ///< kept in the thread magazines
+} memory_pools_thread_stats_t;
+
+typedef struct memory_pools_thread_cache_s {
+  struct memory_pools_s                  *memory_pools;
+  pthread_t                               thread;
+  struct memory_pools_thread_cache_s     *next;
+  memory_pools_thread_stats_t             stats;
+  memory_pool_magazine_t                  magazines[0];         ///< one per pool
+} memory_pools_thread_cache_t;
 
 typedef struct memory_pools_s {
   pools_start_mark_t                      start_mark;
@@ -121,6 +152,17 @@ typedef struct memory_pools_s {
   uint32_t                                pools_number;
   uint32_t                                pools_defined;
   memory_pool_t                          *pools;
+
+  /*
+   * First pool to try for each size class (item size rounded up to 8 bytes)
+   */
+  uint32_t                                size_classes_number;
+  pool_id_t                              *size_classes;
+
+  pthread_key_t                           thread_cache_key;
+  pthread_mutex_t                         thread_caches_mutex;
+  memory_pools_thread_cache_t            *thread_caches;
+  memory_pools_thread_stats_t             exited_threads_stats;
 } memory_pools_t;
 
 //------------------------------------------------------------------------------
@@ -138,12 +180,17 @@ static const pool_start_mark_t          POOL_START_MARK = CHARS_TO_UINT32 ('P',
 
 static const pools_start_mark_t         POOLS_START_MARK = CHARS_TO_UINT32 ('P', 'S', 's', 't');
 
+/* A thread never caches more than 1/128 of the items of a pool */
+static const uint32_t                   MAGAZINE_POOL_ITEMS_RATIO = 256;
+
+static __thread memory_pools_thread_cache_t *memory_pools_last_thread_cache;
+
 /*------------------------------------------------------------------------------*/
 static inline                           uint32_t
 items_group_number_items (
   items_group_t * items_group)
 {
-  return items_group->number_plus_one - 1;
+  return items_group->number;
 }
 
 //------------------------------------------------------------------------------
@@ -151,106 +198,73 @@ static inline                           uint32_t
 items_group_free_items (
   items_group_t * items_group)
 {
-  items_group_positions_t                 positions;
-  uint32_t                                free_items;
-
-  positions.all = items_group->positions.all;
-  free_items = items_group->number_plus_one + positions.ind.put - positions.ind.get;
-  free_items %= items_group->number_plus_one;
-  return free_items;
+  return items_group->free;
 }
 
 //------------------------------------------------------------------------------
-static inline                           items_group_index_t
-items_group_get_free_item (
+static inline void
+items_group_lock (
   items_group_t * items_group)
 {
-  items_group_position_t                  get_raw;
-  items_group_position_t                  put;
-  items_group_position_t                  get;
-  items_group_position_t                  free_items;
-  items_group_index_t                     index = ITEMS_GROUP_INDEX_INVALID;
-
-  /*
-   * Get current put position
-   */
-  put = items_group->positions.ind.put % items_group->number_plus_one;
-  /*
-   * Get current get position and increase it
-   */
-  get_raw = __sync_fetch_and_add (&items_group->positions.ind.get, 1);
-  get = get_raw % items_group->number_plus_one;
-
-  if (put == get) {
-    /*
-     * No more item free, restore previous position
-     */
-    __sync_fetch_and_sub (&items_group->positions.ind.get, 1);
-  } else {
-    /*
-     * Get index at current get position
-     */
-    index = items_group->indexes[get];
-
-    if (index <= ITEMS_GROUP_INDEX_INVALID) {
-      /*
-       * Index has not yet been completely freed, restore previous get position
-       */
-      __sync_fetch_and_sub (&items_group->positions.ind.get, 1);
-    } else {
-      if (get_raw == items_group->number_plus_one) {
-        /*
-         * Wrap get position
-         */
-        __sync_fetch_and_sub (&items_group->positions.ind.get, items_group->number_plus_one);
-      }
-
-      free_items = items_group_free_items (items_group);
-
-      /*
-       * Updates minimum free items if needed
-       */
-      while (items_group->minimum > free_items) {
-        items_group->minimum = free_items;
-      }
-
+  while (__sync_lock_test_and_set (&items_group->lock, 1)) {
+    while (items_group->lock) {
       /*
-       * Clear index at current get position to indicate that item is free
+       * The holder only copies a batch of indexes, let it run
        */
-      items_group->indexes[get] = ITEMS_GROUP_INDEX_INVALID;
+      sched_yield ();
     }
   }
+}
 
-  return (index);
+//------------------------------------------------------------------------------
+static inline void
+items_group_unlock (
+  items_group_t * items_group)
+{
+  __sync_lock_release (&items_group->lock);
 }
 
 //------------------------------------------------------------------------------
-static inline int
-items_group_put_free_item (
+static inline                           uint32_t
+items_group_get_free_items (
   items_group_t * items_group,
-  items_group_index_t index)
+  items_group_index_t * indexes,
+  uint32_t number)
 {
-  items_group_position_t                  put_raw;
-  items_group_position_t                  put;
-
-  /*
-   * Get current put position and increase it
-   */
-  put_raw = __sync_fetch_and_add (&items_group->positions.ind.put, 1);
-  put = put_raw % items_group->number_plus_one;
+  items_group_lock (items_group);
 
-  if (put_raw == items_group->number_plus_one) {
-    /*
-     * Wrap position
-     */
-    __sync_fetch_and_sub (&items_group->positions.ind.put, items_group->number_plus_one);
+  if (number > items_group->free) {
+    number = items_group->free;
   }
 
-  AssertError (items_group->indexes[put] <= ITEMS_GROUP_INDEX_INVALID, return (EXIT_FAILURE), "Index at current put position (%d) is not marked as free (%d)!\n", put, items_group->number_plus_one);
+  items_group->free -= number;
+  memcpy (indexes, &items_group->indexes[items_group->free], number * sizeof (items_group_index_t));
+
   /*
-   * Save freed item index at current put position
+   * Updates minimum free items if needed
    */
-  items_group->indexes[put] = index;
+  if (items_group->minimum > items_group->free) {
+    items_group->minimum = items_group->free;
+  }
+
+  items_group_unlock (items_group);
+  return (number);
+}
+
+//------------------------------------------------------------------------------
+static inline int
+items_group_put_free_items (
+  items_group_t * items_group,
+  items_group_index_t * indexes,
+  uint32_t number)
+{
+  items_group_lock (items_group);
+  AssertError ((items_group->free + number) <= items_group->number, {
+               items_group_unlock (items_group); return (EXIT_FAILURE);}
+               , "More items freed (%d + %u) than items in the group (%d)!\n", items_group->free, number, items_group->number);
+  memcpy (&items_group->indexes[items_group->free], indexes, number * sizeof (items_group_index_t));
+  items_group->free += number;
+  items_group_unlock (items_group);
   return (EXIT_SUCCESS);
 }
 
@@ -283,7 +297,7 @@ memory_pool_item_from_handler (
   /*
    * Recover memory_pools
    */
-  address = memory_pool_item_handle - sizeof (memory_pool_item_start_t);
+  address = memory_pool_item_handle - offsetof (memory_pool_item_t, data);
   memory_pool_item = (memory_pool_item_t *) address;
   /*
    * Sanity check on passed handle
@@ -306,6 +320,152 @@ memory_pool_item_from_index (
   return (address);
 }
 
+//------------------------------------------------------------------------------
+static void
+memory_pools_thread_stats_add (
+  memory_pools_thread_stats_t * total,
+  memory_pools_thread_stats_t * stats)
+{
+  total->allocations += stats->allocations;
+  total->allocation_hits += stats->allocation_hits;
+  total->frees += stats->frees;
+  total->free_hits += stats->free_hits;
+}
+
+//------------------------------------------------------------------------------
+/*
+ * Called on thread exit, gives the items cached by the thread back to their pools
+ */
+static void
+memory_pools_thread_cache_release (
+  void *args)
+{
+  memory_pools_thread_cache_t            *thread_cache = (memory_pools_thread_cache_t *) args;
+  memory_pools_t                         *memory_pools = thread_cache->memory_pools;
+  memory_pools_thread_cache_t           **previous;
+  pool_id_t                               pool;
+
+  for (pool = 0; pool < memory_pools->pools_defined; pool++) {
+    memory_pool_magazine_t                 *magazine = &thread_cache->magazines[pool];
+
+    if (magazine->rounds > 0) {
+      items_group_put_free_items (&memory_pools->pools[pool].items_group_free, magazine->indexes, magazine->rounds);
+      magazine->rounds = 0;
+    }
+  }
+
+  pthread_mutex_lock (&memory_pools->thread_caches_mutex);
+
+  for (previous = &memory_pools->thread_caches; *previous != NULL; previous = &(*previous)->next) {
+    if (*previous == thread_cache) {
+      *previous = thread_cache->next;
+      break;
+    }
+  }
+
+  memory_pools_thread_stats_add (&memory_pools->exited_threads_stats, &thread_cache->stats);
+  pthread_mutex_unlock (&memory_pools->thread_caches_mutex);
+
+  if (memory_pools_last_thread_cache == thread_cache) {
+    memory_pools_last_thread_cache = NULL;
+  }
+
+  free_wrapper ((void **)&thread_cache);
+}
+
+//------------------------------------------------------------------------------
+static inline memory_pools_thread_cache_t *
+memory_pools_thread_cache (
+  memory_pools_t * memory_pools)
+{
+  memory_pools_thread_cache_t            *thread_cache = memory_pools_last_thread_cache;
+
+  if ((thread_cache != NULL) && (thread_cache->memory_pools == memory_pools)) {
+    return (thread_cache);
+  }
+
+  thread_cache = pthread_getspecific (memory_pools->thread_cache_key);
+
+  if (thread_cache == NULL) {
+    /*
+     * First use of these memory pools by this thread
+     */
+    thread_cache = calloc (1, sizeof (memory_pools_thread_cache_t) + memory_pools->pools_number * sizeof (memory_pool_magazine_t));
+    AssertFatal (thread_cache != NULL, "Memory pools thread cache allocation failed!\n");
+    thread_cache->memory_pools = memory_pools;
+    thread_cache->thread = pthread_self ();
+    pthread_setspecific (memory_pools->thread_cache_key, thread_cache);
+    pthread_mutex_lock (&memory_pools->thread_caches_mutex);
+    thread_cache->next = memory_pools->thread_caches;
+    memory_pools->thread_caches = thread_cache;
+    pthread_mutex_unlock (&memory_pools->thread_caches_mutex);
+  }
+
+  memory_pools_last_thread_cache = thread_cache;
+  return (thread_cache);
+}
+
+//------------------------------------------------------------------------------
+static inline                           items_group_index_t
+memory_pool_get_free_item (
+  memory_pool_t * memory_pool,
+  memory_pool_magazine_t * magazine,
+  memory_pools_thread_stats_t * stats)
+{
+  items_group_index_t                     index = ITEMS_GROUP_INDEX_INVALID;
+
+  if (magazine->rounds > 0) {
+    stats->allocation_hits++;
+  } else if (memory_pool->magazine_batch == 0) {
+    items_group_get_free_items (&memory_pool->items_group_free, &index, 1);
+    return (index);
+  } else {
+    /*
+     * Magazine is empty, load a batch of free items from the pool
+     */
+    magazine->rounds = items_group_get_free_items (&memory_pool->items_group_free, magazine->indexes, memory_pool->magazine_batch);
+
+    if (magazine->rounds == 0) {
+      return (index);
+    }
+  }
+
+  magazine->rounds--;
+  index = magazine->indexes[magazine->rounds];
+  return (index);
+}
+
+//------------------------------------------------------------------------------
+static inline int
+memory_pool_put_free_item (
+  memory_pool_t * memory_pool,
+  memory_pool_magazine_t * magazine,
+  memory_pools_thread_stats_t * stats,
+  items_group_index_t index)
+{
+  int                                     result = EXIT_SUCCESS;
+  uint32_t                                batch = memory_pool->magazine_batch;
+
+  if (batch == 0) {
+    return (items_group_put_free_items (&memory_pool->items_group_free, &index, 1));
+  }
+
+  if (magazine->rounds < (2 * batch)) {
+    stats->free_hits++;
+  } else {
+    /*
+     * Magazine is full, give its oldest batch back to the pool
+     */
+    result = items_group_put_free_items (&memory_pool->items_group_free, magazine->indexes, batch);
+    magazine->rounds -= batch;
+    memmove (magazine->indexes, &magazine->indexes[batch], magazine->rounds * sizeof (items_group_index_t));
+  }
+
+  magazine->indexes[magazine->rounds] = index;
+  magazine->rounds++;
+  return (result);
+}
+
 //------------------------------------------------------------------------------
 memory_pools_handle_t memory_pools_create (uint32_t pools_number)
 {
@@ -316,7 +476,7 @@ memory_pools_handle_t memory_pools_create (uint32_t pools_number)
   /*
    * Allocate memory_pools
    */
-  memory_pools = malloc (sizeof (memory_pools_t));
+  memory_pools = calloc (1, sizeof (memory_pools_t));
   AssertFatal (memory_pools != NULL, "Memory pools structure allocation failed!\n");
   /*
    * Initialize memory_pools
@@ -337,21 +497,40 @@ memory_pools_handle_t memory_pools_create (uint32_t pools_number)
     for (pool = 0; pool < pools_number; pool++) {
       memory_pools->pools[pool].start_mark = POOL_START_MARK;
     }
+
+    AssertFatal (pthread_key_create (&memory_pools->thread_cache_key, memory_pools_thread_cache_release) == 0, "Memory pools thread cache key creation failed!\n");
+    pthread_mutex_init (&memory_pools->thread_caches_mutex, NULL);
   }
   return ((memory_pools_handle_t) memory_pools);
 }
 
+//------------------------------------------------------------------------------
+static int
+memory_pools_print_thread_stats (
+  char *statistics,
+  const char *name,
+  memory_pools_thread_stats_t * stats)
+{
+  return sprintf (statistics, "  %-16s %12lu allocs %5.1f%% hits, %12lu frees %5.1f%% hits\n", name,
+                  stats->allocations, stats->allocations ? (100.0 * stats->allocation_hits) / stats->allocations : 0.0,
+                  stats->frees, stats->frees ? (100.0 * stats->free_hits) / stats->frees : 0.0);
+}
+
 //------------------------------------------------------------------------------
 char                                   *
 memory_pools_statistics (
   memory_pools_handle_t memory_pools_handle)
 {
   memory_pools_t                         *memory_pools;
+  memory_pools_thread_cache_t            *thread_cache;
   pool_id_t                               pool;
   char                                   *statistics;
+  char                                    thread_name[16];
   int                                     printed_chars;
+  uint32_t                                threads_number = 0;
   uint32_t                                allocated_pool_memory;
   uint32_t                                allocated_pools_memory = 0;
+  uint32_t                                cached_items;
   items_group_t                          *items_group;
   uint32_t                                pool_items_size;
 
@@ -360,21 +539,49 @@ memory_pools_statistics (
    */
   memory_pools = memory_pools_from_handler (memory_pools_handle);
   AssertFatal (memory_pools != NULL, "Failed to retrieve memory pool for handle %p!\n", memory_pools_handle);
-  statistics = malloc (memory_pools->pools_defined * 200);
-  printed_chars = sprintf (&statistics[0], "Pool:   size, number, minimum,   free, address space and memory used in Kbytes\n");
+  pthread_mutex_lock (&memory_pools->thread_caches_mutex);
+
+  for (thread_cache = memory_pools->thread_caches; thread_cache != NULL; thread_cache = thread_cache->next) {
+    threads_number++;
+  }
+
+  statistics = malloc ((memory_pools->pools_defined + threads_number + 4) * 200);
+  printed_chars = sprintf (&statistics[0], "Pool:   size, number, minimum,   free, cached, address space and memory used in Kbytes\n");
 
   for (pool = 0; pool < memory_pools->pools_defined; pool++) {
     items_group = &memory_pools->pools[pool].items_group_free;
     allocated_pool_memory = items_group_number_items (items_group) * memory_pools->pools[pool].pool_item_size;
     allocated_pools_memory += allocated_pool_memory;
     pool_items_size = memory_pools->pools[pool].item_data_number * sizeof (memory_pool_data_t);
-    printed_chars += sprintf (&statistics[printed_chars], "  %2u: %6u, %6u,  %6u, %6u, [%p-%p] %6u\n",
+    cached_items = 0;
+
+    /*
+     * Free items held in the thread magazines (read without synchronization, may be slightly off)
+     */
+    for (thread_cache = memory_pools->thread_caches; thread_cache != NULL; thread_cache = thread_cache->next) {
+      cached_items += thread_cache->magazines[pool].rounds;
+    }
+
+    printed_chars += sprintf (&statistics[printed_chars], "  %2u: %6u, %6u,  %6u, %6u, %6u, [%p-%p] %6u\n",
                               pool, pool_items_size,
                               items_group_number_items (items_group),
-                              items_group->minimum, items_group_free_items (items_group), memory_pools->pools[pool].items, ((void *)memory_pools->pools[pool].items) + allocated_pool_memory, allocated_pool_memory / (1024));
+                              items_group->minimum, items_group_free_items (items_group), cached_items,
+                              memory_pools->pools[pool].items, ((void *)memory_pools->pools[pool].items) + allocated_pool_memory, allocated_pool_memory / (1024));
+  }
+
+  printed_chars += sprintf (&statistics[printed_chars], "Pools memory %u Kbytes\n", allocated_pools_memory / (1024));
+  printed_chars += sprintf (&statistics[printed_chars], "Thread magazines:\n");
+
+  for (thread_cache = memory_pools->thread_caches; thread_cache != NULL; thread_cache = thread_cache->next) {
+    if (pthread_getname_np (thread_cache->thread, thread_name, sizeof (thread_name)) != 0) {
+      snprintf (thread_name, sizeof (thread_name), "%lx", (unsigned long)thread_cache->thread);
+    }
+
+    printed_chars += memory_pools_print_thread_stats (&statistics[printed_chars], thread_name, &thread_cache->stats);
   }
 
-  printed_chars = sprintf (&statistics[printed_chars], "Pools memory %u Kbytes\n", allocated_pools_memory / (1024));
+  printed_chars += memory_pools_print_thread_stats (&statistics[printed_chars], "(exited threads)", &memory_pools->exited_threads_stats);
+  pthread_mutex_unlock (&memory_pools->thread_caches_mutex);
   return (statistics);
 }
 
@@ -390,6 +597,7 @@ memory_pools_add_pool (
   pool_id_t                               pool;
   items_group_index_t                     item_index;
   memory_pool_item_t                     *memory_pool_item;
+  uint32_t                                size_class;
 
   AssertFatal (pool_items_number <= MAX_POOL_ITEMS_NUMBER, "Too many items for a memory pool (%u/%d)!\n", pool_items_number, MAX_POOL_ITEMS_NUMBER);    /* Limit to a reasonable number of items */
   AssertFatal (pool_item_size <= MAX_POOL_ITEM_SIZE, "Item size is too big for memory pool items (%u/%d)!\n", pool_item_size, MAX_POOL_ITEM_SIZE);      /* Limit to a reasonable item size */
@@ -416,28 +624,34 @@ memory_pools_add_pool (
      * Item size in memory_pool_data_t items by excess
      */
     memory_pool->item_data_number = (pool_item_size + sizeof (memory_pool_data_t) - 1) / sizeof (memory_pool_data_t);
+    /*
+     * Keep items 8 bytes aligned
+     */
+    memory_pool->item_data_number = (memory_pool->item_data_number + 1) & ~1;
     memory_pool->pool_item_size = (memory_pool->item_data_number * sizeof (memory_pool_data_t)) + sizeof (memory_pool_item_t);
-    memory_pool->items_group_free.number_plus_one = pool_items_number + 1;
+    memory_pool->magazine_batch = pool_items_number / MAGAZINE_POOL_ITEMS_RATIO;
+
+    if (memory_pool->magazine_batch > MEMORY_POOL_MAGAZINE_BATCH_MAX) {
+      memory_pool->magazine_batch = MEMORY_POOL_MAGAZINE_BATCH_MAX;
+    }
+
+    memory_pool->items_group_free.number = pool_items_number;
     memory_pool->items_group_free.minimum = pool_items_number;
-    memory_pool->items_group_free.positions.ind.put = pool_items_number;
-    memory_pool->items_group_free.positions.ind.get = 0;
+    memory_pool->items_group_free.free = pool_items_number;
+    memory_pool->items_group_free.lock = 0;
     /*
      * Allocate free indexes
      */
-    memory_pool->items_group_free.indexes = malloc (memory_pool->items_group_free.number_plus_one * sizeof (items_group_index_t));
+    memory_pool->items_group_free.indexes = malloc ((pool_items_number + 1) * sizeof (items_group_index_t));
     AssertFatal (memory_pool->items_group_free.indexes != NULL, "Memory pool indexes allocation failed!\n");
 
     /*
-     * Initialize free indexes
+     * Initialize free indexes, first items on top of the stack
      */
     for (item_index = 0; item_index < pool_items_number; item_index++) {
-      memory_pool->items_group_free.indexes[item_index] = item_index;
+      memory_pool->items_group_free.indexes[item_index] = pool_items_number - 1 - item_index;
     }
 
-    /*
-     * Last index is not allocated
-     */
-    memory_pool->items_group_free.indexes[item_index] = ITEMS_GROUP_INDEX_INVALID;
     /*
      * Allocate items
      */
@@ -456,6 +670,22 @@ memory_pools_add_pool (
     }
   }
   memory_pools->pools_defined++;
+
+  /*
+   * Rebuild the size classes table: for each item size rounded up to 8 bytes,
+   * the first pool (in creation order) with large enough items
+   */
+  if ((memory_pool->item_data_number / 2 + 1) > memory_pools->size_classes_number) {
+    memory_pools->size_classes_number = memory_pool->item_data_number / 2 + 1;
+    memory_pools->size_classes = realloc (memory_pools->size_classes, memory_pools->size_classes_number * sizeof (pool_id_t));
+    AssertFatal (memory_pools->size_classes != NULL, "Memory pools size classes allocation failed!\n");
+  }
+
+  for (size_class = 0; size_class < memory_pools->size_classes_number; size_class++) {
+    for (pool = 0; (memory_pools->pools[pool].item_data_number / 2) < size_class; pool++);
+    memory_pools->size_classes[size_class] = pool;
+  }
+
   return (0);
 }
 
@@ -468,9 +698,11 @@ memory_pools_allocate (
   uint16_t info_1)
 {
   memory_pools_t                         *memory_pools;
+  memory_pools_thread_cache_t            *thread_cache;
   memory_pool_item_t                     *memory_pool_item;
   memory_pool_item_handle_t               memory_pool_item_handle = NULL;
   pool_id_t                               pool;
+  uint32_t                                size_class;
   items_group_index_t                     item_index = ITEMS_GROUP_INDEX_INVALID;
 
   VCD_SIGNAL_DUMPER_DUMP_VARIABLE_BY_NAME (VCD_SIGNAL_DUMPER_VARIABLE_MP_ALLOC, __sync_or_and_fetch (&vcd_mp_alloc, 1L << info_0));
@@ -481,8 +713,15 @@ memory_pools_allocate (
   AssertError (memory_pools != NULL, {
                }
                , "Failed to retrieve memory pool for handle %p!\n", memory_pools_handle);
+  thread_cache = memory_pools_thread_cache (memory_pools);
+  thread_cache->stats.allocations++;
+  /*
+   * Item size in 8 bytes units by excess
+   */
+  size_class = (item_size + (2 * sizeof (memory_pool_data_t)) - 1) / (2 * sizeof (memory_pool_data_t));
+  pool = (size_class < memory_pools->size_classes_number) ? memory_pools->size_classes[size_class] : memory_pools->pools_defined;
 
-  for (pool = 0; pool < memory_pools->pools_defined; pool++) {
+  for (; pool < memory_pools->pools_defined; pool++) {
     if ((memory_pools->pools[pool].item_data_number * sizeof (memory_pool_data_t)) < item_size) {
       /*
        * This memory pool has too small items, skip it
@@ -490,7 +729,7 @@ memory_pools_allocate (
       continue;
     }
 
-    item_index = items_group_get_free_item (&memory_pools->pools[pool].items_group_free);
+    item_index = memory_pool_get_free_item (&memory_pools->pools[pool], &thread_cache->magazines[pool], &thread_cache->stats);
 
     if (item_index <= ITEMS_GROUP_INDEX_INVALID) {
       /*
@@ -536,6 +775,7 @@ memory_pools_free (
   uint16_t info_0)
 {
   memory_pools_t                         *memory_pools;
+  memory_pools_thread_cache_t            *thread_cache;
   memory_pool_item_t                     *memory_pool_item;
   pool_id_t                               pool;
   items_group_index_t                     item_index;
@@ -582,7 +822,9 @@ memory_pools_free (
    */
   AssertFatal (memory_pool_item->start.item_status == ITEM_STATUS_ALLOCATED, "Trying to free a non allocated (%x) memory pool item (pool %u, item %d)!\n", memory_pool_item->start.item_status, pool, item_index);
   memory_pool_item->start.item_status = ITEM_STATUS_FREE;
-  result = items_group_put_free_item (&memory_pools->pools[pool].items_group_free, item_index);
+  thread_cache = memory_pools_thread_cache (memory_pools);
+  thread_cache->stats.frees++;
+  result = memory_pool_put_free_item (&memory_pools->pools[pool], &thread_cache->magazines[pool], &thread_cache->stats, item_index);
   AssertError (result == EXIT_SUCCESS, {
                }
                , "Failed to free memory pool item (pool %u, item %d)!\n", pool, item_index);
@@ -590,6 +832,7 @@ memory_pools_free (
   return (result);
 }
 
+
 //------------------------------------------------------------------------------
 void
 memory_pools_set_info (
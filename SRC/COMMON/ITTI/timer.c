@@ -33,102 +33,187 @@
 #include <unistd.h>
 #include <string.h>
 
-#include <signal.h>
 #include <time.h>
 #include <errno.h>
+#include <sys/timerfd.h>
 
 #include "assertions.h"
 #include "intertask_interface.h"
 #include "timer.h"
+#include "timer_wheel.h"
 #include "log.h"
-#include "queue.h"
 #include "dynamic_memory_check.h"
 
 
-int                                     timer_handle_signal (
-  siginfo_t * info);
-
-struct timer_elm_s {
-  task_id_t                               task_id;      ///< Task ID which has requested the timer
-  int32_t                                 instance;     ///< Instance of the task which has requested the timer
-  timer_t                                 timer;        ///< Unique timer id
-  timer_type_t                            type; ///< Timer type
-  void                                   *timer_arg;    ///< Optional argument that will be passed when timer expires
-                                          STAILQ_ENTRY (
-  timer_elm_s)                            entries;      ///< Pointer to next element
-};
-
 typedef struct timer_desc_s {
-  STAILQ_HEAD (
-  timer_list_head,
-  timer_elm_s) timer_queue;
+  timer_wheel_t                          *timer_wheel;  ///< Armed timers, protected by timer_list_mutex
   pthread_mutex_t                         timer_list_mutex;
-  struct timespec                         timeout;
+  int                                     timer_fd;     ///< One-shot, fires at the next expiry of the wheel
+  uint64_t                                timer_fd_tick;  ///< Tick timer_fd is armed for, UINT64_MAX if disarmed
+  struct timespec                         start;        ///< Tick 0 of the wheel
 } timer_desc_t;
 
 static timer_desc_t                     timer_desc;
 
-#define TIMER_SEARCH(vAR, tIMERfIELD, tIMERvALUE, tIMERqUEUE)   \
-  do {                                                            \
-    STAILQ_FOREACH(vAR, tIMERqUEUE, entries) {                  \
-      if (((vAR)->tIMERfIELD == tIMERvALUE))                  \
-        break;                                              \
-    }                                                           \
-  } while(0)
+//------------------------------------------------------------------------------
+static inline uint64_t
+timer_now_tick (
+  void)
+{
+  struct timespec                         now;
+  uint64_t                                elapsed_usec;
+
+  clock_gettime (CLOCK_MONOTONIC, &now);
+  elapsed_usec = (uint64_t)(now.tv_sec - timer_desc.start.tv_sec) * 1000000 + (now.tv_nsec - timer_desc.start.tv_nsec) / 1000;
+  return elapsed_usec / TIMER_TICK_USEC;
+}
 
-int
-timer_handle_signal (
-  siginfo_t * info)
+//------------------------------------------------------------------------------
+static inline uint64_t
+timer_usec_to_ticks (
+  uint32_t interval_sec,
+  uint32_t interval_us)
 {
-  struct timer_elm_s                     *timer_p;
-  MessageDef                             *message_p;
-  timer_has_expired_t                    *timer_expired_p;
-  task_id_t                               task_id;
-  int32_t                                 instance;
+  uint64_t                                usec = (uint64_t)interval_sec * 1000000 + interval_us;
 
   /*
-   * Get back pointer to timer list element
+   * Round up, a timer never expires before its interval
    */
-  timer_p = (struct timer_elm_s *)info->si_ptr;
-  // LG: To many traces for msc timer:
-  // TMR_DEBUG("Timer with id 0x%lx has expired", (long)timer_p->timer);
-  task_id = timer_p->task_id;
-  instance = timer_p->instance;
-  message_p = itti_alloc_new_message (TASK_TIMER, TIMER_HAS_EXPIRED);
-  timer_expired_p = &message_p->ittiMsg.timer_has_expired;
-  timer_expired_p->timer_id = (long)timer_p->timer;
-  timer_expired_p->arg = timer_p->timer_arg;
+  return (usec + TIMER_TICK_USEC - 1) / TIMER_TICK_USEC;
+}
+
+//------------------------------------------------------------------------------
+static void
+timer_fd_arm (
+  uint64_t tick)
+{
+  struct itimerspec                       its;
+  uint64_t                                nsec;
+
+  if (tick == timer_desc.timer_fd_tick) {
+    return;
+  }
 
   /*
-   * Timer is a one shot timer, remove it
+   * One-shot expiry at the absolute time of the tick, UINT64_MAX disarms
    */
-  if (timer_p->type == TIMER_ONE_SHOT) {
-    //         if (timer_delete(timer_p->timer) < 0) {
-    //             TMR_DEBUG("Failed to delete timer 0x%lx", (long)timer_p->timer);
-    //         }
-    //         TMR_DEBUG("Removed timer 0x%lx", (long)timer_p->timer);
-    //         pthread_mutex_lock(&timer_desc.timer_list_mutex);
-    //         STAILQ_REMOVE(&timer_desc.timer_queue, timer_p, timer_elm_s, entries);
-    //         pthread_mutex_unlock(&timer_desc.timer_list_mutex);
-    //         free_wrapper(timer_p);
-    //         timer_p = NULL;
-    if (timer_remove ((long)timer_p->timer) != 0) {
-      OAILOG_DEBUG (LOG_ITTI, "Failed to delete timer 0x%lx\n", (long)timer_p->timer);
-    }
+  memset (&its, 0, sizeof (its));
+
+  if (tick != UINT64_MAX) {
+    nsec = (uint64_t)timer_desc.start.tv_nsec + tick * TIMER_TICK_USEC * 1000;
+    its.it_value.tv_sec = timer_desc.start.tv_sec + (time_t)(nsec / 1000000000);
+    its.it_value.tv_nsec = (long)(nsec % 1000000000);
+  }
+
+  if (timerfd_settime (timer_desc.timer_fd, TFD_TIMER_ABSTIME, &its, NULL) < 0) {
+    OAILOG_ERROR (LOG_ITTI, "Failed to %s timer fd: (%s:%d)\n", (tick != UINT64_MAX) ? "arm" : "disarm", strerror (errno), errno);
+    return;
   }
 
+  timer_desc.timer_fd_tick = tick;
+}
+
+//------------------------------------------------------------------------------
+static void
+timer_notify_expiry (
+  long timer_id,
+  uint32_t task_id,
+  int32_t instance,
+  void *arg,
+  void *cb_data)
+{
+  MessageDef                             *message_p;
+  timer_has_expired_t                    *timer_expired_p;
+
+  message_p = itti_alloc_new_message (TASK_TIMER, TIMER_HAS_EXPIRED);
+  timer_expired_p = &message_p->ittiMsg.timer_has_expired;
+  timer_expired_p->timer_id = timer_id;
+  timer_expired_p->arg = arg;
+
   /*
    * Notify task of timer expiry
    */
-  if (itti_send_msg_to_task (task_id, instance, message_p) < 0) {
+  if (itti_send_msg_to_task ((task_id_t) task_id, instance, message_p) < 0) {
     OAILOG_DEBUG (LOG_ITTI, "Failed to send msg TIMER_HAS_EXPIRED to task %u\n", task_id);
     itti_free (TASK_TIMER, message_p);
-    return -1;
   }
+}
 
-  return 0;
+//------------------------------------------------------------------------------
+static void
+timer_handle_expiry (
+  void)
+{
+  uint64_t                                expirations;
+
+  /*
+   * The number of timerfd expirations is not used, the wheel catches up with
+   * the monotonic clock whatever the number of ticks missed.
+   */
+  if (read (timer_desc.timer_fd, &expirations, sizeof (expirations)) < 0) {
+    if (errno != EAGAIN) {
+      OAILOG_ERROR (LOG_ITTI, "Failed to read timer fd: (%s:%d)\n", strerror (errno), errno);
+    }
+  }
+
+  pthread_mutex_lock (&timer_desc.timer_list_mutex);
+  timer_wheel_advance (timer_desc.timer_wheel, timer_now_tick (), timer_notify_expiry, NULL);
+  /*
+   * A one-shot timer fd is disarmed once it has fired
+   */
+  timer_desc.timer_fd_tick = UINT64_MAX;
+  timer_fd_arm (timer_wheel_next_expiry (timer_desc.timer_wheel));
+
+  pthread_mutex_unlock (&timer_desc.timer_list_mutex);
 }
 
+//------------------------------------------------------------------------------
+static void                            *
+timer_task (
+  void *args_p)
+{
+  int                                     nb_events = 0;
+  struct epoll_event                     *events = NULL;
+
+  itti_mark_task_ready (TASK_TIMER);
+  OAILOG_START_USE ();
+
+  while (1) {
+    MessageDef                             *received_message_p = NULL;
+
+    itti_receive_msg (TASK_TIMER, &received_message_p);
+
+    if (received_message_p != NULL) {
+      switch (ITTI_MSG_ID (received_message_p)) {
+      case TERMINATE_MESSAGE:{
+          itti_exit_task ();
+        }
+        break;
+
+      default:{
+          OAILOG_DEBUG (LOG_ITTI, "Unkwnon message ID %d:%s\n", ITTI_MSG_ID (received_message_p), ITTI_MSG_NAME (received_message_p));
+        }
+        break;
+      }
+
+      itti_free (ITTI_MSG_ORIGIN_ID (received_message_p), received_message_p);
+      received_message_p = NULL;
+    }
+
+    nb_events = itti_get_events (TASK_TIMER, &events);
+
+    for (int i = 0; (i < nb_events) && (events != NULL); i++) {
+      if ((events[i].events & EPOLLIN) && (events[i].data.fd == timer_desc.timer_fd)) {
+        timer_handle_expiry ();
+        events[i].events &= ~EPOLLIN;
+      }
+    }
+  }
+
+  return NULL;
+}
+
+//------------------------------------------------------------------------------
 int
 timer_setup (
   uint32_t interval_sec,
@@ -139,130 +224,107 @@ timer_setup (
   void *timer_arg,
   long *timer_id)
 {
-  struct sigevent                         se;
-  struct itimerspec                       its;
-  struct timer_elm_s                     *timer_p;
-  timer_t                                 timer;
+  uint64_t                                interval_ticks;
+  uint64_t                                now_tick;
+  int                                     rc;
 
   if (timer_id == NULL) {
     return -1;
   }
 
   AssertFatal (type < TIMER_TYPE_MAX, "Invalid timer type (%d/%d)!\n", type, TIMER_TYPE_MAX);
-  /*
-   * Allocate new timer list element
-   */
-  timer_p = malloc (sizeof (struct timer_elm_s));
+  interval_ticks = timer_usec_to_ticks (interval_sec, interval_us);
 
-  if (timer_p == NULL) {
-    OAILOG_ERROR (LOG_ITTI, "Failed to create new timer element\n");
-    return -1;
+  if (interval_ticks == 0) {
+    interval_ticks = 1;
   }
 
-  memset (&timer, 0, sizeof (timer_t));
-  memset (&se, 0, sizeof (struct sigevent));
-  timer_p->task_id = task_id;
-  timer_p->instance = instance;
-  timer_p->type = type;
-  timer_p->timer_arg = timer_arg;
-  /*
-   * Setting up alarm
-   */
-  /*
-   * Set and enable alarm
-   */
-  se.sigev_notify = SIGEV_SIGNAL;
-  se.sigev_signo = SIGTIMER;
-  se.sigev_value.sival_ptr = timer_p;
+  pthread_mutex_lock (&timer_desc.timer_list_mutex);
+  now_tick = timer_now_tick ();
 
-  /*
-   * At the timer creation, the timer structure will be filled in with timer_id,
-   * * * which is unique for this process. This id is allocated by kernel and the
-   * * * value might be used to distinguish timers.
-   */
-  if (timer_create (CLOCK_REALTIME, &se, &timer) < 0) {
-    OAILOG_ERROR (LOG_ITTI, "Failed to create timer: (%s:%d)\n", strerror (errno), errno);
-    free_wrapper ((void**) &timer_p);
-    return -1;
+  if (timer_wheel_count (timer_desc.timer_wheel) == 0) {
+    /*
+     * The wheel is not driven while empty, bring it up to date first
+     */
+    timer_wheel_advance (timer_desc.timer_wheel, now_tick, NULL, NULL);
   }
 
-  /*
-   * Fill in the first expiration value.
-   */
-  its.it_value.tv_sec = interval_sec;
-  its.it_value.tv_nsec = interval_us * 1000;
+  rc = timer_wheel_add (timer_desc.timer_wheel, now_tick + interval_ticks, (type == TIMER_PERIODIC) ? interval_ticks : 0, task_id, instance, timer_arg, timer_id);
 
-  if (type == TIMER_PERIODIC) {
-    /*
-     * Asked for periodic timer. We set the interval time
-     */
-    its.it_interval.tv_sec = interval_sec;
-    its.it_interval.tv_nsec = interval_us * 1000;
-  } else {
-    /*
-     * Asked for one-shot timer. Do not set the interval field
-     */
-    its.it_interval.tv_sec = 0;
-    its.it_interval.tv_nsec = 0;
+  if ((rc == 0) && (now_tick + interval_ticks < timer_desc.timer_fd_tick)) {
+    timer_fd_arm (now_tick + interval_ticks);
   }
 
-  timer_settime (timer, 0, &its, NULL);
-  /*
-   * Simply set the timer_id argument. so it can be used by caller
-   */
-  *timer_id = (long)timer;
-  OAILOG_DEBUG (LOG_ITTI, "Requesting new %s timer with id 0x%lx that expires within " "%d sec and %d usec\n", type == TIMER_PERIODIC ? "periodic" : "single shot", *timer_id, interval_sec, interval_us);
-  timer_p->timer = timer;
-  /*
-   * Lock the queue and insert the timer at the tail
-   */
-  pthread_mutex_lock (&timer_desc.timer_list_mutex);
-  STAILQ_INSERT_TAIL (&timer_desc.timer_queue, timer_p, entries);
   pthread_mutex_unlock (&timer_desc.timer_list_mutex);
+
+  if (rc < 0) {
+    OAILOG_ERROR (LOG_ITTI, "Failed to create new timer element\n");
+    return -1;
+  }
+
+  OAILOG_DEBUG (LOG_ITTI, "Requesting new %s timer with id 0x%lx that expires within " "%d sec and %d usec\n", type == TIMER_PERIODIC ? "periodic" : "single shot", *timer_id, interval_sec, interval_us);
   return 0;
 }
 
+//------------------------------------------------------------------------------
 int
 timer_remove (
   long timer_id)
 {
   int                                     rc = 0;
-  struct timer_elm_s                     *timer_p;
 
   OAILOG_DEBUG (LOG_ITTI, "Removing timer 0x%lx\n", timer_id);
   pthread_mutex_lock (&timer_desc.timer_list_mutex);
-  TIMER_SEARCH (timer_p, timer, ((timer_t) timer_id), &timer_desc.timer_queue);
+  rc = timer_wheel_remove (timer_desc.timer_wheel, timer_id, NULL);
 
-  /*
-   * We didn't find the timer in list
-   */
-  if (timer_p == NULL) {
-    pthread_mutex_unlock (&timer_desc.timer_list_mutex);
-    OAILOG_ERROR (LOG_ITTI, "Didn't find timer 0x%lx in list\n", timer_id);
-    return -1;
+  if (timer_wheel_count (timer_desc.timer_wheel) == 0) {
+    timer_fd_arm (UINT64_MAX);
   }
 
-  STAILQ_REMOVE (&timer_desc.timer_queue, timer_p, timer_elm_s, entries);
   pthread_mutex_unlock (&timer_desc.timer_list_mutex);
 
-  if (timer_delete (timer_p->timer) < 0) {
-    OAILOG_ERROR (LOG_ITTI, "Failed to delete timer 0x%lx\n", (long)timer_p->timer);
-    rc = -1;
+  /*
+   * We didn't find the timer (already expired one-shot or unknown id)
+   */
+  if (rc < 0) {
+    OAILOG_ERROR (LOG_ITTI, "Didn't find timer 0x%lx in list\n", timer_id);
+    return -1;
   }
 
-  free_wrapper ((void **) &timer_p);
-  timer_p = NULL;
-  return rc;
+  return 0;
 }
 
+//------------------------------------------------------------------------------
 int
 timer_init (
   void)
 {
   OAILOG_DEBUG (LOG_ITTI, "Initializing TIMER task interface\n");
   memset (&timer_desc, 0, sizeof (timer_desc_t));
-  STAILQ_INIT (&timer_desc.timer_queue);
+  timer_desc.timer_fd_tick = UINT64_MAX;
   pthread_mutex_init (&timer_desc.timer_list_mutex, NULL);
+  clock_gettime (CLOCK_MONOTONIC, &timer_desc.start);
+  timer_desc.timer_wheel = timer_wheel_create (TIMER_WHEEL_INITIAL_ENTRIES, 0);
+
+  if (timer_desc.timer_wheel == NULL) {
+    OAILOG_ERROR (LOG_ITTI, "Failed to create timer wheel\n");
+    return -1;
+  }
+
+  timer_desc.timer_fd = timerfd_create (CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+
+  if (timer_desc.timer_fd < 0) {
+    OAILOG_ERROR (LOG_ITTI, "Failed to create timer fd: (%s:%d)\n", strerror (errno), errno);
+    return -1;
+  }
+
+  itti_subscribe_event_fd (TASK_TIMER, timer_desc.timer_fd);
+
+  if (itti_create_task (TASK_TIMER, &timer_task, NULL) < 0) {
+    OAILOG_ERROR (LOG_ITTI, "Failed to create TIMER task: (%s:%d)\n", strerror (errno), errno);
+    return -1;
+  }
+
   OAILOG_DEBUG (LOG_ITTI, "Initializing TIMER task interface: DONE\n");
   return 0;
 }
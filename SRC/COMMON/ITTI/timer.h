@@ -30,9 +30,14 @@
 #ifndef TIMER_H_
 #define TIMER_H_
 
-#include <signal.h>
+#include <stdint.h>
 
-#define SIGTIMER SIGRTMIN
+/* Resolution of ITTI timers: all timers are served by one timing wheel of
+ * TIMER_TICK_USEC ticks (see timer_wheel.h). The TASK_TIMER task only wakes up
+ * at the next expiry of the wheel, not at every tick.
+ */
+#define TIMER_TICK_USEC                  1000
+#define TIMER_WHEEL_INITIAL_ENTRIES      (64 * 1024)
 
 typedef enum timer_type_s {
   TIMER_PERIODIC,
@@ -40,8 +45,6 @@ typedef enum timer_type_s {
   TIMER_TYPE_MAX,
 } timer_type_t;
 
-int timer_handle_signal(siginfo_t *info);
-
 /** \brief Request a new timer
  *  \param interval_sec timer interval in seconds
  *  \param interval_us  timer interval in micro seconds
@@ -0,0 +1,442 @@
+/*
+ * Copyright (c) 2015, EURECOM (www.eurecom.fr)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those
+ * of the authors and should not be interpreted as representing official policies,
+ * either expressed or implied, of the FreeBSD Project.
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "timer_wheel.h"
+
+#define TIMER_WHEEL_NIL             UINT32_MAX
+#define TIMER_WHEEL_SLOT_NONE       UINT16_MAX
+#define TIMER_WHEEL_SLOTS           (TIMER_WHEEL_LEVELS * TIMER_WHEEL_LEVEL_SIZE)
+#define TIMER_WHEEL_GENERATION_MASK 0x7FFFFFFF
+#define TIMER_WHEEL_MAX_ENTRIES     (UINT32_MAX - 1)
+
+/* Handle layout: generation in bits 32..62, entry index + 1 in bits 0..31,
+ * so that a handle is always strictly positive.
+ */
+#define TIMER_WHEEL_HANDLE(gEN, iNDEX)  ((long)(((uint64_t)(gEN) << 32) | ((uint64_t)(iNDEX) + 1)))
+#define TIMER_WHEEL_HANDLE_INDEX(hANDLE) ((uint32_t)(((uint64_t)(hANDLE) & 0xFFFFFFFF) - 1))
+#define TIMER_WHEEL_HANDLE_GEN(hANDLE)   ((uint32_t)(((uint64_t)(hANDLE) >> 32) & TIMER_WHEEL_GENERATION_MASK))
+
+typedef struct timer_wheel_entry_s {
+  uint64_t                                expiry;       ///< Absolute expiry tick
+  uint64_t                                period;       ///< Re-arm period in ticks, 0 for one-shot
+  void                                   *arg;          ///< Argument returned at expiry
+  uint32_t                                next;         ///< Next entry in slot or in free list
+  uint32_t                                prev;         ///< Previous entry in slot
+  uint32_t                                generation;   ///< Incremented each time the entry is released
+  uint32_t                                task_id;      ///< Task which has requested the timer
+  int32_t                                 instance;     ///< Instance of the task which has requested the timer
+  uint16_t                                slot;         ///< Slot holding the entry, TIMER_WHEEL_SLOT_NONE if free
+} timer_wheel_entry_t;
+
+struct timer_wheel_s {
+  uint64_t                                current;      ///< Next tick to be processed
+  uint32_t                                count;        ///< Number of armed timers
+  uint32_t                                capacity;     ///< Number of allocated entries
+  uint32_t                                free_head;    ///< First free entry
+  timer_wheel_entry_t                    *entries;
+  uint32_t                                slots[TIMER_WHEEL_SLOTS];
+};
+
+//------------------------------------------------------------------------------
+static int
+timer_wheel_grow (
+  timer_wheel_t * tw)
+{
+  uint32_t                                new_capacity;
+  timer_wheel_entry_t                    *entries;
+
+  if (tw->capacity >= TIMER_WHEEL_MAX_ENTRIES) {
+    return -1;
+  }
+
+  new_capacity = (tw->capacity < 1024) ? 1024 : tw->capacity;
+  if ((uint64_t)tw->capacity + new_capacity > TIMER_WHEEL_MAX_ENTRIES) {
+    new_capacity = TIMER_WHEEL_MAX_ENTRIES - tw->capacity;
+  }
+
+  entries = realloc (tw->entries, ((size_t)tw->capacity + new_capacity) * sizeof (timer_wheel_entry_t));
+  if (entries == NULL) {
+    return -1;
+  }
+
+  /*
+   * Chain the new entries in the free list, keeping the lower indexes first
+   */
+  for (uint32_t i = tw->capacity; i < tw->capacity + new_capacity; i++) {
+    entries[i].generation = 1;
+    entries[i].slot = TIMER_WHEEL_SLOT_NONE;
+    entries[i].next = (i + 1 < tw->capacity + new_capacity) ? i + 1 : tw->free_head;
+  }
+
+  tw->free_head = tw->capacity;
+  tw->entries = entries;
+  tw->capacity += new_capacity;
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+static inline void
+timer_wheel_link (
+  timer_wheel_t * tw,
+  uint32_t index)
+{
+  timer_wheel_entry_t                    *entry = &tw->entries[index];
+  uint64_t                                delta;
+  uint32_t                                level;
+  uint16_t                                slot;
+
+  if (entry->expiry < tw->current) {
+    entry->expiry = tw->current;
+  }
+
+  delta = entry->expiry - tw->current;
+
+  if (delta > TIMER_WHEEL_MAX_DELAY) {
+    delta = TIMER_WHEEL_MAX_DELAY;
+    entry->expiry = tw->current + delta;
+  }
+
+  for (level = 0; level < TIMER_WHEEL_LEVELS - 1; level++) {
+    if (delta < (UINT64_C(1) << (TIMER_WHEEL_LEVEL_BITS * (level + 1)))) {
+      break;
+    }
+  }
+
+  slot = (level * TIMER_WHEEL_LEVEL_SIZE) + ((entry->expiry >> (TIMER_WHEEL_LEVEL_BITS * level)) & TIMER_WHEEL_LEVEL_MASK);
+  entry->slot = slot;
+  entry->prev = TIMER_WHEEL_NIL;
+  entry->next = tw->slots[slot];
+
+  if (entry->next != TIMER_WHEEL_NIL) {
+    tw->entries[entry->next].prev = index;
+  }
+
+  tw->slots[slot] = index;
+}
+
+//------------------------------------------------------------------------------
+static inline void
+timer_wheel_unlink (
+  timer_wheel_t * tw,
+  uint32_t index)
+{
+  timer_wheel_entry_t                    *entry = &tw->entries[index];
+
+  if (entry->prev != TIMER_WHEEL_NIL) {
+    tw->entries[entry->prev].next = entry->next;
+  } else {
+    tw->slots[entry->slot] = entry->next;
+  }
+
+  if (entry->next != TIMER_WHEEL_NIL) {
+    tw->entries[entry->next].prev = entry->prev;
+  }
+
+  entry->slot = TIMER_WHEEL_SLOT_NONE;
+}
+
+//------------------------------------------------------------------------------
+static inline void
+timer_wheel_release (
+  timer_wheel_t * tw,
+  uint32_t index)
+{
+  timer_wheel_entry_t                    *entry = &tw->entries[index];
+
+  entry->generation = (entry->generation + 1) & TIMER_WHEEL_GENERATION_MASK;
+  entry->slot = TIMER_WHEEL_SLOT_NONE;
+  entry->next = tw->free_head;
+  tw->free_head = index;
+  tw->count--;
+}
+
+//------------------------------------------------------------------------------
+static void
+timer_wheel_cascade (
+  timer_wheel_t * tw,
+  uint32_t level,
+  uint32_t index)
+{
+  uint16_t                                slot = (level * TIMER_WHEEL_LEVEL_SIZE) + index;
+  uint32_t                                entry_index = tw->slots[slot];
+
+  /*
+   * Detach the whole slot then re-link its entries, they go to lower levels
+   */
+  tw->slots[slot] = TIMER_WHEEL_NIL;
+
+  while (entry_index != TIMER_WHEEL_NIL) {
+    uint32_t                                next = tw->entries[entry_index].next;
+
+    timer_wheel_link (tw, entry_index);
+    entry_index = next;
+  }
+}
+
+//------------------------------------------------------------------------------
+timer_wheel_t                          *
+timer_wheel_create (
+  uint32_t initial_entries,
+  uint64_t now_tick)
+{
+  timer_wheel_t                          *tw = calloc (1, sizeof (timer_wheel_t));
+
+  if (tw == NULL) {
+    return NULL;
+  }
+
+  tw->current = now_tick;
+  tw->free_head = TIMER_WHEEL_NIL;
+
+  for (int i = 0; i < TIMER_WHEEL_SLOTS; i++) {
+    tw->slots[i] = TIMER_WHEEL_NIL;
+  }
+
+  while (tw->capacity < initial_entries) {
+    if (timer_wheel_grow (tw) < 0) {
+      timer_wheel_destroy (tw);
+      return NULL;
+    }
+  }
+
+  return tw;
+}
+
+//------------------------------------------------------------------------------
+void
+timer_wheel_destroy (
+  timer_wheel_t * tw)
+{
+  if (tw) {
+    free (tw->entries);
+    free (tw);
+  }
+}
+
+//------------------------------------------------------------------------------
+int
+timer_wheel_add (
+  timer_wheel_t * tw,
+  uint64_t expiry_tick,
+  uint64_t period_ticks,
+  uint32_t task_id,
+  int32_t instance,
+  void *arg,
+  long *timer_id)
+{
+  uint32_t                                index;
+  timer_wheel_entry_t                    *entry;
+
+  if ((tw->free_head == TIMER_WHEEL_NIL) && (timer_wheel_grow (tw) < 0)) {
+    return -1;
+  }
+
+  index = tw->free_head;
+  entry = &tw->entries[index];
+  tw->free_head = entry->next;
+  entry->expiry = expiry_tick;
+  entry->period = period_ticks;
+  entry->arg = arg;
+  entry->task_id = task_id;
+  entry->instance = instance;
+  timer_wheel_link (tw, index);
+  tw->count++;
+  *timer_id = TIMER_WHEEL_HANDLE (entry->generation, index);
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+int
+timer_wheel_remove (
+  timer_wheel_t * tw,
+  long timer_id,
+  void **arg)
+{
+  uint32_t                                index;
+  timer_wheel_entry_t                    *entry;
+
+  if (timer_id <= 0) {
+    return -1;
+  }
+
+  index = TIMER_WHEEL_HANDLE_INDEX (timer_id);
+
+  if (index >= tw->capacity) {
+    return -1;
+  }
+
+  entry = &tw->entries[index];
+
+  if ((entry->slot == TIMER_WHEEL_SLOT_NONE) || (entry->generation != TIMER_WHEEL_HANDLE_GEN (timer_id))) {
+    return -1;
+  }
+
+  if (arg) {
+    *arg = entry->arg;
+  }
+
+  timer_wheel_unlink (tw, index);
+  timer_wheel_release (tw, index);
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+uint32_t
+timer_wheel_advance (
+  timer_wheel_t * tw,
+  uint64_t now_tick,
+  timer_wheel_expiry_cb_t cb,
+  void *cb_data)
+{
+  uint32_t                                expired = 0;
+
+  /*
+   * The caller may have slept until the next expiry: skip the ticks with
+   * nothing to expire nor to cascade.
+   */
+  if (now_tick > tw->current) {
+    uint64_t                                next_tick = timer_wheel_next_expiry (tw);
+
+    if (next_tick > tw->current) {
+      tw->current = (next_tick <= now_tick) ? next_tick : now_tick + 1;
+    }
+  }
+
+  while (tw->current <= now_tick) {
+    uint32_t                                index0;
+    uint16_t                                slot;
+
+    if (tw->count == 0) {
+      /*
+       * Nothing armed, jump directly to now
+       */
+      tw->current = now_tick + 1;
+      break;
+    }
+
+    index0 = tw->current & TIMER_WHEEL_LEVEL_MASK;
+
+    if (index0 == 0) {
+      for (uint32_t level = 1; level < TIMER_WHEEL_LEVELS; level++) {
+        uint32_t                                index = (tw->current >> (TIMER_WHEEL_LEVEL_BITS * level)) & TIMER_WHEEL_LEVEL_MASK;
+
+        timer_wheel_cascade (tw, level, index);
+
+        if (index != 0) {
+          break;
+        }
+      }
+    }
+
+    /*
+     * Pop entries one by one: the callback may add or remove timers,
+     * including in the slot being processed.
+     */
+    slot = index0;
+
+    while (tw->slots[slot] != TIMER_WHEEL_NIL) {
+      uint32_t                                index = tw->slots[slot];
+      timer_wheel_entry_t                    *entry = &tw->entries[index];
+      long                                    timer_id = TIMER_WHEEL_HANDLE (entry->generation, index);
+      uint32_t                                task_id = entry->task_id;
+      int32_t                                 instance = entry->instance;
+      void                                   *arg = entry->arg;
+
+      timer_wheel_unlink (tw, index);
+
+      if (entry->period > 0) {
+        entry->expiry += entry->period;
+        timer_wheel_link (tw, index);
+      } else {
+        timer_wheel_release (tw, index);
+      }
+
+      expired++;
+
+      if (cb) {
+        cb (timer_id, task_id, instance, arg, cb_data);
+      }
+    }
+
+    tw->current++;
+  }
+
+  return expired;
+}
+
+//------------------------------------------------------------------------------
+uint64_t
+timer_wheel_next_expiry (
+  const timer_wheel_t * tw)
+{
+  uint64_t                                next_tick = UINT64_MAX;
+
+  if (tw->count == 0) {
+    return UINT64_MAX;
+  }
+
+  for (uint32_t level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+    uint32_t                                shift = TIMER_WHEEL_LEVEL_BITS * level;
+    uint64_t                                unit = tw->current >> shift;
+
+    /*
+     * A slot of this level is processed (expired at level 0, cascaded above)
+     * at the first tick of its unit. Unless current is on a unit boundary, the
+     * slot of the current unit was already processed and only holds timers
+     * one wheel turn ahead.
+     */
+    if ((tw->current & ((UINT64_C(1) << shift) - 1)) != 0) {
+      unit++;
+    }
+
+    for (uint32_t i = 0; i < TIMER_WHEEL_LEVEL_SIZE; i++, unit++) {
+      if (tw->slots[(level * TIMER_WHEEL_LEVEL_SIZE) + (unit & TIMER_WHEEL_LEVEL_MASK)] != TIMER_WHEEL_NIL) {
+        if ((unit << shift) < next_tick) {
+          next_tick = unit << shift;
+        }
+
+        break;
+      }
+    }
+  }
+
+  return next_tick;
+}
+
+//------------------------------------------------------------------------------
+uint32_t
+timer_wheel_count (
+  const timer_wheel_t * tw)
+{
+  return tw->count;
+}
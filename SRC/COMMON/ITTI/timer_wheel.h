@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2015, EURECOM (www.eurecom.fr)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those
+ * of the authors and should not be interpreted as representing official policies,
+ * either expressed or implied, of the FreeBSD Project.
+ */
+
+#ifndef TIMER_WHEEL_H_
+#define TIMER_WHEEL_H_
+
+#include <stdint.h>
+
+/* Hierarchical timing wheel (Varghese & Lauck, scheme 7).
+ * TIMER_WHEEL_LEVELS levels of TIMER_WHEEL_LEVEL_SIZE slots, level n slot
+ * granularity is TIMER_WHEEL_LEVEL_SIZE^n ticks. Entries live in a growable
+ * array and are linked by index, a timer is referred to by a handle that
+ * encodes its index and a generation counter so that a stale handle (timer
+ * already expired or removed) is detected instead of hitting a reused entry.
+ * The wheel does no locking, the caller serializes accesses.
+ */
+#define TIMER_WHEEL_LEVEL_BITS   6
+#define TIMER_WHEEL_LEVEL_SIZE   (1 << TIMER_WHEEL_LEVEL_BITS)
+#define TIMER_WHEEL_LEVEL_MASK   (TIMER_WHEEL_LEVEL_SIZE - 1)
+#define TIMER_WHEEL_LEVELS       6
+#define TIMER_WHEEL_MAX_DELAY    ((UINT64_C(1) << (TIMER_WHEEL_LEVEL_BITS * TIMER_WHEEL_LEVELS)) - 1)
+
+typedef struct timer_wheel_s timer_wheel_t;
+
+/** \brief Called for each expired timer, one-shot timers are already released
+ *  and periodic timers already re-armed when it is called.
+ *  \param timer_id  handle of the expired timer
+ *  \param task_id   task id given at timer_wheel_add()
+ *  \param instance  instance given at timer_wheel_add()
+ *  \param arg       argument given at timer_wheel_add()
+ *  \param cb_data   opaque data given to timer_wheel_advance()
+ **/
+typedef void (*timer_wheel_expiry_cb_t)(long timer_id, uint32_t task_id, int32_t instance, void *arg, void *cb_data);
+
+/** \brief Create a timing wheel
+ *  \param initial_entries number of timer entries preallocated (grows on demand)
+ *  \param now_tick        current time in ticks
+ *  @returns NULL on failure
+ **/
+timer_wheel_t *timer_wheel_create(uint32_t initial_entries, uint64_t now_tick);
+
+void timer_wheel_destroy(timer_wheel_t *tw);
+
+/** \brief Arm a new timer
+ *  \param expiry_tick  absolute expiry time in ticks
+ *  \param period_ticks re-arm period in ticks, 0 for a one-shot timer
+ *  \param timer_id     filled with the handle of the new timer
+ *  @returns -1 on failure, 0 otherwise
+ **/
+int timer_wheel_add(
+  timer_wheel_t *tw,
+  uint64_t       expiry_tick,
+  uint64_t       period_ticks,
+  uint32_t       task_id,
+  int32_t        instance,
+  void          *arg,
+  long          *timer_id);
+
+/** \brief Cancel an armed timer in O(1)
+ *  \param arg filled with the argument of the timer if not NULL
+ *  @returns -1 if the handle does not refer to an armed timer, 0 otherwise
+ **/
+int timer_wheel_remove(timer_wheel_t *tw, long timer_id, void **arg);
+
+/** \brief Run every timer expiring up to and including now_tick
+ *  @returns the number of expired timers
+ **/
+uint32_t timer_wheel_advance(timer_wheel_t *tw, uint64_t now_tick, timer_wheel_expiry_cb_t cb, void *cb_data);
+
+/** \brief Earliest tick at which timer_wheel_advance() has work to do: the
+ *  expiry of the next timer, or the tick where the slot holding it is cascaded
+ *  to a lower level, whichever comes first. Never later than the next expiry.
+ *  @returns UINT64_MAX if no timer is armed
+ **/
+uint64_t timer_wheel_next_expiry(const timer_wheel_t *tw);
+
+/** \brief Number of armed timers **/
+uint32_t timer_wheel_count(const timer_wheel_t *tw);
+
+#endif /* TIMER_WHEEL_H_ */
@@ -343,7 +343,7 @@ typedef struct {
 
 typedef struct authentication_info_s {
   uint8_t         nb_of_vectors;
-  eutran_vector_t eutran_vector[MAX_EPS_AUTH_VECTORS];
+  eutran_vector_t eutran_vector[MAX_EPS_AUTH_VECTORS_PREFETCH];
 } authentication_info_t;
 
 typedef enum {
@@ -47,4 +47,7 @@
 #define ITTI_QUEUE_MAX_ELEMENTS  (64 * 1024)
 #define ITTI_DUMP_MAX_CON        (5)    /* Max connections in parallel */
 
+/* Max number of messages a task receives before its other fds are polled again */
+#define ITTI_RECEIVE_BATCH_MAX   (64)
+
 #endif /* FILE_INTERTASK_INTERFACE_CONF_SEEN */
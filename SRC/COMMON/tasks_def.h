@@ -39,8 +39,12 @@ TASK_DEF(TASK_FW_IP,    TASK_PRIORITY_MED, 200)
 TASK_DEF(TASK_MME_APP,  TASK_PRIORITY_MED, 200)
 /// NAS task
 TASK_DEF(TASK_NAS_MME,  TASK_PRIORITY_MED, 200)
-/// S11 task
+/// S11 task, runs the S11 shard 0
 TASK_DEF(TASK_S11,      TASK_PRIORITY_MED, 200)
+/// S11 tasks of the other shards, must follow TASK_S11 (S11_MAX_SHARDS tasks in all)
+TASK_DEF(TASK_S11_SHARD_1, TASK_PRIORITY_MED, 200)
+TASK_DEF(TASK_S11_SHARD_2, TASK_PRIORITY_MED, 200)
+TASK_DEF(TASK_S11_SHARD_3, TASK_PRIORITY_MED, 200)
 /// S1AP task
 TASK_DEF(TASK_S1AP,     TASK_PRIORITY_MED, 200)
 /// S6a task
@@ -31,13 +31,18 @@
 
 #define UDP_INIT(mSGpTR)    (mSGpTR)->ittiMsg.udp_init
 
+/* Index of the task receiving a datagram, 0..nb_tasks - 1 */
+typedef uint32_t (*udp_steer_t) (const uint8_t *buffer, uint32_t length, uint32_t nb_tasks);
+
 typedef struct {
-  uint32_t  port;
-  char     *address;
+  uint32_t     port;
+  char        *address;
+  uint32_t     nb_tasks;    ///< tasks sharing the socket: the requesting task and the nb_tasks - 1 next ones
+  udp_steer_t  steer;       ///< task of a received datagram, may be NULL if nb_tasks is 1
 } udp_init_t;
 
 typedef struct {
-  uint8_t  *buffer;
+  uint8_t  *buffer;         ///< itti_malloc'ed, freed by TASK_UDP once sent
   uint32_t  buffer_length;
   uint32_t  buffer_offset;
   uint32_t  peer_address;
@@ -45,7 +50,7 @@ typedef struct {
 } udp_data_req_t;
 
 typedef struct {
-  uint8_t  *buffer;
+  uint8_t  *buffer;         ///< itti_malloc'ed by TASK_UDP, to be freed by the receiving task
   uint32_t  buffer_length;
   uint32_t  peer_address;
   uint32_t  peer_port;
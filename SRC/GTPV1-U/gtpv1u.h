@@ -30,6 +30,4 @@
 
 # define GTPU_HEADER_OVERHEAD_MAX 64
 
-uint32_t gtpv1u_new_teid(void);
-
 #endif /* FILE_GTPV1_U_SEEN */
@@ -84,6 +84,17 @@ extern "C" {
     }                                                                   \
   } while (0)
 
+#define NW_GTPV2C_MAX_MSG_LEN                                    (65507) /**< Maximum supported gtpv2c packet length including header, the UDP payload limit */
+
+/*
+ * The message buffers come in size classes of 256, 1K, 4K, 16K and 64K bytes.
+ * A message starts in the smallest class and moves to a larger one when an IE
+ * does not fit.
+ */
+#define NW_GTPV2C_MSG_BUF_MIN_SIZE                               (256)
+#define NW_GTPV2C_MSG_BUF_CLASSES                                (5)
+#define NW_GTPV2C_MSG_BUF_SIZE(_class)                           (NW_GTPV2C_MSG_BUF_MIN_SIZE << (2 * (_class)))
+
 /*--------------------------------------------------------------------------*
  *  G T P V 2 C   S T A C K   O B J E C T   T Y P E    D E F I N I T I O N  *
  *--------------------------------------------------------------------------*/
@@ -101,6 +112,7 @@ typedef struct NwGtpv2cStack {
   NwGtpv2cLogMgrEntityT         logMgr;
 
   uint32_t                        seqNum;
+  uint32_t                        seqNumStride;           /**< Step between the seqNums of the partition */
   uint32_t                        logLevel;
   uint32_t                        restartCounter;
 
@@ -112,6 +124,13 @@ typedef struct NwGtpv2cStack {
   RB_HEAD( NwGtpv2cOutstandingRxSeqNumTrxnMap, NwGtpv2cTrxn ) outstandingRxSeqNumMap;
   RB_HEAD( NwGtpv2cActiveTimerList, NwGtpv2cTimeoutInfo     ) activeTimerList;
   NwHandleT                     hTmrMinHeap;
+
+  /* Free lists of the objects of this instance, a stack is used by one thread */
+  struct NwGtpv2cMsgS           *pMsgPool;
+  uint8_t                       *pMsgBufPool[NW_GTPV2C_MSG_BUF_CLASSES];  /**< Free message buffers by size class */
+  struct NwGtpv2cTrxn           *pTrxnPool;
+  struct NwGtpv2cTunnel         *pTunnelPool;
+  struct NwGtpv2cTimeoutInfo    *pTimeoutInfoPool;
 } NwGtpv2cStackT;
 
 
@@ -140,8 +159,6 @@ typedef struct NwGtpv2cTimeoutInfo {
  * GTPv2c Message Container Definition
  *--------------------------------------------------------------------------*/
 
-#define NW_GTPV2C_MAX_MSG_LEN                                    (1024)  /**< Maximum supported gtpv2c packet length including header */
-
 /**
  * NwGtpv2cMsgT holds gtpv2c messages to/from the peer.
  */
@@ -156,13 +173,15 @@ typedef struct NwGtpv2cMsgS {
 
 #define NW_GTPV2C_MAX_GROUPED_IE_DEPTH                                  (2)
   struct {
-    NwGtpv2cIeTlvT *pIe[NW_GTPV2C_MAX_GROUPED_IE_DEPTH];
+    uint16_t        ieOffset[NW_GTPV2C_MAX_GROUPED_IE_DEPTH];     /**< The buffer may move while the IE is open */
     uint8_t         top;
   } groupedIeEncodeStack;
 
   NwBoolT                       isIeValid[NW_GTPV2C_IE_TYPE_MAXIMUM][NW_GTPV2C_IE_INSTANCE_MAXIMUM];
   uint8_t                         *pIe[NW_GTPV2C_IE_TYPE_MAXIMUM][NW_GTPV2C_IE_INSTANCE_MAXIMUM];
-  uint8_t                         msgBuf[NW_GTPV2C_MAX_MSG_LEN];
+  uint8_t                         *msgBuf;
+  uint32_t                        msgBufSize;
+  uint8_t                         msgBufClass;
   NwGtpv2cStackHandleT          hStack;
   struct NwGtpv2cMsgS*          next;
 } NwGtpv2cMsgT;
@@ -521,6 +521,22 @@ NwRcT
 nwGtpv2cSetLogLevel( NW_IN NwGtpv2cStackHandleT hGtpcStackHandle,
                      NW_IN uint32_t logLevel);
 
+/**
+ Partition the sequence numbers of the requests sent by the stack: they are
+ all equal to partition modulo nbPartitions, so that the responses sent
+ without TEID can be steered to the stack instance which sent the request.
+
+ @param[in] hGtpcStackHandle : Stack handle
+ @param[in] nbPartitions : Number of partitions, a power of 2.
+ @param[in] partition : Partition of the stack, 0..nbPartitions - 1.
+ @return NW_OK on success.
+ */
+
+NwRcT
+nwGtpv2cSetSeqNumPartition( NW_IN NwGtpv2cStackHandleT hGtpcStackHandle,
+                            NW_IN uint32_t nbPartitions,
+                            NW_IN uint32_t partition);
+
 
 /**
  Process Data Request from UDP entity.
@@ -399,6 +399,36 @@ nwGtpv2cMsgAddIe(NW_IN NwGtpv2cMsgHandleT hMsg,
                  NW_IN uint8_t       instance,
                  NW_IN uint8_t*      pVal);
 
+/**
+ * Start a gtpv2c information element of variable length whose value is
+ * encoded in place in the message buffer, then closed by
+ * nwGtpv2cMsgAddIeCommit(). No other IE may be added in between.
+ *
+ * @param[in] hMsg : Handle to gtpv2c message.
+ * @param[in] type : IE type.
+ * @param[in] instance : IE instance.
+ * @param[in] maxLength : Largest IE length that will be committed.
+ * @param[out] ppVal : Where to write the IE value.
+ */
+
+NwRcT
+nwGtpv2cMsgAddIeReserve(NW_IN NwGtpv2cMsgHandleT hMsg,
+                        NW_IN uint8_t       type,
+                        NW_IN uint8_t       instance,
+                        NW_IN uint16_t      maxLength,
+                        NW_OUT uint8_t**    ppVal);
+
+/**
+ * Close the information element started by nwGtpv2cMsgAddIeReserve().
+ *
+ * @param[in] hMsg : Handle to gtpv2c message.
+ * @param[in] length : IE length, at most the reserved length.
+ */
+
+NwRcT
+nwGtpv2cMsgAddIeCommit(NW_IN NwGtpv2cMsgHandleT hMsg,
+                       NW_IN uint16_t      length);
+
 /**
  * Add CAUSE information element to gtpv2c message.
  *
@@ -60,6 +60,37 @@ typedef struct {
   uint8_t *pIe[NW_GTPV2C_IE_TYPE_MAXIMUM][NW_GTPV2C_IE_INSTANCE_MAXIMUM];
 } NwGtpv2cMsgParserT;
 
+/**
+ * Precompiled message parser: built once per message type from a table of
+ * expected IEs, then run on every received message of this type. The IE
+ * read callbacks get the address ieValueOffset bytes into the structure
+ * given to nwGtpv2cMsgParserInfoRun(), or NULL for NW_GTPV2C_IE_NO_VALUE.
+ */
+
+#define NW_GTPV2C_MSG_PARSER_MAX_IE                                     (32)
+#define NW_GTPV2C_IE_NO_VALUE                                           ((size_t) -1)
+
+typedef NwRcT (*NwGtpv2cIeReadCallbackT) (uint8_t ieType, uint8_t ieLength, uint8_t ieInstance,  uint8_t* ieValue, void* ieReadCallbackArg);
+
+typedef struct {
+  uint8_t                 ieType;
+  uint8_t                 ieInstance;
+  uint8_t                 iePresence;
+  NwGtpv2cIeReadCallbackT ieReadCallback;
+  size_t                  ieValueOffset;
+} NwGtpv2cMsgParserIeInfoT;
+
+typedef struct {
+  uint16_t                msgType;
+  uint8_t                 ieCount;
+  uint32_t                mandatoryIeMask;
+  NwGtpv2cIeReadCallbackT ieReadCallback;
+
+  /* 1 + index of the IE in ieInfo, 0 when the IE is not expected */
+  uint8_t ieIndex[NW_GTPV2C_IE_TYPE_MAXIMUM][NW_GTPV2C_IE_INSTANCE_MAXIMUM + 1];
+  NwGtpv2cMsgParserIeInfoT ieInfo[NW_GTPV2C_MSG_PARSER_MAX_IE];
+} NwGtpv2cMsgParserInfoT;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -140,6 +171,37 @@ nwGtpv2cMsgParserRun( NW_IN NwGtpv2cMsgParserT *thiz,
                       NW_OUT uint8_t             *pOffendingIeInstance,
                       NW_OUT uint16_t            *pOffendingIeLength);
 
+/**
+ * Build a precompiled gtpv2c message parser.
+ *
+ * @param[out] thiz : Message parser.
+ * @param[in] msgType : Message type for this message parser.
+ * @param[in] ieReadCallback : Callback of the IEs without their own callback.
+ * @param[in] pIeInfoTbl : Expected IEs, terminated by an IE of type 0.
+ */
+
+NwRcT
+nwGtpv2cMsgParserInfoInit( NW_OUT NwGtpv2cMsgParserInfoT *thiz,
+                           NW_IN uint8_t msgType,
+                           NW_IN NwGtpv2cIeReadCallbackT ieReadCallback,
+                           NW_IN const NwGtpv2cMsgParserIeInfoT *pIeInfoTbl);
+
+/**
+ * Parse a gtpv2c message with a precompiled message parser.
+ *
+ * @param[in] thiz : Message parser, only read.
+ * @param[in] hMsg : Message handle.
+ * @param[in] pValues : Structure receiving the IE values.
+ */
+
+NwRcT
+nwGtpv2cMsgParserInfoRun( NW_IN const NwGtpv2cMsgParserInfoT *thiz,
+                          NW_IN NwGtpv2cMsgHandleT  hMsg,
+                          NW_INOUT void             *pValues,
+                          NW_OUT uint8_t            *pOffendingIeType,
+                          NW_OUT uint8_t            *pOffendingIeInstance,
+                          NW_OUT uint16_t           *pOffendingIeLength);
+
 #ifdef __cplusplus
 }
 #endif
@@ -89,12 +89,19 @@
 
 #define NW_GTPV2C_UDP_PORT                                              (2123)
 
+#define NW_GTPV2C_FREE_POOL(__thiz, __pool, __type)                     \
+  do {                                                                  \
+    while (__thiz->__pool) {                                            \
+      __type *__obj = __thiz->__pool;                                   \
+      __thiz->__pool = __obj->next;                                     \
+      NW_GTPV2C_FREE (__thiz, __obj);                                   \
+    }                                                                   \
+  } while(0)
+
 #ifdef __cplusplus
 extern                                  "C" {
 #endif
 
-  static NwGtpv2cTimeoutInfoT            *gpGtpv2cTimeoutInfoPool = NULL;
-
   typedef struct {
     int                                     currSize;
     int                                     maxSize;
@@ -127,9 +134,19 @@ extern                                  "C" {
   static NwRcT                            nwGtpv2cTmrMinHeapInsert (
   NwGtpv2cTmrMinHeapT * thiz,
   NwGtpv2cTimeoutInfoT * pTimerEvent) {
-    int                                     holeIndex = thiz->currSize++;
+    int                                     holeIndex;
+
+    /*
+     * The heap follows the transactions in flight, its size is doubled when it is full
+     */
+    if (thiz->currSize == thiz->maxSize) {
+      NwGtpv2cTimeoutInfoT                  **pHeap = (NwGtpv2cTimeoutInfoT **) realloc (thiz->pHeap, 2 * thiz->maxSize * sizeof (NwGtpv2cTimeoutInfoT *));
 
-    NW_ASSERT (thiz->currSize < thiz->maxSize);
+      NW_ASSERT (pHeap);
+      thiz->pHeap = pHeap;
+      thiz->maxSize *= 2;
+    }
+    holeIndex = thiz->currSize++;
 
     while ((holeIndex > 0) && NW_GTPV2C_TIMER_CMP_P (&(thiz->pHeap[NW_HEAP_PARENT_INDEX (holeIndex)])->tvTimeout, &(pTimerEvent->tvTimeout), >)) {
       thiz->pHeap[holeIndex] = thiz->pHeap[NW_HEAP_PARENT_INDEX (holeIndex)];
@@ -807,7 +824,7 @@ extern                                  "C" {
                          (&hMsg));
     NW_ASSERT (NW_OK == rc);
     rc = nwGtpv2cMsgAddIeTV1 (hMsg, NW_GTPV2C_IE_RECOVERY, 0, thiz->restartCounter);
-    OAILOG_ERROR (LOG_GTPV2C, "Sending NW_GTP_ECHO_RSP message to " NW_IPV4_ADDR ":%u with seq %u\n", NW_IPV4_ADDR_FORMAT (peerIp), peerPort, (seqNum));
+    OAILOG_DEBUG (LOG_GTPV2C, "Sending NW_GTP_ECHO_RSP message to " NW_IPV4_ADDR ":%u with seq %u\n", NW_IPV4_ADDR_FORMAT (peerIp), peerPort, (seqNum));
     rc = nwGtpv2cCreateAndSendMsg (thiz, (seqNum), peerIp, peerPort, (NwGtpv2cMsgT *) hMsg);
     rc = nwGtpv2cMsgDelete ((NwGtpv2cStackHandleT) thiz, hMsg);
     NW_ASSERT (NW_OK == rc);
@@ -860,6 +877,7 @@ extern                                  "C" {
 
     if (pTrxn) {
       rc = nwGtpv2cMsgFromBufferNew ((NwGtpv2cStackHandleT) thiz, msgBuf, msgBufLen, &(hMsg));
+      NW_ASSERT (NW_OK == rc);
       NW_ASSERT (thiz->pGtpv2cMsgIeParseInfo[msgType]);
       rc = nwGtpv2cMsgIeParse (thiz->pGtpv2cMsgIeParseInfo[msgType], hMsg, &error);
 
@@ -908,6 +926,7 @@ extern                                  "C" {
       NW_ASSERT (NW_OK == rc);
       NW_ASSERT (msgBuf && msgBufLen);
       rc = nwGtpv2cMsgFromBufferNew ((NwGtpv2cStackHandleT) thiz, msgBuf, msgBufLen, &(hMsg));
+      NW_ASSERT (NW_OK == rc);
       NW_ASSERT (thiz->pGtpv2cMsgIeParseInfo[msgType]);
       rc = nwGtpv2cMsgIeParse (thiz->pGtpv2cMsgIeParseInfo[msgType], hMsg, &error);
 
@@ -945,6 +964,7 @@ extern                                  "C" {
       thiz->id = (uint32_t) thiz;
       thiz->seqNum = ((uint32_t) thiz) & 0x0000FFFF;
       OAI_GCC_DIAG_ON(pointer-to-int-cast);
+      thiz->seqNumStride = 1;
       RB_INIT (&(thiz->tunnelMap));
       RB_INIT (&(thiz->outstandingTxSeqNumMap));
       RB_INIT (&(thiz->outstandingRxSeqNumMap));
@@ -992,13 +1012,46 @@ extern                                  "C" {
 
   NwRcT                                   nwGtpv2cFinalize (
   NW_IN NwGtpv2cStackHandleT hGtpcStackHandle) {
+    NwGtpv2cStackT                         *thiz = (NwGtpv2cStackT *) hGtpcStackHandle;
+
     if (!hGtpcStackHandle)
       return NW_FAILURE;
 
+    NW_GTPV2C_FREE_POOL (thiz, pMsgPool, NwGtpv2cMsgT);
+    NW_GTPV2C_FREE_POOL (thiz, pTrxnPool, NwGtpv2cTrxnT);
+    NW_GTPV2C_FREE_POOL (thiz, pTunnelPool, NwGtpv2cTunnelT);
+    NW_GTPV2C_FREE_POOL (thiz, pTimeoutInfoPool, NwGtpv2cTimeoutInfoT);
+
+    for (int bufClass = 0; bufClass < NW_GTPV2C_MSG_BUF_CLASSES; bufClass++) {
+      while (thiz->pMsgBufPool[bufClass]) {
+        uint8_t                                *pBuf = thiz->pMsgBufPool[bufClass];
+
+        thiz->pMsgBufPool[bufClass] = *((uint8_t **) pBuf);
+        NW_GTPV2C_FREE (thiz, pBuf);
+      }
+    }
     free_wrapper ((void **) &hGtpcStackHandle);
     return NW_OK;
   }
 
+/**
+   Partition the sequence numbers of the requests sent by the stack
+*/
+
+  NwRcT                                   nwGtpv2cSetSeqNumPartition (
+  NW_IN NwGtpv2cStackHandleT hGtpcStackHandle,
+  NW_IN uint32_t nbPartitions,
+  NW_IN uint32_t partition) {
+    NwGtpv2cStackT                         *thiz = (NwGtpv2cStackT *) hGtpcStackHandle;
+
+    if ((!thiz) || (nbPartitions == 0) || (nbPartitions > 0x800000) || (nbPartitions & (nbPartitions - 1)) || (partition >= nbPartitions))
+      return NW_FAILURE;
+
+    thiz->seqNumStride = nbPartitions;
+    thiz->seqNum = (thiz->seqNum & ~(nbPartitions - 1) & 0x7FFFFF) | partition;
+    return NW_OK;
+  }
+
 
 /**
    Set ULP entity
@@ -1263,8 +1316,8 @@ extern                                  "C" {
     if (thiz->activeTimerInfo == timeoutInfo) {
       thiz->activeTimerInfo = NULL;
       RB_REMOVE (NwGtpv2cActiveTimerList, &(thiz->activeTimerList), timeoutInfo);
-      timeoutInfo->next = gpGtpv2cTimeoutInfoPool;
-      gpGtpv2cTimeoutInfoPool = timeoutInfo;
+      timeoutInfo->next = thiz->pTimeoutInfoPool;
+      thiz->pTimeoutInfoPool = timeoutInfo;
       rc = ((timeoutInfo)->timeoutCallbackFunc) (timeoutInfo->timeoutArg);
     } else {
       OAILOG_WARNING (LOG_GTPV2C,  "Received timeout event from ULP for non-existent timeoutInfo 0x%p and activeTimer 0x%p!\n", timeoutInfo, thiz->activeTimerInfo);
@@ -1279,8 +1332,8 @@ extern                                  "C" {
 
       pNextTimeoutInfo = RB_NEXT (NwGtpv2cActiveTimerList, &(thiz->activeTimerList), timeoutInfo);
       RB_REMOVE (NwGtpv2cActiveTimerList, &(thiz->activeTimerList), timeoutInfo);
-      timeoutInfo->next = gpGtpv2cTimeoutInfoPool;
-      gpGtpv2cTimeoutInfoPool = timeoutInfo;
+      timeoutInfo->next = thiz->pTimeoutInfoPool;
+      thiz->pTimeoutInfoPool = timeoutInfo;
       rc = ((timeoutInfo)->timeoutCallbackFunc) (timeoutInfo->timeoutArg);
       timeoutInfo = pNextTimeoutInfo;
     }
@@ -1319,8 +1372,8 @@ extern                                  "C" {
       OAI_GCC_DIAG_OFF(int-to-pointer-cast);
       rc = nwGtpv2cTmrMinHeapRemove ((NwGtpv2cTmrMinHeapT*)thiz->hTmrMinHeap, timeoutInfo->timerMinHeapIndex);
       OAI_GCC_DIAG_ON(int-to-pointer-cast);
-      timeoutInfo->next = gpGtpv2cTimeoutInfoPool;
-      gpGtpv2cTimeoutInfoPool = timeoutInfo;
+      timeoutInfo->next = thiz->pTimeoutInfoPool;
+      thiz->pTimeoutInfoPool = timeoutInfo;
       rc = ((timeoutInfo)->timeoutCallbackFunc) (timeoutInfo->timeoutArg);
     } else {
       OAILOG_WARNING (LOG_GTPV2C,  "Received timeout event from ULP for " "non-existent timeoutInfo 0x%p and activeTimer 0x%p!\n", timeoutInfo, thiz->activeTimerInfo);
@@ -1340,8 +1393,8 @@ extern                                  "C" {
       OAI_GCC_DIAG_OFF(int-to-pointer-cast);
       rc = nwGtpv2cTmrMinHeapRemove ((NwGtpv2cTmrMinHeapT *)thiz->hTmrMinHeap, timeoutInfo->timerMinHeapIndex);
       OAI_GCC_DIAG_ON(int-to-pointer-cast);
-      timeoutInfo->next = gpGtpv2cTimeoutInfoPool;
-      gpGtpv2cTimeoutInfoPool = timeoutInfo;
+      timeoutInfo->next = thiz->pTimeoutInfoPool;
+      thiz->pTimeoutInfoPool = timeoutInfo;
       rc = ((timeoutInfo)->timeoutCallbackFunc) (timeoutInfo->timeoutArg);
       OAI_GCC_DIAG_OFF(int-to-pointer-cast);
       timeoutInfo = nwGtpv2cTmrMinHeapPeek ((NwGtpv2cTmrMinHeapT *)thiz->hTmrMinHeap);
@@ -1389,9 +1442,9 @@ extern                                  "C" {
 
     OAILOG_FUNC_IN (LOG_GTPV2C);
 
-    if (gpGtpv2cTimeoutInfoPool) {
-      timeoutInfo = gpGtpv2cTimeoutInfoPool;
-      gpGtpv2cTimeoutInfoPool = gpGtpv2cTimeoutInfoPool->next;
+    if (thiz->pTimeoutInfoPool) {
+      timeoutInfo = thiz->pTimeoutInfoPool;
+      thiz->pTimeoutInfoPool = thiz->pTimeoutInfoPool->next;
     } else {
       NW_GTPV2C_MALLOC (thiz, sizeof (NwGtpv2cTimeoutInfoT), timeoutInfo, NwGtpv2cTimeoutInfoT *);
     }
@@ -1466,9 +1519,9 @@ extern                                  "C" {
     NW_ASSERT (thiz != NULL);
     OAILOG_FUNC_IN (LOG_GTPV2C);
 
-    if (gpGtpv2cTimeoutInfoPool) {
-      timeoutInfo = gpGtpv2cTimeoutInfoPool;
-      gpGtpv2cTimeoutInfoPool = gpGtpv2cTimeoutInfoPool->next;
+    if (thiz->pTimeoutInfoPool) {
+      timeoutInfo = thiz->pTimeoutInfoPool;
+      thiz->pTimeoutInfoPool = thiz->pTimeoutInfoPool->next;
     } else {
       NW_GTPV2C_MALLOC (thiz, sizeof (NwGtpv2cTimeoutInfoT), timeoutInfo, NwGtpv2cTimeoutInfoT *);
     }
@@ -1537,8 +1590,8 @@ extern                                  "C" {
     OAI_GCC_DIAG_OFF(int-to-pointer-cast);
     rc = nwGtpv2cTmrMinHeapRemove ((NwGtpv2cTmrMinHeapT *)thiz->hTmrMinHeap, timeoutInfo->timerMinHeapIndex);
     OAI_GCC_DIAG_ON(int-to-pointer-cast);
-    timeoutInfo->next = gpGtpv2cTimeoutInfoPool;
-    gpGtpv2cTimeoutInfoPool = timeoutInfo;
+    timeoutInfo->next = thiz->pTimeoutInfoPool;
+    thiz->pTimeoutInfoPool = timeoutInfo;
     OAILOG_DEBUG (LOG_GTPV2C, "Stopping active timer 0x%" PRIxPTR " for info 0x%p!\n", timeoutInfo->hTimer, timeoutInfo);
 
     if (thiz->activeTimerInfo == timeoutInfo) {
@@ -1581,8 +1634,8 @@ extern                                  "C" {
     OAILOG_FUNC_IN (LOG_GTPV2C);
     timeoutInfo = (NwGtpv2cTimeoutInfoT *) hTimer;
     RB_REMOVE (NwGtpv2cActiveTimerList, &(thiz->activeTimerList), timeoutInfo);
-    timeoutInfo->next = gpGtpv2cTimeoutInfoPool;
-    gpGtpv2cTimeoutInfoPool = timeoutInfo;
+    timeoutInfo->next = thiz->pTimeoutInfoPool;
+    thiz->pTimeoutInfoPool = timeoutInfo;
     OAILOG_DEBUG (LOG_GTPV2C, "Stopping active timer 0x%" PRIxPTR " for info 0x%p!\n", timeoutInfo->hTimer, timeoutInfo);
 
     if (thiz->activeTimerInfo == timeoutInfo) {
@@ -51,10 +51,107 @@ extern                                  "C" {
 
 
 /*----------------------------------------------------------------------------*
-                       P R I V A T E     F U N C T I O N S
+                        P R I V A T E   F U N C T I O N S
   ----------------------------------------------------------------------------*/
 
-  static NwGtpv2cMsgT                    *gpGtpv2cMsgPool = NULL;
+/**
+   Take a message buffer of at least len bytes from the pool of the stack.
+*/
+
+  static uint8_t                         *nwGtpv2cMsgBufAlloc (
+  NW_IN NwGtpv2cStackT * pStack,
+  NW_IN uint32_t len,
+  NW_OUT uint8_t * pBufClass) {
+    uint8_t                                 bufClass = 0;
+    uint8_t                                *pBuf;
+
+    while (NW_GTPV2C_MSG_BUF_SIZE (bufClass) < len) {
+      bufClass++;
+    }
+
+    NW_ASSERT (bufClass < NW_GTPV2C_MSG_BUF_CLASSES);
+
+    if (pStack->pMsgBufPool[bufClass]) {
+      /*
+       * A free buffer holds the link to the next free buffer of its class
+       */
+      pBuf = pStack->pMsgBufPool[bufClass];
+      pStack->pMsgBufPool[bufClass] = *((uint8_t **) pBuf);
+    } else {
+      NW_GTPV2C_MALLOC (pStack, NW_GTPV2C_MSG_BUF_SIZE (bufClass), pBuf, uint8_t *);
+    }
+
+    *pBufClass = bufClass;
+    return pBuf;
+  }
+
+  static void                             nwGtpv2cMsgBufFree (
+  NW_IN NwGtpv2cStackT * pStack,
+  NW_IN uint8_t * pBuf,
+  NW_IN uint8_t bufClass) {
+    *((uint8_t **) pBuf) = pStack->pMsgBufPool[bufClass];
+    pStack->pMsgBufPool[bufClass] = pBuf;
+  }
+
+/**
+   Make room for len more bytes at the end of the message, moving it to a
+   buffer of a larger size class if needed.
+*/
+
+  static NwRcT                            nwGtpv2cMsgReserve (
+  NW_IN NwGtpv2cMsgT * pMsg,
+  NW_IN uint32_t len) {
+    NwGtpv2cStackT                         *pStack = (NwGtpv2cStackT *) pMsg->hStack;
+    uint8_t                                *pBuf;
+    uint8_t                                 bufClass;
+
+    if (pMsg->msgLen + len <= pMsg->msgBufSize)
+      return NW_OK;
+
+    if (pMsg->msgLen + len > NW_GTPV2C_MAX_MSG_LEN) {
+      OAILOG_ERROR (LOG_GTPV2C, "Message %p of type %u cannot grow beyond %u bytes!\n", pMsg, pMsg->msgType, NW_GTPV2C_MAX_MSG_LEN);
+      return NW_FAILURE;
+    }
+
+    pBuf = nwGtpv2cMsgBufAlloc (pStack, pMsg->msgLen + len, &bufClass);
+
+    if (!pBuf)
+      return NW_FAILURE;
+
+    memcpy (pBuf, pMsg->msgBuf, pMsg->msgLen);
+    nwGtpv2cMsgBufFree (pStack, pMsg->msgBuf, pMsg->msgBufClass);
+    pMsg->msgBuf = pBuf;
+    pMsg->msgBufClass = bufClass;
+    pMsg->msgBufSize = NW_GTPV2C_MSG_BUF_SIZE (bufClass);
+    return NW_OK;
+  }
+
+  static NwGtpv2cMsgT                    *nwGtpv2cMsgAlloc (
+  NW_IN NwGtpv2cStackT * pStack,
+  NW_IN uint32_t len) {
+    NwGtpv2cMsgT                           *pMsg;
+
+    if (pStack->pMsgPool) {
+      pMsg = pStack->pMsgPool;
+      pStack->pMsgPool = pStack->pMsgPool->next;
+    } else {
+      NW_GTPV2C_MALLOC (pStack, sizeof (NwGtpv2cMsgT), pMsg, NwGtpv2cMsgT *);
+
+      if (!pMsg)
+        return NULL;
+    }
+
+    pMsg->msgBuf = nwGtpv2cMsgBufAlloc (pStack, len, &pMsg->msgBufClass);
+
+    if (!pMsg->msgBuf) {
+      pMsg->next = pStack->pMsgPool;
+      pStack->pMsgPool = pMsg;
+      return NULL;
+    }
+
+    pMsg->msgBufSize = NW_GTPV2C_MSG_BUF_SIZE (pMsg->msgBufClass);
+    return pMsg;
+  }
 
 /*----------------------------------------------------------------------------*
                          P U B L I C   F U N C T I O N S
@@ -72,12 +169,7 @@ extern                                  "C" {
                                             NW_ASSERT (
   pStack);
 
-    if (gpGtpv2cMsgPool) {
-      pMsg = gpGtpv2cMsgPool;
-      gpGtpv2cMsgPool = gpGtpv2cMsgPool->next;
-    } else {
-      NW_GTPV2C_MALLOC (pStack, sizeof (NwGtpv2cMsgT), pMsg, NwGtpv2cMsgT *);
-    }
+    pMsg = nwGtpv2cMsgAlloc (pStack, NW_GTPV2C_MSG_BUF_MIN_SIZE);
 
     if (pMsg) {
       pMsg->version = NW_GTP_VERSION;
@@ -106,13 +198,13 @@ extern                                  "C" {
 
     NW_ASSERT (pStack);
 
-    if (gpGtpv2cMsgPool) {
-      pMsg = gpGtpv2cMsgPool;
-      gpGtpv2cMsgPool = gpGtpv2cMsgPool->next;
-    } else {
-      NW_GTPV2C_MALLOC (pStack, sizeof (NwGtpv2cMsgT), pMsg, NwGtpv2cMsgT *);
+    if (bufLen > NW_GTPV2C_MAX_MSG_LEN) {
+      OAILOG_ERROR (LOG_GTPV2C, "Received message of %u bytes, larger than %u bytes!\n", bufLen, NW_GTPV2C_MAX_MSG_LEN);
+      return NW_FAILURE;
     }
 
+    pMsg = nwGtpv2cMsgAlloc (pStack, bufLen);
+
     if (pMsg) {
       *phMsg = (NwGtpv2cMsgHandleT) pMsg;
       memcpy (pMsg->msgBuf, pBuf, bufLen);
@@ -141,11 +233,17 @@ extern                                  "C" {
   NwRcT                                   nwGtpv2cMsgDelete (
   NW_IN NwGtpv2cStackHandleT hGtpcStackHandle,
   NW_IN NwGtpv2cMsgHandleT hMsg) {
-    // warning: unused variable ‘pStack’ [-Wunused-variable]: NwGtpv2cStackT                         *pStack = (NwGtpv2cStackT *) hGtpcStackHandle;
+    /*
+     * The message and its buffer go back to the pools of the stack instance which created it
+     */
+    NwGtpv2cMsgT                           *pMsg = (NwGtpv2cMsgT *) hMsg;
+    NwGtpv2cStackT                         *pStack = (NwGtpv2cStackT *) pMsg->hStack;
 
     OAILOG_DEBUG (LOG_GTPV2C, "Purging message %" PRIxPTR "!\n", hMsg);
-    ((NwGtpv2cMsgT *) hMsg)->next = gpGtpv2cMsgPool;
-    gpGtpv2cMsgPool = (NwGtpv2cMsgT *) hMsg;
+    nwGtpv2cMsgBufFree (pStack, pMsg->msgBuf, pMsg->msgBufClass);
+    pMsg->msgBuf = NULL;
+    pMsg->next = pStack->pMsgPool;
+    pStack->pMsgPool = pMsg;
     return NW_OK;
   }
 
@@ -271,6 +369,9 @@ extern                                  "C" {
     NwGtpv2cMsgT                           *pMsg = (NwGtpv2cMsgT *) hMsg;
     NwGtpv2cIeTv1T                         *pIe;
 
+    if (nwGtpv2cMsgReserve (pMsg, sizeof (NwGtpv2cIeTv1T)) != NW_OK)
+      return NW_FAILURE;
+
     pIe = (NwGtpv2cIeTv1T *) (pMsg->msgBuf + pMsg->msgLen);
     pIe->t = type;
     pIe->l = htons (0x0001);
@@ -288,6 +389,9 @@ extern                                  "C" {
     NwGtpv2cMsgT                           *pMsg = (NwGtpv2cMsgT *) hMsg;
     NwGtpv2cIeTv2T                         *pIe;
 
+    if (nwGtpv2cMsgReserve (pMsg, sizeof (NwGtpv2cIeTv2T)) != NW_OK)
+      return NW_FAILURE;
+
     pIe = (NwGtpv2cIeTv2T *) (pMsg->msgBuf + pMsg->msgLen);
     pIe->t = type;
     pIe->l = htons (0x0002);
@@ -305,6 +409,9 @@ extern                                  "C" {
     NwGtpv2cMsgT                           *pMsg = (NwGtpv2cMsgT *) hMsg;
     NwGtpv2cIeTv4T                         *pIe;
 
+    if (nwGtpv2cMsgReserve (pMsg, sizeof (NwGtpv2cIeTv4T)) != NW_OK)
+      return NW_FAILURE;
+
     pIe = (NwGtpv2cIeTv4T *) (pMsg->msgBuf + pMsg->msgLen);
     pIe->t = type;
     pIe->l = htons (0x0004);
@@ -320,14 +427,50 @@ extern                                  "C" {
   NW_IN uint16_t length,
   NW_IN uint8_t instance,
   NW_IN uint8_t * pVal) {
+    uint8_t                                *pIeVal;
+
+    if (nwGtpv2cMsgAddIeReserve (hMsg, type, instance, length, &pIeVal) != NW_OK)
+      return NW_FAILURE;
+
+    memcpy (pIeVal, pVal, length);
+    return nwGtpv2cMsgAddIeCommit (hMsg, length);
+  }
+
+/**
+   Start an IE of at most maxLength bytes and give where its value is to be
+   written, the value is encoded in place and the IE is closed by
+   nwGtpv2cMsgAddIeCommit() with its actual length. No other IE may be added
+   in between.
+*/
+
+  NwRcT                                   nwGtpv2cMsgAddIeReserve (
+  NW_IN NwGtpv2cMsgHandleT hMsg,
+  NW_IN uint8_t type,
+  NW_IN uint8_t instance,
+  NW_IN uint16_t maxLength,
+  NW_OUT uint8_t ** ppVal) {
     NwGtpv2cMsgT                           *pMsg = (NwGtpv2cMsgT *) hMsg;
     NwGtpv2cIeTlvT                         *pIe;
 
+    if (nwGtpv2cMsgReserve (pMsg, 4 + maxLength) != NW_OK)
+      return NW_FAILURE;
+
     pIe = (NwGtpv2cIeTlvT *) (pMsg->msgBuf + pMsg->msgLen);
     pIe->t = type;
-    pIe->l = htons (length);
     pIe->i = instance & 0x00ff;
-    memcpy (((uint8_t *) pIe) + 4, pVal, length);
+    *ppVal = ((uint8_t *) pIe) + 4;
+    return NW_OK;
+  }
+
+  NwRcT                                   nwGtpv2cMsgAddIeCommit (
+  NW_IN NwGtpv2cMsgHandleT hMsg,
+  NW_IN uint16_t length) {
+    NwGtpv2cMsgT                           *pMsg = (NwGtpv2cMsgT *) hMsg;
+    NwGtpv2cIeTlvT                         *pIe;
+
+    NW_ASSERT (pMsg->msgLen + 4 + length <= pMsg->msgBufSize);
+    pIe = (NwGtpv2cIeTlvT *) (pMsg->msgBuf + pMsg->msgLen);
+    pIe->l = htons (length);
     pMsg->msgLen += (4 + length);
     return NW_OK;
   }
@@ -339,13 +482,15 @@ extern                                  "C" {
     NwGtpv2cMsgT                           *pMsg = (NwGtpv2cMsgT *) hMsg;
     NwGtpv2cIeTlvT                         *pIe;
 
+    if (nwGtpv2cMsgReserve (pMsg, 4) != NW_OK)
+      return NW_FAILURE;
+
+    NW_ASSERT (pMsg->groupedIeEncodeStack.top < NW_GTPV2C_MAX_GROUPED_IE_DEPTH);
+    pMsg->groupedIeEncodeStack.ieOffset[pMsg->groupedIeEncodeStack.top] = pMsg->msgLen;
     pIe = (NwGtpv2cIeTlvT *) (pMsg->msgBuf + pMsg->msgLen);
     pIe->t = type;
     pIe->i = instance & 0x00ff;
     pMsg->msgLen += (4);
-    pIe->l = (pMsg->msgLen);
-    NW_ASSERT (pMsg->groupedIeEncodeStack.top < NW_GTPV2C_MAX_GROUPED_IE_DEPTH);
-    pMsg->groupedIeEncodeStack.pIe[pMsg->groupedIeEncodeStack.top] = pIe;
     pMsg->groupedIeEncodeStack.top++;
     return NW_OK;
   }
@@ -357,8 +502,8 @@ extern                                  "C" {
 
     NW_ASSERT (pMsg->groupedIeEncodeStack.top > 0);
     pMsg->groupedIeEncodeStack.top--;
-    pIe = pMsg->groupedIeEncodeStack.pIe[pMsg->groupedIeEncodeStack.top];
-    pIe->l = htons (pMsg->msgLen - pIe->l);
+    pIe = (NwGtpv2cIeTlvT *) (pMsg->msgBuf + pMsg->groupedIeEncodeStack.ieOffset[pMsg->groupedIeEncodeStack.top]);
+    pIe->l = htons (pMsg->msgLen - pMsg->groupedIeEncodeStack.ieOffset[pMsg->groupedIeEncodeStack.top] - 4);
     return NW_OK;
   }
 
@@ -262,6 +262,125 @@ extern                                  "C" {
     return rc;
   }
 
+/**
+   Build a precompiled gtpv2c message parser.
+
+   @param[out] thiz : Message parser.
+   @param[in] msgType : Message type for this message parser.
+   @param[in] ieReadCallback : Callback of the IEs without their own callback.
+   @param[in] pIeInfoTbl : Expected IEs, terminated by an IE of type 0.
+*/
+
+  NwRcT                                   nwGtpv2cMsgParserInfoInit (
+  NW_OUT NwGtpv2cMsgParserInfoT * thiz,
+  NW_IN uint8_t msgType,
+  NW_IN NwGtpv2cIeReadCallbackT ieReadCallback,
+  NW_IN const NwGtpv2cMsgParserIeInfoT * pIeInfoTbl) {
+    NW_ASSERT (thiz);
+    memset (thiz, 0, sizeof (NwGtpv2cMsgParserInfoT));
+    thiz->msgType = msgType;
+    thiz->ieReadCallback = ieReadCallback;
+
+    for (; pIeInfoTbl->ieType; pIeInfoTbl++) {
+      if ((thiz->ieCount == NW_GTPV2C_MSG_PARSER_MAX_IE) || (pIeInfoTbl->ieInstance > NW_GTPV2C_IE_INSTANCE_MAXIMUM)
+          || (thiz->ieIndex[pIeInfoTbl->ieType][pIeInfoTbl->ieInstance])) {
+        OAILOG_ERROR (LOG_GTPV2C, "Cannot add IE to parser of msg %u for type %u and instance %u!\n", msgType, pIeInfoTbl->ieType, pIeInfoTbl->ieInstance);
+        return NW_FAILURE;
+      }
+
+      thiz->ieInfo[thiz->ieCount] = *pIeInfoTbl;
+
+      if (pIeInfoTbl->iePresence == NW_GTPV2C_IE_PRESENCE_MANDATORY) {
+        thiz->mandatoryIeMask |= (1u << thiz->ieCount);
+      }
+
+      thiz->ieCount++;
+      thiz->ieIndex[pIeInfoTbl->ieType][pIeInfoTbl->ieInstance] = thiz->ieCount;
+    }
+
+    return NW_OK;
+  }
+
+/**
+   Parse a gtpv2c message with a precompiled message parser. The parser is
+   only read, the state of the parsing is the set of expected IEs found.
+
+   @param[in] thiz : Message parser.
+   @param[in] hMsg : Message handle.
+   @param[in] pValues : Structure receiving the IE values.
+*/
+
+  NwRcT                                   nwGtpv2cMsgParserInfoRun (
+  NW_IN const NwGtpv2cMsgParserInfoT * thiz,
+  NW_IN NwGtpv2cMsgHandleT hMsg,
+  NW_INOUT void *pValues,
+  NW_OUT uint8_t * pOffendingIeType,
+  NW_OUT uint8_t * pOffendingIeInstance,
+  NW_OUT uint16_t * pOffendingIeLength) {
+    NwRcT                                   rc = NW_OK;
+    uint32_t                                ieFound = 0;
+    NwGtpv2cIeTlvT                         *pIe;
+    uint8_t                                *pIeStart;
+    uint8_t                                *pIeEnd;
+    uint16_t                                ieLength;
+    uint8_t                                 ieInstance;
+    uint8_t                                 ieIndex;
+    NwGtpv2cMsgT                           *pMsg = (NwGtpv2cMsgT *) hMsg;
+
+    NW_ASSERT (pMsg);
+    pIeStart = (uint8_t *) (pMsg->msgBuf + (pMsg->msgBuf[0] & 0x08 ? 12 : 8));
+    pIeEnd = (uint8_t *) (pMsg->msgBuf + pMsg->msgLen);
+
+    while (pIeStart < pIeEnd) {
+      pIe = (NwGtpv2cIeTlvT *) pIeStart;
+      ieLength = ntohs (pIe->l);
+      ieInstance = pIe->i & 0x0F;
+
+      if (pIeStart + 4 + ieLength > pIeEnd) {
+        *pOffendingIeType = pIe->t;
+        *pOffendingIeLength = ieLength;
+        *pOffendingIeInstance = ieInstance;
+        return NW_GTPV2C_MSG_MALFORMED;
+      }
+
+      ieIndex = (ieInstance <= NW_GTPV2C_IE_INSTANCE_MAXIMUM) ? thiz->ieIndex[pIe->t][ieInstance] : 0;
+
+      if (ieIndex) {
+        const NwGtpv2cMsgParserIeInfoT         *pIeInfo = &thiz->ieInfo[ieIndex - 1];
+        NwGtpv2cIeReadCallbackT                 ieReadCallback = pIeInfo->ieReadCallback ? pIeInfo->ieReadCallback : thiz->ieReadCallback;
+
+        if (ieReadCallback) {
+          rc = ieReadCallback (pIe->t, ieLength, ieInstance, pIeStart + 4,
+                               (pIeInfo->ieValueOffset == NW_GTPV2C_IE_NO_VALUE) ? NULL : ((uint8_t *) pValues + pIeInfo->ieValueOffset));
+
+          if (NW_OK != rc) {
+            OAILOG_ERROR (LOG_GTPV2C, "Error while parsing IE %u with instance %u and length %u!\n", pIe->t, ieInstance, ieLength);
+            break;
+          }
+        } else {
+          OAILOG_WARNING (LOG_GTPV2C,  "No parse method defined for received IE type %u of length %u in message %u!\n", pIe->t, ieLength, thiz->msgType);
+        }
+
+        ieFound |= (1u << (ieIndex - 1));
+      } else {
+        OAILOG_WARNING (LOG_GTPV2C,  "Unexpected IE %u of length %u received in msg %u!\n", pIe->t, ieLength, thiz->msgType);
+      }
+
+      pIeStart += (ieLength + 4);
+    }
+
+    if ((NW_OK == rc) && ((ieFound & thiz->mandatoryIeMask) != thiz->mandatoryIeMask)) {
+      const NwGtpv2cMsgParserIeInfoT         *pIeInfo = &thiz->ieInfo[__builtin_ctz (thiz->mandatoryIeMask & ~ieFound)];
+
+      *pOffendingIeType = pIeInfo->ieType;
+      *pOffendingIeInstance = pIeInfo->ieInstance;
+      *pOffendingIeLength = 0;
+      return NW_GTPV2C_MANDATORY_IE_MISSING;
+    }
+
+    return rc;
+  }
+
 #ifdef __cplusplus
 }
 #endif
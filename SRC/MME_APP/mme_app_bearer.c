@@ -44,6 +44,7 @@
 #include "mme_app_statistics.h"
 #include "timer.h"
 #include "s1ap_mme.h"
+#include "s11_mme.h"
 
 //----------------------------------------------------------------------------
 static bool mme_app_construct_guti(const plmn_t * const plmn_p, const as_stmsi_t * const s_tmsi_p,  guti_t * const guti_p);
@@ -75,7 +76,7 @@ mme_app_send_s11_release_access_bearers_req (
 
   MSC_LOG_TX_MESSAGE (MSC_MMEAPP_MME, MSC_S11_MME, NULL, 0, "0 S11_RELEASE_ACCESS_BEARERS_REQUEST teid %u ebi %u",
       release_access_bearers_request_p->teid, release_access_bearers_request_p->list_of_rabs.ebis[0]);
-  rc = itti_send_msg_to_task (TASK_S11, INSTANCE_DEFAULT, message_p);
+  rc = itti_send_msg_to_task (s11_mme_task_id (ue_context_pP->mme_s11_teid), INSTANCE_DEFAULT, message_p);
   OAILOG_FUNC_RETURN (LOG_MME_APP, rc);
 }
 
@@ -182,12 +183,19 @@ mme_app_send_s11_create_session_req (
   session_request_p->bearer_contexts_to_be_created.num_bearer_context = 1;
   /*
    * Asking for default bearer in initial UE message.
-   * Use the address of ue_context as unique TEID: Need to find better here
-   * and will generate unique id only for 32 bits platforms.
+   * The MME S11 TEID of the UE is kept until the session is deleted.
    */
-  OAI_GCC_DIAG_OFF(pointer-to-int-cast);
-  session_request_p->sender_fteid_for_cp.teid = (teid_t) ue_context_pP;
-  OAI_GCC_DIAG_ON(pointer-to-int-cast);
+  if (ue_context_pP->mme_s11_teid) {
+    session_request_p->sender_fteid_for_cp.teid = ue_context_pP->mme_s11_teid;
+  } else {
+    session_request_p->sender_fteid_for_cp.teid = teid_shards_allocate (&mme_app_desc.mme_ue_contexts.s11_teid_shards);
+
+    if (session_request_p->sender_fteid_for_cp.teid == INVALID_TEID) {
+      OAILOG_ERROR (LOG_MME_APP, "No S11 TEID left for imsi " IMSI_64_FMT "\n", ue_context_pP->imsi);
+      itti_free (ITTI_MSG_ORIGIN_ID (message_p), message_p);
+      OAILOG_FUNC_RETURN (LOG_MME_APP, RETURNerror);
+    }
+  }
   session_request_p->sender_fteid_for_cp.interface_type = S11_MME_GTP_C;
   mme_config_read_lock (&mme_config);
   session_request_p->sender_fteid_for_cp.ipv4_address = mme_config.ipv4.s11;
@@ -247,7 +255,7 @@ mme_app_send_s11_create_session_req (
   session_request_p->selection_mode = MS_O_N_P_APN_S_V;
   MSC_LOG_TX_MESSAGE (MSC_MMEAPP_MME, MSC_S11_MME, NULL, 0,
       "0 S11_CREATE_SESSION_REQUEST imsi " IMSI_64_FMT, ue_context_pP->imsi);
-  rc = itti_send_msg_to_task (TASK_S11, INSTANCE_DEFAULT, message_p);
+  rc = itti_send_msg_to_task (s11_mme_task_id (session_request_p->sender_fteid_for_cp.teid), INSTANCE_DEFAULT, message_p);
   OAILOG_FUNC_RETURN (LOG_MME_APP, rc);
 }
 
@@ -564,6 +572,7 @@ mme_app_handle_delete_session_rsp (
   }
   hashtable_ts_remove(mme_app_desc.mme_ue_contexts.tun11_ue_context_htbl,
                       (const hash_key_t) ue_context_p->mme_s11_teid, &id);
+  teid_shards_release (&mme_app_desc.mme_ue_contexts.s11_teid_shards, ue_context_p->mme_s11_teid);
   ue_context_p->mme_s11_teid = 0;
   ue_context_p->sgw_s11_teid = 0;
 
@@ -649,6 +658,7 @@ mme_app_handle_create_sess_resp (
    * Store the S-GW teid
    */
   ue_context_p->sgw_s11_teid = create_sess_resp_pP->s11_sgw_teid.teid;
+  s1ap_notified_new_ue_s11_sgw_teid_association (ue_context_p->mme_ue_s1ap_id, ue_context_p->sgw_s11_teid);
   //---------------------------------------------------------
   // Process itti_sgw_create_session_response_t.bearer_context_created
   //---------------------------------------------------------
@@ -890,7 +900,7 @@ mme_app_handle_initial_context_setup_rsp (
   MSC_LOG_TX_MESSAGE (MSC_MMEAPP_MME,  MSC_S11_MME ,
                       NULL, 0, "0 S11_MODIFY_BEARER_REQUEST teid %u ebi %u", s11_modify_bearer_request->teid,
                       s11_modify_bearer_request->bearer_contexts_to_be_modified.bearer_contexts[0].eps_bearer_id);
-  itti_send_msg_to_task (TASK_S11, INSTANCE_DEFAULT, message_p);
+  itti_send_msg_to_task (s11_mme_task_id (ue_context_p->mme_s11_teid), INSTANCE_DEFAULT, message_p);
 
   OAILOG_FUNC_OUT (LOG_MME_APP);
 }
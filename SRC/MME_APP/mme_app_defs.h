@@ -53,6 +53,8 @@ typedef struct {
   uint32_t               nb_ue_connected;
   uint32_t               nb_default_eps_bearers;
   uint32_t               nb_s1u_bearers;
+  uint32_t               nb_enb_ue_lists;
+  size_t                 enb_ue_lists_memory;   /* Bytes allocated by the UE lists of the eNBs in S1AP */
   
   /* ***************Changes in Statistics**************/
 
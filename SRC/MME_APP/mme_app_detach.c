@@ -38,6 +38,7 @@
 #include "mme_app_ue_context.h"
 #include "mme_app_itti_messaging.h"
 #include "mme_app_defs.h"
+#include "s11_mme.h"
 
 //------------------------------------------------------------------------------
 void
@@ -53,9 +54,7 @@ mme_app_send_delete_session_request (
   S11_DELETE_SESSION_REQUEST (message_p).teid = ue_context_p->sgw_s11_teid;
   S11_DELETE_SESSION_REQUEST (message_p).lbi = ue_context_p->default_bearer_id;
 
-  OAI_GCC_DIAG_OFF(pointer-to-int-cast);
-  S11_DELETE_SESSION_REQUEST (message_p).sender_fteid_for_cp.teid = (teid_t) ue_context_p;
-  OAI_GCC_DIAG_ON(pointer-to-int-cast);
+  S11_DELETE_SESSION_REQUEST (message_p).sender_fteid_for_cp.teid = ue_context_p->mme_s11_teid;
   S11_DELETE_SESSION_REQUEST (message_p).sender_fteid_for_cp.interface_type = S11_MME_GTP_C;
   mme_config_read_lock (&mme_config);
   S11_DELETE_SESSION_REQUEST (message_p).sender_fteid_for_cp.ipv4_address = mme_config.ipv4.s11;
@@ -75,7 +74,7 @@ mme_app_send_delete_session_request (
                       S11_DELETE_SESSION_REQUEST  (message_p).teid,
                       S11_DELETE_SESSION_REQUEST  (message_p).lbi);
 
-  itti_send_msg_to_task (TASK_S11, INSTANCE_DEFAULT, message_p);
+  itti_send_msg_to_task (s11_mme_task_id (ue_context_p->mme_s11_teid), INSTANCE_DEFAULT, message_p);
   OAILOG_FUNC_OUT (LOG_MME_APP);
 }
 
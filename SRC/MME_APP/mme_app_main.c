@@ -159,6 +159,7 @@ void *mme_app_thread (
         hashtable_ts_destroy (mme_app_desc.mme_ue_contexts.mme_ue_s1ap_id_ue_context_htbl);
         hashtable_ts_destroy (mme_app_desc.mme_ue_contexts.enb_ue_s1ap_id_ue_context_htbl);
         obj_hashtable_ts_destroy (mme_app_desc.mme_ue_contexts.guti_ue_context_htbl);
+        teid_shards_free (&mme_app_desc.mme_ue_contexts.s11_teid_shards);
         itti_exit_task ();
       }
       break;
@@ -225,6 +226,7 @@ mme_app_init (
   bassigncstr(b, "mme_app_guti_ue_context_htbl");
   mme_app_desc.mme_ue_contexts.guti_ue_context_htbl = obj_hashtable_ts_create (mme_config.max_ues, NULL, hash_free_int_func, hash_free_int_func, b);
   bdestroy(b);
+  teid_shards_init (&mme_app_desc.mme_ue_contexts.s11_teid_shards, mme_config_p->ipv4.nb_s11_shards);
 
   /*
    * Create the thread associated with MME applicative layer
@@ -26,10 +26,14 @@
 #include "mme_app_ue_context.h"
 #include "mme_app_defs.h"
 #include "mme_app_statistics.h"
+#include "nas_auth_vectors.h"
 
 int mme_app_statistics_display (
   void)
 {
+  nas_auth_vectors_statistics_t auth_vectors_stats;
+
+  nas_auth_vectors_get_statistics (&auth_vectors_stats);
   OAILOG_DEBUG (LOG_MME_APP, "======================================= STATISTICS ============================================\n\n");
   OAILOG_DEBUG (LOG_MME_APP, "               |   Current Status| Added since last display|  Removed since last display |\n");
   OAILOG_DEBUG (LOG_MME_APP, "Connected eNBs | %10u      |     %10u              |    %10u               |\n",mme_app_desc.nb_enb_connected,
@@ -42,6 +46,13 @@ int mme_app_statistics_display (
                                           mme_app_desc.nb_eps_bearers_established_since_last_stat,mme_app_desc.nb_eps_bearers_released_since_last_stat);
   OAILOG_DEBUG (LOG_MME_APP, "S1-U Bearers   | %10u      |     %10u              |    %10u               |\n\n",mme_app_desc.nb_s1u_bearers,
                                           mme_app_desc.nb_s1u_bearers_established_since_last_stat,mme_app_desc.nb_s1u_bearers_released_since_last_stat);
+  OAILOG_DEBUG (LOG_MME_APP, "eNB UE lists   | %10u lists, %10zu KB, %8zu bytes per eNB\n\n",mme_app_desc.nb_enb_ue_lists,
+                                          mme_app_desc.enb_ue_lists_memory / 1024,
+                                          mme_app_desc.nb_enb_ue_lists ? mme_app_desc.enb_ue_lists_memory / mme_app_desc.nb_enb_ue_lists : 0);
+  OAILOG_DEBUG (LOG_MME_APP, "Auth vectors   | %10u hits from cache for %10u requests (%3u%%), %10u AIR sent since last display\n\n",
+                                          auth_vectors_stats.nb_hits, auth_vectors_stats.nb_requests,
+                                          auth_vectors_stats.nb_requests ? (100 * auth_vectors_stats.nb_hits) / auth_vectors_stats.nb_requests : 0,
+                                          auth_vectors_stats.nb_air);
   OAILOG_DEBUG (LOG_MME_APP, "======================================= STATISTICS ============================================\n\n");
   
   mme_stats_write_lock (&mme_app_desc);
@@ -163,4 +174,15 @@ void update_mme_app_stats_attached_ue_sub(void)
   mme_stats_unlock(&mme_app_desc);
   return;
 }
+
+/*****************************************************/
+// Memory of the UE lists of the eNBs
+void update_mme_app_stats_enb_ue_lists_memory(const int nb_lists_delta, const ssize_t memory_delta)
+{
+  mme_stats_write_lock (&mme_app_desc);
+  mme_app_desc.nb_enb_ue_lists += nb_lists_delta;
+  mme_app_desc.enb_ue_lists_memory += memory_delta;
+  mme_stats_unlock(&mme_app_desc);
+  return;
+}
 /*****************************************************/
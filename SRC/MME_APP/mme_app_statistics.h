@@ -23,6 +23,8 @@
 #ifndef FILE_MME_APP_STATISTICS_SEEN
 #define FILE_MME_APP_STATISTICS_SEEN
 
+#include <sys/types.h>
+
 int mme_app_statistics_display(void);
 
 /*********************************** Utility Functions to update Statistics**************************************/
@@ -36,5 +38,6 @@ void update_mme_app_stats_default_bearer_add(void);
 void update_mme_app_stats_default_bearer_sub(void);
 void update_mme_app_stats_attached_ue_add(void);
 void update_mme_app_stats_attached_ue_sub(void);
+void update_mme_app_stats_enb_ue_lists_memory(const int nb_lists_delta, const ssize_t memory_delta);
 
 #endif /* FILE_MME_APP_STATISTICS_SEEN */
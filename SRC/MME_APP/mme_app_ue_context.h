@@ -48,6 +48,7 @@
 #include "s6a_messages_types.h"
 #include "security_types.h"
 #include "sgw_ie_defs.h"
+#include "teid_pool.h"
 
 
 
@@ -222,6 +223,7 @@ typedef struct mme_ue_context_s {
   hash_table_ts_t       *mme_ue_s1ap_id_ue_context_htbl;
   hash_table_ts_t       *enb_ue_s1ap_id_ue_context_htbl;
   obj_hash_table_t      *guti_ue_context_htbl;
+  teid_shards_t          s11_teid_shards;      // MME S11 TEIDs in the S11 shards, used by TASK_MME_APP only
 } mme_ue_context_t;
 
 
@@ -93,6 +93,7 @@ static void mme_config_init (mme_config_t * config_pP)
   pthread_rwlock_init (&config_pP->rw_lock, NULL);
   config_pP->log_config.output             = NULL;
   config_pP->log_config.is_output_thread_safe = false;
+  config_pP->log_config.is_output_binary   = false;
   config_pP->log_config.color              = false;
   config_pP->log_config.udp_log_level      = MAX_LOG_LEVEL; // Means invalid
   config_pP->log_config.gtpv1u_log_level   = MAX_LOG_LEVEL; // will not overwrite existing log levels if MME and S-GW bundled in same executable
@@ -130,12 +131,16 @@ static void mme_config_init (mme_config_t * config_pP)
   config_pP->ipv4.if_name_s11 = NULL;
   config_pP->ipv4.s11 = 0;
   config_pP->ipv4.port_s11 = 2123;
+  config_pP->ipv4.nb_s11_shards = S11_SHARDS;
   config_pP->ipv4.sgw_s11 = 0;
   config_pP->s6a_config.conf_file = bfromcstr(S6A_CONF_FILE);
+  config_pP->nas_config.auth_vectors_per_request = NAS_AUTH_VECTORS_PER_REQUEST;
+  config_pP->nas_config.auth_vectors_ttl_sec = NAS_AUTH_VECTORS_TTL;
   config_pP->itti_config.queue_size = ITTI_QUEUE_MAX_ELEMENTS;
   config_pP->itti_config.log_file = NULL;
   config_pP->sctp_config.in_streams = SCTP_IN_STREAMS;
   config_pP->sctp_config.out_streams = SCTP_OUT_STREAMS;
+  config_pP->sctp_config.nb_receive_threads = SCTP_RECEIVE_THREADS;
   config_pP->relative_capacity = RELATIVE_CAPACITY;
   config_pP->mme_statistic_timer = MME_STATISTIC_TIMER_S;
   config_pP->gummei.nb = 1;
@@ -236,6 +241,16 @@ static int mme_config_parse_file (mme_config_t * config_pP)
         }
       }
 
+      if (config_setting_lookup_string (setting, LOG_CONFIG_STRING_OUTPUT_BINARY, (const char **)&astring)) {
+        if (astring != NULL) {
+          if (strcasecmp (astring, "yes") == 0) {
+            config_pP->log_config.is_output_binary = true;
+          } else {
+            config_pP->log_config.is_output_binary = false;
+          }
+        }
+      }
+
       if (config_setting_lookup_string (setting, LOG_CONFIG_STRING_COLOR, (const char **)&astring)) {
         if (0 == strcasecmp("true", astring)) config_pP->log_config.color = true;
         else config_pP->log_config.color = false;
@@ -396,6 +411,12 @@ static int mme_config_parse_file (mme_config_t * config_pP)
       if ((config_setting_lookup_int (setting, MME_CONFIG_STRING_SCTP_OUTSTREAMS, &aint))) {
         config_pP->sctp_config.out_streams = (uint16_t) aint;
       }
+
+      if ((config_setting_lookup_int (setting, MME_CONFIG_STRING_SCTP_RECEIVE_THREADS, &aint))) {
+        AssertFatal ((aint >= 1) && (aint <= SCTP_MAX_RECEIVE_THREADS), "Bad %s value %d, must be 1..%d\n",
+            MME_CONFIG_STRING_SCTP_RECEIVE_THREADS, aint, SCTP_MAX_RECEIVE_THREADS);
+        config_pP->sctp_config.nb_receive_threads = (uint8_t) aint;
+      }
     }
     // S1AP SETTING
     setting = config_setting_get_member (setting_mme, MME_CONFIG_STRING_S1AP_CONFIG);
@@ -594,6 +615,12 @@ static int mme_config_parse_file (mme_config_t * config_pP)
         OAILOG_INFO (LOG_MME_APP, "Parsing configuration file found S11: %s/%d on %s\n",
                        inet_ntoa (in_addr_var), config_pP->ipv4.netmask_s11, bdata(config_pP->ipv4.if_name_s11));
       }
+
+      if ((config_setting_lookup_int (setting, MME_CONFIG_STRING_MME_S11_SHARDS, &aint))) {
+        AssertFatal ((aint > 0) && (aint <= S11_MAX_SHARDS) && !(aint & (aint - 1)), "Bad %s value %d, must be a power of 2 up to %d\n",
+            MME_CONFIG_STRING_MME_S11_SHARDS, aint, S11_MAX_SHARDS);
+        config_pP->ipv4.nb_s11_shards = (uint8_t) aint;
+      }
     }
     // NAS SETTING
     setting = config_setting_get_member (setting_mme, MME_CONFIG_STRING_NAS_CONFIG);
@@ -666,6 +693,14 @@ static int mme_config_parse_file (mme_config_t * config_pP)
       if ((config_setting_lookup_int (setting, MME_CONFIG_STRING_NAS_T3495_TIMER, &aint))) {
         config_pP->nas_config.t3495_sec = (uint8_t) aint;
       }
+      if ((config_setting_lookup_int (setting, MME_CONFIG_STRING_NAS_AUTH_VECTORS_PER_REQUEST, &aint))) {
+        AssertFatal ((aint >= 1) && (aint <= MAX_EPS_AUTH_VECTORS_PREFETCH), "Bad %s value %d, must be 1..%d\n",
+            MME_CONFIG_STRING_NAS_AUTH_VECTORS_PER_REQUEST, aint, MAX_EPS_AUTH_VECTORS_PREFETCH);
+        config_pP->nas_config.auth_vectors_per_request = (uint8_t) aint;
+      }
+      if ((config_setting_lookup_int (setting, MME_CONFIG_STRING_NAS_AUTH_VECTORS_TTL, &aint))) {
+        config_pP->nas_config.auth_vectors_ttl_sec = (uint32_t) aint;
+      }
     }
   }
 
@@ -720,12 +755,14 @@ static void mme_config_display (mme_config_t * config_pP)
   OAILOG_INFO (LOG_CONFIG, "    s11 MME iface ....: %s\n", bdata(config_pP->ipv4.if_name_s11));
   OAILOG_INFO (LOG_CONFIG, "    s11 MME port .....: %d\n", config_pP->ipv4.port_s11);
   OAILOG_INFO (LOG_CONFIG, "    s11 MME ip .......: %s\n", inet_ntoa (*((struct in_addr *)&config_pP->ipv4.s11)));
+  OAILOG_INFO (LOG_CONFIG, "    s11 MME shards ...: %u\n", config_pP->ipv4.nb_s11_shards);
   OAILOG_INFO (LOG_CONFIG, "- ITTI:\n");
   OAILOG_INFO (LOG_CONFIG, "    queue size .......: %u (bytes)\n", config_pP->itti_config.queue_size);
   OAILOG_INFO (LOG_CONFIG, "    log file .........: %s\n", bdata(config_pP->itti_config.log_file));
   OAILOG_INFO (LOG_CONFIG, "- SCTP:\n");
   OAILOG_INFO (LOG_CONFIG, "    in streams .......: %u\n", config_pP->sctp_config.in_streams);
   OAILOG_INFO (LOG_CONFIG, "    out streams ......: %u\n", config_pP->sctp_config.out_streams);
+  OAILOG_INFO (LOG_CONFIG, "    receive threads ..: %u\n", config_pP->sctp_config.nb_receive_threads);
   OAILOG_INFO (LOG_CONFIG, "- GUMMEIs (PLMN|MMEGI|MMEC):\n");
   for (j = 0; j < config_pP->gummei.nb; j++) {
     OAILOG_INFO (LOG_CONFIG, "            " PLMN_FMT "|%u|%u \n",
@@ -755,9 +792,13 @@ static void mme_config_display (mme_config_t * config_pP)
 
   OAILOG_INFO (LOG_CONFIG, "- S6A:\n");
   OAILOG_INFO (LOG_CONFIG, "    conf file ........: %s\n", bdata(config_pP->s6a_config.conf_file));
+  OAILOG_INFO (LOG_CONFIG, "- NAS:\n");
+  OAILOG_INFO (LOG_CONFIG, "    vectors per AIR ..: %u\n", config_pP->nas_config.auth_vectors_per_request);
+  OAILOG_INFO (LOG_CONFIG, "    vectors TTL ......: %u (seconds)\n", config_pP->nas_config.auth_vectors_ttl_sec);
   OAILOG_INFO (LOG_CONFIG, "- Logging:\n");
   OAILOG_INFO (LOG_CONFIG, "    Output ..............: %s\n", bdata(config_pP->log_config.output));
   OAILOG_INFO (LOG_CONFIG, "    Output thread safe ..: %s\n", (config_pP->log_config.is_output_thread_safe) ? "true":"false");
+  OAILOG_INFO (LOG_CONFIG, "    Output binary .......: %s\n", (config_pP->log_config.is_output_binary) ? "true":"false");
   OAILOG_INFO (LOG_CONFIG, "    UDP log level........: %s\n", OAILOG_LEVEL_INT2STR(config_pP->log_config.udp_log_level));
   OAILOG_INFO (LOG_CONFIG, "    GTPV1-U log level....: %s\n", OAILOG_LEVEL_INT2STR(config_pP->log_config.gtpv1u_log_level));
   OAILOG_INFO (LOG_CONFIG, "    GTPV2-C log level....: %s\n", OAILOG_LEVEL_INT2STR(config_pP->log_config.gtpv2c_log_level));
@@ -69,6 +69,7 @@
 #define MME_CONFIG_STRING_SCTP_CONFIG                    "SCTP"
 #define MME_CONFIG_STRING_SCTP_INSTREAMS                 "SCTP_INSTREAMS"
 #define MME_CONFIG_STRING_SCTP_OUTSTREAMS                "SCTP_OUTSTREAMS"
+#define MME_CONFIG_STRING_SCTP_RECEIVE_THREADS           "SCTP_RECEIVE_THREADS"
 
 
 #define MME_CONFIG_STRING_S1AP_CONFIG                    "S1AP"
@@ -89,6 +90,7 @@
 #define MME_CONFIG_STRING_INTERFACE_NAME_FOR_S11_MME     "MME_INTERFACE_NAME_FOR_S11_MME"
 #define MME_CONFIG_STRING_IPV4_ADDRESS_FOR_S11_MME       "MME_IPV4_ADDRESS_FOR_S11_MME"
 #define MME_CONFIG_STRING_MME_PORT_FOR_S11               "MME_PORT_FOR_S11_MME"
+#define MME_CONFIG_STRING_MME_S11_SHARDS                 "MME_S11_SHARDS"
 
 
 #define MME_CONFIG_STRING_NAS_CONFIG                     "NAS"
@@ -101,6 +103,8 @@
 #define MME_CONFIG_STRING_NAS_T3486_TIMER                "T3486"
 #define MME_CONFIG_STRING_NAS_T3489_TIMER                "T3489"
 #define MME_CONFIG_STRING_NAS_T3495_TIMER                "T3495"
+#define MME_CONFIG_STRING_NAS_AUTH_VECTORS_PER_REQUEST   "AUTH_VECTORS_PER_REQUEST"
+#define MME_CONFIG_STRING_NAS_AUTH_VECTORS_TTL           "AUTH_VECTORS_TTL"
 
 #define MME_CONFIG_STRING_ASN1_VERBOSITY                 "ASN1_VERBOSITY"
 #define MME_CONFIG_STRING_ASN1_VERBOSITY_NONE            "none"
@@ -159,6 +163,7 @@ typedef struct mme_config_s {
   struct {
     uint16_t in_streams;
     uint16_t out_streams;
+    uint8_t  nb_receive_threads;
   } sctp_config;
 
   struct {
@@ -175,6 +180,7 @@ typedef struct mme_config_s {
     ipv4_nbo_t s11;
     int        netmask_s11;
     uint16_t   port_s11;
+    uint8_t    nb_s11_shards;
 
     ipv4_nbo_t sgw_s11;
   } ipv4;
@@ -197,6 +203,8 @@ typedef struct mme_config_s {
     uint32_t t3486_sec;
     uint32_t t3489_sec;
     uint32_t t3495_sec;
+    uint8_t  auth_vectors_per_request;
+    uint32_t auth_vectors_ttl_sec;
   } nas_config;
 
   log_config_t log_config;
@@ -75,7 +75,8 @@ static int _nas_message_plain_decode (
     const unsigned char *buffer,
     const nas_message_security_header_t * header,
     nas_message_plain_t * msg,
-    size_t length);
+    size_t length,
+    tlv_decode_arena_t * arena);
 
 static int _nas_message_protected_decode (
     unsigned char * const buffer,
@@ -83,7 +84,8 @@ static int _nas_message_protected_decode (
     nas_message_plain_t * msg,
     size_t length,
     emm_security_context_t * const emm_security_context,
-    nas_message_decode_status_t * status);
+    nas_message_decode_status_t * status,
+    tlv_decode_arena_t * arena);
 
 /* Functions used to encode layer 3 NAS messages */
 static int _nas_message_header_encode (
@@ -355,6 +357,10 @@ int nas_message_decrypt (
        NAS message data
        length:  Number of bytes that should be decoded
        security:  security context
+       arena:  Decode arena of the deciphered message and of
+       the variable length IEs, released by the caller
+       once the message is processed; NULL to allocate
+       them on the heap
        Others:  None
 
    Outputs:   msg:   L3 NAS message structure to be filled
@@ -369,7 +375,8 @@ int nas_message_decode (
     nas_message_t * msg,
     size_t length,
     void *security,
-    nas_message_decode_status_t * status)
+    nas_message_decode_status_t * status,
+    tlv_decode_arena_t * arena)
 {
   OAILOG_FUNC_IN (LOG_NAS);
   emm_security_context_t                 *emm_security_context = (emm_security_context_t *) security;
@@ -496,12 +503,12 @@ int nas_message_decode (
      * Decode security protected NAS message
      */
     
-    bytes = _nas_message_protected_decode ((unsigned char *const)(buffer + size), &msg->header, &msg->plain, length - size, emm_security_context, status);
+    bytes = _nas_message_protected_decode ((unsigned char *const)(buffer + size), &msg->header, &msg->plain, length - size, emm_security_context, status, arena);
   } else {
     /*
      * Decode plain NAS message
      */
-    bytes = _nas_message_plain_decode (buffer, &msg->header, &msg->plain, length);
+    bytes = _nas_message_plain_decode (buffer, &msg->header, &msg->plain, length, arena);
   }
 
   if (bytes < 0)  {
@@ -727,6 +734,7 @@ static int _nas_message_header_decode (
  **       message data                               **
  **    header:  Header of the plain NAS message            **
  **      length:  Number of bytes that should be decoded     **
+ **      arena:   Decode arena of the variable length IEs    **
  **    Others:  None                                       **
  **                                                                        **
  ** Outputs:   msg:   Decoded NAS message                        **
@@ -740,7 +748,8 @@ static int _nas_message_plain_decode (
     const unsigned char *buffer,
     const nas_message_security_header_t * header,
     nas_message_plain_t * msg,
-    size_t length)
+    size_t length,
+    tlv_decode_arena_t * arena)
 {
   OAILOG_FUNC_IN (LOG_NAS);
   int                                     bytes = TLV_PROTOCOL_NOT_SUPPORTED;
@@ -749,12 +758,12 @@ static int _nas_message_plain_decode (
     /*
      * Decode EPS Mobility Management L3 message
      */
-    bytes = emm_msg_decode (&msg->emm, (uint8_t *) buffer, length);
+    bytes = emm_msg_decode (&msg->emm, (uint8_t *) buffer, length, arena);
   } else if (header->protocol_discriminator == EPS_SESSION_MANAGEMENT_MESSAGE) {
     /*
      * Decode EPS Session Management L3 message
      */
-    bytes = esm_msg_decode (&msg->esm, (uint8_t *) buffer, length);
+    bytes = esm_msg_decode (&msg->esm, (uint8_t *) buffer, length, arena);
   } else {
     /*
      * Discard L3 messages with not supported protocol discriminator
@@ -776,6 +785,7 @@ static int _nas_message_plain_decode (
  **          header:  Header of the security protected NAS message       **
  **      length:  Number of bytes that should be decoded             **
  **      emm_security_context: security context                       **
+ **      arena:   Decode arena of the deciphered message     **
  **    Others:  None                                       **
  **                                                                        **
  ** Outputs:   msg:   Decoded NAS message                        **
@@ -791,13 +801,17 @@ static int _nas_message_protected_decode (
     nas_message_plain_t * msg,
     size_t length,
     emm_security_context_t * const emm_security_context,
-    nas_message_decode_status_t * const status)
+    nas_message_decode_status_t * const status,
+    tlv_decode_arena_t * arena)
 {
   OAILOG_FUNC_IN (LOG_NAS);
   int                                     bytes = TLV_BUFFER_TOO_SHORT;
-  unsigned char                    *const plain_msg = (unsigned char *)calloc (1, length);
+  unsigned char                    *const plain_msg = (arena) ? (unsigned char *)tlv_decode_arena_alloc (arena, length) : (unsigned char *)calloc (1, length);
 
   if (plain_msg) {
+    if (arena) {
+      memset (plain_msg, 0, length);
+    }
     /*
      * Decrypt the security protected NAS message
      */
@@ -809,11 +823,20 @@ static int _nas_message_protected_decode (
         header->sequence_number,
         length, emm_security_context,
         status);
+    /*
+     * The plain message is decoded over the security header (nas_message_t
+     * is an union), clear the MAC and the sequence number that would else be
+     * taken for the presence mask of the optional IEs
+     */
+    header->message_authentication_code = 0;
+    header->sequence_number = 0;
     /*
      * Decode the decrypted message as plain NAS message
      */
-    bytes = _nas_message_plain_decode (plain_msg, header, msg, length);
-    free_wrapper ((void**) &plain_msg);
+    bytes = _nas_message_plain_decode (plain_msg, header, msg, length, arena);
+    if (!arena) {
+      free_wrapper ((void**) &plain_msg);
+    }
   }
 
   OAILOG_FUNC_RETURN (LOG_NAS, bytes);
@@ -960,28 +983,21 @@ static int _nas_message_protected_encode (
   OAILOG_FUNC_IN (LOG_NAS);
   emm_security_context_t                 *emm_security_context = (emm_security_context_t *) security;
   int                                     bytes = TLV_BUFFER_TOO_SHORT;
-  unsigned char                          *plain_msg = (unsigned char *)calloc (1, length);
 
-  if (plain_msg) {
+  /*
+   * Encode the security protected NAS message as plain NAS message
+   * directly in the output buffer
+   */
+  int                                     size = _nas_message_plain_encode (buffer, &msg->header,
+                                                                            &msg->plain, length);
+
+  if (size > 0) {
     /*
-     * Encode the security protected NAS message as plain NAS message
+     * Encrypt the encoded plain NAS message in place
      */
-    int                                     size = _nas_message_plain_encode (plain_msg, &msg->header,
-                                                                              &msg->plain, length);
-
-    if (size > 0) {
-      //static uint8_t seq = 0;
-      /*
-       * Encrypt the encoded plain NAS message
-       */
-      bytes = _nas_message_encrypt (buffer, plain_msg, msg->header.security_header_type, msg->header.message_authentication_code, msg->header.sequence_number,
-                                    SECU_DIRECTION_DOWNLINK,
-                                    size, emm_security_context);
-      //seq, size);
-      //seq ++;
-    }
-
-    free_wrapper ((void**) &plain_msg);
+    bytes = _nas_message_encrypt (buffer, buffer, msg->header.security_header_type, msg->header.message_authentication_code, msg->header.sequence_number,
+                                  SECU_DIRECTION_DOWNLINK,
+                                  size, emm_security_context);
   }
 
   OAILOG_FUNC_RETURN (LOG_NAS, bytes);
@@ -1108,7 +1124,8 @@ static int _nas_message_decrypt (
            * length in bits
            */
           stream_cipher.blength = length << 3;
-          nas_stream_encrypt_eea2 (&stream_cipher, (uint8_t*)dest);
+          nas_stream_aes_key_setup (&emm_security_context->knas_enc_aes, emm_security_context->knas_enc);
+          nas_stream_encrypt_eea2_with_key (&emm_security_context->knas_enc_aes, &stream_cipher, (uint8_t*)dest);
           /*
            * Decode the first octet (security header type or EPS bearer identity,
            * * * * and protocol discriminator)
@@ -1160,6 +1177,7 @@ static int _nas_message_decrypt (
  ** Description: Encrypt plain NAS message                                 **
  **                                                                        **
  ** Inputs   src:   Pointer to the decrypted data buffer       **
+ **       (may be dest, encryption is then done in place) **
  **    security_header_type:    The security header type                   **
  **    code:    The message authentication code            **
  **    seq:   The sequence number                        **
@@ -1200,7 +1218,9 @@ static int _nas_message_encrypt (
   case SECURITY_HEADER_TYPE_INTEGRITY_PROTECTED:
   case SECURITY_HEADER_TYPE_INTEGRITY_PROTECTED_NEW:
     OAILOG_DEBUG (LOG_NAS, "No encryption of message according to security header type 0x%02x\n", security_header_type);
-    memcpy (dest, src, length);
+    if (dest != src) {
+      memcpy (dest, src, length);
+    }
     OAILOG_FUNC_RETURN (LOG_NAS, length);
     break;
 
@@ -1252,14 +1272,17 @@ static int _nas_message_encrypt (
          * length in bits
          */
         stream_cipher.blength = length << 3;
-        nas_stream_encrypt_eea2 (&stream_cipher, (uint8_t*)dest);
+        nas_stream_aes_key_setup (&emm_security_context->knas_enc_aes, emm_security_context->knas_enc);
+        nas_stream_encrypt_eea2_with_key (&emm_security_context->knas_enc_aes, &stream_cipher, (uint8_t*)dest);
         OAILOG_FUNC_RETURN (LOG_NAS, length);
       }
       break;
 
     case NAS_SECURITY_ALGORITHMS_EEA0:
       OAILOG_DEBUG (LOG_NAS, "NAS_SECURITY_ALGORITHMS_EEA0 dir %d ul_count.seq_num %d dl_count.seq_num %d\n", direction, emm_security_context->ul_count.seq_num, emm_security_context->dl_count.seq_num);
-      memcpy (dest, src, length);
+      if (dest != src) {
+        memcpy (dest, src, length);
+      }
       OAILOG_FUNC_RETURN (LOG_NAS, length);
       break;
 
@@ -1379,7 +1402,8 @@ static uint32_t _nas_message_get_mac (
        * length in bits
        */
       stream_cipher.blength = length << 3;
-      nas_stream_encrypt_eia2 (&stream_cipher, mac);
+      nas_stream_aes_key_setup (&emm_security_context->knas_int_aes, emm_security_context->knas_int);
+      nas_stream_encrypt_eia2_with_key (&emm_security_context->knas_int_aes, &stream_cipher, mac);
       OAILOG_DEBUG (LOG_NAS, "NAS_SECURITY_ALGORITHMS_EIA2 returned MAC %x.%x.%x.%x(%u) for length %lu direction %d, count %d\n",
           mac[0], mac[1], mac[2], mac[3], *((uint32_t *) & mac), length, direction, count);
       mac32 = (uint32_t *) & mac;
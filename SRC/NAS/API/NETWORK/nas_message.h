@@ -126,7 +126,8 @@ int nas_message_decode(
     nas_message_t      *msg,
     size_t              length,
     void               *security,
-    nas_message_decode_status_t * status);
+    nas_message_decode_status_t * status,
+    tlv_decode_arena_t *arena);
 
 int nas_message_encode(
     unsigned char              *buffer,
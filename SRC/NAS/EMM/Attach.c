@@ -77,6 +77,7 @@
 #include "mme_app_ue_context.h"
 #include "mme_config.h"
 #include "nas_itti_messaging.h"
+#include "nas_auth_vectors.h"
 
 
 /****************************************************************************/
@@ -1016,8 +1017,7 @@ _emm_attach_identify (
     // The UE identifies itself using an IMSI
     if (!IS_EMM_CTXT_PRESENT_AUTH_VECTORS(emm_ctx)) {
       // Ask upper layer to fetch new security context
-      nas_itti_auth_info_req (emm_ctx->ue_id, emm_ctx->_imsi64, true, &emm_ctx->originating_tai.plmn,
-                              MAX_EPS_AUTH_VECTORS, NULL);
+      nas_auth_vectors_request (emm_ctx->ue_id, emm_ctx->_imsi64, true, &emm_ctx->originating_tai.plmn, NULL);
       rc = RETURNok;
     } else {
       ksi_t                                   eksi = 0;
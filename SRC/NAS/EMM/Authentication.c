@@ -62,6 +62,7 @@
 #include "nas_proc.h"
 #include "emm_sap.h"
 #include "nas_itti_messaging.h"
+#include "nas_auth_vectors.h"
 
 /****************************************************************************/
 /****************  E X T E R N A L    D E F I N I T I O N S  ****************/
@@ -299,8 +300,7 @@ int emm_proc_authentication_failure (
       memcpy (resync_param.data, (emm_ctx->_vector[emm_ctx->_security.vector_index].rand), RAND_LENGTH_OCTETS);
       memcpy ((resync_param.data + RAND_LENGTH_OCTETS), auts->data, AUTS_LENGTH);
       // TODO: Double check this case as there is no identity request being sent.
-      nas_itti_auth_info_req(ue_id, emm_ctx->_imsi64, false, &emm_ctx->originating_tai.plmn, MAX_EPS_AUTH_VECTORS,
-                             &resync_param);
+      nas_auth_vectors_request (ue_id, emm_ctx->_imsi64, false, &emm_ctx->originating_tai.plmn, &resync_param);
       emm_ctx_clear_auth_vectors(emm_ctx);
       rc = RETURNok;
       emm_proc_common_clear_args(ue_id);
@@ -527,8 +527,7 @@ int _authentication_check_imsi_5_4_2_5__1 (void * args) {
       REQUIREMENT_3GPP_24_301(R10_5_4_2_5__1);
       if (IS_EMM_CTXT_VALID_IMSI(emm_ctx)) { // VALID means received in IDENTITY RESPONSE
         if (emm_ctx->_imsi64 != emm_ctx->saved_imsi64) {
-          nas_itti_auth_info_req (emm_ctx->ue_id, emm_ctx->_imsi64, false, &emm_ctx->originating_tai.plmn,
-                                  MAX_EPS_AUTH_VECTORS, NULL);
+          nas_auth_vectors_request (emm_ctx->ue_id, emm_ctx->_imsi64, false, &emm_ctx->originating_tai.plmn, NULL);
           OAILOG_FUNC_RETURN (LOG_NAS_EMM, RETURNok);
         }
       }
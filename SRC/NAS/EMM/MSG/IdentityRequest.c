@@ -44,7 +44,7 @@ decode_identity_request (
   /*
    * Decoding mandatory fields
    */
-  if ((decoded_result = decode_u8_identity_type_2 (&identity_request->identitytype, 0, *(buffer + decoded) >> 4, len - decoded)) < 0)
+  if ((decoded_result = decode_u8_identity_type_2 (&identity_request->identitytype, 0, *(buffer + decoded) & 0x0f, len - decoded)) < 0)
     return decoded_result;
 
   decoded++;
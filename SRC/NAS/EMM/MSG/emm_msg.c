@@ -75,6 +75,8 @@ static int                              _emm_msg_encode_header (
  ** Inputs:  buffer:    Pointer to the buffer containing the EMM   **
  **             message data                               **
  **          len:       Number of bytes that should be decoded     **
+ **          arena:     Decode arena of the variable length IEs,   **
+ **             NULL to allocate them on the heap          **
  **      Others:    None                                       **
  **                                                                        **
  ** Outputs:     msg:       The EMM message structure to be filled     **
@@ -88,11 +90,13 @@ int
 emm_msg_decode (
   EMM_msg * msg,
   uint8_t * buffer,
-  uint32_t len)
+  uint32_t len,
+  tlv_decode_arena_t * arena)
 {
   OAILOG_FUNC_IN (LOG_NAS_EMM);
   int                                     header_result = 0;
   int                                     decode_result = 0;
+  tlv_decode_arena_t                     *previous_arena = NULL;
   uint8_t                                *buffer_log = buffer;
   uint32_t                                len_log = len;
   bool                                    is_down_link = false;
@@ -111,6 +115,8 @@ emm_msg_decode (
   len -= header_result;
   OAILOG_INFO (LOG_NAS_EMM, "EMM-MSG   - Message Type 0x%02x\n", msg->header.message_type);
 
+  previous_arena = tlv_decode_arena_attach (arena);
+
   switch (msg->header.message_type) {
   case EMM_INFORMATION:
     decode_result = decode_emm_information (&msg->emm_information, buffer, len);
@@ -232,6 +238,8 @@ emm_msg_decode (
      */
   }
 
+  tlv_decode_arena_attach (previous_arena);
+
   if (decode_result < 0) {
     OAILOG_ERROR (LOG_NAS_EMM, "EMM-MSG   - Failed to decode L3 EMM message 0x%x " "(%d)\n", msg->header.message_type, decode_result);
     OAILOG_FUNC_RETURN (LOG_NAS_EMM, decode_result);
@@ -40,6 +40,7 @@ Description Defines EPS Mobility Management messages and functions used
 #define FILE_EMM_MSG_SEEN
 
 #include <stdint.h>
+#include "TLVDecoder.h"
 #include "emm_msgDef.h"
 
 #include "AttachRequest.h"
@@ -127,7 +128,7 @@ typedef union {
 /******************  E X P O R T E D    F U N C T I O N S  ******************/
 /****************************************************************************/
 
-int emm_msg_decode(EMM_msg *msg, uint8_t *buffer, uint32_t len);
+int emm_msg_decode(EMM_msg *msg, uint8_t *buffer, uint32_t len, tlv_decode_arena_t *arena);
 
 int emm_msg_encode(EMM_msg *msg, uint8_t *buffer, uint32_t len);
 
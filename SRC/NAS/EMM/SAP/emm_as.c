@@ -102,7 +102,8 @@ static int _emm_as_recv (
     bstring msg,
     size_t len,
     int *emm_cause,
-    nas_message_decode_status_t   * decode_status);
+    nas_message_decode_status_t   * decode_status,
+    tlv_decode_arena_t * arena);
 
 
 static int _emm_as_establish_req (const emm_as_establish_t * msg, int *emm_cause);
@@ -264,6 +265,8 @@ int emm_as_send (const emm_as_t * msg)
  ** Inputs:  ue_id:      UE lower layer identifier                  **
  **      msg:       The EMM message to process                 **
  **      len:       The length of the EMM message              **
+ **      arena:     Decode arena of the message, released by   **
+ **             the caller                                 **
  **      Others:    None                                       **
  **                                                                        **
  ** Outputs:     emm_cause: EMM cause code                             **
@@ -278,7 +281,8 @@ static int _emm_as_recv (
   bstring msg,
   size_t len,
   int *emm_cause,
-  nas_message_decode_status_t   * decode_status)
+  nas_message_decode_status_t   * decode_status,
+  tlv_decode_arena_t * arena)
 {
   OAILOG_FUNC_IN (LOG_NAS_EMM);
   nas_message_decode_status_t             local_decode_status = {0};
@@ -313,7 +317,7 @@ static int _emm_as_recv (
   /*
    * Decode the received message
    */
-  decoder_rc = nas_message_decode (msg->data, &nas_msg, len, emm_security_context, decode_status);
+  decoder_rc = nas_message_decode (msg->data, &nas_msg, len, emm_security_context, decode_status, arena);
 
   if (decoder_rc < 0) {
     OAILOG_WARNING (LOG_NAS_EMM, "EMMAS-SAP - Failed to decode NAS message " "(err=%d)\n", decoder_rc);
@@ -462,11 +466,19 @@ static int _emm_as_data_ind (const emm_as_data_t * msg, int *emm_cause)
   if ( EMM_AS_DATA_DELIVERED_TRUE == msg->delivered) {
     if (blength(msg->nas_msg) > 0) {
       /*
-       * Process the received NAS message
+       * Process the received NAS message, the deciphered message and its
+       * decoded IEs are allocated from the arena released once processed
        */
-      bstring                                   plain_msg = bstrcpy(msg->nas_msg);
+      tlv_decode_arena_t                        arena;
+      struct tagbstring                         plain_msg;
 
-      if (plain_msg) {
+      tlv_decode_arena_init (&arena);
+      plain_msg.slen = blength(msg->nas_msg);
+      plain_msg.mlen = plain_msg.slen;
+      plain_msg.data = tlv_decode_arena_alloc (&arena, plain_msg.slen);
+      bwriteprotect (plain_msg);
+
+      if (plain_msg.data) {
         nas_message_security_header_t           header = {0};
         emm_security_context_t                 *security = NULL;        /* Current EPS NAS security context     */
         nas_message_decode_status_t             decode_status = {0};
@@ -486,7 +498,7 @@ static int _emm_as_data_ind (const emm_as_data_t * msg, int *emm_cause)
         }
 
         int  bytes = nas_message_decrypt (msg->nas_msg->data,
-            plain_msg->data,
+            plain_msg.data,
             &header,
             blength(msg->nas_msg),
             security,
@@ -498,6 +510,7 @@ static int _emm_as_data_ind (const emm_as_data_t * msg, int *emm_cause)
            * Failed to decrypt the message
            */
           *emm_cause = EMM_CAUSE_PROTOCOL_ERROR;
+          tlv_decode_arena_release (&arena);
           OAILOG_FUNC_RETURN (LOG_NAS_EMM, bytes);
         } else if (header.protocol_discriminator == EPS_MOBILITY_MANAGEMENT_MESSAGE) {
           /*
@@ -512,16 +525,15 @@ static int _emm_as_data_ind (const emm_as_data_t * msg, int *emm_cause)
           originating_tai.plmn.mnc_digit2 = msg->plmn_id->mnc_digit2;
           originating_tai.plmn.mnc_digit3 = msg->plmn_id->mnc_digit3;
 
-          rc = _emm_as_recv (msg->ue_id, &originating_tai, &msg->ecgi, plain_msg, bytes, emm_cause, &decode_status);
+          rc = _emm_as_recv (msg->ue_id, &originating_tai, &msg->ecgi, &plain_msg, bytes, emm_cause, &decode_status, &arena);
         } else if (header.protocol_discriminator == EPS_SESSION_MANAGEMENT_MESSAGE) {
           /*
            * Foward ESM data to EPS session management
            */
-          rc = lowerlayer_data_ind (msg->ue_id, plain_msg);
+          rc = lowerlayer_data_ind (msg->ue_id, &plain_msg);
         }
-
-        bdestroy (plain_msg);
       }
+      tlv_decode_arena_release (&arena);
     } else {
       /*
        * Process successfull lower layer transfer indication
@@ -569,6 +581,7 @@ static int _emm_as_establish_req (const emm_as_establish_t * msg, int *emm_cause
   int                                     decoder_rc = 0;
   int                                     rc = RETURNerror;
   tai_t                                   originating_tai = {.plmn = {0}, .tac = INVALID_TAC_0000};
+  tlv_decode_arena_t                      arena;
 
   OAILOG_FUNC_IN (LOG_NAS_EMM);
   OAILOG_INFO (LOG_NAS_EMM, "EMMAS-SAP - Received AS connection establish request\n");
@@ -586,13 +599,16 @@ static int _emm_as_establish_req (const emm_as_establish_t * msg, int *emm_cause
   }
 
   /*
-   * Decode initial NAS message
+   * Decode initial NAS message, its IEs are allocated from the arena
+   * released once the message is processed
    */
-  decoder_rc = nas_message_decode (msg->nas_msg->data, &nas_msg, blength(msg->nas_msg), emm_security_context, &decode_status);
+  tlv_decode_arena_init (&arena);
+  decoder_rc = nas_message_decode (msg->nas_msg->data, &nas_msg, blength(msg->nas_msg), emm_security_context, &decode_status, &arena);
   bdestroy(msg->nas_msg);
 
   if (decoder_rc < TLV_FATAL_ERROR) {
     *emm_cause = EMM_CAUSE_PROTOCOL_ERROR;
+    tlv_decode_arena_release (&arena);
     OAILOG_FUNC_RETURN (LOG_NAS_EMM, decoder_rc);
   } else if (decoder_rc == TLV_UNEXPECTED_IEI) {
     *emm_cause = EMM_CAUSE_IE_NOT_IMPLEMENTED;
@@ -627,6 +643,7 @@ static int _emm_as_establish_req (const emm_as_establish_t * msg, int *emm_cause
 
       //Clean up S1AP and MME UE Context 
       nas_itti_detach_req(msg->ue_id);
+      tlv_decode_arena_release (&arena);
       OAILOG_FUNC_RETURN (LOG_NAS_EMM, RETURNok);
     }
     
@@ -639,6 +656,7 @@ static int _emm_as_establish_req (const emm_as_establish_t * msg, int *emm_cause
       *emm_cause = EMM_CAUSE_UE_IDENTITY_CANT_BE_DERIVED_BY_NW;
       // Delete EMM,ESM conext, MMEAPP UE context and S1AP context
       nas_proc_implicit_detach_ue_ind(emm_ctx->ue_id);       
+      tlv_decode_arena_release (&arena);
       OAILOG_FUNC_RETURN (LOG_NAS_EMM, RETURNok);
     }
     // Process Detach Request
@@ -656,6 +674,7 @@ static int _emm_as_establish_req (const emm_as_establish_t * msg, int *emm_cause
       *emm_cause = EMM_CAUSE_UE_IDENTITY_CANT_BE_DERIVED_BY_NW;
       // Send Reject with cause "UE identity cannot be derived by the network" to trigger fresh attach 
       rc = emm_proc_tracking_area_update_reject (msg->ue_id, EMM_CAUSE_UE_IDENTITY_CANT_BE_DERIVED_BY_NW);
+      tlv_decode_arena_release (&arena);
       OAILOG_FUNC_RETURN (LOG_NAS_EMM,rc);
     }
     
@@ -674,6 +693,7 @@ static int _emm_as_establish_req (const emm_as_establish_t * msg, int *emm_cause
       *emm_cause = EMM_CAUSE_UE_IDENTITY_CANT_BE_DERIVED_BY_NW;
       // Send Service Reject with cause "UE identity cannot be derived by the network" to trigger fresh attach 
       rc = emm_proc_service_reject (msg->ue_id, EMM_CAUSE_UE_IDENTITY_CANT_BE_DERIVED_BY_NW);
+      tlv_decode_arena_release (&arena);
       OAILOG_FUNC_RETURN (LOG_NAS_EMM,rc);
     }
     // Process Service request
@@ -687,6 +707,7 @@ static int _emm_as_establish_req (const emm_as_establish_t * msg, int *emm_cause
        // Requirement MME24.301R10_4.4.4.3_2
        ((1 == decode_status.security_context_available) && (0 == decode_status.mac_matched))) {
       *emm_cause = EMM_CAUSE_PROTOCOL_ERROR;
+      tlv_decode_arena_release (&arena);
       OAILOG_FUNC_RETURN (LOG_NAS_EMM, decoder_rc);
     }
 
@@ -701,6 +722,7 @@ static int _emm_as_establish_req (const emm_as_establish_t * msg, int *emm_cause
     break;
   }
 
+  tlv_decode_arena_release (&arena);
   OAILOG_FUNC_RETURN (LOG_NAS_EMM, rc);
 }
 
@@ -54,6 +54,7 @@ Description Defines internal private data handled by EPS Mobility
 #include "emm_fsm.h"
 #include "mme_api.h"
 #include "3gpp_33.401.h"
+#include "secu_defs.h"
 
 #include "AdditionalUpdateType.h"
 #include "UeNetworkCapability.h"
@@ -102,6 +103,8 @@ typedef struct emm_security_context_s {
   int vector_index;   /* Pointer on vector */
   uint8_t knas_enc[AUTH_KNAS_ENC_SIZE];/* NAS cyphering key               */
   uint8_t knas_int[AUTH_KNAS_INT_SIZE];/* NAS integrity key               */
+  nas_stream_aes_key_t knas_enc_aes;   /* knas_enc expanded for 128-EEA2  */
+  nas_stream_aes_key_t knas_int_aes;   /* knas_int expanded for 128-EIA2  */
 
   struct count_s{
     uint32_t spare:8;
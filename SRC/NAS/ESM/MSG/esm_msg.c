@@ -74,6 +74,8 @@ static int                              _esm_msg_encode_header (
  ** Inputs:  buffer:  Pointer to the buffer containing the ESM   **
  **       message                                    **
  **      len:   Number of bytes that should be decoded     **
+ **      arena:   Decode arena of the variable length IEs,   **
+ **       NULL to allocate them on the heap          **
  **    Others:  None                                       **
  **                                                                        **
  ** Outputs:   msg:   The ESM message structure to be filled     **
@@ -87,10 +89,12 @@ int
 esm_msg_decode (
   ESM_msg * msg,
   uint8_t * buffer,
-  uint32_t len)
+  uint32_t len,
+  tlv_decode_arena_t * arena)
 {
   int                                     header_result = 0;
   int                                     decode_result = 0;
+  tlv_decode_arena_t                     *previous_arena = NULL;
   uint8_t                                *buffer_log = buffer;
   uint32_t                                len_log = len;
   int                                     down_link = 0;
@@ -108,6 +112,8 @@ esm_msg_decode (
   buffer += header_result;
   len -= header_result;
 
+  previous_arena = tlv_decode_arena_attach (arena);
+
   switch (msg->header.message_type) {
   case PDN_DISCONNECT_REQUEST:
     decode_result = decode_pdn_disconnect_request (&msg->pdn_disconnect_request, buffer, len);
@@ -203,6 +209,8 @@ esm_msg_decode (
     break;
   }
 
+  tlv_decode_arena_attach (previous_arena);
+
   if (decode_result < 0) {
     OAILOG_ERROR (LOG_NAS_ESM, "ESM-MSG   - Failed to decode L3 ESM message 0x%x " "(%u)\n", msg->header.message_type, decode_result);
     OAILOG_FUNC_RETURN (LOG_NAS_ESM, decode_result);
@@ -65,6 +65,7 @@ Description Defines EPS Session Management messages and functions used
 #include "EsmStatus.h"
 
 #include <stdint.h>
+#include "TLVDecoder.h"
 
 /****************************************************************************/
 /*********************  G L O B A L    C O N S T A N T S  *******************/
@@ -113,7 +114,7 @@ typedef union {
 /******************  E X P O R T E D    F U N C T I O N S  ******************/
 /****************************************************************************/
 
-int esm_msg_decode(ESM_msg *msg, uint8_t *buffer, uint32_t len);
+int esm_msg_decode(ESM_msg *msg, uint8_t *buffer, uint32_t len, tlv_decode_arena_t *arena);
 
 int esm_msg_encode(ESM_msg *msg, uint8_t *buffer, uint32_t len);
 
@@ -320,13 +320,16 @@ _esm_sap_recv (
   int                                     rc = RETURNerror;
   int                                     decoder_rc;
   ESM_msg                                 esm_msg;
+  tlv_decode_arena_t                      arena;
 
   OAILOG_FUNC_IN (LOG_NAS_ESM);
   memset (&esm_msg, 0, sizeof (ESM_msg));
   /*
-   * Decode the received ESM message
+   * Decode the received ESM message, its IEs are allocated from the arena
+   * released once the message is processed
    */
-  decoder_rc = esm_msg_decode (&esm_msg, (uint8_t *)bdata(req), blength(req));
+  tlv_decode_arena_init (&arena);
+  decoder_rc = esm_msg_decode (&esm_msg, (uint8_t *)bdata(req), blength(req), &arena);
 
   /*
    * Process decoding errors
@@ -343,6 +346,7 @@ _esm_sap_recv (
        * Return indication that received message has been discarded
        */
       *err = ESM_SAP_DISCARDED;
+      tlv_decode_arena_release (&arena);
       OAILOG_FUNC_RETURN (LOG_NAS_ESM, RETURNok);
     }
     /*
@@ -742,6 +746,7 @@ _esm_sap_recv (
     rc = RETURNok;
   }
 
+  tlv_decode_arena_release (&arena);
   OAILOG_FUNC_RETURN (LOG_NAS_ESM, rc);
 }
 
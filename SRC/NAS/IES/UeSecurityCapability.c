@@ -48,24 +48,34 @@ decode_ue_security_capability (
   ielen = *(buffer + decoded);
   decoded++;
   CHECK_LENGTH_DECODER (len - decoded, ielen);
+
+  if (ielen < 2) {
+    errorCodeDecoder = TLV_VALUE_DOESNT_MATCH;
+    return TLV_VALUE_DOESNT_MATCH;
+  }
+
   uesecuritycapability->eea = *(buffer + decoded);
   decoded++;
   uesecuritycapability->eia = *(buffer + decoded);
   decoded++;
 
-  if (len >= decoded + 3) {
+  if (ielen >= 4) {
     uesecuritycapability->umts_present = 1;
     uesecuritycapability->uea = *(buffer + decoded);
     decoded++;
     uesecuritycapability->uia = *(buffer + decoded) & 0x7f;
     decoded++;
 
-    if (len == decoded + 4) {
+    if (ielen >= 5) {
       uesecuritycapability->gprs_present = 1;
       uesecuritycapability->gea = *(buffer + decoded) & 0x7f;
       decoded++;
     }
   }
+  /*
+   * The IE may carry up to 13 octets (spare octets 8 to 13 for future algorithms)
+   */
+  decoded = (iei > 0 ? 1 : 0) + 1 + ielen;
 #if NAS_DEBUG
   dump_ue_security_capability_xml (uesecuritycapability, iei);
 #endif
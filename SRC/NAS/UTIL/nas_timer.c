@@ -39,6 +39,7 @@
 #include <pthread.h>
 #include <assert.h>
 #include <stdint.h>
+#include <stdbool.h>
 
 #include <string.h>             // memset
 #include <stdlib.h>             // malloc, free
@@ -69,12 +70,15 @@
    The callback function is scheduled to be executed upon expiration of
    the timer that has been previously setup to the initial interval time
    value when the timer entry was allocated.
+   Entries are stored inline in the chunks of the timer database and are
+   never moved, they are chained in the free list when not allocated.
 */
 typedef struct {
 #if ENABLE_ITTI
-  long                                    timer_id;     /* Timer id returned by the timer API from ITTI */
+  long                                    timer_id;     /* Timer id returned by the timer API from ITTI,
+                                                         * 0 when not armed (stopped or expired) */
 #else
-  pthread_t                               pid;  /* Thread identifier of the callback    */
+  uint32_t                                heap_pos;     /* Position in the queue of active entries */
 #endif
 
   struct timeval                          itv;  /* Initial interval timer value         */
@@ -82,33 +86,56 @@ typedef struct {
 
   nas_timer_callback_t                    cb;   /* Callback executed at timer expiration */
   void                                   *args; /* Callback argument parameters          */
+
+  uint32_t                                next_free;    /* Next entry in the free list   */
+  uint8_t                                 generation;   /* Incremented at each release   */
+  uint8_t                                 allocated;
 } nas_timer_entry_t;
 
-/* Structure of a timer queue - list of active interval timer entries
-   ------------------------------------------------------------------
-   At any time, the first entry of the queue is always associated to the
-   first timer that will come to expire. Upon timer expiration, the first
-   entry is removed from the queue and freed.
+/* Timer identifier
+   ----------------
+   The identifier returned to the caller is made of the entry index and of
+   the generation of the entry, so that an identifier kept after the timer
+   has been stopped does not refer to the entry once it has been reused.
+   The generation is never 0, thus an identifier is always > 0.
 */
-typedef struct _nas_timer_queue_t {
-  int                                     id;   /* Identifier of the current timer entry */
-  nas_timer_entry_t                      *entry;        /* The current timer entry       */
-  struct _nas_timer_queue_t              *prev; /* The previous timer entry in the queue */
-  struct _nas_timer_queue_t              *next; /* The next timer entry in the queue     */
-} timer_queue_t;
+#define NAS_TIMER_INDEX_BITS          24
+#define NAS_TIMER_INDEX_MASK          ((1 << NAS_TIMER_INDEX_BITS) - 1)
+#define NAS_TIMER_GENERATION_MAX      0x7F
+#define NAS_TIMER_MAX_ENTRIES         (1 << NAS_TIMER_INDEX_BITS)
+#define NAS_TIMER_ID(gEN, iNDEX)      ((int)(((uint32_t)(gEN) << NAS_TIMER_INDEX_BITS) | (iNDEX)))
+#define NAS_TIMER_ID_INDEX(iD)        ((uint32_t)(iD) & NAS_TIMER_INDEX_MASK)
+#define NAS_TIMER_ID_GENERATION(iD)   ((uint8_t)((uint32_t)(iD) >> NAS_TIMER_INDEX_BITS))
+
+/* Entries are allocated by chunks, the database grows on demand */
+#define NAS_TIMER_CHUNK_BITS          12
+#define NAS_TIMER_CHUNK_SIZE          (1 << NAS_TIMER_CHUNK_BITS)
+#define NAS_TIMER_CHUNK_MASK          (NAS_TIMER_CHUNK_SIZE - 1)
+#define NAS_TIMER_MAX_CHUNKS          (NAS_TIMER_MAX_ENTRIES / NAS_TIMER_CHUNK_SIZE)
+
+#define NAS_TIMER_NIL                 UINT32_MAX
 
 /* Structure of a timer database
    -----------------------------
    The timer database is managed to provide unique identifier to timer at
    startup and to maintain an ordered queue of active timer entries.
+   With ITTI the ordering is done by the ITTI timer wheel, each entry owning
+   one ITTI timer; otherwise the queue of active entries is a binary heap
+   ordered on expiration time, its first entry drives the system timer.
+   Free entries are reused in FIFO order to delay identifier reuse.
 */
 typedef struct {
-  int                                     timer_id;     /* Identifier of the first available timer entry */
-#define TIMER_DATABASE_SIZE 256
-  timer_queue_t                           tq[TIMER_DATABASE_SIZE];
-  timer_queue_t                          *head; /* Pointer to the first timer entry to be fired  */
+  nas_timer_entry_t                     **chunks;       /* Chunks of timer entries       */
+  uint32_t                                nb_chunks;
+  uint32_t                                nb_entries;   /* Number of entries in chunks   */
+  uint32_t                                nb_allocated; /* Number of allocated entries   */
+  uint32_t                                free_head;    /* First entry to be reused      */
+  uint32_t                                free_tail;    /* Last released entry           */
 
 #if ENABLE_ITTI == 0
+  uint32_t                               *heap; /* Queue of active timer entries */
+  uint32_t                                heap_size;
+  uint32_t                                heap_capacity;
   pthread_mutex_t                         mutex;
 #endif
 } nas_timer_database_t;
@@ -117,11 +144,9 @@ typedef struct {
    The timer database
 */
 static nas_timer_database_t             _nas_timer_db = {
-  0,
-  {},
-  NULL
+  NULL, 0, 0, 0, NAS_TIMER_NIL, NAS_TIMER_NIL
 #if ENABLE_ITTI == 0
-    , PTHREAD_MUTEX_INITIALIZER
+    , NULL, 0, 0, PTHREAD_MUTEX_INITIALIZER
 #endif
 };
 
@@ -133,6 +158,8 @@ static nas_timer_database_t             _nas_timer_db = {
 #  define nas_timer_unlock_db()   pthread_mutex_unlock(&_nas_timer_db.mutex)
 #endif
 
+#define NAS_TIMER_ENTRY(iNDEX)    (&_nas_timer_db.chunks[(iNDEX) >> NAS_TIMER_CHUNK_BITS][(iNDEX) & NAS_TIMER_CHUNK_MASK])
+
 /*
    The handler executed whenever the system timer expires
 */
@@ -151,14 +178,14 @@ _nas_timer_db_init (
   void);
 
 static int
-_nas_timer_db_get_id (
+_nas_timer_db_grow (
   void);
 
-static int
-_nas_timer_db_is_active (
+static nas_timer_entry_t *
+_nas_timer_db_get_entry (
   int id);
 
-static nas_timer_entry_t *
+static int
 _nas_timer_db_create_entry (
   long sec,
   nas_timer_callback_t cb,
@@ -168,22 +195,19 @@ static void
 _nas_timer_db_delete_entry (
   int id);
 
-static void
+#if ENABLE_ITTI == 0
+static int
 _nas_timer_db_insert_entry (
-  int id,
-  nas_timer_entry_t * te);
+  uint32_t index);
 
 static int
-_nas_timer_db_insert (
-  timer_queue_t * entry);
-
-static nas_timer_entry_t *
 _nas_timer_db_remove_entry (
-  int id);
+  nas_timer_entry_t * te);
 
 static int
-_nas_timer_db_remove (
-  timer_queue_t * entry);
+_nas_timer_db_restart_system_timer (
+  void);
+#endif
 
 /*
    -----------------------------------------------------------------------------
@@ -282,11 +306,9 @@ nas_timer_start (
   void *args)
 {
   int                                     id;
-  nas_timer_entry_t                      *te;
 
-#if ENABLE_ITTI
-  int                                     ret;
-  long                                    timer_id;
+#if ENABLE_ITTI == 0
+  int                                     expired;
 #endif
 
   /*
@@ -297,38 +319,41 @@ nas_timer_start (
   }
 
   /*
-   * Get an identifier for the new timer entry
+   * Create a new timer entry
    */
-  id = _nas_timer_db_get_id ();
+  nas_timer_lock_db ();
+  id = _nas_timer_db_create_entry (sec, cb, args);
 
   if (id < 0) {
     /*
-     * No available timer entry found
+     * No available timer entry
      */
+    nas_timer_unlock_db ();
     return (NAS_TIMER_INACTIVE_ID);
   }
 
+#if ENABLE_ITTI
+  nas_timer_entry_t                      *te = _nas_timer_db_get_entry (id);
+
   /*
-   * Create a new timer entry
+   * The ITTI timer carries the NAS timer identifier, see nas_timer_handle_signal_expiry()
    */
-  te = _nas_timer_db_create_entry (sec, cb, args);
-
-  if (te == NULL) {
+  if (timer_setup (sec, 0, TASK_NAS_MME, INSTANCE_DEFAULT, TIMER_ONE_SHOT, (void *)(intptr_t) id, &te->timer_id) == -1) {
+    _nas_timer_db_delete_entry (id);
     return (NAS_TIMER_INACTIVE_ID);
   }
-
+#else
   /*
    * Insert the new entry into the timer queue
    */
-  _nas_timer_db_insert_entry (id, te);
-#if ENABLE_ITTI
-  ret = timer_setup (sec, 0, TASK_NAS_MME, INSTANCE_DEFAULT, TIMER_ONE_SHOT, args, &timer_id);
+  expired = _nas_timer_db_insert_entry (NAS_TIMER_ID_INDEX (id));
+#endif
+  nas_timer_unlock_db ();
+#if ENABLE_ITTI == 0
 
-  if (ret == -1) {
-    return NAS_TIMER_INACTIVE_ID;
+  if (expired) {
+    _nas_timer_handler (SIGALRM);
   }
-
-  te->timer_id = timer_id;
 #endif
   return (id);
 }
@@ -352,28 +377,42 @@ int
 nas_timer_stop (
   int id)
 {
+  nas_timer_entry_t                      *te;
+  int                                     expired = 0;
+
+  nas_timer_lock_db ();
+  te = _nas_timer_db_get_entry (id);
+
   /*
    * Check if the timer entry is active
    */
-  if (_nas_timer_db_is_active (id)) {
-    nas_timer_entry_t                      *entry;
-
+  if (te) {
+#if ENABLE_ITTI
+    if (te->timer_id) {
+      timer_remove (te->timer_id);
+    }
+#else
     /*
      * Remove the entry from the timer queue
      */
-    entry = _nas_timer_db_remove_entry (id);
-#if ENABLE_ITTI
-    timer_remove (entry->timer_id);
-#else
-    (void)entry;
+    expired = _nas_timer_db_remove_entry (te);
 #endif
     /*
      * Delete the timer entry
      */
     _nas_timer_db_delete_entry (id);
+    nas_timer_unlock_db ();
+#if ENABLE_ITTI == 0
+
+    if (expired) {
+      _nas_timer_handler (SIGALRM);
+    }
+#endif
+    (void)expired;
     return (NAS_TIMER_INACTIVE_ID);
   }
 
+  nas_timer_unlock_db ();
   return (id);
 }
 
@@ -400,17 +439,35 @@ int
 nas_timer_restart (
   int id)
 {
-  int ret;
-  
+  nas_timer_entry_t                      *te;
+
+  nas_timer_lock_db ();
+  te = _nas_timer_db_get_entry (id);
+
   /*
    * Check if the timer entry is active
    */
-  if (_nas_timer_db_is_active (id)) {
+  if (te) {
+#if ENABLE_ITTI
+    if (te->timer_id) {
+      timer_remove (te->timer_id);
+      te->timer_id = 0;
+    }
+
+    if (timer_setup (te->itv.tv_sec, 0, TASK_NAS_MME, INSTANCE_DEFAULT, TIMER_ONE_SHOT, (void *)(intptr_t) id, &te->timer_id) == -1) {
+      _nas_timer_db_delete_entry (id);
+      nas_timer_unlock_db ();
+      return (NAS_TIMER_INACTIVE_ID);
+    }
+
+    nas_timer_unlock_db ();
+#else
+    int                                     expired;
+
     /*
      * Remove the entry from the timer queue
      */
-    nas_timer_entry_t                      *te = _nas_timer_db_remove_entry (id);
-
+    _nas_timer_db_remove_entry (te);
     /*
      * Initialize its interval timer value
      */
@@ -418,18 +475,17 @@ nas_timer_restart (
     /*
      * Insert again the entry into the timer queue
      */
-    _nas_timer_db_insert_entry (id, te);
-  #if ENABLE_ITTI
-    ret = timer_setup (te->itv.tv_sec, 0, TASK_NAS_MME, INSTANCE_DEFAULT, TIMER_ONE_SHOT, te->args, &(te->timer_id));
+    expired = _nas_timer_db_insert_entry (NAS_TIMER_ID_INDEX (id));
+    nas_timer_unlock_db ();
 
-    if (ret == -1) {
-      return NAS_TIMER_INACTIVE_ID;
+    if (expired) {
+      _nas_timer_handler (SIGALRM);
     }
-  #endif
-    
+#endif
     return (id);
   }
 
+  nas_timer_unlock_db ();
   return (NAS_TIMER_INACTIVE_ID);
 }
 
@@ -447,6 +503,9 @@ nas_timer_restart (
  **      timer entries. The entry is not removed from the queue of **
  **      active timer entries and shall be explicitly removed when **
  **      the timer expires.                                        **
+ **      With ITTI, the expired entry is retrieved from the NAS    **
+ **      timer identifier carried by the TIMER_HAS_EXPIRED message **
+ **      and stays allocated until it is stopped or restarted.     **
  **                                                                        **
  ** Inputs:  None                                                      **
  **      Others:    None                                       **
@@ -465,8 +524,19 @@ nas_timer_handle_signal_expiry (
   /*
    * Get the timer entry for which the system timer expired
    */
-  nas_timer_entry_t                      *te = _nas_timer_db.head->entry;
+  nas_timer_entry_t                      *te = _nas_timer_db_get_entry ((int)(intptr_t) arg_p);
+
+  /*
+   * Discard expiries of timers stopped or restarted meanwhile
+   */
+  if ((te == NULL) || (te->timer_id != timer_id)) {
+    return;
+  }
 
+  /*
+   * The ITTI one-shot timer is released on expiry
+   */
+  te->timer_id = 0;
   te->cb (te->args);
 }
 #else
@@ -474,15 +544,25 @@ static void
 _nas_timer_handler (
   int signal)
 {
-  /*
-   * At least one timer has been started
-   */
-  assert ((_nas_timer_db.head ) && (_nas_timer_db.head->entry ));
+  nas_timer_callback_t                    cb;
+  void                                   *args;
+  pthread_t                               pid;
+
   /*
    * Get the timer entry for which the system timer expired
    */
-  nas_timer_entry_t                      *te = _nas_timer_db.head->entry;
+  nas_timer_lock_db ();
 
+  if (_nas_timer_db.heap_size == 0) {
+    nas_timer_unlock_db ();
+    return;
+  }
+
+  nas_timer_entry_t                      *te = NAS_TIMER_ENTRY (_nas_timer_db.heap[0]);
+
+  cb = te->cb;
+  args = te->args;
+  nas_timer_unlock_db ();
   /*
    * Execute the callback function
    */
@@ -491,7 +571,7 @@ _nas_timer_handler (
   pthread_attr_init (&attr);
   pthread_attr_setscope (&attr, PTHREAD_SCOPE_SYSTEM);
   pthread_attr_setdetachstate (&attr, PTHREAD_CREATE_JOINABLE);
-  int                                     rc = pthread_create (&te->pid, &attr, te->cb, te->args);
+  int                                     rc = pthread_create (&pid, &attr, cb, args);
 
   pthread_attr_destroy (&attr);
 
@@ -501,7 +581,7 @@ _nas_timer_handler (
   if (rc == 0) {
     void                                   *result = NULL;
 
-    (void)pthread_join (te->pid, &result);
+    (void)pthread_join (pid, &result);
 
     /*
      * TODO: Check returned result ???
@@ -536,83 +616,130 @@ static void
 _nas_timer_db_init (
   void)
 {
-  int                                     i;
+  uint32_t                                i;
 
-  for (i = 0; i < TIMER_DATABASE_SIZE; i++) {
-    _nas_timer_db.tq[i].id = NAS_TIMER_INACTIVE_ID;
+  for (i = 0; i < _nas_timer_db.nb_chunks; i++) {
+    free_wrapper ((void **)&_nas_timer_db.chunks[i]);
   }
+
+  free_wrapper ((void **)&_nas_timer_db.chunks);
+  _nas_timer_db.nb_chunks = 0;
+  _nas_timer_db.nb_entries = 0;
+  _nas_timer_db.nb_allocated = 0;
+  _nas_timer_db.free_head = NAS_TIMER_NIL;
+  _nas_timer_db.free_tail = NAS_TIMER_NIL;
+#if ENABLE_ITTI == 0
+  free_wrapper ((void **)&_nas_timer_db.heap);
+  _nas_timer_db.heap_size = 0;
+  _nas_timer_db.heap_capacity = 0;
+#endif
 }
 
 /****************************************************************************
  **                                                                        **
- ** Name:    _nas_timer_db_get_id()                                    **
+ ** Name:    _nas_timer_db_grow()                                      **
  **                                                                        **
- ** Description: Gets the identifier of the first available timer entry in **
- **      the queue of active timer entries                         **
+ ** Description: Adds a chunk of free entries to the timer database        **
  **                                                                        **
  ** Inputs:  None                                                      **
  **      Others:    _nas_timer_db                              **
  **                                                                        **
  ** Outputs:     None                                                      **
- **      Return:    The identifier of the first available      **
- **             timer entry if the queue of active timers  **
- **             is not full; -1 otherwise.                 **
+ **      Return:    RETURNok, RETURNerror                      **
  **      Others:    _nas_timer_db                              **
  **                                                                        **
  ***************************************************************************/
 static int
-_nas_timer_db_get_id (
+_nas_timer_db_grow (
   void)
 {
-  int                                     i;
+  nas_timer_entry_t                     **chunks;
+  nas_timer_entry_t                      *chunk;
+  uint32_t                                i;
 
-  /*
-   * Search from the current timer entry to the last timer entry
-   */
-  for (i = _nas_timer_db.timer_id; i < TIMER_DATABASE_SIZE; i++) {
-    if (_nas_timer_db.tq[i].id < 0) {
-      _nas_timer_db.timer_id = i + 1;
-      return i;
-    }
+  if (_nas_timer_db.nb_chunks >= NAS_TIMER_MAX_CHUNKS) {
+    return (RETURNerror);
   }
 
-  /*
-   * Search from the first timer entry to the current timer entry
-   */
-  for (i = 0; i < _nas_timer_db.timer_id; i++) {
-    if (_nas_timer_db.tq[i].id < 0) {
-      _nas_timer_db.timer_id = i + 1;
-      return i;
-    }
+  chunks = realloc (_nas_timer_db.chunks, (_nas_timer_db.nb_chunks + 1) * sizeof (nas_timer_entry_t *));
+
+  if (chunks == NULL) {
+    return (RETURNerror);
   }
 
+  _nas_timer_db.chunks = chunks;
+  chunk = calloc (NAS_TIMER_CHUNK_SIZE, sizeof (nas_timer_entry_t));
+
+  if (chunk == NULL) {
+    return (RETURNerror);
+  }
+
+  _nas_timer_db.chunks[_nas_timer_db.nb_chunks++] = chunk;
+
   /*
-   * No available timer entry found
+   * Append the new entries to the free list
    */
-  return (-1);
+  for (i = 0; i < NAS_TIMER_CHUNK_SIZE; i++) {
+    uint32_t                                index = _nas_timer_db.nb_entries + i;
+
+    chunk[i].generation = 1;
+    chunk[i].next_free = (i + 1 < NAS_TIMER_CHUNK_SIZE) ? index + 1 : NAS_TIMER_NIL;
+#if ENABLE_ITTI == 0
+    chunk[i].heap_pos = NAS_TIMER_NIL;
+#endif
+  }
+
+  if (_nas_timer_db.free_tail != NAS_TIMER_NIL) {
+    NAS_TIMER_ENTRY (_nas_timer_db.free_tail)->next_free = _nas_timer_db.nb_entries;
+  } else {
+    _nas_timer_db.free_head = _nas_timer_db.nb_entries;
+  }
+
+  _nas_timer_db.free_tail = _nas_timer_db.nb_entries + NAS_TIMER_CHUNK_SIZE - 1;
+  _nas_timer_db.nb_entries += NAS_TIMER_CHUNK_SIZE;
+  return (RETURNok);
 }
 
 /****************************************************************************
  **                                                                        **
- ** Name:    _nas_timer_db_is_active()                                 **
+ ** Name:    _nas_timer_db_get_entry()                                 **
  **                                                                        **
- ** Description: Checks whether the entry with the given identifier is     **
- **      active within the queue of active timer entries           **
+ ** Description: Gets the timer entry with the given identifier, if this   **
+ **      identifier refers to an active timer entry                **
  **                                                                        **
- ** Inputs:  id:        Identifier of the timer entry to check     **
+ ** Inputs:  id:        Identifier of the timer entry to get       **
  **      Others:    _nas_timer_db                              **
  **                                                                        **
  ** Outputs:     None                                                      **
- **      Return:    true if the timer entry is active; false   **
- **             if it is not an active timer entry.        **
+ **      Return:    A pointer to the timer entry if it is      **
+ **             active; NULL otherwise.                    **
  **      Others:    None                                       **
  **                                                                        **
  ***************************************************************************/
-static int
-_nas_timer_db_is_active (
+static nas_timer_entry_t               *
+_nas_timer_db_get_entry (
   int id)
 {
-  return ((id != NAS_TIMER_INACTIVE_ID) && (_nas_timer_db.tq[id].id != NAS_TIMER_INACTIVE_ID));
+  nas_timer_entry_t                      *te;
+  uint32_t                                index;
+
+  if (id <= 0) {
+    return (NULL);
+  }
+
+  index = NAS_TIMER_ID_INDEX (id);
+
+  if (index >= _nas_timer_db.nb_entries) {
+    return (NULL);
+  }
+
+  te = NAS_TIMER_ENTRY (index);
+
+  if ((!te->allocated) || (te->generation != NAS_TIMER_ID_GENERATION (id))) {
+    return (NULL);
+  }
+
+  return (te);
 }
 
 /****************************************************************************
@@ -627,29 +754,45 @@ _nas_timer_db_is_active (
  **      Others:    None                                       **
  **                                                                        **
  ** Outputs:     None                                                      **
- **      Return:    A pointer to the new timer entry if        **
- **             successfully allocated; NULL otherwise     **
- **      Others:    None                                       **
+ **      Return:    The identifier of the new timer entry if   **
+ **             successfully allocated; -1 otherwise       **
+ **      Others:    _nas_timer_db                              **
  **                                                                        **
  ***************************************************************************/
-static nas_timer_entry_t               *
+static int
 _nas_timer_db_create_entry (
   long sec,
   nas_timer_callback_t cb,
   void *args)
 {
-  nas_timer_entry_t                      *te = (nas_timer_entry_t *) malloc (sizeof (nas_timer_entry_t));
-
-  if (te ) {
-    te->itv.tv_sec = sec;
-    te->itv.tv_usec = 0;
-    te->tv.tv_sec = te->itv.tv_sec;
-    te->tv.tv_usec = te->itv.tv_usec;
-    te->cb = cb;
-    te->args = args;
+  nas_timer_entry_t                      *te;
+  uint32_t                                index;
+
+  if ((_nas_timer_db.free_head == NAS_TIMER_NIL) && (_nas_timer_db_grow () != RETURNok)) {
+    return (-1);
   }
 
-  return (te);
+  index = _nas_timer_db.free_head;
+  te = NAS_TIMER_ENTRY (index);
+  _nas_timer_db.free_head = te->next_free;
+
+  if (_nas_timer_db.free_head == NAS_TIMER_NIL) {
+    _nas_timer_db.free_tail = NAS_TIMER_NIL;
+  }
+
+  te->allocated = 1;
+  te->next_free = NAS_TIMER_NIL;
+#if ENABLE_ITTI
+  te->timer_id = 0;
+#endif
+  te->itv.tv_sec = sec;
+  te->itv.tv_usec = 0;
+  te->tv.tv_sec = te->itv.tv_sec;
+  te->tv.tv_usec = te->itv.tv_usec;
+  te->cb = cb;
+  te->args = args;
+  _nas_timer_db.nb_allocated++;
+  return (NAS_TIMER_ID (te->generation, index));
 }
 
 /****************************************************************************
@@ -671,56 +814,122 @@ static void
 _nas_timer_db_delete_entry (
   int id)
 {
+  uint32_t                                index = NAS_TIMER_ID_INDEX (id);
+  nas_timer_entry_t                      *te = NAS_TIMER_ENTRY (index);
+
   /*
-   * The identifier of the timer is valid within the timer queue
+   * The identifier of the timer is valid within the timer database
    */
-  assert (_nas_timer_db.tq[id].id == id);
+  assert (te->allocated && (te->generation == NAS_TIMER_ID_GENERATION (id)));
   /*
-   * Delete the timer entry from the queue
+   * Release the entry, identifiers previously returned become invalid
    */
-  _nas_timer_db.tq[id].id = NAS_TIMER_INACTIVE_ID;
-  free_wrapper ((void**) &_nas_timer_db.tq[id].entry);
-  _nas_timer_db.tq[id].entry = NULL;
+  te->allocated = 0;
+  te->generation = (te->generation % NAS_TIMER_GENERATION_MAX) + 1;
+  te->cb = NULL;
+  te->args = NULL;
+  te->next_free = NAS_TIMER_NIL;
+
+  if (_nas_timer_db.free_tail != NAS_TIMER_NIL) {
+    NAS_TIMER_ENTRY (_nas_timer_db.free_tail)->next_free = index;
+  } else {
+    _nas_timer_db.free_head = index;
+  }
+
+  _nas_timer_db.free_tail = index;
+  _nas_timer_db.nb_allocated--;
+}
+
+#if ENABLE_ITTI == 0
+/*
+   Binary heap of active timer entries ordered on expiration time
+*/
+static inline void
+_nas_timer_db_heap_set (
+  uint32_t pos,
+  uint32_t index)
+{
+  _nas_timer_db.heap[pos] = index;
+  NAS_TIMER_ENTRY (index)->heap_pos = pos;
+}
+
+static void
+_nas_timer_db_heap_sift_up (
+  uint32_t pos)
+{
+  uint32_t                                index = _nas_timer_db.heap[pos];
+  nas_timer_entry_t                      *te = NAS_TIMER_ENTRY (index);
+
+  while (pos > 0) {
+    uint32_t                                parent = (pos - 1) / 2;
+
+    if (_nas_timer_cmp (&NAS_TIMER_ENTRY (_nas_timer_db.heap[parent])->tv, &te->tv) <= 0) {
+      break;
+    }
+
+    _nas_timer_db_heap_set (pos, _nas_timer_db.heap[parent]);
+    pos = parent;
+  }
+
+  _nas_timer_db_heap_set (pos, index);
+}
+
+static void
+_nas_timer_db_heap_sift_down (
+  uint32_t pos)
+{
+  uint32_t                                index = _nas_timer_db.heap[pos];
+  nas_timer_entry_t                      *te = NAS_TIMER_ENTRY (index);
+
+  for (;;) {
+    uint32_t                                child = (2 * pos) + 1;
+
+    if (child >= _nas_timer_db.heap_size) {
+      break;
+    }
+
+    if ((child + 1 < _nas_timer_db.heap_size)
+        && (_nas_timer_cmp (&NAS_TIMER_ENTRY (_nas_timer_db.heap[child + 1])->tv, &NAS_TIMER_ENTRY (_nas_timer_db.heap[child])->tv) < 0)) {
+      child++;
+    }
+
+    if (_nas_timer_cmp (&te->tv, &NAS_TIMER_ENTRY (_nas_timer_db.heap[child])->tv) <= 0) {
+      break;
+    }
+
+    _nas_timer_db_heap_set (pos, _nas_timer_db.heap[child]);
+    pos = child;
+  }
+
+  _nas_timer_db_heap_set (pos, index);
 }
 
 /****************************************************************************
  **                                                                        **
  ** Name:    _nas_timer_db_insert_entry()                              **
  **                                                                        **
- ** Description: Inserts the entry with the given identifier into the      **
- **      queue of active timer entries and restarts the system     **
- **      timer if the new entry is the next entry for which the    **
- **      timer should be scheduled to expire.                      **
+ ** Description: Inserts the entry into the queue of active timer entries  **
+ **      and restarts the system timer if the new entry is the     **
+ **      next entry for which the timer should be scheduled to     **
+ **      expire.                                                   **
  **                                                                        **
- ** Inputs:  id:        Identifier of the new entry                **
- **      te:        Pointer to the entry to be inserted        **
+ ** Inputs:  index:     Index of the entry to be inserted          **
  **      Others:    None                                       **
  **                                                                        **
  ** Outputs:     None                                                      **
- **      Return:    None                                       **
+ **      Return:    TRUE if the timer handler has to be run    **
+ **             once the database is unlocked              **
  **      Others:    _nas_timer_db                              **
  **                                                                        **
  ***************************************************************************/
-static void
+static int
 _nas_timer_db_insert_entry (
-  int id,
-  nas_timer_entry_t * te)
+  uint32_t index)
 {
-  struct itimerval                        it;
+  nas_timer_entry_t                      *te = NAS_TIMER_ENTRY (index);
   struct timespec                         ts;
   struct timeval                          current_time;
-  int                                     restart;
 
-  /*
-   * Enqueue the new timer entry
-   */
-  _nas_timer_db.tq[id].id = id;
-  _nas_timer_db.tq[id].entry = te;
-  /*
-   * Save its interval timer value
-   */
-  it.it_interval.tv_sec = it.it_interval.tv_usec = 0;
-  it.it_value = te->tv;
   /*
    * Update its interval timer value
    */
@@ -731,231 +940,139 @@ _nas_timer_db_insert_entry (
    * tv = tv + time()
    */
   _nas_timer_add (&te->tv, &current_time, &te->tv);
-  /*
-   * Insert the new timer entry into the list of active entries
-   */
-  nas_timer_lock_db ();
-  restart = _nas_timer_db_insert (&_nas_timer_db.tq[id]);
-  nas_timer_unlock_db ();
-#if ENABLE_ITTI == 0
-
-  if (restart) {
-    /*
-     * The new entry is the first entry of the list;
-     * * * * restart the system timer
-     */
-    setitimer (ITIMER_REAL, &it, 0);
-  }
-#else
-  (void)(restart);
-#endif
-}
 
-static int
-_nas_timer_db_insert (
-  timer_queue_t * entry)
-{
-  timer_queue_t                          *prev,
-                                         *next; /* previous and next entry in the list  */
+  if (_nas_timer_db.heap_size == _nas_timer_db.heap_capacity) {
+    uint32_t                                capacity = _nas_timer_db.heap_capacity ? 2 * _nas_timer_db.heap_capacity : NAS_TIMER_CHUNK_SIZE;
+    uint32_t                               *heap = realloc (_nas_timer_db.heap, capacity * sizeof (uint32_t));
 
-  /*
-   * Search the list of timer entries for the first entry with an interval
-   * timer value greater than the interval timer value of the new timer entry
-   */
-  for (prev = NULL, next = _nas_timer_db.head; next ; next = next->next) {
-    if (_nas_timer_cmp (&next->entry->tv, &entry->entry->tv) > 0) {
-      break;
-    }
-
-    prev = next;
+    assert (heap != NULL);
+    _nas_timer_db.heap = heap;
+    _nas_timer_db.heap_capacity = capacity;
   }
 
   /*
-   * Insert the new entry in the list of active timer entries
-   */
-  /*
-   * prev <-- entry --> next
+   * Insert the new timer entry into the queue of active entries
    */
-  entry->prev = prev;
-  entry->next = next;
+  _nas_timer_db.heap[_nas_timer_db.heap_size] = index;
+  _nas_timer_db_heap_sift_up (_nas_timer_db.heap_size++);
 
-  /*
-   * Update the pointer from the previous entry
-   */
-  if (entry->next ) {
-    /*
-     * prev <-- entry <--> next
-     */
-    entry->next->prev = entry;
-  }
-
-  /*
-   * Update the pointer from the next entry
-   */
-  if (entry->prev ) {
+  if (te->heap_pos == 0) {
     /*
-     * prev <--> entry <--> next
-     */
-    entry->prev->next = entry;
-  } else {
-    /*
-     * The new entry is the first entry of the list
+     * The new entry is the first entry of the queue;
+     * * * * restart the system timer
      */
-    _nas_timer_db.head = entry;
-    return true;
+    return (_nas_timer_db_restart_system_timer ());
   }
 
-  /*
-   * The new entry is NOT the first entry of the list
-   */
-  return false;
+  return (false);
 }
 
 /****************************************************************************
  **                                                                        **
  ** Name:    _nas_timer_db_remove_entry()                              **
  **                                                                        **
- ** Description: Removes the entry with the given identifier from the      **
- **      queue of active timer entries and restarts the system     **
- **      timer if the entry was the next entry for which the timer **
- **      was scheduled to expire.                                  **
+ ** Description: Removes the entry from the queue of active timer entries  **
+ **      and restarts the system timer if the entry was the next   **
+ **      entry for which the timer was scheduled to expire.        **
  **                                                                        **
- ** Inputs:  id:        Identifier of the entry to be removed      **
+ ** Inputs:  te:        Pointer to the entry to be removed         **
  **      Others:    None                                       **
  **                                                                        **
  ** Outputs:     None                                                      **
- **      Return:    A pointer to the removed entry             **
+ **      Return:    TRUE if the timer handler has to be run    **
+ **             once the database is unlocked              **
  **      Others:    _nas_timer_db                              **
  **                                                                        **
  ***************************************************************************/
-static nas_timer_entry_t               *
+static int
 _nas_timer_db_remove_entry (
-  int id)
+  nas_timer_entry_t * te)
 {
-  int                                     restart;
+  uint32_t                                pos = te->heap_pos;
 
-  /*
-   * The identifier of the timer is valid within the timer queue
-   */
-  assert (_nas_timer_db.tq[id].id == id);
-  /*
-   * Remove the timer entry from the list of active entries
-   */
-  nas_timer_lock_db ();
-  restart = _nas_timer_db_remove (&_nas_timer_db.tq[id]);
-  nas_timer_unlock_db ();
+  if (pos == NAS_TIMER_NIL) {
+    return (false);
+  }
 
-  if (restart) {
-    int                                     rc;
+  te->heap_pos = NAS_TIMER_NIL;
+  _nas_timer_db.heap_size--;
 
+  if (pos < _nas_timer_db.heap_size) {
     /*
-     * The entry was the first entry of the list;
-     * * * * the system timer needs to be restarted
+     * Move the last entry to the hole and restore the heap order
      */
-    struct itimerval                        it;
-    struct timeval                          tv;
-    struct timespec                         ts;
-
-    it.it_interval.tv_sec = it.it_interval.tv_usec = 0;
-    clock_gettime (CLOCK_MONOTONIC, &ts);
-    tv.tv_sec = ts.tv_sec;
-    tv.tv_usec = ts.tv_nsec / 1000;
+    _nas_timer_db_heap_set (pos, _nas_timer_db.heap[_nas_timer_db.heap_size]);
+    _nas_timer_db_heap_sift_up (pos);
+    _nas_timer_db_heap_sift_down (pos);
+  }
+
+  if (pos == 0) {
     /*
-     * tv = tv - time()
+     * The entry was the first entry of the queue;
+     * * * * the system timer needs to be restarted
      */
-    rc = _nas_timer_sub (&_nas_timer_db.head->entry->tv, &tv, &it.it_value);
-#if ENABLE_ITTI
-    timer_remove (_nas_timer_db.head->entry->timer_id);
-    (void)(rc);
-#else
-
-    if (rc < 0) {
-      /*
-       * The system timer should have already expired
-       */
-      _nas_timer_handler (SIGALRM);
-    } else {
-      /*
-       * Restart the system timer
-       */
-      setitimer (ITIMER_REAL, &it, 0);
-    }
-
-#endif
+    return (_nas_timer_db_restart_system_timer ());
   }
 
-  /*
-   * Return a pointer to the removed entry
-   */
-  return (_nas_timer_db.tq[id].entry);
+  return (false);
 }
 
+/****************************************************************************
+ **                                                                        **
+ ** Name:    _nas_timer_db_restart_system_timer()                      **
+ **                                                                        **
+ ** Description: Schedules the system timer to the expiration time of the  **
+ **      first entry of the queue of active timer entries, or      **
+ **      stops it if there is no more active timer entry.          **
+ **                                                                        **
+ ** Inputs:  None                                                      **
+ **      Others:    _nas_timer_db                              **
+ **                                                                        **
+ ** Outputs:     None                                                      **
+ **      Return:    TRUE if the first entry already expired    **
+ **      Others:    None                                       **
+ **                                                                        **
+ ***************************************************************************/
 static int
-_nas_timer_db_remove (
-  timer_queue_t * entry)
+_nas_timer_db_restart_system_timer (
+  void)
 {
-  /*
-   * Update the pointer from the previous entry
-   */
-  /*
-   * prev ---> entry ---> next
-   */
-  /*
-   * prev <--- entry <--- next
-   */
-  if (entry->next ) {
-    /*
-     * prev ---> entry ---> next
-     */
+  struct itimerval                        it;
+  struct timeval                          tv;
+  struct timespec                         ts;
+
+  it.it_interval.tv_sec = it.it_interval.tv_usec = 0;
+  it.it_value.tv_sec = it.it_value.tv_usec = 0;
+
+  if (_nas_timer_db.heap_size == 0) {
     /*
-     * prev <-------------- next
+     * No more timer is scheduled to expire; stop the system timer
      */
-    entry->next->prev = entry->prev;
+    setitimer (ITIMER_REAL, &it, 0);
+    return (false);
   }
 
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  tv.tv_sec = ts.tv_sec;
+  tv.tv_usec = ts.tv_nsec / 1000;
+
   /*
-   * Update the pointer from the next entry
+   * tv = tv - time()
    */
-  if (entry->prev ) {
-    /*
-     * prev --------------> next
-     */
+  if (_nas_timer_sub (&NAS_TIMER_ENTRY (_nas_timer_db.heap[0])->tv, &tv, &it.it_value) < 0) {
     /*
-     * prev <-------------- next
+     * The system timer should have already expired
      */
-    entry->prev->next = entry->next;
-  } else {
-    /*
-     * The entry was the first entry of the list
-     */
-    _nas_timer_db.head = entry->next;
-
-    if (_nas_timer_db.head ) {
-      /*
-       * Other timers are scheduled to expire
-       */
-      return true;
-    }
-#if ENABLE_ITTI == 0
-    {
-      /*
-       * No more timer is scheduled to expire; stop the system timer
-       */
-      struct itimerval                        it;
-
-      it.it_interval.tv_sec = it.it_interval.tv_usec = 0;
-      it.it_value.tv_sec = it.it_value.tv_usec = 0;
-      setitimer (ITIMER_REAL, &it, 0);
-      return false;
-    }
-#endif
+    return (true);
   }
 
   /*
-   * The entry was NOT the first entry of the list
+   * Restart the system timer
    */
-  return false;
+  setitimer (ITIMER_REAL, &it, 0);
+  return (false);
 }
+#endif
 
 /*
    -----------------------------------------------------------------------------
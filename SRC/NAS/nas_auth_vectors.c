@@ -0,0 +1,361 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file nas_auth_vectors.c
+  \brief Per IMSI cache of the E-UTRAN authentication vectors prefetched from the HSS
+
+  The MME requests AUTH_VECTORS_PER_REQUEST vectors by AIR. The first one is
+  used at once by the authentication procedure of the UE, the others are kept
+  per IMSI, in the order of their SQN, for AUTH_VECTORS_TTL seconds, detach of
+  the UE included. The next authentication of the UE takes the oldest one
+  without S6A round trip, and the vectors are refilled by an AIR sent in the
+  background when the cache of the IMSI runs low.
+  A vector served from the cache is sent by NAS to itself in an
+  S6A_AUTH_INFO_ANS, so that the authentication procedure is continued the
+  same way as with a vector from the HSS, after the current procedure returns.
+  Only one AIR per IMSI is pending at a time, except for a re-synchronization,
+  which discards the vectors of the IMSI and the answer of a pending refill.
+  The cache is only accessed by the NAS task.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "bstrlib.h"
+#include "log.h"
+#include "msc.h"
+#include "assertions.h"
+#include "conversions.h"
+#include "intertask_interface.h"
+#include "hashtable.h"
+#include "nas_timer.h"
+#include "nas_itti_messaging.h"
+#include "nas_proc.h"
+#include "emmData.h"
+#include "nas_auth_vectors.h"
+
+typedef struct nas_auth_vectors_entry_s {
+  /* Vectors in SQN order, from first */
+  eutran_vector_t    vectors[MAX_EPS_AUTH_VECTORS_PREFETCH];
+  time_t             received_at[MAX_EPS_AUTH_VECTORS_PREFETCH];
+  uint8_t            first;
+  uint8_t            nb_vectors;
+  /* AIR sent and not answered yet */
+  uint8_t            nb_air_pending;
+  /* Answers of the pending AIR to be discarded, sent before a re-synchronization */
+  uint8_t            nb_answers_to_discard;
+  /* UE waiting for the answer of the pending AIR, INVALID_MME_UE_S1AP_ID if none */
+  mme_ue_s1ap_id_t   waiting_ue_id;
+  plmn_t             visited_plmn;
+} nas_auth_vectors_entry_t;
+
+static struct {
+  hash_table_t                           *entries;      /* key is imsi64, data is nas_auth_vectors_entry_t */
+  uint8_t                                 nb_per_request;
+  uint32_t                                ttl_sec;
+  int                                     sweep_timer_id;
+  nas_auth_vectors_statistics_t           statistics;
+} _nas_auth_vectors = {0};
+
+//------------------------------------------------------------------------------
+static time_t _nas_auth_vectors_now (void)
+{
+  struct timespec                         ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec;
+}
+
+//------------------------------------------------------------------------------
+/* Discards the expired vectors, the oldest are first */
+static void _nas_auth_vectors_expire (nas_auth_vectors_entry_t * const entry, const time_t now)
+{
+  while ((entry->nb_vectors > 0) && (now - entry->received_at[entry->first] >= _nas_auth_vectors.ttl_sec)) {
+    entry->first = (entry->first + 1) % MAX_EPS_AUTH_VECTORS_PREFETCH;
+    entry->nb_vectors--;
+  }
+}
+
+//------------------------------------------------------------------------------
+static void _nas_auth_vectors_push (nas_auth_vectors_entry_t * const entry, const eutran_vector_t * const vector, const time_t now)
+{
+  uint8_t                                 index;
+
+  if (entry->nb_vectors == MAX_EPS_AUTH_VECTORS_PREFETCH) {
+    /*
+     * Should not happen as refills are bounded, the oldest vector is dropped
+     */
+    entry->first = (entry->first + 1) % MAX_EPS_AUTH_VECTORS_PREFETCH;
+    entry->nb_vectors--;
+  }
+
+  index = (entry->first + entry->nb_vectors) % MAX_EPS_AUTH_VECTORS_PREFETCH;
+  entry->vectors[index] = *vector;
+  entry->received_at[index] = now;
+  entry->nb_vectors++;
+}
+
+//------------------------------------------------------------------------------
+static void _nas_auth_vectors_pop (nas_auth_vectors_entry_t * const entry, eutran_vector_t * const vector)
+{
+  *vector = entry->vectors[entry->first];
+  entry->first = (entry->first + 1) % MAX_EPS_AUTH_VECTORS_PREFETCH;
+  entry->nb_vectors--;
+}
+
+//------------------------------------------------------------------------------
+static void _nas_auth_vectors_send_air (
+  const mme_ue_s1ap_id_t ue_id,
+  const imsi64_t imsi64,
+  nas_auth_vectors_entry_t * const entry,
+  const bool is_initial_req,
+  const_bstring const auts)
+{
+  uint8_t                                 nb_vectors = _nas_auth_vectors.nb_per_request;
+
+  if (nb_vectors > MAX_EPS_AUTH_VECTORS_PREFETCH - entry->nb_vectors) {
+    nb_vectors = MAX_EPS_AUTH_VECTORS_PREFETCH - entry->nb_vectors;
+  }
+
+  entry->nb_air_pending++;
+  _nas_auth_vectors.statistics.nb_air++;
+  nas_itti_auth_info_req (ue_id, imsi64, is_initial_req, &entry->visited_plmn, nb_vectors, auts);
+}
+
+//------------------------------------------------------------------------------
+/* Continues the authentication of the UE with a vector, after the current procedure */
+static void _nas_auth_vectors_give (const imsi64_t imsi64, const eutran_vector_t * const vector)
+{
+  MessageDef                             *message_p = NULL;
+  s6a_auth_info_ans_t                    *aia = NULL;
+
+  message_p = itti_alloc_new_message (TASK_NAS_MME, S6A_AUTH_INFO_ANS);
+  aia = &message_p->ittiMsg.s6a_auth_info_ans;
+  memset (aia, 0, sizeof (s6a_auth_info_ans_t));
+  aia->imsi_length = snprintf (aia->imsi, IMSI_BCD_DIGITS_MAX + 1, IMSI_64_FMT, imsi64);
+  aia->result.present = S6A_RESULT_BASE;
+  aia->result.choice.base = DIAMETER_SUCCESS;
+  aia->auth_info.nb_of_vectors = 1;
+  aia->auth_info.eutran_vector[0] = *vector;
+  itti_send_msg_to_task (TASK_NAS_MME, INSTANCE_DEFAULT, message_p);
+}
+
+//------------------------------------------------------------------------------
+static bool _nas_auth_vectors_is_expired (
+  const hash_key_t key,
+  void *data,
+  void *parameter,
+  void **result)
+{
+  nas_auth_vectors_entry_t               *entry = (nas_auth_vectors_entry_t *) data;
+  hash_key_t                            **expired_keys = (hash_key_t **) result;
+
+  _nas_auth_vectors_expire (entry, *(time_t *) parameter);
+
+  if ((entry->nb_vectors == 0) && (entry->nb_air_pending == 0)) {
+    *(*expired_keys)++ = key;
+  }
+
+  return false;
+}
+
+//------------------------------------------------------------------------------
+/* Periodic removal of the IMSIs without vector left */
+static void *_nas_auth_vectors_sweep (void *args)
+{
+  hash_key_t                             *expired_keys = NULL;
+  hash_key_t                             *last_key = NULL;
+  time_t                                  now = _nas_auth_vectors_now ();
+
+  if (_nas_auth_vectors.entries->num_elements > 0) {
+    expired_keys = calloc (_nas_auth_vectors.entries->num_elements, sizeof (hash_key_t));
+    if (expired_keys) {
+      last_key = expired_keys;
+      hashtable_apply_callback_on_elements (_nas_auth_vectors.entries, _nas_auth_vectors_is_expired, &now, (void **)&last_key);
+      for (hash_key_t * key = expired_keys; key < last_key; key++) {
+        hashtable_free (_nas_auth_vectors.entries, *key);
+      }
+      OAILOG_DEBUG (LOG_NAS, "Authentication vectors: %ld IMSIs expired, %zu left\n",
+          (long)(last_key - expired_keys), _nas_auth_vectors.entries->num_elements);
+      free (expired_keys);
+    }
+  }
+
+  nas_timer_restart (_nas_auth_vectors.sweep_timer_id);
+  return NULL;
+}
+
+//------------------------------------------------------------------------------
+void nas_auth_vectors_initialize (const mme_config_t * mme_config_p)
+{
+  bstring                                 b = bfromcstr ("nas_auth_vectors");
+
+  _nas_auth_vectors.nb_per_request = mme_config_p->nas_config.auth_vectors_per_request;
+  _nas_auth_vectors.ttl_sec = mme_config_p->nas_config.auth_vectors_ttl_sec;
+  _nas_auth_vectors.entries = hashtable_create (mme_config_p->max_ues, NULL, NULL, b);
+  _nas_auth_vectors.entries->log_enabled = false;
+  _nas_auth_vectors.sweep_timer_id = NAS_TIMER_INACTIVE_ID;
+  bdestroy (b);
+}
+
+//------------------------------------------------------------------------------
+void nas_auth_vectors_cleanup (void)
+{
+  if (_nas_auth_vectors.sweep_timer_id != NAS_TIMER_INACTIVE_ID) {
+    _nas_auth_vectors.sweep_timer_id = nas_timer_stop (_nas_auth_vectors.sweep_timer_id);
+  }
+  hashtable_destroy (_nas_auth_vectors.entries);
+  _nas_auth_vectors.entries = NULL;
+}
+
+//------------------------------------------------------------------------------
+void nas_auth_vectors_request (
+  const mme_ue_s1ap_id_t ue_id,
+  const imsi64_t         imsi64,
+  const bool             is_initial_req,
+  plmn_t         * const visited_plmn,
+  const_bstring    const auts)
+{
+  nas_auth_vectors_entry_t               *entry = NULL;
+  eutran_vector_t                         vector;
+  time_t                                  now = _nas_auth_vectors_now ();
+
+  OAILOG_FUNC_IN (LOG_NAS);
+  _nas_auth_vectors.statistics.nb_requests++;
+
+  if (hashtable_get (_nas_auth_vectors.entries, (const hash_key_t)imsi64, (void **)&entry) != HASH_TABLE_OK) {
+    entry = calloc (1, sizeof (nas_auth_vectors_entry_t));
+    DevAssert (entry != NULL);
+    hashtable_insert (_nas_auth_vectors.entries, (const hash_key_t)imsi64, entry);
+
+    if (_nas_auth_vectors.sweep_timer_id == NAS_TIMER_INACTIVE_ID) {
+      _nas_auth_vectors.sweep_timer_id = nas_timer_start (_nas_auth_vectors.ttl_sec ? _nas_auth_vectors.ttl_sec : 1,
+          _nas_auth_vectors_sweep, NULL);
+    }
+  }
+
+  entry->visited_plmn = *visited_plmn;
+  _nas_auth_vectors_expire (entry, now);
+
+  if (auts) {
+    /*
+     * The SQN of the UE is out of the range of the HSS, the cached vectors are useless
+     */
+    OAILOG_DEBUG (LOG_NAS, "Authentication vectors: IMSI " IMSI_64_FMT " re-synchronization, %u vectors discarded\n",
+        imsi64, entry->nb_vectors);
+    entry->nb_vectors = 0;
+    entry->nb_answers_to_discard = entry->nb_air_pending;
+    entry->waiting_ue_id = ue_id;
+    _nas_auth_vectors_send_air (ue_id, imsi64, entry, is_initial_req, auts);
+    OAILOG_FUNC_OUT (LOG_NAS);
+  }
+
+  if (entry->nb_vectors > 0) {
+    _nas_auth_vectors.statistics.nb_hits++;
+    _nas_auth_vectors_pop (entry, &vector);
+    OAILOG_DEBUG (LOG_NAS, "Authentication vectors: IMSI " IMSI_64_FMT " vector from cache, %u left\n", imsi64, entry->nb_vectors);
+    _nas_auth_vectors_give (imsi64, &vector);
+
+    if ((2 * entry->nb_vectors < _nas_auth_vectors.nb_per_request) && (entry->nb_air_pending == 0)) {
+      _nas_auth_vectors_send_air (ue_id, imsi64, entry, true, NULL);
+    }
+    OAILOG_FUNC_OUT (LOG_NAS);
+  }
+
+  /*
+   * Served by the answer of the pending AIR if any
+   */
+  entry->waiting_ue_id = ue_id;
+  if (entry->nb_air_pending == 0) {
+    _nas_auth_vectors_send_air (ue_id, imsi64, entry, is_initial_req, NULL);
+  }
+  OAILOG_FUNC_OUT (LOG_NAS);
+}
+
+//------------------------------------------------------------------------------
+int nas_auth_vectors_answer (const s6a_auth_info_ans_t * const aia)
+{
+  nas_auth_vectors_entry_t               *entry = NULL;
+  s6a_auth_info_ans_t                     ue_aia;
+  imsi64_t                                imsi64 = INVALID_IMSI64;
+  time_t                                  now = _nas_auth_vectors_now ();
+  int                                     rc = RETURNok;
+
+  OAILOG_FUNC_IN (LOG_NAS);
+  IMSI_STRING_TO_IMSI64 ((char *)aia->imsi, &imsi64);
+
+  if ((hashtable_get (_nas_auth_vectors.entries, (const hash_key_t)imsi64, (void **)&entry) != HASH_TABLE_OK)
+      || (entry->nb_air_pending == 0)) {
+    /*
+     * Not requested through the cache, the UE uses only the first vector
+     */
+    memcpy (&ue_aia, aia, sizeof (ue_aia));
+    if (ue_aia.auth_info.nb_of_vectors > MAX_EPS_AUTH_VECTORS) {
+      ue_aia.auth_info.nb_of_vectors = MAX_EPS_AUTH_VECTORS;
+    }
+    rc = nas_proc_authentication_info_answer (&ue_aia);
+    OAILOG_FUNC_RETURN (LOG_NAS, rc);
+  }
+
+  entry->nb_air_pending--;
+
+  if (entry->nb_answers_to_discard > 0) {
+    entry->nb_answers_to_discard--;
+    OAILOG_DEBUG (LOG_NAS, "Authentication vectors: IMSI " IMSI_64_FMT " answer sent before re-synchronization discarded\n", imsi64);
+    OAILOG_FUNC_RETURN (LOG_NAS, RETURNok);
+  }
+
+  if ((aia->result.present == S6A_RESULT_BASE) && (aia->result.choice.base == DIAMETER_SUCCESS)) {
+    for (int i = 0; i < aia->auth_info.nb_of_vectors; i++) {
+      _nas_auth_vectors_push (entry, &aia->auth_info.eutran_vector[i], now);
+    }
+
+    if ((entry->waiting_ue_id != INVALID_MME_UE_S1AP_ID) && (entry->nb_vectors > 0)
+        && (emm_data_context_get_by_imsi (&_emm_data, imsi64))) {
+      /*
+       * The UE is still there, it gets the oldest vector
+       */
+      memcpy (&ue_aia, aia, sizeof (ue_aia));
+      _nas_auth_vectors_pop (entry, &ue_aia.auth_info.eutran_vector[0]);
+      ue_aia.auth_info.nb_of_vectors = 1;
+      rc = nas_proc_authentication_info_answer (&ue_aia);
+    }
+  } else if ((entry->waiting_ue_id != INVALID_MME_UE_S1AP_ID) && (emm_data_context_get_by_imsi (&_emm_data, imsi64))) {
+    rc = nas_proc_authentication_info_answer ((s6a_auth_info_ans_t *) aia);
+  } else {
+    OAILOG_WARNING (LOG_NAS, "Authentication vectors: IMSI " IMSI_64_FMT " refill failed\n", imsi64);
+  }
+
+  entry->waiting_ue_id = INVALID_MME_UE_S1AP_ID;
+  OAILOG_FUNC_RETURN (LOG_NAS, rc);
+}
+
+//------------------------------------------------------------------------------
+void nas_auth_vectors_get_statistics (nas_auth_vectors_statistics_t * const statistics)
+{
+  /*
+   * Read from the MME_APP task, the counters are reset while NAS updates them
+   */
+  statistics->nb_requests = __sync_fetch_and_and (&_nas_auth_vectors.statistics.nb_requests, 0);
+  statistics->nb_hits = __sync_fetch_and_and (&_nas_auth_vectors.statistics.nb_hits, 0);
+  statistics->nb_air = __sync_fetch_and_and (&_nas_auth_vectors.statistics.nb_air, 0);
+}
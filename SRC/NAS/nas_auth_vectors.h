@@ -0,0 +1,64 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file nas_auth_vectors.h
+  \brief Per IMSI cache of the E-UTRAN authentication vectors prefetched from the HSS
+*/
+
+#ifndef FILE_NAS_AUTH_VECTORS_SEEN
+#define FILE_NAS_AUTH_VECTORS_SEEN
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "bstrlib.h"
+#include "common_types.h"
+#include "mme_config.h"
+#include "s6a_messages_types.h"
+
+/* Counters since the previous call of nas_auth_vectors_get_statistics() */
+typedef struct nas_auth_vectors_statistics_s {
+  uint32_t nb_requests;  /* Vectors needed by authentication procedures */
+  uint32_t nb_hits;      /* Vectors served from the cache                */
+  uint32_t nb_air;       /* S6A AIR sent, refills included               */
+} nas_auth_vectors_statistics_t;
+
+void nas_auth_vectors_initialize(const mme_config_t * mme_config_p);
+
+void nas_auth_vectors_cleanup(void);
+
+/* Gets a vector for the authentication of the UE, instead of nas_itti_auth_info_req().
+ * It is given to NAS by an S6A_AUTH_INFO_ANS, from the cache or from the HSS.
+ * A re-synchronization (auts != NULL) discards the vectors of the IMSI.
+ */
+void nas_auth_vectors_request(
+  const mme_ue_s1ap_id_t ue_id,
+  const imsi64_t         imsi64,
+  const bool             is_initial_req,
+  plmn_t         * const visited_plmn,
+  const_bstring    const auts);
+
+/* Handles an S6A_AUTH_INFO_ANS received from S6A */
+int nas_auth_vectors_answer(const s6a_auth_info_ans_t * const aia);
+
+void nas_auth_vectors_get_statistics(nas_auth_vectors_statistics_t * const statistics);
+
+#endif /* FILE_NAS_AUTH_VECTORS_SEEN */
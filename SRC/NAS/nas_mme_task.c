@@ -34,6 +34,7 @@
 #include "nas_proc.h"
 #include "emm_main.h"
 #include "nas_timer.h"
+#include "nas_auth_vectors.h"
 
 static void nas_exit(void);
 
@@ -81,10 +82,14 @@ static void *nas_intertask_interface (void *args_p)
 
     case S6A_AUTH_INFO_ANS:{
         /*
-         * We received the authentication vectors from HSS, trigger a ULR
-         * for now. Normaly should trigger an authentication procedure with UE.
+         * Vectors from HSS go through the cache, the ones from the cache are
+         * sent by NAS to itself.
          */
-        nas_proc_authentication_info_answer (&S6A_AUTH_INFO_ANS(received_message_p));
+        if (ITTI_MSG_ORIGIN_ID (received_message_p) == TASK_S6A) {
+          nas_auth_vectors_answer (&S6A_AUTH_INFO_ANS(received_message_p));
+        } else {
+          nas_proc_authentication_info_answer (&S6A_AUTH_INFO_ANS(received_message_p));
+        }
       }
       break;
 
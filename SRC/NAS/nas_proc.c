@@ -48,6 +48,7 @@
 #include "esm_sap.h"
 #include "msc.h"
 #include "s6a_defs.h"
+#include "nas_auth_vectors.h"
 
 /****************************************************************************/
 /****************  E X T E R N A L    D E F I N I T I O N S  ****************/
@@ -90,6 +91,10 @@ nas_proc_initialize (
    * Initialize the ESM procedure manager
    */
   esm_main_initialize ();
+  /*
+   * Initialize the cache of authentication vectors
+   */
+  nas_auth_vectors_initialize (mme_config_p);
   OAILOG_FUNC_OUT (LOG_NAS_EMM);
 }
 
@@ -121,6 +126,7 @@ nas_proc_cleanup (
    * Perform the EPS Session Manager's clean up procedure
    */
   esm_main_cleanup ();
+  nas_auth_vectors_cleanup ();
   OAILOG_FUNC_OUT (LOG_NAS_EMM);
 }
 
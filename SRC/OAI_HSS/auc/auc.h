@@ -19,6 +19,7 @@
  *      contact@openairinterface.org
  */
 
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <unistd.h>
@@ -37,6 +38,7 @@
 #define AUTN_LENGTH_OCTETS  (16)
 #define KASME_LENGTH_OCTETS (32)
 #define MAC_S_LENGTH        (8)
+#define AUTS_LENGTH_OCTETS  (SQN_LENGTH_OCTEST + MAC_S_LENGTH)
 
 extern uint8_t opc[16];
 
@@ -53,8 +55,19 @@ typedef struct {
   uint8_t kasme[32];
 } auc_vector_t;
 
-void RijndaelKeySchedule(const uint8_t const key[16]);
-void RijndaelEncrypt(const uint8_t const in[16], uint8_t out[16]);
+/* Expanded AES-128 key. Built on the caller's stack (or kept with the
+ * subscriber), so the Milenage functions can run concurrently from the
+ * freeDiameter threads.
+ */
+typedef struct rijndael_ctx_s {
+  uint8_t  round_keys[11][16] __attribute__ ((aligned (16))); /* AES-NI */
+  uint32_t ek[44];                                            /* tables */
+  bool     aesni;
+} rijndael_ctx_t;
+
+bool RijndaelInit(bool allow_aesni);
+void RijndaelKeySchedule(rijndael_ctx_t * const ctx, const uint8_t const key[16]);
+void RijndaelEncrypt(const rijndael_ctx_t * const ctx, const uint8_t const in[16], uint8_t out[16]);
 
 /* Sequence number functions */
 struct sqn_ue_s;
@@ -82,6 +95,9 @@ void f2345 ( const uint8_t const kP[16],const uint8_t const k[16], const uint8_t
              uint8_t res[8], uint8_t ck[16], uint8_t ik[16], uint8_t ak[6] );
 void f5star( const uint8_t const kP[16],const uint8_t const k[16], const uint8_t const rand[16],
              uint8_t ak[6] );
+/* f1 and f2345 with a single key schedule, as needed for a vector */
+void f12345( const uint8_t const kP[16],const uint8_t const k[16], const uint8_t const rand[16], const uint8_t const sqn[6], const uint8_t const amf[2],
+             uint8_t mac_a[8], uint8_t res[8], uint8_t ck[16], uint8_t ik[16], uint8_t ak[6] );
 
 void generate_autn(const uint8_t const sqn[6], const uint8_t const ak[6], const uint8_t const amf[2], const uint8_t const mac_a[8], uint8_t autn[16]);
 int generate_vector(const uint8_t const opc[16], uint64_t imsi, uint8_t key[16], uint8_t plmn[3],
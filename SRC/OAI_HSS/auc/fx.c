@@ -25,14 +25,16 @@
 
    A sample implementation of the example 3GPP authentication and
    key agreement functions f1, f1*, f2, f3, f4, f5 and f5*. This is
-   a byte-oriented implementation of the functions, and of the block
-   cipher kernel function Rijndael.
+   a byte-oriented implementation of the functions, the block cipher
+   kernel function Rijndael is table driven or uses AES-NI when the
+   CPU has it (see rijndael.c).
 
-   This has been coded for clarity, not necessarily for efficiency.
+   The functions only use the key schedule built on their stack and
+   can run concurrently from the S6A threads.
 
    The functions f2, f3, f4 and f5 share the same inputs and have
-   been coded together as a single function. f1, f1* and f5* are
-   all coded separately.
+   been coded together as a single function, f12345 adds f1 for the
+   authentication vectors. f1, f1* and f5* are all coded separately.
 
   -----------------------------------------------------------------*/
 
@@ -76,35 +78,40 @@ generate_autn (
 }
 
 /*-------------------------------------------------------------------
-   Algorithm f1
-  -------------------------------------------------------------------
-
-   Computes network authentication code MAC-A from key K, random
-   challenge RAND, sequence number SQN and authentication management
-   field AMF.
-
+   TEMP = E[RAND XOR OPc]K, common to all the functions.
   -----------------------------------------------------------------*/
-void
-f1 (
+static void
+milenage_temp (
+  const rijndael_ctx_t * const ctx,
   const uint8_t const opc[16],
-  const uint8_t const k[16],
   const uint8_t const _rand[16],
-  const uint8_t const sqn[6],
-  const uint8_t const amf[2],
-  uint8_t mac_a[8])
+  uint8_t temp[16])
 {
-  uint8_t                                 temp[16];
-  uint8_t                                 in1[16];
-  uint8_t                                 out1[16];
   uint8_t                                 rijndaelInput[16];
   uint8_t                                 i;
 
-  RijndaelKeySchedule (k);
-
   for (i = 0; i < 16; i++)
     rijndaelInput[i] = _rand[i] ^ opc[i];
 
-  RijndaelEncrypt (rijndaelInput, temp);
+  RijndaelEncrypt (ctx, rijndaelInput, temp);
+}
+
+/*-------------------------------------------------------------------
+   OUT1 = E[TEMP XOR rot(IN1 XOR OPc, r1) XOR c1]K XOR OPc, with
+   IN1 = SQN || AMF || SQN || AMF, r1 = 64 and c1 all zeroes.
+  -----------------------------------------------------------------*/
+static void
+milenage_out1 (
+  const rijndael_ctx_t * const ctx,
+  const uint8_t const opc[16],
+  const uint8_t const temp[16],
+  const uint8_t const sqn[6],
+  const uint8_t const amf[2],
+  uint8_t out1[16])
+{
+  uint8_t                                 in1[16];
+  uint8_t                                 rijndaelInput[16];
+  uint8_t                                 i;
 
   for (i = 0; i < 6; i++) {
     in1[i] = sqn[i];
@@ -129,14 +136,64 @@ f1 (
   for (i = 0; i < 16; i++)
     rijndaelInput[i] ^= temp[i];
 
-  RijndaelEncrypt (rijndaelInput, out1);
+  RijndaelEncrypt (ctx, rijndaelInput, out1);
 
   for (i = 0; i < 16; i++)
     out1[i] ^= opc[i];
+}
+
+/*-------------------------------------------------------------------
+   OUTn = E[rot(TEMP XOR OPc, rn) XOR cn]K XOR OPc for n = 2..5, rn
+   given in bytes, cn all zeroes but its last byte.
+  -----------------------------------------------------------------*/
+static void
+milenage_outn (
+  const rijndael_ctx_t * const ctx,
+  const uint8_t const opc[16],
+  const uint8_t const temp[16],
+  uint8_t rotation,
+  uint8_t constant,
+  uint8_t out[16])
+{
+  uint8_t                                 rijndaelInput[16];
+  uint8_t                                 i;
+
+  for (i = 0; i < 16; i++)
+    rijndaelInput[(i + 16 - rotation) % 16] = temp[i] ^ opc[i];
+
+  rijndaelInput[15] ^= constant;
+  RijndaelEncrypt (ctx, rijndaelInput, out);
+
+  for (i = 0; i < 16; i++)
+    out[i] ^= opc[i];
+}
+
+/*-------------------------------------------------------------------
+   Algorithm f1
+  -------------------------------------------------------------------
 
-  for (i = 0; i < 8; i++)
-    mac_a[i] = out1[i];
+   Computes network authentication code MAC-A from key K, random
+   challenge RAND, sequence number SQN and authentication management
+   field AMF.
 
+  -----------------------------------------------------------------*/
+void
+f1 (
+  const uint8_t const opc[16],
+  const uint8_t const k[16],
+  const uint8_t const _rand[16],
+  const uint8_t const sqn[6],
+  const uint8_t const amf[2],
+  uint8_t mac_a[8])
+{
+  rijndael_ctx_t                          ctx;
+  uint8_t                                 temp[16];
+  uint8_t                                 out1[16];
+
+  RijndaelKeySchedule (&ctx, k);
+  milenage_temp (&ctx, opc, _rand, temp);
+  milenage_out1 (&ctx, opc, temp, sqn, amf, out1);
+  memcpy (mac_a, out1, 8);
   return;
 }                               /* end of function f1 */
 
@@ -148,85 +205,93 @@ f1 (
    confidentiality key CK, integrity key IK and anonymity key AK.
 
   -----------------------------------------------------------------*/
-void
-f2345 (
+static void
+milenage_f2345 (
+  const rijndael_ctx_t * const ctx,
   const uint8_t const opc[16],
-  const uint8_t const k[16],
-  const uint8_t const _rand[16],
+  const uint8_t const temp[16],
   uint8_t res[8],
   uint8_t ck[16],
   uint8_t ik[16],
   uint8_t ak[6])
 {
-  uint8_t                                 temp[16];
   uint8_t                                 out[16];
-  uint8_t                                 rijndaelInput[16];
-  uint8_t                                 i;
-
-  RijndaelKeySchedule (k);
-
-  for (i = 0; i < 16; i++)
-    rijndaelInput[i] = _rand[i] ^ opc[i];
-
-  RijndaelEncrypt (rijndaelInput, temp);
 
   /*
    * To obtain output block OUT2: XOR OPc and TEMP,
    * * * * rotate by r2=0, and XOR on the constant c2 (which *
    * * * * is all zeroes except that the last bit is 1).
    */
-  for (i = 0; i < 16; i++)
-    rijndaelInput[i] = temp[i] ^ opc[i];
-
-  rijndaelInput[15] ^= 1;
-  RijndaelEncrypt (rijndaelInput, out);
-
-  for (i = 0; i < 16; i++)
-    out[i] ^= opc[i];
-
-  for (i = 0; i < 8; i++)
-    res[i] = out[i + 8];
-
-  for (i = 0; i < 6; i++)
-    ak[i] = out[i];
-
+  milenage_outn (ctx, opc, temp, 0, 1, out);
+  memcpy (res, &out[8], 8);
+  memcpy (ak, out, 6);
   /*
    * To obtain output block OUT3: XOR OPc and TEMP,
    * * * * rotate by r3=32, and XOR on the constant c3 (which *
    * * * * is all zeroes except that the next to last bit is 1).
    */
-
-  for (i = 0; i < 16; i++)
-    rijndaelInput[(i + 12) % 16] = temp[i] ^ opc[i];
-
-  rijndaelInput[15] ^= 2;
-  RijndaelEncrypt (rijndaelInput, out);
-
-  for (i = 0; i < 16; i++)
-    out[i] ^= opc[i];
-
-  for (i = 0; i < 16; i++)
-    ck[i] = out[i];
-
+  milenage_outn (ctx, opc, temp, 4, 2, ck);
   /*
    * To obtain output block OUT4: XOR OPc and TEMP,
    * * * * rotate by r4=64, and XOR on the constant c4 (which *
    * * * * is all zeroes except that the 2nd from last bit is 1).
    */
-  for (i = 0; i < 16; i++)
-    rijndaelInput[(i + 8) % 16] = temp[i] ^ opc[i];
+  milenage_outn (ctx, opc, temp, 8, 4, ik);
+}
 
-  rijndaelInput[15] ^= 4;
-  RijndaelEncrypt (rijndaelInput, out);
+void
+f2345 (
+  const uint8_t const opc[16],
+  const uint8_t const k[16],
+  const uint8_t const _rand[16],
+  uint8_t res[8],
+  uint8_t ck[16],
+  uint8_t ik[16],
+  uint8_t ak[6])
+{
+  rijndael_ctx_t                          ctx;
+  uint8_t                                 temp[16];
 
-  for (i = 0; i < 16; i++)
-    out[i] ^= opc[i];
+  RijndaelKeySchedule (&ctx, k);
+  milenage_temp (&ctx, opc, _rand, temp);
+  milenage_f2345 (&ctx, opc, temp, res, ck, ik, ak);
+  return;
+}                               /* end of function f2345 */
 
-  for (i = 0; i < 16; i++)
-    ik[i] = out[i];
+/*-------------------------------------------------------------------
+   Algorithms f1 and f2-f5
+  -------------------------------------------------------------------
 
+   Everything an authentication vector needs from key K, random
+   challenge RAND, sequence number SQN and authentication management
+   field AMF: MAC-A, RES, CK, IK and AK. K is expanded and TEMP
+   computed once for all the functions.
+
+  -----------------------------------------------------------------*/
+void
+f12345 (
+  const uint8_t const opc[16],
+  const uint8_t const k[16],
+  const uint8_t const _rand[16],
+  const uint8_t const sqn[6],
+  const uint8_t const amf[2],
+  uint8_t mac_a[8],
+  uint8_t res[8],
+  uint8_t ck[16],
+  uint8_t ik[16],
+  uint8_t ak[6])
+{
+  rijndael_ctx_t                          ctx;
+  uint8_t                                 temp[16];
+  uint8_t                                 out1[16];
+
+  RijndaelKeySchedule (&ctx, k);
+  milenage_temp (&ctx, opc, _rand, temp);
+  milenage_out1 (&ctx, opc, temp, sqn, amf, out1);
+  memcpy (mac_a, out1, 8);
+  milenage_f2345 (&ctx, opc, temp, res, ck, ik, ak);
   return;
-}                               /* end of function f2345 */
+}                               /* end of function f12345 */
 
 /*-------------------------------------------------------------------
    Algorithm f1
@@ -246,50 +311,14 @@ f1star (
   const uint8_t const amf[2],
   uint8_t mac_s[8])
 {
+  rijndael_ctx_t                          ctx;
   uint8_t                                 temp[16];
-  uint8_t                                 in1[16];
   uint8_t                                 out1[16];
-  uint8_t                                 rijndaelInput[16];
-  uint8_t                                 i;
-
-  RijndaelKeySchedule (k);
-
-  for (i = 0; i < 16; i++)
-    rijndaelInput[i] = _rand[i] ^ opc[i];
-
-  RijndaelEncrypt (rijndaelInput, temp);
-
-  for (i = 0; i < 6; i++) {
-    in1[i] = sqn[i];
-    in1[i + 8] = sqn[i];
-  }
-
-  for (i = 0; i < 2; i++) {
-    in1[i + 6] = amf[i];
-    in1[i + 14] = amf[i];
-  }
-
-  /*
-   * XOR op_c and in1, rotate by r1=64, and XOR
-   * * * * on the constant c1 (which is all zeroes)
-   */
-  for (i = 0; i < 16; i++)
-    rijndaelInput[(i + 8) % 16] = in1[i] ^ opc[i];
-
-  /*
-   * XOR on the value temp computed before
-   */
-  for (i = 0; i < 16; i++)
-    rijndaelInput[i] ^= temp[i];
-
-  RijndaelEncrypt (rijndaelInput, out1);
-
-  for (i = 0; i < 16; i++)
-    out1[i] ^= opc[i];
-
-  for (i = 0; i < 8; i++)
-    mac_s[i] = out1[i + 8];
 
+  RijndaelKeySchedule (&ctx, k);
+  milenage_temp (&ctx, opc, _rand, temp);
+  milenage_out1 (&ctx, opc, temp, sqn, amf, out1);
+  memcpy (mac_s, &out1[8], 8);
   return;
 }                               /* end of function f1star */
 
@@ -308,35 +337,19 @@ f5star (
   const uint8_t const _rand[16],
   uint8_t ak[6])
 {
+  rijndael_ctx_t                          ctx;
   uint8_t                                 temp[16];
   uint8_t                                 out[16];
-  uint8_t                                 rijndaelInput[16];
-  uint8_t                                 i;
-
-  RijndaelKeySchedule (k);
-
-  for (i = 0; i < 16; i++)
-    rijndaelInput[i] = _rand[i] ^ opc[i];
-
-  RijndaelEncrypt (rijndaelInput, temp);
 
+  RijndaelKeySchedule (&ctx, k);
+  milenage_temp (&ctx, opc, _rand, temp);
   /*
    * To obtain output block OUT5: XOR OPc and TEMP,
    * * * * rotate by r5=96, and XOR on the constant c5 (which *
    * * * * is all zeroes except that the 3rd from last bit is 1).
    */
-  for (i = 0; i < 16; i++)
-    rijndaelInput[(i + 4) % 16] = temp[i] ^ opc[i];
-
-  rijndaelInput[15] ^= 8;
-  RijndaelEncrypt (rijndaelInput, out);
-
-  for (i = 0; i < 16; i++)
-    out[i] ^= opc[i];
-
-  for (i = 0; i < 6; i++)
-    ak[i] = out[i];
-
+  milenage_outn (&ctx, opc, temp, 12, 8, out);
+  memcpy (ak, out, 6);
   return;
 }                               /* end of function f5star */
 
@@ -349,11 +362,12 @@ ComputeOPc (
   const uint8_t const opP[16],
   uint8_t opcP[16])
 {
+  rijndael_ctx_t                          ctx;
   uint8_t                                 i;
 
-  RijndaelKeySchedule (kP);
+  RijndaelKeySchedule (&ctx, kP);
   FPRINTF_DEBUG ("Compute opc:\n\tK:\t%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X\n", kP[0], kP[1], kP[2], kP[3], kP[4], kP[5], kP[6], kP[7], kP[8], kP[9], kP[10], kP[11], kP[12], kP[13], kP[14], kP[15]);
-  RijndaelEncrypt (opP, opcP);
+  RijndaelEncrypt (&ctx, opP, opcP);
   FPRINTF_DEBUG ("\tIn:\t%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X\n\tRinj:\t%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X\n",
           opP[0], opP[1], opP[2], opP[3], opP[4], opP[5], opP[6], opP[7],
           opP[8], opP[9], opP[10], opP[11], opP[12], opP[13], opP[14], opP[15], opcP[0], opcP[1], opcP[2], opcP[3], opcP[4], opcP[5], opcP[6], opcP[7], opcP[8], opcP[9], opcP[10], opcP[11], opcP[12], opcP[13], opcP[14], opcP[15]);
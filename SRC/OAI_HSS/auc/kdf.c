@@ -164,16 +164,12 @@ generate_vector (
   }
 
   /*
-   * Compute MAC
+   * Compute MAC, XRES, CK, IK, AK
    */
-  f1 (opc, key, vector->rand, sqn, amf, mac_a);
+  f12345 (opc, key, vector->rand, sqn, amf, mac_a, vector->xres, ck, ik, ak);
   print_buffer ("MAC_A   : ", mac_a, 8);
   print_buffer ("SQN     : ", sqn, 6);
   print_buffer ("RAND    : ", vector->rand, 16);
-  /*
-   * Compute XRES, CK, IK, AK
-   */
-  f2345 (opc, key, vector->rand, vector->xres, ck, ik, ak);
   print_buffer ("AK      : ", ak, 6);
   print_buffer ("CK      : ", ck, 16);
   print_buffer ("IK      : ", ik, 16);
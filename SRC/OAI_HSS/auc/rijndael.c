@@ -19,9 +19,17 @@
  *      contact@openairinterface.org
  */
 
+#include <pthread.h>
+#include <stdbool.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <string.h>
 #include <gmp.h>
+#if defined(__x86_64__) || defined(__i386__)
+#  include <cpuid.h>
+#  include <wmmintrin.h>
+#  define RIJNDAEL_AESNI 1
+#endif
 
 #include "auc.h"
 #include "log.h"
@@ -29,11 +37,11 @@
 typedef uint8_t                         u8;
 typedef uint32_t                        u32;
 
-/*-------------------- Rijndael round subkeys ---------------------*/
-u8                                      roundKeys[11][4][4];
+#define GETU32(pT) (((u32)(pT)[0] << 24) ^ ((u32)(pT)[1] << 16) ^ ((u32)(pT)[2] <<  8) ^ ((u32)(pT)[3]))
+#define PUTU32(cT, sT) { (cT)[0] = (u8)((sT) >> 24); (cT)[1] = (u8)((sT) >> 16); (cT)[2] = (u8)((sT) >>  8); (cT)[3] = (u8)(sT); }
 
 /*--------------------- Rijndael S box table ----------------------*/
-u8                                      S[256] = {
+static const u8                         S[256] = {
   99, 124, 119, 123, 242, 107, 111, 197, 48, 1, 103, 43, 254, 215, 171, 118,
   202, 130, 201, 125, 250, 89, 71, 240, 173, 212, 162, 175, 156, 164, 114, 192,
   183, 253, 147, 38, 54, 63, 247, 204, 52, 165, 229, 241, 113, 216, 49, 21,
@@ -53,7 +61,7 @@ u8                                      S[256] = {
 };
 
 /*------- This array does the multiplication by x in GF(2^8) ------*/
-u8                                      Xtime[256] = {
+static const u8                         Xtime[256] = {
   0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30,
   32, 34, 36, 38, 40, 42, 44, 46, 48, 50, 52, 54, 56, 58, 60, 62,
   64, 66, 68, 70, 72, 74, 76, 78, 80, 82, 84, 86, 88, 90, 92, 94,
@@ -72,203 +80,190 @@ u8                                      Xtime[256] = {
   251, 249, 255, 253, 243, 241, 247, 245, 235, 233, 239, 237, 227, 225, 231, 229
 };
 
+/*------ Round tables: SubBytes, ShiftRows and MixColumns of ------
+  ------ one byte in one lookup, built once from S and Xtime -------*/
+static u32                              Te0[256];
+static u32                              Te1[256];
+static u32                              Te2[256];
+static u32                              Te3[256];
+
+static pthread_once_t                   rijndael_tables_once = PTHREAD_ONCE_INIT;
+static bool                             rijndael_aesni = false;
+
+static bool
+RijndaelCpuHasAesni (
+  void)
+{
+#if RIJNDAEL_AESNI
+  unsigned int                            eax, ebx, ecx, edx;
+
+  if (__get_cpuid (1, &eax, &ebx, &ecx, &edx) && (ecx & bit_AES)) {
+    return true;
+  }
+#endif
+  return false;
+}
+
+static void
+RijndaelInitTables (
+  void)
+{
+  int                                     i;
+  u32                                     t;
+
+  for (i = 0; i < 256; i++) {
+    t = ((u32) Xtime[S[i]] << 24) | ((u32) S[i] << 16) | ((u32) S[i] << 8) | (u32) (Xtime[S[i]] ^ S[i]);
+    Te0[i] = t;
+    Te1[i] = (t >> 8) | (t << 24);
+    Te2[i] = (t >> 16) | (t << 16);
+    Te3[i] = (t >> 24) | (t << 8);
+  }
+
+  rijndael_aesni = RijndaelCpuHasAesni ();
+}
+
+/*-------------------------------------------------------------------
+   Selects the block cipher implementation: AES-NI when the CPU has
+   it and allow_aesni is set, the table driven one otherwise.
+   Optional, the first key schedule selects AES-NI when available.
+   Returns true if AES-NI is used.
+  -----------------------------------------------------------------*/
+bool
+RijndaelInit (
+  bool allow_aesni)
+{
+  pthread_once (&rijndael_tables_once, RijndaelInitTables);
+  rijndael_aesni = allow_aesni && RijndaelCpuHasAesni ();
+  return rijndael_aesni;
+}
+
 /*-------------------------------------------------------------------
    Rijndael key schedule function. Takes 16-byte key and creates
-   all Rijndael's internal subkeys ready for encryption.
+   all Rijndael's internal subkeys ready for encryption in ctx.
   -----------------------------------------------------------------*/
 void
 RijndaelKeySchedule (
+  rijndael_ctx_t * const ctx,
   const u8 const key[16])
 {
-  u8                                      roundConst;
-  int                                     i,
-                                          j;
+  u32                                    *w = ctx->ek;
+  u8                                      roundConst = 1;
+  int                                     i;
 
-  FPRINTF_DEBUG ("RijndaelKeySchedule: K %02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X\n", key[0], key[1], key[2], key[3], key[4], key[5], key[6], key[7], key[8], key[9], key[10], key[11], key[12], key[13], key[14], key[15]);
+  pthread_once (&rijndael_tables_once, RijndaelInitTables);
 
   /*
    * first round key equals key
    */
-  for (i = 0; i < 16; i++)
-    roundKeys[0][i & 0x03][i >> 2] = key[i];
-
-  roundConst = 1;
+  for (i = 0; i < 4; i++)
+    w[i] = GETU32 (&key[4 * i]);
 
   /*
    * now calculate round keys
    */
-  for (i = 1; i < 11; i++) {
-    roundKeys[i][0][0] = S[roundKeys[i - 1][1][3]]
-      ^ roundKeys[i - 1][0][0] ^ roundConst;
-    roundKeys[i][1][0] = S[roundKeys[i - 1][2][3]]
-      ^ roundKeys[i - 1][1][0];
-    roundKeys[i][2][0] = S[roundKeys[i - 1][3][3]]
-      ^ roundKeys[i - 1][2][0];
-    roundKeys[i][3][0] = S[roundKeys[i - 1][0][3]]
-      ^ roundKeys[i - 1][3][0];
-
-    for (j = 0; j < 4; j++) {
-      roundKeys[i][j][1] = roundKeys[i - 1][j][1] ^ roundKeys[i][j][0];
-      roundKeys[i][j][2] = roundKeys[i - 1][j][2] ^ roundKeys[i][j][1];
-      roundKeys[i][j][3] = roundKeys[i - 1][j][3] ^ roundKeys[i][j][2];
-    }
-
+  for (i = 4; i < 44; i += 4) {
+    u32                                     t = w[i - 1];
+
+    w[i] = w[i - 4] ^ ((u32) roundConst << 24) ^
+      ((u32) S[(t >> 16) & 0xff] << 24) ^ ((u32) S[(t >> 8) & 0xff] << 16) ^ ((u32) S[t & 0xff] << 8) ^ (u32) S[t >> 24];
+    w[i + 1] = w[i - 3] ^ w[i];
+    w[i + 2] = w[i - 2] ^ w[i + 1];
+    w[i + 3] = w[i - 1] ^ w[i + 2];
     /*
      * update round constant
      */
     roundConst = Xtime[roundConst];
   }
 
-  return;
-}                               /* end of function RijndaelKeySchedule */
-
-/* Round key addition function */
-void
-KeyAdd (
-  u8 state[4][4],
-  u8 roundKeys[11][4][4],
-  int round)
-{
-  int                                     i,
-                                          j;
-
-  for (i = 0; i < 4; i++)
-    for (j = 0; j < 4; j++)
-      state[i][j] ^= roundKeys[round][i][j];
+  for (i = 0; i < 44; i++)
+    PUTU32 (&ctx->round_keys[i >> 2][4 * (i & 3)], w[i]);
 
+  ctx->aesni = rijndael_aesni;
   return;
-}
-
-/* Byte substitution transformation */
-int
-ByteSub (
-  u8 state[4][4])
-{
-  int                                     i,
-                                          j;
-
-  for (i = 0; i < 4; i++)
-    for (j = 0; j < 4; j++)
-      state[i][j] = S[state[i][j]];
-
-  return 0;
-}
+}                               /* end of function RijndaelKeySchedule */
 
-/* Row shift transformation */
-void
-ShiftRow (
-  u8 state[4][4])
+#if RIJNDAEL_AESNI
+__attribute__ ((target ("aes,sse2")))
+static void
+RijndaelEncryptAesni (
+  const rijndael_ctx_t * const ctx,
+  const u8 const input[16],
+  u8 output[16])
 {
-  u8                                      temp;
-
-  /*
-   * left rotate row 1 by 1
-   */
-  temp = state[1][0];
-  state[1][0] = state[1][1];
-  state[1][1] = state[1][2];
-  state[1][2] = state[1][3];
-  state[1][3] = temp;
-  /*
-   * left rotate row 2 by 2
-   */
-  temp = state[2][0];
-  state[2][0] = state[2][2];
-  state[2][2] = temp;
-  temp = state[2][1];
-  state[2][1] = state[2][3];
-  state[2][3] = temp;
-  /*
-   * left rotate row 3 by 3
-   */
-  temp = state[3][0];
-  state[3][0] = state[3][3];
-  state[3][3] = state[3][2];
-  state[3][2] = state[3][1];
-  state[3][1] = temp;
-  return;
-}
+  __m128i                                 state = _mm_loadu_si128 ((const __m128i *)input);
+  int                                     r;
 
-/* MixColumn transformation*/
-void
-MixColumn (
-  u8 state[4][4])
-{
-  u8                                      temp,
-                                          tmp,
-                                          tmp0;
-  int                                     i;
+  state = _mm_xor_si128 (state, _mm_load_si128 ((const __m128i *)ctx->round_keys[0]));
 
-  /*
-   * do one column at a time
-   */
-  for (i = 0; i < 4; i++) {
-    temp = state[0][i] ^ state[1][i] ^ state[2][i] ^ state[3][i];
-    tmp0 = state[0][i];
-    /*
-     * Xtime array does multiply by x in GF2^8
-     */
-    tmp = Xtime[state[0][i] ^ state[1][i]];
-    state[0][i] ^= temp ^ tmp;
-    tmp = Xtime[state[1][i] ^ state[2][i]];
-    state[1][i] ^= temp ^ tmp;
-    tmp = Xtime[state[2][i] ^ state[3][i]];
-    state[2][i] ^= temp ^ tmp;
-    tmp = Xtime[state[3][i] ^ tmp0];
-    state[3][i] ^= temp ^ tmp;
-  }
+  for (r = 1; r <= 9; r++)
+    state = _mm_aesenc_si128 (state, _mm_load_si128 ((const __m128i *)ctx->round_keys[r]));
 
-  return;
+  state = _mm_aesenclast_si128 (state, _mm_load_si128 ((const __m128i *)ctx->round_keys[10]));
+  _mm_storeu_si128 ((__m128i *)output, state);
 }
+#endif
 
 /*-------------------------------------------------------------------
    Rijndael encryption function. Takes 16-byte input and creates
    16-byte output (using round keys already derived from 16-byte
-   key).
+   key in ctx). Reentrant: ctx is only read.
   -----------------------------------------------------------------*/
 void
 RijndaelEncrypt (
+  const rijndael_ctx_t * const ctx,
   const u8 const input[16],
   u8 output[16])
 {
-  u8                                      state[4][4];
-  int                                     i,
-                                          r;
-
-  /*
-   * initialise state array from input byte string
-   */
-  for (i = 0; i < 16; i++)
-    state[i & 0x3][i >> 2] = input[i];
+  const u32                              *rk = ctx->ek;
+  u32                                     s0, s1, s2, s3;
+  u32                                     t0, t1, t2, t3;
+  int                                     r;
+
+#if RIJNDAEL_AESNI
+  if (ctx->aesni) {
+    RijndaelEncryptAesni (ctx, input, output);
+    return;
+  }
+#endif
 
   /*
-   * add first round_key
+   * initialise state from input byte string and add first round_key
    */
-  KeyAdd (state, roundKeys, 0);
+  s0 = GETU32 (&input[0]) ^ rk[0];
+  s1 = GETU32 (&input[4]) ^ rk[1];
+  s2 = GETU32 (&input[8]) ^ rk[2];
+  s3 = GETU32 (&input[12]) ^ rk[3];
 
   /*
    * do lots of full rounds
    */
   for (r = 1; r <= 9; r++) {
-    ByteSub (state);
-    ShiftRow (state);
-    MixColumn (state);
-    KeyAdd (state, roundKeys, r);
+    rk += 4;
+    t0 = Te0[s0 >> 24] ^ Te1[(s1 >> 16) & 0xff] ^ Te2[(s2 >> 8) & 0xff] ^ Te3[s3 & 0xff] ^ rk[0];
+    t1 = Te0[s1 >> 24] ^ Te1[(s2 >> 16) & 0xff] ^ Te2[(s3 >> 8) & 0xff] ^ Te3[s0 & 0xff] ^ rk[1];
+    t2 = Te0[s2 >> 24] ^ Te1[(s3 >> 16) & 0xff] ^ Te2[(s0 >> 8) & 0xff] ^ Te3[s1 & 0xff] ^ rk[2];
+    t3 = Te0[s3 >> 24] ^ Te1[(s0 >> 16) & 0xff] ^ Te2[(s1 >> 8) & 0xff] ^ Te3[s2 & 0xff] ^ rk[3];
+    s0 = t0;
+    s1 = t1;
+    s2 = t2;
+    s3 = t3;
   }
 
   /*
-   * final round
+   * final round, no MixColumn
    */
-  ByteSub (state);
-  ShiftRow (state);
-  KeyAdd (state, roundKeys, r);
+  rk += 4;
+  t0 = ((u32) S[s0 >> 24] << 24) ^ ((u32) S[(s1 >> 16) & 0xff] << 16) ^ ((u32) S[(s2 >> 8) & 0xff] << 8) ^ (u32) S[s3 & 0xff] ^ rk[0];
+  t1 = ((u32) S[s1 >> 24] << 24) ^ ((u32) S[(s2 >> 16) & 0xff] << 16) ^ ((u32) S[(s3 >> 8) & 0xff] << 8) ^ (u32) S[s0 & 0xff] ^ rk[1];
+  t2 = ((u32) S[s2 >> 24] << 24) ^ ((u32) S[(s3 >> 16) & 0xff] << 16) ^ ((u32) S[(s0 >> 8) & 0xff] << 8) ^ (u32) S[s1 & 0xff] ^ rk[2];
+  t3 = ((u32) S[s3 >> 24] << 24) ^ ((u32) S[(s0 >> 16) & 0xff] << 16) ^ ((u32) S[(s1 >> 8) & 0xff] << 8) ^ (u32) S[s2 & 0xff] ^ rk[3];
 
   /*
-   * produce output byte string from state array
+   * produce output byte string from state
    */
-  for (i = 0; i < 16; i++) {
-    output[i] = state[i & 0x3][i >> 2];
-  }
-
+  PUTU32 (&output[0], t0);
+  PUTU32 (&output[4], t1);
+  PUTU32 (&output[8], t2);
+  PUTU32 (&output[12], t3);
   return;
 }                               /* end of function RijndaelEncrypt */
@@ -0,0 +1,1161 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*
+ * Subscriber cache of the HSS.
+ * The authentication data of the subscribers (key, OPc, SQN, RAND) are loaded
+ * from the database at startup, or on a miss, then the AIR are served from memory.
+ * The key and OPc of a cached subscriber are read again from the database after
+ * DB_CACHE_TTL_SEC, so that provisioning changes (new key, deleted subscriber)
+ * are seen.
+ * The HSS is the only writer of SQN and RAND: an update is done in the cache and
+ * its record is appended to the journal file and synced before the AIA is sent,
+ * concurrent updates sharing one sync. Every DB_CACHE_FLUSH_PERIOD_MS, a
+ * background thread renames the journal (DB_JOURNAL_FLUSHING_SUFFIX), starts a
+ * new one, writes the updated subscribers to the database in one transaction,
+ * then deletes the renamed journal. On restart, the renamed journal then the
+ * current one are replayed into the database.
+ */
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <string.h>
+#include <errno.h>
+#include <libgen.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include <mysql/mysql.h>
+
+#include "hss_config.h"
+#include "db_proto.h"
+#include "log.h"
+
+#define DB_CACHE_MIN_BUCKETS          1024
+#define DB_CACHE_LOCKS                64   /* Buckets share these locks, must be a power of 2 */
+#define DB_CACHE_FLUSH_PERIOD_MS      10
+#define DB_CACHE_RETRY_PERIOD_MS      1000 /* While the database can not be written */
+#define DB_CACHE_TTL_SEC              60
+#define DB_JOURNAL_FLUSHING_SUFFIX    ".flushing"
+
+typedef struct db_cache_entry_s {
+  char                                    imsi[IMSI_LENGTH_MAX + 1];
+  uint8_t                                 key[KEY_LENGTH];
+  uint8_t                                 opc[KEY_LENGTH];
+  uint8_t                                 sqn[SQN_LENGTH];
+  uint8_t                                 rand[RAND_LENGTH];
+
+  /* Monotonic time (s) the key and OPc were read from the database */
+  time_t                                  loaded;
+
+  /* SQN/RAND updated since the last flush, the entry is in the dirty list */
+  bool                                    dirty;
+
+  struct db_cache_entry_s                *next;
+  struct db_cache_entry_s                *next_dirty;
+} db_cache_entry_t;
+
+/* Record of the journal, the SQN and RAND of a subscriber after an update */
+typedef struct db_journal_record_s {
+  char                                    imsi[IMSI_LENGTH_MAX + 1];
+  uint8_t                                 sqn[SQN_LENGTH];
+  uint8_t                                 rand[RAND_LENGTH];
+  uint8_t                                 spare[2];
+  /* Of the previous fields, a record torn by a crash is not replayed */
+  uint32_t                                checksum;
+} db_journal_record_t;
+
+/* An update waiting for its record to be in the journal, on the stack of its AIR thread */
+typedef struct db_journal_waiter_s {
+  db_journal_record_t                     record;
+  int                                     status;
+  bool                                    done;
+  struct db_journal_waiter_s             *next;
+} db_journal_waiter_t;
+
+typedef struct {
+  bool                                    enabled;
+
+  uint32_t                                nb_buckets;
+  db_cache_entry_t                      **buckets;
+  pthread_mutex_t                         locks[DB_CACHE_LOCKS];
+
+  /* Entries to flush, protected by dirty_mutex */
+  pthread_mutex_t                         dirty_mutex;
+  pthread_cond_t                          dirty_cond;
+  db_cache_entry_t                       *dirty_entries;
+  bool                                    stop;
+
+  /* Records to append to the journal, oldest first, protected by journal_mutex */
+  pthread_mutex_t                         journal_mutex;
+  pthread_cond_t                          journal_cond;
+  db_journal_waiter_t                    *journal_head;
+  db_journal_waiter_t                    *journal_tail;
+  bool                                    journal_busy;   /* A thread writes or rotates the journal */
+
+  /* Journal file, owned by the thread which has set journal_busy */
+  char                                   *journal_path;
+  char                                   *flushing_path;
+  char                                   *journal_dir;
+  int                                     journal_fd;
+  off_t                                   journal_size;   /* Of the records written and synced */
+  bool                                    journal_broken; /* Not writable until the next rotation */
+  db_journal_record_t                    *journal_buffer;
+  uint32_t                                journal_buffer_records;
+
+  /* Records not yet in the database, owned by the flush thread */
+  bool                                    flushing;       /* flushing_path exists */
+  db_journal_record_t                    *records;
+  uint32_t                                nb_records;
+  uint32_t                                max_records;
+
+  pthread_t                               flush_thread;
+} db_cache_t;
+
+static db_cache_t                       db_cache = {.journal_fd = -1 };
+
+static uint32_t
+db_cache_hash (
+  const void *data,
+  size_t length)
+{
+  const uint8_t                          *bytes = (const uint8_t *)data;
+  uint32_t                                hash = 2166136261u;   /* FNV-1a */
+
+  while (length--) {
+    hash = (hash ^ *bytes++) * 16777619u;
+  }
+
+  return hash;
+}
+
+static uint32_t
+db_journal_checksum (
+  const db_journal_record_t * record)
+{
+  return db_cache_hash (record, offsetof (db_journal_record_t, checksum));
+}
+
+static time_t
+db_cache_now (
+  void)
+{
+  struct timespec                         now;
+
+  clock_gettime (CLOCK_MONOTONIC, &now);
+  return now.tv_sec;
+}
+
+/*
+ * Lock of the bucket of an IMSI
+ */
+static pthread_mutex_t                 *
+db_cache_lock (
+  uint32_t bucket)
+{
+  return &db_cache.locks[bucket & (DB_CACHE_LOCKS - 1)];
+}
+
+/*
+ * Entry of an IMSI in its bucket, the bucket lock must be held
+ */
+static db_cache_entry_t                *
+db_cache_find (
+  uint32_t bucket,
+  const char *imsi)
+{
+  db_cache_entry_t                       *entry;
+
+  for (entry = db_cache.buckets[bucket]; entry; entry = entry->next) {
+    if (strcmp (entry->imsi, imsi) == 0) {
+      return entry;
+    }
+  }
+
+  return NULL;
+}
+
+/*
+ * Adds a subscriber, returns the entry already cached if any.
+ * The bucket lock must be held.
+ */
+static db_cache_entry_t                *
+db_cache_insert (
+  uint32_t bucket,
+  db_cache_entry_t * new_entry)
+{
+  db_cache_entry_t                       *entry = db_cache_find (bucket, new_entry->imsi);
+
+  if (entry) {
+    free (new_entry);
+    return entry;
+  }
+
+  new_entry->next = db_cache.buckets[bucket];
+  db_cache.buckets[bucket] = new_entry;
+  return new_entry;
+}
+
+/*
+ * Removes and frees a subscriber which is not dirty, the bucket lock must be held
+ */
+static void
+db_cache_remove (
+  uint32_t bucket,
+  db_cache_entry_t * entry)
+{
+  db_cache_entry_t                      **entry_pp;
+
+  for (entry_pp = &db_cache.buckets[bucket]; *entry_pp; entry_pp = &(*entry_pp)->next) {
+    if (*entry_pp == entry) {
+      *entry_pp = entry->next;
+      free (entry);
+      return;
+    }
+  }
+}
+
+/*
+ * Reads again the key and OPc of a cached subscriber, drops it if it has been
+ * deleted from the database. Called and returns with the bucket lock held.
+ * The SQN and RAND are kept, the HSS is their only writer.
+ */
+static db_cache_entry_t                *
+db_cache_refresh (
+  uint32_t bucket,
+  db_cache_entry_t * entry,
+  pthread_mutex_t * lock)
+{
+  mysql_auth_info_req_t                   auth_info_req;
+  mysql_auth_info_resp_t                  auth_info_resp;
+  int                                     ret;
+
+  /*
+   * Other threads keep on using the cached data meanwhile
+   */
+  entry->loaded = db_cache_now ();
+  memcpy (auth_info_req.imsi, entry->imsi, sizeof (entry->imsi));
+  pthread_mutex_unlock (lock);
+  ret = hss_mysql_query_auth_info (&auth_info_req, &auth_info_resp);
+  pthread_mutex_lock (lock);
+
+  if ((entry = db_cache_find (bucket, auth_info_req.imsi)) == NULL) {
+    return NULL;
+  }
+
+  if (ret == 0) {
+    memcpy (entry->key, auth_info_resp.key, KEY_LENGTH);
+    memcpy (entry->opc, auth_info_resp.opc, KEY_LENGTH);
+  } else if ((ret == ENOENT) && !entry->dirty) {
+    FPRINTF_NOTICE ("Subscriber %s removed from the database, dropped from the cache\n", entry->imsi);
+    db_cache_remove (bucket, entry);
+    return NULL;
+  }
+
+  /*
+   * On a database error, the cached data are still used
+   */
+  return entry;
+}
+
+/*
+ * Entry of a subscriber, loaded from the database on a miss.
+ * Returns with the lock of its bucket held, or NULL for an unknown subscriber.
+ */
+static db_cache_entry_t                *
+db_cache_lookup (
+  const char *imsi,
+  pthread_mutex_t ** lock_pp)
+{
+  mysql_auth_info_req_t                   auth_info_req;
+  mysql_auth_info_resp_t                  auth_info_resp;
+  db_cache_entry_t                       *entry;
+  size_t                                  length = strlen (imsi);
+  uint32_t                                bucket;
+
+  if (length > IMSI_LENGTH_MAX) {
+    return NULL;
+  }
+
+  bucket = db_cache_hash (imsi, length) & (db_cache.nb_buckets - 1);
+  *lock_pp = db_cache_lock (bucket);
+  pthread_mutex_lock (*lock_pp);
+
+  if ((entry = db_cache_find (bucket, imsi)) != NULL) {
+    if (db_cache_now () - entry->loaded >= DB_CACHE_TTL_SEC) {
+      entry = db_cache_refresh (bucket, entry, *lock_pp);
+    }
+
+    if (entry == NULL) {
+      pthread_mutex_unlock (*lock_pp);
+    }
+
+    return entry;
+  }
+
+  pthread_mutex_unlock (*lock_pp);
+  /*
+   * Provisioned after the startup
+   */
+  memcpy (auth_info_req.imsi, imsi, length + 1);
+
+  if (hss_mysql_query_auth_info (&auth_info_req, &auth_info_resp) != 0) {
+    return NULL;
+  }
+
+  if ((entry = calloc (1, sizeof (db_cache_entry_t))) == NULL) {
+    return NULL;
+  }
+
+  memcpy (entry->imsi, imsi, length + 1);
+  memcpy (entry->key, auth_info_resp.key, KEY_LENGTH);
+  memcpy (entry->opc, auth_info_resp.opc, KEY_LENGTH);
+  memcpy (entry->sqn, auth_info_resp.sqn, SQN_LENGTH);
+  memcpy (entry->rand, auth_info_resp.rand, RAND_LENGTH);
+  entry->loaded = db_cache_now ();
+  pthread_mutex_lock (*lock_pp);
+  return db_cache_insert (bucket, entry);
+}
+
+/*
+ * Queues an updated entry for the flush thread, the bucket lock must be held
+ */
+static void
+db_cache_set_dirty (
+  db_cache_entry_t * entry)
+{
+  if (entry->dirty) {
+    return;
+  }
+
+  entry->dirty = true;
+  pthread_mutex_lock (&db_cache.dirty_mutex);
+
+  if (db_cache.dirty_entries == NULL) {
+    pthread_cond_signal (&db_cache.dirty_cond);
+  }
+
+  entry->next_dirty = db_cache.dirty_entries;
+  db_cache.dirty_entries = entry;
+  pthread_mutex_unlock (&db_cache.dirty_mutex);
+}
+
+/*
+ * Writes a whole buffer at offset, retrying on short writes
+ */
+static int
+db_journal_pwrite (
+  int fd,
+  const void *buffer,
+  size_t length,
+  off_t offset)
+{
+  const uint8_t                          *bytes = (const uint8_t *)buffer;
+  ssize_t                                 written;
+
+  while (length > 0) {
+    if ((written = pwrite (fd, bytes, length, offset)) < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+
+      return errno;
+    }
+
+    if (written == 0) {
+      return EIO;
+    }
+
+    bytes += written;
+    length -= written;
+    offset += written;
+  }
+
+  return 0;
+}
+
+/*
+ * Writes the records of a batch of waiters at the end of the journal and syncs
+ * it. The journal must be owned (journal_busy).
+ */
+static int
+db_journal_write (
+  db_journal_waiter_t * batch)
+{
+  db_journal_waiter_t                    *waiter;
+  db_journal_record_t                    *buffer;
+  uint32_t                                nb_records = 0;
+  size_t                                  length;
+  int                                     ret;
+
+  if (db_cache.journal_broken) {
+    return EIO;
+  }
+
+  for (waiter = batch; waiter; waiter = waiter->next) {
+    nb_records++;
+  }
+
+  if (nb_records > db_cache.journal_buffer_records) {
+    if ((buffer = realloc (db_cache.journal_buffer, 2 * nb_records * sizeof (db_journal_record_t))) == NULL) {
+      return ENOMEM;
+    }
+
+    db_cache.journal_buffer = buffer;
+    db_cache.journal_buffer_records = 2 * nb_records;
+  }
+
+  nb_records = 0;
+
+  for (waiter = batch; waiter; waiter = waiter->next) {
+    db_cache.journal_buffer[nb_records++] = waiter->record;
+  }
+
+  length = nb_records * sizeof (db_journal_record_t);
+
+  if (((ret = db_journal_pwrite (db_cache.journal_fd, db_cache.journal_buffer, length, db_cache.journal_size)) == 0) && (fdatasync (db_cache.journal_fd) != 0)) {
+    ret = errno;
+  }
+
+  if (ret == 0) {
+    db_cache.journal_size += length;
+    return 0;
+  }
+
+  FPRINTF_ERROR ("Failed to write %u records to SQN journal: %s\n", nb_records, strerror (ret));
+
+  /*
+   * Drop what may have been written of the batch, the next records are
+   * written at the same offset
+   */
+  if (ftruncate (db_cache.journal_fd, db_cache.journal_size) != 0) {
+    FPRINTF_ERROR ("Failed to truncate SQN journal: %s\n", strerror (errno));
+    db_cache.journal_broken = true;
+  }
+
+  return ret;
+}
+
+/*
+ * Appends the record of an updated entry to the journal and waits until it is
+ * synced. The record is queued with the bucket lock held, so that the records
+ * of a subscriber are in the order of its updates, then the lock is released.
+ * The first waiting thread writes the records queued so far with one sync.
+ */
+static int
+db_journal_append (
+  db_cache_entry_t * entry,
+  pthread_mutex_t * lock)
+{
+  db_journal_waiter_t                     waiter;
+  db_journal_waiter_t                    *batch;
+  db_journal_waiter_t                    *next;
+  int                                     status;
+
+  memset (&waiter, 0, sizeof (waiter));
+  memcpy (waiter.record.imsi, entry->imsi, sizeof (waiter.record.imsi));
+  memcpy (waiter.record.sqn, entry->sqn, SQN_LENGTH);
+  memcpy (waiter.record.rand, entry->rand, RAND_LENGTH);
+  waiter.record.checksum = db_journal_checksum (&waiter.record);
+  pthread_mutex_lock (&db_cache.journal_mutex);
+
+  if (db_cache.journal_tail) {
+    db_cache.journal_tail->next = &waiter;
+  } else {
+    db_cache.journal_head = &waiter;
+  }
+
+  db_cache.journal_tail = &waiter;
+  pthread_mutex_unlock (lock);
+
+  while (!waiter.done) {
+    if (db_cache.journal_busy) {
+      pthread_cond_wait (&db_cache.journal_cond, &db_cache.journal_mutex);
+      continue;
+    }
+
+    batch = db_cache.journal_head;
+    db_cache.journal_head = NULL;
+    db_cache.journal_tail = NULL;
+    db_cache.journal_busy = true;
+    pthread_mutex_unlock (&db_cache.journal_mutex);
+    status = db_journal_write (batch);
+    pthread_mutex_lock (&db_cache.journal_mutex);
+
+    for (; batch; batch = next) {
+      next = batch->next;
+      batch->status = status;
+      batch->done = true;
+    }
+
+    db_cache.journal_busy = false;
+    pthread_cond_broadcast (&db_cache.journal_cond);
+  }
+
+  status = waiter.status;
+  pthread_mutex_unlock (&db_cache.journal_mutex);
+  return status;
+}
+
+/*
+ * Syncs the directory of the journal, for a created or renamed journal to survive a crash
+ */
+static int
+db_journal_sync_dir (
+  void)
+{
+  int                                     fd;
+  int                                     ret = 0;
+
+  if ((fd = open (db_cache.journal_dir, O_RDONLY | O_DIRECTORY)) < 0) {
+    return errno;
+  }
+
+  if (fsync (fd) != 0) {
+    ret = errno;
+  }
+
+  close (fd);
+  return ret;
+}
+
+/*
+ * Renames the journal to flushing_path and starts a new one.
+ * The journal must be owned (journal_busy).
+ */
+static int
+db_journal_rotate (
+  void)
+{
+  int                                     fd;
+  int                                     ret;
+
+  /*
+   * No journal after a failed rotation
+   */
+  if ((rename (db_cache.journal_path, db_cache.flushing_path) != 0) && (errno != ENOENT)) {
+    return errno;
+  }
+
+  /*
+   * The records written so far are now in flushing_path
+   */
+  db_cache.flushing = true;
+
+  if ((fd = open (db_cache.journal_path, O_RDWR | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR)) < 0) {
+    ret = errno;
+  } else if ((ret = db_journal_sync_dir ()) != 0) {
+    close (fd);
+  }
+
+  if (ret != 0) {
+    /*
+     * The AIR fail until the next rotation
+     */
+    db_cache.journal_broken = true;
+    return ret;
+  }
+
+  close (db_cache.journal_fd);
+  db_cache.journal_fd = fd;
+  db_cache.journal_size = 0;
+  db_cache.journal_broken = false;
+  return 0;
+}
+
+/*
+ * Writes records to the database in one transaction.
+ * A reconnection in the middle of the transaction lost its first records,
+ * the whole batch is then reported as failed.
+ */
+static int
+db_cache_store_records (
+  const db_journal_record_t * records,
+  uint32_t nb_records)
+{
+  db_connection_t                        *connection_p;
+  unsigned long                           thread_id;
+  uint32_t                                i;
+  int                                     ret = 0;
+
+  if ((connection_p = hss_mysql_get_connection ()) == NULL) {
+    return EINVAL;
+  }
+
+  thread_id = mysql_thread_id (connection_p->db_conn);
+  mysql_autocommit (connection_p->db_conn, 0);
+
+  for (i = 0; (i < nb_records) && (ret == 0); i++) {
+    ret = hss_mysql_store_rand_sqn (connection_p, records[i].imsi, records[i].rand, records[i].sqn);
+  }
+
+  if ((ret == 0) && (thread_id == mysql_thread_id (connection_p->db_conn)) && (mysql_commit (connection_p->db_conn) == 0)) {
+    ret = 0;
+  } else {
+    FPRINTF_ERROR ("Failed to write %u SQN updates to db: %s\n", nb_records, mysql_error (connection_p->db_conn));
+    mysql_rollback (connection_p->db_conn);
+    ret = EINVAL;
+  }
+
+  mysql_autocommit (connection_p->db_conn, 1);
+  hss_mysql_release_connection (connection_p);
+  return ret;
+}
+
+/*
+ * Appends to records the valid records of a journal file. A record which fails
+ * its checksum (torn by a crash, or corrupted) is skipped.
+ */
+static int
+db_journal_read (
+  const char *path,
+  db_journal_record_t ** records_p,
+  uint32_t * nb_records_p)
+{
+  struct stat                             journal_stat;
+  db_journal_record_t                    *records;
+  uint8_t                                *bytes;
+  size_t                                  length;
+  ssize_t                                 nb_read;
+  uint32_t                                nb_slots;
+  uint32_t                                nb_valid = 0;
+  uint32_t                                i;
+  int                                     fd;
+  int                                     ret = 0;
+
+  if ((fd = open (path, O_RDONLY)) < 0) {
+    return (errno == ENOENT) ? 0 : errno;
+  }
+
+  if (fstat (fd, &journal_stat) != 0) {
+    ret = errno;
+    close (fd);
+    return ret;
+  }
+
+  nb_slots = journal_stat.st_size / sizeof (db_journal_record_t);
+
+  if (nb_slots == 0) {
+    close (fd);
+    return 0;
+  }
+
+  if ((records = realloc (*records_p, (*nb_records_p + nb_slots) * sizeof (db_journal_record_t))) == NULL) {
+    close (fd);
+    return ENOMEM;
+  }
+
+  *records_p = records;
+  records += *nb_records_p;
+  bytes = (uint8_t *) records;
+  length = nb_slots * sizeof (db_journal_record_t);
+
+  while (length > 0) {
+    if ((nb_read = read (fd, bytes, length)) < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+
+      ret = errno;
+      break;
+    }
+
+    if (nb_read == 0) {
+      break;
+    }
+
+    bytes += nb_read;
+    length -= nb_read;
+  }
+
+  close (fd);
+
+  if (ret != 0) {
+    return ret;
+  }
+
+  nb_slots -= (length + sizeof (db_journal_record_t) - 1) / sizeof (db_journal_record_t);
+
+  for (i = 0; i < nb_slots; i++) {
+    if (records[i].checksum != db_journal_checksum (&records[i])) {
+      continue;
+    }
+
+    records[nb_valid] = records[i];
+    records[nb_valid].imsi[IMSI_LENGTH_MAX] = '\0';
+    nb_valid++;
+  }
+
+  if (nb_valid < nb_slots) {
+    FPRINTF_ERROR ("SQN journal %s: %u invalid records skipped\n", path, nb_slots - nb_valid);
+  }
+
+  *nb_records_p += nb_valid;
+  return 0;
+}
+
+/*
+ * Applies the records of the journals left by the previous run
+ */
+static int
+db_journal_replay (
+  void)
+{
+  db_journal_record_t                    *records = NULL;
+  uint32_t                                nb_records = 0;
+  int                                     ret;
+
+  /*
+   * The rotated journal of an incomplete flush is the older one
+   */
+  if (((ret = db_journal_read (db_cache.flushing_path, &records, &nb_records)) == 0) && ((ret = db_journal_read (db_cache.journal_path, &records, &nb_records)) == 0)) {
+    FPRINTF_NOTICE ("Replaying %u SQN updates of the journal\n", nb_records);
+
+    if (nb_records > 0) {
+      ret = db_cache_store_records (records, nb_records);
+    }
+  }
+
+  free (records);
+
+  if ((ret == 0) && (unlink (db_cache.flushing_path) != 0) && (errno != ENOENT)) {
+    ret = errno;
+  }
+
+  return ret;
+}
+
+/*
+ * Writes the entries updated since the last flush to the database, then drops
+ * the journal which has their records
+ */
+static int
+db_cache_flush (
+  void)
+{
+  db_cache_entry_t                       *entry;
+  db_cache_entry_t                       *next;
+  db_journal_record_t                    *record;
+  pthread_mutex_t                        *lock;
+  int                                     ret;
+
+  /*
+   * Own the journal while rotating it and collecting the updated entries:
+   * the update of a record of the rotated journal is then in the entries
+   * collected now, or by a previous flush.
+   */
+  pthread_mutex_lock (&db_cache.journal_mutex);
+
+  while (db_cache.journal_busy) {
+    pthread_cond_wait (&db_cache.journal_cond, &db_cache.journal_mutex);
+  }
+
+  db_cache.journal_busy = true;
+  pthread_mutex_unlock (&db_cache.journal_mutex);
+
+  /*
+   * The rotated journal of a failed flush is kept until its records are in the database
+   */
+  if (!db_cache.flushing && ((ret = db_journal_rotate ()) != 0)) {
+    FPRINTF_ERROR ("Failed to rotate SQN journal %s: %s\n", db_cache.journal_path, strerror (ret));
+  }
+
+  pthread_mutex_lock (&db_cache.dirty_mutex);
+  entry = db_cache.dirty_entries;
+  db_cache.dirty_entries = NULL;
+  pthread_mutex_unlock (&db_cache.dirty_mutex);
+  pthread_mutex_lock (&db_cache.journal_mutex);
+  db_cache.journal_busy = false;
+  pthread_cond_broadcast (&db_cache.journal_cond);
+  pthread_mutex_unlock (&db_cache.journal_mutex);
+
+  for (; entry; entry = next) {
+    if (db_cache.nb_records == db_cache.max_records) {
+      record = realloc (db_cache.records, 2 * db_cache.max_records * sizeof (db_journal_record_t));
+
+      if (record == NULL) {
+        /*
+         * Left for the next flush
+         */
+        FPRINTF_ERROR ("An error occured on MALLOC\n");
+
+        for (; entry; entry = next) {
+          next = entry->next_dirty;
+          pthread_mutex_lock (&db_cache.dirty_mutex);
+          entry->next_dirty = db_cache.dirty_entries;
+          db_cache.dirty_entries = entry;
+          pthread_mutex_unlock (&db_cache.dirty_mutex);
+        }
+
+        return ENOMEM;
+      }
+
+      db_cache.records = record;
+      db_cache.max_records *= 2;
+    }
+
+    record = &db_cache.records[db_cache.nb_records++];
+    memset (record, 0, sizeof (db_journal_record_t));
+    lock = db_cache_lock (db_cache_hash (entry->imsi, strlen (entry->imsi)) & (db_cache.nb_buckets - 1));
+    pthread_mutex_lock (lock);
+    next = entry->next_dirty;
+    memcpy (record->imsi, entry->imsi, sizeof (record->imsi));
+    memcpy (record->sqn, entry->sqn, SQN_LENGTH);
+    memcpy (record->rand, entry->rand, RAND_LENGTH);
+    entry->dirty = false;
+    pthread_mutex_unlock (lock);
+  }
+
+  /*
+   * Records of a previous failed flush are written again with the new ones
+   */
+  if ((db_cache.nb_records > 0) && (db_cache_store_records (db_cache.records, db_cache.nb_records) != 0)) {
+    return EINVAL;
+  }
+
+  db_cache.nb_records = 0;
+
+  if (db_cache.flushing) {
+    if ((unlink (db_cache.flushing_path) != 0) && (errno != ENOENT)) {
+      FPRINTF_ERROR ("Failed to delete SQN journal %s: %s\n", db_cache.flushing_path, strerror (errno));
+      return errno;
+    }
+
+    db_cache.flushing = false;
+  }
+
+  return 0;
+}
+
+static void                            *
+db_cache_flush_thread (
+  void *arg)
+{
+  bool                                    stop = false;
+  int                                     ret = 0;
+
+  while (!stop) {
+    pthread_mutex_lock (&db_cache.dirty_mutex);
+
+    while (!db_cache.stop && (db_cache.dirty_entries == NULL) && (db_cache.nb_records == 0)) {
+      pthread_cond_wait (&db_cache.dirty_cond, &db_cache.dirty_mutex);
+    }
+
+    stop = db_cache.stop;
+    pthread_mutex_unlock (&db_cache.dirty_mutex);
+
+    /*
+     * Let the updates of the period accumulate in one batch, they are
+     * already safe in the journal
+     */
+    if (!stop) {
+      usleep (((ret == 0) ? DB_CACHE_FLUSH_PERIOD_MS : DB_CACHE_RETRY_PERIOD_MS) * 1000);
+    }
+
+    ret = db_cache_flush ();
+  }
+
+  return NULL;
+}
+
+/*
+ * Loads all the subscribers of the database
+ */
+static int
+db_cache_warm (
+  void)
+{
+  db_connection_t                        *connection_p;
+  MYSQL_STMT                             *stmt;
+  MYSQL_BIND                              results[5];
+  my_bool                                 is_null[5] = {0};
+  unsigned long                           imsi_length = 0;
+  db_cache_entry_t                        fetched;
+  db_cache_entry_t                       *entry;
+  uint64_t                                sqn = 0;
+  uint32_t                                bucket;
+  uint32_t                                nb_subscribers = 0;
+  int                                     status;
+  int                                     i;
+
+  memset (&fetched, 0, sizeof (fetched));
+  db_bind_result_string (&results[0], fetched.imsi, sizeof (fetched.imsi), &imsi_length, &is_null[0]);
+  db_bind (&results[1], MYSQL_TYPE_BLOB, fetched.key, KEY_LENGTH);
+  db_bind (&results[2], MYSQL_TYPE_LONGLONG, &sqn, sizeof (sqn));
+  results[2].is_unsigned = 1;
+  db_bind (&results[3], MYSQL_TYPE_BLOB, fetched.rand, RAND_LENGTH);
+  db_bind (&results[4], MYSQL_TYPE_BLOB, fetched.opc, KEY_LENGTH);
+
+  for (i = 1; i < 5; i++) {
+    results[i].is_null = &is_null[i];
+  }
+
+  if ((connection_p = hss_mysql_get_connection ()) == NULL) {
+    return EINVAL;
+  }
+
+  if ((stmt = hss_mysql_execute (connection_p, DB_STMT_ALL_AUTH_INFO, NULL, results)) == NULL) {
+    hss_mysql_release_connection (connection_p);
+    return EINVAL;
+  }
+
+  for (db_cache.nb_buckets = DB_CACHE_MIN_BUCKETS; db_cache.nb_buckets < mysql_stmt_num_rows (stmt); db_cache.nb_buckets *= 2);
+
+  if ((db_cache.buckets = calloc (db_cache.nb_buckets, sizeof (db_cache_entry_t *))) == NULL) {
+    mysql_stmt_free_result (stmt);
+    hss_mysql_release_connection (connection_p);
+    return ENOMEM;
+  }
+
+  fetched.loaded = db_cache_now ();
+
+  while (((status = mysql_stmt_fetch (stmt)) == 0) || (status == MYSQL_DATA_TRUNCATED)) {
+    /*
+     * Incomplete subscribers are left to the database, as AIR fails for them
+     */
+    if (is_null[0] || is_null[1] || is_null[2] || is_null[3] || is_null[4] || (imsi_length > IMSI_LENGTH_MAX)) {
+      continue;
+    }
+
+    db_result_string_end (fetched.imsi, sizeof (fetched.imsi), imsi_length, is_null[0]);
+    fetched.sqn[0] = (sqn >> 40) & 0xFF;
+    fetched.sqn[1] = (sqn >> 32) & 0xFF;
+    fetched.sqn[2] = (sqn >> 24) & 0xFF;
+    fetched.sqn[3] = (sqn >> 16) & 0xFF;
+    fetched.sqn[4] = (sqn >> 8) & 0xFF;
+    fetched.sqn[5] = sqn & 0xFF;
+
+    if ((entry = malloc (sizeof (db_cache_entry_t))) == NULL) {
+      break;
+    }
+
+    *entry = fetched;
+    bucket = db_cache_hash (entry->imsi, imsi_length) & (db_cache.nb_buckets - 1);
+    db_cache_insert (bucket, entry);
+    nb_subscribers++;
+  }
+
+  mysql_stmt_free_result (stmt);
+  hss_mysql_release_connection (connection_p);
+  FPRINTF_NOTICE ("Subscriber cache: %u subscribers loaded\n", nb_subscribers);
+  return 0;
+}
+
+int
+hss_cache_init (
+  const hss_config_t * hss_config_p)
+{
+  char                                   *path;
+  int                                     ret = 0;
+  int                                     i;
+
+  if (hss_config_p->sqn_journal == NULL) {
+    return 0;
+  }
+
+  for (i = 0; i < DB_CACHE_LOCKS; i++) {
+    pthread_mutex_init (&db_cache.locks[i], NULL);
+  }
+
+  pthread_mutex_init (&db_cache.dirty_mutex, NULL);
+  pthread_cond_init (&db_cache.dirty_cond, NULL);
+  pthread_mutex_init (&db_cache.journal_mutex, NULL);
+  pthread_cond_init (&db_cache.journal_cond, NULL);
+  db_cache.max_records = DB_CACHE_MIN_BUCKETS;
+  db_cache.records = malloc (db_cache.max_records * sizeof (db_journal_record_t));
+  db_cache.journal_path = strdup (hss_config_p->sqn_journal);
+  db_cache.flushing_path = malloc (strlen (hss_config_p->sqn_journal) + sizeof (DB_JOURNAL_FLUSHING_SUFFIX));
+  path = strdup (hss_config_p->sqn_journal);
+
+  if ((db_cache.records == NULL) || (db_cache.journal_path == NULL) || (db_cache.flushing_path == NULL) || (path == NULL)) {
+    free (path);
+    return ENOMEM;
+  }
+
+  sprintf (db_cache.flushing_path, "%s%s", hss_config_p->sqn_journal, DB_JOURNAL_FLUSHING_SUFFIX);
+  db_cache.journal_dir = strdup (dirname (path));
+  free (path);
+
+  if (db_cache.journal_dir == NULL) {
+    return ENOMEM;
+  }
+
+  if ((ret = db_journal_replay ()) != 0) {
+    FPRINTF_ERROR ("Failed to replay SQN journal %s: %s\n", hss_config_p->sqn_journal, strerror (ret));
+    return ret;
+  }
+
+  /*
+   * Replayed, the journal starts empty
+   */
+  db_cache.journal_fd = open (hss_config_p->sqn_journal, O_RDWR | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+
+  if ((db_cache.journal_fd < 0) || ((ret = db_journal_sync_dir ()) != 0)) {
+    ret = (db_cache.journal_fd < 0) ? errno : ret;
+    FPRINTF_ERROR ("Failed to open SQN journal %s: %s\n", hss_config_p->sqn_journal, strerror (ret));
+    return ret;
+  }
+
+  if ((ret = db_cache_warm ()) != 0) {
+    FPRINTF_ERROR ("Failed to initialize the subscriber cache\n");
+    return ret;
+  }
+
+  if ((ret = pthread_create (&db_cache.flush_thread, NULL, db_cache_flush_thread, NULL)) != 0) {
+    return ret;
+  }
+
+  db_cache.enabled = true;
+  return 0;
+}
+
+/*
+ * Flushes the pending updates then frees the cache
+ */
+void
+hss_cache_exit (
+  void)
+{
+  db_cache_entry_t                       *entry;
+  uint32_t                                i;
+
+  if (!db_cache.enabled) {
+    return;
+  }
+
+  pthread_mutex_lock (&db_cache.dirty_mutex);
+  db_cache.stop = true;
+  pthread_cond_signal (&db_cache.dirty_cond);
+  pthread_mutex_unlock (&db_cache.dirty_mutex);
+  pthread_join (db_cache.flush_thread, NULL);
+  close (db_cache.journal_fd);
+
+  for (i = 0; i < db_cache.nb_buckets; i++) {
+    while ((entry = db_cache.buckets[i]) != NULL) {
+      db_cache.buckets[i] = entry->next;
+      free (entry);
+    }
+  }
+
+  for (i = 0; i < DB_CACHE_LOCKS; i++) {
+    pthread_mutex_destroy (&db_cache.locks[i]);
+  }
+
+  pthread_cond_destroy (&db_cache.journal_cond);
+  pthread_mutex_destroy (&db_cache.journal_mutex);
+  pthread_cond_destroy (&db_cache.dirty_cond);
+  pthread_mutex_destroy (&db_cache.dirty_mutex);
+  free (db_cache.buckets);
+  free (db_cache.records);
+  free (db_cache.journal_buffer);
+  free (db_cache.journal_path);
+  free (db_cache.flushing_path);
+  free (db_cache.journal_dir);
+  memset (&db_cache, 0, sizeof (db_cache));
+  db_cache.journal_fd = -1;
+}
+
+bool
+hss_cache_is_enabled (
+  void)
+{
+  return db_cache.enabled;
+}
+
+int
+hss_cache_auth_info (
+  mysql_auth_info_req_t * auth_info_req,
+  mysql_auth_info_resp_t * auth_info_resp)
+{
+  db_cache_entry_t                       *entry;
+  pthread_mutex_t                        *lock;
+
+  if ((entry = db_cache_lookup (auth_info_req->imsi, &lock)) == NULL) {
+    return EINVAL;
+  }
+
+  memcpy (auth_info_resp->key, entry->key, KEY_LENGTH);
+  memcpy (auth_info_resp->opc, entry->opc, KEY_LENGTH);
+  memcpy (auth_info_resp->sqn, entry->sqn, SQN_LENGTH);
+  memcpy (auth_info_resp->rand, entry->rand, RAND_LENGTH);
+  pthread_mutex_unlock (lock);
+  return 0;
+}
+
+/*
+ * Returns once the update is in the journal, non zero if it could not be
+ * written: the AIA must then not be sent.
+ */
+int
+hss_cache_push_rand_sqn (
+  const char *imsi,
+  const uint8_t * rand_p,
+  const uint8_t * sqn)
+{
+  db_cache_entry_t                       *entry;
+  pthread_mutex_t                        *lock;
+
+  if ((entry = db_cache_lookup (imsi, &lock)) == NULL) {
+    return EINVAL;
+  }
+
+  memcpy (entry->rand, rand_p, RAND_LENGTH);
+  memcpy (entry->sqn, sqn, SQN_LENGTH);
+  db_cache_set_dirty (entry);
+  return db_journal_append (entry, lock);
+}
+
+int
+hss_cache_increment_sqn (
+  const char *imsi)
+{
+  db_cache_entry_t                       *entry;
+  pthread_mutex_t                        *lock;
+  uint64_t                                sqn = 0;
+  int                                     i;
+
+  if ((entry = db_cache_lookup (imsi, &lock)) == NULL) {
+    return EINVAL;
+  }
+
+  for (i = 0; i < SQN_LENGTH; i++) {
+    sqn = (sqn << 8) | entry->sqn[i];
+  }
+
+  /*
+   * + 32 = 2 ^ sizeof(IND) (see 3GPP TS. 33.102)
+   */
+  sqn += 32;
+
+  for (i = SQN_LENGTH - 1; i >= 0; i--, sqn >>= 8) {
+    entry->sqn[i] = sqn & 0xFF;
+  }
+
+  db_cache_set_dirty (entry);
+  return db_journal_append (entry, lock);
+}
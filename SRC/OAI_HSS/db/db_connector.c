@@ -31,19 +31,59 @@
 #include <inttypes.h>
 
 #include <mysql/mysql.h>
+#include <mysql/errmsg.h>
+#include <mysql/mysqld_error.h>
 
 #include "hss_config.h"
 #include "db_proto.h"
 #include "log.h"
 
-extern void                             ComputeOPc (
-  const uint8_t const kP[16],
-  const uint8_t const opP[16],
-  uint8_t opcP[16]);
-
 
 database_t                             *db_desc;
 
+#define DB_OPC_WHEN_8 "WHEN ? THEN ? WHEN ? THEN ? WHEN ? THEN ? WHEN ? THEN ? " \
+                      "WHEN ? THEN ? WHEN ? THEN ? WHEN ? THEN ? WHEN ? THEN ? "
+#define DB_OPC_IN_8   "?,?,?,?,?,?,?,?"
+#if DB_OPC_BATCH_SIZE != 32
+#error "DB_STMT_PUSH_OPC must have DB_OPC_BATCH_SIZE WHEN and IN parameters"
+#endif
+
+/*
+ * Prepared once per connection of the pool, the values are bound on each execution
+ */
+static const char                      *const db_statements[DB_STMT_MAX] = {
+  [DB_STMT_AUTH_INFO] = "SELECT `key`,`sqn`,`rand`,`OPc` FROM `users` WHERE `users`.`imsi`=?",
+  [DB_STMT_ALL_AUTH_INFO] = "SELECT `imsi`,`key`,`sqn`,`rand`,`OPc` FROM `users`",
+  [DB_STMT_PUSH_RAND_SQN] = "UPDATE `users` SET `rand`=?,`sqn`=? WHERE `users`.`imsi`=?",
+  /*
+   * + 32 = 2 ^ sizeof(IND) (see 3GPP TS. 33.102)
+   */
+  [DB_STMT_INCREMENT_SQN] = "UPDATE `users` SET `sqn` = `sqn` + 32 WHERE `users`.`imsi`=?",
+  /*
+   * Keyset pagination, the chunks are read from the last IMSI of the previous one
+   */
+  [DB_STMT_KEYS_CHUNK] = "SELECT `imsi`,`key`,`OPc` FROM `users` WHERE `users`.`imsi`>? ORDER BY `imsi` LIMIT ?",
+  /*
+   * DB_OPC_BATCH_SIZE (IMSI, OPc) then the DB_OPC_BATCH_SIZE IMSIs
+   */
+  [DB_STMT_PUSH_OPC] = "UPDATE `users` SET `OPc`=CASE `imsi` " DB_OPC_WHEN_8 DB_OPC_WHEN_8 DB_OPC_WHEN_8 DB_OPC_WHEN_8 "END"
+    " WHERE `users`.`imsi` IN (" DB_OPC_IN_8 "," DB_OPC_IN_8 "," DB_OPC_IN_8 "," DB_OPC_IN_8 ")",
+  [DB_STMT_UPDATE_LOC] = "SELECT `access_restriction`,`mmeidentity_idmmeidentity`," "`msisdn`,`ue_ambr_ul`,`ue_ambr_dl`,`rau_tau_timer` " "FROM `users` WHERE `users`.`imsi`=?",
+  [DB_STMT_PUSH_MME_IDENTITY] = "INSERT INTO `mmeidentity`" " (`mmehost`,`mmerealm`) SELECT ?,? FROM `mmeidentity` WHERE NOT" " EXISTS (SELECT * FROM `mmeidentity` WHERE `mmehost`=?" " AND `mmerealm`=?) LIMIT 1",
+  /*
+   * A NULL IMEI or software version leaves the stored one unchanged
+   */
+  [DB_STMT_PUSH_UP_LOC] = "UPDATE `users` SET `imei`=IFNULL(?,`imei`),`imei_sv`=IFNULL(?,`imei_sv`)" " WHERE `users`.`imsi`=?",
+  [DB_STMT_PUSH_UP_LOC_MME] = "UPDATE `users`,`mmeidentity` SET `users`.`imei`=IFNULL(?,`users`.`imei`)," "`users`.`imei_sv`=IFNULL(?,`users`.`imei_sv`),"
+    "`users`.`mmeidentity_idmmeidentity`=`mmeidentity`.`idmmeidentity`, " "`users`.`ms_ps_status`='NOT_PURGED'" " WHERE `users`.`imsi`=?" " AND `mmeidentity`.`mmehost`=?" " AND `mmeidentity`.`mmerealm`=?",
+  [DB_STMT_PURGE_UE] = "UPDATE `users` SET `users`.`ms_ps_status`='PURGED' " "WHERE `users`.`imsi`=?",
+  [DB_STMT_PURGE_UE_MME] = "SELECT `users`.`mmeidentity_idmmeidentity` FROM `users` " "WHERE `users`.`imsi`=?",
+  [DB_STMT_GET_USER] = "SELECT `imsi` FROM `users` WHERE `users`.`imsi`=?",
+  [DB_STMT_QUERY_MMEIDENTITY] = "SELECT mmehost,mmerealm FROM mmeidentity WHERE " "mmeidentity.idmmeidentity=?",
+  [DB_STMT_CHECK_EPC_EQUIPMENT] = "SELECT idmmeidentity FROM mmeidentity WHERE mmeidentity.mmehost=?",
+  [DB_STMT_QUERY_PDNS] = "SELECT `apn`,`pdn_type`,`pdn_ipv4`,`pdn_ipv6`,`aggregate_ambr_ul`,`aggregate_ambr_dl`," "`qci`,`priority_level`,`pre_emp_cap`,`pre_emp_vul` FROM `pdn` WHERE " "`pdn`.`users_imsi`=? LIMIT 10",
+};
+
 static void
 print_buffer (
   const char *prefix,
@@ -61,11 +101,64 @@ print_buffer (
   fprintf (stdout, "\n");
 }
 
+static void
+hss_mysql_close_statements (
+  db_connection_t * connection_p)
+{
+  int                                     i;
+
+  for (i = 0; i < DB_STMT_MAX; i++) {
+    if (connection_p->stmts[i]) {
+      mysql_stmt_close (connection_p->stmts[i]);
+      connection_p->stmts[i] = NULL;
+    }
+  }
+}
+
+/*
+ * (Re)prepares the statements of a connection, the ping reconnects it
+ * if the server went away, which invalidates the previous statements.
+ */
+static int
+hss_mysql_prepare_statements (
+  db_connection_t * connection_p)
+{
+  int                                     i;
+
+  hss_mysql_close_statements (connection_p);
+
+  if (mysql_ping (connection_p->db_conn)) {
+    FPRINTF_ERROR ("Lost connection to db: %s\n", mysql_error (connection_p->db_conn));
+    return -1;
+  }
+
+  for (i = 0; i < DB_STMT_MAX; i++) {
+    connection_p->stmts[i] = mysql_stmt_init (connection_p->db_conn);
+
+    if ((connection_p->stmts[i] == NULL) || mysql_stmt_prepare (connection_p->stmts[i], db_statements[i], strlen (db_statements[i]))) {
+      FPRINTF_ERROR ("Failed to prepare query %s: %s\n", db_statements[i], mysql_error (connection_p->db_conn));
+      hss_mysql_close_statements (connection_p);
+      return -1;
+    }
+  }
+
+  return 0;
+}
+
+static int
+hss_mysql_is_connection_lost (
+  unsigned int error)
+{
+  return (error == CR_SERVER_GONE_ERROR) || (error == CR_SERVER_LOST) || (error == ER_UNKNOWN_STMT_HANDLER);
+}
+
 int
 hss_mysql_connect (
   const hss_config_t * hss_config_p)
 {
   const int                               mysql_reconnect_val = 1;
+  db_connection_t                        *connection_p;
+  int                                     i;
 
   if ((hss_config_p->mysql_server == NULL) || (hss_config_p->mysql_user == NULL) || (hss_config_p->mysql_password == NULL) || (hss_config_p->mysql_database == NULL)) {
     FPRINTF_ERROR ( "An empty name is not allowed\n");
@@ -73,7 +166,7 @@ hss_mysql_connect (
   }
 
   FPRINTF_DEBUG ("Initializing db layer\n");
-  db_desc = malloc (sizeof (database_t));
+  db_desc = calloc (1, sizeof (database_t));
 
   if (db_desc == NULL) {
     FPRINTF_DEBUG ("An error occured on MALLOC\n");
@@ -81,6 +174,7 @@ hss_mysql_connect (
   }
 
   pthread_mutex_init (&db_desc->db_cs_mutex, NULL);
+  pthread_cond_init (&db_desc->db_cs_cond, NULL);
   /*
    * Copy database configuration from static hss config
    */
@@ -88,26 +182,44 @@ hss_mysql_connect (
   db_desc->user = strdup (hss_config_p->mysql_user);
   db_desc->password = strdup (hss_config_p->mysql_password);
   db_desc->database = strdup (hss_config_p->mysql_database);
-  /*
-   * Init mySQL client
-   */
-  db_desc->db_conn = mysql_init (NULL);
-  mysql_options (db_desc->db_conn, MYSQL_OPT_RECONNECT, &mysql_reconnect_val);
+  db_desc->nb_connections = (hss_config_p->mysql_connections > 0) ? hss_config_p->mysql_connections : 1;
+  db_desc->connections = calloc (db_desc->nb_connections, sizeof (db_connection_t));
 
-  /*
-   * Try to connect to database
-   */
-  if (!mysql_real_connect (db_desc->db_conn, db_desc->server, db_desc->user, db_desc->password, db_desc->database, 0, NULL, 0)) {
-    FPRINTF_ERROR ("An error occured while connecting to db: %s\n", mysql_error (db_desc->db_conn));
-    mysql_thread_end();
-    return -1;
+  if (db_desc->connections == NULL) {
+    FPRINTF_DEBUG ("An error occured on MALLOC\n");
+    hss_mysql_disconnect ();
+    return ENOMEM;
   }
 
   /*
-   * Set the multi statement ON
+   * Init mySQL client, before the threads use it
    */
-  mysql_set_server_option (db_desc->db_conn, MYSQL_OPTION_MULTI_STATEMENTS_ON);
-  FPRINTF_DEBUG ("Initializing db layer: DONE\n");
+  mysql_library_init (0, NULL, NULL);
+
+  for (i = 0; i < db_desc->nb_connections; i++) {
+    connection_p = &db_desc->connections[i];
+    connection_p->db_conn = mysql_init (NULL);
+    mysql_options (connection_p->db_conn, MYSQL_OPT_RECONNECT, &mysql_reconnect_val);
+
+    /*
+     * Try to connect to database
+     */
+    if (!mysql_real_connect (connection_p->db_conn, db_desc->server, db_desc->user, db_desc->password, db_desc->database, 0, NULL, 0)) {
+      FPRINTF_ERROR ("An error occured while connecting to db: %s\n", mysql_error (connection_p->db_conn));
+      hss_mysql_disconnect ();
+      return -1;
+    }
+
+    if (hss_mysql_prepare_statements (connection_p) != 0) {
+      hss_mysql_disconnect ();
+      return -1;
+    }
+
+    connection_p->next = db_desc->free_connections;
+    db_desc->free_connections = connection_p;
+  }
+
+  FPRINTF_DEBUG ("Initializing db layer: DONE (%d connections)\n", db_desc->nb_connections);
   return 0;
 }
 
@@ -115,21 +227,199 @@ void
 hss_mysql_disconnect (
   void)
 {
-  mysql_close (db_desc->db_conn);
+  int                                     i;
+
+  if (db_desc == NULL) {
+    return;
+  }
+
+  hss_cache_exit ();
+
+  if (db_desc->connections) {
+    for (i = 0; i < db_desc->nb_connections; i++) {
+      if (db_desc->connections[i].db_conn) {
+        hss_mysql_close_statements (&db_desc->connections[i]);
+        mysql_close (db_desc->connections[i].db_conn);
+      }
+    }
+
+    free (db_desc->connections);
+  }
+
+  pthread_cond_destroy (&db_desc->db_cs_cond);
+  pthread_mutex_destroy (&db_desc->db_cs_mutex);
+  free (db_desc->server);
+  free (db_desc->user);
+  free (db_desc->password);
+  free (db_desc->database);
+  free (db_desc);
+  db_desc = NULL;
   mysql_thread_end();
 }
 
+/*
+ * Takes a connection of the pool, waits for one if all serve other requests
+ */
+db_connection_t                        *
+hss_mysql_get_connection (
+  void)
+{
+  db_connection_t                        *connection_p;
+
+  if (db_desc == NULL) {
+    return NULL;
+  }
+
+  pthread_mutex_lock (&db_desc->db_cs_mutex);
+
+  while (db_desc->free_connections == NULL) {
+    pthread_cond_wait (&db_desc->db_cs_cond, &db_desc->db_cs_mutex);
+  }
+
+  connection_p = db_desc->free_connections;
+  db_desc->free_connections = connection_p->next;
+  pthread_mutex_unlock (&db_desc->db_cs_mutex);
+  return connection_p;
+}
+
+void
+hss_mysql_release_connection (
+  db_connection_t * connection_p)
+{
+  pthread_mutex_lock (&db_desc->db_cs_mutex);
+  connection_p->next = db_desc->free_connections;
+  db_desc->free_connections = connection_p;
+  pthread_cond_signal (&db_desc->db_cs_cond);
+  pthread_mutex_unlock (&db_desc->db_cs_mutex);
+}
+
+/*
+ * Executes a prepared statement of the connection, its result set, if any,
+ * is stored client side: fetch the rows with mysql_stmt_fetch() then
+ * release them with mysql_stmt_free_result().
+ * Returns NULL on error.
+ */
+MYSQL_STMT                             *
+hss_mysql_execute (
+  db_connection_t * connection_p,
+  db_stmt_t stmt_id,
+  MYSQL_BIND * params,
+  MYSQL_BIND * results)
+{
+  MYSQL_STMT                             *stmt;
+  unsigned int                            error;
+  int                                     retry;
+
+  FPRINTF_DEBUG ("Query: %s\n", db_statements[stmt_id]);
+
+  for (retry = 0;; retry++) {
+    stmt = connection_p->stmts[stmt_id];
+
+    if ((stmt != NULL)
+        && ((params == NULL) || (mysql_stmt_bind_param (stmt, params) == 0))
+        && (mysql_stmt_execute (stmt) == 0)
+        && ((results == NULL) || (mysql_stmt_bind_result (stmt, results) == 0))
+        && ((mysql_stmt_field_count (stmt) == 0) || (mysql_stmt_store_result (stmt) == 0))) {
+      return stmt;
+    }
+
+    if (stmt != NULL) {
+      error = mysql_stmt_errno (stmt);
+      FPRINTF_ERROR ("Query execution failed: %s\n", mysql_stmt_error (stmt));
+    } else {
+      error = CR_SERVER_LOST;
+    }
+
+    /*
+     * Reconnect and prepare again once, the server may have been restarted
+     */
+    if ((retry > 0) || !hss_mysql_is_connection_lost (error) || (hss_mysql_prepare_statements (connection_p) != 0)) {
+      return NULL;
+    }
+  }
+}
+
+void
+db_bind (
+  MYSQL_BIND * bind,
+  enum enum_field_types type,
+  void *buffer,
+  unsigned long buffer_length)
+{
+  memset (bind, 0, sizeof (MYSQL_BIND));
+  bind->buffer_type = type;
+  bind->buffer = buffer;
+  bind->buffer_length = buffer_length;
+}
+
+/*
+ * A NULL string is bound as SQL NULL
+ */
+void
+db_bind_string (
+  MYSQL_BIND * bind,
+  const char *string)
+{
+  if (string == NULL) {
+    db_bind (bind, MYSQL_TYPE_NULL, NULL, 0);
+  } else {
+    db_bind (bind, MYSQL_TYPE_STRING, (void *)string, strlen (string));
+  }
+}
+
+/*
+ * Up to size - 1 characters of a string column, see db_result_string_end()
+ */
+void
+db_bind_result_string (
+  MYSQL_BIND * bind,
+  char *string,
+  unsigned long size,
+  unsigned long *length,
+  my_bool * is_null)
+{
+  db_bind (bind, MYSQL_TYPE_STRING, string, size - 1);
+  bind->length = length;
+  bind->is_null = is_null;
+}
+
+/*
+ * Terminates a string fetched by db_bind_result_string(), empty if NULL
+ */
+void
+db_result_string_end (
+  char *string,
+  unsigned long size,
+  unsigned long length,
+  my_bool is_null)
+{
+  if (is_null) {
+    string[0] = '\0';
+  } else {
+    string[(length < size) ? length : size - 1] = '\0';
+  }
+}
+
 int
 hss_mysql_update_loc (
   const char *imsi,
   mysql_ul_ans_t * mysql_ul_ans)
 {
-  MYSQL_RES                              *res;
-  MYSQL_ROW                               row;
-  char                                    query[1000];
+  db_connection_t                        *connection_p;
+  MYSQL_STMT                             *stmt;
+  MYSQL_BIND                              params[1];
+  MYSQL_BIND                              results[6];
+  uint32_t                                access_restriction = 0;
+  int                                     mme_id = 0;
+  unsigned long                           msisdn_length = 0;
+  my_bool                                 msisdn_is_null = 1;
+  uint64_t                                aggr_ul = 0;
+  uint64_t                                aggr_dl = 0;
+  uint32_t                                rau_tau = 0;
+  int                                     status;
   int                                     ret = 0;
 
-  if ((db_desc->db_conn == NULL) || (mysql_ul_ans == NULL)) {
+  if ((db_desc == NULL) || (mysql_ul_ans == NULL)) {
     return EINVAL;
   }
 
@@ -137,48 +427,54 @@ hss_mysql_update_loc (
     return EINVAL;
   }
 
-  sprintf (query, "SELECT `access_restriction`,`mmeidentity_idmmeidentity`," "`msisdn`,`ue_ambr_ul`,`ue_ambr_dl`,`rau_tau_timer` " "FROM `users` WHERE `users`.`imsi`='%s' ", imsi);
   memcpy (mysql_ul_ans->imsi, imsi, strlen (imsi) + 1);
-  FPRINTF_DEBUG ("Query: %s\n", query);
-  pthread_mutex_lock (&db_desc->db_cs_mutex);
-
-  if (mysql_query (db_desc->db_conn, query)) {
-    pthread_mutex_unlock (&db_desc->db_cs_mutex);
-    FPRINTF_ERROR ("Query execution failed: %s\n", mysql_error (db_desc->db_conn));
+  db_bind_string (&params[0], imsi);
+  db_bind (&results[0], MYSQL_TYPE_LONG, &access_restriction, sizeof (access_restriction));
+  results[0].is_unsigned = 1;
+  db_bind (&results[1], MYSQL_TYPE_LONG, &mme_id, sizeof (mme_id));
+  db_bind_result_string (&results[2], mysql_ul_ans->msisdn, sizeof (mysql_ul_ans->msisdn), &msisdn_length, &msisdn_is_null);
+  db_bind (&results[3], MYSQL_TYPE_LONGLONG, &aggr_ul, sizeof (aggr_ul));
+  results[3].is_unsigned = 1;
+  db_bind (&results[4], MYSQL_TYPE_LONGLONG, &aggr_dl, sizeof (aggr_dl));
+  results[4].is_unsigned = 1;
+  db_bind (&results[5], MYSQL_TYPE_LONG, &rau_tau, sizeof (rau_tau));
+  results[5].is_unsigned = 1;
+
+  if ((connection_p = hss_mysql_get_connection ()) == NULL) {
     return EINVAL;
   }
 
-  res = mysql_store_result (db_desc->db_conn);
-  pthread_mutex_unlock (&db_desc->db_cs_mutex);
-
-  if ( res == NULL )
+  if ((stmt = hss_mysql_execute (connection_p, DB_STMT_UPDATE_LOC, params, results)) == NULL) {
+    hss_mysql_release_connection (connection_p);
     return EINVAL;
+  }
 
-  if ((row = mysql_fetch_row (res)) != NULL) {
-    int                                     mme_id;
+  status = mysql_stmt_fetch (stmt);
+  mysql_stmt_free_result (stmt);
+  /*
+   * The MME identity is queried on its own connection
+   */
+  hss_mysql_release_connection (connection_p);
 
+  if ((status == 0) || (status == MYSQL_DATA_TRUNCATED)) {
     /*
      * MSISDN may be NULL
      */
-    mysql_ul_ans->access_restriction = atoi (row[0]);
+    mysql_ul_ans->access_restriction = access_restriction;
 
-    if ((mme_id = atoi (row[1])) > 0) {
+    if (mme_id > 0) {
       ret = hss_mysql_query_mmeidentity (mme_id, &mysql_ul_ans->mme_identity);
     } else {
       mysql_ul_ans->mme_identity.mme_host[0] = '\0';
       mysql_ul_ans->mme_identity.mme_realm[0] = '\0';
     }
 
-    if (row[2] != 0) {
-      memcpy (mysql_ul_ans->msisdn, row[2], strlen (row[2]));
-    }
-
-    mysql_ul_ans->aggr_ul = atoi (row[3]);
-    mysql_ul_ans->aggr_dl = atoi (row[4]);
-    mysql_ul_ans->rau_tau = atoi (row[5]);
+    db_result_string_end (mysql_ul_ans->msisdn, sizeof (mysql_ul_ans->msisdn), msisdn_length, msisdn_is_null);
+    mysql_ul_ans->aggr_ul = aggr_ul;
+    mysql_ul_ans->aggr_dl = aggr_dl;
+    mysql_ul_ans->rau_tau = rau_tau;
   }
 
-  mysql_free_result (res);
   return ret;
 }
 
@@ -187,12 +483,14 @@ hss_mysql_purge_ue (
   mysql_pu_req_t * mysql_pu_req,
   mysql_pu_ans_t * mysql_pu_ans)
 {
-  MYSQL_RES                              *res;
-  MYSQL_ROW                               row;
-  char                                    query[1000];
-  int                                     ret = 0;
+  db_connection_t                        *connection_p;
+  MYSQL_STMT                             *stmt;
+  MYSQL_BIND                              params[1];
+  MYSQL_BIND                              results[1];
+  int                                     mme_id = 0;
+  int                                     status;
 
-  if ((db_desc->db_conn == NULL) || (mysql_pu_req == NULL) || (mysql_pu_ans == NULL)) {
+  if ((db_desc == NULL) || (mysql_pu_req == NULL) || (mysql_pu_ans == NULL)) {
     return EINVAL;
   }
 
@@ -200,38 +498,34 @@ hss_mysql_purge_ue (
     return EINVAL;
   }
 
+  db_bind_string (&params[0], mysql_pu_req->imsi);
+  db_bind (&results[0], MYSQL_TYPE_LONG, &mme_id, sizeof (mme_id));
 
-  sprintf (query, "UPDATE `users` SET `users`.`ms_ps_status`=\"PURGED\" " "WHERE `users`.`imsi`='%s'; " "SELECT `users`.`mmeidentity_idmmeidentity` FROM `users` " "WHERE `users`.`imsi`='%s' ", mysql_pu_req->imsi, mysql_pu_req->imsi);
-  FPRINTF_DEBUG ("Query: %s\n", query);
-  pthread_mutex_lock (&db_desc->db_cs_mutex);
-
-  if (mysql_query (db_desc->db_conn, query)) {
-    pthread_mutex_unlock (&db_desc->db_cs_mutex);
-    FPRINTF_ERROR ("Query execution failed: %s\n", mysql_error (db_desc->db_conn));
+  if ((connection_p = hss_mysql_get_connection ()) == NULL) {
     return EINVAL;
   }
 
-  res = mysql_store_result (db_desc->db_conn);
-  pthread_mutex_unlock (&db_desc->db_cs_mutex);
-
-  if ( res == NULL )
+  if ((hss_mysql_execute (connection_p, DB_STMT_PURGE_UE, params, NULL) == NULL)
+      || ((stmt = hss_mysql_execute (connection_p, DB_STMT_PURGE_UE_MME, params, results)) == NULL)) {
+    hss_mysql_release_connection (connection_p);
     return EINVAL;
+  }
 
-  if ((row = mysql_fetch_row (res)) != NULL) {
-    int                                     mme_id;
+  status = mysql_stmt_fetch (stmt);
+  mysql_stmt_free_result (stmt);
+  hss_mysql_release_connection (connection_p);
 
-    if ((mme_id = atoi (row[0])) > 0) {
-      ret = hss_mysql_query_mmeidentity (mme_id, mysql_pu_ans);
+  if ((status == 0) || (status == MYSQL_DATA_TRUNCATED)) {
+    if (mme_id > 0) {
+      return hss_mysql_query_mmeidentity (mme_id, mysql_pu_ans);
     } else {
       mysql_pu_ans->mme_host[0] = '\0';
       mysql_pu_ans->mme_realm[0] = '\0';
     }
 
-    mysql_free_result (res);
-    return ret;
+    return 0;
   }
 
-  mysql_free_result (res);
   return EINVAL;
 }
 
@@ -239,121 +533,98 @@ int
 hss_mysql_get_user (
   const char *imsi)
 {
-  MYSQL_RES                              *res;
-  MYSQL_ROW                               row;
-  char                                    query[1000];
+  db_connection_t                        *connection_p;
+  MYSQL_STMT                             *stmt;
+  MYSQL_BIND                              params[1];
+  my_ulonglong                            nb_rows = 0;
 
-  if (db_desc->db_conn == NULL) {
+  if (db_desc == NULL) {
     return EINVAL;
   }
 
+  db_bind_string (&params[0], imsi);
 
-  sprintf (query, "SELECT `imsi` FROM `users` WHERE `users`.`imsi`='%s' ", imsi);
-  FPRINTF_DEBUG ("Query: %s\n", query);
-  pthread_mutex_lock (&db_desc->db_cs_mutex);
-
-  if (mysql_query (db_desc->db_conn, query)) {
-    pthread_mutex_unlock (&db_desc->db_cs_mutex);
-    FPRINTF_ERROR ("Query execution failed: %s\n", mysql_error (db_desc->db_conn));
+  if ((connection_p = hss_mysql_get_connection ()) == NULL) {
     return EINVAL;
   }
 
-  res = mysql_store_result (db_desc->db_conn);
-  pthread_mutex_unlock (&db_desc->db_cs_mutex);
-
-  if ( res == NULL )
-    return EINVAL;
-
-  if ((row = mysql_fetch_row (res)) != NULL) {
-    mysql_free_result (res);
-    return 0;
+  if ((stmt = hss_mysql_execute (connection_p, DB_STMT_GET_USER, params, NULL)) != NULL) {
+    nb_rows = mysql_stmt_num_rows (stmt);
+    mysql_stmt_free_result (stmt);
   }
 
-  mysql_free_result (res);
-  return EINVAL;
+  hss_mysql_release_connection (connection_p);
+  return (nb_rows > 0) ? 0 : EINVAL;
 }
 
 int
 mysql_push_up_loc (
   mysql_ul_push_t * ul_push_p)
 {
-  MYSQL_RES                              *res;
-  char                                    query[1000];
-  int                                     query_length = 0;
-  int                                     status;
+  db_connection_t                        *connection_p;
+  MYSQL_BIND                              params[5];
+  db_stmt_t                               stmt_id = DB_STMT_PUSH_UP_LOC;
+  int                                     ret = 0;
 
-  if ((db_desc->db_conn == NULL) || (ul_push_p == NULL)) {
+  if ((db_desc == NULL) || (ul_push_p == NULL)) {
     return EINVAL;
   }
-  // TODO: multi-statement check results
 
-  if (ul_push_p->mme_identity_present == MME_IDENTITY_PRESENT) {
-    query_length += sprintf (&query[query_length], "INSERT INTO `mmeidentity`"
-                             " (`mmehost`,`mmerealm`) SELECT '%s','%s' FROM `mmeidentity` WHERE NOT"
-                             " EXISTS (SELECT * FROM `mmeidentity` WHERE `mmehost`='%s'"
-                             " AND `mmerealm`='%s') LIMIT 1;", ul_push_p->mme_identity.mme_host, ul_push_p->mme_identity.mme_realm, ul_push_p->mme_identity.mme_host, ul_push_p->mme_identity.mme_realm);
+  if ((connection_p = hss_mysql_get_connection ()) == NULL) {
+    return EINVAL;
   }
 
-  query_length += sprintf (&query[query_length], "UPDATE `users`%s SET ", ul_push_p->mme_identity_present == MME_IDENTITY_PRESENT ? ",`mmeidentity`" : "");
+  if (ul_push_p->mme_identity_present == MME_IDENTITY_PRESENT) {
+    db_bind_string (&params[0], ul_push_p->mme_identity.mme_host);
+    db_bind_string (&params[1], ul_push_p->mme_identity.mme_realm);
+    db_bind_string (&params[2], ul_push_p->mme_identity.mme_host);
+    db_bind_string (&params[3], ul_push_p->mme_identity.mme_realm);
+
+    if (hss_mysql_execute (connection_p, DB_STMT_PUSH_MME_IDENTITY, params, NULL) == NULL) {
+      hss_mysql_release_connection (connection_p);
+      return EINVAL;
+    }
 
-  if (ul_push_p->imei_present == IMEI_PRESENT) {
-    query_length += sprintf (&query[query_length], "`imei`='%s',", ul_push_p->imei);
+    db_bind_string (&params[3], ul_push_p->mme_identity.mme_host);
+    db_bind_string (&params[4], ul_push_p->mme_identity.mme_realm);
+    stmt_id = DB_STMT_PUSH_UP_LOC_MME;
   }
 
-  if (ul_push_p->sv_present == SV_PRESENT) {
-    query_length += sprintf (&query[query_length], "`imeisv`='%*s',", 2, ul_push_p->software_version);
-  }
+  db_bind_string (&params[0], (ul_push_p->imei_present == IMEI_PRESENT) ? ul_push_p->imei : NULL);
+  db_bind_string (&params[1], (ul_push_p->sv_present == SV_PRESENT) ? ul_push_p->software_version : NULL);
+  db_bind_string (&params[2], ul_push_p->imsi);
 
-  if (ul_push_p->mme_identity_present == MME_IDENTITY_PRESENT) {
-    query_length += sprintf (&query[query_length], "`users`.`mmeidentity_idmmeidentity`=`mmeidentity`.`idmmeidentity`, " "`users`.`ms_ps_status`=\"NOT_PURGED\"");
+  if (hss_mysql_execute (connection_p, stmt_id, params, NULL) == NULL) {
+    ret = EINVAL;
   }
 
-  query_length += sprintf (&query[query_length], " WHERE `users`.`imsi`='%s'", ul_push_p->imsi);
+  hss_mysql_release_connection (connection_p);
+  return ret;
+}
 
-  if (ul_push_p->mme_identity_present == MME_IDENTITY_PRESENT) {
-    query_length += sprintf (&query[query_length], " AND `mmeidentity`.`mmehost`='%s'" " AND `mmeidentity`.`mmerealm`='%s'", ul_push_p->mme_identity.mme_host, ul_push_p->mme_identity.mme_realm);
-  }
+/*
+ * Stores RAND and SQN of a subscriber on a connection already taken from the pool
+ */
+int
+hss_mysql_store_rand_sqn (
+  db_connection_t * connection_p,
+  const char *imsi,
+  const uint8_t * rand_p,
+  const uint8_t * sqn)
+{
+  MYSQL_BIND                              params[3];
+  uint64_t                                sqn_decimal = 0;
 
-  FPRINTF_DEBUG ("Query: %s\n", query);
-  pthread_mutex_lock (&db_desc->db_cs_mutex);
+  sqn_decimal = ((uint64_t) sqn[0] << 40) | ((uint64_t) sqn[1] << 32) | ((uint64_t) sqn[2] << 24) | (sqn[3] << 16) | (sqn[4] << 8) | sqn[5];
+  db_bind (&params[0], MYSQL_TYPE_BLOB, (void *)rand_p, RAND_LENGTH);
+  db_bind (&params[1], MYSQL_TYPE_LONGLONG, &sqn_decimal, sizeof (sqn_decimal));
+  params[1].is_unsigned = 1;
+  db_bind_string (&params[2], imsi);
 
-  if (mysql_query (db_desc->db_conn, query)) {
-    pthread_mutex_unlock (&db_desc->db_cs_mutex);
-    fprintf (stderr, "Query execution failed: %s\n", mysql_error (db_desc->db_conn));
+  if (hss_mysql_execute (connection_p, DB_STMT_PUSH_RAND_SQN, params, NULL) == NULL) {
     return EINVAL;
   }
 
-  /*
-   * process each statement result
-   */
-  do {
-    /*
-     * did current statement return data?
-     */
-    res = mysql_store_result (db_desc->db_conn);
-
-    if (res) {
-      /*
-       * yes; process rows and free the result set
-       */
-      mysql_free_result (res);
-    } else {                    /* no result set or error */
-      if (mysql_field_count (db_desc->db_conn) == 0) {
-        FPRINTF_ERROR ( "%lld rows affected\n", mysql_affected_rows (db_desc->db_conn));
-      } else {                  /* some error occurred */
-        FPRINTF_ERROR ( "Could not retrieve result set\n");
-        break;
-      }
-    }
-
-    /*
-     * more results? -1 = no, >0 = error, 0 = yes (keep looping)
-     */
-    if ((status = mysql_next_result (db_desc->db_conn)) > 0)
-      FPRINTF_ERROR ( "Could not execute statement\n");
-  } while (status == 0);
-
-  pthread_mutex_unlock (&db_desc->db_cs_mutex);
   return 0;
 }
 
@@ -363,14 +634,10 @@ hss_mysql_push_rand_sqn (
   uint8_t * rand_p,
   uint8_t * sqn)
 {
-  int                                     status = 0,
-    i;
-  MYSQL_RES                              *res;
-  char                                    query[1000];
-  int                                     query_length = 0;
-  uint64_t                                sqn_decimal = 0;
+  db_connection_t                        *connection_p;
+  int                                     ret;
 
-  if (db_desc->db_conn == NULL) {
+  if (db_desc == NULL) {
     return EINVAL;
   }
 
@@ -378,67 +645,28 @@ hss_mysql_push_rand_sqn (
     return EINVAL;
   }
 
-  sqn_decimal = ((uint64_t) sqn[0] << 40) | ((uint64_t) sqn[1] << 32) | ((uint64_t) sqn[2] << 24) | (sqn[3] << 16) | (sqn[4] << 8) | sqn[5];
-  query_length = sprintf (query, "UPDATE `users` SET `rand`=UNHEX('");
-
-  for (i = 0; i < RAND_LENGTH; i++) {
-    query_length += sprintf (&query[query_length], "%02x", rand_p[i]);
+  if (hss_cache_is_enabled ()) {
+    return hss_cache_push_rand_sqn (imsi, rand_p, sqn);
   }
 
-  query_length += sprintf (&query[query_length], "'),`sqn`=%" PRIu64, sqn_decimal);
-  query_length += sprintf (&query[query_length], " WHERE `users`.`imsi`='%s'", imsi);
-  FPRINTF_DEBUG ("Query: %s\n", query);
-  pthread_mutex_lock (&db_desc->db_cs_mutex);
-
-  if (mysql_query (db_desc->db_conn, query)) {
-    pthread_mutex_unlock (&db_desc->db_cs_mutex);
-    FPRINTF_ERROR ("Query execution failed: %s\n", mysql_error (db_desc->db_conn));
+  if ((connection_p = hss_mysql_get_connection ()) == NULL) {
     return EINVAL;
   }
 
-  /*
-   * process each statement result
-   */
-  do {
-    /*
-     * did current statement return data?
-     */
-    res = mysql_store_result (db_desc->db_conn);
-
-    if (res) {
-      /*
-       * yes; process rows and free the result set
-       */
-      mysql_free_result (res);
-    } else {                    /* no result set or error */
-      if (mysql_field_count (db_desc->db_conn) == 0) {
-        FPRINTF_ERROR ( "%lld rows affected\n", mysql_affected_rows (db_desc->db_conn));
-      } else {                  /* some error occurred */
-        FPRINTF_ERROR ( "Could not retrieve result set\n");
-        break;
-      }
-    }
-
-    /*
-     * more results? -1 = no, >0 = error, 0 = yes (keep looping)
-     */
-    if ((status = mysql_next_result (db_desc->db_conn)) > 0)
-      FPRINTF_ERROR ( "Could not execute statement\n");
-  } while (status == 0);
-
-  pthread_mutex_unlock (&db_desc->db_cs_mutex);
-  return 0;
+  ret = hss_mysql_store_rand_sqn (connection_p, imsi, rand_p, sqn);
+  hss_mysql_release_connection (connection_p);
+  return ret;
 }
 
 int
 hss_mysql_increment_sqn (
   const char *imsi)
 {
-  int                                     status;
-  MYSQL_RES                              *res;
-  char                                    query[1000];
+  db_connection_t                        *connection_p;
+  MYSQL_BIND                              params[1];
+  int                                     ret = 0;
 
-  if (db_desc->db_conn == NULL) {
+  if (db_desc == NULL) {
     return EINVAL;
   }
 
@@ -446,65 +674,59 @@ hss_mysql_increment_sqn (
     return EINVAL;
   }
 
-  /*
-   * + 32 = 2 ^ sizeof(IND) (see 3GPP TS. 33.102)
-   */
-  sprintf (query, "UPDATE `users` SET `sqn` = `sqn` + 32 WHERE `users`.`imsi`='%s'", imsi);
-  FPRINTF_DEBUG ("Query: %s\n", query);
+  if (hss_cache_is_enabled ()) {
+    return hss_cache_increment_sqn (imsi);
+  }
 
-  pthread_mutex_lock(&db_desc->db_cs_mutex);
+  db_bind_string (&params[0], imsi);
 
-  if (mysql_query (db_desc->db_conn, query)) {
-    pthread_mutex_unlock (&db_desc->db_cs_mutex);
-    FPRINTF_ERROR ("Query execution failed: %s\n", mysql_error (db_desc->db_conn));
+  if ((connection_p = hss_mysql_get_connection ()) == NULL) {
     return EINVAL;
   }
 
-  /*
-   * process each statement result
-   */
-  do {
-    /*
-     * did current statement return data?
-     */
-    res = mysql_store_result (db_desc->db_conn);
-
-    if (res) {
-      /*
-       * yes; process rows and free the result set
-       */
-      mysql_free_result (res);
-    } else {                    /* no result set or error */
-      if (mysql_field_count (db_desc->db_conn) == 0) {
-        FPRINTF_ERROR ( "%lld rows affected\n", mysql_affected_rows (db_desc->db_conn));
-      } else {                  /* some error occurred */
-        FPRINTF_ERROR ( "Could not retrieve result set\n");
-        break;
-      }
-    }
-
-    /*
-     * more results? -1 = no, >0 = error, 0 = yes (keep looping)
-     */
-    if ((status = mysql_next_result (db_desc->db_conn)) > 0)
-      FPRINTF_ERROR ( "Could not execute statement\n");
-  } while (status == 0);
+  if (hss_mysql_execute (connection_p, DB_STMT_INCREMENT_SQN, params, NULL) == NULL) {
+    ret = EINVAL;
+  }
 
-  pthread_mutex_unlock (&db_desc->db_cs_mutex);
-  return 0;
+  hss_mysql_release_connection (connection_p);
+  return ret;
 }
 
 int
 hss_mysql_auth_info (
   mysql_auth_info_req_t * auth_info_req,
   mysql_auth_info_resp_t * auth_info_resp)
+{
+  if ((db_desc == NULL) || (auth_info_req == NULL) || (auth_info_resp == NULL)) {
+    return EINVAL;
+  }
+
+  if (hss_cache_is_enabled ()) {
+    return hss_cache_auth_info (auth_info_req, auth_info_resp);
+  }
+
+  return hss_mysql_query_auth_info (auth_info_req, auth_info_resp);
+}
+
+/*
+ * Reads the authentication data of a subscriber in the database, bypassing the cache
+ */
+int
+hss_mysql_query_auth_info (
+  mysql_auth_info_req_t * auth_info_req,
+  mysql_auth_info_resp_t * auth_info_resp)
 {
   int                                     ret = 0;
-  MYSQL_RES                              *res;
-  MYSQL_ROW                               row;
-  char                                    query[1000];
+  db_connection_t                        *connection_p;
+  MYSQL_STMT                             *stmt;
+  MYSQL_BIND                              params[1];
+  MYSQL_BIND                              results[4];
+  my_bool                                 is_null[4] = {0};
+  uint64_t                                sqn = 0;
+  int                                     status;
+  int                                     i;
 
-  if (db_desc->db_conn == NULL) {
+  if (db_desc == NULL) {
     return EINVAL;
   }
 
@@ -512,39 +734,41 @@ hss_mysql_auth_info (
     return EINVAL;
   }
 
-  sprintf (query, "SELECT `key`,`sqn`,`rand`,`OPc` FROM `users` WHERE `users`.`imsi`='%s' ", auth_info_req->imsi);
-  FPRINTF_DEBUG ("Query: %s\n", query);
-  pthread_mutex_lock (&db_desc->db_cs_mutex);
+  db_bind_string (&params[0], auth_info_req->imsi);
+  db_bind (&results[0], MYSQL_TYPE_BLOB, auth_info_resp->key, KEY_LENGTH);
+  db_bind (&results[1], MYSQL_TYPE_LONGLONG, &sqn, sizeof (sqn));
+  results[1].is_unsigned = 1;
+  db_bind (&results[2], MYSQL_TYPE_BLOB, auth_info_resp->rand, RAND_LENGTH);
+  db_bind (&results[3], MYSQL_TYPE_BLOB, auth_info_resp->opc, KEY_LENGTH);
 
-  if (mysql_query (db_desc->db_conn, query)) {
-    pthread_mutex_unlock (&db_desc->db_cs_mutex);
-    FPRINTF_ERROR ("Query execution failed: %s\n", mysql_error (db_desc->db_conn));
-    return EINVAL;
+  for (i = 0; i < 4; i++) {
+    results[i].is_null = &is_null[i];
   }
 
-  res = mysql_store_result (db_desc->db_conn);
-  pthread_mutex_unlock (&db_desc->db_cs_mutex);
+  if ((connection_p = hss_mysql_get_connection ()) == NULL) {
+    return EINVAL;
+  }
 
-  if ( res == NULL )
+  if ((stmt = hss_mysql_execute (connection_p, DB_STMT_AUTH_INFO, params, results)) == NULL) {
+    hss_mysql_release_connection (connection_p);
     return EINVAL;
+  }
 
-  ret = 0;
+  status = mysql_stmt_fetch (stmt);
+  mysql_stmt_free_result (stmt);
+  hss_mysql_release_connection (connection_p);
 
-  if ((row = mysql_fetch_row (res)) != NULL) {
-    if (row[0] == NULL || row[1] == NULL || row[2] == NULL || row[3] == NULL) {
+  if ((status == 0) || (status == MYSQL_DATA_TRUNCATED)) {
+    if (is_null[0] || is_null[1] || is_null[2] || is_null[3]) {
       ret = EINVAL;
     }
 
-    if (row[0] != NULL) {
-      print_buffer ("Key: ", (uint8_t *) row[0], KEY_LENGTH);
-      memcpy (auth_info_resp->key, row[0], KEY_LENGTH);
+    if (!is_null[0]) {
+      print_buffer ("Key: ", auth_info_resp->key, KEY_LENGTH);
     }
 
-    if (row[1] != NULL) {
-      uint64_t                                sqn = 0;
-
-      sqn = atoll (row[1]);
-      printf ("Received SQN %s converted to %" PRIu64 "\n", row[1], sqn);
+    if (!is_null[1]) {
+      printf ("Received SQN %" PRIu64 "\n", sqn);
       auth_info_resp->sqn[0] = (sqn & (255UL << 40)) >> 40;
       auth_info_resp->sqn[1] = (sqn & (255UL << 32)) >> 32;
       auth_info_resp->sqn[2] = (sqn & (255UL << 24)) >> 24;
@@ -554,135 +778,19 @@ hss_mysql_auth_info (
       print_buffer ("SQN: ", auth_info_resp->sqn, SQN_LENGTH);
     }
 
-    if (row[2] != NULL) {
-      print_buffer ("RAND: ", (uint8_t *) row[2], RAND_LENGTH);
-      memcpy (auth_info_resp->rand, row[2], RAND_LENGTH);
+    if (!is_null[2]) {
+      print_buffer ("RAND: ", auth_info_resp->rand, RAND_LENGTH);
     }
 
-    if (row[3] != NULL) {
-      print_buffer ("OPc: ", (uint8_t *) row[3], KEY_LENGTH);
-      memcpy (auth_info_resp->opc, row[3], KEY_LENGTH);
-    }
-
-  }
-
-  mysql_free_result (res);
-  return ret;
-}
-
-int
-hss_mysql_check_opc_keys (
-  const uint8_t const opP[16])
-{
-  int                                     ret = 0;
-  MYSQL_RES                              *res = NULL;
-  MYSQL_RES                              *res2 = NULL;
-  MYSQL_ROW                               row;
-  char                                    query[1000];
-  char                                    update[1000];
-  uint8_t                                 k[16];
-  uint8_t                                 opc[16];
-  int                                     update_length = 0;
-  int                                     status = 0;
-  int                                     i;
-
-  if (db_desc->db_conn == NULL) {
-    return EINVAL;
-  }
-
-  sprintf (query, "SELECT `imsi`,`key`,`OPc` FROM `users` ");
-  FPRINTF_DEBUG ("Query: %s\n", query);
-  pthread_mutex_lock (&db_desc->db_cs_mutex);
-
-  if (mysql_query (db_desc->db_conn, query)) {
-    pthread_mutex_unlock (&db_desc->db_cs_mutex);
-    FPRINTF_ERROR ( "Query execution failed: %s\n", mysql_error (db_desc->db_conn));
-    mysql_thread_end ();
-    return EINVAL;
-  }
-
-  res = mysql_store_result (db_desc->db_conn);
-  pthread_mutex_unlock (&db_desc->db_cs_mutex);
-
-  while ((row = mysql_fetch_row (res))) {
-    if (row[0] == NULL || row[1] == NULL) {
-      FPRINTF_ERROR ( "Query execution failed: %s\n", mysql_error (db_desc->db_conn));
-      ret = EINVAL;
-    } else {
-      if (row[0] != NULL) {
-        printf ("IMSI: %s", (uint8_t *) row[0]);
-      }
-
-      if (row[1] != NULL) {
-        print_buffer ("Key: ", (uint8_t *) row[1], KEY_LENGTH);
-        memcpy (k, row[1], KEY_LENGTH);
-      }
-      //if (row[3] != NULL)
-      {
-        print_buffer ("OPc: ", (uint8_t *) row[2], KEY_LENGTH);
-        //} else {
-        ComputeOPc (k, opP, opc);
-        update_length = sprintf (update, "UPDATE `users` SET `OPc`=UNHEX('");
-
-        for (i = 0; i < KEY_LENGTH; i++) {
-          update_length += sprintf (&update[update_length], "%02x", opc[i]);
-        }
-
-        update_length += sprintf (&update[update_length], "') WHERE `users`.`imsi`='%s'", (uint8_t *) row[0]);
-        FPRINTF_DEBUG ("Query: %s\n", update);
-
-        if (mysql_query (db_desc->db_conn, update)) {
-          FPRINTF_ERROR ( "Query execution failed: %s\n", mysql_error (db_desc->db_conn));
-        } else {
-          printf ("IMSI %s Updated OPc ", (uint8_t *) row[0]);
-
-          for (i = 0; i < KEY_LENGTH; i++) {
-            printf ("%02x", (uint8_t) (row[2][i]));
-          }
-
-          printf (" -> ");
-
-          for (i = 0; i < KEY_LENGTH; i++) {
-            printf ("%02x", opc[i]);
-          }
-
-          printf ("\n");
-
-          /*
-           * process each statement result
-           */
-          do {
-            /*
-             * did current statement return data?
-             */
-            res2 = mysql_store_result (db_desc->db_conn);
-
-            if (res2) {
-              /*
-               * yes; process rows and free the result set
-               */
-              mysql_free_result (res2);
-            } else {            /* no result set or error */
-              if (mysql_field_count (db_desc->db_conn) == 0) {
-                FPRINTF_ERROR ( "%lld rows affected\n", mysql_affected_rows (db_desc->db_conn));
-              } else {          /* some error occurred */
-                FPRINTF_ERROR ( "Could not retrieve result set\n");
-                break;
-              }
-            }
-
-            /*
-             * more results? -1 = no, >0 = error, 0 = yes (keep looping)
-             */
-            if ((status = mysql_next_result (db_desc->db_conn)) > 0)
-              FPRINTF_ERROR ( "Could not execute statement\n");
-          } while (status == 0);
-        }
-      }
+    if (!is_null[3]) {
+      print_buffer ("OPc: ", auth_info_resp->opc, KEY_LENGTH);
     }
+  } else {
+    /*
+     * Unknown subscriber, told apart from a database error for the subscriber cache
+     */
+    ret = (status == MYSQL_NO_DATA) ? ENOENT : EINVAL;
   }
 
-  mysql_free_result (res);
-  mysql_thread_end ();
   return ret;
 }
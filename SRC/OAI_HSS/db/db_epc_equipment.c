@@ -39,49 +39,43 @@ hss_mysql_query_mmeidentity (
   const int id_mme_identity,
   mysql_mme_identity_t * mme_identity_p)
 {
-  MYSQL_RES                              *res;
-  MYSQL_ROW                               row;
-  char                                    query[1000];
-
-  if ((db_desc->db_conn == NULL) || (mme_identity_p == NULL)) {
+  db_connection_t                        *connection_p;
+  MYSQL_STMT                             *stmt;
+  MYSQL_BIND                              params[1];
+  MYSQL_BIND                              results[2];
+  int                                     id = id_mme_identity;
+  unsigned long                           lengths[2] = {0};
+  my_bool                                 is_null[2] = {1, 1};
+  int                                     status;
+
+  if ((db_desc == NULL) || (mme_identity_p == NULL)) {
     return EINVAL;
   }
 
   memset (mme_identity_p, 0, sizeof (mysql_mme_identity_t));
-  sprintf (query, "SELECT mmehost,mmerealm FROM mmeidentity WHERE " "mmeidentity.idmmeidentity='%d' ", id_mme_identity);
-  FPRINTF_DEBUG ("Query: %s\n", query);
-  pthread_mutex_lock (&db_desc->db_cs_mutex);
+  db_bind (&params[0], MYSQL_TYPE_LONG, &id, sizeof (id));
+  db_bind_result_string (&results[0], mme_identity_p->mme_host, sizeof (mme_identity_p->mme_host), &lengths[0], &is_null[0]);
+  db_bind_result_string (&results[1], mme_identity_p->mme_realm, sizeof (mme_identity_p->mme_realm), &lengths[1], &is_null[1]);
 
-  if (mysql_query (db_desc->db_conn, query)) {
-    pthread_mutex_unlock (&db_desc->db_cs_mutex);
-    FPRINTF_ERROR ("Query execution failed: %s\n", mysql_error (db_desc->db_conn));
+  if ((connection_p = hss_mysql_get_connection ()) == NULL) {
     return EINVAL;
   }
 
-  res = mysql_store_result (db_desc->db_conn);
-  pthread_mutex_unlock (&db_desc->db_cs_mutex);
-
-  if ( res == NULL )
+  if ((stmt = hss_mysql_execute (connection_p, DB_STMT_QUERY_MMEIDENTITY, params, results)) == NULL) {
+    hss_mysql_release_connection (connection_p);
     return EINVAL;
+  }
 
-  if ((row = mysql_fetch_row (res)) != NULL) {
-    if (row[0] != NULL) {
-      memcpy (mme_identity_p->mme_host, row[0], strlen (row[0]));
-    } else {
-      mme_identity_p->mme_host[0] = '\0';
-    }
-
-    if (row[1] != NULL) {
-      memcpy (mme_identity_p->mme_realm, row[1], strlen (row[1]));
-    } else {
-      mme_identity_p->mme_realm[0] = '\0';
-    }
+  status = mysql_stmt_fetch (stmt);
+  mysql_stmt_free_result (stmt);
+  hss_mysql_release_connection (connection_p);
 
-    mysql_free_result (res);
+  if ((status == 0) || (status == MYSQL_DATA_TRUNCATED)) {
+    db_result_string_end (mme_identity_p->mme_host, sizeof (mme_identity_p->mme_host), lengths[0], is_null[0]);
+    db_result_string_end (mme_identity_p->mme_realm, sizeof (mme_identity_p->mme_realm), lengths[1], is_null[1]);
     return 0;
   }
 
-  mysql_free_result (res);
   return EINVAL;
 }
 
@@ -89,35 +83,26 @@ int
 hss_mysql_check_epc_equipment (
   mysql_mme_identity_t * mme_identity_p)
 {
-  MYSQL_RES                              *res;
-  MYSQL_ROW                               row;
-  char                                    query[1000];
+  db_connection_t                        *connection_p;
+  MYSQL_STMT                             *stmt;
+  MYSQL_BIND                              params[1];
+  my_ulonglong                            nb_rows = 0;
 
-  if ((db_desc->db_conn == NULL) || (mme_identity_p == NULL)) {
+  if ((db_desc == NULL) || (mme_identity_p == NULL)) {
     return EINVAL;
   }
 
-  sprintf (query, "SELECT idmmeidentity FROM mmeidentity WHERE mmeidentity.mmehost='%s' ", mme_identity_p->mme_host);
-  FPRINTF_DEBUG ("Query: %s\n", query);
-  pthread_mutex_lock (&db_desc->db_cs_mutex);
+  db_bind_string (&params[0], mme_identity_p->mme_host);
 
-  if (mysql_query (db_desc->db_conn, query)) {
-    pthread_mutex_unlock (&db_desc->db_cs_mutex);
-    FPRINTF_ERROR ("Query execution failed: %s\n", mysql_error (db_desc->db_conn));
+  if ((connection_p = hss_mysql_get_connection ()) == NULL) {
     return EINVAL;
   }
 
-  res = mysql_store_result (db_desc->db_conn);
-  pthread_mutex_unlock (&db_desc->db_cs_mutex);
-
-  if ( res == NULL )
-    return EINVAL;
-
-  if ((row = mysql_fetch_row (res)) != NULL) {
-    mysql_free_result (res);
-    return 0;
+  if ((stmt = hss_mysql_execute (connection_p, DB_STMT_CHECK_EPC_EQUIPMENT, params, NULL)) != NULL) {
+    nb_rows = mysql_stmt_num_rows (stmt);
+    mysql_stmt_free_result (stmt);
   }
 
-  mysql_free_result (res);
-  return EINVAL;
+  hss_mysql_release_connection (connection_p);
+  return (nb_rows > 0) ? 0 : EINVAL;
 }
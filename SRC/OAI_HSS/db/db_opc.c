@@ -0,0 +1,298 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*
+ * OPc precomputation at HSS startup.
+ * One worker per connection of the pool reads the users table by chunks of
+ * DB_OPC_CHUNK_SIZE subscribers, ordered by IMSI, computes their OPc from the
+ * operator key and writes the ones that differ from the stored OPc by batches
+ * of DB_OPC_BATCH_SIZE. The chunks are read one at a time, the OPc computations
+ * and the updates of the workers run in parallel.
+ */
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+
+#include <mysql/mysql.h>
+
+#include "hss_config.h"
+#include "db_proto.h"
+#include "log.h"
+
+#define DB_OPC_CHUNK_SIZE 1024
+
+extern void                             ComputeOPc (
+  const uint8_t const kP[16],
+  const uint8_t const opP[16],
+  uint8_t opcP[16]);
+
+typedef struct db_opc_subscriber_s {
+  char                                    imsi[IMSI_LENGTH_MAX + 1];
+  uint8_t                                 key[KEY_LENGTH];
+  uint8_t                                 opc[KEY_LENGTH];
+  bool                                    has_opc;
+} db_opc_subscriber_t;
+
+typedef struct db_opc_scan_s {
+  const uint8_t                          *op;
+  /* Protects the fields below, held while a chunk is read */
+  pthread_mutex_t                         mutex;
+  char                                    last_imsi[IMSI_LENGTH_MAX + 1];
+  bool                                    done;
+  int                                     ret;
+  uint32_t                                nb_subscribers;
+  uint32_t                                nb_updated;
+} db_opc_scan_t;
+
+/*
+ * Reads the chunk following scan->last_imsi, returns its number of subscribers
+ * or -1 on error. The scan mutex must be held.
+ */
+static int
+db_opc_read_chunk (
+  db_connection_t * connection_p,
+  db_opc_scan_t * scan,
+  db_opc_subscriber_t * subscribers)
+{
+  MYSQL_STMT                             *stmt;
+  MYSQL_BIND                              params[2];
+  MYSQL_BIND                              results[3];
+  my_bool                                 is_null[3] = {0};
+  unsigned long                           imsi_length = 0;
+  unsigned long                           key_length = 0;
+  unsigned long                           opc_length = 0;
+  uint32_t                                limit = DB_OPC_CHUNK_SIZE;
+  db_opc_subscriber_t                     fetched;
+  int                                     nb_subscribers = 0;
+  int                                     status;
+
+  db_bind_string (&params[0], scan->last_imsi);
+  db_bind (&params[1], MYSQL_TYPE_LONG, &limit, sizeof (limit));
+  params[1].is_unsigned = 1;
+  memset (&fetched, 0, sizeof (fetched));
+  db_bind_result_string (&results[0], fetched.imsi, sizeof (fetched.imsi), &imsi_length, &is_null[0]);
+  db_bind (&results[1], MYSQL_TYPE_BLOB, fetched.key, KEY_LENGTH);
+  results[1].length = &key_length;
+  results[1].is_null = &is_null[1];
+  db_bind (&results[2], MYSQL_TYPE_BLOB, fetched.opc, KEY_LENGTH);
+  results[2].length = &opc_length;
+  results[2].is_null = &is_null[2];
+
+  if ((stmt = hss_mysql_execute (connection_p, DB_STMT_KEYS_CHUNK, params, results)) == NULL) {
+    return -1;
+  }
+
+  while (((status = mysql_stmt_fetch (stmt)) == 0) || (status == MYSQL_DATA_TRUNCATED)) {
+    db_result_string_end (fetched.imsi, sizeof (fetched.imsi), imsi_length, is_null[0]);
+    /*
+     * The next chunk starts after this IMSI, even if the subscriber is skipped
+     */
+    memcpy (scan->last_imsi, fetched.imsi, sizeof (scan->last_imsi));
+
+    if (is_null[1] || (key_length != KEY_LENGTH)) {
+      FPRINTF_ERROR ("IMSI %s: no valid key, OPc not computed\n", fetched.imsi);
+      scan->ret = EINVAL;
+      continue;
+    }
+
+    fetched.has_opc = !is_null[2] && (opc_length == KEY_LENGTH);
+    subscribers[nb_subscribers++] = fetched;
+  }
+
+  /*
+   * The last chunk is shorter, skipped subscribers included
+   */
+  if (mysql_stmt_num_rows (stmt) < DB_OPC_CHUNK_SIZE) {
+    scan->done = true;
+  }
+
+  mysql_stmt_free_result (stmt);
+  return nb_subscribers;
+}
+
+/*
+ * Writes up to DB_OPC_BATCH_SIZE OPc in one statement, a short batch is
+ * padded with its last subscriber.
+ */
+static int
+db_opc_push_batch (
+  db_connection_t * connection_p,
+  db_opc_subscriber_t ** batch,
+  int nb_subscribers)
+{
+  MYSQL_BIND                              params[3 * DB_OPC_BATCH_SIZE];
+  db_opc_subscriber_t                    *subscriber;
+  int                                     i;
+
+  for (i = 0; i < DB_OPC_BATCH_SIZE; i++) {
+    subscriber = batch[(i < nb_subscribers) ? i : nb_subscribers - 1];
+    db_bind_string (&params[2 * i], subscriber->imsi);
+    db_bind (&params[2 * i + 1], MYSQL_TYPE_BLOB, subscriber->opc, KEY_LENGTH);
+    db_bind_string (&params[2 * DB_OPC_BATCH_SIZE + i], subscriber->imsi);
+  }
+
+  if (hss_mysql_execute (connection_p, DB_STMT_PUSH_OPC, params, NULL) == NULL) {
+    return EINVAL;
+  }
+
+  return 0;
+}
+
+static void                            *
+db_opc_worker (
+  void *arg)
+{
+  db_opc_scan_t                          *scan = (db_opc_scan_t *) arg;
+  db_connection_t                        *connection_p;
+  db_opc_subscriber_t                    *subscribers;
+  db_opc_subscriber_t                    *batch[DB_OPC_BATCH_SIZE];
+  uint8_t                                 opc[KEY_LENGTH];
+  int                                     nb_subscribers;
+  int                                     nb_batched;
+  uint32_t                                nb_updated;
+  int                                     ret;
+  int                                     i;
+
+  if ((subscribers = malloc (DB_OPC_CHUNK_SIZE * sizeof (db_opc_subscriber_t))) == NULL) {
+    pthread_mutex_lock (&scan->mutex);
+    scan->ret = ENOMEM;
+    pthread_mutex_unlock (&scan->mutex);
+    return NULL;
+  }
+
+  connection_p = hss_mysql_get_connection ();
+
+  for (;;) {
+    pthread_mutex_lock (&scan->mutex);
+
+    if (scan->done) {
+      pthread_mutex_unlock (&scan->mutex);
+      break;
+    }
+
+    if ((nb_subscribers = db_opc_read_chunk (connection_p, scan, subscribers)) < 0) {
+      scan->ret = EINVAL;
+      scan->done = true;
+      pthread_mutex_unlock (&scan->mutex);
+      break;
+    }
+
+    pthread_mutex_unlock (&scan->mutex);
+    nb_batched = 0;
+    nb_updated = 0;
+    ret = 0;
+
+    for (i = 0; i < nb_subscribers; i++) {
+      ComputeOPc (subscribers[i].key, scan->op, opc);
+
+      if (subscribers[i].has_opc && (memcmp (subscribers[i].opc, opc, KEY_LENGTH) == 0)) {
+        continue;
+      }
+
+      FPRINTF_DEBUG ("IMSI %s: OPc %s\n", subscribers[i].imsi, subscribers[i].has_opc ? "updated" : "computed");
+      memcpy (subscribers[i].opc, opc, KEY_LENGTH);
+      batch[nb_batched++] = &subscribers[i];
+
+      if (nb_batched == DB_OPC_BATCH_SIZE) {
+        if (db_opc_push_batch (connection_p, batch, nb_batched) == 0) {
+          nb_updated += nb_batched;
+        } else {
+          ret = EINVAL;
+        }
+
+        nb_batched = 0;
+      }
+    }
+
+    if (nb_batched > 0) {
+      if (db_opc_push_batch (connection_p, batch, nb_batched) == 0) {
+        nb_updated += nb_batched;
+      } else {
+        ret = EINVAL;
+      }
+    }
+
+    pthread_mutex_lock (&scan->mutex);
+    scan->nb_subscribers += nb_subscribers;
+    scan->nb_updated += nb_updated;
+
+    if (ret != 0) {
+      scan->ret = ret;
+    }
+
+    pthread_mutex_unlock (&scan->mutex);
+  }
+
+  hss_mysql_release_connection (connection_p);
+  mysql_thread_end ();
+  free (subscribers);
+  return NULL;
+}
+
+int
+hss_mysql_check_opc_keys (
+  const uint8_t const opP[16])
+{
+  db_opc_scan_t                           scan;
+  pthread_t                              *workers;
+  int                                     nb_workers;
+  int                                     i;
+
+  if (db_desc == NULL) {
+    return EINVAL;
+  }
+
+  memset (&scan, 0, sizeof (scan));
+  scan.op = opP;
+  pthread_mutex_init (&scan.mutex, NULL);
+
+  if ((workers = calloc (db_desc->nb_connections, sizeof (pthread_t))) == NULL) {
+    pthread_mutex_destroy (&scan.mutex);
+    return ENOMEM;
+  }
+
+  for (nb_workers = 0; nb_workers < db_desc->nb_connections; nb_workers++) {
+    if (pthread_create (&workers[nb_workers], NULL, db_opc_worker, &scan) != 0) {
+      break;
+    }
+  }
+
+  /*
+   * Should not happen, but the scan needs a worker
+   */
+  if (nb_workers == 0) {
+    db_opc_worker (&scan);
+  }
+
+  for (i = 0; i < nb_workers; i++) {
+    pthread_join (workers[i], NULL);
+  }
+
+  free (workers);
+  pthread_mutex_destroy (&scan.mutex);
+  FPRINTF_NOTICE ("OPc checked for %u subscribers, %u updated, %d workers\n", scan.nb_subscribers, scan.nb_updated, nb_workers ? nb_workers : 1);
+  return scan.ret;
+}
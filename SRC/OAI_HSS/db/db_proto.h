@@ -22,6 +22,7 @@
 
 #include <stdio.h>
 #include <stdint.h>
+#include <stdbool.h>
 #include <pthread.h>
 #include <mysql/mysql.h>
 
@@ -30,15 +31,57 @@
 #ifndef DB_PROTO_H_
 #define DB_PROTO_H_
 
-typedef struct {
+/* The prepared statements of a connection, their text is in db_connector.c */
+typedef enum {
+  DB_STMT_AUTH_INFO = 0,
+  DB_STMT_ALL_AUTH_INFO,
+  DB_STMT_PUSH_RAND_SQN,
+  DB_STMT_INCREMENT_SQN,
+  DB_STMT_KEYS_CHUNK,
+  DB_STMT_PUSH_OPC,
+  DB_STMT_UPDATE_LOC,
+  DB_STMT_PUSH_MME_IDENTITY,
+  DB_STMT_PUSH_UP_LOC,
+  DB_STMT_PUSH_UP_LOC_MME,
+  DB_STMT_PURGE_UE,
+  DB_STMT_PURGE_UE_MME,
+  DB_STMT_GET_USER,
+  DB_STMT_QUERY_MMEIDENTITY,
+  DB_STMT_CHECK_EPC_EQUIPMENT,
+  DB_STMT_QUERY_PDNS,
+  DB_STMT_MAX,
+} db_stmt_t;
+
+/* Subscribers updated by one execution of DB_STMT_PUSH_OPC */
+#define DB_OPC_BATCH_SIZE 32
+
+/* MySQL 8 dropped my_bool for bool in MYSQL_BIND, MariaDB still has it */
+#if MYSQL_VERSION_ID >= 80001 && MYSQL_VERSION_ID < 100000
+typedef bool my_bool;
+#endif
+
+typedef struct db_connection_s {
   /* The mysql reference connector object */
-  MYSQL *db_conn;
+  MYSQL      *db_conn;
+  MYSQL_STMT *stmts[DB_STMT_MAX];
+
+  /* Next connection in the list of the free ones */
+  struct db_connection_s *next;
+} db_connection_t;
+
+typedef struct {
   char  *server;
   char  *user;
   char  *password;
   char  *database;
 
+  /* Pool of connections, a request takes one for the duration of its queries */
+  int              nb_connections;
+  db_connection_t *connections;
+  db_connection_t *free_connections;
+
   pthread_mutex_t db_cs_mutex;
+  pthread_cond_t  db_cs_cond;
 } database_t;
 
 extern database_t *db_desc;
@@ -164,6 +207,27 @@ typedef mysql_mme_identity_t mysql_pu_ans_t;
 
 int hss_mysql_connect(const hss_config_t *hss_config_p);
 
+db_connection_t *hss_mysql_get_connection(void);
+
+void hss_mysql_release_connection(db_connection_t *connection_p);
+
+MYSQL_STMT *hss_mysql_execute(db_connection_t *connection_p,
+                              db_stmt_t        stmt_id,
+                              MYSQL_BIND      *params,
+                              MYSQL_BIND      *results);
+
+/* Parameters and results of the prepared statements */
+void db_bind(MYSQL_BIND *bind, enum enum_field_types type,
+             void *buffer, unsigned long buffer_length);
+
+void db_bind_string(MYSQL_BIND *bind, const char *string);
+
+void db_bind_result_string(MYSQL_BIND *bind, char *string, unsigned long size,
+                           unsigned long *length, my_bool *is_null);
+
+void db_result_string_end(char *string, unsigned long size,
+                          unsigned long length, my_bool is_null);
+
 void hss_mysql_disconnect(void);
 
 int hss_mysql_get_user(const char *imsi);
@@ -187,11 +251,32 @@ int hss_mysql_query_pdns(const char   *imsi,
 int hss_mysql_auth_info(mysql_auth_info_req_t  *auth_info_req,
                         mysql_auth_info_resp_t *auth_info_resp);
 
+int hss_mysql_query_auth_info(mysql_auth_info_req_t  *auth_info_req,
+                              mysql_auth_info_resp_t *auth_info_resp);
+
 int hss_mysql_push_rand_sqn(const char *imsi, uint8_t *rand_p, uint8_t *sqn);
 
+int hss_mysql_store_rand_sqn(db_connection_t *connection_p, const char *imsi,
+                             const uint8_t *rand_p, const uint8_t *sqn);
+
 int hss_mysql_increment_sqn(const char *imsi);
 
+/* OPc precomputation at startup, see db_opc.c */
 int hss_mysql_check_opc_keys(const uint8_t const opP[16]);
 
+/* Subscriber cache, serves the AIR without database round trip, see db_cache.c */
+int hss_cache_init(const hss_config_t *hss_config_p);
+
+void hss_cache_exit(void);
+
+bool hss_cache_is_enabled(void);
+
+int hss_cache_auth_info(mysql_auth_info_req_t  *auth_info_req,
+                        mysql_auth_info_resp_t *auth_info_resp);
+
+int hss_cache_push_rand_sqn(const char *imsi, const uint8_t *rand_p, const uint8_t *sqn);
+
+int hss_cache_increment_sqn(const char *imsi);
+
 
 #endif /* DB_PROTO_H_ */
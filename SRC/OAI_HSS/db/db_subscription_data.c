@@ -40,12 +40,20 @@ hss_mysql_query_pdns (
   uint8_t * nb_pdns)
 {
   int                                     ret;
-  MYSQL_RES                              *res = NULL;
-  MYSQL_ROW                               row;
-  char                                    query[1000];
+  db_connection_t                        *connection_p;
+  MYSQL_STMT                             *stmt;
+  MYSQL_BIND                              params[1];
+  MYSQL_BIND                              results[10];
+  unsigned long                           lengths[10] = {0};
+  my_bool                                 is_null[10] = {0};
   mysql_pdn_t                            *pdn_array = NULL;
+  mysql_pdn_t                             pdn;  /* Row being fetched */
+  char                                    pdn_type[16];
+  char                                    pre_emp_cap[16];
+  char                                    pre_emp_vul[16];
+  int                                     status;
 
-  if (db_desc->db_conn == NULL) {
+  if (db_desc == NULL) {
     return EINVAL;
   }
 
@@ -53,29 +61,37 @@ hss_mysql_query_pdns (
     return EINVAL;
   }
 
-  sprintf (query, "SELECT * FROM `pdn` WHERE " "`pdn`.`users_imsi`=%s LIMIT 10; ", imsi);
-  FPRINTF_DEBUG ("Query: %s\n", query);
-  pthread_mutex_lock (&db_desc->db_cs_mutex);
-
-  if (mysql_query (db_desc->db_conn, query)) {
-    pthread_mutex_unlock (&db_desc->db_cs_mutex);
-    fprintf (stderr, "Query execution failed: %s\n", mysql_error (db_desc->db_conn));
+  memset (&pdn, 0, sizeof (mysql_pdn_t));
+  db_bind_string (&params[0], imsi);
+  db_bind_result_string (&results[0], pdn.apn, sizeof (pdn.apn), &lengths[0], &is_null[0]);
+  db_bind_result_string (&results[1], pdn_type, sizeof (pdn_type), &lengths[1], &is_null[1]);
+  db_bind_result_string (&results[2], pdn.pdn_address.ipv4_address, sizeof (pdn.pdn_address.ipv4_address), &lengths[2], &is_null[2]);
+  db_bind_result_string (&results[3], pdn.pdn_address.ipv6_address, sizeof (pdn.pdn_address.ipv6_address), &lengths[3], &is_null[3]);
+  db_bind (&results[4], MYSQL_TYPE_LONG, &pdn.aggr_ul, sizeof (pdn.aggr_ul));
+  results[4].is_unsigned = 1;
+  db_bind (&results[5], MYSQL_TYPE_LONG, &pdn.aggr_dl, sizeof (pdn.aggr_dl));
+  results[5].is_unsigned = 1;
+  db_bind (&results[6], MYSQL_TYPE_TINY, &pdn.qci, sizeof (pdn.qci));
+  results[6].is_unsigned = 1;
+  db_bind (&results[7], MYSQL_TYPE_TINY, &pdn.priority_level, sizeof (pdn.priority_level));
+  results[7].is_unsigned = 1;
+  db_bind_result_string (&results[8], pre_emp_cap, sizeof (pre_emp_cap), &lengths[8], &is_null[8]);
+  db_bind_result_string (&results[9], pre_emp_vul, sizeof (pre_emp_vul), &lengths[9], &is_null[9]);
+
+  if ((connection_p = hss_mysql_get_connection ()) == NULL) {
     return EINVAL;
   }
 
-  res = mysql_store_result (db_desc->db_conn);
-  pthread_mutex_unlock (&db_desc->db_cs_mutex);
-
-  if ( res == NULL )
+  if ((stmt = hss_mysql_execute (connection_p, DB_STMT_QUERY_PDNS, params, results)) == NULL) {
+    hss_mysql_release_connection (connection_p);
     return EINVAL;
+  }
 
   *nb_pdns = 0;
 
-  while ((row = mysql_fetch_row (res)) != NULL) {
+  while (((status = mysql_stmt_fetch (stmt)) == 0) || (status == MYSQL_DATA_TRUNCATED)) {
     mysql_pdn_t                            *pdn_elm;    /* Local PDN element in array */
-    unsigned long                          *lengths;
 
-    lengths = mysql_fetch_lengths (res);
     *nb_pdns += 1;
 
     if (*nb_pdns == 1) {
@@ -100,52 +116,51 @@ hss_mysql_query_pdns (
      * Copying the APN
      */
     memset (pdn_elm, 0, sizeof (mysql_pdn_t));
-    memcpy (pdn_elm->apn, row[1], lengths[1]);
+    db_result_string_end (pdn.apn, sizeof (pdn.apn), lengths[0], is_null[0]);
+    memcpy (pdn_elm->apn, pdn.apn, sizeof (pdn.apn));
+    db_result_string_end (pdn_type, sizeof (pdn_type), lengths[1], is_null[1]);
+    db_result_string_end (pdn.pdn_address.ipv4_address, sizeof (pdn.pdn_address.ipv4_address), lengths[2], is_null[2]);
+    db_result_string_end (pdn.pdn_address.ipv6_address, sizeof (pdn.pdn_address.ipv6_address), lengths[3], is_null[3]);
 
     /*
      * PDN Type + PDN address
      */
-    if (strcmp (row[2], "IPv6") == 0) {
+    if (strcmp (pdn_type, "IPv6") == 0) {
       pdn_elm->pdn_type = IPV6;
-      memcpy (pdn_elm->pdn_address.ipv6_address, row[4], lengths[4]);
-      pdn_elm->pdn_address.ipv6_address[lengths[4]] = '\0';
-    } else if (strcmp (row[2], "IPv4v6") == 0) {
+      memcpy (pdn_elm->pdn_address.ipv6_address, pdn.pdn_address.ipv6_address, sizeof (pdn.pdn_address.ipv6_address));
+    } else if (strcmp (pdn_type, "IPv4v6") == 0) {
       pdn_elm->pdn_type = IPV4V6;
-      memcpy (pdn_elm->pdn_address.ipv4_address, row[3], lengths[3]);
-      pdn_elm->pdn_address.ipv4_address[lengths[3]] = '\0';
-      memcpy (pdn_elm->pdn_address.ipv6_address, row[4], lengths[4]);
-      pdn_elm->pdn_address.ipv6_address[lengths[4]] = '\0';
-    } else if (strcmp (row[2], "IPv4_or_IPv6") == 0) {
+      pdn_elm->pdn_address = pdn.pdn_address;
+    } else if (strcmp (pdn_type, "IPv4_or_IPv6") == 0) {
       pdn_elm->pdn_type = IPV4_OR_IPV6;
-      memcpy (pdn_elm->pdn_address.ipv4_address, row[3], lengths[3]);
-      pdn_elm->pdn_address.ipv4_address[lengths[3]] = '\0';
-      memcpy (pdn_elm->pdn_address.ipv6_address, row[4], lengths[4]);
-      pdn_elm->pdn_address.ipv6_address[lengths[4]] = '\0';
+      pdn_elm->pdn_address = pdn.pdn_address;
     } else {
       pdn_elm->pdn_type = IPV4;
-      memcpy (pdn_elm->pdn_address.ipv4_address, row[3], lengths[3]);
-      pdn_elm->pdn_address.ipv4_address[lengths[3]] = '\0';
+      memcpy (pdn_elm->pdn_address.ipv4_address, pdn.pdn_address.ipv4_address, sizeof (pdn.pdn_address.ipv4_address));
     }
 
-    pdn_elm->aggr_ul = atoi (row[5]);
-    pdn_elm->aggr_dl = atoi (row[6]);
-    pdn_elm->qci = atoi (row[9]);
-    pdn_elm->priority_level = atoi (row[10]);
+    pdn_elm->aggr_ul = pdn.aggr_ul;
+    pdn_elm->aggr_dl = pdn.aggr_dl;
+    pdn_elm->qci = pdn.qci;
+    pdn_elm->priority_level = pdn.priority_level;
+    db_result_string_end (pre_emp_cap, sizeof (pre_emp_cap), lengths[8], is_null[8]);
+    db_result_string_end (pre_emp_vul, sizeof (pre_emp_vul), lengths[9], is_null[9]);
 
-    if (strcmp (row[11], "ENABLED") == 0) {
+    if (strcmp (pre_emp_cap, "ENABLED") == 0) {
       pdn_elm->pre_emp_cap = 0;
     } else {
       pdn_elm->pre_emp_cap = 1;
     }
 
-    if (strcmp (row[12], "DISABLED") == 0) {
+    if (strcmp (pre_emp_vul, "DISABLED") == 0) {
       pdn_elm->pre_emp_vul = 1;
     } else {
       pdn_elm->pre_emp_vul = 0;
     }
   }
 
-  mysql_free_result (res);
+  mysql_stmt_free_result (stmt);
+  hss_mysql_release_connection (connection_p);
 
   /*
    * We did not find any APN for the requested IMSI
@@ -166,6 +181,7 @@ err:
   pdn_array = NULL;
   *pdns_p = pdn_array;
   *nb_pdns = 0;
-  mysql_free_result (res);
+  mysql_stmt_free_result (stmt);
+  hss_mysql_release_connection (connection_p);
   return ret;
 }
@@ -35,6 +35,7 @@
 #include "db_proto.h"
 #include "s6a_proto.h"
 #include "auc.h"
+#include "log.h"
 #include "pid_file.h"
 
 hss_config_t                            hss_config;
@@ -107,11 +108,16 @@ main (
   }
 
   random_init ();
+  FPRINTF_NOTICE ("Milenage block cipher: %s\n", RijndaelInit (true) ? "AES-NI" : "table driven AES");
 
   if (hss_config.valid_op) {
     hss_mysql_check_opc_keys ((uint8_t *) hss_config.operator_key_bin);
   }
 
+  if (hss_cache_init (&hss_config) != 0) {
+    return -1;
+  }
+
   s6a_init (&hss_config);
 
   while (1) {
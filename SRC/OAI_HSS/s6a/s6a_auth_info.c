@@ -43,6 +43,31 @@
 
 #define AUTH_MAX_EUTRAN_VECTORS 6
 
+/*
+ * SQN of the vector at index in a batch: the vectors of a batch are used one
+ * after the other by the MME, each one needs its own SQN, increased as
+ * hss_mysql_increment_sqn() does.
+ */
+static void
+s6a_auth_info_vector_sqn (
+  const uint8_t sqn[6],
+  int index,
+  uint8_t vector_sqn[6])
+{
+  uint64_t                                value = 0;
+
+  for (int i = 0; i < 6; i++) {
+    value = (value << 8) | sqn[i];
+  }
+
+  value += (uint64_t) index * 32;
+
+  for (int i = 5; i >= 0; i--) {
+    vector_sqn[i] = value & 0xFF;
+    value >>= 8;
+  }
+}
+
 int
 s6a_auth_info_cb (
   struct msg **msg,
@@ -74,7 +99,9 @@ s6a_auth_info_cb (
   uint64_t                                imsi = 0;
   uint32_t                                num_vectors = 0;
   uint8_t                                *sqn = NULL,
-    *auts = NULL;
+    *auts = NULL,
+    *resync_rand = NULL;
+  uint8_t                                 vector_sqn[6];
 
   if (msg == NULL) {
     return EINVAL;
@@ -141,7 +168,7 @@ s6a_auth_info_cb (
       switch (hdr->avp_code) {
       case AVP_CODE_NUMBER_OF_REQ_VECTORS:{
           /*
-           * We allow only one vector request
+           * Up to AUTH_MAX_EUTRAN_VECTORS vectors, see s6a_auth_info_vector_sqn()
            */
           if (hdr->avp_value->u32 > AUTH_MAX_EUTRAN_VECTORS) {
             result_code = ER_DIAMETER_INVALID_AVP_VALUE;
@@ -162,10 +189,20 @@ s6a_auth_info_cb (
 
         /*
          * The resynchronization-info AVP is present.
-         * * * * AUTS = Conc(SQN MS ) || MAC-S
+         * * * * RAND || AUTS with AUTS = Conc(SQN MS ) || MAC-S
+         * * * * Older MMEs only send the AUTS, fall back to the RAND in database.
          */
         if (avp) {
-          auts = hdr->avp_value->os.data;
+          if (hdr->avp_value->os.len == RAND_LENGTH_OCTETS + AUTS_LENGTH_OCTETS) {
+            resync_rand = hdr->avp_value->os.data;
+            auts = hdr->avp_value->os.data + RAND_LENGTH_OCTETS;
+          } else if (hdr->avp_value->os.len == AUTS_LENGTH_OCTETS) {
+            auts = hdr->avp_value->os.data;
+          } else {
+            result_code = ER_DIAMETER_INVALID_AVP_VALUE;
+            failed_avp = child_avp;
+            goto out;
+          }
         }
 
         break;
@@ -246,9 +283,10 @@ s6a_auth_info_cb (
 
   if (auts != NULL) {
     /*
-     * Try to derive SQN_MS from previous RAND
+     * Try to derive SQN_MS from the RAND the UE answered to, the database
+     * only holds the RAND of the last generated vector.
      */
-    sqn = sqn_ms_derive (auth_info_resp.opc, auth_info_resp.key, auts, auth_info_resp.rand);
+    sqn = sqn_ms_derive (auth_info_resp.opc, auth_info_resp.key, auts, resync_rand ? resync_rand : auth_info_resp.rand);
 
     if (sqn != NULL) {
       /*
@@ -275,28 +313,34 @@ s6a_auth_info_cb (
       goto out;
     }
 
-    sqn = auth_info_resp.sqn;
     for (int i = 0; i < num_vectors; i++) {
       generate_random (vector[i].rand, RAND_LENGTH);
-      generate_vector (auth_info_resp.opc, imsi, auth_info_resp.key, hdr->avp_value->os.data, sqn, &vector[i]);
+      s6a_auth_info_vector_sqn (auth_info_resp.sqn, i, vector_sqn);
+      generate_vector (auth_info_resp.opc, imsi, auth_info_resp.key, hdr->avp_value->os.data, vector_sqn, &vector[i]);
     }
-    hss_mysql_push_rand_sqn (auth_info_req.imsi, vector[num_vectors-1].rand, sqn);
   } else {
     /*
      * Pick a new RAND and store SQN_MS + RAND in the HSS
      */
     for (int i = 0; i < num_vectors; i++) {
       generate_random (vector[i].rand, RAND_LENGTH);
-      sqn = auth_info_resp.sqn;
+      s6a_auth_info_vector_sqn (auth_info_resp.sqn, i, vector_sqn);
       /*
        * Generate authentication vector
        */
-      generate_vector (auth_info_resp.opc, imsi, auth_info_resp.key, hdr->avp_value->os.data, sqn, &vector[i]);
+      generate_vector (auth_info_resp.opc, imsi, auth_info_resp.key, hdr->avp_value->os.data, vector_sqn, &vector[i]);
     }
-    hss_mysql_push_rand_sqn (auth_info_req.imsi, vector[num_vectors-1].rand, sqn);
   }
 
-  hss_mysql_increment_sqn (auth_info_req.imsi);
+  /*
+   * The SQN of the vectors must be stored before they are sent
+   */
+  if ((hss_mysql_push_rand_sqn (auth_info_req.imsi, vector[num_vectors - 1].rand, vector_sqn) != 0) || (hss_mysql_increment_sqn (auth_info_req.imsi) != 0)) {
+    result_code = DIAMETER_AUTHENTICATION_DATA_UNAVAILABLE;
+    experimental = 1;
+    goto out;
+  }
+
   /*
    * We add the vector
    */
@@ -0,0 +1,93 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "auc.h"
+
+/* Cost of the Milenage functions of the AuC, per core, with the table driven
+ * AES and with AES-NI when the CPU has it: one AES block, the f1..f5 of an
+ * authentication vector and the f5*, f1* of a resynchronisation.
+ * usage: auc_benchmark [nb_iterations]
+ */
+
+#define DEFAULT_NB_ITERATIONS (1000 * 1000)
+
+typedef enum {
+  BENCH_AES_BLOCK,
+  BENCH_VECTOR,
+  BENCH_RESYNC,
+} bench_algo_t;
+
+static double
+elapsed_ns (
+  struct timespec *start)
+{
+  struct timespec                         end;
+
+  clock_gettime (CLOCK_MONOTONIC, &end);
+  return (double)(end.tv_sec - start->tv_sec) * 1e9 + (double)(end.tv_nsec - start->tv_nsec);
+}
+
+static void
+bench (
+  const char *label,
+  bench_algo_t algo,
+  uint32_t nb_iterations)
+{
+  static const uint8_t                    key[16] = {0x46, 0x5b, 0x5c, 0xe8, 0xb1, 0x99, 0xb4, 0x9f, 0xaa, 0x5f, 0x0a, 0x2e, 0xe2, 0x38, 0xa6, 0xbc};
+  static const uint8_t                    opc[16] = {0xcd, 0x63, 0xcb, 0x71, 0x95, 0x4a, 0x9f, 0x4e, 0x48, 0xa5, 0x99, 0x4e, 0x37, 0xa0, 0x2b, 0xaf};
+  uint8_t                                 rand[16] = {0x23, 0x55, 0x3c, 0xbe, 0x96, 0x37, 0xa8, 0x9d, 0x21, 0x8a, 0xe6, 0x4d, 0xae, 0x47, 0xbf, 0x35};
+  uint8_t                                 sqn[6] = {0xff, 0x9b, 0xb4, 0xd0, 0xb6, 0x07};
+  uint8_t                                 amf[2] = {0x80, 0x00};
+  uint8_t                                 mac[8], res[8], ck[16], ik[16], ak[6];
+  rijndael_ctx_t                          ctx;
+  struct timespec                         start;
+  double                                  ns;
+
+  RijndaelKeySchedule (&ctx, key);
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  for (uint32_t i = 0; i < nb_iterations; i++) {
+    rand[0] = (uint8_t) i;
+    switch (algo) {
+    case BENCH_AES_BLOCK:
+      RijndaelEncrypt (&ctx, rand, rand);
+      break;
+    case BENCH_VECTOR:
+      f12345 (opc, key, rand, sqn, amf, mac, res, ck, ik, ak);
+      break;
+    case BENCH_RESYNC:
+      f5star (opc, key, rand, ak);
+      f1star (opc, key, rand, sqn, amf, mac);
+      break;
+    }
+  }
+  ns = elapsed_ns (&start);
+  printf ("%-26s: %8.1f ns, %10.0f /s/core\n", label, ns / nb_iterations, nb_iterations * 1e9 / ns);
+}
+
+int
+main (
+  int argc,
+  char *argv[])
+{
+  uint32_t                                nb_iterations = DEFAULT_NB_ITERATIONS;
+
+  if (argc > 1) {
+    nb_iterations = strtoul (argv[1], NULL, 0);
+  }
+
+  RijndaelInit (false);
+  bench ("tables: AES block", BENCH_AES_BLOCK, nb_iterations);
+  bench ("tables: auth vector", BENCH_VECTOR, nb_iterations);
+  bench ("tables: resync", BENCH_RESYNC, nb_iterations);
+  if (RijndaelInit (true)) {
+    bench ("AES-NI: AES block", BENCH_AES_BLOCK, nb_iterations);
+    bench ("AES-NI: auth vector", BENCH_VECTOR, nb_iterations);
+    bench ("AES-NI: resync", BENCH_RESYNC, nb_iterations);
+  } else {
+    printf ("AES-NI not available\n");
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,171 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "hss_config.h"
+#include "db_proto.h"
+
+/* Database transactions/s of the S6a procedures, issued by as many threads
+ * as freeDiameter workers, as the pool of connections grows:
+ * - AIR: hss_mysql_auth_info, hss_mysql_push_rand_sqn, hss_mysql_increment_sqn
+ * - ULR: hss_mysql_update_loc, mysql_push_up_loc, hss_mysql_query_pdns
+ * The IMSIs first_imsi..first_imsi + nb_imsis - 1 must be provisioned in the
+ * database (with their pdn), their SQN, RAND and MME identity are modified.
+ * With a SQN journal, the AIR are served by the subscriber cache.
+ * The connector traces on stdout, results are printed on stderr.
+ * usage: db_benchmark server user password database first_imsi nb_imsis [nb_transactions [SQN journal]] > /dev/null
+ */
+
+#define DEFAULT_NB_TRANSACTIONS (20 * 1000)
+#define NB_THREADS              16
+
+typedef enum {
+  BENCH_AIR,
+  BENCH_ULR,
+} bench_procedure_t;
+
+typedef struct {
+  bench_procedure_t                       procedure;
+  uint64_t                                first_imsi;
+  uint32_t                                nb_imsis;
+  uint32_t                                first_transaction;
+  uint32_t                                nb_transactions;
+  uint32_t                                nb_errors;
+} bench_thread_t;
+
+static double
+elapsed_ns (
+  struct timespec *start)
+{
+  struct timespec                         end;
+
+  clock_gettime (CLOCK_MONOTONIC, &end);
+  return (double)(end.tv_sec - start->tv_sec) * 1e9 + (double)(end.tv_nsec - start->tv_nsec);
+}
+
+static void                            *
+bench_thread (
+  void *arg)
+{
+  bench_thread_t                         *thread = (bench_thread_t *) arg;
+  mysql_auth_info_req_t                   auth_info_req;
+  mysql_auth_info_resp_t                  auth_info_resp;
+  mysql_ul_ans_t                          ul_ans;
+  mysql_ul_push_t                         ul_push;
+  mysql_pdn_t                            *pdns = NULL;
+  uint8_t                                 nb_pdns = 0;
+  uint8_t                                 rand[RAND_LENGTH] = {0};
+
+  for (uint32_t i = thread->first_transaction; i < thread->first_transaction + thread->nb_transactions; i++) {
+    snprintf (auth_info_req.imsi, sizeof (auth_info_req.imsi), "%015" PRIu64, thread->first_imsi + i % thread->nb_imsis);
+    switch (thread->procedure) {
+    case BENCH_AIR:
+      if (hss_mysql_auth_info (&auth_info_req, &auth_info_resp) != 0) {
+        thread->nb_errors++;
+        break;
+      }
+      memcpy (rand, &i, sizeof (i));
+      hss_mysql_push_rand_sqn (auth_info_req.imsi, rand, auth_info_resp.sqn);
+      hss_mysql_increment_sqn (auth_info_req.imsi);
+      break;
+    case BENCH_ULR:
+      memset (&ul_ans, 0, sizeof (ul_ans));
+      memset (&ul_push, 0, sizeof (ul_push));
+      if (hss_mysql_update_loc (auth_info_req.imsi, &ul_ans) != 0) {
+        thread->nb_errors++;
+        break;
+      }
+      memcpy (ul_push.imsi, auth_info_req.imsi, sizeof (ul_push.imsi));
+      ul_push.mme_identity_present = MME_IDENTITY_PRESENT;
+      strcpy (ul_push.mme_identity.mme_host, "mme_benchmark.openair4G.eur");
+      strcpy (ul_push.mme_identity.mme_realm, "openair4G.eur");
+      mysql_push_up_loc (&ul_push);
+      if (hss_mysql_query_pdns (auth_info_req.imsi, &pdns, &nb_pdns) == 0) {
+        free (pdns);
+      }
+      break;
+    }
+  }
+  return NULL;
+}
+
+static void
+bench (
+  const char *label,
+  bench_procedure_t procedure,
+  hss_config_t * hss_config,
+  uint64_t first_imsi,
+  uint32_t nb_imsis,
+  uint32_t nb_transactions)
+{
+  bench_thread_t                          threads[NB_THREADS];
+  pthread_t                               tids[NB_THREADS];
+  struct timespec                         start;
+  uint32_t                                nb_errors = 0;
+  double                                  ns;
+
+  if ((hss_mysql_connect (hss_config) != 0) || (hss_cache_init (hss_config) != 0)) {
+    exit (EXIT_FAILURE);
+  }
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  for (int i = 0; i < NB_THREADS; i++) {
+    threads[i].procedure = procedure;
+    threads[i].first_imsi = first_imsi;
+    threads[i].nb_imsis = nb_imsis;
+    threads[i].first_transaction = i * (nb_transactions / NB_THREADS);
+    threads[i].nb_transactions = nb_transactions / NB_THREADS;
+    threads[i].nb_errors = 0;
+    pthread_create (&tids[i], NULL, bench_thread, &threads[i]);
+  }
+  for (int i = 0; i < NB_THREADS; i++) {
+    pthread_join (tids[i], NULL);
+    nb_errors += threads[i].nb_errors;
+  }
+  ns = elapsed_ns (&start);
+  hss_mysql_disconnect ();
+  fprintf (stderr, "%s, %2d connections: %8.0f transactions/s, %8.1f us/transaction, %u errors\n", label, hss_config->mysql_connections,
+           (nb_transactions / NB_THREADS) * NB_THREADS * 1e9 / ns, ns / 1e3 / (nb_transactions / NB_THREADS), nb_errors);
+}
+
+int
+main (
+  int argc,
+  char *argv[])
+{
+  hss_config_t                            hss_config = {0};
+  uint64_t                                first_imsi;
+  uint32_t                                nb_imsis;
+  uint32_t                                nb_transactions = DEFAULT_NB_TRANSACTIONS;
+  int                                     nb_connections[] = {1, 2, 4, 8, 16};
+
+  if (argc < 7) {
+    fprintf (stderr, "usage: %s server user password database first_imsi nb_imsis [nb_transactions [SQN journal]]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+  hss_config.mysql_server = argv[1];
+  hss_config.mysql_user = argv[2];
+  hss_config.mysql_password = argv[3];
+  hss_config.mysql_database = argv[4];
+  first_imsi = strtoull (argv[5], NULL, 10);
+  nb_imsis = strtoul (argv[6], NULL, 0);
+  if (argc > 7) {
+    nb_transactions = strtoul (argv[7], NULL, 0);
+  }
+  if (argc > 8) {
+    hss_config.sqn_journal = argv[8];
+  }
+
+  for (int i = 0; i < sizeof (nb_connections) / sizeof (nb_connections[0]); i++) {
+    hss_config.mysql_connections = nb_connections[i];
+    bench ("AIR", BENCH_AIR, &hss_config, first_imsi, nb_imsis, nb_transactions);
+  }
+  for (int i = 0; i < sizeof (nb_connections) / sizeof (nb_connections[0]); i++) {
+    hss_config.mysql_connections = nb_connections[i];
+    bench ("ULR", BENCH_ULR, &hss_config, first_imsi, nb_imsis, nb_transactions);
+  }
+  return EXIT_SUCCESS;
+}
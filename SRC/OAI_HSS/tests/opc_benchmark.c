@@ -0,0 +1,153 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <string.h>
+#include <time.h>
+
+#include <mysql/mysql.h>
+
+#include "hss_config.h"
+#include "db_proto.h"
+#include "auc.h"
+
+/* HSS startup time spent in hss_mysql_check_opc_keys, as the pool of
+ * connections grows, on a generated subscriber set:
+ * - compute: the OPc of the generated subscribers are NULL
+ * - check: all the OPc are valid, nothing is written
+ * The IMSIs first_imsi..first_imsi + nb_imsis - 1 are inserted in the
+ * database with random keys, then deleted. The OPc of the other subscribers
+ * of the database are checked too, use a test database.
+ * The connector traces on stdout, results are printed on stderr.
+ * usage: opc_benchmark server user password database first_imsi nb_imsis > /dev/null
+ */
+
+#define INSERT_BATCH_SIZE 1000
+
+static double
+elapsed_ns (
+  struct timespec *start)
+{
+  struct timespec                         end;
+
+  clock_gettime (CLOCK_MONOTONIC, &end);
+  return (double)(end.tv_sec - start->tv_sec) * 1e9 + (double)(end.tv_nsec - start->tv_nsec);
+}
+
+static void
+query (
+  MYSQL * db_conn,
+  const char *statement)
+{
+  if (mysql_query (db_conn, statement)) {
+    fprintf (stderr, "Query execution failed: %s\n", mysql_error (db_conn));
+    exit (EXIT_FAILURE);
+  }
+}
+
+static void
+generate_subscribers (
+  MYSQL * db_conn,
+  uint64_t first_imsi,
+  uint32_t nb_imsis)
+{
+  char                                   *statement;
+  size_t                                  length;
+  uint8_t                                 key[KEY_LENGTH];
+
+  statement = malloc (64 + INSERT_BATCH_SIZE * 128);
+
+  for (uint32_t i = 0; i < nb_imsis;) {
+    length = sprintf (statement, "INSERT INTO `users` (`imsi`,`key`,`sqn`,`rand`,`OPc`) VALUES ");
+
+    for (uint32_t j = 0; (j < INSERT_BATCH_SIZE) && (i < nb_imsis); j++, i++) {
+      generate_random (key, sizeof (key));
+      length += sprintf (statement + length, "%s('%015" PRIu64 "',x'", j ? "," : "", first_imsi + i);
+
+      for (int k = 0; k < KEY_LENGTH; k++) {
+        length += sprintf (statement + length, "%02x", key[k]);
+      }
+
+      length += sprintf (statement + length, "',0,x'00000000000000000000000000000000',NULL)");
+    }
+
+    query (db_conn, statement);
+  }
+
+  free (statement);
+}
+
+static void
+bench (
+  const char *label,
+  hss_config_t * hss_config,
+  const uint8_t * op,
+  uint32_t nb_imsis)
+{
+  struct timespec                         start;
+  double                                  ns;
+  int                                     ret;
+
+  if (hss_mysql_connect (hss_config) != 0) {
+    exit (EXIT_FAILURE);
+  }
+
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  ret = hss_mysql_check_opc_keys (op);
+  ns = elapsed_ns (&start);
+  hss_mysql_disconnect ();
+  fprintf (stderr, "%-7s, %2d connections: %8.3f s, %9.0f subscribers/s%s\n", label, hss_config->mysql_connections,
+           ns / 1e9, nb_imsis * 1e9 / ns, ret ? ", errors" : "");
+}
+
+int
+main (
+  int argc,
+  char *argv[])
+{
+  hss_config_t                            hss_config = {0};
+  MYSQL                                  *db_conn;
+  char                                    statement[256];
+  uint8_t                                 op[16];
+  uint64_t                                first_imsi;
+  uint32_t                                nb_imsis;
+  int                                     nb_connections[] = {1, 2, 4, 8, 16};
+
+  if (argc < 7) {
+    fprintf (stderr, "usage: %s server user password database first_imsi nb_imsis\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+  hss_config.mysql_server = argv[1];
+  hss_config.mysql_user = argv[2];
+  hss_config.mysql_password = argv[3];
+  hss_config.mysql_database = argv[4];
+  first_imsi = strtoull (argv[5], NULL, 10);
+  nb_imsis = strtoul (argv[6], NULL, 0);
+
+  random_init ();
+  RijndaelInit (true);
+  generate_random (op, sizeof (op));
+
+  db_conn = mysql_init (NULL);
+  if (!mysql_real_connect (db_conn, hss_config.mysql_server, hss_config.mysql_user, hss_config.mysql_password, hss_config.mysql_database, 0, NULL, 0)) {
+    fprintf (stderr, "Connection failed: %s\n", mysql_error (db_conn));
+    return EXIT_FAILURE;
+  }
+  generate_subscribers (db_conn, first_imsi, nb_imsis);
+  snprintf (statement, sizeof (statement), "UPDATE `users` SET `OPc`=NULL WHERE `imsi` BETWEEN '%015" PRIu64 "' AND '%015" PRIu64 "'",
+            first_imsi, first_imsi + nb_imsis - 1);
+
+  for (int i = 0; i < sizeof (nb_connections) / sizeof (nb_connections[0]); i++) {
+    hss_config.mysql_connections = nb_connections[i];
+    query (db_conn, statement);
+    bench ("compute", &hss_config, op, nb_imsis);
+    bench ("check", &hss_config, op, nb_imsis);
+  }
+
+  snprintf (statement, sizeof (statement), "DELETE FROM `users` WHERE `imsi` BETWEEN '%015" PRIu64 "' AND '%015" PRIu64 "'",
+            first_imsi, first_imsi + nb_imsis - 1);
+  query (db_conn, statement);
+  mysql_close (db_conn);
+  return EXIT_SUCCESS;
+}
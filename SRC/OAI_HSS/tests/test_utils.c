@@ -0,0 +1,137 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under 
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.  
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "test_utils.h"
+
+static int                              error_count = 0;
+
+void
+fail (
+  const char *format,
+  ...)
+{
+  va_list                                 args;
+
+  va_start (args, format);
+  vfprintf (stderr, format, args);
+  va_end (args);
+  fprintf (stderr, "\n");
+  error_count++;
+}
+
+void
+success (
+  const char *format,
+  ...)
+{
+  va_list                                 args;
+
+  va_start (args, format);
+  vfprintf (stdout, format, args);
+  va_end (args);
+}
+
+int
+compare_buffer (
+  const uint8_t * buffer,
+  const uint32_t length_buffer,
+  const uint8_t * pattern,
+  const uint32_t length_pattern)
+{
+  if (length_buffer != length_pattern) {
+    fprintf (stderr, "Length mismatch, expecting %u bytes, got %u bytes\n", length_pattern, length_buffer);
+    return -1;
+  }
+
+  if (memcmp (buffer, pattern, length_buffer) != 0) {
+    fprintf (stderr, "Expecting: ");
+
+    for (uint32_t i = 0; i < length_pattern; i++) {
+      fprintf (stderr, "%02x", pattern[i]);
+    }
+
+    fprintf (stderr, "\nReceived:  ");
+
+    for (uint32_t i = 0; i < length_buffer; i++) {
+      fprintf (stderr, "%02x", buffer[i]);
+    }
+
+    fprintf (stderr, "\n");
+    return -1;
+  }
+
+  return 0;
+}
+
+unsigned
+decode_hex_length (
+  const char *hex)
+{
+  unsigned                                digits = 0;
+
+  for (; *hex; hex++) {
+    if (isxdigit ((unsigned char)*hex)) {
+      digits++;
+    }
+  }
+
+  return digits / 2;
+}
+
+uint8_t                                *
+decode_hex_dup (
+  const char *hex)
+{
+  uint8_t                                *buffer = calloc (1, decode_hex_length (hex) + 1);
+  unsigned                                digits = 0;
+
+  if (buffer == NULL) {
+    fail ("Allocation failed");
+    exit (EXIT_FAILURE);
+  }
+
+  for (; *hex; hex++) {
+    char                                    c = tolower ((unsigned char)*hex);
+
+    if (!isxdigit ((unsigned char)c)) {
+      continue;
+    }
+
+    buffer[digits / 2] = (buffer[digits / 2] << 4) | (uint8_t) (isdigit ((unsigned char)c) ? c - '0' : c - 'a' + 10);
+    digits++;
+  }
+
+  return buffer;
+}
+
+int
+main (
+  void)
+{
+  doit ();
+  return (error_count == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -2,9 +2,9 @@
  * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
  * contributor license agreements.  See the NOTICE file distributed with
  * this work for additional information regarding copyright ownership.
- * The OpenAirInterface Software Alliance licenses this file to You under
+ * The OpenAirInterface Software Alliance licenses this file to You under 
  * the Apache License, Version 2.0  (the "License"); you may not use this file
- * except in compliance with the License.
+ * except in compliance with the License.  
  * You may obtain a copy of the License at
  *
  *      http://www.apache.org/licenses/LICENSE-2.0
@@ -18,31 +18,31 @@
  * For more information about the OpenAirInterface (OAI) Software Alliance:
  *      contact@openairinterface.org
  */
-/*! \file gtpv1u_task.c
-  \brief
-  \author Lionel Gauthier
-  \company Eurecom
-  \email: lionel.gauthier@eurecom.fr
-*/
-#include <stdlib.h>
+
+#ifndef TEST_UTILS_H_
+#define TEST_UTILS_H_
+
 #include <stdint.h>
 
-#include "gtpv1u.h"
-
-//#define GTPV1U_LINEAR_TEID_ALLOCATION 1
-
-#if GTPV1U_LINEAR_TEID_ALLOCATION
-static uint32_t                         g_gtpv1u_teid = 0;
-#endif
-
-uint32_t
-gtpv1u_new_teid (
-  void)
-{
-#if GTPV1U_LINEAR_TEID_ALLOCATION
-  g_gtpv1u_teid = g_gtpv1u_teid + 1;
-  return g_gtpv1u_teid;
-#else
-  return random () + random () % (RAND_MAX - 1) + 1;
-#endif
-}
+/* Minimal harness of the HSS unit tests: each test provides doit(), which
+ * reports mismatches with fail(). The test exits with a failure status if
+ * fail() has been called at least once.
+ */
+void doit(void);
+
+void fail(const char *format, ...) __attribute__ ((format (printf, 1, 2)));
+void success(const char *format, ...) __attribute__ ((format (printf, 1, 2)));
+
+int compare_buffer(const uint8_t *buffer, const uint32_t length_buffer,
+                   const uint8_t *pattern, const uint32_t length_pattern);
+
+/* Hexadecimal string to buffer, blanks are skipped. The buffer is never
+ * freed, test vectors live until the end of the test.
+ */
+uint8_t *decode_hex_dup(const char *hex);
+unsigned decode_hex_length(const char *hex);
+
+#define H(x)  decode_hex_dup(x)
+#define HL(x) decode_hex_dup(x), decode_hex_length(x)
+
+#endif  /* TEST_UTILS_H_ */
@@ -43,6 +43,11 @@
 #include "hss_config.h"
 #include "log.h"
 
+#ifdef LIBCONFIG_LONG
+#  define libconfig_int long
+#else
+#  define libconfig_int int
+#endif
 
 #ifndef PACKAGE_NAME
 #  define PACKAGE_NAME "OPENAIR-HSS"
@@ -59,9 +64,13 @@
 #define HSS_CONFIG_STRING_MYSQL_USER               "MYSQL_user"
 #define HSS_CONFIG_STRING_MYSQL_PASS               "MYSQL_pass"
 #define HSS_CONFIG_STRING_MYSQL_DB                 "MYSQL_db"
+#define HSS_CONFIG_STRING_MYSQL_CONNECTIONS        "MYSQL_connections"
 #define HSS_CONFIG_STRING_OPERATOR_KEY             "OPERATOR_key"
 #define HSS_CONFIG_STRING_RANDOM                   "RANDOM"
 #define HSS_CONFIG_STRING_FREEDIAMETER_CONF_FILE   "FD_conf"
+#define HSS_CONFIG_STRING_SQN_JOURNAL              "SQN_journal"
+
+#define HSS_CONFIG_MYSQL_CONNECTIONS_DEFAULT       4
 
 
 // LG TODO fd_g_debug_lvl
@@ -191,11 +200,14 @@ hss_config_display (
   FPRINTF_NOTICE ( "\t- Database .........: %s\n", hss_config_p->mysql_database);
   FPRINTF_NOTICE ( "\t- User .............: %s\n", hss_config_p->mysql_user);
   FPRINTF_NOTICE ( "\t- Password .........: %s\n", (hss_config_p->mysql_password == NULL) ? "None" : "*****");
+  FPRINTF_NOTICE ( "\t- Connections ......: %d\n", hss_config_p->mysql_connections);
   FPRINTF_NOTICE ( "* FreeDiameter:\n");
   FPRINTF_NOTICE ( "\t- Conf file ........: %s\n", hss_config_p->freediameter_config);
   FPRINTF_NOTICE ( "* Security:\n");
   FPRINTF_NOTICE ( "\t- Operator key......: %s\n", (hss_config_p->operator_key == NULL) ? "None" : "********************************");
   FPRINTF_NOTICE ( "\t- Random      ......: %s\n", hss_config_p->random);
+  FPRINTF_NOTICE ( "* Subscriber cache:\n");
+  FPRINTF_NOTICE ( "\t- SQN journal ......: %s\n", (hss_config_p->sqn_journal == NULL) ? "None (cache disabled)" : hss_config_p->sqn_journal);
 }
 
 static int
@@ -246,6 +258,7 @@ hss_config_parse_file (
   int                                     ret = -1;
   config_t                                cfg;
   const char                             *astring = NULL;
+  libconfig_int                           aint = 0;
   config_setting_t                       *setting = NULL;
 
   if (hss_config_p == NULL) {
@@ -294,6 +307,17 @@ hss_config_parse_file (
       return ret;
     }
 
+    // optional, size of the connection pool
+    if (  (config_setting_lookup_int( setting, HSS_CONFIG_STRING_MYSQL_CONNECTIONS, &aint) )) {
+      if (aint < 1) {
+        FPRINTF_ERROR( "Error in configuration file: %s: %d (must be >= 1)\n", HSS_CONFIG_STRING_MYSQL_CONNECTIONS, (int)aint);
+        return ret;
+      }
+      hss_config_p->mysql_connections = (int)aint;
+    } else {
+      hss_config_p->mysql_connections = HSS_CONFIG_MYSQL_CONNECTIONS_DEFAULT;
+    }
+
     if (  (config_setting_lookup_string( setting, HSS_CONFIG_STRING_OPERATOR_KEY, (const char **)&astring) )) {
       hss_config_p->operator_key = strdup(astring);
     } else {
@@ -314,6 +338,11 @@ hss_config_parse_file (
       FPRINTF_ERROR( "Failed to parse HSS configuration file token %s!\n", HSS_CONFIG_STRING_FREEDIAMETER_CONF_FILE);
       return ret;
     }
+
+    // optional, the subscriber cache is enabled by its journal
+    if (  (config_setting_lookup_string( setting, HSS_CONFIG_STRING_SQN_JOURNAL, (const char **)&astring) )) {
+      hss_config_p->sqn_journal = strdup(astring);
+    }
   } else {
     FPRINTF_ERROR( "Failed to parse HSS configuration file main HSS section not found!\n");
     return ret;
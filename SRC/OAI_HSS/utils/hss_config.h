@@ -27,7 +27,11 @@ typedef struct hss_config_s {
   char *mysql_user;
   char *mysql_password;
   char *mysql_database;
+  /* Number of connections to the database, each one serves one request at a time */
+  int   mysql_connections;
 
+  /* Journal of the SQN updates of the subscriber cache, no cache if NULL */
+  char *sqn_journal;
 
   char *operator_key;
   unsigned char operator_key_bin[16];
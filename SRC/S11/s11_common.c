@@ -25,6 +25,7 @@
 
 #include "NwGtpv2c.h"
 #include "s11_common.h"
+#include "teid_pool.h"
 #include "log.h"
 
 NwRcT
@@ -38,3 +39,36 @@ s11_ie_indication_generic (
   OAILOG_DEBUG (LOG_S11, "Received IE Parse Indication for of type %u, length %u, " "instance %u!\n", ieType, ieLength, ieInstance);
   return NW_OK;
 }
+
+//------------------------------------------------------------------------------
+uint32_t
+s11_steer (
+  const uint8_t * buffer,
+  uint32_t length,
+  uint32_t nb_shards)
+{
+  const uint8_t                          *seq_num_p = &buffer[4];
+  uint32_t                                teid;
+
+  /*
+   * A message with a local TEID goes to the shard owning the TEID. The
+   * responses without TEID go to the shard which sent the request, its
+   * sequence numbers are partitioned, the initial requests without TEID
+   * are spread the same way.
+   */
+  if (length < 8) {
+    return 0;
+  }
+  if (buffer[0] & 0x08) {
+    if (length < 12) {
+      return 0;
+    }
+    teid = ((uint32_t)buffer[4] << 24) | ((uint32_t)buffer[5] << 16) | ((uint32_t)buffer[6] << 8) | buffer[7];
+    if (teid != 0) {
+      return teid_pool_shard (teid, teid_pool_shard_bits (nb_shards));
+    }
+    seq_num_p = &buffer[8];
+  }
+  // the sequence number is on 3 bytes, nb_shards is a power of 2 up to 256
+  return seq_num_p[2] & (nb_shards - 1);
+}
@@ -28,4 +28,7 @@ NwRcT s11_ie_indication_generic(uint8_t  ieType,
                                 uint8_t *ieValue,
                                 void  *arg);
 
+/* Shard of a received S11 message, steering the datagrams of TASK_UDP */
+uint32_t s11_steer(const uint8_t *buffer, uint32_t length, uint32_t nb_shards);
+
 #endif /* FILE_S11_COMMON_SEEN */
@@ -91,16 +91,16 @@ s11_imsi_ie_set (
    * In case of odd/even imsi
    */
   imsi_length = imsi->length % 2 == 0 ? imsi->length / 2 : imsi->length / 2 + 1;
-  temp = calloc (imsi_length, sizeof (uint8_t));
-  DevAssert (temp );
+  rc = nwGtpv2cMsgAddIeReserve (*msg, NW_GTPV2C_IE_IMSI, 0, imsi_length, &temp);
+  DevAssert (NW_OK == rc);
+  memset (temp, 0, imsi_length);
 
   for (i = 0; i < imsi->length; i++) {
     temp[i / 2] |= ((imsi->digit[i] - '0') & 0x0F) << (i % 2 ? 4 : 0);
   }
 
-  rc = nwGtpv2cMsgAddIe (*msg, NW_GTPV2C_IE_IMSI, imsi_length, 0, temp);
+  rc = nwGtpv2cMsgAddIeCommit (*msg, imsi_length);
   DevAssert (NW_OK == rc);
-  free_wrapper ((void**) &temp);
   return RETURNok;
 }
 
@@ -448,10 +448,12 @@ s11_cause_ie_set (
   const gtp_cause_t * cause)
 {
   NwRcT                                   rc;
-  uint8_t                                 value[6];
+  uint8_t                                *value = NULL;
 
   DevAssert (msg );
   DevAssert (cause );
+  rc = nwGtpv2cMsgAddIeReserve (*msg, NW_GTPV2C_IE_CAUSE, 0, 6, &value);
+  DevAssert (NW_OK == rc);
   value[0] = cause->cause_value;
   value[1] = ((cause->pce & 0x1) << 2) | ((cause->bce & 0x1) << 1) | (cause->cs & 0x1);
 
@@ -460,9 +462,9 @@ s11_cause_ie_set (
     value[3] = (cause->offending_ie_length & 0xFF00) >> 8;
     value[4] = cause->offending_ie_length & 0x00FF;
     value[5] = cause->offending_ie_instance & 0x0F;
-    rc = nwGtpv2cMsgAddIe (*msg, NW_GTPV2C_IE_CAUSE, 6, 0, value);
+    rc = nwGtpv2cMsgAddIeCommit (*msg, 6);
   } else {
-    rc = nwGtpv2cMsgAddIe (*msg, NW_GTPV2C_IE_CAUSE, 2, 0, value);
+    rc = nwGtpv2cMsgAddIeCommit (*msg, 2);
   }
 
   DevAssert (NW_OK == rc);
@@ -516,12 +518,12 @@ s11_bearer_context_to_be_created_ie_get (
 
     switch (ie_p->t) {
     case NW_GTPV2C_IE_EBI:
-      rc = s11_ebi_ie_get (ie_p->t, ie_p->l, ie_p->i, &ieValue[read + sizeof (NwGtpv2cIeTlvT)], &bearer_context->eps_bearer_id);
+      rc = s11_ebi_ie_get (ie_p->t, ntohs (ie_p->l), ie_p->i, &ieValue[read + sizeof (NwGtpv2cIeTlvT)], &bearer_context->eps_bearer_id);
       DevAssert (NW_OK == rc);
       break;
 
     case NW_GTPV2C_IE_BEARER_LEVEL_QOS:
-      rc = s11_bearer_qos_ie_get (ie_p->t, ie_p->l, ie_p->i, &ieValue[read + sizeof (NwGtpv2cIeTlvT)], &bearer_context->bearer_level_qos);
+      rc = s11_bearer_qos_ie_get (ie_p->t, ntohs (ie_p->l), ie_p->i, &ieValue[read + sizeof (NwGtpv2cIeTlvT)], &bearer_context->bearer_level_qos);
       break;
 
     case NW_GTPV2C_IE_BEARER_TFT:
@@ -532,22 +534,22 @@ s11_bearer_context_to_be_created_ie_get (
     case NW_GTPV2C_IE_FTEID:
       switch (ie_p->i) {
         case 0:
-          rc = s11_fteid_ie_get (ie_p->t, ie_p->l, ie_p->i, &ieValue[read + sizeof (NwGtpv2cIeTlvT)], &bearer_context->s1u_enb_fteid);
+          rc = s11_fteid_ie_get (ie_p->t, ntohs (ie_p->l), ie_p->i, &ieValue[read + sizeof (NwGtpv2cIeTlvT)], &bearer_context->s1u_enb_fteid);
           break;
         case 1:
-          rc = s11_fteid_ie_get (ie_p->t, ie_p->l, ie_p->i, &ieValue[read + sizeof (NwGtpv2cIeTlvT)], &bearer_context->s4u_sgsn_fteid);
+          rc = s11_fteid_ie_get (ie_p->t, ntohs (ie_p->l), ie_p->i, &ieValue[read + sizeof (NwGtpv2cIeTlvT)], &bearer_context->s4u_sgsn_fteid);
           break;
         case 2:
-          rc = s11_fteid_ie_get (ie_p->t, ie_p->l, ie_p->i, &ieValue[read + sizeof (NwGtpv2cIeTlvT)], &bearer_context->s5_s8_u_sgw_fteid);
+          rc = s11_fteid_ie_get (ie_p->t, ntohs (ie_p->l), ie_p->i, &ieValue[read + sizeof (NwGtpv2cIeTlvT)], &bearer_context->s5_s8_u_sgw_fteid);
           break;
         case 3:
-          rc = s11_fteid_ie_get (ie_p->t, ie_p->l, ie_p->i, &ieValue[read + sizeof (NwGtpv2cIeTlvT)], &bearer_context->s5_s8_u_pgw_fteid);
+          rc = s11_fteid_ie_get (ie_p->t, ntohs (ie_p->l), ie_p->i, &ieValue[read + sizeof (NwGtpv2cIeTlvT)], &bearer_context->s5_s8_u_pgw_fteid);
           break;
         case 4:
-          rc = s11_fteid_ie_get (ie_p->t, ie_p->l, ie_p->i, &ieValue[read + sizeof (NwGtpv2cIeTlvT)], &bearer_context->s12_rnc_fteid);
+          rc = s11_fteid_ie_get (ie_p->t, ntohs (ie_p->l), ie_p->i, &ieValue[read + sizeof (NwGtpv2cIeTlvT)], &bearer_context->s12_rnc_fteid);
           break;
         case 5:
-          rc = s11_fteid_ie_get (ie_p->t, ie_p->l, ie_p->i, &ieValue[read + sizeof (NwGtpv2cIeTlvT)], &bearer_context->s2b_u_epdg_fteid);
+          rc = s11_fteid_ie_get (ie_p->t, ntohs (ie_p->l), ie_p->i, &ieValue[read + sizeof (NwGtpv2cIeTlvT)], &bearer_context->s2b_u_epdg_fteid);
           break;
         default:
           OAILOG_ERROR (LOG_S11, "Received unexpected IE %u instance %u\n", ie_p->t, ie_p->i);
@@ -641,12 +643,12 @@ s11_bearer_context_to_be_modified_ie_get (
 
     switch (ie_p->t) {
     case NW_GTPV2C_IE_EBI:
-      rc = s11_ebi_ie_get (ie_p->t, ie_p->l, ie_p->i, &ieValue[read + sizeof (NwGtpv2cIeTlvT)], &bearer_context->eps_bearer_id);
+      rc = s11_ebi_ie_get (ie_p->t, ntohs (ie_p->l), ie_p->i, &ieValue[read + sizeof (NwGtpv2cIeTlvT)], &bearer_context->eps_bearer_id);
       DevAssert (NW_OK == rc);
       break;
 
     case NW_GTPV2C_IE_FTEID:
-      rc = s11_fteid_ie_get (ie_p->t, ie_p->l, ie_p->i, &ieValue[read + sizeof (NwGtpv2cIeTlvT)], &bearer_context->s1_eNB_fteid);
+      rc = s11_fteid_ie_get (ie_p->t, ntohs (ie_p->l), ie_p->i, &ieValue[read + sizeof (NwGtpv2cIeTlvT)], &bearer_context->s1_eNB_fteid);
       break;
 
     default:
@@ -683,16 +685,16 @@ s11_bearer_context_created_ie_get (
 
     switch (ie_p->t) {
     case NW_GTPV2C_IE_EBI:
-      rc = s11_ebi_ie_get (ie_p->t, ie_p->l, ie_p->i, &ieValue[read + sizeof (NwGtpv2cIeTlvT)], &bearer_context->eps_bearer_id);
+      rc = s11_ebi_ie_get (ie_p->t, ntohs (ie_p->l), ie_p->i, &ieValue[read + sizeof (NwGtpv2cIeTlvT)], &bearer_context->eps_bearer_id);
       DevAssert (NW_OK == rc);
       break;
 
     case NW_GTPV2C_IE_FTEID:
-      rc = s11_fteid_ie_get (ie_p->t, ie_p->l, ie_p->i, &ieValue[read + sizeof (NwGtpv2cIeTlvT)], &bearer_context->s1u_sgw_fteid);
+      rc = s11_fteid_ie_get (ie_p->t, ntohs (ie_p->l), ie_p->i, &ieValue[read + sizeof (NwGtpv2cIeTlvT)], &bearer_context->s1u_sgw_fteid);
       break;
 
     case NW_GTPV2C_IE_CAUSE:
-      rc = s11_cause_ie_get (ie_p->t, ie_p->l, ie_p->i, &ieValue[read + sizeof (NwGtpv2cIeTlvT)], &bearer_context->cause);
+      rc = s11_cause_ie_get (ie_p->t, ntohs (ie_p->l), ie_p->i, &ieValue[read + sizeof (NwGtpv2cIeTlvT)], &bearer_context->cause);
       break;
 
     default:
@@ -793,10 +795,12 @@ s11_serving_network_ie_set (
   const ServingNetwork_t * serving_network)
 {
   NwRcT                                   rc;
-  uint8_t                                 value[3];
+  uint8_t                                *value = NULL;
 
   DevAssert (msg );
   DevAssert (serving_network );
+  rc = nwGtpv2cMsgAddIeReserve (*msg, NW_GTPV2C_IE_SERVING_NETWORK, 0, 3, &value);
+  DevAssert (NW_OK == rc);
   /*
    * MCC Decimal | MCC Hundreds
    */
@@ -814,7 +818,7 @@ s11_serving_network_ie_set (
     value[2] = ((serving_network->mnc[1] & 0x0F) << 4) | (serving_network->mnc[0] & 0x0F);
   }
 
-  rc = nwGtpv2cMsgAddIe (*msg, NW_GTPV2C_IE_SERVING_NETWORK, 3, 0, value);
+  rc = nwGtpv2cMsgAddIeCommit (*msg, 3);
   DevAssert (NW_OK == rc);
   return RETURNok;
 }
@@ -825,10 +829,12 @@ s11_fteid_ie_set (
   const FTeid_t * fteid)
 {
   NwRcT                                   rc;
-  uint8_t                                 value[25];
+  uint8_t                                *value = NULL;
 
   DevAssert (msg );
   DevAssert (fteid );
+  rc = nwGtpv2cMsgAddIeReserve (*msg, NW_GTPV2C_IE_FTEID, 0, 25, &value);
+  DevAssert (NW_OK == rc);
   /*
    * MCC Decimal | MCC Hundreds
    */
@@ -851,7 +857,7 @@ s11_fteid_ie_set (
     offset += 16;
   }
 
-  rc = nwGtpv2cMsgAddIe (*msg, NW_GTPV2C_IE_FTEID, offset, 0, value);
+  rc = nwGtpv2cMsgAddIeCommit (*msg, offset);
   DevAssert (NW_OK == rc);
   return RETURNok;
 }
@@ -927,13 +933,15 @@ s11_pco_ie_set (
   NwGtpv2cMsgHandleT * msg,
   const protocol_configuration_options_t * pco)
 {
-  uint8_t                                 temp[PCO_MAX_LENGTH];
+  uint8_t                                *temp = NULL;
   uint8_t                                 offset = 0;
   NwRcT                                   rc = NW_OK;
 
   DevAssert (pco );
+  rc = nwGtpv2cMsgAddIeReserve (*msg, NW_GTPV2C_IE_PCO, 0, PCO_MAX_LENGTH, &temp);
+  DevAssert (NW_OK == rc);
   offset = encode_protocol_configuration_options(pco, temp, PCO_MAX_LENGTH);
-  rc = nwGtpv2cMsgAddIe (*msg, NW_GTPV2C_IE_PCO, offset, 0, temp);
+  rc = nwGtpv2cMsgAddIeCommit (*msg, offset);
   DevAssert (NW_OK == rc);
   return RETURNok;
 }
@@ -992,12 +1000,14 @@ s11_paa_ie_set (
    * * * * + pdn_type = 1
    * * * * = maximum of 22 bytes
    */
-  uint8_t                                 temp[22];
+  uint8_t                                *temp = NULL;
   uint8_t                                 pdn_type;
   uint8_t                                 offset = 0;
   NwRcT                                   rc;
 
   DevAssert (paa );
+  rc = nwGtpv2cMsgAddIeReserve (*msg, NW_GTPV2C_IE_PAA, 0, 22, &temp);
+  DevAssert (NW_OK == rc);
   pdn_type = paa->pdn_type + 1;
   temp[offset] = pdn_type;
   offset++;
@@ -1016,7 +1026,7 @@ s11_paa_ie_set (
     offset += 4;
   }
 
-  rc = nwGtpv2cMsgAddIe (*msg, NW_GTPV2C_IE_PAA, offset, 0, temp);
+  rc = nwGtpv2cMsgAddIeCommit (*msg, offset);
   DevAssert (NW_OK == rc);
   return RETURNok;
 }
@@ -1082,7 +1092,8 @@ s11_apn_ie_set (
   DevAssert (apn );
   DevAssert (msg );
   apn_length = strlen (apn);
-  value = calloc (apn_length + 1, sizeof (uint8_t));
+  rc = nwGtpv2cMsgAddIeReserve (*msg, NW_GTPV2C_IE_APN, 0, apn_length + 1, &value);
+  DevAssert (NW_OK == rc);
   last_size = &value[0];
 
   while (apn[offset]) {
@@ -1102,9 +1113,8 @@ s11_apn_ie_set (
   }
 
   *last_size = word_length;
-  rc = nwGtpv2cMsgAddIe (*msg, NW_GTPV2C_IE_APN, apn_length + 1, 0, value);
+  rc = nwGtpv2cMsgAddIeCommit (*msg, apn_length + 1);
   DevAssert (NW_OK == rc);
-  free_wrapper ((void**) &value);
   return RETURNok;
 }
 
@@ -1190,10 +1200,12 @@ s11_bearer_qos_ie_set (
   const BearerQOS_t * bearer_qos)
 {
   NwRcT                                   rc;
-  uint8_t                                 value[22];
+  uint8_t                                *value = NULL;
 
   DevAssert (msg );
   DevAssert (bearer_qos );
+  rc = nwGtpv2cMsgAddIeReserve (*msg, NW_GTPV2C_IE_BEARER_LEVEL_QOS, 0, 22, &value);
+  DevAssert (NW_OK == rc);
   value[0] = (bearer_qos->pci << 6) | (bearer_qos->pl << 2) | (bearer_qos->pvi);
   value[1] = bearer_qos->qci;
   /*
@@ -1203,7 +1215,7 @@ s11_bearer_qos_ie_set (
   memcpy (&value[7], &bearer_qos->mbr.br_dl, 5);
   memcpy (&value[12], &bearer_qos->gbr.br_ul, 5);
   memcpy (&value[17], &bearer_qos->gbr.br_dl, 5);
-  rc = nwGtpv2cMsgAddIe (*msg, NW_GTPV2C_IE_BEARER_LEVEL_QOS, 22, 0, value);
+  rc = nwGtpv2cMsgAddIeCommit (*msg, 22);
   DevAssert (NW_OK == rc);
   return RETURNok;
 }
@@ -24,4 +24,7 @@
 
 int s11_mme_init(const mme_config_t *mme_config);
 
+/* Task of the S11 shard owning the MME S11 TEID, the requests of a session go to it */
+task_id_t s11_mme_task_id(const teid_t mme_s11_teid);
+
 #endif /* FILE_S11_MME_SEEN */
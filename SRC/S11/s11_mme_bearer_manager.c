@@ -21,6 +21,7 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <stddef.h>
 #include <string.h>
 
 #include "assertions.h"
@@ -36,8 +37,50 @@
 #include "s11_mme_bearer_manager.h"
 #include "s11_ie_formatter.h"
 
+static const NwGtpv2cMsgParserIeInfoT   release_access_bearers_response_ie_info_tbl[] = {
+  /*
+   * Cause IE
+   */
+  {NW_GTPV2C_IE_CAUSE, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_MANDATORY, s11_cause_ie_get, offsetof (itti_s11_release_access_bearers_response_t, cause)},
+  /*
+   * TODO Recovery IE
+   */
+
+  /*
+   * Do not add below this
+   */
+  {0}
+};
+
+static const NwGtpv2cMsgParserIeInfoT   modify_bearer_response_ie_info_tbl[] = {
+  /*
+   * Cause IE
+   */
+  {NW_GTPV2C_IE_CAUSE, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_MANDATORY, s11_cause_ie_get, offsetof (itti_s11_modify_bearer_response_t, cause)},
+  /*
+   * TODO Recovery IE
+   */
+
+  /*
+   * Do not add below this
+   */
+  {0}
+};
+
+static NwGtpv2cMsgParserInfoT           release_access_bearers_response_parser_info;
+static NwGtpv2cMsgParserInfoT           modify_bearer_response_parser_info;
+
 extern hash_table_ts_t                        *s11_mme_teid_2_gtv2c_teid_handle;
 
+//------------------------------------------------------------------------------
+void
+s11_mme_bearer_manager_init (
+  void)
+{
+  DevAssert (NW_OK == nwGtpv2cMsgParserInfoInit (&release_access_bearers_response_parser_info, NW_GTP_RELEASE_ACCESS_BEARERS_RSP, s11_ie_indication_generic, release_access_bearers_response_ie_info_tbl));
+  DevAssert (NW_OK == nwGtpv2cMsgParserInfoInit (&modify_bearer_response_parser_info, NW_GTP_MODIFY_BEARER_RSP, s11_ie_indication_generic, modify_bearer_response_ie_info_tbl));
+}
+
 //------------------------------------------------------------------------------
 int
 s11_mme_release_access_bearers_request (
@@ -94,7 +137,6 @@ s11_mme_handle_release_access_bearer_response (
   uint16_t                                offendingIeLength;
   itti_s11_release_access_bearers_response_t  *resp_p;
   MessageDef                             *message_p;
-  NwGtpv2cMsgParserT                     *pMsgParser;
 
   DevAssert (stack_p );
   message_p = itti_alloc_new_message (TASK_S11, S11_RELEASE_ACCESS_BEARERS_RESPONSE);
@@ -102,28 +144,10 @@ s11_mme_handle_release_access_bearer_response (
 
   resp_p->teid = nwGtpv2cMsgGetTeid(pUlpApi->hMsg);
 
-  /*
-   * Create a new message parser
-   */
-  rc = nwGtpv2cMsgParserNew (*stack_p, NW_GTP_RELEASE_ACCESS_BEARERS_RSP, s11_ie_indication_generic, NULL, &pMsgParser);
-  DevAssert (NW_OK == rc);
-  /*
-   * Cause IE
-   */
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_CAUSE, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_MANDATORY, s11_cause_ie_get,
-		  &resp_p->cause);
-  DevAssert (NW_OK == rc);
-  /*
-   * Recovery IE
-   */
-  /*rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_RECOVERY, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_OPTIONAL, s11_fteid_ie_get,
-		  &resp_p->recovery);
-  DevAssert (NW_OK == rc);*/
-
   /*
    * Run the parser
    */
-  rc = nwGtpv2cMsgParserRun (pMsgParser, (pUlpApi->hMsg), &offendingIeType, &offendingIeInstance, &offendingIeLength);
+  rc = nwGtpv2cMsgParserInfoRun (&release_access_bearers_response_parser_info, pUlpApi->hMsg, resp_p, &offendingIeType, &offendingIeInstance, &offendingIeLength);
 
   if (rc != NW_OK) {
     MSC_LOG_RX_DISCARDED_MESSAGE (MSC_S11_MME, MSC_SGW, NULL, 0, "0 RELEASE_ACCESS_BEARERS_RESPONSE local S11 teid " TEID_FMT " ", resp_p->teid);
@@ -132,8 +156,6 @@ s11_mme_handle_release_access_bearer_response (
      */
     itti_free (ITTI_MSG_ORIGIN_ID (message_p), message_p);
     message_p = NULL;
-    rc = nwGtpv2cMsgParserDelete (*stack_p, pMsgParser);
-    DevAssert (NW_OK == rc);
     rc = nwGtpv2cMsgDelete (*stack_p, (pUlpApi->hMsg));
     DevAssert (NW_OK == rc);
     return RETURNerror;
@@ -142,8 +164,6 @@ s11_mme_handle_release_access_bearer_response (
   MSC_LOG_RX_MESSAGE (MSC_S11_MME, MSC_SGW, NULL, 0, "0 RELEASE_ACCESS_BEARERS_RESPONSE local S11 teid " TEID_FMT " cause %u",
     resp_p->teid, resp_p->cause);
 
-  rc = nwGtpv2cMsgParserDelete (*stack_p, pMsgParser);
-  DevAssert (NW_OK == rc);
   rc = nwGtpv2cMsgDelete (*stack_p, (pUlpApi->hMsg));
   DevAssert (NW_OK == rc);
   return itti_send_msg_to_task (TASK_MME_APP, INSTANCE_DEFAULT, message_p);
@@ -217,7 +237,6 @@ s11_mme_handle_modify_bearer_response (
   uint16_t                                offendingIeLength;
   itti_s11_modify_bearer_response_t      *resp_p;
   MessageDef                             *message_p;
-  NwGtpv2cMsgParserT                     *pMsgParser;
 
   DevAssert (stack_p );
   message_p = itti_alloc_new_message (TASK_S11, S11_MODIFY_BEARER_RESPONSE);
@@ -225,28 +244,10 @@ s11_mme_handle_modify_bearer_response (
 
   resp_p->teid = nwGtpv2cMsgGetTeid(pUlpApi->hMsg);
 
-  /*
-   * Create a new message parser
-   */
-  rc = nwGtpv2cMsgParserNew (*stack_p, NW_GTP_MODIFY_BEARER_RSP, s11_ie_indication_generic, NULL, &pMsgParser);
-  DevAssert (NW_OK == rc);
-  /*
-   * Cause IE
-   */
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_CAUSE, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_MANDATORY, s11_cause_ie_get,
-      &resp_p->cause);
-  DevAssert (NW_OK == rc);
-  /*
-   * Recovery IE
-   */
-  /*rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_RECOVERY, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_OPTIONAL, s11_fteid_ie_get,
-		  &resp_p->recovery);
-  DevAssert (NW_OK == rc);*/
-
   /*
    * Run the parser
    */
-  rc = nwGtpv2cMsgParserRun (pMsgParser, (pUlpApi->hMsg), &offendingIeType, &offendingIeInstance, &offendingIeLength);
+  rc = nwGtpv2cMsgParserInfoRun (&modify_bearer_response_parser_info, pUlpApi->hMsg, resp_p, &offendingIeType, &offendingIeInstance, &offendingIeLength);
 
   if (rc != NW_OK) {
     MSC_LOG_RX_DISCARDED_MESSAGE (MSC_S11_MME, MSC_SGW, NULL, 0, "0 MODIFY_BEARER_RESPONSE local S11 teid " TEID_FMT " ", resp_p->teid);
@@ -255,8 +256,6 @@ s11_mme_handle_modify_bearer_response (
      */
     itti_free (ITTI_MSG_ORIGIN_ID (message_p), message_p);
     message_p = NULL;
-    rc = nwGtpv2cMsgParserDelete (*stack_p, pMsgParser);
-    DevAssert (NW_OK == rc);
     rc = nwGtpv2cMsgDelete (*stack_p, (pUlpApi->hMsg));
     DevAssert (NW_OK == rc);
     return RETURNerror;
@@ -264,8 +263,6 @@ s11_mme_handle_modify_bearer_response (
 
   MSC_LOG_RX_DISCARDED_MESSAGE (MSC_S11_MME, MSC_SGW, NULL, 0, "0 MODIFY_BEARER_RESPONSE local S11 teid " TEID_FMT " cause %u",
     resp_p->teid, resp_p->cause);
-  rc = nwGtpv2cMsgParserDelete (*stack_p, pMsgParser);
-  DevAssert (NW_OK == rc);
   rc = nwGtpv2cMsgDelete (*stack_p, (pUlpApi->hMsg));
   DevAssert (NW_OK == rc);
   return itti_send_msg_to_task (TASK_MME_APP, INSTANCE_DEFAULT, message_p);
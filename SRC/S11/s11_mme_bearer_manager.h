@@ -23,6 +23,8 @@
 #ifndef FILE_S11_MME_BEARER_MANAGER_SEEN
 #define FILE_S11_MME_BEARER_MANAGER_SEEN
 
+/* @brief Build the parsers of the bearer messages received from S-GW. */
+void s11_mme_bearer_manager_init (void);
 
 /* @brief Create a new Release Access Bearers Request and send it to provided S-GW. */
 int s11_mme_release_access_bearers_request(NwGtpv2cStackHandleT *stack_p, itti_s11_release_access_bearers_request_t *release_access_bearers_p);
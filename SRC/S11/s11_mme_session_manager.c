@@ -21,6 +21,7 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <stddef.h>
 #include <string.h>
 
 #include "assertions.h"
@@ -37,8 +38,71 @@
 #include "s11_mme_session_manager.h"
 #include "s11_ie_formatter.h"
 
+static const NwGtpv2cMsgParserIeInfoT   create_session_response_ie_info_tbl[] = {
+  /*
+   * Cause IE
+   */
+  {NW_GTPV2C_IE_CAUSE, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_MANDATORY, s11_cause_ie_get, offsetof (itti_s11_create_session_response_t, cause)},
+  /*
+   * Sender FTEID for CP IE
+   */
+  {NW_GTPV2C_IE_FTEID, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL, s11_fteid_ie_get, offsetof (itti_s11_create_session_response_t, s11_sgw_teid)},
+  /*
+   * Sender FTEID for PGW S5/S8 IE
+   */
+  {NW_GTPV2C_IE_FTEID, NW_GTPV2C_IE_INSTANCE_ONE, NW_GTPV2C_IE_PRESENCE_CONDITIONAL, s11_fteid_ie_get, offsetof (itti_s11_create_session_response_t, s5_s8_pgw_teid)},
+  /*
+   * PAA IE
+   */
+  {NW_GTPV2C_IE_PAA, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL, s11_paa_ie_get, offsetof (itti_s11_create_session_response_t, paa)},
+  /*
+   * PCO IE
+   */
+  {NW_GTPV2C_IE_PCO, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL, s11_pco_ie_get, offsetof (itti_s11_create_session_response_t, pco)},
+  /*
+   * Bearer Contexts Created IE
+   */
+  {NW_GTPV2C_IE_BEARER_CONTEXT, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL, s11_bearer_context_created_ie_get, offsetof (itti_s11_create_session_response_t, bearer_contexts_created)},
+
+  /*
+   * Do not add below this
+   */
+  {0}
+};
+
+static const NwGtpv2cMsgParserIeInfoT   delete_session_response_ie_info_tbl[] = {
+  /*
+   * Cause IE
+   */
+  {NW_GTPV2C_IE_CAUSE, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_MANDATORY, s11_cause_ie_get, offsetof (itti_s11_delete_session_response_t, cause)},
+  /*
+   * TODO Recovery IE
+   */
+  /*
+   * PCO IE
+   */
+  {NW_GTPV2C_IE_PCO, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL, s11_pco_ie_get, offsetof (itti_s11_delete_session_response_t, pco)},
+
+  /*
+   * Do not add below this
+   */
+  {0}
+};
+
+static NwGtpv2cMsgParserInfoT           create_session_response_parser_info;
+static NwGtpv2cMsgParserInfoT           delete_session_response_parser_info;
+
 extern hash_table_ts_t                        *s11_mme_teid_2_gtv2c_teid_handle;
 
+//------------------------------------------------------------------------------
+void
+s11_mme_session_manager_init (
+  void)
+{
+  DevAssert (NW_OK == nwGtpv2cMsgParserInfoInit (&create_session_response_parser_info, NW_GTP_CREATE_SESSION_RSP, s11_ie_indication_generic, create_session_response_ie_info_tbl));
+  DevAssert (NW_OK == nwGtpv2cMsgParserInfoInit (&delete_session_response_parser_info, NW_GTP_DELETE_SESSION_RSP, s11_ie_indication_generic, delete_session_response_ie_info_tbl));
+}
+
 //------------------------------------------------------------------------------
 int
 s11_mme_create_session_request (
@@ -123,7 +187,6 @@ s11_mme_handle_create_session_response (
   uint16_t                                offendingIeLength;
   itti_s11_create_session_response_t     *resp_p;
   MessageDef                             *message_p;
-  NwGtpv2cMsgParserT                     *pMsgParser;
 
   DevAssert (stack_p );
   message_p = itti_alloc_new_message (TASK_S11, S11_CREATE_SESSION_RESPONSE);
@@ -132,51 +195,10 @@ s11_mme_handle_create_session_response (
 
   resp_p->teid = nwGtpv2cMsgGetTeid(pUlpApi->hMsg);
 
-  /*
-   * Create a new message parser
-   */
-  rc = nwGtpv2cMsgParserNew (*stack_p, NW_GTP_CREATE_SESSION_RSP, s11_ie_indication_generic, NULL, &pMsgParser);
-  DevAssert (NW_OK == rc);
-  /*
-   * Cause IE
-   */
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_CAUSE, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_MANDATORY,
-      s11_cause_ie_get, &resp_p->cause);
-  DevAssert (NW_OK == rc);
-  /*
-   * Sender FTEID for CP IE
-   */
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_FTEID, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
-      s11_fteid_ie_get, &resp_p->s11_sgw_teid);
-  DevAssert (NW_OK == rc);
-  /*
-   * Sender FTEID for PGW S5/S8 IE
-   */
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_FTEID, NW_GTPV2C_IE_INSTANCE_ONE, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
-      s11_fteid_ie_get, &resp_p->s5_s8_pgw_teid);
-  DevAssert (NW_OK == rc);
-  /*
-   * PAA IE
-   */
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_PAA, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
-      s11_paa_ie_get, &resp_p->paa);
-  DevAssert (NW_OK == rc);
-  /*
-   * PCO IE
-   */
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_PCO, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
-      s11_pco_ie_get, &resp_p->pco);
-  DevAssert (NW_OK == rc);
-  /*
-   * Bearer Contexts Created IE
-   */
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_BEARER_CONTEXT, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
-      s11_bearer_context_created_ie_get, &resp_p->bearer_contexts_created);
-  DevAssert (NW_OK == rc);
   /*
    * Run the parser
    */
-  rc = nwGtpv2cMsgParserRun (pMsgParser, (pUlpApi->hMsg), &offendingIeType, &offendingIeInstance, &offendingIeLength);
+  rc = nwGtpv2cMsgParserInfoRun (&create_session_response_parser_info, pUlpApi->hMsg, resp_p, &offendingIeType, &offendingIeInstance, &offendingIeLength);
 
   if (rc != NW_OK) {
     MSC_LOG_RX_DISCARDED_MESSAGE (MSC_S11_MME, MSC_SGW, NULL, 0, "0 CREATE_SESSION_RESPONSE local S11 teid " TEID_FMT " ", resp_p->teid);
@@ -185,15 +207,11 @@ s11_mme_handle_create_session_response (
      */
     itti_free (ITTI_MSG_ORIGIN_ID (message_p), message_p);
     message_p = NULL;
-    rc = nwGtpv2cMsgParserDelete (*stack_p, pMsgParser);
-    DevAssert (NW_OK == rc);
     rc = nwGtpv2cMsgDelete (*stack_p, (pUlpApi->hMsg));
     DevAssert (NW_OK == rc);
     return RETURNerror;
   }
 
-  rc = nwGtpv2cMsgParserDelete (*stack_p, pMsgParser);
-  DevAssert (NW_OK == rc);
   rc = nwGtpv2cMsgDelete (*stack_p, (pUlpApi->hMsg));
   DevAssert (NW_OK == rc);
 
@@ -267,7 +285,6 @@ s11_mme_handle_delete_session_response (
   uint16_t                                offendingIeLength;
   itti_s11_delete_session_response_t     *resp_p;
   MessageDef                             *message_p;
-  NwGtpv2cMsgParserT                     *pMsgParser;
   hashtable_rc_t                          hash_rc = HASH_TABLE_OK;
 
   DevAssert (stack_p );
@@ -276,34 +293,10 @@ s11_mme_handle_delete_session_response (
 
   resp_p->teid = nwGtpv2cMsgGetTeid(pUlpApi->hMsg);
 
-  /*
-   * Create a new message parser
-   */
-  rc = nwGtpv2cMsgParserNew (*stack_p, NW_GTP_DELETE_SESSION_RSP, s11_ie_indication_generic, NULL, &pMsgParser);
-  DevAssert (NW_OK == rc);
-  /*
-   * Cause IE
-   */
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_CAUSE, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_MANDATORY,
-      s11_cause_ie_get, &resp_p->cause);
-  DevAssert (NW_OK == rc);
-  /*
-   * Recovery IE
-   */
-  /* TODO rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_RECOVERY, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL, s11_fteid_ie_get,
-		  &resp_p->recovery);
-  DevAssert (NW_OK == rc); */
-  /*
-   * PCO IE
-   */
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_PCO, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
-      s11_pco_ie_get, &resp_p->pco);
-  DevAssert (NW_OK == rc);
-
   /*
    * Run the parser
    */
-  rc = nwGtpv2cMsgParserRun (pMsgParser, (pUlpApi->hMsg), &offendingIeType, &offendingIeInstance, &offendingIeLength);
+  rc = nwGtpv2cMsgParserInfoRun (&delete_session_response_parser_info, pUlpApi->hMsg, resp_p, &offendingIeType, &offendingIeInstance, &offendingIeLength);
 
   if (rc != NW_OK) {
     MSC_LOG_RX_DISCARDED_MESSAGE (MSC_S11_MME, MSC_SGW, NULL, 0, "0 DELETE_SESSION_RESPONSE local S11 teid " TEID_FMT " ", resp_p->teid);
@@ -312,15 +305,11 @@ s11_mme_handle_delete_session_response (
      */
     itti_free (ITTI_MSG_ORIGIN_ID (message_p), message_p);
     message_p = NULL;
-    rc = nwGtpv2cMsgParserDelete (*stack_p, pMsgParser);
-    DevAssert (NW_OK == rc);
     rc = nwGtpv2cMsgDelete (*stack_p, (pUlpApi->hMsg));
     DevAssert (NW_OK == rc);
     return RETURNerror;
   }
 
-  rc = nwGtpv2cMsgParserDelete (*stack_p, pMsgParser);
-  DevAssert (NW_OK == rc);
   rc = nwGtpv2cMsgDelete (*stack_p, (pUlpApi->hMsg));
   DevAssert (NW_OK == rc);
 
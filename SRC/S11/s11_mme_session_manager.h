@@ -23,6 +23,9 @@
 #ifndef FILE_S11_MME_SESSION_MANAGER_SEEN
 #define FILE_S11_MME_SESSION_MANAGER_SEEN
 
+/* @brief Build the parsers of the session messages received from S-GW. */
+void s11_mme_session_manager_init (void);
+
 /* @brief Create a new Create Session Request and send it to provided S-GW. */
 int s11_mme_create_session_request(NwGtpv2cStackHandleT *stack_p, itti_s11_create_session_request_t *create_session_p);
 
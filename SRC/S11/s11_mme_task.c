@@ -27,6 +27,7 @@
 
 #include "assertions.h"
 #include "hashtable.h"
+#include "teid_pool.h"
 #include "log.h"
 #include "msc.h"
 #include "mme_config.h"
@@ -35,11 +36,19 @@
 #include "NwLog.h"
 #include "NwGtpv2c.h"
 #include "NwGtpv2cMsg.h"
+#include "s11_common.h"
 #include "s11_mme.h"
 #include "s11_mme_session_manager.h"
 #include "s11_mme_bearer_manager.h"
 
-static NwGtpv2cStackHandleT             s11_mme_stack_handle = 0;
+typedef struct s11_mme_shard_s {
+  NwGtpv2cStackHandleT                    stack_handle;
+  task_id_t                               task_id;
+} s11_mme_shard_t;
+
+// GTPv2-C stack instances, each one run by its own task for the MME S11 TEIDs of its shard
+static s11_mme_shard_t                  s11_mme_shards[S11_MAX_SHARDS];
+static uint32_t                         s11_mme_nb_shards = 1;
 // Store the GTPv2-C teid handle
 hash_table_ts_t                        *s11_mme_teid_2_gtv2c_teid_handle = NULL;
 //------------------------------------------------------------------------------
@@ -62,6 +71,7 @@ s11_mme_ulp_process_stack_req_cb (
   NwGtpv2cUlpApiT * pUlpApi)
 {
   //     NwRcT rc = NW_OK;
+  s11_mme_shard_t                        *shard = (s11_mme_shard_t *) hUlp;
   int                                     ret = 0;
 
   DevAssert (pUlpApi );
@@ -72,19 +82,19 @@ s11_mme_ulp_process_stack_req_cb (
 
     switch (pUlpApi->apiInfo.triggeredRspIndInfo.msgType) {
     case NW_GTP_CREATE_SESSION_RSP:
-      ret = s11_mme_handle_create_session_response (&s11_mme_stack_handle, pUlpApi);
+      ret = s11_mme_handle_create_session_response (&shard->stack_handle, pUlpApi);
       break;
 
     case NW_GTP_DELETE_SESSION_RSP:
-      ret = s11_mme_handle_delete_session_response (&s11_mme_stack_handle, pUlpApi);
+      ret = s11_mme_handle_delete_session_response (&shard->stack_handle, pUlpApi);
       break;
 
     case NW_GTP_MODIFY_BEARER_RSP:
-      ret = s11_mme_handle_modify_bearer_response (&s11_mme_stack_handle, pUlpApi);
+      ret = s11_mme_handle_modify_bearer_response (&shard->stack_handle, pUlpApi);
       break;
 
     case NW_GTP_RELEASE_ACCESS_BEARERS_RSP:
-      ret = s11_mme_handle_release_access_bearer_response (&s11_mme_stack_handle, pUlpApi);
+      ret = s11_mme_handle_release_access_bearer_response (&shard->stack_handle, pUlpApi);
       break;
 
     default:
@@ -111,15 +121,21 @@ s11_mme_send_udp_msg (
   uint32_t peerPort)
 {
   // Create and alloc new message
+  s11_mme_shard_t                        *shard = (s11_mme_shard_t *) udpHandle;
   MessageDef                             *message_p;
   udp_data_req_t                         *udp_data_req_p;
   int                                     ret = 0;
 
-  message_p = itti_alloc_new_message (TASK_S11, UDP_DATA_REQ);
+  message_p = itti_alloc_new_message (shard->task_id, UDP_DATA_REQ);
   udp_data_req_p = &message_p->ittiMsg.udp_data_req;
   udp_data_req_p->peer_address = peerIpAddr;
   udp_data_req_p->peer_port = peerPort;
-  udp_data_req_p->buffer = buffer;
+  /*
+   * The stack may release its buffer before TASK_UDP sends it
+   */
+  udp_data_req_p->buffer = itti_malloc (shard->task_id, TASK_UDP, buffer_len);
+  memcpy (udp_data_req_p->buffer, buffer, buffer_len);
+  udp_data_req_p->buffer_offset = 0;
   udp_data_req_p->buffer_length = buffer_len;
   ret = itti_send_msg_to_task (TASK_UDP, INSTANCE_DEFAULT, message_p);
   return ((ret == 0) ? NW_OK : NW_FAILURE);
@@ -135,13 +151,14 @@ s11_mme_start_timer_wrapper (
   void *timeoutArg,
   NwGtpv2cTimerHandleT * hTmr)
 {
+  s11_mme_shard_t                        *shard = (s11_mme_shard_t *) tmrMgrHandle;
   long                                    timer_id;
   int                                     ret = 0;
 
   if (tmrType == NW_GTPV2C_TMR_TYPE_REPETITIVE) {
-    ret = timer_setup (timeoutSec, timeoutUsec, TASK_S11, INSTANCE_DEFAULT, TIMER_PERIODIC, timeoutArg, &timer_id);
+    ret = timer_setup (timeoutSec, timeoutUsec, shard->task_id, INSTANCE_DEFAULT, TIMER_PERIODIC, timeoutArg, &timer_id);
   } else {
-    ret = timer_setup (timeoutSec, timeoutUsec, TASK_S11, INSTANCE_DEFAULT, TIMER_ONE_SHOT, timeoutArg, &timer_id);
+    ret = timer_setup (timeoutSec, timeoutUsec, shard->task_id, INSTANCE_DEFAULT, TIMER_ONE_SHOT, timeoutArg, &timer_id);
   }
 
   *hTmr = (NwGtpv2cTimerHandleT) timer_id;
@@ -164,35 +181,37 @@ static void                            *
 s11_mme_thread (
   void *args)
 {
-  itti_mark_task_ready (TASK_S11);
+  s11_mme_shard_t                        *shard = (s11_mme_shard_t *) args;
+
+  itti_mark_task_ready (shard->task_id);
   OAILOG_START_USE ();
   MSC_START_USE ();
 
   while (1) {
     MessageDef                             *received_message_p = NULL;
 
-    itti_receive_msg (TASK_S11, &received_message_p);
+    itti_receive_msg (shard->task_id, &received_message_p);
     assert (received_message_p );
 
     switch (ITTI_MSG_ID (received_message_p)) {
     case S11_CREATE_SESSION_REQUEST:{
-        s11_mme_create_session_request (&s11_mme_stack_handle, &received_message_p->ittiMsg.s11_create_session_request);
+        s11_mme_create_session_request (&shard->stack_handle, &received_message_p->ittiMsg.s11_create_session_request);
       }
       break;
 
     case S11_MODIFY_BEARER_REQUEST:{
-        s11_mme_modify_bearer_request (&s11_mme_stack_handle, &received_message_p->ittiMsg.s11_modify_bearer_request);
+        s11_mme_modify_bearer_request (&shard->stack_handle, &received_message_p->ittiMsg.s11_modify_bearer_request);
       }
       break;
 
 
     case S11_DELETE_SESSION_REQUEST:{
-        s11_mme_delete_session_request (&s11_mme_stack_handle, &received_message_p->ittiMsg.s11_delete_session_request);
+        s11_mme_delete_session_request (&shard->stack_handle, &received_message_p->ittiMsg.s11_delete_session_request);
       }
       break;
 
     case S11_RELEASE_ACCESS_BEARERS_REQUEST:{
-        s11_mme_release_access_bearers_request (&s11_mme_stack_handle, &received_message_p->ittiMsg.s11_release_access_bearers_request);
+        s11_mme_release_access_bearers_request (&shard->stack_handle, &received_message_p->ittiMsg.s11_release_access_bearers_request);
       }
       break;
 
@@ -204,8 +223,9 @@ s11_mme_thread (
         udp_data_ind_t                         *udp_data_ind;
 
         udp_data_ind = &received_message_p->ittiMsg.udp_data_ind;
-        rc = nwGtpv2cProcessUdpReq (s11_mme_stack_handle, udp_data_ind->buffer, udp_data_ind->buffer_length, udp_data_ind->peer_port, udp_data_ind->peer_address);
+        rc = nwGtpv2cProcessUdpReq (shard->stack_handle, udp_data_ind->buffer, udp_data_ind->buffer_length, udp_data_ind->peer_port, udp_data_ind->peer_address);
         DevAssert (rc == NW_OK);
+        itti_free (ITTI_MSG_ORIGIN_ID (received_message_p), udp_data_ind->buffer);
       }
       break;
 
@@ -240,6 +260,11 @@ s11_send_init_udp (
   }
   message_p->ittiMsg.udp_init.port = port_number;
   message_p->ittiMsg.udp_init.address = address;
+  /*
+   * The shards share the socket, TASK_UDP hands each datagram to the task of its shard
+   */
+  message_p->ittiMsg.udp_init.nb_tasks = s11_mme_nb_shards;
+  message_p->ittiMsg.udp_init.steer = s11_steer;
   OAILOG_DEBUG (LOG_S11, "Tx UDP_INIT IP addr %s:%d\n", message_p->ittiMsg.udp_init.address, message_p->ittiMsg.udp_init.port);
   return itti_send_msg_to_task (TASK_UDP, INSTANCE_DEFAULT, message_p);
 }
@@ -259,40 +284,54 @@ s11_mme_init (
 
   OAILOG_DEBUG (LOG_S11, "Initializing S11 interface\n");
 
-  if (nwGtpv2cInitialize (&s11_mme_stack_handle) != NW_OK) {
-    OAILOG_ERROR (LOG_S11, "Failed to initialize gtpv2-c stack\n");
-    goto fail;
-  }
+  s11_mme_nb_shards = mme_config_p->ipv4.nb_s11_shards ? mme_config_p->ipv4.nb_s11_shards : 1;
+  s11_mme_session_manager_init ();
+  s11_mme_bearer_manager_init ();
 
-  /*
-   * Set ULP entity
-   */
-  ulp.hUlp = (NwGtpv2cUlpHandleT) NULL;
-  ulp.ulpReqCallback = s11_mme_ulp_process_stack_req_cb;
-  DevAssert (NW_OK == nwGtpv2cSetUlpEntity (s11_mme_stack_handle, &ulp));
-  /*
-   * Set UDP entity
-   */
-  udp.hUdp = (NwGtpv2cUdpHandleT) NULL;
-  udp.udpDataReqCallback = s11_mme_send_udp_msg;
-  DevAssert (NW_OK == nwGtpv2cSetUdpEntity (s11_mme_stack_handle, &udp));
-  /*
-   * Set Timer entity
-   */
-  tmrMgr.tmrMgrHandle = (NwGtpv2cTimerMgrHandleT) NULL;
-  tmrMgr.tmrStartCallback = s11_mme_start_timer_wrapper;
-  tmrMgr.tmrStopCallback = s11_mme_stop_timer_wrapper;
-  DevAssert (NW_OK == nwGtpv2cSetTimerMgrEntity (s11_mme_stack_handle, &tmrMgr));
-  logMgr.logMgrHandle = 0;
-  logMgr.logReqCallback = s11_mme_log_wrapper;
-  DevAssert (NW_OK == nwGtpv2cSetLogMgrEntity (s11_mme_stack_handle, &logMgr));
-
-  if (itti_create_task (TASK_S11, &s11_mme_thread, NULL) < 0) {
-    OAILOG_ERROR (LOG_S11, "gtpv1u phtread_create: %s\n", strerror (errno));
-    goto fail;
+  for (uint32_t i = 0; i < s11_mme_nb_shards; i++) {
+    s11_mme_shard_t                        *shard = &s11_mme_shards[i];
+
+    shard->task_id = TASK_S11 + i;
+    if (nwGtpv2cInitialize (&shard->stack_handle) != NW_OK) {
+      OAILOG_ERROR (LOG_S11, "Failed to initialize gtpv2-c stack\n");
+      goto fail;
+    }
+
+    /*
+     * The requests of the shard are sent with sequence numbers of its
+     * partition, for s11_steer() to steer their responses without TEID
+     */
+    DevAssert (NW_OK == nwGtpv2cSetSeqNumPartition (shard->stack_handle, s11_mme_nb_shards, i));
+    /*
+     * Set ULP entity
+     */
+    ulp.hUlp = (NwGtpv2cUlpHandleT) shard;
+    ulp.ulpReqCallback = s11_mme_ulp_process_stack_req_cb;
+    DevAssert (NW_OK == nwGtpv2cSetUlpEntity (shard->stack_handle, &ulp));
+    /*
+     * Set UDP entity
+     */
+    udp.hUdp = (NwGtpv2cUdpHandleT) shard;
+    udp.udpDataReqCallback = s11_mme_send_udp_msg;
+    DevAssert (NW_OK == nwGtpv2cSetUdpEntity (shard->stack_handle, &udp));
+    /*
+     * Set Timer entity
+     */
+    tmrMgr.tmrMgrHandle = (NwGtpv2cTimerMgrHandleT) shard;
+    tmrMgr.tmrStartCallback = s11_mme_start_timer_wrapper;
+    tmrMgr.tmrStopCallback = s11_mme_stop_timer_wrapper;
+    DevAssert (NW_OK == nwGtpv2cSetTimerMgrEntity (shard->stack_handle, &tmrMgr));
+    logMgr.logMgrHandle = 0;
+    logMgr.logReqCallback = s11_mme_log_wrapper;
+    DevAssert (NW_OK == nwGtpv2cSetLogMgrEntity (shard->stack_handle, &logMgr));
+    DevAssert (NW_OK == nwGtpv2cSetLogLevel (shard->stack_handle, NW_LOG_LEVEL_DEBG));
+
+    if (itti_create_task (shard->task_id, &s11_mme_thread, shard) < 0) {
+      OAILOG_ERROR (LOG_S11, "gtpv1u phtread_create: %s\n", strerror (errno));
+      goto fail;
+    }
   }
 
-  DevAssert (NW_OK == nwGtpv2cSetLogLevel (s11_mme_stack_handle, NW_LOG_LEVEL_DEBG));
   mme_config_read_lock (&mme_config);
   addr.s_addr = mme_config.ipv4.s11;
   s11_address_str = inet_ntoa (addr);
@@ -310,3 +349,11 @@ fail:
   OAILOG_DEBUG (LOG_S11, "Initializing S11 interface: FAILURE\n");
   return RETURNerror;
 }
+
+//------------------------------------------------------------------------------
+task_id_t
+s11_mme_task_id (
+  const teid_t mme_s11_teid)
+{
+  return TASK_S11 + teid_pool_shard (mme_s11_teid, teid_pool_shard_bits (s11_mme_nb_shards));
+}
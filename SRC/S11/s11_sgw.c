@@ -29,6 +29,7 @@
 #include "assertions.h"
 #include "queue.h"
 #include "sgw_config.h"
+#include "teid_pool.h"
 #include "intertask_interface.h"
 #include "timer.h"
 #include "NwLog.h"
@@ -42,12 +43,20 @@
 #include "s11_sgw_session_manager.h"
 
 
-static NwGtpv2cStackHandleT             s11_sgw_stack_handle = 0;
+typedef struct s11_sgw_shard_s {
+  NwGtpv2cStackHandleT                    stack_handle;
+  task_id_t                               task_id;
+} s11_sgw_shard_t;
+
+// GTPv2-C stack instances, each one run by its own task for the S-GW S11 TEIDs of its shard
+static s11_sgw_shard_t                  s11_sgw_shards[S11_MAX_SHARDS];
+static uint32_t                         s11_sgw_nb_shards = 1;
 
 /* ULP callback for the GTPv2-C stack */
 //------------------------------------------------------------------------------
 static NwRcT s11_sgw_ulp_process_stack_req_cb (NwGtpv2cUlpHandleT hUlp, NwGtpv2cUlpApiT * pUlpApi)
 {
+  s11_sgw_shard_t                        *shard = (s11_sgw_shard_t *) hUlp;
   int                                     ret = 0;
 
   DevAssert (pUlpApi );
@@ -58,19 +67,19 @@ static NwRcT s11_sgw_ulp_process_stack_req_cb (NwGtpv2cUlpHandleT hUlp, NwGtpv2c
 
     switch (pUlpApi->apiInfo.initialReqIndInfo.msgType) {
     case NW_GTP_CREATE_SESSION_REQ:
-      ret = s11_sgw_handle_create_session_request (&s11_sgw_stack_handle, pUlpApi);
+      ret = s11_sgw_handle_create_session_request (&shard->stack_handle, shard->task_id, pUlpApi);
       break;
 
     case NW_GTP_MODIFY_BEARER_REQ:
-      ret = s11_sgw_handle_modify_bearer_request (&s11_sgw_stack_handle, pUlpApi);
+      ret = s11_sgw_handle_modify_bearer_request (&shard->stack_handle, shard->task_id, pUlpApi);
       break;
 
     case NW_GTP_DELETE_SESSION_REQ:
-      ret = s11_sgw_handle_delete_session_request (&s11_sgw_stack_handle, pUlpApi);
+      ret = s11_sgw_handle_delete_session_request (&shard->stack_handle, shard->task_id, pUlpApi);
       break;
 
     case NW_GTP_RELEASE_ACCESS_BEARERS_REQ:
-      ret = s11_sgw_handle_release_access_bearers_request (&s11_sgw_stack_handle, pUlpApi);
+      ret = s11_sgw_handle_release_access_bearers_request (&shard->stack_handle, shard->task_id, pUlpApi);
       break;
 
     default:
@@ -97,15 +106,21 @@ static NwRcT s11_sgw_send_udp_msg (
   uint32_t peerPort)
 {
   // Create and alloc new message
+  s11_sgw_shard_t                        *shard = (s11_sgw_shard_t *) udpHandle;
   MessageDef                             *message_p;
   udp_data_req_t                         *udp_data_req_p;
   int                                     ret = 0;
 
-  message_p = itti_alloc_new_message (TASK_S11, UDP_DATA_REQ);
+  message_p = itti_alloc_new_message (shard->task_id, UDP_DATA_REQ);
   udp_data_req_p = &message_p->ittiMsg.udp_data_req;
   udp_data_req_p->peer_address = peerIpAddr;
   udp_data_req_p->peer_port = peerPort;
-  udp_data_req_p->buffer = buffer;
+  /*
+   * The stack may release its buffer before TASK_UDP sends it
+   */
+  udp_data_req_p->buffer = itti_malloc (shard->task_id, TASK_UDP, buffer_len);
+  memcpy (udp_data_req_p->buffer, buffer, buffer_len);
+  udp_data_req_p->buffer_offset = 0;
   udp_data_req_p->buffer_length = buffer_len;
   ret = itti_send_msg_to_task (TASK_UDP, INSTANCE_DEFAULT, message_p);
   return ret == 0 ? NW_OK : NW_FAILURE;
@@ -132,13 +147,14 @@ static NwRcT s11_sgw_start_timer_wrapper (
   void *timeoutArg,
   NwGtpv2cTimerHandleT * hTmr)
 {
+  s11_sgw_shard_t                        *shard = (s11_sgw_shard_t *) tmrMgrHandle;
   long                                    timer_id;
   int                                     ret = 0;
 
   if (tmrType == NW_GTPV2C_TMR_TYPE_REPETITIVE) {
-    ret = timer_setup (timeoutSec, timeoutUsec, TASK_S11, INSTANCE_DEFAULT, TIMER_PERIODIC, timeoutArg, &timer_id);
+    ret = timer_setup (timeoutSec, timeoutUsec, shard->task_id, INSTANCE_DEFAULT, TIMER_PERIODIC, timeoutArg, &timer_id);
   } else {
-    ret = timer_setup (timeoutSec, timeoutUsec, TASK_S11, INSTANCE_DEFAULT, TIMER_ONE_SHOT, timeoutArg, &timer_id);
+    ret = timer_setup (timeoutSec, timeoutUsec, shard->task_id, INSTANCE_DEFAULT, TIMER_ONE_SHOT, timeoutArg, &timer_id);
   }
 
   return ret == 0 ? NW_OK : NW_FAILURE;
@@ -160,13 +176,15 @@ static NwRcT s11_sgw_stop_timer_wrapper (
 //------------------------------------------------------------------------------
 static void *s11_sgw_thread (void *args)
 {
-  itti_mark_task_ready (TASK_S11);
+  s11_sgw_shard_t                        *shard = (s11_sgw_shard_t *) args;
+
+  itti_mark_task_ready (shard->task_id);
   OAILOG_START_USE ();
 
   while (1) {
     MessageDef                             *received_message_p = NULL;
 
-    itti_receive_msg (TASK_S11, &received_message_p);
+    itti_receive_msg (shard->task_id, &received_message_p);
 
     switch (ITTI_MSG_ID (received_message_p)) {
     case UDP_DATA_IND:{
@@ -178,32 +196,33 @@ static void *s11_sgw_thread (void *args)
 
         udp_data_ind = &received_message_p->ittiMsg.udp_data_ind;
         OAILOG_DEBUG (LOG_S11, "Processing new data indication from UDP\n");
-        rc = nwGtpv2cProcessUdpReq (s11_sgw_stack_handle, udp_data_ind->buffer, udp_data_ind->buffer_length, udp_data_ind->peer_port, udp_data_ind->peer_address);
+        rc = nwGtpv2cProcessUdpReq (shard->stack_handle, udp_data_ind->buffer, udp_data_ind->buffer_length, udp_data_ind->peer_port, udp_data_ind->peer_address);
         DevAssert (rc == NW_OK);
+        itti_free (ITTI_MSG_ORIGIN_ID (received_message_p), udp_data_ind->buffer);
       }
       break;
 
     case S11_CREATE_SESSION_RESPONSE:{
         OAILOG_DEBUG (LOG_S11, "Received S11_CREATE_SESSION_RESPONSE from S-PGW APP\n");
-        s11_sgw_handle_create_session_response (&s11_sgw_stack_handle, &received_message_p->ittiMsg.s11_create_session_response);
+        s11_sgw_handle_create_session_response (&shard->stack_handle, &received_message_p->ittiMsg.s11_create_session_response);
       }
       break;
 
     case S11_MODIFY_BEARER_RESPONSE:{
         OAILOG_DEBUG (LOG_S11, "Received S11_MODIFY_BEARER_RESPONSE from S-PGW APP\n");
-        s11_sgw_handle_modify_bearer_response (&s11_sgw_stack_handle, &received_message_p->ittiMsg.s11_modify_bearer_response);
+        s11_sgw_handle_modify_bearer_response (&shard->stack_handle, &received_message_p->ittiMsg.s11_modify_bearer_response);
       }
       break;
 
     case S11_DELETE_SESSION_RESPONSE:{
         OAILOG_DEBUG (LOG_S11, "Received S11_DELETE_SESSION_RESPONSE from S-PGW APP\n");
-        s11_sgw_handle_delete_session_response (&s11_sgw_stack_handle, &received_message_p->ittiMsg.s11_delete_session_response);
+        s11_sgw_handle_delete_session_response (&shard->stack_handle, &received_message_p->ittiMsg.s11_delete_session_response);
       }
       break;
 
     case S11_RELEASE_ACCESS_BEARERS_RESPONSE:{
         OAILOG_DEBUG (LOG_S11, "Received S11_RELEASE_ACCESS_BEARERS_RESPONSE from S-PGW APP\n");
-        s11_sgw_handle_release_access_bearers_response (&s11_sgw_stack_handle, &received_message_p->ittiMsg.s11_release_access_bearers_response);
+        s11_sgw_handle_release_access_bearers_response (&shard->stack_handle, &received_message_p->ittiMsg.s11_release_access_bearers_response);
       }
       break;
 
@@ -241,6 +260,11 @@ static int s11_send_init_udp (char *address, uint16_t port_number)
   message_p->ittiMsg.udp_init.port = port_number;
   //LG message_p->ittiMsg.udpInit.address = "0.0.0.0"; //ANY address
   message_p->ittiMsg.udp_init.address = address;
+  /*
+   * The shards share the socket, TASK_UDP hands each datagram to the task of its shard
+   */
+  message_p->ittiMsg.udp_init.nb_tasks = s11_sgw_nb_shards;
+  message_p->ittiMsg.udp_init.steer = s11_steer;
   OAILOG_DEBUG (LOG_S11, "Tx UDP_INIT IP addr %s\n", message_p->ittiMsg.udp_init.address);
   return itti_send_msg_to_task (TASK_UDP, INSTANCE_DEFAULT, message_p);
 }
@@ -258,40 +282,52 @@ int s11_sgw_init (sgw_config_t * config_p)
 
   OAILOG_DEBUG (LOG_S11, "Initializing S11 interface\n");
 
-  if (nwGtpv2cInitialize (&s11_sgw_stack_handle) != NW_OK) {
-    OAILOG_ERROR (LOG_S11, "Failed to initialize gtpv2-c stack\n");
-    goto fail;
-  }
+  sgw_config_read_lock (config_p);
+  s11_sgw_nb_shards = config_p->ipv4.nb_s11_shards ? config_p->ipv4.nb_s11_shards : 1;
+  sgw_config_unlock (config_p);
+  s11_sgw_session_manager_init ();
+  s11_sgw_bearer_manager_init ();
 
-  /*
-   * Set ULP entity
-   */
-  ulp.hUlp = (NwGtpv2cUlpHandleT) NULL;
-  ulp.ulpReqCallback = s11_sgw_ulp_process_stack_req_cb;
-  DevAssert (NW_OK == nwGtpv2cSetUlpEntity (s11_sgw_stack_handle, &ulp));
-  /*
-   * Set UDP entity
-   */
-  udp.hUdp = (NwGtpv2cUdpHandleT) NULL;
-  udp.udpDataReqCallback = s11_sgw_send_udp_msg;
-  DevAssert (NW_OK == nwGtpv2cSetUdpEntity (s11_sgw_stack_handle, &udp));
-  /*
-   * Set Timer entity
-   */
-  tmrMgr.tmrMgrHandle = (NwGtpv2cTimerMgrHandleT) NULL;
-  tmrMgr.tmrStartCallback = s11_sgw_start_timer_wrapper;
-  tmrMgr.tmrStopCallback = s11_sgw_stop_timer_wrapper;
-  DevAssert (NW_OK == nwGtpv2cSetTimerMgrEntity (s11_sgw_stack_handle, &tmrMgr));
-  logMgr.logMgrHandle = 0;
-  logMgr.logReqCallback = s11_sgw_log_wrapper;
-  DevAssert (NW_OK == nwGtpv2cSetLogMgrEntity (s11_sgw_stack_handle, &logMgr));
-
-  if (itti_create_task (TASK_S11, &s11_sgw_thread, NULL) < 0) {
-    OAILOG_ERROR (LOG_S11, "S11 pthread_create: %s\n", strerror (errno));
-    goto fail;
+  for (uint32_t i = 0; i < s11_sgw_nb_shards; i++) {
+    s11_sgw_shard_t                        *shard = &s11_sgw_shards[i];
+
+    shard->task_id = TASK_S11 + i;
+    if (nwGtpv2cInitialize (&shard->stack_handle) != NW_OK) {
+      OAILOG_ERROR (LOG_S11, "Failed to initialize gtpv2-c stack\n");
+      goto fail;
+    }
+
+    DevAssert (NW_OK == nwGtpv2cSetSeqNumPartition (shard->stack_handle, s11_sgw_nb_shards, i));
+    /*
+     * Set ULP entity
+     */
+    ulp.hUlp = (NwGtpv2cUlpHandleT) shard;
+    ulp.ulpReqCallback = s11_sgw_ulp_process_stack_req_cb;
+    DevAssert (NW_OK == nwGtpv2cSetUlpEntity (shard->stack_handle, &ulp));
+    /*
+     * Set UDP entity
+     */
+    udp.hUdp = (NwGtpv2cUdpHandleT) shard;
+    udp.udpDataReqCallback = s11_sgw_send_udp_msg;
+    DevAssert (NW_OK == nwGtpv2cSetUdpEntity (shard->stack_handle, &udp));
+    /*
+     * Set Timer entity
+     */
+    tmrMgr.tmrMgrHandle = (NwGtpv2cTimerMgrHandleT) shard;
+    tmrMgr.tmrStartCallback = s11_sgw_start_timer_wrapper;
+    tmrMgr.tmrStopCallback = s11_sgw_stop_timer_wrapper;
+    DevAssert (NW_OK == nwGtpv2cSetTimerMgrEntity (shard->stack_handle, &tmrMgr));
+    logMgr.logMgrHandle = 0;
+    logMgr.logReqCallback = s11_sgw_log_wrapper;
+    DevAssert (NW_OK == nwGtpv2cSetLogMgrEntity (shard->stack_handle, &logMgr));
+    DevAssert (NW_OK == nwGtpv2cSetLogLevel (shard->stack_handle, NW_LOG_LEVEL_DEBG));
+
+    if (itti_create_task (shard->task_id, &s11_sgw_thread, shard) < 0) {
+      OAILOG_ERROR (LOG_S11, "S11 pthread_create: %s\n", strerror (errno));
+      goto fail;
+    }
   }
 
-  DevAssert (NW_OK == nwGtpv2cSetLogLevel (s11_sgw_stack_handle, NW_LOG_LEVEL_DEBG));
   sgw_config_read_lock (config_p);
   addr.s_addr = config_p->ipv4.S11;
   sgw_config_unlock (config_p);
@@ -304,3 +340,9 @@ fail:
   OAILOG_DEBUG (LOG_S11, "Initializing S11 interface: FAILURE\n");
   return RETURNerror;
 }
+
+//------------------------------------------------------------------------------
+task_id_t s11_sgw_task_id (const teid_t sgw_s11_teid)
+{
+  return TASK_S11 + teid_pool_shard (sgw_s11_teid, teid_pool_shard_bits (s11_sgw_nb_shards));
+}
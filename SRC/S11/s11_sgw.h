@@ -24,4 +24,7 @@
 
 int s11_sgw_init(sgw_config_t *mme_config);
 
+/* Task of the S11 shard owning the S-GW S11 TEID, the responses of a session go to it */
+task_id_t s11_sgw_task_id(const teid_t sgw_s11_teid);
+
 #endif /* FILE_S11_SGW_SEEN */
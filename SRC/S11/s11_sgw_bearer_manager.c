@@ -21,6 +21,7 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <stddef.h>
 #include <string.h>
 
 #include "assertions.h"
@@ -37,10 +38,61 @@
 #include "s11_ie_formatter.h"
 #include "log.h"
 
+static const NwGtpv2cMsgParserIeInfoT   modify_bearer_request_ie_info_tbl[] = {
+  /*
+   * Indication Flags IE
+   */
+  {NW_GTPV2C_IE_INDICATION, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL, s11_indication_flags_ie_get, offsetof (itti_s11_modify_bearer_request_t, indication_flags)},
+  /*
+   * MME-FQ-CSID IE
+   */
+  {NW_GTPV2C_IE_FQ_CSID, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL, s11_fqcsid_ie_get, offsetof (itti_s11_modify_bearer_request_t, mme_fq_csid)},
+  /*
+   * RAT Type IE
+   */
+  {NW_GTPV2C_IE_RAT_TYPE, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL, s11_rat_type_ie_get, offsetof (itti_s11_modify_bearer_request_t, rat_type)},
+  /*
+   * Delay Value IE
+   */
+  {NW_GTPV2C_IE_DELAY_VALUE, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL, s11_delay_value_ie_get, offsetof (itti_s11_modify_bearer_request_t, delay_dl_packet_notif_req)},
+  /*
+   * Bearer Context to be modified IE
+   */
+  {NW_GTPV2C_IE_BEARER_CONTEXT, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL, s11_bearer_context_to_be_modified_ie_get, offsetof (itti_s11_modify_bearer_request_t, bearer_contexts_to_be_modified)},
+
+  /*
+   * Do not add below this
+   */
+  {0}
+};
+
+static const NwGtpv2cMsgParserIeInfoT   release_access_bearers_request_ie_info_tbl[] = {
+  {NW_GTPV2C_IE_NODE_TYPE, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL, s11_node_type_ie_get, offsetof (itti_s11_release_access_bearers_request_t, originating_node)},
+  {NW_GTPV2C_IE_EBI, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL, s11_ebi_ie_get_list, offsetof (itti_s11_release_access_bearers_request_t, list_of_rabs)},
+
+  /*
+   * Do not add below this
+   */
+  {0}
+};
+
+static NwGtpv2cMsgParserInfoT           modify_bearer_request_parser_info;
+static NwGtpv2cMsgParserInfoT           release_access_bearers_request_parser_info;
+
+//------------------------------------------------------------------------------
+void
+s11_sgw_bearer_manager_init (
+  void)
+{
+  DevAssert (NW_OK == nwGtpv2cMsgParserInfoInit (&modify_bearer_request_parser_info, NW_GTP_MODIFY_BEARER_REQ, s11_ie_indication_generic, modify_bearer_request_ie_info_tbl));
+  DevAssert (NW_OK == nwGtpv2cMsgParserInfoInit (&release_access_bearers_request_parser_info, NW_GTP_RELEASE_ACCESS_BEARERS_REQ, s11_ie_indication_generic, release_access_bearers_request_ie_info_tbl));
+}
+
 //------------------------------------------------------------------------------
 int
 s11_sgw_handle_modify_bearer_request (
   NwGtpv2cStackHandleT * stack_p,
+  const task_id_t task_id,
   NwGtpv2cUlpApiT * pUlpApi)
 {
   NwRcT                                   rc = NW_OK;
@@ -49,50 +101,14 @@ s11_sgw_handle_modify_bearer_request (
   uint16_t                                offendingIeLength;
   itti_s11_modify_bearer_request_t       *request_p;
   MessageDef                             *message_p;
-  NwGtpv2cMsgParserT                     *pMsgParser;
 
   DevAssert (stack_p );
-  message_p = itti_alloc_new_message (TASK_S11, S11_MODIFY_BEARER_REQUEST);
+  message_p = itti_alloc_new_message (task_id, S11_MODIFY_BEARER_REQUEST);
   request_p = &message_p->ittiMsg.s11_modify_bearer_request;
   memset(request_p, 0, sizeof(*request_p));
   request_p->trxn = (void *)pUlpApi->apiInfo.initialReqIndInfo.hTrxn;
   request_p->teid = nwGtpv2cMsgGetTeid (pUlpApi->hMsg);
-  /*
-   * Create a new message parser
-   */
-  rc = nwGtpv2cMsgParserNew (*stack_p, NW_GTP_MODIFY_BEARER_REQ, s11_ie_indication_generic, NULL, &pMsgParser);
-  DevAssert (NW_OK == rc);
-  /*
-   * Indication Flags IE
-   */
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_INDICATION, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
-      s11_indication_flags_ie_get, &request_p->indication_flags);
-  DevAssert (NW_OK == rc);
-  /*
-   * MME-FQ-CSID IE
-   */
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_FQ_CSID, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
-      s11_fqcsid_ie_get, &request_p->mme_fq_csid);
-  DevAssert (NW_OK == rc);
-  /*
-   * RAT Type IE
-   */
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_RAT_TYPE, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
-      s11_rat_type_ie_get, &request_p->rat_type);
-  DevAssert (NW_OK == rc);
-  /*
-   * Delay Value IE
-   */
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_DELAY_VALUE, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
-      s11_delay_value_ie_get, &request_p->delay_dl_packet_notif_req);
-  DevAssert (NW_OK == rc);
-  /*
-   * Bearer Context to be modified IE
-   */
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_BEARER_CONTEXT, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
-      s11_bearer_context_to_be_modified_ie_get, &request_p->bearer_contexts_to_be_modified);
-  DevAssert (NW_OK == rc);
-  rc = nwGtpv2cMsgParserRun (pMsgParser, pUlpApi->hMsg, &offendingIeType, &offendingIeInstance, &offendingIeLength);
+  rc = nwGtpv2cMsgParserInfoRun (&modify_bearer_request_parser_info, pUlpApi->hMsg, request_p, &offendingIeType, &offendingIeInstance, &offendingIeLength);
 
   if (rc != NW_OK) {
     gtp_cause_t                             cause;
@@ -128,15 +144,11 @@ s11_sgw_handle_modify_bearer_request (
     DevAssert (NW_OK == rc);
     itti_free (ITTI_MSG_ORIGIN_ID (message_p), message_p);
     message_p = NULL;
-    rc = nwGtpv2cMsgParserDelete (*stack_p, pMsgParser);
-    DevAssert (NW_OK == rc);
     rc = nwGtpv2cMsgDelete (*stack_p, (pUlpApi->hMsg));
     DevAssert (NW_OK == rc);
     return NW_OK;
   }
 
-  rc = nwGtpv2cMsgParserDelete (*stack_p, pMsgParser);
-  DevAssert (NW_OK == rc);
   rc = nwGtpv2cMsgDelete (*stack_p, (pUlpApi->hMsg));
   DevAssert (NW_OK == rc);
   return itti_send_msg_to_task (TASK_SPGW_APP, INSTANCE_DEFAULT, message_p);
@@ -181,6 +193,7 @@ s11_sgw_handle_modify_bearer_response (
 int
 s11_sgw_handle_release_access_bearers_request (
   NwGtpv2cStackHandleT * stack_p,
+  const task_id_t task_id,
   NwGtpv2cUlpApiT * pUlpApi)
 {
   NwRcT                                   rc = NW_OK;
@@ -189,30 +202,15 @@ s11_sgw_handle_release_access_bearers_request (
   uint16_t                                offendingIeLength;
   itti_s11_release_access_bearers_request_t  *request_p = NULL;
   MessageDef                             *message_p = NULL;
-  NwGtpv2cMsgParserT                     *pMsgParser = NULL;
 
   DevAssert (stack_p );
-  message_p = itti_alloc_new_message (TASK_S11, S11_RELEASE_ACCESS_BEARERS_REQUEST);
+  message_p = itti_alloc_new_message (task_id, S11_RELEASE_ACCESS_BEARERS_REQUEST);
   request_p = &message_p->ittiMsg.s11_release_access_bearers_request;
   memset((void*)request_p, 0, sizeof(*request_p));
 
   request_p->trxn = (void *)pUlpApi->apiInfo.initialReqIndInfo.hTrxn;
   request_p->teid = nwGtpv2cMsgGetTeid (pUlpApi->hMsg);
-  /*
-   * Create a new message parser
-   */
-  rc = nwGtpv2cMsgParserNew (*stack_p, NW_GTP_RELEASE_ACCESS_BEARERS_REQ, s11_ie_indication_generic, NULL, &pMsgParser);
-  DevAssert (NW_OK == rc);
-
-
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_NODE_TYPE, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
-      s11_node_type_ie_get, &request_p->originating_node);
-
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_EBI, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
-      s11_ebi_ie_get_list, &request_p->list_of_rabs);
-  DevAssert (NW_OK == rc);
-
-  rc = nwGtpv2cMsgParserRun (pMsgParser, pUlpApi->hMsg, &offendingIeType, &offendingIeInstance, &offendingIeLength);
+  rc = nwGtpv2cMsgParserInfoRun (&release_access_bearers_request_parser_info, pUlpApi->hMsg, request_p, &offendingIeType, &offendingIeInstance, &offendingIeLength);
 
   if (rc != NW_OK) {
     gtp_cause_t                             cause;
@@ -248,15 +246,11 @@ s11_sgw_handle_release_access_bearers_request (
     DevAssert (NW_OK == rc);
     itti_free (ITTI_MSG_ORIGIN_ID (message_p), message_p);
     message_p = NULL;
-    rc = nwGtpv2cMsgParserDelete (*stack_p, pMsgParser);
-    DevAssert (NW_OK == rc);
     rc = nwGtpv2cMsgDelete (*stack_p, (pUlpApi->hMsg));
     DevAssert (NW_OK == rc);
     return RETURNok;
   }
 
-  rc = nwGtpv2cMsgParserDelete (*stack_p, pMsgParser);
-  DevAssert (NW_OK == rc);
   rc = nwGtpv2cMsgDelete (*stack_p, (pUlpApi->hMsg));
   DevAssert (NW_OK == rc);
 
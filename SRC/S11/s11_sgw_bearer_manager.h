@@ -22,8 +22,11 @@
 #ifndef FILE_S11_SGW_BEARER_MANAGER_SEEN
 #define FILE_S11_SGW_BEARER_MANAGER_SEEN
 
+void s11_sgw_bearer_manager_init(void);
+
 int s11_sgw_handle_modify_bearer_request(
   NwGtpv2cStackHandleT *stack_p,
+  const task_id_t       task_id,
   NwGtpv2cUlpApiT      *pUlpApi);
 
 int s11_sgw_handle_modify_bearer_response(
@@ -33,6 +36,7 @@ int s11_sgw_handle_modify_bearer_response(
 int
 s11_sgw_handle_release_access_bearers_request (
   NwGtpv2cStackHandleT * stack_p,
+  const task_id_t task_id,
   NwGtpv2cUlpApiT * pUlpApi);
 
 int s11_sgw_handle_release_access_bearers_response (
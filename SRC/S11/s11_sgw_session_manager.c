@@ -21,6 +21,7 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <stddef.h>
 #include <string.h>
 
 #include "assertions.h"
@@ -37,148 +38,146 @@
 #include "s11_ie_formatter.h"
 #include "log.h"
 
-//------------------------------------------------------------------------------
-int
-s11_sgw_handle_create_session_request (
-  NwGtpv2cStackHandleT * stack_p,
-  NwGtpv2cUlpApiT * pUlpApi)
-{
-  NwRcT                                   rc = NW_OK;
-  uint8_t                                 offendingIeType,
-                                          offendingIeInstance;
-  uint16_t                                offendingIeLength;
-  itti_s11_create_session_request_t      *create_session_request_p;
-  MessageDef                             *message_p;
-  NwGtpv2cMsgParserT                     *pMsgParser;
-
-  DevAssert (stack_p );
-  message_p = itti_alloc_new_message (TASK_S11, S11_CREATE_SESSION_REQUEST);
-  create_session_request_p = &message_p->ittiMsg.s11_create_session_request;
-  /*
-   * Create a new message parser
-   */
-  rc = nwGtpv2cMsgParserNew (*stack_p, NW_GTP_CREATE_SESSION_REQ, s11_ie_indication_generic, NULL, &pMsgParser);
-  DevAssert (NW_OK == rc);
+static const NwGtpv2cMsgParserIeInfoT   create_session_request_ie_info_tbl[] = {
   /*
    * Imsi IE
    */
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_IMSI, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
-		  s11_imsi_ie_get, &create_session_request_p->imsi);
-  DevAssert (NW_OK == rc);
+  {NW_GTPV2C_IE_IMSI, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL, s11_imsi_ie_get, offsetof (itti_s11_create_session_request_t, imsi)},
   /*
    * MSISDN IE
    */
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_MSISDN, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
-		  s11_msisdn_ie_get, &create_session_request_p->msisdn);
-  DevAssert (NW_OK == rc);
+  {NW_GTPV2C_IE_MSISDN, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL, s11_msisdn_ie_get, offsetof (itti_s11_create_session_request_t, msisdn)},
   /*
    * MEI IE
    */
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_MEI, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
-		  s11_mei_ie_get, &create_session_request_p->mei);
-  DevAssert (NW_OK == rc);
+  {NW_GTPV2C_IE_MEI, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL, s11_mei_ie_get, offsetof (itti_s11_create_session_request_t, mei)},
   /*
    * ULI IE
    */
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_ULI, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
-		  s11_uli_ie_get, &create_session_request_p->uli);
-  DevAssert (NW_OK == rc);
+  {NW_GTPV2C_IE_ULI, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL, s11_uli_ie_get, offsetof (itti_s11_create_session_request_t, uli)},
   /*
    * Serving Network IE
    */
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_SERVING_NETWORK, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
-		  s11_serving_network_ie_get, &create_session_request_p->serving_network);
-  DevAssert (NW_OK == rc);
+  {NW_GTPV2C_IE_SERVING_NETWORK, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL, s11_serving_network_ie_get, offsetof (itti_s11_create_session_request_t, serving_network)},
   /*
    * RAT Type IE
    */
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_RAT_TYPE, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_MANDATORY,
-		  s11_rat_type_ie_get, &create_session_request_p->rat_type);
-  DevAssert (NW_OK == rc);
+  {NW_GTPV2C_IE_RAT_TYPE, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_MANDATORY, s11_rat_type_ie_get, offsetof (itti_s11_create_session_request_t, rat_type)},
   /*
    * Indication Flags IE
    */
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_INDICATION, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
-		  s11_indication_flags_ie_get, &create_session_request_p->indication_flags);
-  DevAssert (NW_OK == rc);
+  {NW_GTPV2C_IE_INDICATION, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL, s11_indication_flags_ie_get, offsetof (itti_s11_create_session_request_t, indication_flags)},
   /*
    * APN IE
    */
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_APN, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_MANDATORY,
-		  s11_apn_ie_get, &create_session_request_p->apn);
-  DevAssert (NW_OK == rc);
+  {NW_GTPV2C_IE_APN, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_MANDATORY, s11_apn_ie_get, offsetof (itti_s11_create_session_request_t, apn)},
   /*
    * Selection Mode IE
    */
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_SELECTION_MODE, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
-		  s11_ie_indication_generic, NULL);
-  DevAssert (NW_OK == rc);
+  {NW_GTPV2C_IE_SELECTION_MODE, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL, s11_ie_indication_generic, NW_GTPV2C_IE_NO_VALUE},
   /*
    * PDN Type IE
    */
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_PDN_TYPE, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
-		  s11_pdn_type_ie_get, &create_session_request_p->pdn_type);
-  DevAssert (NW_OK == rc);
+  {NW_GTPV2C_IE_PDN_TYPE, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL, s11_pdn_type_ie_get, offsetof (itti_s11_create_session_request_t, pdn_type)},
   /*
    * PAA IE
    */
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_PAA, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
-           s11_paa_ie_get, &create_session_request_p->paa);
-  DevAssert (NW_OK == rc);
+  {NW_GTPV2C_IE_PAA, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL, s11_paa_ie_get, offsetof (itti_s11_create_session_request_t, paa)},
   /*
    * Sender FTEID for CP IE
    */
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_FTEID, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_MANDATORY,
-           s11_fteid_ie_get, &create_session_request_p->sender_fteid_for_cp);
-  DevAssert (NW_OK == rc);
+  {NW_GTPV2C_IE_FTEID, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_MANDATORY, s11_fteid_ie_get, offsetof (itti_s11_create_session_request_t, sender_fteid_for_cp)},
   /*
    * PGW FTEID for CP IE
    */
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_FTEID, NW_GTPV2C_IE_INSTANCE_ONE, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
-		  s11_fteid_ie_get, &create_session_request_p->pgw_address_for_cp);
-  DevAssert (NW_OK == rc);
+  {NW_GTPV2C_IE_FTEID, NW_GTPV2C_IE_INSTANCE_ONE, NW_GTPV2C_IE_PRESENCE_CONDITIONAL, s11_fteid_ie_get, offsetof (itti_s11_create_session_request_t, pgw_address_for_cp)},
   /*
    * APN Restriction IE
    */
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_APN_RESTRICTION, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
-           s11_ie_indication_generic, NULL);
-  DevAssert (NW_OK == rc);
+  {NW_GTPV2C_IE_APN_RESTRICTION, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL, s11_ie_indication_generic, NW_GTPV2C_IE_NO_VALUE},
   /*
    * Bearer Context IE
    */
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_BEARER_CONTEXT, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_MANDATORY,
-           s11_bearer_context_to_be_created_ie_get, &create_session_request_p->bearer_contexts_to_be_created);
-  DevAssert (NW_OK == rc);
-
-
+  {NW_GTPV2C_IE_BEARER_CONTEXT, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_MANDATORY, s11_bearer_context_to_be_created_ie_get, offsetof (itti_s11_create_session_request_t, bearer_contexts_to_be_created)},
   /*
    * Protocol Configuration Options IE
    */
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_PCO, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
-      s11_pco_ie_get, &create_session_request_p->pco);
-  DevAssert (NW_OK == rc);
-
-
-  /*TODO rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_BEARER_CONTEXT, NW_GTPV2C_IE_INSTANCE_ONE, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
-           s11_bearer_context_to_be_removed_ie_get, &create_session_request_p->bearer_contexts_to_be_removed);
-  DevAssert (NW_OK == rc);*/
-
+  {NW_GTPV2C_IE_PCO, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL, s11_pco_ie_get, offsetof (itti_s11_create_session_request_t, pco)},
+  /*
+   * TODO Bearer Contexts to be removed IE
+   */
   /*
    * AMBR IE
    */
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_AMBR, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
-           s11_ambr_ie_get, &create_session_request_p->ambr);
-  DevAssert (NW_OK == rc);
+  {NW_GTPV2C_IE_AMBR, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL, s11_ambr_ie_get, offsetof (itti_s11_create_session_request_t, ambr)},
   /*
    * Recovery IE
    */
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_RECOVERY, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_MANDATORY,
-		  s11_ie_indication_generic, NULL);
-  DevAssert (NW_OK == rc);
+  {NW_GTPV2C_IE_RECOVERY, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_MANDATORY, s11_ie_indication_generic, NW_GTPV2C_IE_NO_VALUE},
+
+  /*
+   * Do not add below this
+   */
+  {0}
+};
+
+static const NwGtpv2cMsgParserIeInfoT   delete_session_request_ie_info_tbl[] = {
+  /*
+   * MME FTEID for CP IE
+   */
+  {NW_GTPV2C_IE_FTEID, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_OPTIONAL, s11_fteid_ie_get, offsetof (itti_s11_delete_session_request_t, sender_fteid_for_cp)},
+  /*
+   * Linked EPS Bearer Id IE
+   * * * * This information element shall not be present for TAU/RAU/Handover with
+   * * * * S-GW relocation procedures.
+   */
+  {NW_GTPV2C_IE_EBI, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_OPTIONAL, s11_ebi_ie_get, offsetof (itti_s11_delete_session_request_t, lbi)},
+  /*
+   * Indication Flags IE
+   * * * * For a Delete Session Request on S11 interface,
+   * * * * only the Operation Indication flag might be present.
+   */
+  {NW_GTPV2C_IE_INDICATION, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL, s11_indication_flags_ie_get, offsetof (itti_s11_delete_session_request_t, indication_flags)},
+
+  /*
+   * Do not add below this
+   */
+  {0}
+};
+
+static NwGtpv2cMsgParserInfoT           create_session_request_parser_info;
+static NwGtpv2cMsgParserInfoT           delete_session_request_parser_info;
+
+//------------------------------------------------------------------------------
+void
+s11_sgw_session_manager_init (
+  void)
+{
+  DevAssert (NW_OK == nwGtpv2cMsgParserInfoInit (&create_session_request_parser_info, NW_GTP_CREATE_SESSION_REQ, s11_ie_indication_generic, create_session_request_ie_info_tbl));
+  DevAssert (NW_OK == nwGtpv2cMsgParserInfoInit (&delete_session_request_parser_info, NW_GTP_DELETE_SESSION_REQ, s11_ie_indication_generic, delete_session_request_ie_info_tbl));
+}
+
+//------------------------------------------------------------------------------
+int
+s11_sgw_handle_create_session_request (
+  NwGtpv2cStackHandleT * stack_p,
+  const task_id_t task_id,
+  NwGtpv2cUlpApiT * pUlpApi)
+{
+  NwRcT                                   rc = NW_OK;
+  uint8_t                                 offendingIeType,
+                                          offendingIeInstance;
+  uint16_t                                offendingIeLength;
+  itti_s11_create_session_request_t      *create_session_request_p;
+  MessageDef                             *message_p;
+
+  DevAssert (stack_p );
+  message_p = itti_alloc_new_message (task_id, S11_CREATE_SESSION_REQUEST);
+  create_session_request_p = &message_p->ittiMsg.s11_create_session_request;
   create_session_request_p->teid = nwGtpv2cMsgGetTeid (pUlpApi->hMsg);
   create_session_request_p->trxn = (void *)pUlpApi->apiInfo.initialReqIndInfo.hTrxn;
   create_session_request_p->peer_ip = pUlpApi->apiInfo.initialReqIndInfo.peerIp;
-  rc = nwGtpv2cMsgParserRun (pMsgParser, pUlpApi->hMsg, &offendingIeType, &offendingIeInstance, &offendingIeLength);
+  rc = nwGtpv2cMsgParserInfoRun (&create_session_request_parser_info, pUlpApi->hMsg, create_session_request_p, &offendingIeType, &offendingIeInstance, &offendingIeLength);
 
   if (rc != NW_OK) {
     gtp_cause_t                             cause;
@@ -214,15 +213,11 @@ s11_sgw_handle_create_session_request (
     DevAssert (NW_OK == rc);
     itti_free (ITTI_MSG_ORIGIN_ID (message_p), message_p);
     message_p = NULL;
-    rc = nwGtpv2cMsgParserDelete (*stack_p, pMsgParser);
-    DevAssert (NW_OK == rc);
     rc = nwGtpv2cMsgDelete (*stack_p, (pUlpApi->hMsg));
     DevAssert (NW_OK == rc);
     return RETURNok;
   }
 
-  rc = nwGtpv2cMsgParserDelete (*stack_p, pMsgParser);
-  DevAssert (NW_OK == rc);
   rc = nwGtpv2cMsgDelete (*stack_p, (pUlpApi->hMsg));
   DevAssert (NW_OK == rc);
   return itti_send_msg_to_task (TASK_SPGW_APP, INSTANCE_DEFAULT, message_p);
@@ -299,6 +294,7 @@ s11_sgw_handle_create_session_response (
 int
 s11_sgw_handle_delete_session_request (
   NwGtpv2cStackHandleT * stack_p,
+  const task_id_t task_id,
   NwGtpv2cUlpApiT * pUlpApi)
 {
   NwRcT                                   rc = NW_OK;
@@ -307,43 +303,15 @@ s11_sgw_handle_delete_session_request (
   uint16_t                                offendingIeLength;
   itti_s11_delete_session_request_t      *delete_session_request_p;
   MessageDef                             *message_p;
-  NwGtpv2cMsgParserT                     *pMsgParser;
 
   DevAssert (stack_p );
-  message_p = itti_alloc_new_message (TASK_S11, S11_DELETE_SESSION_REQUEST);
+  message_p = itti_alloc_new_message (task_id, S11_DELETE_SESSION_REQUEST);
   delete_session_request_p = &message_p->ittiMsg.s11_delete_session_request;
   memset((void*)delete_session_request_p, 0, sizeof(*delete_session_request_p));
-  /*
-   * Create a new message parser
-   */
-  rc = nwGtpv2cMsgParserNew (*stack_p, NW_GTP_DELETE_SESSION_REQ, s11_ie_indication_generic, NULL, &pMsgParser);
-  DevAssert (NW_OK == rc);
-  /*
-   * MME FTEID for CP IE
-   */
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_FTEID, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_OPTIONAL,
-      s11_fteid_ie_get, &delete_session_request_p->sender_fteid_for_cp);
-  DevAssert (NW_OK == rc);
-  /*
-   * Linked EPS Bearer Id IE
-   * * * * This information element shall not be present for TAU/RAU/Handover with
-   * * * * S-GW relocation procedures.
-   */
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_EBI, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_OPTIONAL,
-      s11_ebi_ie_get, &delete_session_request_p->lbi);
-  DevAssert (NW_OK == rc);
-  /*
-   * Indication Flags IE
-   * * * * For a Delete Session Request on S11 interface,
-   * * * * only the Operation Indication flag might be present.
-   */
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_INDICATION, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
-      s11_indication_flags_ie_get, &delete_session_request_p->indication_flags);
-  DevAssert (NW_OK == rc);
   delete_session_request_p->teid = nwGtpv2cMsgGetTeid (pUlpApi->hMsg);
   delete_session_request_p->trxn = (void *)pUlpApi->apiInfo.initialReqIndInfo.hTrxn;
   delete_session_request_p->peer_ip = pUlpApi->apiInfo.initialReqIndInfo.peerIp;
-  rc = nwGtpv2cMsgParserRun (pMsgParser, pUlpApi->hMsg, &offendingIeType, &offendingIeInstance, &offendingIeLength);
+  rc = nwGtpv2cMsgParserInfoRun (&delete_session_request_parser_info, pUlpApi->hMsg, delete_session_request_p, &offendingIeType, &offendingIeInstance, &offendingIeLength);
 
   if (rc != NW_OK) {
     NwGtpv2cUlpApiT                         ulp_req;
@@ -381,15 +349,11 @@ s11_sgw_handle_delete_session_request (
     DevAssert (NW_OK == rc);
     itti_free (ITTI_MSG_ORIGIN_ID (message_p), message_p);
     message_p = NULL;
-    rc = nwGtpv2cMsgParserDelete (*stack_p, pMsgParser);
-    DevAssert (NW_OK == rc);
     rc = nwGtpv2cMsgDelete (*stack_p, (pUlpApi->hMsg));
     DevAssert (NW_OK == rc);
     return NW_OK;
   }
 
-  rc = nwGtpv2cMsgParserDelete (*stack_p, pMsgParser);
-  DevAssert (NW_OK == rc);
   rc = nwGtpv2cMsgDelete (*stack_p, (pUlpApi->hMsg));
   DevAssert (NW_OK == rc);
   return itti_send_msg_to_task (TASK_SPGW_APP, INSTANCE_DEFAULT, message_p);
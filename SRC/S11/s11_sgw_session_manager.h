@@ -22,8 +22,11 @@
 #ifndef FILE_S11_SGW_SESSION_MANAGER_SEEN
 #define FILE_S11_SGW_SESSION_MANAGER_SEEN
 
+void s11_sgw_session_manager_init(void);
+
 int s11_sgw_handle_create_session_request(
   NwGtpv2cStackHandleT *stack_p,
+  const task_id_t       task_id,
   NwGtpv2cUlpApiT      *pUlpApi);
 
 int s11_sgw_handle_create_session_response(
@@ -32,6 +35,7 @@ int s11_sgw_handle_create_session_response(
 
 int s11_sgw_handle_delete_session_request(
   NwGtpv2cStackHandleT *stack_p,
+  const task_id_t       task_id,
   NwGtpv2cUlpApiT      *pUlpApi);
 
 int s11_sgw_handle_delete_session_response(
@@ -53,6 +53,12 @@ uint32_t                                nb_enb_associated = 0;
 
 hash_table_ts_t g_s1ap_enb_coll = {.mutex = PTHREAD_MUTEX_INITIALIZER, 0}; // contains eNB_description_s, key is eNB_description_s.enb_id (uint32_t);
 hash_table_ts_t g_s1ap_mme_id2assoc_id_coll = {.mutex = PTHREAD_MUTEX_INITIALIZER, 0}; // contains sctp association id, key is mme_ue_s1ap_id;
+/*
+ * Secondary indexes, they do not own the descriptors (stored in g_s1ap_enb_coll and enb_description_s.ue_coll)
+ */
+hash_table_ts_t g_s1ap_enb_id_coll = {.mutex = PTHREAD_MUTEX_INITIALIZER, 0}; // contains eNB_description_s, key is eNB_description_s.enb_id;
+hash_table_ts_t g_s1ap_mme_ue_id_coll = {.mutex = PTHREAD_MUTEX_INITIALIZER, 0}; // contains ue_description_s, key is ue_description_s.mme_ue_s1ap_id;
+hash_table_ts_t g_s1ap_s11_teid_coll = {.mutex = PTHREAD_MUTEX_INITIALIZER, 0}; // contains ue_description_s, key is ue_description_s.s11_sgw_teid;
 
 static int                              indent = 0;
  void *s1ap_mme_thread (void *args);
@@ -215,6 +221,38 @@ s1ap_mme_thread (
   return NULL;
 }
 
+//------------------------------------------------------------------------------
+int
+s1ap_mme_init_lists(void)
+{
+  // 16 entries for n eNB.
+  bstring bs1 = bfromcstr("s1ap_eNB_coll");
+  hash_table_ts_t* h = hashtable_ts_init (&g_s1ap_enb_coll, mme_config.max_enbs, NULL, free_wrapper, bs1);
+  bdestroy(bs1);
+  if (!h) return RETURNerror;
+
+  bstring bs2 = bfromcstr("s1ap_mme_id2assoc_id_coll");
+  h = hashtable_ts_init (&g_s1ap_mme_id2assoc_id_coll, mme_config.max_ues, NULL, hash_free_int_func, bs2);
+  bdestroy(bs2);
+  if (!h) return RETURNerror;
+
+  bstring bs3 = bfromcstr("s1ap_enb_id_coll");
+  h = hashtable_ts_init (&g_s1ap_enb_id_coll, mme_config.max_enbs, NULL, hash_free_int_func, bs3);
+  bdestroy(bs3);
+  if (!h) return RETURNerror;
+
+  bstring bs4 = bfromcstr("s1ap_mme_ue_id_coll");
+  h = hashtable_ts_init (&g_s1ap_mme_ue_id_coll, mme_config.max_ues, NULL, hash_free_int_func, bs4);
+  bdestroy(bs4);
+  if (!h) return RETURNerror;
+
+  bstring bs5 = bfromcstr("s1ap_s11_teid_coll");
+  h = hashtable_ts_init (&g_s1ap_s11_teid_coll, mme_config.max_ues, NULL, hash_free_int_func, bs5);
+  bdestroy(bs5);
+  if (!h) return RETURNerror;
+  return RETURNok;
+}
+
 //------------------------------------------------------------------------------
 int
 s1ap_mme_init(void)
@@ -229,16 +267,9 @@ s1ap_mme_init(void)
   }
 
   OAILOG_DEBUG (LOG_S1AP, "S1AP Release v10.5\n");
-  // 16 entries for n eNB.
-  bstring bs1 = bfromcstr("s1ap_eNB_coll");
-  hash_table_ts_t* h = hashtable_ts_init (&g_s1ap_enb_coll, mme_config.max_enbs, NULL, free_wrapper, bs1);
-  bdestroy(bs1);
-  if (!h) return RETURNerror;
-
-  bstring bs2 = bfromcstr("s1ap_mme_id2assoc_id_coll");
-  h = hashtable_ts_init (&g_s1ap_mme_id2assoc_id_coll, mme_config.max_ues, NULL, hash_free_int_func, bs2);
-  bdestroy(bs2);
-  if (!h) return RETURNerror;
+  if (s1ap_mme_init_lists () != RETURNok) {
+    return RETURNerror;
+  }
 
   if (itti_create_task (TASK_S1AP, &s1ap_mme_thread, NULL) < 0) {
     OAILOG_ERROR (LOG_S1AP, "Error while creating S1AP task\n");
@@ -355,8 +386,7 @@ s1ap_is_enb_id_in_list (
   const uint32_t enb_id)
 {
   enb_description_t                      *enb_ref = NULL;
-  uint32_t                               *enb_id_p  = (uint32_t*)&enb_id;
-  hashtable_ts_apply_callback_on_elements((hash_table_ts_t * const)&g_s1ap_enb_coll, s1ap_enb_compare_by_enb_id_cb, (void *)enb_id_p, (void**)&enb_ref);
+  hashtable_ts_get (&g_s1ap_enb_id_coll, (const hash_key_t)enb_id, (void**)&enb_ref);
   return enb_ref;
 }
 
@@ -395,83 +425,68 @@ s1ap_is_ue_enb_id_in_list (
 }
 
 //------------------------------------------------------------------------------
-bool s1ap_ue_compare_by_mme_ue_id_cb (__attribute__((unused)) const hash_key_t keyP,
-                                      void * const elementP, void * parameterP, void **resultP)
+ue_description_t                       *
+s1ap_is_ue_mme_id_in_list (
+  const mme_ue_s1ap_id_t mme_ue_s1ap_id)
 {
-  mme_ue_s1ap_id_t                      * mme_ue_s1ap_id_p = (mme_ue_s1ap_id_t*)parameterP;
-  ue_description_t                       *ue_ref           = (ue_description_t*)elementP;
-  if ( *mme_ue_s1ap_id_p == ue_ref->mme_ue_s1ap_id ) {
-    *resultP = elementP;
-    OAILOG_TRACE(LOG_S1AP, "Found ue_ref %p mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT "\n", ue_ref, ue_ref->mme_ue_s1ap_id);
-    return true;
-  }
-  return false;
+  ue_description_t                       *ue_ref = NULL;
+
+  hashtable_ts_get (&g_s1ap_mme_ue_id_coll, (const hash_key_t)mme_ue_s1ap_id, (void**)&ue_ref);
+  OAILOG_TRACE(LOG_S1AP, "Return ue_ref %p \n", ue_ref);
+  return ue_ref;
 }
 
 //------------------------------------------------------------------------------
-bool s1ap_enb_find_ue_by_mme_ue_id_cb (__attribute__((unused))const hash_key_t keyP,
-                                       void * const elementP, void * parameterP, void **resultP)
+// TODO(amar) unused function check with OAI.
+ue_description_t                       *
+s1ap_is_s11_sgw_teid_in_list (
+  const s11_teid_t teid)
 {
-  enb_description_t                      *enb_ref = (enb_description_t*)elementP;
+  ue_description_t                       *ue_ref = NULL;
 
-  hashtable_ts_apply_callback_on_elements((hash_table_ts_t * const)&enb_ref->ue_coll, s1ap_ue_compare_by_mme_ue_id_cb, parameterP, resultP);
-  if (*resultP) {
-    OAILOG_TRACE(LOG_S1AP, "Found ue_ref %p mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT "\n", *resultP, ((ue_description_t*)(*resultP))->mme_ue_s1ap_id);
-    return true;
-  }
-  return false;
-}
-//------------------------------------------------------------------------------
-bool s1ap_ue_compare_by_s11_sgw_teid_cb (__attribute__((unused))const hash_key_t keyP,
-                                         void * const elementP,
-                                         void *parameterP, void **resultP)
-{
-  s11_teid_t                       * s11_sgw_teid_p = (s11_teid_t*)parameterP;
-  ue_description_t                  *ue_ref         = (ue_description_t*)elementP;
-  if ( *s11_sgw_teid_p == ue_ref->s11_sgw_teid ) {
-    *resultP = elementP;
-    return true;
-  }
-  return false;
+  hashtable_ts_get (&g_s1ap_s11_teid_coll, (const hash_key_t)teid, (void**)&ue_ref);
+  return ue_ref;
 }
 
 //------------------------------------------------------------------------------
-bool s1ap_enb_find_ue_by_s11_sgw_teid_cb (__attribute((unused)) const hash_key_t keyP,
-                                          void * const elementP, void * parameterP, void **resultP)
+// Removes the index entry only if it still refers to the descriptor, the key may have been taken over by a newer one
+static void
+s1ap_remove_index_entry (
+  hash_table_ts_t * const coll,
+  const hash_key_t key,
+  const void * const ref)
 {
-  enb_description_t                      *enb_ref = (enb_description_t*)elementP;
+  void                                   *indexed_ref = NULL;
 
-  hashtable_ts_apply_callback_on_elements((hash_table_ts_t * const)&enb_ref->ue_coll, s1ap_ue_compare_by_s11_sgw_teid_cb, parameterP, resultP);
-  if (*resultP) {
-    return true;
+  if ((HASH_TABLE_OK == hashtable_ts_get (coll, key, &indexed_ref)) && (indexed_ref == ref)) {
+    hashtable_ts_remove (coll, key, &indexed_ref);
   }
-  return false;
 }
 
 //------------------------------------------------------------------------------
-ue_description_t                       *
-s1ap_is_ue_mme_id_in_list (
-  const mme_ue_s1ap_id_t mme_ue_s1ap_id)
+void
+s1ap_set_enb_id (
+  enb_description_t * const enb_ref,
+  const uint32_t enb_id)
 {
-  ue_description_t                       *ue_ref = NULL;
-  mme_ue_s1ap_id_t                       *mme_ue_s1ap_id_p = (mme_ue_s1ap_id_t*)&mme_ue_s1ap_id;
-
-  hashtable_ts_apply_callback_on_elements(&g_s1ap_enb_coll, s1ap_enb_find_ue_by_mme_ue_id_cb, (void*)mme_ue_s1ap_id_p, (void**)&ue_ref);
-  OAILOG_TRACE(LOG_S1AP, "Return ue_ref %p \n", ue_ref);
-  return ue_ref;
+  s1ap_remove_index_entry (&g_s1ap_enb_id_coll, (const hash_key_t)enb_ref->enb_id, enb_ref);
+  enb_ref->enb_id = enb_id;
+  hashtable_ts_insert (&g_s1ap_enb_id_coll, (const hash_key_t)enb_id, (void *)enb_ref);
 }
 
 //------------------------------------------------------------------------------
-// TODO(amar) unused function check with OAI.
-ue_description_t                       *
-s1ap_is_s11_sgw_teid_in_list (
-  const s11_teid_t teid)
+void
+s1ap_set_ue_s11_sgw_teid (
+  ue_description_t * const ue_ref,
+  const s11_teid_t s11_sgw_teid)
 {
-  ue_description_t                       *ue_ref = NULL;
-  s11_teid_t                             *teid_id_p = (s11_teid_t*)&teid;
-
-  hashtable_ts_apply_callback_on_elements(&g_s1ap_enb_coll, s1ap_enb_find_ue_by_s11_sgw_teid_cb, (void *)teid_id_p, (void**)&ue_ref);
-  return ue_ref;
+  if (ue_ref->s11_sgw_teid) {
+    s1ap_remove_index_entry (&g_s1ap_s11_teid_coll, (const hash_key_t)ue_ref->s11_sgw_teid, ue_ref);
+  }
+  ue_ref->s11_sgw_teid = s11_sgw_teid;
+  if (s11_sgw_teid) {
+    hashtable_ts_insert (&g_s1ap_s11_teid_coll, (const hash_key_t)s11_sgw_teid, (void *)ue_ref);
+  }
 }
 
 //------------------------------------------------------------------------------
@@ -484,7 +499,11 @@ void s1ap_notified_new_ue_mme_s1ap_id_association (
   if (enb_ref) {
     ue_description_t   *ue_ref = s1ap_is_ue_enb_id_in_list (enb_ref,enb_ue_s1ap_id);
     if (ue_ref) {
+      if (ue_ref->mme_ue_s1ap_id != INVALID_MME_UE_S1AP_ID) {
+        s1ap_remove_index_entry (&g_s1ap_mme_ue_id_coll, (const hash_key_t)ue_ref->mme_ue_s1ap_id, ue_ref);
+      }
       ue_ref->mme_ue_s1ap_id = mme_ue_s1ap_id;
+      hashtable_ts_insert (&g_s1ap_mme_ue_id_coll, (const hash_key_t)mme_ue_s1ap_id, (void *)ue_ref);
       hashtable_rc_t  h_rc = hashtable_ts_insert (&g_s1ap_mme_id2assoc_id_coll, (const hash_key_t) mme_ue_s1ap_id, (void *)(uintptr_t)sctp_assoc_id);
       OAILOG_DEBUG(LOG_S1AP, "Associated  sctp_assoc_id %d, enb_ue_s1ap_id " ENB_UE_S1AP_ID_FMT ", mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT ":%s \n",
           sctp_assoc_id, enb_ue_s1ap_id, mme_ue_s1ap_id, hashtable_rc_code2string(h_rc));
@@ -496,6 +515,21 @@ void s1ap_notified_new_ue_mme_s1ap_id_association (
   OAILOG_DEBUG(LOG_S1AP, "Could not find  eNB with sctp_assoc_id %d \n", sctp_assoc_id);
 }
 
+//------------------------------------------------------------------------------
+void s1ap_notified_new_ue_s11_sgw_teid_association (
+    const mme_ue_s1ap_id_t mme_ue_s1ap_id,
+    const s11_teid_t       s11_sgw_teid)
+{
+  ue_description_t   *ue_ref = s1ap_is_ue_mme_id_in_list (mme_ue_s1ap_id);
+  if (ue_ref) {
+    s1ap_set_ue_s11_sgw_teid (ue_ref, s11_sgw_teid);
+    OAILOG_DEBUG(LOG_S1AP, "Associated mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT " with S11 SGW teid " TEID_FMT "\n",
+        mme_ue_s1ap_id, s11_sgw_teid);
+    return;
+  }
+  OAILOG_DEBUG(LOG_S1AP, "Could not find  ue  with mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT "\n", mme_ue_s1ap_id);
+}
+
 //------------------------------------------------------------------------------
 enb_description_t                      *
 s1ap_new_enb (
@@ -513,12 +547,28 @@ s1ap_new_enb (
   // Update number of eNB associated
   nb_enb_associated++;
   bstring bs = bfromcstr("s1ap_ue_coll");
-  hashtable_ts_init(&enb_ref->ue_coll, mme_config.max_ues, NULL, free_wrapper, bs);
+  hashtable_ts_init(&enb_ref->ue_coll, S1AP_ENB_UE_COLL_INITIAL_SIZE, NULL, free_wrapper, bs);
   bdestroy(bs);
   enb_ref->nb_ue_associated = 0;
+  enb_ref->ue_coll_memory = hashtable_ts_memory_size (&enb_ref->ue_coll);
+  update_mme_app_stats_enb_ue_lists_memory (1, enb_ref->ue_coll_memory);
   return enb_ref;
 }
 
+//------------------------------------------------------------------------------
+// The UE list only grows, its memory is updated when a UE is added
+static void
+s1ap_update_ue_coll_memory (
+  enb_description_t * const enb_ref)
+{
+  size_t                                  ue_coll_memory = hashtable_ts_memory_size (&enb_ref->ue_coll);
+
+  if (ue_coll_memory != enb_ref->ue_coll_memory) {
+    update_mme_app_stats_enb_ue_lists_memory (0, (ssize_t)ue_coll_memory - (ssize_t)enb_ref->ue_coll_memory);
+    enb_ref->ue_coll_memory = ue_coll_memory;
+  }
+}
+
 //------------------------------------------------------------------------------
 ue_description_t                       *
 s1ap_new_ue (
@@ -545,11 +595,41 @@ s1ap_new_ue (
     free_wrapper((void**) &ue_ref);
     return NULL;
   }
+  /*
+   * mme_ue_s1ap_id and s11_sgw_teid are not known yet, the UE is indexed by
+   * s1ap_notified_new_ue_mme_s1ap_id_association() and s1ap_set_ue_s11_sgw_teid()
+   */
   // Increment number of UE
   enb_ref->nb_ue_associated++;
+  s1ap_update_ue_coll_memory (enb_ref);
   return ue_ref;
 }
 
+//------------------------------------------------------------------------------
+static void
+s1ap_remove_ue_indexes (
+  const ue_description_t * const ue_ref)
+{
+  if (ue_ref->mme_ue_s1ap_id != INVALID_MME_UE_S1AP_ID) {
+    s1ap_remove_index_entry (&g_s1ap_mme_ue_id_coll, (const hash_key_t)ue_ref->mme_ue_s1ap_id, ue_ref);
+  }
+  if (ue_ref->s11_sgw_teid) {
+    s1ap_remove_index_entry (&g_s1ap_s11_teid_coll, (const hash_key_t)ue_ref->s11_sgw_teid, ue_ref);
+  }
+}
+
+//------------------------------------------------------------------------------
+static bool
+s1ap_remove_ue_indexes_cb (
+  __attribute__((unused)) const hash_key_t keyP,
+  void * const elementP,
+  __attribute__((unused)) void *parameterP,
+  __attribute__((unused)) void **resultP)
+{
+  s1ap_remove_ue_indexes ((ue_description_t*)elementP);
+  return false;
+}
+
 //------------------------------------------------------------------------------
 void
 s1ap_remove_ue (
@@ -583,6 +663,7 @@ s1ap_remove_ue (
   //     s1ap_timer_remove_ue(ue_ref->mme_ue_s1ap_id);
   OAILOG_TRACE(LOG_S1AP, "Removing UE enb_ue_s1ap_id: " ENB_UE_S1AP_ID_FMT " mme_ue_s1ap_id:" MME_UE_S1AP_ID_FMT " in eNB id : %d\n",
       ue_ref->enb_ue_s1ap_id, ue_ref->mme_ue_s1ap_id, enb_ref->enb_id);
+  s1ap_remove_ue_indexes (ue_ref);
   hashtable_ts_free (&enb_ref->ue_coll, ue_ref->enb_ue_s1ap_id);
 
   if (!enb_ref->nb_ue_associated) {
@@ -604,6 +685,9 @@ s1ap_remove_enb (
 {
   if (enb_ref == NULL)
     return;
+  hashtable_ts_apply_callback_on_elements (&enb_ref->ue_coll, s1ap_remove_ue_indexes_cb, NULL, NULL);
+  s1ap_remove_index_entry (&g_s1ap_enb_id_coll, (const hash_key_t)enb_ref->enb_id, enb_ref);
+  update_mme_app_stats_enb_ue_lists_memory (-1, -(ssize_t)enb_ref->ue_coll_memory);
   hashtable_ts_destroy(&enb_ref->ue_coll);
   hashtable_ts_free (&g_s1ap_enb_coll, enb_ref->sctp_assoc_id);
   nb_enb_associated--;
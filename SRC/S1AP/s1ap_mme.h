@@ -35,6 +35,7 @@ struct enb_description_s;
 
 #define S1AP_TIMER_INACTIVE_ID   (-1)
 #define S1AP_UE_CONTEXT_REL_COMP_TIMER 2 // in seconds 
+#define S1AP_ENB_UE_COLL_INITIAL_SIZE  16 // UEs, the UE list of an eNB grows with its UEs
 
 /* Timer structure */
 struct s1ap_timer_t {
@@ -107,7 +108,8 @@ typedef struct enb_description_s {
   /** UE list for this eNB **/
   /*@{*/
   uint32_t nb_ue_associated; ///< Number of NAS associated UE on this eNB
-  hash_table_ts_t  ue_coll; // contains ue_description_s, key is ue_description_s.?;
+  hash_table_ts_t  ue_coll; // contains ue_description_s, key is ue_description_s.enb_ue_s1ap_id;
+  size_t   ue_coll_memory;   ///< Memory allocated by ue_coll, as reported to MME statistics
   /*@}*/
 
   /** SCTP stuff **/
@@ -128,6 +130,11 @@ extern mme_config_t    *global_mme_config_p;
  **/
 int s1ap_mme_init(void);
 
+/** \brief Initialize the eNB and UE lists, and their indexes
+ * @returns -1 in case of failure
+ **/
+int s1ap_mme_init_lists(void);
+
 /** \brief Look for given eNB id in the list
  * \param enb_id The unique eNB id to search in list
  * @returns NULL if no eNB matchs the eNB id, or reference to the eNB element in list if matches
@@ -154,6 +161,18 @@ ue_description_t* s1ap_is_ue_enb_id_in_list(enb_description_t *enb_ref,
 ue_description_t* s1ap_is_ue_mme_id_in_list(const mme_ue_s1ap_id_t ue_mme_id);
 ue_description_t* s1ap_is_s11_sgw_teid_in_list(const s11_teid_t teid);
 
+/** \brief Set the eNB id of the eNB, and index the eNB by it
+ * \param enb_ref eNB structure reference
+ * \param enb_id The unique eNB id received in S1 Setup Request
+ **/
+void s1ap_set_enb_id(enb_description_t * const enb_ref, const uint32_t enb_id);
+
+/** \brief Set the S11 SGW TEID of the UE, and index the UE by it
+ * \param ue_ref UE structure reference
+ * \param s11_sgw_teid The S11 SGW TEID of the UE, 0 if none
+ **/
+void s1ap_set_ue_s11_sgw_teid(ue_description_t * const ue_ref, const s11_teid_t s11_sgw_teid);
+
 /** \brief associate mainly 2(3) identifiers in S1AP layer: {mme_ue_s1ap_id_t, sctp_assoc_id (,enb_ue_s1ap_id)}
  **/
 void s1ap_notified_new_ue_mme_s1ap_id_association (
@@ -161,6 +180,12 @@ void s1ap_notified_new_ue_mme_s1ap_id_association (
     const enb_ue_s1ap_id_t enb_ue_s1ap_id,
     const mme_ue_s1ap_id_t mme_ue_s1ap_id);
 
+/** \brief associate the S11 SGW TEID learnt by MME_APP with the UE identified by its mme_ue_s1ap_id
+ **/
+void s1ap_notified_new_ue_s11_sgw_teid_association (
+    const mme_ue_s1ap_id_t mme_ue_s1ap_id,
+    const s11_teid_t       s11_sgw_teid);
+
 /** \brief Allocate and add to the list a new eNB descriptor
  * @returns Reference to the new eNB element in list
  **/
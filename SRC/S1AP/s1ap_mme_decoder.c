@@ -30,70 +30,133 @@
 #include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdbool.h>
 
 #include "assertions.h"
 #include "s1ap_common.h"
 #include "s1ap_ies_defs.h"
+#include "s1ap_mme_decoder.h"
 #include "s1ap_mme_handlers.h"
+#include "intertask_interface_dump.h"
 #include "dynamic_memory_check.h"
 
+/* Renders a decoded message as XER text */
+typedef asn_enc_rval_t (*s1ap_xer_print_t) (asn_app_consume_bytes_f *cb, void *app_key, s1ap_message *message_p);
+
+static s1ap_xer_print_mode_t            s1ap_xer_print_mode = S1AP_XER_PRINT_ON_DEMAND;
+
+//------------------------------------------------------------------------------
+void
+s1ap_mme_decoder_set_xer_print_mode (
+  const s1ap_xer_print_mode_t mode)
+{
+  s1ap_xer_print_mode = mode;
+}
+
+//------------------------------------------------------------------------------
+static int
+s1ap_xer_print2bstr (
+  const void *buffer,
+  size_t size,
+  void *app_key)
+{
+  return bcatblk ((bstring) app_key, buffer, size);
+}
+
+//------------------------------------------------------------------------------
+/*
+   The XER text of decoded messages is only read by the ITTI analyzer (or dump file) and the S1AP trace log,
+   rendering it costs more than decoding the PDU, so it is skipped unless one of them is there to read it.
+*/
+static void
+s1ap_mme_decode_log (
+  const MessagesIds message_id,
+  const s1ap_xer_print_t xer_print,
+  s1ap_message * const message)
+{
+  MessageDef                             *message_p = NULL;
+  bstring                                 message_string = NULL;
+  bool                                    to_itti = (s1ap_xer_print_mode == S1AP_XER_PRINT_ALWAYS);
+  bool                                    to_log = OAILOG_IS_ENABLED (OAILOG_LEVEL_TRACE, LOG_S1AP);
+
+#if ENABLE_ITTI_ANALYZER
+  to_itti = to_itti || itti_dump_has_consumer ();
+#endif
+
+  if ((!xer_print) || ((!to_itti) && (!to_log))) {
+    return;
+  }
+
+  message_string = bfromcstralloc (1024, "");
+  xer_print (s1ap_xer_print2bstr, message_string, message);
+
+  if (to_log) {
+    OAILOG_TRACE (LOG_S1AP, "%s\n", bdata (message_string));
+  }
+
+  if (to_itti) {
+    message_p = itti_alloc_new_message_sized (TASK_S1AP, message_id, blength (message_string) + sizeof (IttiMsgText));
+    message_p->ittiMsg.s1ap_uplink_nas_log.size = blength (message_string);
+    memcpy (&message_p->ittiMsg.s1ap_uplink_nas_log.text, message_string->data, blength (message_string));
+    itti_send_msg_to_task (TASK_UNKNOWN, INSTANCE_DEFAULT, message_p);
+  }
+  bdestroy (message_string);
+}
+
+//------------------------------------------------------------------------------
 static int
 s1ap_mme_decode_initiating (
   s1ap_message *message,
   S1ap_InitiatingMessage_t *initiating_p) {
   int                                     ret = -1;
-  MessageDef                             *message_p = NULL;
-  char                                   *message_string = NULL;
-  size_t                                  message_string_size;
+  s1ap_xer_print_t                        xer_print = NULL;
   MessagesIds                             message_id = MESSAGES_ID_MAX;
   
   OAILOG_FUNC_IN (LOG_S1AP);
  
   DevAssert (initiating_p != NULL);
-  message_string = calloc (10000, sizeof (char));
-  s1ap_string_total_size = 0;
   message->procedureCode = initiating_p->procedureCode;
   message->criticality = initiating_p->criticality;
 
   switch (initiating_p->procedureCode) {
     case S1ap_ProcedureCode_id_uplinkNASTransport: {
         ret = s1ap_decode_s1ap_uplinknastransporties (&message->msg.s1ap_UplinkNASTransportIEs, &initiating_p->value);
-        s1ap_xer_print_s1ap_uplinknastransport (s1ap_xer__print2sp, message_string, message);
+        xer_print = s1ap_xer_print_s1ap_uplinknastransport;
         message_id = S1AP_UPLINK_NAS_LOG;
       }
       break;
 
     case S1ap_ProcedureCode_id_S1Setup: {
         ret = s1ap_decode_s1ap_s1setuprequesties (&message->msg.s1ap_S1SetupRequestIEs, &initiating_p->value);
-        s1ap_xer_print_s1ap_s1setuprequest (s1ap_xer__print2sp, message_string, message);
+        xer_print = s1ap_xer_print_s1ap_s1setuprequest;
         message_id = S1AP_S1_SETUP_LOG;
       }
       break;
 
     case S1ap_ProcedureCode_id_initialUEMessage: {
         ret = s1ap_decode_s1ap_initialuemessageies (&message->msg.s1ap_InitialUEMessageIEs, &initiating_p->value);
-        s1ap_xer_print_s1ap_initialuemessage (s1ap_xer__print2sp, message_string, message);
+        xer_print = s1ap_xer_print_s1ap_initialuemessage;
         message_id = S1AP_INITIAL_UE_MESSAGE_LOG;
       }
       break;
 
     case S1ap_ProcedureCode_id_UEContextReleaseRequest: {
         ret = s1ap_decode_s1ap_uecontextreleaserequesties (&message->msg.s1ap_UEContextReleaseRequestIEs, &initiating_p->value);
-        s1ap_xer_print_s1ap_uecontextreleaserequest (s1ap_xer__print2sp, message_string, message);
+        xer_print = s1ap_xer_print_s1ap_uecontextreleaserequest;
         message_id = S1AP_UE_CONTEXT_RELEASE_REQ_LOG;
       }
       break;
 
     case S1ap_ProcedureCode_id_UECapabilityInfoIndication: {
         ret = s1ap_decode_s1ap_uecapabilityinfoindicationies (&message->msg.s1ap_UECapabilityInfoIndicationIEs, &initiating_p->value);
-        s1ap_xer_print_s1ap_uecapabilityinfoindication (s1ap_xer__print2sp, message_string, message);
+        xer_print = s1ap_xer_print_s1ap_uecapabilityinfoindication;
         message_id = S1AP_UE_CAPABILITY_IND_LOG;
       }
       break;
 
     case S1ap_ProcedureCode_id_NASNonDeliveryIndication: {
         ret = s1ap_decode_s1ap_nasnondeliveryindication_ies (&message->msg.s1ap_NASNonDeliveryIndication_IEs, &initiating_p->value);
-        s1ap_xer_print_s1ap_nasnondeliveryindication_ (s1ap_xer__print2sp, message_string, message);
+        xer_print = s1ap_xer_print_s1ap_nasnondeliveryindication_;
         message_id = S1AP_NAS_NON_DELIVERY_IND_LOG;
       }
       break;
@@ -132,41 +195,33 @@ s1ap_mme_decode_initiating (
       break;
   }
 
-  message_string_size = strlen (message_string);
-  message_p = itti_alloc_new_message_sized (TASK_S1AP, message_id, message_string_size + sizeof (IttiMsgText));
-  message_p->ittiMsg.s1ap_uplink_nas_log.size = message_string_size;
-  memcpy (&message_p->ittiMsg.s1ap_uplink_nas_log.text, message_string, message_string_size);
-  itti_send_msg_to_task (TASK_UNKNOWN, INSTANCE_DEFAULT, message_p);
-  free_wrapper ((void**) &message_string);
+  s1ap_mme_decode_log (message_id, xer_print, message);
   OAILOG_FUNC_RETURN (LOG_S1AP, ret);
 }
 
+//------------------------------------------------------------------------------
 static int
 s1ap_mme_decode_successfull_outcome (
   s1ap_message *message,
   S1ap_SuccessfulOutcome_t *successfullOutcome_p) {
   int                                     ret = -1;
-  MessageDef                             *message_p = NULL;
-  char                                   *message_string = NULL;
-  size_t                                  message_string_size = 0;
+  s1ap_xer_print_t                        xer_print = NULL;
   MessagesIds                             message_id = MESSAGES_ID_MAX;
   DevAssert (successfullOutcome_p != NULL);
-  message_string = calloc (10000, sizeof (char));
-  s1ap_string_total_size = 0;
   message->procedureCode = successfullOutcome_p->procedureCode;
   message->criticality = successfullOutcome_p->criticality;
 
   switch (successfullOutcome_p->procedureCode) {
     case S1ap_ProcedureCode_id_InitialContextSetup: {
         ret = s1ap_decode_s1ap_initialcontextsetupresponseies (&message->msg.s1ap_InitialContextSetupResponseIEs, &successfullOutcome_p->value);
-        s1ap_xer_print_s1ap_initialcontextsetupresponse (s1ap_xer__print2sp, message_string, message);
+        xer_print = s1ap_xer_print_s1ap_initialcontextsetupresponse;
         message_id = S1AP_INITIAL_CONTEXT_SETUP_LOG;
       }
       break;
 
     case S1ap_ProcedureCode_id_UEContextRelease: {
         ret = s1ap_decode_s1ap_uecontextreleasecompleteies (&message->msg.s1ap_UEContextReleaseCompleteIEs, &successfullOutcome_p->value);
-        s1ap_xer_print_s1ap_uecontextreleasecomplete (s1ap_xer__print2sp, message_string, message);
+        xer_print = s1ap_xer_print_s1ap_uecontextreleasecomplete;
         message_id = S1AP_UE_CONTEXT_RELEASE_LOG;
       }
       break;
@@ -177,34 +232,26 @@ s1ap_mme_decode_successfull_outcome (
       break;
   }
 
-  message_string_size = strlen (message_string);
-  message_p = itti_alloc_new_message_sized (TASK_S1AP, message_id, message_string_size + sizeof (IttiMsgText));
-  message_p->ittiMsg.s1ap_initial_context_setup_log.size = message_string_size;
-  memcpy (&message_p->ittiMsg.s1ap_initial_context_setup_log.text, message_string, message_string_size);
-  itti_send_msg_to_task (TASK_UNKNOWN, INSTANCE_DEFAULT, message_p);
-  free_wrapper ((void**) &message_string);
+  s1ap_mme_decode_log (message_id, xer_print, message);
   return ret;
 }
 
+//------------------------------------------------------------------------------
 static int
 s1ap_mme_decode_unsuccessfull_outcome (
   s1ap_message *message,
   S1ap_UnsuccessfulOutcome_t *unSuccessfulOutcome_p) {
   int                                     ret = -1;
-  MessageDef                             *message_p = NULL;
-  char                                   *message_string = NULL;
-  size_t                                  message_string_size = 0;
+  s1ap_xer_print_t                        xer_print = NULL;
   MessagesIds                             message_id = MESSAGES_ID_MAX;
   DevAssert (unSuccessfulOutcome_p != NULL);
-  message_string = calloc (10000, sizeof (char));
-  s1ap_string_total_size = 0;
   message->procedureCode = unSuccessfulOutcome_p->procedureCode;
   message->criticality = unSuccessfulOutcome_p->criticality;
 
   switch (unSuccessfulOutcome_p->procedureCode) {
     case S1ap_ProcedureCode_id_InitialContextSetup: {
         ret = s1ap_decode_s1ap_initialcontextsetupfailureies (&message->msg.s1ap_InitialContextSetupFailureIEs, &unSuccessfulOutcome_p->value);
-        s1ap_xer_print_s1ap_initialcontextsetupfailure (s1ap_xer__print2sp, message_string, message);
+        xer_print = s1ap_xer_print_s1ap_initialcontextsetupfailure;
         message_id = S1AP_INITIAL_CONTEXT_SETUP_LOG;
       }
       break;
@@ -215,15 +262,11 @@ s1ap_mme_decode_unsuccessfull_outcome (
       break;
   }
 
-  message_string_size = strlen (message_string);
-  message_p = itti_alloc_new_message_sized (TASK_S1AP, message_id, message_string_size + sizeof (IttiMsgText));
-  message_p->ittiMsg.s1ap_initial_context_setup_log.size = message_string_size;
-  memcpy (&message_p->ittiMsg.s1ap_initial_context_setup_log.text, message_string, message_string_size);
-  itti_send_msg_to_task (TASK_UNKNOWN, INSTANCE_DEFAULT, message_p);
-  free_wrapper ((void**) &message_string);
+  s1ap_mme_decode_log (message_id, xer_print, message);
   return ret;
 }
 
+//------------------------------------------------------------------------------
 int
 s1ap_mme_decode_pdu (
   s1ap_message *message,
@@ -27,6 +27,14 @@
 #include "s1ap_common.h"
 #include "s1ap_ies_defs.h"
 
+/* Decoded messages are rendered as XER text for the ITTI analyzer */
+typedef enum {
+  S1AP_XER_PRINT_ON_DEMAND = 0, /* only when an ITTI dump consumer is attached or S1AP log level is TRACE */
+  S1AP_XER_PRINT_ALWAYS,
+} s1ap_xer_print_mode_t;
+
+void s1ap_mme_decoder_set_xer_print_mode(const s1ap_xer_print_mode_t mode);
+
 int s1ap_mme_decode_pdu(s1ap_message *message, const_bstring const raw) __attribute__ ((warn_unused_result));
 
 #endif /* FILE_S1AP_MME_DECODER_SEEN */
@@ -382,7 +382,7 @@ s1ap_mme_handle_s1_setup_request (
 
   OAILOG_DEBUG (LOG_S1AP, "Adding eNB to the list of served eNBs\n");
 
-  enb_association->enb_id = enb_id;
+  s1ap_set_enb_id (enb_association, enb_id);
   enb_association->default_paging_drx = s1SetupRequest_p->defaultPagingDRX;
 
   if (enb_name != NULL) {
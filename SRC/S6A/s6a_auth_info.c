@@ -166,7 +166,7 @@ s6a_parse_authentication_info_avp (
 
     switch (hdr->avp_code) {
     case AVP_CODE_E_UTRAN_VECTOR:{
-      DevAssert (MAX_EPS_AUTH_VECTORS > authentication_info->nb_of_vectors);
+      DevAssert (MAX_EPS_AUTH_VECTORS_PREFETCH > authentication_info->nb_of_vectors);
       CHECK_FCT (s6a_parse_e_utran_vector (avp, &authentication_info->eutran_vector[authentication_info->nb_of_vectors]));
       authentication_info->nb_of_vectors++;
       }
@@ -402,13 +402,12 @@ s6a_generate_authentication_info_req (
     CHECK_FCT (fd_msg_avp_add (avp, MSG_BRW_LAST_CHILD, child_avp));
 
     /*
-     * Re-synchronization information containing the AUTS computed at USIM
+     * Re-synchronization information containing the RAND sent to the USIM and the AUTS computed at USIM
      */
     if (air_p->re_synchronization) {
       CHECK_FCT (fd_msg_avp_new (s6a_fd_cnf.dataobj_s6a_re_synchronization_info, 0, &child_avp));
-      // TODO Fix after updating HSS
-      value.os.len = AUTS_LENGTH;
-      value.os.data = (air_p->resync_param + RAND_LENGTH_OCTETS);
+      value.os.len = RESYNC_PARAM_LENGTH;
+      value.os.data = air_p->resync_param;
       CHECK_FCT (fd_msg_avp_setvalue (child_avp, &value));
       CHECK_FCT (fd_msg_avp_add (avp, MSG_BRW_LAST_CHILD, child_avp));
     }
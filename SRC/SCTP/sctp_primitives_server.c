@@ -36,6 +36,7 @@
 #include <string.h>
 #include <errno.h>
 #include <sys/socket.h>
+#include <sys/epoll.h>
 #include <netinet/in.h>
 #include <netinet/sctp.h>
 
@@ -44,6 +45,7 @@
 #include "assertions.h"
 #include "log.h"
 #include "msc.h"
+#include "hashtable.h"
 #include "intertask_interface.h"
 #include "sctp_primitives_server.h"
 #include "conversions.h"
@@ -55,9 +57,9 @@
 #define SCTP_RC_NORMAL_READ  0
 #define SCTP_RC_DISCONNECT   1
 
+#define SCTP_MAX_EPOLL_EVENTS 64
+
 typedef struct sctp_association_s {
-  struct sctp_association_s              *next_assoc;   ///< Next association in the list
-  struct sctp_association_s              *previous_assoc;       ///< Previous association in the list
   int                                     sd;   ///< Socket descriptor
   uint32_t                                ppid; ///< Payload protocol Identifier
   uint16_t                                instreams;    ///< Number of input streams negociated for this connection
@@ -70,26 +72,31 @@ typedef struct sctp_association_s {
   int                                     nb_peer_addresses;
 } sctp_association_t;
 
+/* A receive thread waits on its own epoll instance for the sockets of its
+ * associations, a socket is always read by the same thread so the messages of
+ * an association stay in order.
+ */
+typedef struct sctp_receiver_s {
+  pthread_t                               thread;
+  int                                     epoll_fd;
+  bstring                                 buffer;       ///< Next receive buffer, given to S1AP with the data read in it
+} sctp_receiver_t;
+
 typedef struct sctp_descriptor_s {
-  // List of connected peers
-  struct sctp_association_s              *available_connections_head;
-  struct sctp_association_s              *available_connections_tail;
+  // Connected peers, key is the association id
+  hash_table_ts_t                         associations;
 
-  uint32_t                                number_of_connections;
   uint16_t                                nb_instreams;
   uint16_t                                nb_outstreams;
-} sctp_descriptor_t;
 
-typedef struct sctp_arg_s {
-  int                                     sd;
+  int                                     listen_sd;
   uint32_t                                ppid;
-} sctp_arg_t;
+  int                                     nb_receivers;
+  sctp_receiver_t                         receivers[SCTP_MAX_RECEIVE_THREADS];
+} sctp_descriptor_t;
 
 static sctp_descriptor_t                  sctp_desc;
 
-// Thread used to handle sctp messages
-static pthread_t                        assoc_thread;
-
 // LOCAL FUNCTIONS prototypes
 void                                   *sctp_receiver_thread (void *args_p);
 static int sctp_send_msg (
@@ -99,7 +106,7 @@ static int sctp_send_msg (
 
 // Association list related local functions prototypes
 static sctp_association_t              *sctp_is_assoc_in_list (sctp_assoc_id_t assoc_id);
-static sctp_association_t              *sctp_add_new_peer (void);
+static sctp_association_t              *sctp_add_new_peer (sctp_assoc_id_t assoc_id);
 static int                              handle_assoc_change(int sd, uint32_t ppid,
                                                             struct sctp_assoc_change  *assoc_change);
 static int                              sctp_handle_com_down (sctp_assoc_id_t assoc_id);
@@ -108,7 +115,19 @@ static void                             sctp_dump_list (void);
 static void sctp_exit (void);
 
 //------------------------------------------------------------------------------
-static sctp_association_t *sctp_add_new_peer (void)
+static void sctp_free_association (void **association)
+{
+  sctp_association_t              *assoc_desc = (sctp_association_t *) *association;
+
+  if (assoc_desc->peer_addresses) {
+    int rv = sctp_freepaddrs(assoc_desc->peer_addresses);
+    if (rv) OAILOG_DEBUG (LOG_SCTP, "sctp_freepaddrs(%p) failed\n", assoc_desc->peer_addresses);
+  }
+  free_wrapper (association);
+}
+
+//------------------------------------------------------------------------------
+static sctp_association_t *sctp_add_new_peer (sctp_assoc_id_t assoc_id)
 {
   sctp_association_t              *new_sctp_descriptor = calloc (1, sizeof (sctp_association_t));
 
@@ -117,19 +136,13 @@ static sctp_association_t *sctp_add_new_peer (void)
     return NULL;
   }
 
-  new_sctp_descriptor->next_assoc = NULL;
-  new_sctp_descriptor->previous_assoc = NULL;
-
-  if (sctp_desc.available_connections_tail == NULL) {
-    sctp_desc.available_connections_head = new_sctp_descriptor;
-    sctp_desc.available_connections_tail = sctp_desc.available_connections_head;
-  } else {
-    new_sctp_descriptor->previous_assoc = sctp_desc.available_connections_tail;
-    sctp_desc.available_connections_tail->next_assoc = new_sctp_descriptor;
-    sctp_desc.available_connections_tail = new_sctp_descriptor;
+  new_sctp_descriptor->assoc_id = assoc_id;
+  if (hashtable_ts_insert (&sctp_desc.associations, (const hash_key_t)assoc_id, (void *)new_sctp_descriptor) != HASH_TABLE_OK) {
+    OAILOG_ERROR (LOG_SCTP, "Failed to insert new peer %d in list\n", assoc_id);
+    free_wrapper ((void**) &new_sctp_descriptor);
+    return NULL;
   }
 
-  sctp_desc.number_of_connections++;
   sctp_dump_list ();
   return new_sctp_descriptor;
 }
@@ -143,62 +156,20 @@ static sctp_association_t *sctp_is_assoc_in_list (sctp_assoc_id_t assoc_id)
     return NULL;
   }
 
-  for (assoc_desc = sctp_desc.available_connections_head; assoc_desc; assoc_desc = assoc_desc->next_assoc) {
-    if (assoc_desc->assoc_id == assoc_id) {
-      break;
-    }
-  }
-
+  hashtable_ts_get (&sctp_desc.associations, (const hash_key_t)assoc_id, (void **)&assoc_desc);
   return assoc_desc;
 }
 
 //------------------------------------------------------------------------------
 static int sctp_remove_assoc_from_list (sctp_assoc_id_t assoc_id)
 {
-  sctp_association_t              *assoc_desc = NULL;
-
   /*
    * Association not in the list
    */
-  if ((assoc_desc = sctp_is_assoc_in_list (assoc_id)) == NULL) {
+  if ((assoc_id < 0) || (hashtable_ts_free (&sctp_desc.associations, (const hash_key_t)assoc_id) != HASH_TABLE_OK)) {
     return -1;
   }
 
-  if (assoc_desc->next_assoc == NULL) {
-    if (assoc_desc->previous_assoc == NULL) {
-      /*
-       * Head and tail
-       */
-      sctp_desc.available_connections_head = sctp_desc.available_connections_tail = NULL;
-    } else {
-      /*
-       * Not head but tail
-       */
-      sctp_desc.available_connections_tail = assoc_desc->previous_assoc;
-      assoc_desc->previous_assoc->next_assoc = NULL;
-    }
-  } else {
-    if (assoc_desc->previous_assoc == NULL) {
-      /*
-       * Head but not tail
-       */
-      sctp_desc.available_connections_head = assoc_desc->next_assoc;
-      assoc_desc->next_assoc->previous_assoc = NULL;
-    } else {
-      /*
-       * Not head and not tail
-       */
-      assoc_desc->previous_assoc->next_assoc = assoc_desc->next_assoc;
-      assoc_desc->next_assoc->previous_assoc = assoc_desc->previous_assoc;
-    }
-  }
-
-  if (assoc_desc->peer_addresses) {
-    int rv = sctp_freepaddrs(assoc_desc->peer_addresses);
-    if (rv) OAILOG_DEBUG (LOG_SCTP, "sctp_freepaddrs(%p) failed\n", assoc_desc->peer_addresses);
-  }
-  free_wrapper ((void**) &assoc_desc);
-  sctp_desc.number_of_connections--;
   return 0;
 }
 
@@ -233,18 +204,25 @@ static void sctp_dump_assoc (sctp_association_t *sctp_assoc_p)
 #endif
 }
 
+//------------------------------------------------------------------------------
+#if SCTP_DUMP_LIST
+static bool sctp_dump_assoc_cb (
+    __attribute__((unused)) const hash_key_t keyP,
+    void * const elementP,
+    __attribute__((unused)) void *parameterP,
+    __attribute__((unused)) void **resultP)
+{
+  sctp_dump_assoc ((sctp_association_t *)elementP);
+  return false;
+}
+#endif
+
 //------------------------------------------------------------------------------
 static void sctp_dump_list (void)
 {
 #if SCTP_DUMP_LIST
-  sctp_association_t              *sctp_assoc_p = sctp_desc.available_connections_head;
-  OAILOG_DEBUG (LOG_SCTP, "SCTP list contains %d associations\n", sctp_desc.number_of_connections);
-
-  while (sctp_assoc_p != NULL) {
-    sctp_dump_assoc (sctp_assoc_p);
-    sctp_assoc_p = sctp_assoc_p->next_assoc;
-  }
-
+  OAILOG_DEBUG (LOG_SCTP, "SCTP list contains %zu associations\n", sctp_desc.associations.num_elements);
+  hashtable_ts_apply_callback_on_elements (&sctp_desc.associations, sctp_dump_assoc_cb, NULL, NULL);
 #else
   sctp_dump_assoc (NULL);
 #endif
@@ -262,6 +240,8 @@ static int sctp_send_msg (
 
   if ((assoc_desc = sctp_is_assoc_in_list (sctp_assoc_id)) == NULL) {
     OAILOG_DEBUG (LOG_SCTP, "This assoc id has not been fount in list (%d)\n", sctp_assoc_id);
+    bdestroy (*payload);
+    *payload = NULL;
     return -1;
   }
 
@@ -270,6 +250,8 @@ static int sctp_send_msg (
      * The socket is invalid may be closed.
      */
     OAILOG_DEBUG (LOG_SCTP, "The socket is invalid may be closed (assoc id %d)\n", sctp_assoc_id);
+    bdestroy (*payload);
+    *payload = NULL;
     return -1;
   }
 
@@ -281,23 +263,61 @@ static int sctp_send_msg (
    */
   if (sctp_sendmsg (assoc_desc->sd, (const void *)bdata(*payload), (size_t) blength(*payload), NULL, 0, htonl
       (assoc_desc->ppid), 0, stream, 0, 0) < 0) {
+    bdestroy (*payload);
     *payload = NULL;
     OAILOG_ERROR (LOG_SCTP, "send: %s:%d\n", strerror (errno), errno);
     return -1;
   }
   OAILOG_DEBUG (LOG_SCTP, "Successfully sent %d bytes on stream %d\n", blength(*payload), stream);
+  bdestroy (*payload);
   *payload = NULL;
 
   assoc_desc->messages_sent++;
   return 0;
 }
 
+//------------------------------------------------------------------------------
+static int sctp_start_receivers (int listen_sd, uint32_t ppid)
+{
+  struct epoll_event                      event = {0};
+  int                                     i,
+                                          rv;
+
+  sctp_desc.listen_sd = listen_sd;
+  sctp_desc.ppid = ppid;
+
+  for (i = 0; i < sctp_desc.nb_receivers; i++) {
+    if ((sctp_desc.receivers[i].epoll_fd = epoll_create1 (EPOLL_CLOEXEC)) < 0) {
+      OAILOG_ERROR (LOG_SCTP, "epoll_create1: %s:%d\n", strerror (errno), errno);
+      return -1;
+    }
+  }
+
+  /*
+   * The first receiver accepts the new associations
+   */
+  event.events = EPOLLIN;
+  event.data.fd = listen_sd;
+  if (epoll_ctl (sctp_desc.receivers[0].epoll_fd, EPOLL_CTL_ADD, listen_sd, &event) < 0) {
+    OAILOG_ERROR (LOG_SCTP, "epoll_ctl: %s:%d\n", strerror (errno), errno);
+    return -1;
+  }
+
+  for (i = 0; i < sctp_desc.nb_receivers; i++) {
+    if ((rv = pthread_create (&sctp_desc.receivers[i].thread, NULL, &sctp_receiver_thread, (void *)&sctp_desc.receivers[i])) != 0) {
+      OAILOG_ERROR (LOG_SCTP, "pthread_create: %s:%d\n", strerror (rv), rv);
+      return -1;
+    }
+  }
+  OAILOG_DEBUG (LOG_SCTP, "Started %d SCTP receive threads\n", sctp_desc.nb_receivers);
+  return 0;
+}
+
 //------------------------------------------------------------------------------
 static int sctp_create_new_listener (SctpInit * init_p)
 {
   struct sctp_event_subscribe             event = {0};
   struct sockaddr                        *addr = NULL;
-  sctp_arg_t                             *sctp_arg_p = NULL;
   uint16_t                                i = 0,
                                           j = 0;
   int                                     sd = 0;
@@ -381,16 +401,8 @@ static int sctp_create_new_listener (SctpInit * init_p)
     return -1;
   }
 
-  if ((sctp_arg_p = malloc (sizeof (sctp_arg_t))) == NULL) {
-    return -1;
-  }
-
-  sctp_arg_p->sd = sd;
-  sctp_arg_p->ppid = init_p->ppid;
-
-  if (pthread_create (&assoc_thread, NULL, &sctp_receiver_thread, (void *)sctp_arg_p) < 0) {
-    OAILOG_ERROR (LOG_SCTP, "pthread_create: %s:%d\n", strerror (errno), errno);
-    return -1;
+  if (sctp_start_receivers (sd, init_p->ppid) < 0) {
+    goto err;
   }
 
   return sd;
@@ -405,23 +417,35 @@ err:
 }
 
 //------------------------------------------------------------------------------
-static inline int sctp_read_from_socket (int sd, uint32_t ppid)
+static inline int sctp_read_from_socket (sctp_receiver_t * receiver, int sd, uint32_t ppid)
 {
   int                                     flags = 0,
     n;
   socklen_t                               from_len = 0;
   struct sctp_sndrcvinfo                  sinfo = {0};
   struct sockaddr_in6                     addr = {0};
-  uint8_t                                 buffer[SCTP_RECV_BUFFER_SIZE];
+  bstring                                 buffer = NULL;
 
   if (sd < 0) {
     return -1;
   }
 
+  /*
+   * The data is read in a bstring that is given to S1AP, a new one is
+   * allocated after each data message.
+   */
+  if (receiver->buffer == NULL) {
+    if ((receiver->buffer = bfromcstralloc (SCTP_RECV_BUFFER_SIZE, "")) == NULL) {
+      OAILOG_ERROR (LOG_SCTP, "Failed to allocate receive buffer\n");
+      return SCTP_RC_ERROR;
+    }
+  }
+  buffer = receiver->buffer;
+
   memset ((void *)&addr, 0, sizeof (struct sockaddr_in6));
   from_len = (socklen_t) sizeof (struct sockaddr_in6);
   memset ((void *)&sinfo, 0, sizeof (struct sctp_sndrcvinfo));
-  n = sctp_recvmsg (sd, (void *)buffer, SCTP_RECV_BUFFER_SIZE, (struct sockaddr *)&addr, &from_len, &sinfo, &flags);
+  n = sctp_recvmsg (sd, (void *)buffer->data, buffer->mlen - 1, (struct sockaddr *)&addr, &from_len, &sinfo, &flags);
 
   if (n < 0) {
     OAILOG_DEBUG (LOG_SCTP, "An error occured during read\n");
@@ -430,7 +454,7 @@ static inline int sctp_read_from_socket (int sd, uint32_t ppid)
   }
 
   if (flags & MSG_NOTIFICATION) {
-    union sctp_notification                *snp = (union sctp_notification *)buffer;
+    union sctp_notification                *snp = (union sctp_notification *)buffer->data;
 
     switch (snp->sn_header.sn_type) {
     case SCTP_SHUTDOWN_EVENT: {
@@ -469,8 +493,13 @@ static inline int sctp_read_from_socket (int sd, uint32_t ppid)
     }
 
     OAILOG_DEBUG (LOG_SCTP, "[%d][%d] Msg of length %d received from port %u, on stream %d, PPID %d\n", sinfo.sinfo_assoc_id, sd, n, ntohs (addr.sin6_port), sinfo.sinfo_stream, ntohl (sinfo.sinfo_ppid));
-    bstring payload = blk2bstr(buffer, n);
-    sctp_itti_send_new_message_ind (&payload,
+    /*
+     * Hand the receive buffer over, shrunk in place to the message
+     */
+    buffer->slen = n;
+    ballocmin (buffer, n + 1);
+    receiver->buffer = NULL;
+    sctp_itti_send_new_message_ind (&buffer,
                                     (sctp_assoc_id_t) sinfo.sinfo_assoc_id, sinfo.sinfo_stream, association->instreams, association->outstreams);
   }
 
@@ -506,103 +535,67 @@ static int sctp_handle_reset(const sctp_assoc_id_t assoc_id) {
 }
 
 //------------------------------------------------------------------------------
-void *sctp_receiver_thread (void *args_p)
+static void sctp_accept (void)
 {
-  sctp_arg_t                             *sctp_arg_p = NULL;
+  struct epoll_event                      event = {0};
+  sctp_receiver_t                        *receiver = NULL;
+  int                                     clientsock;
 
-  /*
-   * maximum file descriptor number
-   */
-  int                                     fdmax,
-                                          clientsock,
-                                          i;
-
-  /*
-   * master file descriptor list
-   */
-  fd_set                                  master;
+  if ((clientsock = accept (sctp_desc.listen_sd, NULL, NULL)) < 0) {
+    OAILOG_ERROR (LOG_SCTP, "[%d] accept: %s:%d\n", sctp_desc.listen_sd, strerror (errno), errno);
+    return;
+  }
 
   /*
-   * temp file descriptor list for select()
+   * Each socket carries one association, the socket gives its receiver
    */
-  fd_set                                  read_fds;
-
-  if ((sctp_arg_p = (sctp_arg_t *)args_p) == NULL) {
-    pthread_exit (NULL);
+  receiver = &sctp_desc.receivers[clientsock % sctp_desc.nb_receivers];
+  event.events = EPOLLIN;
+  event.data.fd = clientsock;
+  if (epoll_ctl (receiver->epoll_fd, EPOLL_CTL_ADD, clientsock, &event) < 0) {
+    OAILOG_ERROR (LOG_SCTP, "[%d] epoll_ctl: %s:%d\n", clientsock, strerror (errno), errno);
+    close (clientsock);
   }
+}
+
+//------------------------------------------------------------------------------
+void *sctp_receiver_thread (void *args_p)
+{
+  sctp_receiver_t                        *receiver = (sctp_receiver_t *)args_p;
+  struct epoll_event                      events[SCTP_MAX_EPOLL_EVENTS];
+  int                                     nb_events,
+                                          i;
 
-  /*
-   * clear the master and temp sets
-   */
-  FD_ZERO (&master);
-  FD_ZERO (&read_fds);
-  FD_SET (sctp_arg_p->sd, &master);
-  fdmax = sctp_arg_p->sd;       /* so far, it's this one */
   OAILOG_START_USE ();
   MSC_START_USE ();
 
   while (1) {
-    memcpy (&read_fds, &master, sizeof (master));
-
-    if (select (fdmax + 1, &read_fds, NULL, NULL, NULL) == -1) {
-      OAILOG_ERROR (LOG_SCTP, "[%d] Select() error: %s\n", sctp_arg_p->sd, strerror (errno));
-      free_wrapper ((void**) &args_p);
-      args_p = NULL;
+    if ((nb_events = epoll_wait (receiver->epoll_fd, events, SCTP_MAX_EPOLL_EVENTS, -1)) < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      OAILOG_ERROR (LOG_SCTP, "[%d] epoll_wait() error: %s\n", receiver->epoll_fd, strerror (errno));
       pthread_exit (NULL);
     }
 
-    for (i = 0; i <= fdmax; i++) {
-      if (FD_ISSET (i, &read_fds)) {
-        if (i == sctp_arg_p->sd) {
-          /*
-           * There is data to read on listener socket. This means we have to accept
-           * * * * the connection.
-           */
-          if ((clientsock = accept (sctp_arg_p->sd, NULL, NULL)) < 0) {
-            OAILOG_ERROR (LOG_SCTP, "[%d] accept: %s:%d\n", sctp_arg_p->sd, strerror (errno), errno);
-            free_wrapper ((void**) &args_p);
-            args_p = NULL;
-            pthread_exit (NULL);
-          } else {
-            FD_SET (clientsock, &master);       /* add to master set */
-
-            if (clientsock > fdmax) {
-              /*
-               * keep track of the maximum
-               */
-              fdmax = clientsock;
-            }
-          }
-        } else {
-          int                                     ret;
-
-          /*
-           * Read from socket
-           */
-          ret = sctp_read_from_socket (i, sctp_arg_p->ppid);
+    for (i = 0; i < nb_events; i++) {
+      int                                     sd = events[i].data.fd;
 
-          /*
-           * When the socket is disconnected we have to update
-           * * * * the fd_set.
-           */
-          if (ret == SCTP_RC_DISCONNECT) {
-            /*
-             * Remove the socket from the FD set and update the max sd
-             */
-            FD_CLR (i, &master);
-
-            if (i == fdmax) {
-              while (FD_ISSET (fdmax, &master) == false)
-                fdmax -= 1;
-            }
-          }
-        }
+      if (sd == sctp_desc.listen_sd) {
+        /*
+         * There is data to read on listener socket. This means we have to accept
+         * the connection.
+         */
+        sctp_accept ();
+      } else if (sctp_read_from_socket (receiver, sd, sctp_desc.ppid) == SCTP_RC_DISCONNECT) {
+        /*
+         * The association is down, the socket is not needed anymore
+         */
+        close (sd);
       }
     }
   }
 
-  free_wrapper ((void**) &args_p);
-  args_p = NULL;
   return NULL;
 }
 
@@ -691,7 +684,7 @@ static void * sctp_intertask_interface (
 // Function adds a new association and sends a new association notification message.
 sctp_association_t* add_new_association(int sd, uint32_t ppid, struct sctp_assoc_change *sctp_assoc_changed) {
   sctp_association_t *new_association = NULL;
-  if ((new_association = sctp_add_new_peer()) == NULL) {
+  if ((new_association = sctp_add_new_peer((sctp_assoc_id_t) sctp_assoc_changed->sac_assoc_id)) == NULL) {
     OAILOG_ERROR (LOG_SCTP, "Failed to allocate new sctp peer \n");
     return NULL;
   }
@@ -700,7 +693,6 @@ sctp_association_t* add_new_association(int sd, uint32_t ppid, struct sctp_assoc
   new_association->ppid = ppid;
   new_association->instreams = sctp_assoc_changed->sac_inbound_streams;
   new_association->outstreams = sctp_assoc_changed->sac_outbound_streams;
-  new_association->assoc_id = (sctp_assoc_id_t) sctp_assoc_changed->sac_assoc_id;
   sctp_get_localaddresses(sd, NULL, NULL);
   sctp_get_peeraddresses(sd, &new_association->peer_addresses, &new_association->nb_peer_addresses);
 
@@ -756,6 +748,18 @@ int sctp_init (const mme_config_t * mme_config_p)
    */
   sctp_desc.nb_instreams = mme_config_p->sctp_config.in_streams;
   sctp_desc.nb_outstreams = mme_config_p->sctp_config.out_streams;
+  sctp_desc.nb_receivers = mme_config_p->sctp_config.nb_receive_threads;
+  AssertFatal ((sctp_desc.nb_receivers >= 1) && (sctp_desc.nb_receivers <= SCTP_MAX_RECEIVE_THREADS),
+      "Bad number of SCTP receive threads %d\n", sctp_desc.nb_receivers);
+  sctp_desc.listen_sd = -1;
+
+  bstring b = bfromcstr ("sctp_associations");
+  hash_table_ts_t *h = hashtable_ts_init (&sctp_desc.associations, mme_config_p->max_enbs, NULL, sctp_free_association, b);
+  bdestroy (b);
+  if (!h) {
+    OAILOG_ERROR (LOG_SCTP, "Failed to create the association list\n");
+    return -1;
+  }
 
   if (itti_create_task (TASK_SCTP, &sctp_intertask_interface, NULL) < 0) {
     OAILOG_ERROR (LOG_SCTP, "create task failed\n");
@@ -770,20 +774,19 @@ int sctp_init (const mme_config_t * mme_config_p)
 //------------------------------------------------------------------------------
 static void sctp_exit (void)
 {
+  for (int i = 0; i < sctp_desc.nb_receivers; i++) {
+    sctp_receiver_t                        *receiver = &sctp_desc.receivers[i];
 
-  int rv = pthread_cancel(assoc_thread);
-  if (rv) OAILOG_DEBUG (LOG_SCTP, "pthread_cancel(%08lX) failed: %d:%s\n", assoc_thread, rv, strerror(rv));
-
-  sctp_association_t              *sctp_assoc_p = sctp_desc.available_connections_head;
-  sctp_association_t              *next_sctp_assoc_p = sctp_desc.available_connections_head;
-
-  while (next_sctp_assoc_p) {
-    next_sctp_assoc_p = sctp_assoc_p->next_assoc;
-    if (sctp_assoc_p->peer_addresses) {
-      rv = sctp_freepaddrs(sctp_assoc_p->peer_addresses);
-      if (rv) OAILOG_DEBUG (LOG_SCTP, "sctp_freepaddrs(%p) failed\n", sctp_assoc_p->peer_addresses);
+    if (receiver->thread) {
+      int rv = pthread_cancel(receiver->thread);
+      if (rv) OAILOG_DEBUG (LOG_SCTP, "pthread_cancel(%08lX) failed: %d:%s\n", receiver->thread, rv, strerror(rv));
+      pthread_join (receiver->thread, NULL);
+    }
+    if (receiver->epoll_fd > 0) {
+      close (receiver->epoll_fd);
     }
-    free_wrapper ((void**) &sctp_assoc_p);
-    sctp_desc.number_of_connections--;
+    bdestroy (receiver->buffer);
   }
+
+  hashtable_ts_destroy (&sctp_desc.associations);
 }
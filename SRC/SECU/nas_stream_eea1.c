@@ -115,7 +115,9 @@ nas_stream_encrypt_eea1 (
   }
 
   free_wrapper ((void**) &KS);
-  memcpy (out, stream_cipher->message, n * 4);
+  if (out != stream_cipher->message) {
+    memcpy (out, stream_cipher->message, n * 4);
+  }
 
   if (zero_bit > 0) {
     out[ceil_index - 1] = stream_cipher->message[ceil_index - 1];
@@ -24,26 +24,41 @@
 #include <stdint.h>
 #include <string.h>
 
-#include <nettle/nettle-meta.h>
 #include <nettle/aes.h>
-#include <nettle/ctr.h>
 #include "assertions.h"
 #include "conversions.h"
 #include "secu_defs.h"
-#include "dynamic_memory_check.h"
 
 int
 nas_stream_encrypt_eea2 (
   nas_stream_cipher_t * const stream_cipher,
   uint8_t * const out)
 {
-  uint8_t                                 m[16];
+  nas_stream_aes_key_t                    aes_key;
+
+  DevAssert (stream_cipher != NULL);
+  DevAssert (stream_cipher->key_length == AES128_KEY_SIZE);
+  aes_key.is_set = false;
+  nas_stream_aes_key_setup (&aes_key, stream_cipher->key);
+  return nas_stream_encrypt_eea2_with_key (&aes_key, stream_cipher, out);
+}
+
+//------------------------------------------------------------------------------
+int
+nas_stream_encrypt_eea2_with_key (
+  const nas_stream_aes_key_t * const aes_key,
+  nas_stream_cipher_t * const stream_cipher,
+  uint8_t * const out)
+{
+  uint8_t                                 m[AES_BLOCK_SIZE];
+  uint8_t                                 key_stream[AES_BLOCK_SIZE];
   uint32_t                                local_count;
-  void                                   *ctx;
-  uint8_t                                *data;
   uint32_t                                zero_bit = 0;
   uint32_t                                byte_length;
+  uint32_t                                length;
 
+  DevAssert (aes_key != NULL);
+  DevAssert (aes_key->is_set);
   DevAssert (stream_cipher != NULL);
   DevAssert (out != NULL);
   zero_bit = stream_cipher->blength & 0x7;
@@ -52,8 +67,6 @@ nas_stream_encrypt_eea2 (
   if (zero_bit > 0)
     byte_length += 1;
 
-  ctx = malloc (nettle_aes128.context_size);
-  data = malloc (byte_length);
   local_count = hton_int32 (stream_cipher->count);
   memset (m, 0, sizeof (m));
   memcpy (&m[0], &local_count, 4);
@@ -61,14 +74,21 @@ nas_stream_encrypt_eea2 (
   /*
    * Other bits are 0
    */
-  nettle_aes128.set_encrypt_key (ctx, stream_cipher->key_length, stream_cipher->key);
-  nettle_ctr_crypt (ctx, nettle_aes128.encrypt, nettle_aes128.block_size, m, byte_length, data, stream_cipher->message);
+
+  /*
+   * AES-CTR, the 128 bits counter block is incremented as a big endian integer
+   */
+  for (uint32_t offset = 0; offset < byte_length; offset += AES_BLOCK_SIZE) {
+    secu_aes128_encrypt (&aes_key->aes, AES_BLOCK_SIZE, key_stream, m);
+    length = ((byte_length - offset) < AES_BLOCK_SIZE) ? (byte_length - offset) : AES_BLOCK_SIZE;
+    for (uint32_t i = 0; i < length; i++) {
+      out[offset + i] = stream_cipher->message[offset + i] ^ key_stream[i];
+    }
+    for (int i = AES_BLOCK_SIZE - 1; (i >= 0) && (0 == ++m[i]); i--);
+  }
 
   if (zero_bit > 0)
-    data[byte_length - 1] = data[byte_length - 1] & (uint8_t) (0xFF << (8 - zero_bit));
+    out[byte_length - 1] = out[byte_length - 1] & (uint8_t) (0xFF << (8 - zero_bit));
 
-  memcpy (out, data, byte_length);
-  free_wrapper ((void**) &data);
-  free_wrapper (&ctx);
   return 0;
 }
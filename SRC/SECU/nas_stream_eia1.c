@@ -107,9 +107,11 @@ MUL64 (
   uint64_t                                result = 0;
   int                                     i = 0;
 
-  for (i = 0; i < 64; i++) {
+  // V holds MUL64xPOW (V, i, c) of the input V at step i
+  for (i = 0; (i < 64) && (P >> i); i++) {
     if ((P >> i) & 0x1)
-      result ^= MUL64xPOW (V, i, c);
+      result ^= V;
+    V = MUL64x (V, c);
   }
 
   return result;
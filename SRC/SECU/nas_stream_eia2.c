@@ -24,22 +24,53 @@
 #include <stdint.h>
 #include <string.h>
 
-#include "secu_defs.h"
-
-#include <openssl/aes.h>
-#include <openssl/cmac.h>
-#include <openssl/evp.h>
-
-// test
-#include <openssl/ssl.h>
-#include <openssl/err.h>
-#include <openssl/bio.h>
+#include <nettle/aes.h>
 
+#include "secu_defs.h"
 #include "assertions.h"
 #include "conversions.h"
-#include "dynamic_memory_check.h"
 #include "log.h"
 
+//------------------------------------------------------------------------------
+// CMAC subkey generation, RFC 4493 section 2.3: out = in << 1, xor Rb if the
+// most significant bit of in was set.
+static void
+_nas_stream_cmac_double (
+  const uint8_t in[AES_BLOCK_SIZE],
+  uint8_t out[AES_BLOCK_SIZE])
+{
+  uint8_t                                 msb = in[0] & 0x80;
+
+  for (int i = 0; i < AES_BLOCK_SIZE - 1; i++) {
+    out[i] = (in[i] << 1) | (in[i + 1] >> 7);
+  }
+  out[AES_BLOCK_SIZE - 1] = in[AES_BLOCK_SIZE - 1] << 1;
+  if (msb) {
+    out[AES_BLOCK_SIZE - 1] ^= 0x87;
+  }
+}
+
+//------------------------------------------------------------------------------
+void
+nas_stream_aes_key_setup (
+  nas_stream_aes_key_t * const aes_key,
+  const uint8_t * const key)
+{
+  uint8_t                                 l[AES_BLOCK_SIZE] = {0};
+
+  DevAssert (aes_key != NULL);
+  DevAssert (key != NULL);
+  if ((aes_key->is_set) && (!memcmp (aes_key->key, key, AES128_KEY_SIZE))) {
+    return;
+  }
+  memcpy (aes_key->key, key, AES128_KEY_SIZE);
+  secu_aes128_set_encrypt_key (&aes_key->aes, key);
+  secu_aes128_encrypt (&aes_key->aes, AES_BLOCK_SIZE, l, l);
+  _nas_stream_cmac_double (l, aes_key->k1);
+  _nas_stream_cmac_double (aes_key->k1, aes_key->k2);
+  aes_key->is_set = true;
+}
+
 /*!
    @brief Create integrity cmac t for a given message.
    @param[in] stream_cipher Structure containing various variables to setup encoding
@@ -50,18 +81,38 @@ nas_stream_encrypt_eia2 (
   nas_stream_cipher_t * const stream_cipher,
   uint8_t const out[4])
 {
-  uint8_t                                *m = NULL;
+  nas_stream_aes_key_t                    aes_key;
+
+  DevAssert (stream_cipher != NULL);
+  DevAssert (stream_cipher->key != NULL);
+  DevAssert (stream_cipher->key_length == AES128_KEY_SIZE);
+  aes_key.is_set = false;
+  nas_stream_aes_key_setup (&aes_key, stream_cipher->key);
+  return nas_stream_encrypt_eia2_with_key (&aes_key, stream_cipher, (uint8_t *)out);
+}
+
+//------------------------------------------------------------------------------
+// AES-CMAC (RFC 4493) of COUNT | BEARER | DIRECTION | 0^26 | MESSAGE, computed
+// block per block from the message without copying it behind the 8 bytes
+// header.
+int
+nas_stream_encrypt_eia2_with_key (
+  const nas_stream_aes_key_t * const aes_key,
+  nas_stream_cipher_t * const stream_cipher,
+  uint8_t out[4])
+{
+  uint8_t                                 x[AES_BLOCK_SIZE] = {0};
+  uint8_t                                 block[AES_BLOCK_SIZE];
   uint32_t                                local_count = 0;
-  size_t                                  size = 4;
-  uint8_t                                 data[16] = {0};
-  CMAC_CTX                               *cmac_ctx = NULL;
-  const EVP_CIPHER                       *cipher = EVP_aes_128_cbc ();
   uint32_t                                zero_bit = 0;
   uint32_t                                m_length;
+  uint32_t                                length;
+  uint32_t                                offset = 0;
+  const uint8_t                          *k;
 
+  DevAssert (aes_key != NULL);
+  DevAssert (aes_key->is_set);
   DevAssert (stream_cipher != NULL);
-  DevAssert (stream_cipher->key != NULL);
-  DevAssert (stream_cipher->key_length > 0);
   DevAssert (out != NULL);
   zero_bit = stream_cipher->blength & 0x7;
   m_length = stream_cipher->blength >> 3;
@@ -69,24 +120,52 @@ nas_stream_encrypt_eia2 (
   if (zero_bit > 0)
     m_length += 1;
 
-  local_count = hton_int32 (stream_cipher->count);
-  m = calloc (m_length + 8, sizeof (uint8_t));
-  memcpy (&m[0], &local_count, 4);
-  m[4] = ((stream_cipher->bearer & 0x1F) << 3) | ((stream_cipher->direction & 0x01) << 2);
-  memcpy (&m[8], stream_cipher->message, m_length);
-
   OAILOG_TRACE (LOG_NAS, "Byte length: %u, Zero bits: %u:\n", m_length + 8, zero_bit);
-  OAILOG_STREAM_HEX(OAILOG_LEVEL_TRACE, LOG_NAS, "m:", m, m_length + 8);
-  OAILOG_STREAM_HEX(OAILOG_LEVEL_TRACE, LOG_NAS, "Key:", stream_cipher->key, stream_cipher->key_length);
+  OAILOG_STREAM_HEX(OAILOG_LEVEL_TRACE, LOG_NAS, "Key:", aes_key->key, AES128_KEY_SIZE);
   OAILOG_STREAM_HEX(OAILOG_LEVEL_TRACE, LOG_NAS, "Message:", stream_cipher->message, m_length);
 
-  cmac_ctx = CMAC_CTX_new ();
-  CMAC_Init (cmac_ctx, stream_cipher->key, stream_cipher->key_length, cipher, NULL);
-  CMAC_Update (cmac_ctx, m, m_length + 8);
-  CMAC_Final (cmac_ctx, data, &size);
-  CMAC_CTX_free (cmac_ctx);
-  OAILOG_STREAM_HEX(OAILOG_LEVEL_TRACE, LOG_NAS, "Out:", data, size);
-  memcpy ((void*)out, data, 4);
-  free_wrapper ((void**) &m);
+  /*
+   * First block: the 8 bytes header and up to 8 bytes of message
+   */
+  local_count = hton_int32 (stream_cipher->count);
+  memcpy (&block[0], &local_count, 4);
+  block[4] = ((stream_cipher->bearer & 0x1F) << 3) | ((stream_cipher->direction & 0x01) << 2);
+  block[5] = 0;
+  block[6] = 0;
+  block[7] = 0;
+  length = (m_length < 8) ? m_length : 8;
+  memcpy (&block[8], stream_cipher->message, length);
+  length += 8;
+  offset = length - 8;
+
+  /*
+   * Full blocks but the last one
+   */
+  while (offset < m_length) {
+    for (int i = 0; i < AES_BLOCK_SIZE; i++) {
+      x[i] ^= block[i];
+    }
+    secu_aes128_encrypt (&aes_key->aes, AES_BLOCK_SIZE, x, x);
+    length = ((m_length - offset) < AES_BLOCK_SIZE) ? (m_length - offset) : AES_BLOCK_SIZE;
+    memcpy (block, &stream_cipher->message[offset], length);
+    offset += length;
+  }
+
+  /*
+   * Last block: complete or padded with 10^i
+   */
+  if (AES_BLOCK_SIZE == length) {
+    k = aes_key->k1;
+  } else {
+    block[length] = 0x80;
+    memset (&block[length + 1], 0, AES_BLOCK_SIZE - length - 1);
+    k = aes_key->k2;
+  }
+  for (int i = 0; i < AES_BLOCK_SIZE; i++) {
+    x[i] ^= block[i] ^ k[i];
+  }
+  secu_aes128_encrypt (&aes_key->aes, AES_BLOCK_SIZE, x, x);
+  OAILOG_STREAM_HEX(OAILOG_LEVEL_TRACE, LOG_NAS, "Out:", x, AES_BLOCK_SIZE);
+  memcpy (out, x, 4);
   return 0;
 }
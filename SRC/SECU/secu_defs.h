@@ -22,8 +22,23 @@
 #ifndef FILE_SECU_DEFS_SEEN
 #define FILE_SECU_DEFS_SEEN
 
+#include <stdbool.h>
+#include <nettle/aes.h>
+
 #include "security_types.h"
 
+/* AES-128 context of nettle >= 3.0, the generic AES context before */
+#if defined(AES128_KEY_SIZE)
+#  define SECU_AES128_CTX                      struct aes128_ctx
+#  define secu_aes128_set_encrypt_key(cTx, kEy) aes128_set_encrypt_key (cTx, kEy)
+#  define secu_aes128_encrypt                  aes128_encrypt
+#else
+#  define AES128_KEY_SIZE                      16
+#  define SECU_AES128_CTX                      struct aes_ctx
+#  define secu_aes128_set_encrypt_key(cTx, kEy) aes_set_encrypt_key (cTx, AES128_KEY_SIZE, kEy)
+#  define secu_aes128_encrypt                  aes_encrypt
+#endif
+
 
 #define SECU_DIRECTION_UPLINK   0
 #define SECU_DIRECTION_DOWNLINK 1
@@ -72,6 +87,23 @@ typedef struct {
   uint32_t  blength;
 } nas_stream_cipher_t;
 
+/* AES-128 state expanded from a NAS key (KNASenc or KNASint). The NAS keys only
+ * change on security mode control, so the key schedule and the CMAC subkeys are
+ * kept with the security context and reused for every protected NAS PDU
+ * instead of being expanded (and allocated) per message. Plain data: it can be
+ * copied or zeroed together with the structure holding it.
+ */
+typedef struct nas_stream_aes_key_s {
+  uint8_t           key[16];  /* key the state below was expanded from */
+  bool              is_set;
+  SECU_AES128_CTX   aes;      /* encryption key schedule               */
+  uint8_t           k1[16];   /* CMAC subkeys (RFC 4493), 128-EIA2     */
+  uint8_t           k2[16];
+} nas_stream_aes_key_t;
+
+/* Expands key into aes_key, unless aes_key already holds its expansion */
+void nas_stream_aes_key_setup(nas_stream_aes_key_t * const aes_key, const uint8_t * const key);
+
 int nas_stream_encrypt_eea1(nas_stream_cipher_t * const stream_cipher, uint8_t * const out);
 
 int nas_stream_encrypt_eia1(nas_stream_cipher_t * const stream_cipher, uint8_t const out[4]);
@@ -80,6 +112,14 @@ int nas_stream_encrypt_eea2(nas_stream_cipher_t * const stream_cipher, uint8_t *
 
 int nas_stream_encrypt_eia2(nas_stream_cipher_t * const stream_cipher, uint8_t const out[4]);
 
+/* Same as above with the key already expanded (stream_cipher->key is not
+ * used). Nothing is allocated, 128-EEA2 can encrypt in place
+ * (out == stream_cipher->message).
+ */
+int nas_stream_encrypt_eea2_with_key(const nas_stream_aes_key_t * const aes_key, nas_stream_cipher_t * const stream_cipher, uint8_t * const out);
+
+int nas_stream_encrypt_eia2_with_key(const nas_stream_aes_key_t * const aes_key, nas_stream_cipher_t * const stream_cipher, uint8_t out[4]);
+
 #undef SECU_DEBUG
 
 #endif /* FILE_SECU_DEFS_SEEN */
@@ -23,41 +23,30 @@
 #include <stdio.h>
 #include <stdint.h>
 #include <string.h>
+#include <pthread.h>
 
 #include "rijndael.h"
 #include "snow3g.h"
 
-static uint8_t                          _MULx (
-  uint8_t V,
-  uint8_t c);
-static uint8_t                          _MULxPOW (
-  uint8_t V,
-  uint8_t i,
-  uint8_t c);
-static uint32_t                         _MULalpha (
-  uint8_t c);
-static uint32_t                         _DIValpha (
-  uint8_t c);
-static uint32_t                         _S1 (
-  uint32_t w);
-static uint32_t                         _S2 (
-  uint32_t w);
-static void                             _snow3g_clock_LFSR_initialization_mode (
-  uint32_t F,
-  snow_3g_context_t * s3g_ctx_pP);
-static void                             _snow3g_clock_LFSR_key_stream_mode (
-  snow_3g_context_t * snow_3g_context_pP);
-static uint32_t                         _snow3g_clock_fsm (
-  snow_3g_context_t * snow_3g_context_pP);
-void                                    snow3g_initialize (
-  uint32_t k[4],
-  uint32_t IV[4],
-  snow_3g_context_t * snow_3g_context_pP);
-void                                    snow3g_generate_key_stream (
-  uint32_t n,
-  uint32_t * ks,
-  snow_3g_context_t * snow_3g_context_pP);
-
+/* Tables computed once from the definitions of the specification:
+   MULalpha/DIValpha (section 3.4.2 and 3.4.3), the S-boxes S1 and S2 (section
+   3.3.1 and 3.3.2) as the XOR of four tables indexed by the bytes of the input
+   word.
+*/
+static pthread_once_t                   _snow3g_tables_once = PTHREAD_ONCE_INIT;
+static uint32_t                         _snow3g_MULalpha[256];
+static uint32_t                         _snow3g_DIValpha[256];
+static uint32_t                         _snow3g_S1_T0[256];
+static uint32_t                         _snow3g_S1_T1[256];
+static uint32_t                         _snow3g_S1_T2[256];
+static uint32_t                         _snow3g_S1_T3[256];
+static uint32_t                         _snow3g_S2_T0[256];
+static uint32_t                         _snow3g_S2_T1[256];
+static uint32_t                         _snow3g_S2_T2[256];
+static uint32_t                         _snow3g_S2_T3[256];
+
+/* LFSR register Si, the registers are a circular buffer starting at LFSR_position */
+#define LFSR_S(cTx, i)                  ((cTx)->LFSR_S[((cTx)->LFSR_position + (i)) & 15])
 
 /* _MULx.
   Input V: an 8-bit input.
@@ -92,37 +81,55 @@ _MULxPOW (
   uint8_t i,
   uint8_t c)
 {
-  if (i == 0)
-    return V;
-  else
-    return _MULx (_MULxPOW (V, i - 1, c), c);
+  while (i--) {
+    V = _MULx (V, c);
+  }
+  return V;
 }
 
-/* The function _MULalpha.
-  Input c: 8-bit input.
-  Output : 32-bit output.
-  maps 8 bits to 32 bits.
+/* Column mixing of the S-Boxes.
+  Input s0..s3: the S-Box substituted bytes, s0 the most significant.
+  Input c: 0x1b for S1, 0x69 for S2.
+  Output: r0 || r1 || r2 || r3 with r0 the most and r3 the least significant byte.
 */
 
 static                                  uint32_t
-_MULalpha (
+_snow3g_mix (
+  uint8_t s0,
+  uint8_t s1,
+  uint8_t s2,
+  uint8_t s3,
   uint8_t c)
 {
-  return ((((uint32_t) _MULxPOW (c, 23, 0xa9)) << 24) | (((uint32_t) _MULxPOW (c, 245, 0xa9)) << 16) | (((uint32_t) _MULxPOW (c, 48, 0xa9)) << 8) | (((uint32_t) _MULxPOW (c, 239, 0xa9))));
-}
+  uint8_t                                 r0 = _MULx (s0, c) ^ s1 ^ s2 ^ _MULx (s3, c) ^ s3;
+  uint8_t                                 r1 = _MULx (s0, c) ^ s0 ^ _MULx (s1, c) ^ s2 ^ s3;
+  uint8_t                                 r2 = s0 ^ _MULx (s1, c) ^ s1 ^ _MULx (s2, c) ^ s3;
+  uint8_t                                 r3 = s0 ^ s1 ^ _MULx (s2, c) ^ s2 ^ _MULx (s3, c);
 
+  return ((((uint32_t) r0) << 24) | (((uint32_t) r1) << 16) | (((uint32_t) r2) << 8) | (((uint32_t) r3)));
+}
 
-/* The function DIV alpha.
-  Input c: 8-bit input.
-  Output : 32-bit output.
-  maps 8 bits to 32 bit.
-*/
-
-static                                  uint32_t
-_DIValpha (
-  uint8_t c)
+static void
+_snow3g_init_tables (
+  void)
 {
-  return ((((uint32_t) _MULxPOW (c, 16, 0xa9)) << 24) | (((uint32_t) _MULxPOW (c, 39, 0xa9)) << 16) | (((uint32_t) _MULxPOW (c, 6, 0xa9)) << 8) | (((uint32_t) _MULxPOW (c, 64, 0xa9))));
+  int                                     c = 0;
+
+  for (c = 0; c < 256; c++) {
+    _snow3g_MULalpha[c] = (((uint32_t) _MULxPOW (c, 23, 0xa9)) << 24) | (((uint32_t) _MULxPOW (c, 245, 0xa9)) << 16) |
+                          (((uint32_t) _MULxPOW (c, 48, 0xa9)) << 8) | (((uint32_t) _MULxPOW (c, 239, 0xa9)));
+    _snow3g_DIValpha[c] = (((uint32_t) _MULxPOW (c, 16, 0xa9)) << 24) | (((uint32_t) _MULxPOW (c, 39, 0xa9)) << 16) |
+                          (((uint32_t) _MULxPOW (c, 6, 0xa9)) << 8) | (((uint32_t) _MULxPOW (c, 64, 0xa9)));
+    // the mixing is linear: S(w) is the XOR of the contributions of each byte of w
+    _snow3g_S1_T0[c] = _snow3g_mix (SR[c], 0, 0, 0, 0x1b);
+    _snow3g_S1_T1[c] = _snow3g_mix (0, SR[c], 0, 0, 0x1b);
+    _snow3g_S1_T2[c] = _snow3g_mix (0, 0, SR[c], 0, 0x1b);
+    _snow3g_S1_T3[c] = _snow3g_mix (0, 0, 0, SR[c], 0x1b);
+    _snow3g_S2_T0[c] = _snow3g_mix (SQ[c], 0, 0, 0, 0x69);
+    _snow3g_S2_T1[c] = _snow3g_mix (0, SQ[c], 0, 0, 0x69);
+    _snow3g_S2_T2[c] = _snow3g_mix (0, 0, SQ[c], 0, 0x69);
+    _snow3g_S2_T3[c] = _snow3g_mix (0, 0, 0, SQ[c], 0x69);
+  }
 }
 
 /* The 32x32-bit S-Box S1
@@ -133,28 +140,11 @@ _DIValpha (
   S1(w)= r0 || r1 || r2 || r3 with r0 the most and r3 the least significant byte.
 */
 
-static                                  uint32_t
+static inline                           uint32_t
 _S1 (
   uint32_t w)
 {
-  uint8_t                                 r0 = 0,
-    r1 = 0,
-    r2 = 0,
-    r3 = 0;
-  uint8_t                                 srw0 = SR[(uint8_t) ((w >> 24) & 0xff)];
-  uint8_t                                 srw1 = SR[(uint8_t) ((w >> 16) & 0xff)];
-  uint8_t                                 srw2 = SR[(uint8_t) ((w >> 8) & 0xff)];
-  uint8_t                                 srw3 = SR[(uint8_t) ((w) & 0xff)];
-
-  r0 = ((_MULx (srw0, 0x1b)) ^ (srw1) ^ (srw2) ^ ((_MULx (srw3, 0x1b)) ^ srw3)
-    );
-  r1 = (((_MULx (srw0, 0x1b)) ^ srw0) ^ (_MULx (srw1, 0x1b)) ^ (srw2) ^ (srw3)
-    );
-  r2 = ((srw0) ^ ((_MULx (srw1, 0x1b)) ^ srw1) ^ (_MULx (srw2, 0x1b)) ^ (srw3)
-    );
-  r3 = ((srw0) ^ (srw1) ^ ((_MULx (srw2, 0x1b)) ^ srw2) ^ (_MULx (srw3, 0x1b))
-    );
-  return ((((uint32_t) r0) << 24) | (((uint32_t) r1) << 16) | (((uint32_t) r2) << 8) | (((uint32_t) r3)));
+  return _snow3g_S1_T0[w >> 24] ^ _snow3g_S1_T1[(w >> 16) & 0xff] ^ _snow3g_S1_T2[(w >> 8) & 0xff] ^ _snow3g_S1_T3[w & 0xff];
 }
 
 /* The 32x32-bit S-Box S2
@@ -165,92 +155,30 @@ _S1 (
   Let S2(w)= r0 || r1 || r2 || r3 with r0 the most and r3 the least significant byte.
 */
 
-static                                  uint32_t
+static inline                           uint32_t
 _S2 (
   uint32_t w)
 {
-  uint8_t                                 r0 = 0,
-    r1 = 0,
-    r2 = 0,
-    r3 = 0;
-  uint8_t                                 sqw0 = SQ[(uint8_t) ((w >> 24) & 0xff)];
-  uint8_t                                 sqw1 = SQ[(uint8_t) ((w >> 16) & 0xff)];
-  uint8_t                                 sqw2 = SQ[(uint8_t) ((w >> 8) & 0xff)];
-  uint8_t                                 sqw3 = SQ[(uint8_t) ((w) & 0xff)];
-
-  r0 = ((_MULx (sqw0, 0x69)) ^ (sqw1) ^ (sqw2) ^ ((_MULx (sqw3, 0x69)) ^ sqw3)
-    );
-  r1 = (((_MULx (sqw0, 0x69)) ^ sqw0) ^ (_MULx (sqw1, 0x69)) ^ (sqw2) ^ (sqw3)
-    );
-  r2 = ((sqw0) ^ ((_MULx (sqw1, 0x69)) ^ sqw1) ^ (_MULx (sqw2, 0x69)) ^ (sqw3)
-    );
-  r3 = ((sqw0) ^ (sqw1) ^ ((_MULx (sqw2, 0x69)) ^ sqw2) ^ (_MULx (sqw3, 0x69))
-    );
-  return ((((uint32_t) r0) << 24) | (((uint32_t) r1) << 16) | (((uint32_t) r2) << 8) | (((uint32_t) r3)));
+  return _snow3g_S2_T0[w >> 24] ^ _snow3g_S2_T1[(w >> 16) & 0xff] ^ _snow3g_S2_T2[(w >> 8) & 0xff] ^ _snow3g_S2_T3[w & 0xff];
 }
 
-/* Clocking LFSR in initialization mode.
-  LFSR Registers S0 to S15 are updated as the LFSR receives a single clock.
-  Input F: a 32-bit word comes from output of FSM.
-  See section 3.4.4.
+/* Clocking LFSR.
+  LFSR Registers S0 to S15 are updated as the LFSR receives a single clock:
+  the new S15 takes the place of S0 in the circular buffer.
+  Input F: a 32-bit word comes from output of FSM in initialization mode, 0 in keystream mode.
+  See section 3.4.4 and 3.4.5.
 */
 
-static void
-_snow3g_clock_LFSR_initialization_mode (
+static inline void
+_snow3g_clock_LFSR (
   uint32_t F,
-  snow_3g_context_t * s3g_ctx_pP)
-{
-  uint32_t                                v = (((s3g_ctx_pP->LFSR_S0 << 8) & 0xffffff00) ^
-                                               (_MULalpha ((uint8_t) ((s3g_ctx_pP->LFSR_S0 >> 24) & 0xff))) ^ (s3g_ctx_pP->LFSR_S2) ^ ((s3g_ctx_pP->LFSR_S11 >> 8) & 0x00ffffff) ^ (_DIValpha ((uint8_t) ((s3g_ctx_pP->LFSR_S11) & 0xff))) ^ (F)
-    );
-
-  s3g_ctx_pP->LFSR_S0 = s3g_ctx_pP->LFSR_S1;
-  s3g_ctx_pP->LFSR_S1 = s3g_ctx_pP->LFSR_S2;
-  s3g_ctx_pP->LFSR_S2 = s3g_ctx_pP->LFSR_S3;
-  s3g_ctx_pP->LFSR_S3 = s3g_ctx_pP->LFSR_S4;
-  s3g_ctx_pP->LFSR_S4 = s3g_ctx_pP->LFSR_S5;
-  s3g_ctx_pP->LFSR_S5 = s3g_ctx_pP->LFSR_S6;
-  s3g_ctx_pP->LFSR_S6 = s3g_ctx_pP->LFSR_S7;
-  s3g_ctx_pP->LFSR_S7 = s3g_ctx_pP->LFSR_S8;
-  s3g_ctx_pP->LFSR_S8 = s3g_ctx_pP->LFSR_S9;
-  s3g_ctx_pP->LFSR_S9 = s3g_ctx_pP->LFSR_S10;
-  s3g_ctx_pP->LFSR_S10 = s3g_ctx_pP->LFSR_S11;
-  s3g_ctx_pP->LFSR_S11 = s3g_ctx_pP->LFSR_S12;
-  s3g_ctx_pP->LFSR_S12 = s3g_ctx_pP->LFSR_S13;
-  s3g_ctx_pP->LFSR_S13 = s3g_ctx_pP->LFSR_S14;
-  s3g_ctx_pP->LFSR_S14 = s3g_ctx_pP->LFSR_S15;
-  s3g_ctx_pP->LFSR_S15 = v;
-}
-
-/* Clocking LFSR in keystream mode.
-  LFSR Registers S0 to S15 are updated as the LFSR receives a single clock.
-  See section 3.4.5.
-*/
-static void
-_snow3g_clock_LFSR_key_stream_mode (
   snow_3g_context_t * snow_3g_context_pP)
 {
-  uint32_t                                v = (((snow_3g_context_pP->LFSR_S0 << 8) & 0xffffff00) ^
-                                               (_MULalpha ((uint8_t) ((snow_3g_context_pP->LFSR_S0 >> 24) & 0xff))) ^
-                                               (snow_3g_context_pP->LFSR_S2) ^ ((snow_3g_context_pP->LFSR_S11 >> 8) & 0x00ffffff) ^ (_DIValpha ((uint8_t) ((snow_3g_context_pP->LFSR_S11) & 0xff)))
-    );
-
-  snow_3g_context_pP->LFSR_S0 = snow_3g_context_pP->LFSR_S1;
-  snow_3g_context_pP->LFSR_S1 = snow_3g_context_pP->LFSR_S2;
-  snow_3g_context_pP->LFSR_S2 = snow_3g_context_pP->LFSR_S3;
-  snow_3g_context_pP->LFSR_S3 = snow_3g_context_pP->LFSR_S4;
-  snow_3g_context_pP->LFSR_S4 = snow_3g_context_pP->LFSR_S5;
-  snow_3g_context_pP->LFSR_S5 = snow_3g_context_pP->LFSR_S6;
-  snow_3g_context_pP->LFSR_S6 = snow_3g_context_pP->LFSR_S7;
-  snow_3g_context_pP->LFSR_S7 = snow_3g_context_pP->LFSR_S8;
-  snow_3g_context_pP->LFSR_S8 = snow_3g_context_pP->LFSR_S9;
-  snow_3g_context_pP->LFSR_S9 = snow_3g_context_pP->LFSR_S10;
-  snow_3g_context_pP->LFSR_S10 = snow_3g_context_pP->LFSR_S11;
-  snow_3g_context_pP->LFSR_S11 = snow_3g_context_pP->LFSR_S12;
-  snow_3g_context_pP->LFSR_S12 = snow_3g_context_pP->LFSR_S13;
-  snow_3g_context_pP->LFSR_S13 = snow_3g_context_pP->LFSR_S14;
-  snow_3g_context_pP->LFSR_S14 = snow_3g_context_pP->LFSR_S15;
-  snow_3g_context_pP->LFSR_S15 = v;
+  uint32_t                                s0 = LFSR_S (snow_3g_context_pP, 0);
+  uint32_t                                s11 = LFSR_S (snow_3g_context_pP, 11);
+
+  LFSR_S (snow_3g_context_pP, 0) = (s0 << 8) ^ _snow3g_MULalpha[s0 >> 24] ^ LFSR_S (snow_3g_context_pP, 2) ^ (s11 >> 8) ^ _snow3g_DIValpha[s11 & 0xff] ^ F;
+  snow_3g_context_pP->LFSR_position = (snow_3g_context_pP->LFSR_position + 1) & 15;
 }
 
 /* Clocking FSM.
@@ -259,12 +187,12 @@ _snow3g_clock_LFSR_key_stream_mode (
   See Section 3.4.6.
 */
 
-static                                  uint32_t
+static inline                           uint32_t
 _snow3g_clock_fsm (
   snow_3g_context_t * snow_3g_context_pP)
 {
-  uint32_t                                F = ((snow_3g_context_pP->LFSR_S15 + snow_3g_context_pP->FSM_R1) & 0xffffffff) ^ snow_3g_context_pP->FSM_R2;
-  uint32_t                                r = (snow_3g_context_pP->FSM_R2 + (snow_3g_context_pP->FSM_R3 ^ snow_3g_context_pP->LFSR_S5)) & 0xffffffff;
+  uint32_t                                F = (LFSR_S (snow_3g_context_pP, 15) + snow_3g_context_pP->FSM_R1) ^ snow_3g_context_pP->FSM_R2;
+  uint32_t                                r = snow_3g_context_pP->FSM_R2 + (snow_3g_context_pP->FSM_R3 ^ LFSR_S (snow_3g_context_pP, 5));
 
   snow_3g_context_pP->FSM_R3 = _S2 (snow_3g_context_pP->FSM_R2);
   snow_3g_context_pP->FSM_R2 = _S1 (snow_3g_context_pP->FSM_R1);
@@ -288,29 +216,32 @@ snow3g_initialize (
   uint8_t                                 i = 0;
   uint32_t                                F = 0x0;
 
-  snow_3g_context_pP->LFSR_S15 = k[3] ^ IV[0];
-  snow_3g_context_pP->LFSR_S14 = k[2];
-  snow_3g_context_pP->LFSR_S13 = k[1];
-  snow_3g_context_pP->LFSR_S12 = k[0] ^ IV[1];
-  snow_3g_context_pP->LFSR_S11 = k[3] ^ 0xffffffff;
-  snow_3g_context_pP->LFSR_S10 = k[2] ^ 0xffffffff ^ IV[2];
-  snow_3g_context_pP->LFSR_S9 = k[1] ^ 0xffffffff ^ IV[3];
-  snow_3g_context_pP->LFSR_S8 = k[0] ^ 0xffffffff;
-  snow_3g_context_pP->LFSR_S7 = k[3];
-  snow_3g_context_pP->LFSR_S6 = k[2];
-  snow_3g_context_pP->LFSR_S5 = k[1];
-  snow_3g_context_pP->LFSR_S4 = k[0];
-  snow_3g_context_pP->LFSR_S3 = k[3] ^ 0xffffffff;
-  snow_3g_context_pP->LFSR_S2 = k[2] ^ 0xffffffff;
-  snow_3g_context_pP->LFSR_S1 = k[1] ^ 0xffffffff;
-  snow_3g_context_pP->LFSR_S0 = k[0] ^ 0xffffffff;
+  pthread_once (&_snow3g_tables_once, _snow3g_init_tables);
+
+  snow_3g_context_pP->LFSR_position = 0;
+  snow_3g_context_pP->LFSR_S[15] = k[3] ^ IV[0];
+  snow_3g_context_pP->LFSR_S[14] = k[2];
+  snow_3g_context_pP->LFSR_S[13] = k[1];
+  snow_3g_context_pP->LFSR_S[12] = k[0] ^ IV[1];
+  snow_3g_context_pP->LFSR_S[11] = k[3] ^ 0xffffffff;
+  snow_3g_context_pP->LFSR_S[10] = k[2] ^ 0xffffffff ^ IV[2];
+  snow_3g_context_pP->LFSR_S[9] = k[1] ^ 0xffffffff ^ IV[3];
+  snow_3g_context_pP->LFSR_S[8] = k[0] ^ 0xffffffff;
+  snow_3g_context_pP->LFSR_S[7] = k[3];
+  snow_3g_context_pP->LFSR_S[6] = k[2];
+  snow_3g_context_pP->LFSR_S[5] = k[1];
+  snow_3g_context_pP->LFSR_S[4] = k[0];
+  snow_3g_context_pP->LFSR_S[3] = k[3] ^ 0xffffffff;
+  snow_3g_context_pP->LFSR_S[2] = k[2] ^ 0xffffffff;
+  snow_3g_context_pP->LFSR_S[1] = k[1] ^ 0xffffffff;
+  snow_3g_context_pP->LFSR_S[0] = k[0] ^ 0xffffffff;
   snow_3g_context_pP->FSM_R1 = 0x0;
   snow_3g_context_pP->FSM_R2 = 0x0;
   snow_3g_context_pP->FSM_R3 = 0x0;
 
   for (i = 0; i < 32; i++) {
     F = _snow3g_clock_fsm (snow_3g_context_pP);
-    _snow3g_clock_LFSR_initialization_mode (F, snow_3g_context_pP);
+    _snow3g_clock_LFSR (F, snow_3g_context_pP);
   }
 }
 
@@ -332,14 +263,14 @@ snow3g_generate_key_stream (
   uint32_t                                F = 0x0;
 
   _snow3g_clock_fsm (snow_3g_context_pP);       /* Clock FSM once. Discard the output. */
-  _snow3g_clock_LFSR_key_stream_mode (snow_3g_context_pP);      /* Clock LFSR in keystream mode once. */
+  _snow3g_clock_LFSR (0, snow_3g_context_pP);   /* Clock LFSR in keystream mode once. */
 
   for (t = 0; t < n; t++) {
     F = _snow3g_clock_fsm (snow_3g_context_pP); /* STEP 1 */
-    ks[t] = F ^ snow_3g_context_pP->LFSR_S0;    /* STEP 2 */
+    ks[t] = F ^ LFSR_S (snow_3g_context_pP, 0); /* STEP 2 */
     /*
      * Note that ks[t] corresponds to z_{t+1} in section 4.2
      */
-    _snow3g_clock_LFSR_key_stream_mode (snow_3g_context_pP);    /* STEP 3 */
+    _snow3g_clock_LFSR (0, snow_3g_context_pP); /* STEP 3 */
   }
 }
@@ -34,22 +34,10 @@
 #define FILE_SNOW3G_SEEN
 
 typedef struct snow_3g_context_s {
-  uint32_t LFSR_S0;
-  uint32_t LFSR_S1;
-  uint32_t LFSR_S2;
-  uint32_t LFSR_S3;
-  uint32_t LFSR_S4;
-  uint32_t LFSR_S5;
-  uint32_t LFSR_S6;
-  uint32_t LFSR_S7;
-  uint32_t LFSR_S8;
-  uint32_t LFSR_S9;
-  uint32_t LFSR_S10;
-  uint32_t LFSR_S11;
-  uint32_t LFSR_S12;
-  uint32_t LFSR_S13;
-  uint32_t LFSR_S14;
-  uint32_t LFSR_S15;
+  /* LFSR : 16 32-bit registers S0 .. S15, S0 is LFSR_S[LFSR_position].
+  */
+  uint32_t LFSR_S[16];
+  uint32_t LFSR_position;
 
   /* FSM : The Finite State Machine has three 32-bit registers R1, R2 and R3.
   */
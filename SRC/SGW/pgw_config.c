@@ -92,7 +92,7 @@ void pgw_config_init (pgw_config_t * config_pP)
 {
   memset ((char *)config_pP, 0, sizeof (*config_pP));
   pthread_rwlock_init (&config_pP->rw_lock, NULL);
-  STAILQ_INIT (&config_pP->ipv4_pool_list);
+  STAILQ_INIT (&config_pP->ipv4_reserved_list);
 }
 
 //------------------------------------------------------------------------------
@@ -100,8 +100,6 @@ int pgw_config_process (pgw_config_t * config_pP)
 {
   bstring                                 system_cmd = NULL;
   struct in_addr                          addr_start, addr_mask;
-  uint64_t                                counter64 = 0;
-  conf_ipv4_list_elm_t                   *ip4_ref = NULL;
 
   system_cmd = bformat ("iptables -t mangle -F FORWARD");
   pgw_system (system_cmd, PGW_ABORT_ON_ERROR, __FILE__, __LINE__);
@@ -179,17 +177,6 @@ int pgw_config_process (pgw_config_t * config_pP)
           inet_ntoa(config_pP->ue_pool_addr[i]), config_pP->ue_pool_mask[i], addr_start.s_addr, addr_mask.s_addr);
     }
 
-    counter64 = 0x00000000FFFFFFFF >> config_pP->ue_pool_mask[i];  // address Prefix_mask/0..0 not valid
-    counter64 = counter64 - 2;
-
-    do {
-      addr_start.s_addr = addr_start.s_addr + htonl (2);
-      ip4_ref = calloc (1, sizeof (conf_ipv4_list_elm_t));
-      ip4_ref->addr = addr_start;
-      STAILQ_INSERT_TAIL (&config_pP->ipv4_pool_list, ip4_ref, ipv4_entries);
-      counter64 = counter64 - 1;
-    } while (counter64 > 0);
-
     //---------------
     if (config_pP->masquerade_SGI) {
       system_cmd = bformat ("iptables -t nat -I POSTROUTING -s %s/%d -o %s  ! --protocol sctp -j SNAT --to-source %s",
@@ -344,6 +331,25 @@ int pgw_config_parse_file (pgw_config_t * config_pP)
         OAILOG_WARNING (LOG_SPGW_APP, "CONFIG POOL ADDR IPV4: NO IPV4 ADDRESS FOUND\n");
       }
 
+      sub2setting = config_setting_get_member (subsetting, PGW_CONFIG_STRING_IPV4_RESERVED_ADDRESS_LIST);
+
+      if (sub2setting) {
+        num = config_setting_length (sub2setting);
+
+        for (i = 0; i < num; i++) {
+          astring = config_setting_get_string_elem (sub2setting, i);
+
+          if ((astring) && (inet_pton (AF_INET, astring, buf_in_addr) == 1)) {
+            conf_ipv4_list_elm_t                   *ip4_ref = calloc (1, sizeof (conf_ipv4_list_elm_t));
+
+            memcpy (&ip4_ref->addr, buf_in_addr, sizeof (struct in_addr));
+            STAILQ_INSERT_TAIL (&config_pP->ipv4_reserved_list, ip4_ref, ipv4_entries);
+          } else {
+            OAILOG_ERROR (LOG_SPGW_APP, "CONFIG POOL ADDR IPV4: BAD RESERVED ADDRESS: %s\n", astring);
+          }
+        }
+      }
+
       if (config_setting_lookup_string (setting_pgw, PGW_CONFIG_STRING_DEFAULT_DNS_IPV4_ADDRESS, (const char **)&default_dns)
           && config_setting_lookup_string (setting_pgw, PGW_CONFIG_STRING_DEFAULT_DNS_SEC_IPV4_ADDRESS, (const char **)&default_dns_sec)) {
         config_pP->ipv4.if_name_S5_S8 = bfromcstr (if_S5_S8);
@@ -393,6 +399,18 @@ void pgw_config_display (pgw_config_t * config_p)
   OAILOG_INFO (LOG_SPGW_APP, "    SGi ip  (read)........: %s\n", inet_ntoa (*((struct in_addr *)&config_p->ipv4.SGI)));
   OAILOG_INFO (LOG_SPGW_APP, "    SGi MTU (read)........: %u\n", config_p->ipv4.mtu_SGI);
 
+  OAILOG_INFO (LOG_SPGW_APP, "- UE pools:\n");
+  for (int i = 0; i < config_p->num_ue_pool; i++) {
+    OAILOG_INFO (LOG_SPGW_APP, "    IPv4 pool ............: %s/%d\n", inet_ntoa (config_p->ue_pool_addr[i]), config_p->ue_pool_mask[i]);
+  }
+  {
+    conf_ipv4_list_elm_t                   *ip4_ref = NULL;
+
+    STAILQ_FOREACH (ip4_ref, &config_p->ipv4_reserved_list, ipv4_entries) {
+      OAILOG_INFO (LOG_SPGW_APP, "    IPv4 reserved ........: %s\n", inet_ntoa (ip4_ref->addr));
+    }
+  }
+
   OAILOG_INFO (LOG_SPGW_APP, "- MSS clamping: ..........: %d\n", config_p->ue_tcp_mss_clamp);
   OAILOG_INFO (LOG_SPGW_APP, "- Masquerading: ..........: %d\n", config_p->masquerade_SGI);
   OAILOG_INFO (LOG_SPGW_APP, "- Push PCO: ..............: %d\n", config_p->force_push_pco);
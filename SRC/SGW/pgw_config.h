@@ -45,6 +45,7 @@
 
 #define PGW_CONFIG_STRING_IP_ADDRESS_POOL                       "IP_ADDRESS_POOL"
 #define PGW_CONFIG_STRING_IPV4_ADDRESS_LIST                     "IPV4_LIST"
+#define PGW_CONFIG_STRING_IPV4_RESERVED_ADDRESS_LIST            "IPV4_RESERVED_LIST"
 #define PGW_CONFIG_STRING_IPV4_PREFIX_DELIMITER                 '/'
 #define PGW_CONFIG_STRING_DEFAULT_DNS_IPV4_ADDRESS              "DEFAULT_DNS_IPV4_ADDRESS"
 #define PGW_CONFIG_STRING_DEFAULT_DNS_SEC_IPV4_ADDRESS          "DEFAULT_DNS_SEC_IPV4_ADDRESS"
@@ -101,7 +102,8 @@ typedef struct pgw_config_s {
   bool      force_push_pco;
   uint16_t  ue_mtu;
 
-  STAILQ_HEAD(ipv4_pool_head_s, conf_ipv4_list_elm_s) ipv4_pool_list;
+  // addresses of the pools never allocated to UEs, statically assigned
+  STAILQ_HEAD(ipv4_reserved_head_s, conf_ipv4_list_elm_s) ipv4_reserved_list;
 } pgw_config_t;
 
 
@@ -0,0 +1,176 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under 
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.  
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file pgw_ipv4_pool.c
+  \brief Allocator of the UE IPv4 addresses of a P-GW pool
+*/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common_defs.h"
+#include "pgw_ipv4_pool.h"
+
+#define WORD_BITS 64
+#define WORD_BIT(iNDEX) (1ull << ((iNDEX) & (WORD_BITS - 1)))
+
+//------------------------------------------------------------------------------
+static uint32_t _pgw_ipv4_pool_nb_words (const uint32_t nb_bits)
+{
+  return (nb_bits + WORD_BITS - 1) / WORD_BITS;
+}
+
+//------------------------------------------------------------------------------
+/* Marks index as used, the words left without free bit are cleared in the upper levels */
+static void _pgw_ipv4_pool_clear (pgw_ipv4_pool_t * const pool, uint32_t index)
+{
+  for (int l = 0; l < pool->nb_levels; l++) {
+    pool->levels[l][index / WORD_BITS] &= ~WORD_BIT (index);
+    if (pool->levels[l][index / WORD_BITS]) {
+      break;
+    }
+    index /= WORD_BITS;
+  }
+  pool->nb_allocated++;
+}
+
+//------------------------------------------------------------------------------
+static bool _pgw_ipv4_pool_is_free (const pgw_ipv4_pool_t * const pool, const uint32_t index)
+{
+  return (pool->levels[0][index / WORD_BITS] & WORD_BIT (index)) != 0;
+}
+
+//------------------------------------------------------------------------------
+int pgw_ipv4_pool_init (pgw_ipv4_pool_t * const pool, const uint32_t network, const uint8_t prefix_len)
+{
+  uint32_t                                nb_bits = 0;
+
+  memset (pool, 0, sizeof (*pool));
+  if ((prefix_len < 2) || (prefix_len > 30) || (network & (0xFFFFFFFF >> prefix_len))) {
+    return RETURNerror;
+  }
+  pool->network = network;
+  pool->prefix_len = prefix_len;
+  pool->first = network + 2;
+  pool->size = (1u << (32 - prefix_len)) - 3;
+
+  nb_bits = pool->size;
+  do {
+    uint32_t                                nb_words = _pgw_ipv4_pool_nb_words (nb_bits);
+
+    pool->levels[pool->nb_levels] = calloc (nb_words, sizeof (uint64_t));
+    if (pool->levels[pool->nb_levels] == NULL) {
+      pgw_ipv4_pool_free (pool);
+      return RETURNerror;
+    }
+    // the bits of the nb_bits first addresses or words are set, the padding stays clear
+    memset (pool->levels[pool->nb_levels], 0xFF, (nb_bits / WORD_BITS) * sizeof (uint64_t));
+    if (nb_bits % WORD_BITS) {
+      pool->levels[pool->nb_levels][nb_words - 1] = WORD_BIT (nb_bits) - 1;
+    }
+    pool->nb_levels++;
+    nb_bits = nb_words;
+  } while (nb_bits > 1);
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+void pgw_ipv4_pool_free (pgw_ipv4_pool_t * const pool)
+{
+  for (int l = 0; l < PGW_IPV4_POOL_MAX_LEVELS; l++) {
+    free (pool->levels[l]);
+    pool->levels[l] = NULL;
+  }
+  pool->nb_levels = 0;
+  pool->size = 0;
+  pool->nb_allocated = 0;
+}
+
+//------------------------------------------------------------------------------
+bool pgw_ipv4_pool_contains (const pgw_ipv4_pool_t * const pool, const uint32_t addr)
+{
+  return (addr - pool->first) < pool->size;
+}
+
+//------------------------------------------------------------------------------
+int pgw_ipv4_pool_allocate (pgw_ipv4_pool_t * const pool, uint32_t * const addr)
+{
+  uint32_t                                index = 0;
+
+  if (pool->nb_allocated == pool->size) {
+    return RETURNerror;
+  }
+  // a set bit in a level tells which word of the level below has a free bit
+  for (int l = pool->nb_levels - 1; l >= 0; l--) {
+    index = index * WORD_BITS + __builtin_ctzll (pool->levels[l][index]);
+  }
+  _pgw_ipv4_pool_clear (pool, index);
+  *addr = pool->first + index;
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+int pgw_ipv4_pool_reserve (pgw_ipv4_pool_t * const pool, const uint32_t addr)
+{
+  uint32_t                                index = addr - pool->first;
+
+  if ((index >= pool->size) || !_pgw_ipv4_pool_is_free (pool, index)) {
+    return RETURNerror;
+  }
+  _pgw_ipv4_pool_clear (pool, index);
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+int pgw_ipv4_pool_release (pgw_ipv4_pool_t * const pool, const uint32_t addr)
+{
+  uint32_t                                index = addr - pool->first;
+
+  if ((index >= pool->size) || _pgw_ipv4_pool_is_free (pool, index)) {
+    return RETURNerror;
+  }
+  // the upper levels are already set if the word had a free bit
+  for (int l = 0; l < pool->nb_levels; l++) {
+    uint64_t                                word = pool->levels[l][index / WORD_BITS];
+
+    pool->levels[l][index / WORD_BITS] = word | WORD_BIT (index);
+    if (word) {
+      break;
+    }
+    index /= WORD_BITS;
+  }
+  pool->nb_allocated--;
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+size_t pgw_ipv4_pool_memory_size (const pgw_ipv4_pool_t * const pool)
+{
+  size_t                                  size = sizeof (*pool);
+  uint32_t                                nb_bits = pool->size;
+
+  for (int l = 0; l < pool->nb_levels; l++) {
+    nb_bits = _pgw_ipv4_pool_nb_words (nb_bits);
+    size += nb_bits * sizeof (uint64_t);
+  }
+  return size;
+}
@@ -0,0 +1,61 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under 
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.  
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file pgw_ipv4_pool.h
+  \brief Allocator of the UE IPv4 addresses of a P-GW pool
+
+  A pool is a network/prefix_len of the configuration, the network address,
+  the first host address (kept for the P-GW) and the broadcast address are
+  never allocated. Free addresses are tracked in a hierarchical bitmap: one
+  bit per address, then one bit per 64 bits word of the level below telling
+  if the word has a free address, up to a single word. Allocation takes the
+  lowest free address, allocation, reservation and release visit at most one
+  word per level (5 levels for a /2), the memory is about 1 bit per address.
+  Addresses are in host byte order.
+*/
+#ifndef FILE_PGW_IPV4_POOL_SEEN
+#define FILE_PGW_IPV4_POOL_SEEN
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define PGW_IPV4_POOL_MAX_LEVELS 6
+
+typedef struct pgw_ipv4_pool_s {
+  uint32_t         network;
+  uint8_t          prefix_len;
+  uint32_t         first;         // first allocatable address
+  uint32_t         size;          // number of allocatable addresses
+  uint32_t         nb_allocated;  // allocated or reserved
+  uint8_t          nb_levels;
+  uint64_t        *levels[PGW_IPV4_POOL_MAX_LEVELS]; // levels[0] has a bit per address, a set bit is free
+} pgw_ipv4_pool_t;
+
+int    pgw_ipv4_pool_init        (pgw_ipv4_pool_t * const pool, const uint32_t network, const uint8_t prefix_len);
+void   pgw_ipv4_pool_free        (pgw_ipv4_pool_t * const pool);
+bool   pgw_ipv4_pool_contains    (const pgw_ipv4_pool_t * const pool, const uint32_t addr);
+int    pgw_ipv4_pool_allocate    (pgw_ipv4_pool_t * const pool, uint32_t * const addr);
+int    pgw_ipv4_pool_reserve     (pgw_ipv4_pool_t * const pool, const uint32_t addr);
+int    pgw_ipv4_pool_release     (pgw_ipv4_pool_t * const pool, const uint32_t addr);
+size_t pgw_ipv4_pool_memory_size (const pgw_ipv4_pool_t * const pool);
+
+#endif /* FILE_PGW_IPV4_POOL_SEEN */
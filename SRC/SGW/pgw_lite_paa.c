@@ -49,8 +49,6 @@
 #include "pgw_lite_paa.h"
 
 
-//#define PGW_LITE_FREE_ADDR_POOL_CONFIG 1
-
 extern pgw_app_t                        pgw_app;
 
 
@@ -60,80 +58,87 @@ pgw_load_pool_ip_addresses (
   void)
 {
   struct conf_ipv4_list_elm_s   *conf_ipv4_p = NULL;
-  struct ipv4_list_elm_s        *ipv4_p = NULL;
-  //struct conf_ipv6_list_elm_s   *conf_ipv6_p = NULL;
-  //struct ipv6_list_elm_s        *ipv6_p = NULL;
-  //char                           print_buffer[INET6_ADDRSTRLEN];
-
-  STAILQ_INIT (&pgw_app.ipv4_list_free);
-  STAILQ_INIT (&pgw_app.ipv4_list_allocated);
-  STAILQ_FOREACH (conf_ipv4_p, &spgw_config.pgw_config.ipv4_pool_list, ipv4_entries) {
-    ipv4_p = calloc (1, sizeof (struct ipv4_list_elm_s));
-    ipv4_p->addr.s_addr = ntohl (conf_ipv4_p->addr.s_addr);
-    STAILQ_INSERT_TAIL (&pgw_app.ipv4_list_free, ipv4_p, ipv4_entries);
-    //SPGW_APP_DEBUG("Loaded IPv4 PAA address in pool: %s\n",
-    //        inet_ntoa(conf_ipv4_p->addr));
+  pgw_ipv4_pool_t               *pool = NULL;
+
+  pgw_app.num_ipv4_pools = 0;
+  for (int i = 0; i < spgw_config.pgw_config.num_ue_pool; i++) {
+    pool = &pgw_app.ipv4_pools[pgw_app.num_ipv4_pools];
+    AssertFatal (pgw_ipv4_pool_init (pool, ntohl (spgw_config.pgw_config.ue_pool_addr[i].s_addr), spgw_config.pgw_config.ue_pool_mask[i]) == RETURNok,
+        "Could not load IPv4 PAA pool %s/%d\n", inet_ntoa (spgw_config.pgw_config.ue_pool_addr[i]), spgw_config.pgw_config.ue_pool_mask[i]);
+    for (int j = 0; j < pgw_app.num_ipv4_pools; j++) {
+      AssertFatal (!pgw_ipv4_pool_contains (&pgw_app.ipv4_pools[j], pool->network) && !pgw_ipv4_pool_contains (pool, pgw_app.ipv4_pools[j].network),
+          "IPv4 PAA pool %s/%d overlaps another pool\n", inet_ntoa (spgw_config.pgw_config.ue_pool_addr[i]), spgw_config.pgw_config.ue_pool_mask[i]);
+    }
+    pgw_app.num_ipv4_pools++;
+    OAILOG_DEBUG (LOG_SPGW_APP, "Loaded IPv4 PAA pool %s/%d: %u addresses, %zu bytes\n", inet_ntoa (spgw_config.pgw_config.ue_pool_addr[i]),
+        spgw_config.pgw_config.ue_pool_mask[i], pool->size, pgw_ipv4_pool_memory_size (pool));
   }
 
-//  STAILQ_FOREACH (conf_ipv6_p, &spgw_config.pgw_config.pgw_lite_ipv6_pool_list, ipv6_entries) {
-//    ipv6_p = calloc (1, sizeof (struct pgw_lite_ipv6_list_elm_s));
-//    ipv6_p->addr = conf_ipv6_p->addr;
-//    ipv6_p->prefix_len = conf_ipv6_p->prefix_len;
-//    ipv6_p->num_allocated = 0;
-//    STAILQ_INSERT_TAIL (&pgw_app.pgw_lite_ipv6_list_free, ipv6_p, ipv6_entries);
-//
-//    if (inet_ntop (AF_INET6, &ipv6_p->addr, print_buffer, INET6_ADDRSTRLEN) == NULL) {
-//      OAILOG_ERROR (LOG_SPGW_APP, "Could not Load IPv6 PAA address in pool: %s\n", strerror (errno));
-//    }                           /*else {
-//                                 *
-//                                 * SPGW_APP_DEBUG("Loaded IPv6 PAA prefix in pool: %s\n",print_buffer);
-//                                 * } */
-//  }
-#if PGW_LITE_FREE_ADDR_POOL_CONFIG
-
-  while ((conf_ipv4_p = STAILQ_FIRST (&spgw_config.pgw_config.ipv4_pool_list))) {
-    STAILQ_REMOVE_HEAD (&spgw_config.pgw_config.ipv4_pool_list, ipv4_entries);
-    free_wrapper ((void **) &conf_ipv4_p);
-  }
+  STAILQ_FOREACH (conf_ipv4_p, &spgw_config.pgw_config.ipv4_reserved_list, ipv4_entries) {
+    struct in_addr                          addr = {.s_addr = ntohl (conf_ipv4_p->addr.s_addr)};
 
-#endif
+    if (pgw_reserve_ipv4_paa_address (&addr) != RETURNok) {
+      OAILOG_WARNING (LOG_SPGW_APP, "Reserved IPv4 PAA address %s not in a pool or already reserved\n", inet_ntoa (conf_ipv4_p->addr));
+    }
+  }
 }
 
+void
+pgw_free_pool_ip_addresses (
+  void)
+{
+  for (int i = 0; i < pgw_app.num_ipv4_pools; i++) {
+    pgw_ipv4_pool_free (&pgw_app.ipv4_pools[i]);
+  }
+  pgw_app.num_ipv4_pools = 0;
+}
 
+static pgw_ipv4_pool_t *
+pgw_find_ipv4_pool (
+  const struct in_addr *const addr_pP)
+{
+  for (int i = 0; i < pgw_app.num_ipv4_pools; i++) {
+    if (pgw_ipv4_pool_contains (&pgw_app.ipv4_pools[i], addr_pP->s_addr)) {
+      return &pgw_app.ipv4_pools[i];
+    }
+  }
+  return NULL;
+}
 
+// Addresses are in host byte order
 int
 pgw_get_free_ipv4_paa_address (
   struct in_addr *const addr_pP)
 {
-  struct ipv4_list_elm_s        *ipv4_p = NULL;
+  for (int i = 0; i < pgw_app.num_ipv4_pools; i++) {
+    if (pgw_ipv4_pool_allocate (&pgw_app.ipv4_pools[i], &addr_pP->s_addr) == RETURNok) {
+      return RETURNok;
+    }
+  }
+  addr_pP->s_addr = INADDR_ANY;
+  return RETURNerror;
+}
+
+int
+pgw_reserve_ipv4_paa_address (
+  const struct in_addr *const addr_pP)
+{
+  pgw_ipv4_pool_t               *pool = pgw_find_ipv4_pool (addr_pP);
 
-  if (STAILQ_EMPTY (&pgw_app.ipv4_list_free)) {
-    addr_pP->s_addr = INADDR_ANY;
+  if (pool == NULL) {
     return RETURNerror;
   }
-
-  ipv4_p = STAILQ_FIRST (&pgw_app.ipv4_list_free);
-  STAILQ_REMOVE (&pgw_app.ipv4_list_free, ipv4_p, ipv4_list_elm_s, ipv4_entries);
-  STAILQ_INSERT_TAIL (&pgw_app.ipv4_list_allocated, ipv4_p, ipv4_entries);
-  addr_pP->s_addr = ipv4_p->addr.s_addr;
-  return RETURNok;
+  return pgw_ipv4_pool_reserve (pool, addr_pP->s_addr);
 }
 
 int
 pgw_release_free_ipv4_paa_address (
   const struct in_addr *const addr_pP)
 {
-  struct ipv4_list_elm_s        *ipv4_p = NULL;
+  pgw_ipv4_pool_t               *pool = pgw_find_ipv4_pool (addr_pP);
 
-  STAILQ_FOREACH (ipv4_p, &pgw_app.ipv4_list_allocated, ipv4_entries) {
-    if (ipv4_p->addr.s_addr == addr_pP->s_addr) {
-      STAILQ_REMOVE (&pgw_app.ipv4_list_allocated, ipv4_p, ipv4_list_elm_s, ipv4_entries);
-      STAILQ_INSERT_TAIL (&pgw_app.ipv4_list_free, ipv4_p, ipv4_entries);
-      return RETURNok;
-    }
+  if (pool == NULL) {
+    return RETURNerror;
   }
-  return RETURNerror;
+  return pgw_ipv4_pool_release (pool, addr_pP->s_addr);
 }
-
-
-
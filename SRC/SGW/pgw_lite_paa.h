@@ -29,7 +29,9 @@
 #define FILE_PGW_LITE_PAA_SEEN
 
 void pgw_load_pool_ip_addresses       (void);
+void pgw_free_pool_ip_addresses       (void);
 int pgw_get_free_ipv4_paa_address     (struct in_addr * const addr_P);
+int pgw_reserve_ipv4_paa_address      (const struct in_addr * const addr_P);
 int pgw_release_free_ipv4_paa_address (const struct in_addr * const addr_P);
 
 #endif
@@ -37,6 +37,9 @@
 #include "common_types.h"
 #include "sgw_context_manager.h"
 #include "gtpv1u_sgw_defs.h"
+#include "pgw_config.h"
+#include "pgw_ipv4_pool.h"
+#include "teid_pool.h"
 
 typedef struct sgw_app_s {
 
@@ -48,6 +51,11 @@ typedef struct sgw_app_s {
 
   ipv4_nbo_t sgw_ip_address_S5_S8_up; // unused now
 
+  // S-GW local TEIDs, allocated and released by TASK_SPGW_APP only,
+  // the S11 TEIDs of a shard are handled by the S11 task of this shard
+  teid_shards_t    s11_teid_shards;
+  teid_pool_t      s1u_teid_pool;
+
   // key is S11 S-GW local teid
   hash_table_ts_t *s11teid2mme_hashtable;
 
@@ -61,15 +69,10 @@ typedef struct sgw_app_s {
 } sgw_app_t;
 
 
-struct ipv4_list_elm_s {
-  STAILQ_ENTRY(ipv4_list_elm_s) ipv4_entries;
-  struct in_addr  addr;
-};
-
-
 typedef struct pgw_app_s {
-  STAILQ_HEAD(ipv4_list_free_head_s,     ipv4_list_elm_s) ipv4_list_free;
-  STAILQ_HEAD(pv4_list_allocated_head_s, ipv4_list_elm_s) ipv4_list_allocated;
+  // UE IPv4 address pools, in the order of the configuration
+  int              num_ipv4_pools;
+  pgw_ipv4_pool_t  ipv4_pools[PGW_NUM_UE_POOL_MAX];
 } pgw_app_t;
 
 #endif
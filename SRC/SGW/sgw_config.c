@@ -43,6 +43,7 @@
 #include "dynamic_memory_check.h"
 #include "log.h"
 #include "intertask_interface.h"
+#include "mme_default_values.h"
 #include "sgw_config.h"
 
 #ifdef LIBCONFIG_LONG
@@ -62,6 +63,7 @@ void sgw_config_init (sgw_config_t * config_pP)
 {
   memset(config_pP, 0, sizeof(*config_pP));
   pthread_rwlock_init (&config_pP->rw_lock, NULL);
+  config_pP->ipv4.nb_s11_shards = S11_SHARDS;
 }
 //------------------------------------------------------------------------------
 int sgw_config_process (sgw_config_t * config_pP)
@@ -83,6 +85,7 @@ int sgw_config_parse_file (sgw_config_t * config_pP)
   char                                   *sgw_if_name_S11 = NULL;
   char                                   *S11 = NULL;
   libconfig_int                           sgw_udp_port_S1u_S12_S4_up = 2152;
+  libconfig_int                           sgw_s11_shards = 0;
   config_setting_t                       *subsetting = NULL;
   const char                             *astring = NULL;
   bstring                                 address = NULL;
@@ -149,6 +152,16 @@ int sgw_config_parse_file (sgw_config_t * config_pP)
         }
       }
 
+      if (config_setting_lookup_string (subsetting, LOG_CONFIG_STRING_OUTPUT_BINARY, (const char **)&astring)) {
+        if (astring != NULL) {
+          if (strcasecmp (astring, "yes") == 0) {
+            config_pP->log_config.is_output_binary = true;
+          } else {
+            config_pP->log_config.is_output_binary = false;
+          }
+        }
+      }
+
       if (config_setting_lookup_string (subsetting, LOG_CONFIG_STRING_COLOR, (const char **)&astring)) {
         if (!strcasecmp("true", astring)) config_pP->log_config.color = true;
         else config_pP->log_config.color = false;
@@ -244,6 +257,12 @@ int sgw_config_parse_file (sgw_config_t * config_pP)
       } else {
         config_pP->udp_port_S1u_S12_S4_up = sgw_udp_port_S1u_S12_S4_up;
       }
+
+      if (config_setting_lookup_int (subsetting, SGW_CONFIG_STRING_SGW_S11_SHARDS, &sgw_s11_shards)) {
+        AssertFatal ((sgw_s11_shards > 0) && (sgw_s11_shards <= S11_MAX_SHARDS) && !(sgw_s11_shards & (sgw_s11_shards - 1)),
+            "Bad %s value %d, must be a power of 2 up to %d\n", SGW_CONFIG_STRING_SGW_S11_SHARDS, sgw_s11_shards, S11_MAX_SHARDS);
+        config_pP->ipv4.nb_s11_shards = (uint8_t) sgw_s11_shards;
+      }
     }
   }
 
@@ -270,6 +289,7 @@ void sgw_config_display (sgw_config_t * config_p)
   OAILOG_INFO (LOG_SPGW_APP, "- S11:\n");
   OAILOG_INFO (LOG_SPGW_APP, "    S11 iface ............: %s\n", bdata(config_p->ipv4.if_name_S11));
   OAILOG_INFO (LOG_SPGW_APP, "    S11 ip ...............: %s/%u\n", inet_ntoa (*((struct in_addr *)&config_p->ipv4.S11)), config_p->ipv4.netmask_S11);
+  OAILOG_INFO (LOG_SPGW_APP, "    S11 shards ...........: %u\n", config_p->ipv4.nb_s11_shards);
   OAILOG_INFO (LOG_SPGW_APP, "- ITTI:\n");
   OAILOG_INFO (LOG_SPGW_APP, "    queue size .......: %u (bytes)\n", config_p->itti_config.queue_size);
   OAILOG_INFO (LOG_SPGW_APP, "    log file .........: %s\n", bdata(config_p->itti_config.log_file));
@@ -277,6 +297,7 @@ void sgw_config_display (sgw_config_t * config_p)
   OAILOG_INFO (LOG_SPGW_APP, "- Logging:\n");
   OAILOG_INFO (LOG_SPGW_APP, "    Output ..............: %s\n", bdata(config_p->log_config.output));
   OAILOG_INFO (LOG_SPGW_APP, "    Output thread-safe...: %s\n", (config_p->log_config.is_output_thread_safe) ? "true":"false");
+  OAILOG_INFO (LOG_SPGW_APP, "    Output binary........: %s\n", (config_p->log_config.is_output_binary) ? "true":"false");
   OAILOG_INFO (LOG_SPGW_APP, "    UDP log level........: %s\n", OAILOG_LEVEL_INT2STR(config_p->log_config.udp_log_level));
   OAILOG_INFO (LOG_SPGW_APP, "    GTPV1-U log level....: %s\n", OAILOG_LEVEL_INT2STR(config_p->log_config.gtpv1u_log_level));
   OAILOG_INFO (LOG_SPGW_APP, "    GTPV2-C log level....: %s\n", OAILOG_LEVEL_INT2STR(config_p->log_config.gtpv2c_log_level));
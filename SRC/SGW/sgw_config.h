@@ -44,6 +44,7 @@
 #define SGW_CONFIG_STRING_SGW_IPV4_ADDRESS_FOR_S5_S8_UP         "SGW_IPV4_ADDRESS_FOR_S5_S8_UP"
 #define SGW_CONFIG_STRING_SGW_INTERFACE_NAME_FOR_S11            "SGW_INTERFACE_NAME_FOR_S11"
 #define SGW_CONFIG_STRING_SGW_IPV4_ADDRESS_FOR_S11              "SGW_IPV4_ADDRESS_FOR_S11"
+#define SGW_CONFIG_STRING_SGW_S11_SHARDS                        "SGW_S11_SHARDS"
 
 #define SPGW_ABORT_ON_ERROR true
 #define SPGW_WARN_ON_ERROR false
@@ -69,6 +70,7 @@ typedef struct sgw_config_s {
     bstring    if_name_S11;
     ipv4_nbo_t S11;
     int        netmask_S11;
+    uint8_t    nb_s11_shards;
   } ipv4;
   uint16_t     udp_port_S1u_S12_S4_up;
 
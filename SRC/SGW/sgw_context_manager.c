@@ -177,14 +177,10 @@ pgw_lite_cm_free_apn (
 //-----------------------------------------------------------------------------
 teid_t
 sgw_get_new_S11_tunnel_id (
-  void)
+  const uint32_t s11_shard)
 //-----------------------------------------------------------------------------
 {
-  // TO DO: RANDOM
-  static teid_t                           tunnel_id = 0;
-
-  tunnel_id += 1;
-  return tunnel_id;
+  return teid_pool_allocate (&sgw_app.s11_teid_shards.pools[s11_shard & (sgw_app.s11_teid_shards.nb_shards - 1)]);
 }
 
 //-----------------------------------------------------------------------------
@@ -225,6 +221,7 @@ sgw_cm_remove_s11_tunnel (
   int                                     temp = 0;
 
   temp = hashtable_ts_free (sgw_app.s11teid2mme_hashtable, local_teid);
+  teid_shards_release (&sgw_app.s11_teid_shards, local_teid);
   return temp;
 }
 
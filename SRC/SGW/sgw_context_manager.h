@@ -60,7 +60,7 @@ void                                   sgw_display_s11_bearer_context_informatio
 void                                   pgw_lite_cm_free_apn(pgw_apn_t **apnP);
 
 
-teid_t                                 sgw_get_new_S11_tunnel_id(void);
+teid_t                                 sgw_get_new_S11_tunnel_id(const uint32_t s11_shard);
 mme_sgw_tunnel_t *                     sgw_cm_create_s11_tunnel(teid_t remote_teid, teid_t local_teid);
 int                                    sgw_cm_remove_s11_tunnel(teid_t local_teid);
 sgw_eps_bearer_entry_t *               sgw_cm_create_eps_bearer_entry(void);
@@ -55,6 +55,7 @@
 #include "pgw_lite_paa.h"
 #include "pgw_pco.h"
 #include "spgw_config.h"
+#include "s11_sgw.h"
 #include "ProtocolConfigurationOptions.h"
 
 #include "gtp_mod_kernel.h"
@@ -62,26 +63,25 @@
 extern sgw_app_t                        sgw_app;
 extern spgw_config_t                    spgw_config;
 
-static uint32_t                         g_gtpv1u_teid = 0;
-
 //------------------------------------------------------------------------------
 uint32_t
 sgw_get_new_teid (
   void)
 {
-  g_gtpv1u_teid = g_gtpv1u_teid + 1;
-  return g_gtpv1u_teid;
+  return teid_pool_allocate (&sgw_app.s1u_teid_pool);
 }
 
 
 //------------------------------------------------------------------------------
 int
 sgw_handle_create_session_request (
-  const itti_s11_create_session_request_t * const session_req_pP)
+  const itti_s11_create_session_request_t * const session_req_pP,
+  const uint32_t s11_shard)
 {
   mme_sgw_tunnel_t                       *new_endpoint_p = NULL;
   s_plus_p_gw_eps_bearer_context_information_t *s_plus_p_gw_eps_bearer_ctxt_info_p = NULL;
   sgw_eps_bearer_entry_t                 *eps_bearer_entry_p = NULL;
+  teid_t                                  local_teid = INVALID_TEID;
 
   OAILOG_FUNC_IN(LOG_SPGW_APP);
   /*
@@ -109,9 +109,21 @@ sgw_handle_create_session_request (
     OAILOG_FUNC_RETURN(LOG_SPGW_APP, RETURNerror);
   }
 
-  new_endpoint_p = sgw_cm_create_s11_tunnel (session_req_pP->sender_fteid_for_cp.teid, sgw_get_new_S11_tunnel_id ());
+  /*
+   * The S11 task of the shard that received the request sends the response,
+   * the S-GW S11 TEID is allocated in this shard
+   */
+  local_teid = sgw_get_new_S11_tunnel_id (s11_shard);
+
+  if (local_teid == INVALID_TEID) {
+    OAILOG_ERROR (LOG_SPGW_APP, "No S11 TEID left\n");
+    OAILOG_FUNC_RETURN(LOG_SPGW_APP, RETURNerror);
+  }
+
+  new_endpoint_p = sgw_cm_create_s11_tunnel (session_req_pP->sender_fteid_for_cp.teid, local_teid);
 
   if (new_endpoint_p == NULL) {
+    teid_shards_release (&sgw_app.s11_teid_shards, local_teid);
     OAILOG_WARNING (LOG_SPGW_APP, "Could not create new tunnel endpoint between S-GW and MME " "for S11 abstraction\n");
     OAILOG_FUNC_RETURN(LOG_SPGW_APP, RETURNerror);
   }
@@ -327,7 +339,7 @@ sgw_handle_sgi_endpoint_created (
                       create_session_response_p->bearer_contexts_created.bearer_contexts[0].s1u_sgw_fteid.ipv4_address,
                       create_session_response_p->bearer_contexts_created.bearer_contexts[0].eps_bearer_id,
                       create_session_response_p->bearer_contexts_created.bearer_contexts[0].cause);
-  rv = itti_send_msg_to_task (TASK_S11, INSTANCE_DEFAULT, message_p);
+  rv = itti_send_msg_to_task (s11_sgw_task_id (resp_pP->context_teid), INSTANCE_DEFAULT, message_p);
   OAILOG_FUNC_RETURN(LOG_SPGW_APP, rv);
 }
 
@@ -495,7 +507,7 @@ sgw_handle_gtpv1uCreateTunnelResp (
     create_session_response_p->trxn = new_bearer_ctxt_info_p->sgw_eps_bearer_context_information.trxn;
     create_session_response_p->peer_ip = new_bearer_ctxt_info_p->sgw_eps_bearer_context_information.peer_ip;
   }
-  rv = itti_send_msg_to_task (TASK_S11, INSTANCE_DEFAULT, message_p);
+  rv = itti_send_msg_to_task (s11_sgw_task_id (endpoint_created_pP->context_teid), INSTANCE_DEFAULT, message_p);
   OAILOG_FUNC_RETURN(LOG_SPGW_APP, rv);
 }
 //------------------------------------------------------------------------------
@@ -534,7 +546,7 @@ sgw_handle_gtpv1uUpdateTunnelResp (
       modify_response_p->bearer_contexts_marked_for_removal.num_bearer_context += 1;
       modify_response_p->cause = CONTEXT_NOT_FOUND;
       modify_response_p->trxn = new_bearer_ctxt_info_p->sgw_eps_bearer_context_information.trxn;
-      rv = itti_send_msg_to_task (TASK_S11, INSTANCE_DEFAULT, message_p);
+      rv = itti_send_msg_to_task (s11_sgw_task_id (endpoint_updated_pP->context_teid), INSTANCE_DEFAULT, message_p);
       OAILOG_FUNC_RETURN(LOG_SPGW_APP, rv);
     } else if (HASH_TABLE_OK == hash_rc) {
       message_p = itti_alloc_new_message (TASK_SPGW_APP, SGI_UPDATE_ENDPOINT_REQUEST);
@@ -571,7 +583,7 @@ sgw_handle_gtpv1uUpdateTunnelResp (
                         NULL, 0, "0 S11_MODIFY_BEARER_RESPONSE ebi %u CONTEXT_NOT_FOUND trxn %u",
                         modify_response_p->bearer_contexts_marked_for_removal.bearer_contexts[0].eps_bearer_id,
                         modify_response_p->trxn);
-    rv = itti_send_msg_to_task (TASK_S11, INSTANCE_DEFAULT, message_p);
+    rv = itti_send_msg_to_task (s11_sgw_task_id (endpoint_updated_pP->context_teid), INSTANCE_DEFAULT, message_p);
     OAILOG_FUNC_RETURN(LOG_SPGW_APP, rv);
   }
 
@@ -625,7 +637,7 @@ sgw_handle_sgi_endpoint_updated (
                           NULL, 0, "0 S11_MODIFY_BEARER_RESPONSE ebi %u CONTEXT_NOT_FOUND trxn %u",
                           modify_response_p->bearer_contexts_marked_for_removal.bearer_contexts[0].eps_bearer_id,
                           modify_response_p->trxn);
-      rv = itti_send_msg_to_task (TASK_S11, INSTANCE_DEFAULT, message_p);
+      rv = itti_send_msg_to_task (s11_sgw_task_id (resp_pP->context_teid), INSTANCE_DEFAULT, message_p);
       OAILOG_FUNC_RETURN(LOG_SPGW_APP, rv);
     } else if (HASH_TABLE_OK == hash_rc) {
       OAILOG_DEBUG (LOG_SPGW_APP, "Rx SGI_UPDATE_ENDPOINT_RESPONSE: REQUEST_ACCEPTED\n");
@@ -662,7 +674,7 @@ sgw_handle_sgi_endpoint_updated (
 
     MSC_LOG_TX_MESSAGE (MSC_SP_GWAPP_MME, MSC_S11_MME, NULL, 0, "0 S11_MODIFY_BEARER_RESPONSE ebi %u  trxn %u",
         modify_response_p->bearer_contexts_modified.bearer_contexts[0].eps_bearer_id, modify_response_p->trxn);
-    rv = itti_send_msg_to_task (TASK_S11, INSTANCE_DEFAULT, message_p);
+    rv = itti_send_msg_to_task (s11_sgw_task_id (resp_pP->context_teid), INSTANCE_DEFAULT, message_p);
     OAILOG_FUNC_RETURN(LOG_SPGW_APP, rv);
   } else {
     if (HASH_TABLE_OK != hash_rc2) {
@@ -676,7 +688,7 @@ sgw_handle_sgi_endpoint_updated (
       MSC_LOG_TX_MESSAGE (MSC_SP_GWAPP_MME,  MSC_S11_MME,
                         NULL, 0, "0 S11_MODIFY_BEARER_RESPONSE ebi %u CONTEXT_NOT_FOUND trxn %u",
                         modify_response_p->bearer_contexts_marked_for_removal.bearer_contexts[0].eps_bearer_id, modify_response_p->trxn);
-      rv = itti_send_msg_to_task (TASK_S11, INSTANCE_DEFAULT, message_p);
+      rv = itti_send_msg_to_task (s11_sgw_task_id (resp_pP->context_teid), INSTANCE_DEFAULT, message_p);
       OAILOG_FUNC_RETURN(LOG_SPGW_APP, rv);
     } else {
       OAILOG_FUNC_RETURN(LOG_SPGW_APP, RETURNerror);
@@ -740,7 +752,8 @@ sgw_handle_sgi_endpoint_deleted (
 //------------------------------------------------------------------------------
 int
 sgw_handle_modify_bearer_request (
-  const itti_s11_modify_bearer_request_t * const modify_bearer_pP)
+  const itti_s11_modify_bearer_request_t * const modify_bearer_pP,
+  const uint32_t s11_shard)
 {
   itti_s11_modify_bearer_response_t            *modify_response_p = NULL;
   s_plus_p_gw_eps_bearer_context_information_t *new_bearer_ctxt_info_p = NULL;
@@ -783,7 +796,11 @@ sgw_handle_modify_bearer_request (
       MSC_LOG_TX_MESSAGE (MSC_SP_GWAPP_MME, MSC_S11_MME,
                           NULL, 0, "0 S11_MODIFY_BEARER_RESPONSE ebi %u CONTEXT_NOT_FOUND trxn %u",
                           modify_response_p->bearer_contexts_marked_for_removal.bearer_contexts[0].eps_bearer_id, modify_response_p->trxn);
-      rv = itti_send_msg_to_task (TASK_S11, INSTANCE_DEFAULT, message_p);
+      /*
+       * An unknown TEID was steered by sequence number, the S11 task of the
+       * shard that received the request holds its transaction
+       */
+      rv = itti_send_msg_to_task (TASK_S11 + s11_shard, INSTANCE_DEFAULT, message_p);
       OAILOG_FUNC_RETURN(LOG_SPGW_APP, rv);
     } else if (HASH_TABLE_OK == hash_rc) {
       // TO DO
@@ -817,7 +834,7 @@ sgw_handle_modify_bearer_request (
     modify_response_p->cause = CONTEXT_NOT_FOUND;
     modify_response_p->trxn = modify_bearer_pP->trxn;
     OAILOG_DEBUG (LOG_SPGW_APP, "Rx MODIFY_BEARER_REQUEST, teid %u CONTEXT_NOT_FOUND\n", modify_bearer_pP->teid);
-    rv = itti_send_msg_to_task (TASK_S11, INSTANCE_DEFAULT, message_p);
+    rv = itti_send_msg_to_task (TASK_S11 + s11_shard, INSTANCE_DEFAULT, message_p);
     OAILOG_FUNC_RETURN(LOG_SPGW_APP, rv);
   }
 
@@ -829,7 +846,8 @@ sgw_handle_modify_bearer_request (
 //------------------------------------------------------------------------------
 int
 sgw_handle_delete_session_request (
-  const itti_s11_delete_session_request_t * const delete_session_req_pP)
+  const itti_s11_delete_session_request_t * const delete_session_req_pP,
+  const uint32_t s11_shard)
 {
   hashtable_rc_t                          hash_rc = HASH_TABLE_OK;
   itti_s11_delete_session_response_t      *delete_session_resp_p = NULL;
@@ -881,6 +899,21 @@ sgw_handle_delete_session_request (
 
       sgw_handle_sgi_endpoint_deleted (&sgi_delete_end_point_request);
 
+      teid_pool_release (&sgw_app.s1u_teid_pool, eps_bearer_entry_p->s_gw_teid_S1u_S12_S4_up);
+
+      /*
+       * Give back the IPv4 address of the UE to its pool
+       */
+      if ((sgi_delete_end_point_request.paa.pdn_type == IPv4) || (sgi_delete_end_point_request.paa.pdn_type == IPv4_AND_v6)) {
+        struct in_addr                            inaddr = {.s_addr = INADDR_ANY};
+
+        BUFFER_TO_INT32 (sgi_delete_end_point_request.paa.ipv4_address, inaddr.s_addr);
+        if (pgw_release_free_ipv4_paa_address (&inaddr) != RETURNok) {
+          OAILOG_WARNING (LOG_SPGW_APP, "Failed to release IPv4 PAA %u.%u.%u.%u\n", sgi_delete_end_point_request.paa.ipv4_address[0],
+              sgi_delete_end_point_request.paa.ipv4_address[1], sgi_delete_end_point_request.paa.ipv4_address[2], sgi_delete_end_point_request.paa.ipv4_address[3]);
+        }
+      }
+
       /*
        * Delete S11 bearer context and remove s11 tunnel
        */
@@ -892,7 +925,7 @@ sgw_handle_delete_session_request (
     delete_session_resp_p->trxn = delete_session_req_pP->trxn;
     delete_session_resp_p->peer_ip = delete_session_req_pP->peer_ip;
     MSC_LOG_TX_MESSAGE (MSC_SP_GWAPP_MME, MSC_S11_MME, NULL, 0, "0 S11_DELETE_SESSION_RESPONSE teid %u cause %u trxn %u", delete_session_resp_p->teid, delete_session_resp_p->cause, delete_session_resp_p->trxn);
-    rv = itti_send_msg_to_task (TASK_S11, INSTANCE_DEFAULT, message_p);
+    rv = itti_send_msg_to_task (TASK_S11 + s11_shard, INSTANCE_DEFAULT, message_p);
     OAILOG_FUNC_RETURN(LOG_SPGW_APP, rv);
 
   } else {
@@ -911,7 +944,7 @@ sgw_handle_delete_session_request (
     delete_session_resp_p->trxn = delete_session_req_pP->trxn;
     delete_session_resp_p->peer_ip = delete_session_req_pP->peer_ip;
     MSC_LOG_TX_MESSAGE (MSC_SP_GWAPP_MME, MSC_S11_MME, NULL, 0, "0 S11_DELETE_SESSION_RESPONSE CONTEXT_NOT_FOUND trxn %u", delete_session_resp_p->trxn);
-    rv = itti_send_msg_to_task (TASK_S11, INSTANCE_DEFAULT, message_p);
+    rv = itti_send_msg_to_task (TASK_S11 + s11_shard, INSTANCE_DEFAULT, message_p);
     OAILOG_FUNC_RETURN(LOG_SPGW_APP, rv);
   }
 
@@ -950,7 +983,8 @@ sgw_release_all_enb_related_information (
 //------------------------------------------------------------------------------
 int
 sgw_handle_release_access_bearers_request (
-  const itti_s11_release_access_bearers_request_t * const release_access_bearers_req_pP)
+  const itti_s11_release_access_bearers_request_t * const release_access_bearers_req_pP,
+  const uint32_t s11_shard)
 {
   hashtable_rc_t                          hash_rc = HASH_TABLE_OK;
   itti_s11_release_access_bearers_response_t        *release_access_bearers_resp_p = NULL;
@@ -981,7 +1015,7 @@ sgw_handle_release_access_bearers_request (
     // TODO The S-GW starts buffering downlink packets received for the UE
     // (set target on GTPUSP to order the buffering)
     MSC_LOG_TX_MESSAGE (MSC_SP_GWAPP_MME, MSC_S11_MME, NULL, 0, "0 S11_RELEASE_ACCESS_BEARERS_RESPONSE S11 MME teid %u cause REQUEST_ACCEPTED", release_access_bearers_resp_p->teid);
-    rv = itti_send_msg_to_task (TASK_S11, INSTANCE_DEFAULT, message_p);
+    rv = itti_send_msg_to_task (TASK_S11 + s11_shard, INSTANCE_DEFAULT, message_p);
 
     OAILOG_DEBUG (LOG_SPGW_APP, "Release Access Bearer Respone sent to SGW\n");
     OAILOG_FUNC_RETURN(LOG_SPGW_APP, rv);
@@ -989,7 +1023,7 @@ sgw_handle_release_access_bearers_request (
     release_access_bearers_resp_p->cause = CONTEXT_NOT_FOUND;
     release_access_bearers_resp_p->teid = 0;
     MSC_LOG_TX_MESSAGE (MSC_SP_GWAPP_MME, MSC_S11_MME, NULL, 0, "0 S11_RELEASE_ACCESS_BEARERS_RESPONSE cause CONTEXT_NOT_FOUND");
-    rv = itti_send_msg_to_task (TASK_S11, INSTANCE_DEFAULT, message_p);
+    rv = itti_send_msg_to_task (TASK_S11 + s11_shard, INSTANCE_DEFAULT, message_p);
     OAILOG_FUNC_RETURN(LOG_SPGW_APP, rv);
   }
 }
@@ -29,13 +29,13 @@
 #ifndef FILE_SGW_HANDLERS_SEEN
 #define FILE_SGW_HANDLERS_SEEN
 
-int sgw_handle_create_session_request(const itti_s11_create_session_request_t * const session_req_p);
+int sgw_handle_create_session_request(const itti_s11_create_session_request_t * const session_req_p, const uint32_t s11_shard);
 int sgw_handle_sgi_endpoint_created  (itti_sgi_create_end_point_response_t   * const resp_p);
 int sgw_handle_sgi_endpoint_updated  (const itti_sgi_update_end_point_response_t   * const resp_p);
 int sgw_handle_gtpv1uCreateTunnelResp(const Gtpv1uCreateTunnelResp  * const endpoint_created_p);
 int sgw_handle_gtpv1uUpdateTunnelResp(const Gtpv1uUpdateTunnelResp  * const endpoint_updated_p);
 int sgw_handle_gtpv1uDeleteTunnelResp(const Gtpv1uDeleteTunnelResp  * const endpoint_deleted_p);
-int sgw_handle_modify_bearer_request (const itti_s11_modify_bearer_request_t  * const modify_bearer_p);
-int sgw_handle_delete_session_request(const itti_s11_delete_session_request_t * const delete_session_p);
-int sgw_handle_release_access_bearers_request(const itti_s11_release_access_bearers_request_t * const release_access_bearers_req_pP);
+int sgw_handle_modify_bearer_request (const itti_s11_modify_bearer_request_t  * const modify_bearer_p, const uint32_t s11_shard);
+int sgw_handle_delete_session_request(const itti_s11_delete_session_request_t * const delete_session_p, const uint32_t s11_shard);
+int sgw_handle_release_access_bearers_request(const itti_s11_release_access_bearers_request_t * const release_access_bearers_req_pP, const uint32_t s11_shard);
 #endif /* FILE_SGW_HANDLERS_SEEN */
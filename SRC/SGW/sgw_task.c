@@ -79,22 +79,22 @@ static void *sgw_intertask_interface (void *args_p)
          * * * *      E-UTRAN Initial Attach
          * * * *      UE requests PDN connectivity
          */
-        sgw_handle_create_session_request (&received_message_p->ittiMsg.s11_create_session_request);
+        sgw_handle_create_session_request (&received_message_p->ittiMsg.s11_create_session_request, ITTI_MSG_ORIGIN_ID (received_message_p) - TASK_S11);
       }
       break;
 
     case S11_MODIFY_BEARER_REQUEST:{
-        sgw_handle_modify_bearer_request (&received_message_p->ittiMsg.s11_modify_bearer_request);
+        sgw_handle_modify_bearer_request (&received_message_p->ittiMsg.s11_modify_bearer_request, ITTI_MSG_ORIGIN_ID (received_message_p) - TASK_S11);
       }
       break;
 
     case S11_RELEASE_ACCESS_BEARERS_REQUEST:{
-        sgw_handle_release_access_bearers_request (&received_message_p->ittiMsg.s11_release_access_bearers_request);
+        sgw_handle_release_access_bearers_request (&received_message_p->ittiMsg.s11_release_access_bearers_request, ITTI_MSG_ORIGIN_ID (received_message_p) - TASK_S11);
       }
       break;
 
     case S11_DELETE_SESSION_REQUEST:{
-        sgw_handle_delete_session_request (&received_message_p->ittiMsg.s11_delete_session_request);
+        sgw_handle_delete_session_request (&received_message_p->ittiMsg.s11_delete_session_request, ITTI_MSG_ORIGIN_ID (received_message_p) - TASK_S11);
       }
       break;
 
@@ -153,6 +153,8 @@ int sgw_init (spgw_config_t *spgw_config_pP)
   }
 
   pgw_load_pool_ip_addresses ();
+  teid_shards_init (&sgw_app.s11_teid_shards, spgw_config_pP->sgw_config.ipv4.nb_s11_shards);
+  teid_pool_init (&sgw_app.s1u_teid_pool, 0, 0);
 
   bstring b = bfromcstr("sgw_s11teid2mme_hashtable");
   sgw_app.s11teid2mme_hashtable = hashtable_ts_create (512, NULL, NULL, b);
@@ -226,8 +228,11 @@ static void sgw_exit(void)
   //P-GW code
   struct conf_ipv4_list_elm_s   *conf_ipv4_p = NULL;
 
-  while ((conf_ipv4_p = STAILQ_FIRST (&spgw_config.pgw_config.ipv4_pool_list))) {
-    STAILQ_REMOVE_HEAD (&spgw_config.pgw_config.ipv4_pool_list, ipv4_entries);
+  teid_shards_free (&sgw_app.s11_teid_shards);
+  teid_pool_free (&sgw_app.s1u_teid_pool);
+  pgw_free_pool_ip_addresses ();
+  while ((conf_ipv4_p = STAILQ_FIRST (&spgw_config.pgw_config.ipv4_reserved_list))) {
+    STAILQ_REMOVE_HEAD (&spgw_config.pgw_config.ipv4_reserved_list, ipv4_entries);
     free_wrapper ((void**) &conf_ipv4_p);
   }
 }
@@ -898,11 +898,11 @@ generate_authentication_info_req (
     CHECK_FCT (fd_msg_avp_add (avp, MSG_BRW_LAST_CHILD, child_avp));
 
     /*
-     * Re-synchronization information containing the AUTS computed at USIM
+     * Re-synchronization information containing the RAND sent to the USIM and the AUTS computed at USIM
      */
     if (air_p->re_synchronization) {
       CHECK_FCT (fd_msg_avp_new (s6a_fd_cnf.dataobj_s6a_re_synchronization_info, 0, &child_avp));
-      value.os.len = AUTS_LENGTH;
+      value.os.len = RESYNC_PARAM_LENGTH;
       value.os.data = air_p->resync_param;
       CHECK_FCT (fd_msg_avp_setvalue (child_avp, &value));
       CHECK_FCT (fd_msg_avp_add (avp, MSG_BRW_LAST_CHILD, child_avp));
@@ -0,0 +1,226 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "bstrlib.h"
+#include "hashtable.h"
+
+/* Compares the chained hash table (hash_table_t) with the open addressing
+ * thread safe hash table (hash_table_ts_t) on IMSI-like keys with several
+ * hit ratios, then runs concurrent readers against a writer on hash_table_ts_t.
+ * usage: hashtable_benchmark [nb_keys] [nb_reader_threads]
+ */
+
+#define DEFAULT_NB_KEYS     (1000 * 1000)
+#define DEFAULT_NB_THREADS  4
+#define LOOKUPS_PER_KEY     4
+#define IMSI_BASE           UINT64_C(208930000000000)
+
+static uint32_t                         nb_keys = DEFAULT_NB_KEYS;
+static hash_table_ts_t                 *shared_htbl;
+static volatile int                     stop_readers;
+
+static double
+elapsed_ns (
+  struct timespec *start)
+{
+  struct timespec                         end;
+
+  clock_gettime (CLOCK_MONOTONIC, &end);
+  return (double)(end.tv_sec - start->tv_sec) * 1e9 + (double)(end.tv_nsec - start->tv_nsec);
+}
+
+/* IMSIs of a single PLMN allocated with holes: key(i, 0) are inserted, key(i, 1) never are */
+static inline uint64_t
+key (
+  uint32_t i,
+  int missing)
+{
+  return IMSI_BASE + 3 * (uint64_t)i + missing;
+}
+
+/* Random walk over the keys, hit_percent of the lookups target inserted keys */
+static inline uint64_t
+lookup_key (
+  uint32_t i,
+  uint32_t hit_percent)
+{
+  uint32_t                                r = (uint32_t)(((uint64_t)i * 2654435761u) % nb_keys);
+
+  return key (r, (i % 100) >= hit_percent);
+}
+
+static void
+bench_chained (
+  void)
+{
+  static const uint32_t                   hit_percents[] = {100, 90, 50, 0};
+  hash_table_t                           *htbl = hashtable_create (nb_keys, NULL, hash_free_int_func, NULL);
+  struct timespec                         start;
+  void                                   *data = NULL;
+  uint32_t                                found = 0;
+
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  for (uint32_t i = 0; i < nb_keys; i++) {
+    hashtable_insert (htbl, key (i, 0), (void *)(uintptr_t)(i + 1));
+  }
+  printf ("chained    insert %8u keys:          %6.1f ns/op\n", nb_keys, elapsed_ns (&start) / nb_keys);
+
+  for (int h = 0; h < sizeof (hit_percents) / sizeof (hit_percents[0]); h++) {
+    found = 0;
+    clock_gettime (CLOCK_MONOTONIC, &start);
+    for (uint32_t i = 0; i < LOOKUPS_PER_KEY * nb_keys; i++) {
+      found += (hashtable_get (htbl, lookup_key (i, hit_percents[h]), &data) == HASH_TABLE_OK);
+    }
+    printf ("chained    get    %3u%% hits (%8u): %6.1f ns/op\n", hit_percents[h], found, elapsed_ns (&start) / (LOOKUPS_PER_KEY * nb_keys));
+  }
+
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  for (uint32_t i = 0; i < nb_keys; i++) {
+    hashtable_remove (htbl, key (i, 0), &data);
+  }
+  printf ("chained    remove %8u keys:          %6.1f ns/op\n", nb_keys, elapsed_ns (&start) / nb_keys);
+  hashtable_destroy (htbl);
+}
+
+static int
+bench_ts (
+  hash_size_t initial_size,
+  const char *label)
+{
+  static const uint32_t                   hit_percents[] = {100, 90, 50, 0};
+  hash_table_ts_t                        *htbl = hashtable_ts_create (initial_size, NULL, hash_free_int_func, NULL);
+  struct timespec                         start;
+  void                                   *data = NULL;
+  uint32_t                                found = 0;
+
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  for (uint32_t i = 0; i < nb_keys; i++) {
+    hashtable_ts_insert (htbl, key (i, 0), (void *)(uintptr_t)(i + 1));
+  }
+  printf ("%-10s insert %8u keys:          %6.1f ns/op\n", label, nb_keys, elapsed_ns (&start) / nb_keys);
+
+  for (uint32_t i = 0; i < nb_keys; i++) {
+    if ((hashtable_ts_get (htbl, key (i, 0), &data) != HASH_TABLE_OK) || (data != (void *)(uintptr_t)(i + 1)) ||
+        (hashtable_ts_get (htbl, key (i, 1), &data) == HASH_TABLE_OK)) {
+      fprintf (stderr, "%s: lookup of key %u failed\n", label, i);
+      return -1;
+    }
+  }
+
+  for (int h = 0; h < sizeof (hit_percents) / sizeof (hit_percents[0]); h++) {
+    found = 0;
+    clock_gettime (CLOCK_MONOTONIC, &start);
+    for (uint32_t i = 0; i < LOOKUPS_PER_KEY * nb_keys; i++) {
+      found += (hashtable_ts_get (htbl, lookup_key (i, hit_percents[h]), &data) == HASH_TABLE_OK);
+    }
+    printf ("%-10s get    %3u%% hits (%8u): %6.1f ns/op\n", label, hit_percents[h], found, elapsed_ns (&start) / (LOOKUPS_PER_KEY * nb_keys));
+  }
+
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  for (uint32_t i = 0; i < nb_keys; i++) {
+    if (hashtable_ts_remove (htbl, key (i, 0), &data) != HASH_TABLE_OK) {
+      fprintf (stderr, "%s: remove of key %u failed\n", label, i);
+      return -1;
+    }
+  }
+  printf ("%-10s remove %8u keys:          %6.1f ns/op\n", label, nb_keys, elapsed_ns (&start) / nb_keys);
+
+  if (htbl->num_elements != 0) {
+    fprintf (stderr, "%s: %zu elements left\n", label, htbl->num_elements);
+    return -1;
+  }
+  hashtable_ts_destroy (htbl);
+  return 0;
+}
+
+/* Readers look up the first half of the keys, which stay in the table,
+ * while the writer inserts and removes the second half.
+ */
+static void *
+reader_thread (
+  void *arg)
+{
+  uint64_t                               *nb_lookups = (uint64_t *) arg;
+  void                                   *data = NULL;
+  uint32_t                                i = 0;
+
+  while (!stop_readers) {
+    uint32_t                                r = (uint32_t)(((uint64_t)i++ * 2654435761u) % (nb_keys / 2));
+
+    if ((hashtable_ts_get (shared_htbl, key (r, 0), &data) != HASH_TABLE_OK) || (data != (void *)(uintptr_t)(r + 1))) {
+      fprintf (stderr, "reader: lookup of key %u failed\n", r);
+      exit (EXIT_FAILURE);
+    }
+    (*nb_lookups)++;
+  }
+  return NULL;
+}
+
+static void
+bench_ts_concurrent (
+  uint32_t nb_threads)
+{
+  pthread_t                              *threads = calloc (nb_threads, sizeof (pthread_t));
+  uint64_t                               *nb_lookups = calloc (nb_threads, sizeof (uint64_t));
+  struct timespec                         start;
+  uint64_t                                total = 0;
+  uint32_t                                nb_writes = 0;
+  void                                   *data = NULL;
+  double                                  ns;
+
+  // start small so that the writer triggers incremental resizes
+  shared_htbl = hashtable_ts_create (1024, NULL, hash_free_int_func, NULL);
+  for (uint32_t i = 0; i < nb_keys / 2; i++) {
+    hashtable_ts_insert (shared_htbl, key (i, 0), (void *)(uintptr_t)(i + 1));
+  }
+
+  stop_readers = 0;
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  for (uint32_t t = 0; t < nb_threads; t++) {
+    pthread_create (&threads[t], NULL, reader_thread, &nb_lookups[t]);
+  }
+  for (int round = 0; round < 2; round++) {
+    for (uint32_t i = nb_keys / 2; i < nb_keys; i++, nb_writes++) {
+      hashtable_ts_insert (shared_htbl, key (i, 0), (void *)(uintptr_t)(i + 1));
+    }
+    for (uint32_t i = nb_keys / 2; i < nb_keys; i++, nb_writes++) {
+      hashtable_ts_remove (shared_htbl, key (i, 0), &data);
+    }
+  }
+  stop_readers = 1;
+  for (uint32_t t = 0; t < nb_threads; t++) {
+    pthread_join (threads[t], NULL);
+    total += nb_lookups[t];
+  }
+  ns = elapsed_ns (&start);
+  printf ("concurrent %u readers: %6.1f Mget/s, 1 writer: %6.1f ns/op\n", nb_threads, total * 1e3 / ns, ns / nb_writes);
+  hashtable_ts_destroy (shared_htbl);
+  free (threads);
+  free (nb_lookups);
+}
+
+int
+main (
+  int argc,
+  char *argv[])
+{
+  uint32_t                                nb_threads = DEFAULT_NB_THREADS;
+
+  if (argc > 1) {
+    nb_keys = strtoul (argv[1], NULL, 0);
+  }
+  if (argc > 2) {
+    nb_threads = strtoul (argv[2], NULL, 0);
+  }
+
+  bench_chained ();
+  if ((bench_ts (nb_keys, "ts") != 0) || (bench_ts (16, "ts grow") != 0)) {
+    return EXIT_FAILURE;
+  }
+  bench_ts_concurrent (nb_threads);
+  return EXIT_SUCCESS;
+}
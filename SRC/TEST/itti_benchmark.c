@@ -0,0 +1,101 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sched.h>
+#include <time.h>
+
+#include "intertask_interface.h"
+#include "intertask_interface_init.h"
+
+/* Sends messages from the main thread (as TASK_MME_APP) to TASK_S1AP, with
+ * at most window messages in flight, the consumer task receives them one
+ * at a time with itti_receive_msg() or by batches with itti_receive_msgs().
+ * A window of 1 measures the latency of a hop (consumer sleeping on each
+ * message), a large window the throughput.
+ * usage: itti_benchmark [nb_messages]
+ */
+
+#define DEFAULT_NB_MESSAGES (1000 * 1000)
+#define RECEIVE_BATCH_SIZE  64
+
+static volatile uint64_t                nb_received;
+static volatile int                     receive_batched;
+
+static void                            *
+consumer_task (
+  void *args_p)
+{
+  MessageDef                             *messages[RECEIVE_BATCH_SIZE];
+  int                                     nb_messages;
+
+  itti_mark_task_ready (TASK_S1AP);
+
+  while (1) {
+    if (receive_batched) {
+      nb_messages = itti_receive_msgs (TASK_S1AP, messages, RECEIVE_BATCH_SIZE);
+    } else {
+      itti_receive_msg (TASK_S1AP, &messages[0]);
+      nb_messages = (messages[0] != NULL);
+    }
+
+    for (int i = 0; i < nb_messages; i++) {
+      itti_free (ITTI_MSG_ORIGIN_ID (messages[i]), messages[i]);
+    }
+    __sync_fetch_and_add (&nb_received, nb_messages);
+  }
+  return NULL;
+}
+
+static double
+bench_send (
+  uint64_t nb_messages,
+  uint64_t window,
+  int batched)
+{
+  struct timespec                         start, end;
+  uint64_t                                first = nb_received;
+  double                                  ns;
+
+  receive_batched = batched;
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  for (uint64_t i = 0; i < nb_messages; i++) {
+    while ((i - (nb_received - first)) >= window) {
+      // spin, the consumer may be on the same core
+      sched_yield ();
+    }
+    itti_send_msg_to_task (TASK_S1AP, INSTANCE_DEFAULT, itti_alloc_new_message (TASK_MME_APP, MESSAGE_TEST));
+  }
+  while ((nb_received - first) < nb_messages) {
+    sched_yield ();
+  }
+  clock_gettime (CLOCK_MONOTONIC, &end);
+  ns = (double)(end.tv_sec - start.tv_sec) * 1e9 + (double)(end.tv_nsec - start.tv_nsec);
+  printf ("%-8s window %4lu: %10.0f msg/s, %8.1f ns/msg\n", batched ? "batched" : "single", window, nb_messages * 1e9 / ns, ns / nb_messages);
+  return ns;
+}
+
+int
+main (
+  int argc,
+  char *argv[])
+{
+  uint64_t                                nb_messages = DEFAULT_NB_MESSAGES;
+
+  if (argc > 1) {
+    nb_messages = strtoul (argv[1], NULL, 0);
+  }
+
+  if (itti_init (TASK_MAX, THREAD_MAX, MESSAGES_ID_MAX, tasks_info, messages_info, NULL, NULL) < 0) {
+    fprintf (stderr, "itti_init failed\n");
+    return EXIT_FAILURE;
+  }
+  itti_create_task (TASK_S1AP, consumer_task, NULL);
+
+  for (int batched = 0; batched < 2; batched++) {
+    bench_send (nb_messages / 10, 1, batched);
+    bench_send (nb_messages, 16, batched);
+    bench_send (nb_messages, 128, batched);
+  }
+  return EXIT_SUCCESS;
+}
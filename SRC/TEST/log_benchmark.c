@@ -0,0 +1,98 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <time.h>
+
+#include "bstrlib.h"
+#include "log.h"
+
+/* Cost of an OAILOG_DEBUG() call in the logging thread (formatting or, with
+ * BINARY = "yes", recording the raw arguments in the thread ring) and of
+ * log_flush_messages() in TASK_LOG, for messages of the kind NAS and MME_APP
+ * emit. Messages are flushed by bursts smaller than a thread ring so that
+ * none is dropped.
+ * usage: log_benchmark [nb_messages] [log file]
+ */
+
+#define DEFAULT_NB_MESSAGES (1000 * 1000)
+#define DEFAULT_LOG_FILE    "/tmp/log_benchmark.log"
+#define BURST_SIZE          1024
+
+static double
+elapsed_ns (
+  struct timespec *start)
+{
+  struct timespec                         end;
+
+  clock_gettime (CLOCK_MONOTONIC, &end);
+  return (double)(end.tv_sec - start->tv_sec) * 1e9 + (double)(end.tv_nsec - start->tv_nsec);
+}
+
+static void
+bench (
+  const char *label,
+  const char *log_file,
+  uint32_t nb_messages,
+  log_level_t nas_log_level,
+  bool binary)
+{
+  log_config_t                            config = {0};
+  struct timespec                         start;
+  double                                  log_ns = 0;
+  double                                  flush_ns = 0;
+  FILE                                   *file = NULL;
+
+  config.output = bfromcstr (log_file);
+  config.is_output_thread_safe = true;
+  config.is_output_binary = binary;
+  config.nas_log_level = nas_log_level;
+  log_set_config (&config);
+
+  for (uint32_t i = 0; i < nb_messages; i += BURST_SIZE) {
+    clock_gettime (CLOCK_MONOTONIC, &start);
+    for (uint32_t j = 0; j < BURST_SIZE; j++) {
+      OAILOG_DEBUG (LOG_NAS, "UE " "%06" PRIX32 " EMM-PROC  - Attach request, IMSI %s, procedure %d, %s\n",
+          i + j, "208930000000001", (int) j, (j & 1) ? "accepted" : "pending");
+    }
+    log_ns += elapsed_ns (&start);
+    clock_gettime (CLOCK_MONOTONIC, &start);
+    log_flush_messages ();
+    flush_ns += elapsed_ns (&start);
+  }
+  log_exit ();
+  bdestroy (config.output);
+
+  file = fopen (log_file, "r");
+  if (file) {
+    fseek (file, 0, SEEK_END);
+  }
+  printf ("%-8s: %7.1f ns/message logged, %7.1f ns/message flushed, %6.1f bytes/message\n", label,
+          log_ns / nb_messages, flush_ns / nb_messages, file ? (double)ftell (file) / nb_messages : 0.0);
+  if (file) {
+    fclose (file);
+  }
+}
+
+int
+main (
+  int argc,
+  char *argv[])
+{
+  uint32_t                                nb_messages = DEFAULT_NB_MESSAGES;
+  const char                             *log_file = DEFAULT_LOG_FILE;
+
+  if (argc > 1) {
+    nb_messages = strtoul (argv[1], NULL, 0);
+  }
+  if (argc > 2) {
+    log_file = argv[2];
+  }
+
+  log_init (LOG_MME_ENV, OAILOG_LEVEL_ERROR, 1);
+  bench ("disabled", log_file, nb_messages, OAILOG_LEVEL_INFO, false);
+  bench ("text", log_file, nb_messages, OAILOG_LEVEL_DEBUG, false);
+  bench ("binary", log_file, nb_messages, OAILOG_LEVEL_DEBUG, true);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,183 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+
+#include "memory_pools.h"
+
+/* Allocates and frees items of the ITTI memory pools from several threads:
+ * "local" threads free what they allocate (bursts of BURST_SIZE items), then
+ * "pipe" thread pairs allocate on one side and free on the other, the way
+ * ITTI messages go from a sender task to a receiver task.
+ * usage: memory_pools_benchmark [nb_operations_per_thread] [nb_threads]
+ */
+
+#define DEFAULT_NB_OPERATIONS (2 * 1000 * 1000)
+#define DEFAULT_NB_THREADS    4
+#define BURST_SIZE            16
+#define PIPE_SIZE             256
+
+typedef struct {
+  uint32_t                                nb_operations;
+  uint32_t                                seed;
+  volatile uint32_t                       head;
+  volatile uint32_t                       tail;
+  void                                   *items[PIPE_SIZE];
+} bench_thread_t;
+
+static memory_pools_handle_t            memory_pools;
+
+static double
+elapsed_ns (
+  struct timespec *start)
+{
+  struct timespec                         end;
+
+  clock_gettime (CLOCK_MONOTONIC, &end);
+  return (double)(end.tv_sec - start->tv_sec) * 1e9 + (double)(end.tv_nsec - start->tv_nsec);
+}
+
+/* Mostly small messages, as for ITTI */
+static inline uint32_t
+item_size (
+  uint32_t *seed)
+{
+  uint32_t                                r = rand_r (seed) % 100;
+
+  return (r < 60) ? 40 : (r < 90) ? 90 : (r < 99) ? 600 : 20000;
+}
+
+static void                            *
+local_thread (
+  void *args)
+{
+  bench_thread_t                         *bench_thread = (bench_thread_t *) args;
+  void                                   *items[BURST_SIZE];
+
+  for (uint32_t i = 0; i < bench_thread->nb_operations; i += BURST_SIZE) {
+    for (int j = 0; j < BURST_SIZE; j++) {
+      items[j] = memory_pools_allocate (memory_pools, item_size (&bench_thread->seed), 0, 0);
+      if (items[j] == NULL) {
+        fprintf (stderr, "Allocation failed\n");
+        exit (EXIT_FAILURE);
+      }
+    }
+    for (int j = 0; j < BURST_SIZE; j++) {
+      memory_pools_free (memory_pools, items[j], 0);
+    }
+  }
+  return NULL;
+}
+
+static void                            *
+pipe_producer_thread (
+  void *args)
+{
+  bench_thread_t                         *bench_thread = (bench_thread_t *) args;
+
+  for (uint32_t i = 0; i < bench_thread->nb_operations; i++) {
+    while ((bench_thread->head - bench_thread->tail) == PIPE_SIZE) {
+      sched_yield ();
+    }
+    bench_thread->items[bench_thread->head % PIPE_SIZE] = memory_pools_allocate (memory_pools, item_size (&bench_thread->seed), 0, 0);
+    if (bench_thread->items[bench_thread->head % PIPE_SIZE] == NULL) {
+      fprintf (stderr, "Allocation failed\n");
+      exit (EXIT_FAILURE);
+    }
+    __sync_synchronize ();
+    bench_thread->head++;
+  }
+  return NULL;
+}
+
+static void                            *
+pipe_consumer_thread (
+  void *args)
+{
+  bench_thread_t                         *bench_thread = (bench_thread_t *) args;
+
+  for (uint32_t i = 0; i < bench_thread->nb_operations; i++) {
+    while (bench_thread->head == bench_thread->tail) {
+      sched_yield ();
+    }
+    memory_pools_free (memory_pools, bench_thread->items[bench_thread->tail % PIPE_SIZE], 0);
+    __sync_synchronize ();
+    bench_thread->tail++;
+  }
+  return NULL;
+}
+
+static void
+bench (
+  const char *label,
+  uint32_t nb_threads,
+  uint32_t nb_operations,
+  int pipe)
+{
+  pthread_t                              *threads = calloc (2 * nb_threads, sizeof (pthread_t));
+  bench_thread_t                         *bench_threads = calloc (nb_threads, sizeof (bench_thread_t));
+  struct timespec                         start;
+  double                                  ns;
+
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  for (uint32_t t = 0; t < nb_threads; t++) {
+    bench_threads[t].nb_operations = nb_operations;
+    bench_threads[t].seed = t + 1;
+    if (pipe) {
+      pthread_create (&threads[2 * t], NULL, pipe_producer_thread, &bench_threads[t]);
+      pthread_create (&threads[2 * t + 1], NULL, pipe_consumer_thread, &bench_threads[t]);
+    } else {
+      pthread_create (&threads[2 * t], NULL, local_thread, &bench_threads[t]);
+    }
+  }
+  for (uint32_t t = 0; t < nb_threads; t++) {
+    pthread_join (threads[2 * t], NULL);
+    if (pipe) {
+      pthread_join (threads[2 * t + 1], NULL);
+    }
+  }
+  ns = elapsed_ns (&start);
+  printf ("%-6s %2u threads: %8.2f Malloc+free/s, %6.1f ns/alloc+free\n", label, pipe ? 2 * nb_threads : nb_threads,
+          (double)nb_threads * nb_operations * 1e3 / ns, ns / ((double)nb_threads * nb_operations));
+  free (threads);
+  free (bench_threads);
+}
+
+int
+main (
+  int argc,
+  char *argv[])
+{
+  uint32_t                                nb_operations = DEFAULT_NB_OPERATIONS;
+  uint32_t                                nb_threads = DEFAULT_NB_THREADS;
+  char                                   *statistics;
+
+  if (argc > 1) {
+    nb_operations = strtoul (argv[1], NULL, 0);
+  }
+  if (argc > 2) {
+    nb_threads = strtoul (argv[2], NULL, 0);
+  }
+
+  /*
+   * Same pools as ITTI
+   */
+  memory_pools = memory_pools_create (5);
+  memory_pools_add_pool (memory_pools, 1000 + 64 * 1024, 50);
+  memory_pools_add_pool (memory_pools, 1000 + 2 * 64 * 1024, 100);
+  memory_pools_add_pool (memory_pools, 10000, 1000);
+  memory_pools_add_pool (memory_pools, 400, 20050);
+  memory_pools_add_pool (memory_pools, 100, 30050);
+
+  bench ("local", 1, nb_operations, 0);
+  bench ("local", nb_threads, nb_operations, 0);
+  bench ("pipe", 1, nb_operations, 1);
+  bench ("pipe", nb_threads / 2 ? nb_threads / 2 : 1, nb_operations, 1);
+
+  statistics = memory_pools_statistics (memory_pools);
+  printf ("%s", statistics);
+  free (statistics);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,385 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#include "bstrlib.h"
+#include "log.h"
+#include "intertask_interface.h"
+#include "intertask_interface_init.h"
+#include "secu_defs.h"
+#include "emmData.h"
+#include "TLVDecoder.h"
+#include "nas_message.h"
+#include "emm_msg.h"
+#include "esm_msg.h"
+#include "nas_test_util.h"
+
+/* NAS codecs: each plain NAS message of a corpus is decoded and encoded by
+ * the EMM or ESM message codec alone, then by nas_message_decode() and
+ * nas_message_encode() as a plain message, an integrity protected message
+ * (128-EIA2) and an integrity protected and ciphered message (128-EEA2).
+ * The decoding is done into a per-message arena, as EMM-AS and ESM-SAP do.
+ * Reports the ns/msg and heap allocations/msg of the decoding and the
+ * encoding of every message type, the allocations are counted by
+ * nas_test_util.
+ * Every message is also checked: the encoding of a decoded plain message
+ * gives back the original bytes, the MAC of a protected message matches and
+ * its deciphered content decodes to the plain message. The exit status is
+ * non-zero if a check fails, so that the benchmark run with a small number of
+ * messages is a regression test of the codecs.
+ * The corpus is built-in or made of files, each one holding a single plain
+ * NAS message (ex: exported from wireshark with "Export Packet Bytes").
+ * usage: nas_codec_benchmark [nb_messages [pdu_file...]]
+ */
+
+#define DEFAULT_NB_MESSAGES (100 * 1000)
+
+typedef enum {
+  NAS_CODEC_MSG,               /* emm_msg_decode()/esm_msg_decode() of the plain message          */
+  NAS_CODEC_PLAIN,             /* nas_message_decode() of the plain message, no security context */
+  NAS_CODEC_INTEGRITY,         /* security header type 1                                          */
+  NAS_CODEC_CIPHERED,          /* security header type 2                                          */
+  NAS_CODEC_MAX
+} nas_codec_t;
+
+static const char                      *nas_codec_names[NAS_CODEC_MAX] = {"emm/esm", "plain", "integrity", "ciphered"};
+
+static double
+elapsed_ns (
+  struct timespec *start)
+{
+  struct timespec                         end;
+
+  clock_gettime (CLOCK_MONOTONIC, &end);
+  return (double)(end.tv_sec - start->tv_sec) * 1e9 + (double)(end.tv_nsec - start->tv_nsec);
+}
+
+static bool
+load_pdu_file (
+  const char *file_name,
+  nas_pdu_t * pdu)
+{
+  FILE                                   *fp = fopen (file_name, "rb");
+
+  if (fp == NULL) {
+    fprintf (stderr, "Cannot open %s\n", file_name);
+    return false;
+  }
+  pdu->message_name = (char *)file_name;
+  pdu->buf_len = fread (pdu->buffer, 1, NAS_TEST_MAX_PDU_LENGTH, fp);
+  fclose (fp);
+  return (pdu->buf_len > 0);
+}
+
+/* Security context of the UE, NAS COUNT 0 in both directions */
+static void
+init_security_context (
+  emm_security_context_t * emm_security_context)
+{
+  static const uint8_t                    knas_enc[AUTH_KNAS_ENC_SIZE] = {0xd3, 0xc5, 0xd5, 0x92, 0x32, 0x7f, 0xb1, 0x1c, 0x40, 0x35, 0xc6, 0x68, 0x0a, 0xf8, 0xc6, 0xd1};
+  static const uint8_t                    knas_int[AUTH_KNAS_INT_SIZE] = {0x2b, 0xd6, 0x45, 0x9f, 0x82, 0xc5, 0xb3, 0x00, 0x95, 0x2c, 0x49, 0x10, 0x48, 0x81, 0xff, 0x48};
+
+  memset (emm_security_context, 0, sizeof (*emm_security_context));
+  emm_security_context->sc_type = SECURITY_CTX_TYPE_FULL_NATIVE;
+  memcpy (emm_security_context->knas_enc, knas_enc, sizeof (knas_enc));
+  memcpy (emm_security_context->knas_int, knas_int, sizeof (knas_int));
+  emm_security_context->selected_algorithms.encryption = NAS_SECURITY_ALGORITHMS_EEA2;
+  emm_security_context->selected_algorithms.integrity = NAS_SECURITY_ALGORITHMS_EIA2;
+  emm_security_context->activated = 1;
+  nas_stream_aes_key_setup (&emm_security_context->knas_enc_aes, emm_security_context->knas_enc);
+  nas_stream_aes_key_setup (&emm_security_context->knas_int_aes, emm_security_context->knas_int);
+}
+
+/* Uplink MAC over the sequence number and the message */
+static uint32_t
+uplink_mac (
+  emm_security_context_t * emm_security_context,
+  uint8_t * buffer,
+  uint32_t length)
+{
+  nas_stream_cipher_t                     integrity = {.key = emm_security_context->knas_int, .key_length = AUTH_KNAS_INT_SIZE,
+                                                       .count = 0, .bearer = 0, .direction = SECU_DIRECTION_UPLINK};
+  uint8_t                                 mac[4];
+
+  integrity.message = buffer;
+  integrity.blength = length << 3;
+  nas_stream_encrypt_eia2_with_key (&emm_security_context->knas_int_aes, &integrity, mac);
+  return ((uint32_t) mac[0] << 24) | ((uint32_t) mac[1] << 16) | ((uint32_t) mac[2] << 8) | mac[3];
+}
+
+/* Builds the uplink PDU sent by the UE for a plain message, returns its length */
+static uint32_t
+build_pdu (
+  const nas_pdu_t * plain,
+  nas_codec_t codec,
+  emm_security_context_t * emm_security_context,
+  uint8_t * pdu)
+{
+  nas_stream_cipher_t                     ciphering = {.key = emm_security_context->knas_enc, .key_length = AUTH_KNAS_ENC_SIZE,
+                                                       .count = 0, .bearer = 0, .direction = SECU_DIRECTION_UPLINK};
+  uint32_t                                mac = 0;
+
+  if (plain->buffer[0] == nas_test_service_request.buffer[0]) {
+    memcpy (pdu, plain->buffer, plain->buf_len);
+    mac = uplink_mac (emm_security_context, pdu, 2);
+    pdu[2] = (mac >> 8) & 0xff;
+    pdu[3] = mac & 0xff;
+    return plain->buf_len;
+  }
+  if ((codec == NAS_CODEC_MSG) || (codec == NAS_CODEC_PLAIN)) {
+    memcpy (pdu, plain->buffer, plain->buf_len);
+    return plain->buf_len;
+  }
+  pdu[0] = ((codec == NAS_CODEC_CIPHERED) ? SECURITY_HEADER_TYPE_INTEGRITY_PROTECTED_CYPHERED : SECURITY_HEADER_TYPE_INTEGRITY_PROTECTED) << 4 | EPS_MOBILITY_MANAGEMENT_MESSAGE;
+  pdu[5] = 0;                   // sequence number
+  if (codec == NAS_CODEC_CIPHERED) {
+    ciphering.message = (uint8_t *) plain->buffer;
+    ciphering.blength = plain->buf_len << 3;
+    nas_stream_encrypt_eea2_with_key (&emm_security_context->knas_enc_aes, &ciphering, &pdu[NAS_MESSAGE_SECURITY_HEADER_SIZE]);
+  } else {
+    memcpy (&pdu[NAS_MESSAGE_SECURITY_HEADER_SIZE], plain->buffer, plain->buf_len);
+  }
+  mac = uplink_mac (emm_security_context, &pdu[5], plain->buf_len + 1);
+  pdu[1] = (mac >> 24) & 0xff;
+  pdu[2] = (mac >> 16) & 0xff;
+  pdu[3] = (mac >> 8) & 0xff;
+  pdu[4] = mac & 0xff;
+  return plain->buf_len + NAS_MESSAGE_SECURITY_HEADER_SIZE;
+}
+
+static int
+decode (
+  nas_codec_t codec,
+  const uint8_t * pdu,
+  uint32_t length,
+  nas_message_t * msg,
+  emm_security_context_t * emm_security_context,
+  nas_message_decode_status_t * status,
+  tlv_decode_arena_t * arena)
+{
+  memset (msg, 0, sizeof (*msg));
+  memset (status, 0, sizeof (*status));
+  if (codec != NAS_CODEC_MSG) {
+    return nas_message_decode (pdu, msg, length, (codec == NAS_CODEC_PLAIN) ? NULL : emm_security_context, status, arena);
+  } else if ((pdu[0] & 0x0f) == EPS_MOBILITY_MANAGEMENT_MESSAGE) {
+    return emm_msg_decode (&msg->plain.emm, (uint8_t *) pdu, length, arena);
+  }
+  return esm_msg_decode (&msg->plain.esm, (uint8_t *) pdu, length, arena);
+}
+
+static int
+encode (
+  nas_codec_t codec,
+  const nas_message_t * msg,
+  uint8_t * buffer,
+  emm_security_context_t * emm_security_context)
+{
+  uint8_t                                 plain[NAS_TEST_MAX_PDU_LENGTH];
+  int                                     size = 0;
+
+  if (codec == NAS_CODEC_MSG) {
+    if (msg->plain.emm.header.protocol_discriminator == EPS_MOBILITY_MANAGEMENT_MESSAGE) {
+      return emm_msg_encode ((EMM_msg *) & msg->plain.emm, buffer, NAS_TEST_MAX_PDU_LENGTH);
+    }
+    return esm_msg_encode ((ESM_msg *) & msg->plain.esm, buffer, NAS_TEST_MAX_PDU_LENGTH);
+  } else if (codec == NAS_CODEC_PLAIN) {
+    return nas_message_encode (buffer, msg, NAS_TEST_MAX_PDU_LENGTH, NULL);
+  } else if (msg->security_protected.plain.emm.header.protocol_discriminator == EPS_MOBILITY_MANAGEMENT_MESSAGE) {
+    return nas_message_encode (buffer, msg, NAS_TEST_MAX_PDU_LENGTH, emm_security_context);
+  }
+  /*
+   * As EMM-AS does, an ESM message is encoded plain then security protected
+   */
+  size = esm_msg_encode ((ESM_msg *) & msg->security_protected.plain.esm, plain, NAS_TEST_MAX_PDU_LENGTH);
+  if (size < 0) {
+    return size;
+  }
+  return nas_message_encrypt (plain, buffer, &msg->security_protected.header, size + NAS_MESSAGE_SECURITY_HEADER_SIZE, emm_security_context);
+}
+
+/* Decodes the PDU once and checks the result, fills the message to encode */
+static bool
+check (
+  const nas_pdu_t * plain,
+  nas_codec_t codec,
+  const uint8_t * pdu,
+  uint32_t length,
+  emm_security_context_t * emm_security_context,
+  nas_message_t * encode_msg,
+  tlv_decode_arena_t * arena)
+{
+  nas_message_t                           msg;
+  nas_message_decode_status_t             status;
+  uint8_t                                 buffer[NAS_TEST_MAX_PDU_LENGTH];
+  int                                     rc = 0;
+
+  rc = decode (codec, pdu, length, &msg, emm_security_context, &status, arena);
+  if (rc != (int)length) {
+    fprintf (stderr, "%s (%s): decoded %d bytes of %u\n", plain->message_name, nas_codec_names[codec], rc, length);
+    return false;
+  }
+  if ((codec == NAS_CODEC_INTEGRITY) || (codec == NAS_CODEC_CIPHERED)) {
+    if (!status.mac_matched) {
+      fprintf (stderr, "%s (%s): MAC mismatch\n", plain->message_name, nas_codec_names[codec]);
+      return false;
+    }
+    /*
+     * The plain message is decoded over the security header, move it to the security protected message
+     */
+    memset (encode_msg, 0, sizeof (*encode_msg));
+    encode_msg->security_protected.header.protocol_discriminator = EPS_MOBILITY_MANAGEMENT_MESSAGE;
+    encode_msg->security_protected.header.security_header_type = pdu[0] >> 4;
+    memcpy (&encode_msg->security_protected.plain, &msg.plain, sizeof (msg.plain));
+    rc = encode (NAS_CODEC_MSG, &msg, buffer, NULL);
+  } else {
+    memcpy (encode_msg, &msg, sizeof (msg));
+    rc = encode (codec, &msg, buffer, NULL);
+  }
+  if (!plain->encoding_differs && ((rc != (int)plain->buf_len) || memcmp (buffer, plain->buffer, plain->buf_len))) {
+    fprintf (stderr, "%s (%s): encoded %d bytes, differs from the %u bytes of the message\n", plain->message_name, nas_codec_names[codec], rc, plain->buf_len);
+    return false;
+  }
+  rc = encode (codec, encode_msg, buffer, emm_security_context);
+  if ((rc < 0) || (!plain->encoding_differs && (rc != (int)length))) {
+    fprintf (stderr, "%s (%s): encoded %d bytes instead of %u\n", plain->message_name, nas_codec_names[codec], rc, length);
+    return false;
+  }
+  return true;
+}
+
+static bool
+bench (
+  const nas_pdu_t * plain,
+  nas_codec_t codec,
+  emm_security_context_t * emm_security_context,
+  uint32_t nb_messages)
+{
+  uint8_t                                 pdu[NAS_TEST_MAX_PDU_LENGTH + NAS_MESSAGE_SECURITY_HEADER_SIZE];
+  uint8_t                                 buffer[NAS_TEST_MAX_PDU_LENGTH];
+  uint32_t                                length = build_pdu (plain, codec, emm_security_context, pdu);
+  bool                                    is_service_request = (plain->buffer[0] == nas_test_service_request.buffer[0]);
+  tlv_decode_arena_t                      msg_arena;
+  nas_message_t                           msg;
+  nas_message_t                           encode_msg;
+  nas_message_decode_status_t             status;
+  struct timespec                         start;
+  uint64_t                                allocs;
+  double                                  decode_ns, decode_allocs;
+  double                                  encode_ns = 0, encode_allocs = 0;
+
+  /*
+   * The decoded message to encode lives in its own arena
+   */
+  tlv_decode_arena_init (&msg_arena);
+  if (is_service_request) {
+    memset (&status, 0, sizeof (status));
+    if ((decode (NAS_CODEC_INTEGRITY, pdu, length, &msg, emm_security_context, &status, &msg_arena) != (int)length) || !status.mac_matched) {
+      fprintf (stderr, "%s: short MAC mismatch\n", plain->message_name);
+      tlv_decode_arena_release (&msg_arena);
+      return false;
+    }
+    codec = NAS_CODEC_INTEGRITY;
+  } else if (!check (plain, codec, pdu, length, emm_security_context, &encode_msg, &msg_arena)) {
+    tlv_decode_arena_release (&msg_arena);
+    return false;
+  }
+
+  allocs = nas_test_nb_allocs;
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  for (uint32_t i = 0; i < nb_messages; i++) {
+    tlv_decode_arena_t                      arena;
+
+    tlv_decode_arena_init (&arena);
+    decode (codec, pdu, length, &msg, emm_security_context, &status, &arena);
+    tlv_decode_arena_release (&arena);
+  }
+  decode_ns = elapsed_ns (&start) / nb_messages;
+  decode_allocs = (double)(nas_test_nb_allocs - allocs) / nb_messages;
+
+  /*
+   * The MME does not send service requests
+   */
+  if (!is_service_request) {
+    allocs = nas_test_nb_allocs;
+    clock_gettime (CLOCK_MONOTONIC, &start);
+    for (uint32_t i = 0; i < nb_messages; i++) {
+      encode (codec, &encode_msg, buffer, emm_security_context);
+    }
+    encode_ns = elapsed_ns (&start) / nb_messages;
+    encode_allocs = (double)(nas_test_nb_allocs - allocs) / nb_messages;
+  }
+  tlv_decode_arena_release (&msg_arena);
+
+  printf ("%-40s %-10s %5u %10.1f %8.2f", plain->message_name, is_service_request ? "short MAC" : nas_codec_names[codec], length, decode_ns, decode_allocs);
+  if (is_service_request) {
+    printf (" %10s %8s\n", "-", "-");
+  } else {
+    printf (" %10.1f %8.2f\n", encode_ns, encode_allocs);
+  }
+  return true;
+}
+
+int
+main (
+  int argc,
+  char *argv[])
+{
+  uint32_t                                nb_messages = DEFAULT_NB_MESSAGES;
+  nas_pdu_t                              *pdus = NULL;
+  int                                     nb_pdus = 0;
+  emm_security_context_t                  emm_security_context;
+  int                                     nb_failed = 0;
+
+  if (argc > 1) {
+    nb_messages = strtoul (argv[1], NULL, 0);
+  }
+  if (nb_messages == 0) {
+    nb_messages = 1;
+  }
+
+  if (argc > 2) {
+    pdus = calloc (argc - 2, sizeof (nas_pdu_t));
+    for (int i = 2; i < argc; i++) {
+      if (!load_pdu_file (argv[i], &pdus[nb_pdus])) {
+        return EXIT_FAILURE;
+      }
+      nb_pdus++;
+    }
+  } else {
+    nb_pdus = nas_test_corpus_size;
+    pdus = calloc (nb_pdus + 1, sizeof (nas_pdu_t));
+    memcpy (pdus, nas_test_corpus, nb_pdus * sizeof (nas_pdu_t));
+    pdus[nb_pdus++] = nas_test_service_request;
+  }
+
+  log_init (LOG_MME_ENV, OAILOG_LEVEL_ERROR, 1);
+  /*
+   * The decoded and encoded messages are sent to TASK_UNKNOWN, ITTI frees them
+   */
+  if (itti_init (TASK_MAX, THREAD_MAX, MESSAGES_ID_MAX, tasks_info, messages_info, NULL, NULL) < 0) {
+    fprintf (stderr, "itti_init failed\n");
+    return EXIT_FAILURE;
+  }
+  init_security_context (&emm_security_context);
+
+  printf ("%-40s %-10s %5s %10s %8s %10s %8s\n", "message", "codec", "bytes", "decode ns", "allocs", "encode ns", "allocs");
+  for (int i = 0; i < nb_pdus; i++) {
+    for (nas_codec_t codec = NAS_CODEC_MSG; codec < NAS_CODEC_MAX; codec++) {
+      if (!bench (&pdus[i], codec, &emm_security_context, nb_messages)) {
+        nb_failed++;
+      }
+      if (pdus[i].buffer[0] == nas_test_service_request.buffer[0]) {
+        break;
+      }
+    }
+  }
+  free (pdus);
+  if (nb_failed) {
+    fprintf (stderr, "%d failed\n", nb_failed);
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
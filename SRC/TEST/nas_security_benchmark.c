@@ -0,0 +1,108 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "secu_defs.h"
+
+/* Throughput of NAS security protection as done by nas_message_encrypt() for
+ * a downlink message: ciphering of the plain message in place, then MAC over
+ * the sequence number and the ciphered message. 128-EEA2/128-EIA2 either
+ * expand KNASenc/KNASint for every message or reuse the AES state cached in
+ * the EMM security context.
+ * usage: nas_security_benchmark [nb_messages]
+ */
+
+#define DEFAULT_NB_MESSAGES (1000 * 1000)
+#define MAX_MESSAGE_SIZE    512
+
+typedef enum {
+  BENCH_EEA1_EIA1,
+  BENCH_EEA2_EIA2,
+  BENCH_EEA2_EIA2_CACHED,
+} bench_algo_t;
+
+static double
+elapsed_ns (
+  struct timespec *start)
+{
+  struct timespec                         end;
+
+  clock_gettime (CLOCK_MONOTONIC, &end);
+  return (double)(end.tv_sec - start->tv_sec) * 1e9 + (double)(end.tv_nsec - start->tv_nsec);
+}
+
+static void
+bench (
+  const char *label,
+  bench_algo_t algo,
+  uint32_t size,
+  uint32_t nb_messages)
+{
+  static uint8_t                          knas_enc[16] = {0xd3, 0xc5, 0xd5, 0x92, 0x32, 0x7f, 0xb1, 0x1c, 0x40, 0x35, 0xc6, 0x68, 0x0a, 0xf8, 0xc6, 0xd1};
+  static uint8_t                          knas_int[16] = {0x2b, 0xd6, 0x45, 0x9f, 0x82, 0xc5, 0xb3, 0x00, 0x95, 0x2c, 0x49, 0x10, 0x48, 0x81, 0xff, 0x48};
+  /* security header: protocol discriminator, MAC, sequence number */
+  uint8_t                                 buffer[6 + MAX_MESSAGE_SIZE + 4] = {0};
+  uint8_t                                 mac[4];
+  nas_stream_aes_key_t                    knas_enc_aes = {.is_set = false};
+  nas_stream_aes_key_t                    knas_int_aes = {.is_set = false};
+  nas_stream_cipher_t                     ciphering = {.key = knas_enc, .key_length = 16, .bearer = 0, .direction = SECU_DIRECTION_DOWNLINK};
+  nas_stream_cipher_t                     integrity = {.key = knas_int, .key_length = 16, .bearer = 0, .direction = SECU_DIRECTION_DOWNLINK};
+  struct timespec                         start;
+  double                                  ns;
+
+  ciphering.message = &buffer[6];
+  ciphering.blength = size << 3;
+  integrity.message = &buffer[5];
+  integrity.blength = (size + 1) << 3;
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  for (uint32_t i = 0; i < nb_messages; i++) {
+    buffer[5] = (uint8_t) i;
+    ciphering.count = i;
+    integrity.count = i;
+    switch (algo) {
+    case BENCH_EEA1_EIA1:
+      nas_stream_encrypt_eea1 (&ciphering, ciphering.message);
+      nas_stream_encrypt_eia1 (&integrity, mac);
+      break;
+    case BENCH_EEA2_EIA2:
+      nas_stream_encrypt_eea2 (&ciphering, ciphering.message);
+      nas_stream_encrypt_eia2 (&integrity, mac);
+      break;
+    case BENCH_EEA2_EIA2_CACHED:
+      nas_stream_aes_key_setup (&knas_enc_aes, knas_enc);
+      nas_stream_aes_key_setup (&knas_int_aes, knas_int);
+      nas_stream_encrypt_eea2_with_key (&knas_enc_aes, &ciphering, ciphering.message);
+      nas_stream_encrypt_eia2_with_key (&knas_int_aes, &integrity, mac);
+      break;
+    }
+    memcpy (&buffer[1], mac, 4);
+  }
+  ns = elapsed_ns (&start);
+  printf ("%-20s %4u bytes: %8.1f ns/message, %10.0f messages/s\n", label, size, ns / nb_messages, nb_messages * 1e9 / ns);
+}
+
+int
+main (
+  int argc,
+  char *argv[])
+{
+  uint32_t                                nb_messages = DEFAULT_NB_MESSAGES;
+  uint32_t                                sizes[] = {16, 64, 256, MAX_MESSAGE_SIZE};
+
+  if (argc > 1) {
+    nb_messages = strtoul (argv[1], NULL, 0);
+  }
+
+  for (int i = 0; i < sizeof (sizes) / sizeof (sizes[0]); i++) {
+    bench ("EEA1+EIA1", BENCH_EEA1_EIA1, sizes[i], nb_messages);
+  }
+  for (int i = 0; i < sizeof (sizes) / sizeof (sizes[0]); i++) {
+    bench ("EEA2+EIA2", BENCH_EEA2_EIA2, sizes[i], nb_messages);
+  }
+  for (int i = 0; i < sizeof (sizes) / sizeof (sizes[0]); i++) {
+    bench ("EEA2+EIA2 cached key", BENCH_EEA2_EIA2_CACHED, sizes[i], nb_messages);
+  }
+  return EXIT_SUCCESS;
+}
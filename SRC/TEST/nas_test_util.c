@@ -0,0 +1,232 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "nas_test_util.h"
+
+void                                   *__real_malloc (size_t size);
+void                                   *__real_calloc (size_t nmemb, size_t size);
+void                                   *__real_realloc (void *ptr, size_t size);
+
+__thread uint64_t                       nas_test_nb_allocs = 0;
+
+void *
+__wrap_malloc (
+  size_t size)
+{
+  nas_test_nb_allocs++;
+  return __real_malloc (size);
+}
+
+void *
+__wrap_calloc (
+  size_t nmemb,
+  size_t size)
+{
+  nas_test_nb_allocs++;
+  return __real_calloc (nmemb, size);
+}
+
+void *
+__wrap_realloc (
+  void *ptr,
+  size_t size)
+{
+  nas_test_nb_allocs++;
+  return __real_realloc (ptr, size);
+}
+
+const nas_pdu_t                         nas_test_corpus[] = {
+  {
+   .message_name = "Attach request",
+   .buffer = {
+              0x07, 0x41, 0x71, 0x08, 0x29, 0x80, 0x39, 0x00, 0x00, 0x00,
+              0x00, 0x10, 0x02, 0xe0, 0xe0, 0x00, 0x2b, 0x02, 0x01, 0xd0,
+              0x11, 0x28, 0x09, 0x03, 0x6f, 0x61, 0x69, 0x04, 0x69, 0x70,
+              0x76, 0x34, 0x27, 0x1a, 0x80, 0x80, 0x21, 0x10, 0x01, 0x00,
+              0x00, 0x10, 0x81, 0x06, 0x00, 0x00, 0x00, 0x00, 0x83, 0x06,
+              0x00, 0x00, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x0a, 0x00,
+              },
+   .buf_len = 60,
+   },
+  {
+   .message_name = "Identity response",
+   .buffer = {
+              0x07, 0x56, 0x08, 0x29, 0x80, 0x39, 0x00, 0x00, 0x00, 0x00,
+              0x10,
+              },
+   .buf_len = 11,
+   },
+  {
+   .message_name = "Authentication response",
+   .buffer = {
+              0x07, 0x53, 0x08, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+              0x08,
+              },
+   .buf_len = 11,
+   },
+  {
+   .message_name = "Authentication failure",
+   .buffer = {
+              0x07, 0x5c, 0x15, 0x30, 0x0e, 0x01, 0x02, 0x03, 0x04, 0x05,
+              0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e,
+              },
+   .buf_len = 19,
+   },
+  {
+   .message_name = "Security mode complete",
+   .buffer = {
+              0x07, 0x5e,
+              },
+   .buf_len = 2,
+   },
+  {
+   .message_name = "Attach complete",
+   .buffer = {
+              0x07, 0x43, 0x00, 0x03, 0x52, 0x00, 0xc2,
+              },
+   .buf_len = 7,
+   },
+  {
+   .message_name = "Tracking area update request",
+   .buffer = {
+              0x07, 0x48, 0x00, 0x0b, 0xf6, 0x02, 0xf8, 0x39, 0x80, 0x00,
+              0x01, 0x02, 0xc0, 0x00, 0x01, 0x52, 0x02, 0xf8, 0x39, 0x00,
+              0x01, 0x57, 0x02, 0x20, 0x00,
+              },
+   .buf_len = 25,
+   },
+  {
+   .message_name = "Tracking area update complete",
+   .buffer = {
+              0x07, 0x4a,
+              },
+   .buf_len = 2,
+   },
+  {
+   .message_name = "Detach request",
+   .buffer = {
+              0x07, 0x45, 0x01, 0x0b, 0xf6, 0x02, 0xf8, 0x39, 0x80, 0x00,
+              0x01, 0x02, 0xc0, 0x00, 0x01,
+              },
+   .buf_len = 15,
+   },
+  {
+   .message_name = "Detach accept",
+   .buffer = {
+              0x07, 0x46,
+              },
+   .buf_len = 2,
+   },
+  {
+   .message_name = "PDN connectivity request",
+   .buffer = {
+              0x02, 0x01, 0xd0, 0x11, 0x28, 0x09, 0x03, 0x6f, 0x61, 0x69,
+              0x04, 0x69, 0x70, 0x76, 0x34, 0x27, 0x1a, 0x80, 0x80, 0x21,
+              0x10, 0x01, 0x00, 0x00, 0x10, 0x81, 0x06, 0x00, 0x00, 0x00,
+              0x00, 0x83, 0x06, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0d, 0x00,
+              0x00, 0x0a, 0x00,
+              },
+   .buf_len = 43,
+   .encoding_differs = true,
+   },
+  {
+   .message_name = "ESM information response",
+   .buffer = {
+              0x02, 0x01, 0xda, 0x28, 0x09, 0x03, 0x6f, 0x61, 0x69, 0x04,
+              0x69, 0x70, 0x76, 0x34,
+              },
+   .buf_len = 14,
+   .encoding_differs = true,
+   },
+  {
+   .message_name = "Activate default EPS bearer ctx accept",
+   .buffer = {
+              0x52, 0x00, 0xc2,
+              },
+   .buf_len = 3,
+   },
+  {
+   .message_name = "Deactivate EPS bearer ctx accept",
+   .buffer = {
+              0x52, 0x00, 0xce,
+              },
+   .buf_len = 3,
+   },
+  {
+   .message_name = "Identity request",
+   .buffer = {
+              0x07, 0x55, 0x01,
+              },
+   .buf_len = 3,
+   },
+  {
+   .message_name = "Authentication request",
+   .buffer = {
+              0x07, 0x52, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+              0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x10, 0x10,
+              0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1a,
+              0x1b, 0x1c, 0x1d, 0x1e, 0x1f, 0x20,
+              },
+   .buf_len = 36,
+   },
+  {
+   .message_name = "Security mode command",
+   .buffer = {
+              0x07, 0x5d, 0x22, 0x00, 0x04, 0xe0, 0xe0, 0xc0, 0x40,
+              },
+   .buf_len = 9,
+   },
+  {
+   .message_name = "Attach accept",
+   .buffer = {
+              0x07, 0x42, 0x01, 0x21, 0x06, 0x00, 0x02, 0xf8, 0x39, 0x00,
+              0x01, 0x00, 0x15, 0x52, 0x01, 0xc1, 0x01, 0x09, 0x09, 0x03,
+              0x6f, 0x61, 0x69, 0x04, 0x69, 0x70, 0x76, 0x34, 0x05, 0x01,
+              0x0a, 0x00, 0x00, 0x02, 0x50, 0x0b, 0xf6, 0x02, 0xf8, 0x39,
+              0x80, 0x00, 0x01, 0x02, 0xc0, 0x00, 0x01,
+              },
+   .buf_len = 47,
+   },
+};
+
+const int                               nas_test_corpus_size = sizeof (nas_test_corpus) / sizeof (nas_test_corpus[0]);
+
+const nas_pdu_t                         nas_test_service_request = {
+  .message_name = "Service request",
+  .buffer = {0xc7, 0x00, 0x00, 0x00},
+  .buf_len = 4,
+};
+
+const nas_pdu_t                        *
+nas_test_corpus_find (
+  const char *message_name)
+{
+  for (int i = 0; i < nas_test_corpus_size; i++) {
+    if (strcmp (nas_test_corpus[i].message_name, message_name) == 0) {
+      return &nas_test_corpus[i];
+    }
+  }
+  return NULL;
+}
+
+int
+nas_test_build_attach_request (
+  uint8_t * buffer,
+  const uint8_t * esm,
+  const int esm_len)
+{
+  static const uint8_t                    header[] = {
+    0x07, 0x41, 0x71,
+    0x08, 0x29, 0x80, 0x39, 0x00, 0x00, 0x00, 0x00, 0x10,
+    0x02, 0xe0, 0xe0
+  };
+  int                                     len = sizeof (header);
+
+  memcpy (buffer, header, sizeof (header));
+  buffer[len++] = (esm_len >> 8) & 0xff;
+  buffer[len++] = esm_len & 0xff;
+  memcpy (buffer + len, esm, esm_len);
+  return len + esm_len;
+}
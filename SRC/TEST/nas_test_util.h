@@ -0,0 +1,43 @@
+#ifndef FILE_NAS_TEST_UTIL_SEEN
+#define FILE_NAS_TEST_UTIL_SEEN
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Helpers shared by the NAS codec tests and benchmarks.
+ *
+ * Heap allocations: the executable is linked with
+ * -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc, every allocation made by a
+ * thread is counted in its nas_test_nb_allocs.
+ *
+ * Corpus: plain NAS messages of the attach, TAU, service request, PDN
+ * connectivity and detach procedures, uplink then downlink.
+ * IMSI 208930000000001, GUTI 208.93.32768.1.0x02c00001, APN "oai.ipv4".
+ */
+
+#define NAS_TEST_MAX_PDU_LENGTH (1024)
+
+typedef struct {
+  char                                   *message_name;
+  uint8_t                                 buffer[NAS_TEST_MAX_PDU_LENGTH];
+  uint32_t                                buf_len;
+  /* The APN is decoded as length prefixed labels, encoded from a dotted name */
+  bool                                    encoding_differs;
+} nas_pdu_t;
+
+extern __thread uint64_t                nas_test_nb_allocs;
+
+extern const nas_pdu_t                  nas_test_corpus[];
+extern const int                        nas_test_corpus_size;
+/* Service request: security header type 12, KSI and sequence number, short MAC */
+extern const nas_pdu_t                  nas_test_service_request;
+
+/* Returns the message of the corpus named message_name, NULL if none */
+const nas_pdu_t *nas_test_corpus_find (const char *message_name);
+
+/* Builds an attach request of IMSI 208930000000001 carrying the ESM message
+ * esm of esm_len bytes, returns its length
+ */
+int nas_test_build_attach_request (uint8_t * buffer, const uint8_t * esm, const int esm_len);
+
+#endif /* FILE_NAS_TEST_UTIL_SEEN */
@@ -0,0 +1,246 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include "queue.h"
+#include "common_defs.h"
+#include "pgw_ipv4_pool.h"
+
+/* UE IPv4 address pool of the P-GW: every address of a network/prefix_len
+ * pool is allocated then released in random order, then a pool with static
+ * reservations is filled, then allocations and releases are mixed on a pool
+ * kept nearly full. The release through the previous free/allocated lists,
+ * searched linearly, is given for a /LIST_PREFIX_LEN pool.
+ * usage: pgw_ipv4_pool_benchmark [prefix_len [nb_churns]]
+ */
+
+#define DEFAULT_PREFIX_LEN     10
+#define DEFAULT_NB_CHURNS      (10 * 1000 * 1000)
+#define NETWORK                0x0A000000   // 10.0.0.0
+#define RESERVED_EVERY         1000
+#define LIST_PREFIX_LEN        16
+#define LIST_RELEASES          10000
+
+struct ipv4_list_elm_s {
+  STAILQ_ENTRY(ipv4_list_elm_s) ipv4_entries;
+  uint32_t                                addr;
+};
+
+STAILQ_HEAD(ipv4_list_head_s, ipv4_list_elm_s);
+
+static double
+elapsed_ns (
+  struct timespec *start)
+{
+  struct timespec                         end;
+
+  clock_gettime (CLOCK_MONOTONIC, &end);
+  return (double)(end.tv_sec - start->tv_sec) * 1e9 + (double)(end.tv_nsec - start->tv_nsec);
+}
+
+static uint64_t                         rand_state = 88172645463325252ull;
+
+static uint32_t
+xorshift (
+  void)
+{
+  rand_state ^= rand_state << 13;
+  rand_state ^= rand_state >> 7;
+  rand_state ^= rand_state << 17;
+  return (uint32_t)rand_state;
+}
+
+static void
+shuffle (
+  uint32_t * addrs,
+  uint32_t nb)
+{
+  for (uint32_t i = nb - 1; i > 0; i--) {
+    uint32_t                                j = xorshift () % (i + 1);
+    uint32_t                                tmp = addrs[i];
+
+    addrs[i] = addrs[j];
+    addrs[j] = tmp;
+  }
+}
+
+static int
+bench_fill_and_release (
+  pgw_ipv4_pool_t * pool,
+  uint32_t * addrs)
+{
+  struct timespec                         start;
+  uint32_t                                addr;
+  double                                  ns;
+
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  for (uint32_t i = 0; i < pool->size; i++) {
+    if (pgw_ipv4_pool_allocate (pool, &addrs[i]) != RETURNok) {
+      fprintf (stderr, "allocation %u of %u failed\n", i, pool->size);
+      return -1;
+    }
+  }
+  ns = elapsed_ns (&start);
+  printf ("allocate %9u addresses: %7.1f ns/allocation\n", pool->size, ns / pool->size);
+  if (pgw_ipv4_pool_allocate (pool, &addr) == RETURNok) {
+    fprintf (stderr, "allocation in a full pool\n");
+    return -1;
+  }
+  for (uint32_t i = 0; i < pool->size; i++) {
+    if (addrs[i] != pool->first + i) {
+      fprintf (stderr, "address %u allocated at %u\n", addrs[i] - pool->first, i);
+      return -1;
+    }
+  }
+
+  shuffle (addrs, pool->size);
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  for (uint32_t i = 0; i < pool->size; i++) {
+    if (pgw_ipv4_pool_release (pool, addrs[i]) != RETURNok) {
+      fprintf (stderr, "release %u failed\n", i);
+      return -1;
+    }
+  }
+  ns = elapsed_ns (&start);
+  printf ("release  %9u addresses: %7.1f ns/release (random order)\n", pool->size, ns / pool->size);
+  if ((pool->nb_allocated != 0) || (pgw_ipv4_pool_release (pool, addrs[0]) == RETURNok)) {
+    fprintf (stderr, "pool not empty after release, or double release accepted\n");
+    return -1;
+  }
+  return 0;
+}
+
+static int
+check_reservations (
+  pgw_ipv4_pool_t * pool)
+{
+  uint32_t                                nb_reserved = 0;
+  uint32_t                                addr;
+
+  for (uint32_t reserved = pool->first; pgw_ipv4_pool_contains (pool, reserved); reserved += RESERVED_EVERY) {
+    if (pgw_ipv4_pool_reserve (pool, reserved) != RETURNok) {
+      fprintf (stderr, "reservation failed\n");
+      return -1;
+    }
+    nb_reserved++;
+  }
+  if ((pgw_ipv4_pool_reserve (pool, pool->first) == RETURNok) || (pgw_ipv4_pool_reserve (pool, pool->network) == RETURNok)
+      || (pgw_ipv4_pool_reserve (pool, pool->first + pool->size) == RETURNok)) {
+    fprintf (stderr, "reservation of a reserved address, the network or the broadcast address accepted\n");
+    return -1;
+  }
+  for (uint32_t i = 0; i < pool->size - nb_reserved; i++) {
+    if ((pgw_ipv4_pool_allocate (pool, &addr) != RETURNok) || ((addr - pool->first) % RESERVED_EVERY == 0)) {
+      fprintf (stderr, "allocation failed or reserved address allocated\n");
+      return -1;
+    }
+  }
+  if (pgw_ipv4_pool_allocate (pool, &addr) == RETURNok) {
+    fprintf (stderr, "allocation in a full pool\n");
+    return -1;
+  }
+  printf ("%u static reservations kept out of %u allocations\n", nb_reserved, pool->size - nb_reserved);
+
+  for (uint32_t i = 0; i < pool->size; i++) {
+    pgw_ipv4_pool_release (pool, pool->first + i);
+  }
+  return (pool->nb_allocated == 0) ? 0 : -1;
+}
+
+static int
+bench_churn (
+  pgw_ipv4_pool_t * pool,
+  uint32_t * addrs,
+  uint32_t nb_churns)
+{
+  struct timespec                         start;
+  uint32_t                                nb_allocated = pool->size - pool->size / 10;
+  double                                  ns;
+
+  for (uint32_t i = 0; i < nb_allocated; i++) {
+    pgw_ipv4_pool_allocate (pool, &addrs[i]);
+  }
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  for (uint32_t i = 0; i < nb_churns; i++) {
+    uint32_t                                j = xorshift () % nb_allocated;
+
+    if ((pgw_ipv4_pool_release (pool, addrs[j]) != RETURNok) || (pgw_ipv4_pool_allocate (pool, &addrs[j]) != RETURNok)) {
+      fprintf (stderr, "churn %u failed\n", i);
+      return -1;
+    }
+  }
+  ns = elapsed_ns (&start);
+  printf ("churn    %9u release + allocate, pool 90%% full: %7.1f ns/pair\n", nb_churns, ns / nb_churns);
+  return (pool->nb_allocated == nb_allocated) ? 0 : -1;
+}
+
+static void
+bench_list (
+  void)
+{
+  struct ipv4_list_head_s                 free_list = STAILQ_HEAD_INITIALIZER (free_list);
+  struct ipv4_list_head_s                 allocated_list = STAILQ_HEAD_INITIALIZER (allocated_list);
+  uint32_t                                nb_addrs = (1u << (32 - LIST_PREFIX_LEN)) - 3;
+  struct ipv4_list_elm_s                 *elms = calloc (nb_addrs, sizeof (struct ipv4_list_elm_s));
+  struct timespec                         start;
+
+  for (uint32_t i = 0; i < nb_addrs; i++) {
+    elms[i].addr = NETWORK + 2 + i;
+    STAILQ_INSERT_TAIL (&allocated_list, &elms[i], ipv4_entries);
+  }
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  for (uint32_t i = 0; i < LIST_RELEASES; i++) {
+    uint32_t                                addr = NETWORK + 2 + xorshift () % nb_addrs;
+    struct ipv4_list_elm_s                 *ipv4_p = NULL;
+
+    STAILQ_FOREACH (ipv4_p, &allocated_list, ipv4_entries) {
+      if (ipv4_p->addr == addr) {
+        STAILQ_REMOVE (&allocated_list, ipv4_p, ipv4_list_elm_s, ipv4_entries);
+        STAILQ_INSERT_TAIL (&free_list, ipv4_p, ipv4_entries);
+        break;
+      }
+    }
+  }
+  printf ("lists /%d: %7.1f ns/release, %zu bytes\n", LIST_PREFIX_LEN, elapsed_ns (&start) / LIST_RELEASES,
+          nb_addrs * sizeof (struct ipv4_list_elm_s));
+  free (elms);
+}
+
+int
+main (
+  int argc,
+  char *argv[])
+{
+  pgw_ipv4_pool_t                         pool;
+  uint32_t                                prefix_len = DEFAULT_PREFIX_LEN;
+  uint32_t                                nb_churns = DEFAULT_NB_CHURNS;
+  uint32_t                               *addrs;
+  int                                     rc = 0;
+
+  if (argc > 1) {
+    prefix_len = strtoul (argv[1], NULL, 0);
+  }
+  if (argc > 2) {
+    nb_churns = strtoul (argv[2], NULL, 0);
+  }
+  if (pgw_ipv4_pool_init (&pool, NETWORK & (0xFFFFFFFF << (32 - prefix_len)), prefix_len) != RETURNok) {
+    fprintf (stderr, "pool /%u initialization failed\n", prefix_len);
+    return EXIT_FAILURE;
+  }
+  printf ("pool /%u: %u addresses, %u levels, %zu bytes\n", prefix_len, pool.size, pool.nb_levels, pgw_ipv4_pool_memory_size (&pool));
+
+  addrs = calloc (pool.size, sizeof (uint32_t));
+  rc = bench_fill_and_release (&pool, addrs);
+  if (rc == 0) {
+    rc = check_reservations (&pool);
+  }
+  if (rc == 0) {
+    rc = bench_churn (&pool, addrs, nb_churns);
+  }
+  pgw_ipv4_pool_free (&pool);
+  free (addrs);
+  bench_list ();
+  return (rc == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
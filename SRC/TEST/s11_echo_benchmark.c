@@ -0,0 +1,221 @@
+#define _GNU_SOURCE             // required for recvmmsg() and sendmmsg()
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "intertask_interface.h"
+#include "intertask_interface_init.h"
+#include "log.h"
+#include "mme_config.h"
+#include "udp_primitives_server.h"
+#include "s11_mme.h"
+
+/* GTPv2-C Echo Requests sent on the loopback to the S11 interface of the
+ * MME (TASK_UDP, TASK_S11 and its GTPv2-C stack), which answers with Echo
+ * Responses. window requests are kept in flight, the client sends and
+ * receives by batches. Gives the echoes/s and the round trip latency.
+ * usage: s11_echo_benchmark [nb_echoes [window]]
+ */
+
+#define DEFAULT_NB_ECHOES  (200 * 1000)
+#define DEFAULT_WINDOW     64
+#define MAX_NB_ECHOES      0xFFFFFF     // GTPv2-C sequence numbers are 24 bits
+#define BATCH_SIZE         32
+#define BENCHMARK_PORT     21230
+#define ECHO_REQUEST_SIZE  13
+#define GTP_ECHO_REQ       1
+#define GTP_ECHO_RSP       2
+
+static uint64_t
+now_ns (
+  void)
+{
+  struct timespec                         ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static int
+compare_double (
+  const void *a,
+  const void *b)
+{
+  double                                  x = *(const double *)a;
+  double                                  y = *(const double *)b;
+
+  return (x > y) - (x < y);
+}
+
+/* Sends the Echo Requests first_seq..first_seq + nb - 1 */
+static void
+send_echo_requests (
+  int sd,
+  struct sockaddr_in *mme_addr,
+  uint32_t first_seq,
+  uint32_t nb,
+  uint64_t * send_ns)
+{
+  uint8_t                                 requests[BATCH_SIZE][ECHO_REQUEST_SIZE];
+  struct mmsghdr                          datagrams[BATCH_SIZE];
+  struct iovec                            iovecs[BATCH_SIZE];
+
+  while (nb > 0) {
+    uint32_t                                batch = (nb < BATCH_SIZE) ? nb : BATCH_SIZE;
+    int                                     nb_sent;
+
+    for (uint32_t i = 0; i < batch; i++) {
+      uint32_t                                seq = first_seq + i;
+      uint8_t                                *request = requests[i];
+
+      request[0] = 0x40;        // version 2, no piggybacking, no TEID
+      request[1] = GTP_ECHO_REQ;
+      request[2] = 0;
+      request[3] = ECHO_REQUEST_SIZE - 4;
+      request[4] = (seq >> 16) & 0xFF;
+      request[5] = (seq >> 8) & 0xFF;
+      request[6] = seq & 0xFF;
+      request[7] = 0;
+      request[8] = 3;           // Recovery IE
+      request[9] = 0;
+      request[10] = 1;
+      request[11] = 0;
+      request[12] = 0;
+      iovecs[i].iov_base = request;
+      iovecs[i].iov_len = ECHO_REQUEST_SIZE;
+      memset (&datagrams[i], 0, sizeof (datagrams[i]));
+      datagrams[i].msg_hdr.msg_name = mme_addr;
+      datagrams[i].msg_hdr.msg_namelen = sizeof (*mme_addr);
+      datagrams[i].msg_hdr.msg_iov = &iovecs[i];
+      datagrams[i].msg_hdr.msg_iovlen = 1;
+      send_ns[seq] = now_ns ();
+    }
+    if ((nb_sent = sendmmsg (sd, datagrams, batch, 0)) < 0) {
+      fprintf (stderr, "sendmmsg: %s\n", strerror (errno));
+      exit (EXIT_FAILURE);
+    }
+    first_seq += nb_sent;
+    nb -= nb_sent;
+  }
+}
+
+int
+main (
+  int argc,
+  char *argv[])
+{
+  uint32_t                                nb_echoes = DEFAULT_NB_ECHOES;
+  uint32_t                                window = DEFAULT_WINDOW;
+  struct sockaddr_in                      mme_addr = {0};
+  uint64_t                               *send_ns;
+  double                                 *latencies_ns;
+  uint32_t                                nb_sent,
+                                          nb_received = 0;
+  uint64_t                                start;
+  double                                  ns,
+                                          sum = 0;
+  int                                     sd;
+
+  if (argc > 1) {
+    nb_echoes = strtoul (argv[1], NULL, 0);
+  }
+  if (argc > 2) {
+    window = strtoul (argv[2], NULL, 0);
+  }
+  if (nb_echoes > MAX_NB_ECHOES - 1) {
+    nb_echoes = MAX_NB_ECHOES - 1;
+  }
+  if (window > nb_echoes) {
+    window = nb_echoes;
+  }
+
+  log_init (LOG_MME_ENV, OAILOG_LEVEL_ERROR, 1);
+  itti_init (TASK_MAX, THREAD_MAX, MESSAGES_ID_MAX, tasks_info, messages_info, NULL, NULL);
+  mme_config.max_ues = 1024;
+  mme_config.ipv4.s11 = htonl (INADDR_LOOPBACK);
+  mme_config.ipv4.port_s11 = BENCHMARK_PORT;
+  if ((udp_init () < 0) || (s11_mme_init (&mme_config) < 0)) {
+    fprintf (stderr, "S11 initialization failed\n");
+    return EXIT_FAILURE;
+  }
+
+  mme_addr.sin_family = AF_INET;
+  mme_addr.sin_port = htons (BENCHMARK_PORT);
+  mme_addr.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+  if ((sd = socket (AF_INET, SOCK_DGRAM, IPPROTO_UDP)) < 0) {
+    fprintf (stderr, "socket: %s\n", strerror (errno));
+    return EXIT_FAILURE;
+  }
+  // the socket of TASK_UDP is created asynchronously
+  usleep (100000);
+
+  send_ns = calloc (nb_echoes + 1, sizeof (uint64_t));
+  latencies_ns = calloc (nb_echoes, sizeof (double));
+  start = now_ns ();
+  send_echo_requests (sd, &mme_addr, 1, window, send_ns);
+  nb_sent = window;
+
+  while (nb_received < nb_echoes) {
+    uint8_t                                 responses[BATCH_SIZE][64];
+    struct mmsghdr                          datagrams[BATCH_SIZE];
+    struct iovec                            iovecs[BATCH_SIZE];
+    struct pollfd                           pfd = {.fd = sd,.events = POLLIN };
+    uint32_t                                nb_answered = 0;
+    int                                     nb_datagrams;
+
+    if (poll (&pfd, 1, 1000) <= 0) {
+      fprintf (stderr, "No response for 1 s, %u echoes lost\n", nb_sent - nb_received);
+      break;
+    }
+    for (int i = 0; i < BATCH_SIZE; i++) {
+      iovecs[i].iov_base = responses[i];
+      iovecs[i].iov_len = sizeof (responses[i]);
+      memset (&datagrams[i], 0, sizeof (datagrams[i]));
+      datagrams[i].msg_hdr.msg_iov = &iovecs[i];
+      datagrams[i].msg_hdr.msg_iovlen = 1;
+    }
+    if ((nb_datagrams = recvmmsg (sd, datagrams, BATCH_SIZE, MSG_DONTWAIT, NULL)) <= 0) {
+      continue;
+    }
+    for (int i = 0; i < nb_datagrams; i++) {
+      uint8_t                                *response = responses[i];
+      uint32_t                                seq;
+
+      if ((datagrams[i].msg_len < 8) || (response[1] != GTP_ECHO_RSP)) {
+        continue;
+      }
+      seq = (response[4] << 16) | (response[5] << 8) | response[6];
+      if ((seq == 0) || (seq > nb_sent)) {
+        continue;
+      }
+      latencies_ns[nb_received++] = (double)(now_ns () - send_ns[seq]);
+      nb_answered++;
+    }
+    if (nb_sent + nb_answered > nb_echoes) {
+      nb_answered = nb_echoes - nb_sent;
+    }
+    send_echo_requests (sd, &mme_addr, nb_sent + 1, nb_answered, send_ns);
+    nb_sent += nb_answered;
+  }
+  ns = (double)(now_ns () - start);
+
+  qsort (latencies_ns, nb_received, sizeof (double), compare_double);
+  for (uint32_t i = 0; i < nb_received; i++) {
+    sum += latencies_ns[i];
+  }
+  printf ("window %4u: %u/%u echoes, %10.0f echoes/s\n", window, nb_received, nb_echoes, nb_received * 1e9 / ns);
+  if (nb_received) {
+    printf ("latency: mean %8.1f us, p50 %8.1f us, p99 %8.1f us, max %8.1f us\n", sum / nb_received / 1e3,
+            latencies_ns[nb_received / 2] / 1e3, latencies_ns[nb_received * 99 / 100] / 1e3, latencies_ns[nb_received - 1] / 1e3);
+  }
+  close (sd);
+  return (nb_received == nb_echoes) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,353 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <time.h>
+#include <arpa/inet.h>
+
+#include "log.h"
+#include "NwGtpv2c.h"
+#include "NwGtpv2cIe.h"
+#include "NwGtpv2cMsg.h"
+#include "NwGtpv2cMsgParser.h"
+#include "NwGtpv2cPrivate.h"
+#include "sgw_ie_defs.h"
+#include "s11_messages_types.h"
+#include "s11_common.h"
+#include "s11_ie_formatter.h"
+
+/* S11 Create Session Request and Response parsing: a corpus of messages is
+ * parsed with a message parser allocated and filled for every message, as
+ * the S11 handlers used to, then with the parser built once per message
+ * type by nwGtpv2cMsgParserInfoInit(). The corpus is read from a pcap file
+ * (Ethernet, IPv4, UDP port 2123) or, without file, encoded with the S11 IE
+ * formatters. Gives the messages/s of both parsers.
+ * usage: s11_parser_benchmark [nb_parses [capture.pcap]]
+ */
+
+#define DEFAULT_NB_PARSES  (1000 * 1000)
+#define NB_SESSIONS        1024
+#define MAX_CORPUS_SIZE    (64 * 1024)
+#define GTPV2C_PORT        2123
+
+typedef struct corpus_s {
+  NwGtpv2cMsgHandleT                     *msgs;
+  uint32_t                                nb_msgs;
+} corpus_t;
+
+static const NwGtpv2cMsgParserIeInfoT   create_session_request_ie_info_tbl[] = {
+  {NW_GTPV2C_IE_IMSI, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL, s11_imsi_ie_get, offsetof (itti_s11_create_session_request_t, imsi)},
+  {NW_GTPV2C_IE_MSISDN, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL, s11_msisdn_ie_get, offsetof (itti_s11_create_session_request_t, msisdn)},
+  {NW_GTPV2C_IE_MEI, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL, s11_mei_ie_get, offsetof (itti_s11_create_session_request_t, mei)},
+  {NW_GTPV2C_IE_ULI, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL, s11_uli_ie_get, offsetof (itti_s11_create_session_request_t, uli)},
+  {NW_GTPV2C_IE_SERVING_NETWORK, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL, s11_serving_network_ie_get, offsetof (itti_s11_create_session_request_t, serving_network)},
+  {NW_GTPV2C_IE_RAT_TYPE, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_MANDATORY, s11_rat_type_ie_get, offsetof (itti_s11_create_session_request_t, rat_type)},
+  {NW_GTPV2C_IE_INDICATION, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL, s11_indication_flags_ie_get, offsetof (itti_s11_create_session_request_t, indication_flags)},
+  {NW_GTPV2C_IE_APN, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_MANDATORY, s11_apn_ie_get, offsetof (itti_s11_create_session_request_t, apn)},
+  {NW_GTPV2C_IE_SELECTION_MODE, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL, s11_ie_indication_generic, NW_GTPV2C_IE_NO_VALUE},
+  {NW_GTPV2C_IE_PDN_TYPE, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL, s11_pdn_type_ie_get, offsetof (itti_s11_create_session_request_t, pdn_type)},
+  {NW_GTPV2C_IE_PAA, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL, s11_paa_ie_get, offsetof (itti_s11_create_session_request_t, paa)},
+  {NW_GTPV2C_IE_FTEID, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_MANDATORY, s11_fteid_ie_get, offsetof (itti_s11_create_session_request_t, sender_fteid_for_cp)},
+  {NW_GTPV2C_IE_FTEID, NW_GTPV2C_IE_INSTANCE_ONE, NW_GTPV2C_IE_PRESENCE_CONDITIONAL, s11_fteid_ie_get, offsetof (itti_s11_create_session_request_t, pgw_address_for_cp)},
+  {NW_GTPV2C_IE_APN_RESTRICTION, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL, s11_ie_indication_generic, NW_GTPV2C_IE_NO_VALUE},
+  {NW_GTPV2C_IE_BEARER_CONTEXT, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_MANDATORY, s11_bearer_context_to_be_created_ie_get, offsetof (itti_s11_create_session_request_t, bearer_contexts_to_be_created)},
+  {NW_GTPV2C_IE_PCO, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL, s11_pco_ie_get, offsetof (itti_s11_create_session_request_t, pco)},
+  {NW_GTPV2C_IE_AMBR, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL, s11_ambr_ie_get, offsetof (itti_s11_create_session_request_t, ambr)},
+  {NW_GTPV2C_IE_RECOVERY, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_MANDATORY, s11_ie_indication_generic, NW_GTPV2C_IE_NO_VALUE},
+  {0}
+};
+
+static const NwGtpv2cMsgParserIeInfoT   create_session_response_ie_info_tbl[] = {
+  {NW_GTPV2C_IE_CAUSE, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_MANDATORY, s11_cause_ie_get, offsetof (itti_s11_create_session_response_t, cause)},
+  {NW_GTPV2C_IE_FTEID, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL, s11_fteid_ie_get, offsetof (itti_s11_create_session_response_t, s11_sgw_teid)},
+  {NW_GTPV2C_IE_FTEID, NW_GTPV2C_IE_INSTANCE_ONE, NW_GTPV2C_IE_PRESENCE_CONDITIONAL, s11_fteid_ie_get, offsetof (itti_s11_create_session_response_t, s5_s8_pgw_teid)},
+  {NW_GTPV2C_IE_PAA, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL, s11_paa_ie_get, offsetof (itti_s11_create_session_response_t, paa)},
+  {NW_GTPV2C_IE_PCO, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL, s11_pco_ie_get, offsetof (itti_s11_create_session_response_t, pco)},
+  {NW_GTPV2C_IE_BEARER_CONTEXT, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL, s11_bearer_context_created_ie_get, offsetof (itti_s11_create_session_response_t, bearer_contexts_created)},
+  {0}
+};
+
+static NwGtpv2cStackHandleT             stack;
+
+static double
+elapsed_ns (
+  struct timespec *start)
+{
+  struct timespec                         end;
+
+  clock_gettime (CLOCK_MONOTONIC, &end);
+  return (double)(end.tv_sec - start->tv_sec) * 1e9 + (double)(end.tv_nsec - start->tv_nsec);
+}
+
+/* Writes the header as the stack does when it sends the message, then reads it back as received */
+static void
+corpus_add (
+  corpus_t * corpus,
+  NwGtpv2cMsgHandleT hMsg)
+{
+  NwGtpv2cMsgT                           *pMsg = (NwGtpv2cMsgT *) hMsg;
+  uint8_t                                *hdr = pMsg->msgBuf;
+
+  hdr[0] = (pMsg->version << 5) | (pMsg->teidPresent << 3);
+  hdr[1] = pMsg->msgType;
+  *((uint16_t *) & hdr[2]) = htons (pMsg->msgLen - 4);
+  *((uint32_t *) & hdr[4]) = htonl (pMsg->teid);
+  hdr[8] = (pMsg->seqNum >> 16) & 0xFF;
+  hdr[9] = (pMsg->seqNum >> 8) & 0xFF;
+  hdr[10] = pMsg->seqNum & 0xFF;
+  hdr[11] = 0;
+  if (nwGtpv2cMsgFromBufferNew (stack, pMsg->msgBuf, pMsg->msgLen, &corpus->msgs[corpus->nb_msgs]) == NW_OK) {
+    corpus->nb_msgs++;
+  }
+  nwGtpv2cMsgDelete (stack, hMsg);
+}
+
+static void
+encode_corpus (
+  corpus_t * request_corpus,
+  corpus_t * response_corpus)
+{
+  itti_s11_create_session_request_t       request;
+  itti_s11_create_session_response_t      response;
+  bearer_context_created_t                bearer;
+  gtp_cause_t                             cause = {.cause_value = REQUEST_ACCEPTED };
+  uint8_t                                 restart_counter = 0;
+
+  memset (&request, 0, sizeof (request));
+  memset (&response, 0, sizeof (response));
+  memset (&bearer, 0, sizeof (bearer));
+  request.imsi.length = 15;
+  request.rat_type = RAT_EUTRAN;
+  request.pdn_type = IPv4;
+  strcpy (request.apn, "oai.ipv4");
+  request.serving_network.mcc[0] = 2;
+  request.serving_network.mcc[2] = 8;
+  request.serving_network.mnc[0] = 9;
+  request.serving_network.mnc[1] = 3;
+  request.serving_network.mnc[2] = 0x0F;
+  request.bearer_contexts_to_be_created.bearer_contexts[0].eps_bearer_id = 5;
+  request.bearer_contexts_to_be_created.bearer_contexts[0].bearer_level_qos.qci = 9;
+  response.paa.pdn_type = IPv4;
+  bearer.eps_bearer_id = 5;
+  bearer.cause = REQUEST_ACCEPTED;
+  bearer.s1u_sgw_fteid.ipv4 = 1;
+  bearer.s1u_sgw_fteid.interface_type = S1_U_SGW_GTP_U;
+  bearer.s1u_sgw_fteid.ipv4_address = 0xC0A80A02;
+
+  for (uint32_t i = 0; i < NB_SESSIONS; i++) {
+    NwGtpv2cMsgHandleT                      hMsg;
+    uint32_t                                msin = i;
+
+    // IMSI 20893 followed by the session number
+    for (int d = 14; d >= 0; d--) {
+      request.imsi.digit[d] = (d < 5) ? "20893"[d] - '0' : msin % 10;
+      msin /= (d < 5) ? 1 : 10;
+    }
+    nwGtpv2cMsgNew (stack, NW_TRUE, NW_GTP_CREATE_SESSION_REQ, 0, i + 1, &hMsg);
+    nwGtpv2cMsgAddIe (hMsg, NW_GTPV2C_IE_RECOVERY, 1, 0, &restart_counter);
+    s11_imsi_ie_set (&hMsg, &request.imsi);
+    s11_rat_type_ie_set (&hMsg, &request.rat_type);
+    s11_pdn_type_ie_set (&hMsg, &request.pdn_type);
+    nwGtpv2cMsgAddIeFteid (hMsg, NW_GTPV2C_IE_INSTANCE_ZERO, S11_MME_GTP_C, i + 1, 0xC0A80A01, NULL);
+    nwGtpv2cMsgAddIeFteid (hMsg, NW_GTPV2C_IE_INSTANCE_ONE, S5_S8_PGW_GTP_C, 0, 0xC0A80A03, NULL);
+    s11_apn_ie_set (&hMsg, request.apn);
+    s11_serving_network_ie_set (&hMsg, &request.serving_network);
+    s11_pco_ie_set (&hMsg, &request.pco);
+    s11_bearer_context_to_be_created_ie_set (&hMsg, &request.bearer_contexts_to_be_created.bearer_contexts[0]);
+    corpus_add (request_corpus, hMsg);
+
+    nwGtpv2cMsgNew (stack, NW_TRUE, NW_GTP_CREATE_SESSION_RSP, i + 1, i + 1, &hMsg);
+    s11_cause_ie_set (&hMsg, &cause);
+    nwGtpv2cMsgAddIeFteid (hMsg, NW_GTPV2C_IE_INSTANCE_ZERO, S11_SGW_GTP_C, i + 1, 0xC0A80A02, NULL);
+    nwGtpv2cMsgAddIeFteid (hMsg, NW_GTPV2C_IE_INSTANCE_ONE, S5_S8_PGW_GTP_C, i + 1, 0xC0A80A03, NULL);
+    response.paa.ipv4_address[0] = 10;
+    response.paa.ipv4_address[3] = i & 0xFF;
+    s11_paa_ie_set (&hMsg, &response.paa);
+    s11_apn_restriction_ie_set (&hMsg, 0);
+    s11_pco_ie_set (&hMsg, &response.pco);
+    bearer.s1u_sgw_fteid.teid = i + 1;
+    s11_bearer_context_created_ie_set (&hMsg, &bearer);
+    corpus_add (response_corpus, hMsg);
+  }
+}
+
+/* Reads the Create Session Requests and Responses of a classic pcap capture */
+static int
+read_pcap_corpus (
+  const char *path,
+  corpus_t * request_corpus,
+  corpus_t * response_corpus)
+{
+  FILE                                   *fp = fopen (path, "rb");
+  uint8_t                                 header[24];
+  uint8_t                                 record[16];
+  uint8_t                                *frame = malloc (65536);
+  int                                     swapped;
+
+  if (fp == NULL) {
+    fprintf (stderr, "Cannot open pcap file %s\n", path);
+    free (frame);
+    return -1;
+  }
+  if (fread (header, sizeof (header), 1, fp) != 1) {
+    fprintf (stderr, "Cannot read pcap file %s\n", path);
+    free (frame);
+    fclose (fp);
+    return -1;
+  }
+  swapped = (header[0] == 0xA1);
+#define PCAP_U32(p) (swapped ? (uint32_t)((p)[0] << 24 | (p)[1] << 16 | (p)[2] << 8 | (p)[3]) : (uint32_t)((p)[3] << 24 | (p)[2] << 16 | (p)[1] << 8 | (p)[0]))
+  if (PCAP_U32 (&header[20]) != 1) {
+    fprintf (stderr, "Only Ethernet captures are supported\n");
+    free (frame);
+    fclose (fp);
+    return -1;
+  }
+  while (fread (record, sizeof (record), 1, fp) == 1) {
+    uint32_t                                caplen = PCAP_U32 (&record[8]);
+    uint8_t                                *ip = &frame[14];
+    uint8_t                                *udp,
+                                           *gtp;
+    uint32_t                                gtp_len;
+
+    if ((caplen > 65536) || (fread (frame, caplen, 1, fp) != 1)) {
+      break;
+    }
+    if ((frame[12] == 0x81) && (frame[13] == 0x00)) {   // 802.1Q
+      ip += 4;
+    }
+    if ((caplen < (ip - frame) + 28) || ((ip[0] >> 4) != 4) || (ip[9] != IPPROTO_UDP)) {
+      continue;
+    }
+    udp = ip + (ip[0] & 0x0F) * 4;
+    gtp = udp + 8;
+    if ((((udp[0] << 8) | udp[1]) != GTPV2C_PORT) && (((udp[2] << 8) | udp[3]) != GTPV2C_PORT)) {
+      continue;
+    }
+    gtp_len = ((udp[4] << 8) | udp[5]) - 8;
+    if ((gtp + gtp_len > frame + caplen) || (gtp_len < 12) || (gtp_len > NW_GTPV2C_MAX_MSG_LEN) || ((gtp[0] & 0x08) == 0)) {
+      continue;
+    }
+    if ((gtp[1] == NW_GTP_CREATE_SESSION_REQ) && (request_corpus->nb_msgs < MAX_CORPUS_SIZE)) {
+      nwGtpv2cMsgFromBufferNew (stack, gtp, gtp_len, &request_corpus->msgs[request_corpus->nb_msgs++]);
+    } else if ((gtp[1] == NW_GTP_CREATE_SESSION_RSP) && (response_corpus->nb_msgs < MAX_CORPUS_SIZE)) {
+      nwGtpv2cMsgFromBufferNew (stack, gtp, gtp_len, &response_corpus->msgs[response_corpus->nb_msgs++]);
+    }
+  }
+#undef PCAP_U32
+  free (frame);
+  fclose (fp);
+  return 0;
+}
+
+/* The message parser of the S11 handlers before the precompiled parsers */
+static NwRcT
+parse_with_new_parser (
+  uint8_t msgType,
+  const NwGtpv2cMsgParserIeInfoT * pIeInfoTbl,
+  NwGtpv2cMsgHandleT hMsg,
+  uint8_t * values)
+{
+  NwGtpv2cMsgParserT                     *pMsgParser;
+  uint8_t                                 offendingIeType,
+                                          offendingIeInstance;
+  uint16_t                                offendingIeLength;
+  NwRcT                                   rc;
+
+  nwGtpv2cMsgParserNew (stack, msgType, s11_ie_indication_generic, NULL, &pMsgParser);
+  for (const NwGtpv2cMsgParserIeInfoT * pIeInfo = pIeInfoTbl; pIeInfo->ieType; pIeInfo++) {
+    nwGtpv2cMsgParserAddIe (pMsgParser, pIeInfo->ieType, pIeInfo->ieInstance, pIeInfo->iePresence, pIeInfo->ieReadCallback,
+                            (pIeInfo->ieValueOffset == NW_GTPV2C_IE_NO_VALUE) ? NULL : values + pIeInfo->ieValueOffset);
+  }
+  rc = nwGtpv2cMsgParserRun (pMsgParser, hMsg, &offendingIeType, &offendingIeInstance, &offendingIeLength);
+  nwGtpv2cMsgParserDelete (stack, pMsgParser);
+  return rc;
+}
+
+static int
+bench (
+  const char *name,
+  uint8_t msgType,
+  const NwGtpv2cMsgParserIeInfoT * pIeInfoTbl,
+  corpus_t * corpus,
+  size_t values_size,
+  uint32_t nb_parses)
+{
+  NwGtpv2cMsgParserInfoT                  parser_info;
+  uint8_t                                *values = malloc (values_size);
+  uint8_t                                 offendingIeType,
+                                          offendingIeInstance;
+  uint16_t                                offendingIeLength;
+  uint32_t                                nb_errors = 0;
+  struct timespec                         start;
+  double                                  ns;
+
+  if (corpus->nb_msgs == 0) {
+    printf ("%s: empty corpus\n", name);
+    free (values);
+    return 0;
+  }
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  for (uint32_t i = 0; i < nb_parses; i++) {
+    memset (values, 0, values_size);
+    nb_errors += (parse_with_new_parser (msgType, pIeInfoTbl, corpus->msgs[i % corpus->nb_msgs], values) != NW_OK);
+  }
+  ns = elapsed_ns (&start);
+  printf ("%s: %u messages, parser per message:  %10.0f msg/s\n", name, corpus->nb_msgs, nb_parses * 1e9 / ns);
+
+  if (nwGtpv2cMsgParserInfoInit (&parser_info, msgType, s11_ie_indication_generic, pIeInfoTbl) != NW_OK) {
+    free (values);
+    return -1;
+  }
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  for (uint32_t i = 0; i < nb_parses; i++) {
+    memset (values, 0, values_size);
+    nb_errors += (nwGtpv2cMsgParserInfoRun (&parser_info, corpus->msgs[i % corpus->nb_msgs], values,
+                                            &offendingIeType, &offendingIeInstance, &offendingIeLength) != NW_OK);
+  }
+  ns = elapsed_ns (&start);
+  printf ("%s: %u messages, precompiled parser: %10.0f msg/s\n", name, corpus->nb_msgs, nb_parses * 1e9 / ns);
+  free (values);
+  if (nb_errors) {
+    fprintf (stderr, "%s: %u parse errors\n", name, nb_errors);
+    return -1;
+  }
+  return 0;
+}
+
+int
+main (
+  int argc,
+  char *argv[])
+{
+  uint32_t                                nb_parses = DEFAULT_NB_PARSES;
+  corpus_t                                request_corpus = {0};
+  corpus_t                                response_corpus = {0};
+  int                                     rc = 0;
+
+  if (argc > 1) {
+    nb_parses = strtoul (argv[1], NULL, 0);
+  }
+
+  log_init (LOG_MME_ENV, OAILOG_LEVEL_ERROR, 1);
+  if (nwGtpv2cInitialize (&stack) != NW_OK) {
+    fprintf (stderr, "GTPv2-C stack initialization failed\n");
+    return EXIT_FAILURE;
+  }
+  request_corpus.msgs = calloc (MAX_CORPUS_SIZE, sizeof (NwGtpv2cMsgHandleT));
+  response_corpus.msgs = calloc (MAX_CORPUS_SIZE, sizeof (NwGtpv2cMsgHandleT));
+  if (argc > 2) {
+    if (read_pcap_corpus (argv[2], &request_corpus, &response_corpus) < 0) {
+      return EXIT_FAILURE;
+    }
+  } else {
+    encode_corpus (&request_corpus, &response_corpus);
+  }
+
+  rc |= bench ("Create Session Request ", NW_GTP_CREATE_SESSION_REQ, create_session_request_ie_info_tbl, &request_corpus,
+               sizeof (itti_s11_create_session_request_t), nb_parses);
+  rc |= bench ("Create Session Response", NW_GTP_CREATE_SESSION_RSP, create_session_response_ie_info_tbl, &response_corpus,
+               sizeof (itti_s11_create_session_response_t), nb_parses);
+  return (rc == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,313 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/wait.h>
+#include <sys/prctl.h>
+#include <arpa/inet.h>
+
+#include "intertask_interface.h"
+#include "intertask_interface_init.h"
+#include "log.h"
+#include "mme_config.h"
+#include "sgw_config.h"
+#include "teid_pool.h"
+#include "udp_primitives_server.h"
+#include "s11_mme.h"
+#include "s11_sgw.h"
+
+/* Create and Delete Session Requests between the S11 interfaces of the MME
+ * and of the S-GW on the loopback, both run by nb_shards GTPv2-C stack
+ * instances. The S-GW runs in a child process with TASK_SPGW_APP replaced by
+ * a task answering each request at once, TASK_MME_APP is replaced by a task
+ * keeping window sessions in flight, each one created then deleted. Gives the
+ * sessions/s, to be compared between shard counts. The S-GW GTPv2-C stacks
+ * keep the local tunnels of the deleted sessions, so the S-GW S11 TEIDs are
+ * never reused.
+ * usage: s11_shard_benchmark [nb_sessions [nb_shards [window]]]
+ */
+
+#define DEFAULT_NB_SESSIONS  (100 * 1000)
+#define DEFAULT_WINDOW       256
+#define BENCHMARK_PORT       21231
+#define MME_S11_ADDRESS      "127.0.0.1"
+#define SGW_S11_ADDRESS      "127.0.0.2"
+#define DEFAULT_EBI          5
+
+static uint32_t                         nb_sessions = DEFAULT_NB_SESSIONS;
+static uint32_t                         nb_shards = S11_SHARDS;
+static uint32_t                         window = DEFAULT_WINDOW;
+static volatile uint32_t                nb_done;
+static volatile uint32_t                nb_rejected;
+
+static uint64_t
+now_ns (
+  void)
+{
+  struct timespec                         ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void
+send_create_session_request (
+  teid_shards_t * teids,
+  uint32_t session)
+{
+  MessageDef                             *message_p = itti_alloc_new_message (TASK_MME_APP, S11_CREATE_SESSION_REQUEST);
+  itti_s11_create_session_request_t      *req_p = &message_p->ittiMsg.s11_create_session_request;
+  teid_t                                  mme_teid = teid_shards_allocate (teids);
+
+  memset (req_p, 0, sizeof (*req_p));
+  // IMSI 20893 followed by the session number
+  req_p->imsi.length = 15;
+  for (int d = 14; d >= 0; d--) {
+    req_p->imsi.digit[d] = (d < 5) ? "20893"[d] - '0' : session % 10;
+    session /= (d < 5) ? 1 : 10;
+  }
+  req_p->rat_type = RAT_EUTRAN;
+  req_p->pdn_type = IPv4;
+  strcpy (req_p->apn, "oai.ipv4");
+  req_p->serving_network.mcc[0] = 2;
+  req_p->serving_network.mcc[2] = 8;
+  req_p->serving_network.mnc[0] = 9;
+  req_p->serving_network.mnc[1] = 3;
+  req_p->serving_network.mnc[2] = 0x0F;
+  req_p->sender_fteid_for_cp.teid = mme_teid;
+  req_p->sender_fteid_for_cp.interface_type = S11_MME_GTP_C;
+  req_p->sender_fteid_for_cp.ipv4 = 1;
+  req_p->sender_fteid_for_cp.ipv4_address = inet_addr (MME_S11_ADDRESS);
+  req_p->bearer_contexts_to_be_created.num_bearer_context = 1;
+  req_p->bearer_contexts_to_be_created.bearer_contexts[0].eps_bearer_id = DEFAULT_EBI;
+  req_p->bearer_contexts_to_be_created.bearer_contexts[0].bearer_level_qos.qci = 9;
+  req_p->peer_ip = inet_addr (SGW_S11_ADDRESS);
+  itti_send_msg_to_task (s11_mme_task_id (mme_teid), INSTANCE_DEFAULT, message_p);
+}
+
+static void                            *
+mme_app_task (
+  __attribute__((unused)) void *args_p)
+{
+  teid_shards_t                           teids;
+  uint32_t                                nb_started = 0;
+
+  itti_mark_task_ready (TASK_MME_APP);
+  teid_shards_init (&teids, nb_shards);
+  for (; (nb_started < window) && (nb_started < nb_sessions); nb_started++) {
+    send_create_session_request (&teids, nb_started);
+  }
+
+  while (1) {
+    MessageDef                             *received_message_p = NULL;
+
+    itti_receive_msg (TASK_MME_APP, &received_message_p);
+
+    switch (ITTI_MSG_ID (received_message_p)) {
+    case S11_CREATE_SESSION_RESPONSE:{
+        itti_s11_create_session_response_t     *resp_p = &received_message_p->ittiMsg.s11_create_session_response;
+        MessageDef                             *message_p = itti_alloc_new_message (TASK_MME_APP, S11_DELETE_SESSION_REQUEST);
+        itti_s11_delete_session_request_t      *req_p = &message_p->ittiMsg.s11_delete_session_request;
+
+        if (resp_p->cause != REQUEST_ACCEPTED) {
+          __sync_fetch_and_add (&nb_rejected, 1);
+        }
+        memset (req_p, 0, sizeof (*req_p));
+        req_p->teid = resp_p->s11_sgw_teid.teid;
+        req_p->local_teid = resp_p->teid;
+        req_p->lbi = DEFAULT_EBI;
+        req_p->sender_fteid_for_cp.teid = resp_p->teid;
+        req_p->sender_fteid_for_cp.interface_type = S11_MME_GTP_C;
+        req_p->sender_fteid_for_cp.ipv4 = 1;
+        req_p->sender_fteid_for_cp.ipv4_address = inet_addr (MME_S11_ADDRESS);
+        req_p->peer_ip = inet_addr (SGW_S11_ADDRESS);
+        itti_send_msg_to_task (s11_mme_task_id (resp_p->teid), INSTANCE_DEFAULT, message_p);
+      }
+      break;
+
+    case S11_DELETE_SESSION_RESPONSE:{
+        teid_shards_release (&teids, received_message_p->ittiMsg.s11_delete_session_response.teid);
+        __sync_fetch_and_add (&nb_done, 1);
+        if (nb_started < nb_sessions) {
+          send_create_session_request (&teids, nb_started++);
+        }
+      }
+      break;
+
+    default:
+      break;
+    }
+    itti_free (ITTI_MSG_ORIGIN_ID (received_message_p), received_message_p);
+  }
+  return NULL;
+}
+
+static void                            *
+spgw_app_task (
+  __attribute__((unused)) void *args_p)
+{
+  teid_shards_t                           teids;
+
+  itti_mark_task_ready (TASK_SPGW_APP);
+  teid_shards_init (&teids, nb_shards);
+
+  while (1) {
+    MessageDef                             *received_message_p = NULL;
+
+    itti_receive_msg (TASK_SPGW_APP, &received_message_p);
+
+    switch (ITTI_MSG_ID (received_message_p)) {
+    case S11_CREATE_SESSION_REQUEST:{
+        itti_s11_create_session_request_t      *req_p = &received_message_p->ittiMsg.s11_create_session_request;
+        MessageDef                             *message_p = itti_alloc_new_message (TASK_SPGW_APP, S11_CREATE_SESSION_RESPONSE);
+        itti_s11_create_session_response_t     *resp_p = &message_p->ittiMsg.s11_create_session_response;
+        bearer_context_created_t               *bearer_p = &resp_p->bearer_contexts_created.bearer_contexts[0];
+        // as the S-GW does, the S11 TEID is allocated in the shard that received the request
+        uint32_t                                shard = ITTI_MSG_ORIGIN_ID (received_message_p) - TASK_S11;
+        teid_t                                  sgw_teid = teid_pool_allocate (&teids.pools[shard & (nb_shards - 1)]);
+
+        memset (resp_p, 0, sizeof (*resp_p));
+        resp_p->teid = req_p->sender_fteid_for_cp.teid;
+        resp_p->cause = REQUEST_ACCEPTED;
+        resp_p->s11_sgw_teid.teid = sgw_teid;
+        resp_p->s11_sgw_teid.interface_type = S11_SGW_GTP_C;
+        resp_p->s11_sgw_teid.ipv4 = 1;
+        resp_p->s11_sgw_teid.ipv4_address = inet_addr (SGW_S11_ADDRESS);
+        resp_p->paa.pdn_type = IPv4;
+        resp_p->paa.ipv4_address[0] = 10;
+        resp_p->bearer_contexts_created.num_bearer_context = 1;
+        bearer_p->eps_bearer_id = DEFAULT_EBI;
+        bearer_p->cause = REQUEST_ACCEPTED;
+        bearer_p->s1u_sgw_fteid.teid = sgw_teid;
+        bearer_p->s1u_sgw_fteid.interface_type = S1_U_SGW_GTP_U;
+        bearer_p->s1u_sgw_fteid.ipv4 = 1;
+        bearer_p->s1u_sgw_fteid.ipv4_address = inet_addr (SGW_S11_ADDRESS);
+        resp_p->trxn = req_p->trxn;
+        resp_p->peer_ip = req_p->peer_ip;
+        itti_send_msg_to_task (s11_sgw_task_id (sgw_teid), INSTANCE_DEFAULT, message_p);
+      }
+      break;
+
+    case S11_DELETE_SESSION_REQUEST:{
+        itti_s11_delete_session_request_t      *req_p = &received_message_p->ittiMsg.s11_delete_session_request;
+        MessageDef                             *message_p = itti_alloc_new_message (TASK_SPGW_APP, S11_DELETE_SESSION_RESPONSE);
+        itti_s11_delete_session_response_t     *resp_p = &message_p->ittiMsg.s11_delete_session_response;
+
+        memset (resp_p, 0, sizeof (*resp_p));
+        resp_p->teid = req_p->sender_fteid_for_cp.teid;
+        resp_p->cause = REQUEST_ACCEPTED;
+        resp_p->trxn = req_p->trxn;
+        resp_p->peer_ip = req_p->peer_ip;
+        itti_send_msg_to_task (s11_sgw_task_id (req_p->teid), INSTANCE_DEFAULT, message_p);
+      }
+      break;
+
+    default:
+      break;
+    }
+    itti_free (ITTI_MSG_ORIGIN_ID (received_message_p), received_message_p);
+  }
+  return NULL;
+}
+
+/* The S-GW process, it runs until it is killed */
+static void
+run_sgw (
+  void)
+{
+  sgw_config_t                            sgw_config;
+
+  // the S-GW does not outlive the MME, even when the MME is killed
+  prctl (PR_SET_PDEATHSIG, SIGKILL);
+  log_init (LOG_SPGW_ENV, OAILOG_LEVEL_ERROR, 1);
+  itti_init (TASK_MAX, THREAD_MAX, MESSAGES_ID_MAX, tasks_info, messages_info, NULL, NULL);
+  memset (&sgw_config, 0, sizeof (sgw_config));
+  pthread_rwlock_init (&sgw_config.rw_lock, NULL);
+  sgw_config.ipv4.S11 = inet_addr (SGW_S11_ADDRESS);
+  sgw_config.ipv4.nb_s11_shards = nb_shards;
+  if ((udp_init () < 0) || (s11_sgw_init (&sgw_config) < 0) || (itti_create_task (TASK_SPGW_APP, &spgw_app_task, NULL) < 0)) {
+    fprintf (stderr, "S-GW S11 initialization failed\n");
+    exit (EXIT_FAILURE);
+  }
+  while (1) {
+    pause ();
+  }
+}
+
+int
+main (
+  int argc,
+  char *argv[])
+{
+  uint32_t                                last_done = 0;
+  uint64_t                                start,
+                                          last_progress;
+  double                                  ns;
+  pid_t                                   sgw_pid;
+  int                                     status;
+
+  if (argc > 1) {
+    nb_sessions = strtoul (argv[1], NULL, 0);
+  }
+  if (argc > 2) {
+    nb_shards = strtoul (argv[2], NULL, 0);
+  }
+  if (argc > 3) {
+    window = strtoul (argv[3], NULL, 0);
+  }
+  if ((nb_shards == 0) || (nb_shards > S11_MAX_SHARDS) || (nb_shards & (nb_shards - 1))) {
+    fprintf (stderr, "nb_shards must be a power of 2 up to %d\n", S11_MAX_SHARDS);
+    return EXIT_FAILURE;
+  }
+
+  // the S-GW and the MME both run TASK_S11 and TASK_UDP, each one in its process
+  if ((sgw_pid = fork ()) < 0) {
+    perror ("fork");
+    return EXIT_FAILURE;
+  } else if (sgw_pid == 0) {
+    run_sgw ();
+  }
+
+  log_init (LOG_MME_ENV, OAILOG_LEVEL_ERROR, 1);
+  itti_init (TASK_MAX, THREAD_MAX, MESSAGES_ID_MAX, tasks_info, messages_info, NULL, NULL);
+  mme_config.max_ues = window * 2;
+  mme_config.ipv4.s11 = inet_addr (MME_S11_ADDRESS);
+  mme_config.ipv4.port_s11 = BENCHMARK_PORT;
+  mme_config.ipv4.sgw_s11 = inet_addr (SGW_S11_ADDRESS);
+  mme_config.ipv4.nb_s11_shards = nb_shards;
+  if ((udp_init () < 0) || (s11_mme_init (&mme_config) < 0)) {
+    fprintf (stderr, "MME S11 initialization failed\n");
+    kill (sgw_pid, SIGKILL);
+    return EXIT_FAILURE;
+  }
+  // the sockets of both TASK_UDP are created asynchronously
+  usleep (200000);
+
+  start = last_progress = now_ns ();
+  if (itti_create_task (TASK_MME_APP, &mme_app_task, NULL) < 0) {
+    fprintf (stderr, "TASK_MME_APP creation failed\n");
+    kill (sgw_pid, SIGKILL);
+    return EXIT_FAILURE;
+  }
+  while (nb_done < nb_sessions) {
+    usleep (1000);
+    if (nb_done != last_done) {
+      last_done = nb_done;
+      last_progress = now_ns ();
+    } else if (now_ns () - last_progress > 1000000000ull) {
+      fprintf (stderr, "No session done for 1 s, %u sessions lost\n", nb_sessions - nb_done);
+      break;
+    }
+  }
+  ns = (double)(now_ns () - start);
+  kill (sgw_pid, SIGKILL);
+  waitpid (sgw_pid, &status, 0);
+
+  printf ("%u shards, window %4u: %u/%u sessions, %10.0f sessions/s (create + delete), %u rejected\n", nb_shards, window, nb_done, nb_sessions,
+          nb_done * 1e9 / ns, nb_rejected);
+  return ((nb_done == nb_sessions) && (nb_rejected == 0)) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
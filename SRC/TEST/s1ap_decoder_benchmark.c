@@ -0,0 +1,171 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "bstrlib.h"
+#include "intertask_interface.h"
+#include "intertask_interface_init.h"
+#include "s1ap_common.h"
+#include "s1ap_mme_decoder.h"
+
+/* Decodes a corpus of uplink S1AP PDUs with the MME decoder, with the XER
+ * rendering of decoded messages on demand (default) and always on, and
+ * reports the decoding rate of both modes.
+ * The corpus is built-in or made of files, each one holding a single raw
+ * S1AP PDU (ex: exported from wireshark with "Export Packet Bytes").
+ * usage: s1ap_decoder_benchmark [nb_messages [pdu_file...]]
+ */
+
+#define DEFAULT_NB_MESSAGES (100 * 1000)
+#define MAX_PDU_LENGTH      (1024)
+
+typedef struct {
+  char                                   *procedure_name;
+  uint8_t                                 buffer[MAX_PDU_LENGTH];
+  uint32_t                                buf_len;
+} s1ap_pdu_t;
+
+/* Captured on an eNB <-> MME link, see oaisim_mme_s1ap_test.c */
+static const s1ap_pdu_t                 s1ap_corpus[] = {
+  {
+   .procedure_name = "Uplink NAS transport",
+   .buffer = {
+              0x00, 0x0D, 0x40, 0x41, 0x00, 0x00, 0x05, 0x00, 0x00, 0x00,
+              0x05, 0xC0, 0x01, 0x10, 0xCE, 0xCC, 0x00, 0x08, 0x00, 0x03,
+              0x40, 0x01, 0xB3, 0x00, 0x1A, 0x00, 0x14, 0x13, 0x27, 0xD3,
+              0x77, 0xED, 0x4C, 0x01, 0x02, 0x01, 0xDA, 0x28, 0x08, 0x03,
+              0x69, 0x6D, 0x73, 0x03, 0x70, 0x66, 0x74, 0x00, 0x64, 0x40,
+              0x08, 0x00, 0x02, 0xF8, 0x29, 0x00, 0x00, 0x20, 0x40, 0x00,
+              0x43, 0x40, 0x06, 0x00, 0x02, 0xF8, 0x29, 0x00, 0x04,
+              },
+   .buf_len = 69,
+   },
+  {
+   .procedure_name = "UE capability info indication",
+   .buffer = {
+              0x00, 0x16, 0x40, 0x37, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00,
+              0x05, 0xC0, 0x01, 0x10, 0xCE, 0xCC, 0x00, 0x08, 0x00, 0x03,
+              0x40, 0x01, 0xB3, 0x00, 0x4A, 0x40, 0x20, 0x1F, 0x00, 0xE8,
+              0x01, 0x01, 0xA8, 0x13, 0x80, 0x00, 0x20, 0x83, 0x13, 0x05,
+              0x0B, 0x8B, 0xFC, 0x2E, 0x2F, 0xF0, 0xB8, 0xBF, 0xAF, 0x87,
+              0xFE, 0x40, 0x44, 0x04, 0x07, 0x0C, 0xA7, 0x4A, 0x80,
+              },
+   .buf_len = 59,
+   },
+  {
+   .procedure_name = "Initial context setup response",
+   .buffer = {
+              0x20, 0x09, 0x00, 0x26, 0x00, 0x00, 0x03, 0x00, 0x00, 0x40,
+              0x05, 0xC0, 0x01, 0x10, 0xCE, 0xCC, 0x00, 0x08, 0x40, 0x03,
+              0x40, 0x01, 0xB3, 0x00, 0x33, 0x40, 0x0F, 0x00, 0x00, 0x32,
+              0x40, 0x0A, 0x0A, 0x1F, 0x0A, 0x05, 0x02, 0x05, 0x00, 0x0F,
+              0x7A, 0x03,
+              },
+   .buf_len = 42,
+   },
+};
+
+static double
+elapsed_ns (
+  struct timespec *start)
+{
+  struct timespec                         end;
+
+  clock_gettime (CLOCK_MONOTONIC, &end);
+  return (double)(end.tv_sec - start->tv_sec) * 1e9 + (double)(end.tv_nsec - start->tv_nsec);
+}
+
+static bstring
+load_pdu_file (
+  const char *file_name)
+{
+  FILE                                   *fp = fopen (file_name, "rb");
+  bstring                                 pdu = NULL;
+
+  if (fp == NULL) {
+    fprintf (stderr, "Cannot open %s\n", file_name);
+    return NULL;
+  }
+  pdu = bread ((bNread) fread, fp);
+  fclose (fp);
+  return pdu;
+}
+
+static double
+bench_decode (
+  bstring *pdus,
+  int nb_pdus,
+  uint32_t nb_messages,
+  s1ap_xer_print_mode_t mode,
+  const char *label)
+{
+  struct timespec                         start;
+  uint32_t                                nb_failed = 0;
+  double                                  ns;
+
+  s1ap_mme_decoder_set_xer_print_mode (mode);
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  for (uint32_t i = 0; i < nb_messages; i++) {
+    s1ap_message                            message = {0};
+
+    if (s1ap_mme_decode_pdu (&message, pdus[i % nb_pdus]) < 0) {
+      nb_failed++;
+    }
+  }
+  ns = elapsed_ns (&start);
+  printf ("%-10s %8u messages (%u failed): %10.0f msg/s, %8.1f ns/msg\n", label, nb_messages, nb_failed, nb_messages * 1e9 / ns, ns / nb_messages);
+  return nb_messages * 1e9 / ns;
+}
+
+int
+main (
+  int argc,
+  char *argv[])
+{
+  uint32_t                                nb_messages = DEFAULT_NB_MESSAGES;
+  bstring                                *pdus = NULL;
+  int                                     nb_pdus = 0;
+  double                                  on_demand, always;
+
+  if (argc > 1) {
+    nb_messages = strtoul (argv[1], NULL, 0);
+  }
+
+  if (argc > 2) {
+    pdus = calloc (argc - 2, sizeof (bstring));
+    for (int i = 2; i < argc; i++) {
+      if ((pdus[nb_pdus] = load_pdu_file (argv[i])) == NULL) {
+        return EXIT_FAILURE;
+      }
+      nb_pdus++;
+    }
+  } else {
+    nb_pdus = sizeof (s1ap_corpus) / sizeof (s1ap_corpus[0]);
+    pdus = calloc (nb_pdus, sizeof (bstring));
+    for (int i = 0; i < nb_pdus; i++) {
+      pdus[i] = blk2bstr (s1ap_corpus[i].buffer, s1ap_corpus[i].buf_len);
+    }
+  }
+
+  /*
+   * The rendered messages are sent to TASK_UNKNOWN, ITTI frees them (after queuing them to the dump ring buffer if the analyzer is enabled)
+   */
+  if (itti_init (TASK_MAX, THREAD_MAX, MESSAGES_ID_MAX, tasks_info, messages_info, NULL, NULL) < 0) {
+    fprintf (stderr, "itti_init failed\n");
+    return EXIT_FAILURE;
+  }
+
+  // warm up
+  bench_decode (pdus, nb_pdus, nb_pdus, S1AP_XER_PRINT_ALWAYS, "warm up");
+  always = bench_decode (pdus, nb_pdus, nb_messages, S1AP_XER_PRINT_ALWAYS, "always");
+  on_demand = bench_decode (pdus, nb_pdus, nb_messages, S1AP_XER_PRINT_ON_DEMAND, "on demand");
+  printf ("speedup x%.2f on %d PDUs\n", on_demand / always, nb_pdus);
+
+  for (int i = 0; i < nb_pdus; i++) {
+    bdestroy (pdus[i]);
+  }
+  free (pdus);
+  return EXIT_SUCCESS;
+}
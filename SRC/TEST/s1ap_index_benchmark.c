@@ -0,0 +1,245 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include "log.h"
+#include "mme_config.h"
+#include "s1ap_mme.h"
+
+/* Lookups of the S1AP layer on a synthetic population of eNBs and UEs:
+ * UE by mme_ue_s1ap_id, UE by S11 SGW TEID and eNB by eNB id, through the
+ * secondary indexes and through a scan of every eNB then every UE of each
+ * eNB (the previous implementation), then the removal of the population,
+ * which must leave the indexes empty.
+ * usage: s1ap_index_benchmark [nb_enbs [nb_ues_per_enb [nb_lookups]]]
+ */
+
+#define DEFAULT_NB_ENBS         1000
+#define DEFAULT_NB_UES_PER_ENB  100
+#define DEFAULT_NB_LOOKUPS      (1000 * 1000)
+/* A scan visits the whole population, keep it short */
+#define SCAN_LOOKUPS_DIVIDER    1000
+#define ENB_ID_BASE             0x10000
+#define S11_TEID_BASE           0x80000000
+
+extern hash_table_ts_t                  g_s1ap_enb_coll;
+extern hash_table_ts_t                  g_s1ap_enb_id_coll;
+extern hash_table_ts_t                  g_s1ap_mme_ue_id_coll;
+extern hash_table_ts_t                  g_s1ap_s11_teid_coll;
+
+typedef enum {
+  LOOKUP_UE_BY_MME_UE_ID,
+  LOOKUP_UE_BY_S11_TEID,
+  LOOKUP_ENB_BY_ENB_ID,
+} lookup_t;
+
+static uint32_t                         nb_enbs = DEFAULT_NB_ENBS;
+static uint32_t                         nb_ues_per_enb = DEFAULT_NB_UES_PER_ENB;
+
+static double
+elapsed_ns (
+  struct timespec *start)
+{
+  struct timespec                         end;
+
+  clock_gettime (CLOCK_MONOTONIC, &end);
+  return (double)(end.tv_sec - start->tv_sec) * 1e9 + (double)(end.tv_nsec - start->tv_nsec);
+}
+
+typedef struct {
+  lookup_t                                type;
+  uint64_t                                id;
+} scan_parameter_t;
+
+static bool
+scan_ue_cb (
+  __attribute__((unused)) const hash_key_t keyP,
+  void * const elementP,
+  void *parameterP,
+  void **resultP)
+{
+  ue_description_t                       *ue_ref = (ue_description_t *)elementP;
+  scan_parameter_t                       *parameter = (scan_parameter_t *)parameterP;
+
+  if (((parameter->type == LOOKUP_UE_BY_MME_UE_ID) && (ue_ref->mme_ue_s1ap_id == parameter->id)) ||
+      ((parameter->type == LOOKUP_UE_BY_S11_TEID) && (ue_ref->s11_sgw_teid == parameter->id))) {
+    *resultP = elementP;
+    return true;
+  }
+  return false;
+}
+
+static bool
+scan_enb_cb (
+  __attribute__((unused)) const hash_key_t keyP,
+  void * const elementP,
+  void *parameterP,
+  void **resultP)
+{
+  enb_description_t                      *enb_ref = (enb_description_t *)elementP;
+  scan_parameter_t                       *parameter = (scan_parameter_t *)parameterP;
+
+  if (parameter->type == LOOKUP_ENB_BY_ENB_ID) {
+    if (enb_ref->enb_id == parameter->id) {
+      *resultP = elementP;
+      return true;
+    }
+    return false;
+  }
+  hashtable_ts_apply_callback_on_elements (&enb_ref->ue_coll, scan_ue_cb, parameterP, resultP);
+  return (*resultP != NULL);
+}
+
+static void *
+lookup (
+  lookup_t type,
+  uint64_t id,
+  bool scan)
+{
+  void                                   *ref = NULL;
+
+  if (scan) {
+    scan_parameter_t                        parameter = {.type = type, .id = id};
+
+    hashtable_ts_apply_callback_on_elements (&g_s1ap_enb_coll, scan_enb_cb, &parameter, &ref);
+    return ref;
+  }
+  switch (type) {
+  case LOOKUP_UE_BY_MME_UE_ID:
+    return s1ap_is_ue_mme_id_in_list ((mme_ue_s1ap_id_t)id);
+  case LOOKUP_UE_BY_S11_TEID:
+    return s1ap_is_s11_sgw_teid_in_list ((s11_teid_t)id);
+  case LOOKUP_ENB_BY_ENB_ID:
+    return s1ap_is_enb_id_in_list ((uint32_t)id);
+  }
+  return NULL;
+}
+
+static double
+bench_lookup (
+  const char *label,
+  lookup_t type,
+  uint32_t nb_lookups,
+  bool scan)
+{
+  struct timespec                         start;
+  uint32_t                                nb_ues = nb_enbs * nb_ues_per_enb;
+  uint32_t                                nb_missed = 0;
+  double                                  ns;
+
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  for (uint32_t i = 0; i < nb_lookups; i++) {
+    uint64_t                                id;
+
+    switch (type) {
+    case LOOKUP_UE_BY_MME_UE_ID:
+      id = 1 + (uint32_t)(((uint64_t)i * 2654435761u) % nb_ues);
+      break;
+    case LOOKUP_UE_BY_S11_TEID:
+      id = S11_TEID_BASE + 1 + (uint32_t)(((uint64_t)i * 2654435761u) % nb_ues);
+      break;
+    default:
+      id = ENB_ID_BASE + (uint32_t)(((uint64_t)i * 2654435761u) % nb_enbs);
+      break;
+    }
+    if (lookup (type, id, scan) == NULL) {
+      nb_missed++;
+    }
+  }
+  ns = elapsed_ns (&start);
+  printf ("%-22s %-5s %8u lookups (%u missed): %12.0f lookups/s, %12.1f ns/lookup\n", label, scan ? "scan" : "index",
+          nb_lookups, nb_missed, nb_lookups * 1e9 / ns, ns / nb_lookups);
+  return ns / nb_lookups;
+}
+
+static void
+populate (
+  void)
+{
+  struct timespec                         start;
+
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  for (uint32_t e = 0; e < nb_enbs; e++) {
+    enb_description_t                      *enb_ref = s1ap_new_enb ();
+    sctp_assoc_id_t                         assoc_id = e + 1;
+
+    enb_ref->sctp_assoc_id = assoc_id;
+    hashtable_ts_insert (&g_s1ap_enb_coll, (const hash_key_t)assoc_id, (void *)enb_ref);
+    s1ap_set_enb_id (enb_ref, ENB_ID_BASE + e);
+    for (uint32_t u = 0; u < nb_ues_per_enb; u++) {
+      mme_ue_s1ap_id_t                        mme_ue_s1ap_id = e * nb_ues_per_enb + u + 1;
+      ue_description_t                       *ue_ref = s1ap_new_ue (assoc_id, u + 1);
+
+      ue_ref->s1ap_ue_context_rel_timer.id = S1AP_TIMER_INACTIVE_ID;
+      s1ap_notified_new_ue_mme_s1ap_id_association (assoc_id, u + 1, mme_ue_s1ap_id);
+      s1ap_set_ue_s11_sgw_teid (ue_ref, S11_TEID_BASE + mme_ue_s1ap_id);
+    }
+  }
+  printf ("populate %u eNBs x %u UEs: %.3f s\n", nb_enbs, nb_ues_per_enb, elapsed_ns (&start) / 1e9);
+}
+
+static int
+depopulate (
+  void)
+{
+  struct timespec                         start;
+
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  for (uint32_t e = 0; e < nb_enbs; e++) {
+    enb_description_t                      *enb_ref = s1ap_is_enb_assoc_id_in_list (e + 1);
+
+    // removes half of the UEs one by one, the eNB removal takes the others
+    for (uint32_t u = 0; u < nb_ues_per_enb / 2; u++) {
+      s1ap_remove_ue (s1ap_is_ue_enb_id_in_list (enb_ref, u + 1));
+    }
+    s1ap_remove_enb (enb_ref);
+  }
+  printf ("depopulate: %.3f s, left in indexes: %zu eNBs, %zu UEs by mme_ue_s1ap_id, %zu UEs by S11 TEID\n", elapsed_ns (&start) / 1e9,
+          g_s1ap_enb_id_coll.num_elements, g_s1ap_mme_ue_id_coll.num_elements, g_s1ap_s11_teid_coll.num_elements);
+  return (g_s1ap_enb_id_coll.num_elements + g_s1ap_mme_ue_id_coll.num_elements + g_s1ap_s11_teid_coll.num_elements) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+int
+main (
+  int argc,
+  char *argv[])
+{
+  static const struct {
+    const char                             *label;
+    lookup_t                                type;
+  } lookups[] = {
+    {"UE by mme_ue_s1ap_id", LOOKUP_UE_BY_MME_UE_ID},
+    {"UE by S11 SGW TEID", LOOKUP_UE_BY_S11_TEID},
+    {"eNB by eNB id", LOOKUP_ENB_BY_ENB_ID},
+  };
+  uint32_t                                nb_lookups = DEFAULT_NB_LOOKUPS;
+
+  if (argc > 1) {
+    nb_enbs = strtoul (argv[1], NULL, 0);
+  }
+  if (argc > 2) {
+    nb_ues_per_enb = strtoul (argv[2], NULL, 0);
+  }
+  if (argc > 3) {
+    nb_lookups = strtoul (argv[3], NULL, 0);
+  }
+
+  log_init (LOG_MME_ENV, OAILOG_LEVEL_ERROR, 1);
+  mme_config.max_enbs = nb_enbs;
+  mme_config.max_ues = nb_enbs * nb_ues_per_enb;
+  if (s1ap_mme_init_lists () != RETURNok) {
+    fprintf (stderr, "s1ap_mme_init_lists failed\n");
+    return EXIT_FAILURE;
+  }
+
+  populate ();
+  for (int i = 0; i < sizeof (lookups) / sizeof (lookups[0]); i++) {
+    double                                  index_ns = bench_lookup (lookups[i].label, lookups[i].type, nb_lookups, false);
+    double                                  scan_ns = bench_lookup (lookups[i].label, lookups[i].type, nb_lookups / SCAN_LOOKUPS_DIVIDER + 1, true);
+
+    printf ("%-22s speedup x%.0f\n", lookups[i].label, scan_ns / index_ns);
+  }
+  return depopulate ();
+}
@@ -0,0 +1,303 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <netinet/in.h>
+#include <netinet/sctp.h>
+#include <arpa/inet.h>
+
+#include "intertask_interface.h"
+#include "intertask_interface_init.h"
+#include "log.h"
+#include "mme_config.h"
+#include "sctp_primitives_server.h"
+
+/* Load on the SCTP server of the MME: nb_associations local associations
+ * are opened to the SCTP task, TASK_S1AP is replaced by a task echoing every
+ * SCTP_DATA_IND back with a SCTP_DATA_REQ. Each association keeps window
+ * messages in flight until it has received nb_messages echoes, the clients
+ * run in nb_client_threads threads. Gives the throughput and the round trip
+ * latency (receive thread, ITTI, TASK_S1AP, TASK_SCTP and back).
+ * usage: sctp_load_benchmark [nb_associations [nb_messages [nb_receive_threads [window [nb_client_threads]]]]]
+ */
+
+#define DEFAULT_NB_ASSOCIATIONS    200
+#define DEFAULT_NB_MESSAGES        1000
+#define DEFAULT_WINDOW             1
+#define DEFAULT_NB_CLIENT_THREADS  2
+#define BENCHMARK_PORT             36462
+#define MESSAGE_SIZE               128
+#define MAX_EVENTS                 64
+
+typedef struct client_s {
+  int                                     sd;
+  uint32_t                                nb_sent;
+  uint32_t                                nb_received;
+} client_t;
+
+typedef struct client_thread_s {
+  pthread_t                               thread;
+  int                                     epoll_fd;
+  client_t                               *clients;
+  uint32_t                                nb_clients;
+  double                                 *latencies_ns;
+  uint64_t                                nb_latencies;
+} client_thread_t;
+
+static uint32_t                         nb_associations = DEFAULT_NB_ASSOCIATIONS;
+static uint32_t                         nb_messages = DEFAULT_NB_MESSAGES;
+static uint32_t                         window = DEFAULT_WINDOW;
+static volatile uint32_t                nb_new_associations;
+
+static uint64_t
+now_ns (
+  void)
+{
+  struct timespec                         ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void                            *
+echo_task (
+  __attribute__((unused)) void *args_p)
+{
+  itti_mark_task_ready (TASK_S1AP);
+
+  while (1) {
+    MessageDef                             *received_message_p = NULL;
+
+    itti_receive_msg (TASK_S1AP, &received_message_p);
+
+    switch (ITTI_MSG_ID (received_message_p)) {
+    case SCTP_NEW_ASSOCIATION:
+      __sync_fetch_and_add (&nb_new_associations, 1);
+      break;
+
+    case SCTP_DATA_IND:{
+        MessageDef                             *message_p = itti_alloc_new_message (TASK_S1AP, SCTP_DATA_REQ);
+
+        SCTP_DATA_REQ (message_p).payload = SCTP_DATA_IND (received_message_p).payload;
+        SCTP_DATA_IND (received_message_p).payload = NULL;
+        SCTP_DATA_REQ (message_p).assoc_id = SCTP_DATA_IND (received_message_p).assoc_id;
+        SCTP_DATA_REQ (message_p).stream = SCTP_DATA_IND (received_message_p).stream;
+        SCTP_DATA_REQ (message_p).mme_ue_s1ap_id = INVALID_MME_UE_S1AP_ID;
+        itti_send_msg_to_task (TASK_SCTP, INSTANCE_DEFAULT, message_p);
+      }
+      break;
+
+    default:
+      break;
+    }
+    itti_free (ITTI_MSG_ORIGIN_ID (received_message_p), received_message_p);
+  }
+  return NULL;
+}
+
+static int
+send_timestamp (
+  client_t * client)
+{
+  uint8_t                                 message[MESSAGE_SIZE] = {0};
+  uint64_t                                timestamp = now_ns ();
+
+  memcpy (message, &timestamp, sizeof (timestamp));
+  if (sctp_sendmsg (client->sd, message, sizeof (message), NULL, 0, htonl (S1AP_SCTP_PPID), 0, 1, 0, 0) < 0) {
+    fprintf (stderr, "sctp_sendmsg: %s\n", strerror (errno));
+    return -1;
+  }
+  client->nb_sent++;
+  return 0;
+}
+
+static void                            *
+client_thread (
+  void *args_p)
+{
+  client_thread_t                        *thread = (client_thread_t *)args_p;
+  struct epoll_event                      events[MAX_EVENTS];
+  uint32_t                                nb_done = 0;
+
+  for (uint32_t i = 0; i < thread->nb_clients; i++) {
+    for (uint32_t j = 0; (j < window) && (j < nb_messages); j++) {
+      send_timestamp (&thread->clients[i]);
+    }
+  }
+
+  while (nb_done < thread->nb_clients) {
+    int                                     nb_events = epoll_wait (thread->epoll_fd, events, MAX_EVENTS, 1000);
+
+    if (nb_events <= 0) {
+      fprintf (stderr, "epoll_wait: %s\n", nb_events ? strerror (errno) : "timeout, messages lost");
+      break;
+    }
+
+    for (int i = 0; i < nb_events; i++) {
+      client_t                               *client = (client_t *)events[i].data.ptr;
+      uint8_t                                 message[MESSAGE_SIZE];
+      uint64_t                                timestamp;
+      struct sctp_sndrcvinfo                  sinfo = {0};
+      int                                     flags = 0;
+
+      if (sctp_recvmsg (client->sd, message, sizeof (message), NULL, NULL, &sinfo, &flags) < (int)sizeof (timestamp)) {
+        continue;
+      }
+      memcpy (&timestamp, message, sizeof (timestamp));
+      thread->latencies_ns[thread->nb_latencies++] = (double)(now_ns () - timestamp);
+      client->nb_received++;
+      if (client->nb_sent < nb_messages) {
+        send_timestamp (client);
+      } else if (client->nb_received == nb_messages) {
+        nb_done++;
+      }
+    }
+  }
+  return NULL;
+}
+
+static int
+connect_client (
+  client_t * client,
+  int epoll_fd)
+{
+  struct sockaddr_in                      addr = {0};
+  struct epoll_event                      event = {0};
+
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons (BENCHMARK_PORT);
+  addr.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+
+  if ((client->sd = socket (AF_INET, SOCK_STREAM, IPPROTO_SCTP)) < 0) {
+    fprintf (stderr, "socket: %s\n", strerror (errno));
+    return -1;
+  }
+  // the listener is created by TASK_SCTP, retry until it is up
+  for (int retry = 0; connect (client->sd, (struct sockaddr *)&addr, sizeof (addr)) < 0; retry++) {
+    if (retry == 100) {
+      fprintf (stderr, "connect: %s\n", strerror (errno));
+      return -1;
+    }
+    usleep (10000);
+  }
+  event.events = EPOLLIN;
+  event.data.ptr = client;
+  return epoll_ctl (epoll_fd, EPOLL_CTL_ADD, client->sd, &event);
+}
+
+static int
+compare_double (
+  const void *a,
+  const void *b)
+{
+  double                                  x = *(const double *)a;
+  double                                  y = *(const double *)b;
+
+  return (x > y) - (x < y);
+}
+
+int
+main (
+  int argc,
+  char *argv[])
+{
+  uint32_t                                nb_receive_threads = SCTP_RECEIVE_THREADS;
+  uint32_t                                nb_client_threads = DEFAULT_NB_CLIENT_THREADS;
+  client_thread_t                        *threads;
+  client_t                               *clients;
+  double                                 *latencies_ns;
+  uint64_t                                nb_latencies = 0;
+  uint64_t                                start;
+  double                                  ns,
+                                          sum = 0;
+  MessageDef                             *message_p;
+
+  if (argc > 1) {
+    nb_associations = strtoul (argv[1], NULL, 0);
+  }
+  if (argc > 2) {
+    nb_messages = strtoul (argv[2], NULL, 0);
+  }
+  if (argc > 3) {
+    nb_receive_threads = strtoul (argv[3], NULL, 0);
+  }
+  if (argc > 4) {
+    window = strtoul (argv[4], NULL, 0);
+  }
+  if (argc > 5) {
+    nb_client_threads = strtoul (argv[5], NULL, 0);
+  }
+  if (nb_client_threads > nb_associations) {
+    nb_client_threads = nb_associations;
+  }
+
+  log_init (LOG_MME_ENV, OAILOG_LEVEL_ERROR, 1);
+  itti_init (TASK_MAX, THREAD_MAX, MESSAGES_ID_MAX, tasks_info, messages_info, NULL, NULL);
+  mme_config.max_enbs = nb_associations;
+  mme_config.sctp_config.in_streams = SCTP_IN_STREAMS;
+  mme_config.sctp_config.out_streams = SCTP_OUT_STREAMS;
+  mme_config.sctp_config.nb_receive_threads = nb_receive_threads;
+  if ((sctp_init (&mme_config) < 0) || (itti_create_task (TASK_S1AP, &echo_task, NULL) < 0)) {
+    fprintf (stderr, "SCTP task initialization failed\n");
+    return EXIT_FAILURE;
+  }
+  message_p = itti_alloc_new_message (TASK_S1AP, SCTP_INIT_MSG);
+  SCTP_INIT_MSG (message_p).port = BENCHMARK_PORT;
+  SCTP_INIT_MSG (message_p).ppid = S1AP_SCTP_PPID;
+  SCTP_INIT_MSG (message_p).ipv4 = 1;
+  SCTP_INIT_MSG (message_p).nb_ipv4_addr = 1;
+  SCTP_INIT_MSG (message_p).ipv4_address[0] = htonl (INADDR_LOOPBACK);
+  itti_send_msg_to_task (TASK_SCTP, INSTANCE_DEFAULT, message_p);
+
+  clients = calloc (nb_associations, sizeof (client_t));
+  threads = calloc (nb_client_threads, sizeof (client_thread_t));
+  latencies_ns = calloc ((uint64_t)nb_associations * nb_messages, sizeof (double));
+  start = now_ns ();
+  for (uint32_t t = 0, first = 0; t < nb_client_threads; t++) {
+    threads[t].clients = &clients[first];
+    threads[t].nb_clients = (nb_associations - first) / (nb_client_threads - t);
+    threads[t].latencies_ns = &latencies_ns[(uint64_t)first * nb_messages];
+    threads[t].epoll_fd = epoll_create1 (0);
+    for (uint32_t i = 0; i < threads[t].nb_clients; i++) {
+      if (connect_client (&threads[t].clients[i], threads[t].epoll_fd) < 0) {
+        return EXIT_FAILURE;
+      }
+    }
+    first += threads[t].nb_clients;
+  }
+  while (nb_new_associations < nb_associations) {
+    sched_yield ();
+  }
+  printf ("%u associations up in %.3f s\n", nb_associations, (now_ns () - start) / 1e9);
+
+  start = now_ns ();
+  for (uint32_t t = 0; t < nb_client_threads; t++) {
+    pthread_create (&threads[t].thread, NULL, client_thread, &threads[t]);
+  }
+  for (uint32_t t = 0; t < nb_client_threads; t++) {
+    pthread_join (threads[t].thread, NULL);
+    // compact the latencies of the threads
+    memmove (&latencies_ns[nb_latencies], threads[t].latencies_ns, threads[t].nb_latencies * sizeof (double));
+    nb_latencies += threads[t].nb_latencies;
+  }
+  ns = (double)(now_ns () - start);
+
+  qsort (latencies_ns, nb_latencies, sizeof (double), compare_double);
+  for (uint64_t i = 0; i < nb_latencies; i++) {
+    sum += latencies_ns[i];
+  }
+  printf ("%u associations, %u receive threads, window %u: %lu/%lu messages, %10.0f msg/s\n", nb_associations, nb_receive_threads, window,
+          nb_latencies, (uint64_t)nb_associations * nb_messages, nb_latencies * 1e9 / ns);
+  if (nb_latencies) {
+    printf ("latency: mean %8.1f us, p50 %8.1f us, p99 %8.1f us, max %8.1f us\n", sum / nb_latencies / 1e3,
+            latencies_ns[nb_latencies / 2] / 1e3, latencies_ns[nb_latencies * 99 / 100] / 1e3, latencies_ns[nb_latencies - 1] / 1e3);
+  }
+  return (nb_latencies == (uint64_t)nb_associations * nb_messages) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
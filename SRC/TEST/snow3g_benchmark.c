@@ -0,0 +1,106 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "secu_defs.h"
+#include "snow3g.h"
+
+/* Cost of the SNOW 3G keystream generation and of 128-EEA1/128-EIA1 on NAS
+ * sized messages, in cycles/byte (time stamp counter, x86 only) and ns/byte.
+ * usage: snow3g_benchmark [nb_iterations]
+ */
+
+#define DEFAULT_NB_ITERATIONS (100 * 1000)
+#define MAX_MESSAGE_SIZE      1500
+
+typedef enum {
+  BENCH_KEY_STREAM,
+  BENCH_EEA1,
+  BENCH_EIA1,
+} bench_algo_t;
+
+static inline uint64_t
+cycles (
+  void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc ();
+#else
+  return 0;
+#endif
+}
+
+static void
+bench (
+  const char *label,
+  bench_algo_t algo,
+  uint32_t size,
+  uint32_t nb_iterations)
+{
+  static uint8_t                          key[16] = {0x2b, 0xd6, 0x45, 0x9f, 0x82, 0xc5, 0xb3, 0x00, 0x95, 0x2c, 0x49, 0x10, 0x48, 0x81, 0xff, 0x48};
+  uint8_t                                 message[MAX_MESSAGE_SIZE + 4] = {0};
+  uint8_t                                 out[MAX_MESSAGE_SIZE + 4];
+  uint32_t                                key_stream[(MAX_MESSAGE_SIZE + 3) / 4];
+  uint32_t                                k[4] = {0x2bd6459f, 0x82c5b300, 0x952c4910, 0x4881ff48};
+  uint32_t                                iv[4] = {0x72a4f20f, 0x64000000, 0x72a4f20f, 0x64000000};
+  snow_3g_context_t                       snow_3g_context;
+  nas_stream_cipher_t                     stream_cipher = {.key = key, .key_length = 16, .bearer = 0, .direction = 0, .message = message};
+  struct timespec                         start, end;
+  uint64_t                                start_cycles;
+  double                                  ns;
+  double                                  nb_cycles;
+
+  stream_cipher.blength = size * 8;
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  start_cycles = cycles ();
+  for (uint32_t i = 0; i < nb_iterations; i++) {
+    stream_cipher.count = i;
+    switch (algo) {
+    case BENCH_KEY_STREAM:
+      iv[0] = i;
+      snow3g_initialize (k, iv, &snow_3g_context);
+      snow3g_generate_key_stream ((size + 3) / 4, key_stream, &snow_3g_context);
+      break;
+    case BENCH_EEA1:
+      nas_stream_encrypt_eea1 (&stream_cipher, out);
+      break;
+    case BENCH_EIA1:
+      nas_stream_encrypt_eia1 (&stream_cipher, out);
+      break;
+    }
+  }
+  nb_cycles = (double)(cycles () - start_cycles);
+  clock_gettime (CLOCK_MONOTONIC, &end);
+  ns = (double)(end.tv_sec - start.tv_sec) * 1e9 + (double)(end.tv_nsec - start.tv_nsec);
+  printf ("%-10s %5u bytes: %8.1f cycles/byte, %7.2f ns/byte, %9.1f ns/message\n", label, size,
+          nb_cycles / ((double)nb_iterations * size), ns / ((double)nb_iterations * size), ns / nb_iterations);
+}
+
+int
+main (
+  int argc,
+  char *argv[])
+{
+  uint32_t                                nb_iterations = DEFAULT_NB_ITERATIONS;
+  uint32_t                                sizes[] = {16, 64, 256, MAX_MESSAGE_SIZE};
+
+  if (argc > 1) {
+    nb_iterations = strtoul (argv[1], NULL, 0);
+  }
+
+  for (int i = 0; i < sizeof (sizes) / sizeof (sizes[0]); i++) {
+    bench ("key stream", BENCH_KEY_STREAM, sizes[i], nb_iterations);
+  }
+  for (int i = 0; i < sizeof (sizes) / sizeof (sizes[0]); i++) {
+    bench ("128-EEA1", BENCH_EEA1, sizes[i], nb_iterations);
+  }
+  for (int i = 0; i < sizeof (sizes) / sizeof (sizes[0]); i++) {
+    bench ("128-EIA1", BENCH_EIA1, sizes[i], nb_iterations);
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,277 @@
+#include <check.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <arpa/inet.h>
+
+#include "bstrlib.h"
+#include "log.h"
+#include "NwGtpv2c.h"
+#include "NwGtpv2cIe.h"
+#include "NwGtpv2cMsg.h"
+#include "NwGtpv2cMsgParser.h"
+#include "NwGtpv2cPrivate.h"
+#include "sgw_ie_defs.h"
+#include "s11_messages_types.h"
+#include "s11_common.h"
+#include "s11_ie_formatter.h"
+
+/* GTPv2-C message buffers: a message starts in the smallest buffer size
+ * class and moves to larger ones as IEs are appended, up to the UDP payload
+ * limit. A Create Session Request with the maximum number of bearer contexts,
+ * each with IPv4v6 F-TEIDs, and a full PCO is larger than 1 KB; it is encoded
+ * with the S11 IE formatters, read back as received and parsed.
+ */
+
+#define NB_PCO_CONTAINERS  4
+#define PCO_CONTAINER_LEN  50
+
+static NwGtpv2cStackHandleT             stack;
+
+static const NwGtpv2cMsgParserIeInfoT   create_session_request_ie_info_tbl[] = {
+  {NW_GTPV2C_IE_IMSI, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL, s11_imsi_ie_get, offsetof (itti_s11_create_session_request_t, imsi)},
+  {NW_GTPV2C_IE_RAT_TYPE, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_MANDATORY, s11_rat_type_ie_get, offsetof (itti_s11_create_session_request_t, rat_type)},
+  {NW_GTPV2C_IE_APN, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_MANDATORY, s11_apn_ie_get, offsetof (itti_s11_create_session_request_t, apn)},
+  {NW_GTPV2C_IE_FTEID, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_MANDATORY, s11_fteid_ie_get, offsetof (itti_s11_create_session_request_t, sender_fteid_for_cp)},
+  {NW_GTPV2C_IE_BEARER_CONTEXT, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_MANDATORY, s11_bearer_context_to_be_created_ie_get, offsetof (itti_s11_create_session_request_t, bearer_contexts_to_be_created)},
+  {NW_GTPV2C_IE_PCO, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL, s11_pco_ie_get, offsetof (itti_s11_create_session_request_t, pco)},
+  {0}
+};
+
+/* Writes the header as the stack does when it sends the message, then reads it back as received */
+static NwGtpv2cMsgHandleT
+receive (
+  NwGtpv2cMsgHandleT hMsg)
+{
+  NwGtpv2cMsgT                           *pMsg = (NwGtpv2cMsgT *) hMsg;
+  NwGtpv2cMsgHandleT                      hRxMsg = 0;
+  uint8_t                                *hdr = pMsg->msgBuf;
+
+  hdr[0] = (pMsg->version << 5) | (pMsg->teidPresent << 3);
+  hdr[1] = pMsg->msgType;
+  *((uint16_t *) & hdr[2]) = htons (pMsg->msgLen - 4);
+  *((uint32_t *) & hdr[4]) = htonl (pMsg->teid);
+  *((uint32_t *) & hdr[8]) = htonl (pMsg->seqNum << 8);
+  ck_assert_int_eq (nwGtpv2cMsgFromBufferNew (stack, pMsg->msgBuf, pMsg->msgLen, &hRxMsg), NW_OK);
+  return hRxMsg;
+}
+
+static void
+fill_request (
+  itti_s11_create_session_request_t * request)
+{
+  memset (request, 0, sizeof (*request));
+  request->imsi.length = 15;
+  for (int d = 0; d < 15; d++) {
+    request->imsi.digit[d] = '0' + (d % 10);
+  }
+  request->rat_type = RAT_EUTRAN;
+  strcpy (request->apn, "a.very.long.access.point.name.to.check.the.apn.encoded.in.place.mnc093.mcc208.gprs");
+  request->sender_fteid_for_cp.ipv4 = 1;
+  request->sender_fteid_for_cp.interface_type = S11_MME_GTP_C;
+  request->sender_fteid_for_cp.teid = 0x12345678;
+  request->sender_fteid_for_cp.ipv4_address = 0x010AA8C0;
+  request->pco.ext = 1;
+  request->pco.num_protocol_or_container_id = NB_PCO_CONTAINERS;
+  for (int i = 0; i < NB_PCO_CONTAINERS; i++) {
+    uint8_t                                 contents[PCO_CONTAINER_LEN];
+
+    memset (contents, 'a' + i, sizeof (contents));
+    request->pco.protocol_or_container_ids[i].id = 0xC021 + i;
+    request->pco.protocol_or_container_ids[i].length = PCO_CONTAINER_LEN;
+    request->pco.protocol_or_container_ids[i].contents = blk2bstr (contents, PCO_CONTAINER_LEN);
+  }
+  request->bearer_contexts_to_be_created.num_bearer_context = MSG_CREATE_SESSION_REQUEST_MAX_BEARER_CONTEXTS;
+  for (int i = 0; i < MSG_CREATE_SESSION_REQUEST_MAX_BEARER_CONTEXTS; i++) {
+    bearer_context_to_be_created_t         *bearer = &request->bearer_contexts_to_be_created.bearer_contexts[i];
+
+    bearer->eps_bearer_id = 5 + i;
+    bearer->bearer_level_qos.qci = 1 + (i % 9);
+    bearer->s1u_enb_fteid.ipv4 = 1;
+    bearer->s1u_enb_fteid.ipv6 = 1;
+    bearer->s1u_enb_fteid.interface_type = S1_U_ENODEB_GTP_U;
+    bearer->s1u_enb_fteid.teid = 0x1000 + i;
+    bearer->s1u_enb_fteid.ipv4_address = 0x020AA8C0;
+    memset (bearer->s1u_enb_fteid.ipv6_address, 0x20 + i, 16);
+  }
+}
+
+START_TEST(gtpv2c_msg_multi_bearer_test)
+{
+  itti_s11_create_session_request_t       request;
+  itti_s11_create_session_request_t       parsed;
+  NwGtpv2cMsgParserInfoT                  parser_info;
+  NwGtpv2cMsgHandleT                      hMsg = 0;
+  NwGtpv2cMsgHandleT                      hRxMsg;
+  uint8_t                                 ipv6_address[16];
+  uint8_t                                 offendingIeType,
+                                          offendingIeInstance;
+  uint16_t                                offendingIeLength;
+
+  fill_request (&request);
+  ck_assert_int_eq (nwGtpv2cMsgNew (stack, NW_TRUE, NW_GTP_CREATE_SESSION_REQ, 0, 1, &hMsg), NW_OK);
+  ck_assert_uint_eq (((NwGtpv2cMsgT *) hMsg)->msgBufSize, NW_GTPV2C_MSG_BUF_MIN_SIZE);
+  s11_imsi_ie_set (&hMsg, &request.imsi);
+  s11_rat_type_ie_set (&hMsg, &request.rat_type);
+  s11_fteid_ie_set (&hMsg, &request.sender_fteid_for_cp);
+  s11_apn_ie_set (&hMsg, request.apn);
+  s11_pco_ie_set (&hMsg, &request.pco);
+  for (int i = 0; i < MSG_CREATE_SESSION_REQUEST_MAX_BEARER_CONTEXTS; i++) {
+    bearer_context_to_be_created_t         *bearer = &request.bearer_contexts_to_be_created.bearer_contexts[i];
+
+    // the bearer contexts to be created with their S1-U eNB and S5/S8-U PGW F-TEIDs
+    ck_assert_int_eq (nwGtpv2cMsgGroupedIeStart (hMsg, NW_GTPV2C_IE_BEARER_CONTEXT, NW_GTPV2C_IE_INSTANCE_ZERO), NW_OK);
+    s11_ebi_ie_set (&hMsg, bearer->eps_bearer_id);
+    s11_bearer_qos_ie_set (&hMsg, &bearer->bearer_level_qos);
+    s11_fteid_ie_set (&hMsg, &bearer->s1u_enb_fteid);
+    memset (ipv6_address, 0x40 + i, sizeof (ipv6_address));
+    ck_assert_int_eq (nwGtpv2cMsgAddIeFteid (hMsg, NW_GTPV2C_IE_INSTANCE_THREE, S5_S8_PGW_GTP_U, 0x2000 + i, 0xC0A80A03, ipv6_address), NW_OK);
+    ck_assert_int_eq (nwGtpv2cMsgGroupedIeEnd (hMsg), NW_OK);
+  }
+  ck_assert_uint_gt (nwGtpv2cMsgGetLength (hMsg), 1024);
+  ck_assert_uint_ge (((NwGtpv2cMsgT *) hMsg)->msgBufSize, nwGtpv2cMsgGetLength (hMsg));
+
+  hRxMsg = receive (hMsg);
+  ck_assert_uint_eq (nwGtpv2cMsgGetLength (hRxMsg), nwGtpv2cMsgGetLength (hMsg));
+  ck_assert_int_eq (memcmp (((NwGtpv2cMsgT *) hRxMsg)->msgBuf, ((NwGtpv2cMsgT *) hMsg)->msgBuf, nwGtpv2cMsgGetLength (hMsg)), 0);
+  ck_assert_int_eq (nwGtpv2cMsgParserInfoInit (&parser_info, NW_GTP_CREATE_SESSION_REQ, s11_ie_indication_generic, create_session_request_ie_info_tbl), NW_OK);
+  memset (&parsed, 0, sizeof (parsed));
+  ck_assert_int_eq (nwGtpv2cMsgParserInfoRun (&parser_info, hRxMsg, &parsed, &offendingIeType, &offendingIeInstance, &offendingIeLength), NW_OK);
+
+  ck_assert_int_eq (memcmp (parsed.imsi.digit, request.imsi.digit, 15), 0);
+  ck_assert_str_eq (parsed.apn, request.apn);
+  ck_assert_uint_eq (parsed.sender_fteid_for_cp.teid, request.sender_fteid_for_cp.teid);
+  ck_assert_uint_eq (parsed.pco.num_protocol_or_container_id, NB_PCO_CONTAINERS);
+  for (int i = 0; i < NB_PCO_CONTAINERS; i++) {
+    ck_assert_int_eq (biseq (parsed.pco.protocol_or_container_ids[i].contents, request.pco.protocol_or_container_ids[i].contents), 1);
+  }
+  ck_assert_uint_eq (parsed.bearer_contexts_to_be_created.num_bearer_context, MSG_CREATE_SESSION_REQUEST_MAX_BEARER_CONTEXTS);
+  for (int i = 0; i < MSG_CREATE_SESSION_REQUEST_MAX_BEARER_CONTEXTS; i++) {
+    bearer_context_to_be_created_t         *bearer = &parsed.bearer_contexts_to_be_created.bearer_contexts[i];
+
+    ck_assert_uint_eq (bearer->eps_bearer_id, 5 + i);
+    ck_assert_uint_eq (bearer->bearer_level_qos.qci, 1 + (i % 9));
+    ck_assert_uint_eq (bearer->s1u_enb_fteid.teid, 0x1000 + i);
+    ck_assert_uint_eq (bearer->s1u_enb_fteid.ipv4_address, 0x020AA8C0);
+    ck_assert_int_eq (memcmp (bearer->s1u_enb_fteid.ipv6_address, request.bearer_contexts_to_be_created.bearer_contexts[i].s1u_enb_fteid.ipv6_address, 16), 0);
+    ck_assert_uint_eq (bearer->s5_s8_u_pgw_fteid.teid, 0x2000 + i);
+  }
+  clear_protocol_configuration_options (&request.pco);
+  clear_protocol_configuration_options (&parsed.pco);
+  nwGtpv2cMsgDelete (stack, hRxMsg);
+  nwGtpv2cMsgDelete (stack, hMsg);
+}
+END_TEST
+
+START_TEST(gtpv2c_msg_size_class_test)
+{
+  NwGtpv2cMsgHandleT                      hMsg = 0;
+  NwGtpv2cMsgHandleT                      hRxMsg;
+  uint8_t                                 value[1000];
+  uint32_t                                bufSize = NW_GTPV2C_MSG_BUF_MIN_SIZE;
+  uint32_t                                nb_ies = 0;
+  NwGtpv2cIeTlvT                         *pIe;
+
+  /*
+   * A grouped IE is open while its message moves through all the size classes
+   */
+  memset (value, 0x5A, sizeof (value));
+  ck_assert_int_eq (nwGtpv2cMsgNew (stack, NW_TRUE, NW_GTP_CREATE_SESSION_REQ, 0, 2, &hMsg), NW_OK);
+  ck_assert_int_eq (nwGtpv2cMsgGroupedIeStart (hMsg, NW_GTPV2C_IE_BEARER_CONTEXT, NW_GTPV2C_IE_INSTANCE_ZERO), NW_OK);
+  while (nwGtpv2cMsgAddIe (hMsg, NW_GTPV2C_IE_PRIVATE_EXTENSION, sizeof (value), 0, value) == NW_OK) {
+    nb_ies++;
+    ck_assert_uint_ge (((NwGtpv2cMsgT *) hMsg)->msgBufSize, bufSize);
+    bufSize = ((NwGtpv2cMsgT *) hMsg)->msgBufSize;
+    ck_assert_uint_ge (bufSize, nwGtpv2cMsgGetLength (hMsg));
+  }
+  ck_assert_uint_eq (bufSize, NW_GTPV2C_MSG_BUF_SIZE (NW_GTPV2C_MSG_BUF_CLASSES - 1));
+  // the IE which did not fit was not added
+  ck_assert_uint_eq (nwGtpv2cMsgGetLength (hMsg), NW_GTPV2C_EPC_SPECIFIC_HEADER_SIZE + 4 + nb_ies * (4 + sizeof (value)));
+  ck_assert_uint_gt (nwGtpv2cMsgGetLength (hMsg) + 4 + sizeof (value), NW_GTPV2C_MAX_MSG_LEN);
+  ck_assert_int_eq (nwGtpv2cMsgGroupedIeEnd (hMsg), NW_OK);
+  pIe = (NwGtpv2cIeTlvT *) (((NwGtpv2cMsgT *) hMsg)->msgBuf + NW_GTPV2C_EPC_SPECIFIC_HEADER_SIZE);
+  ck_assert_uint_eq (pIe->t, NW_GTPV2C_IE_BEARER_CONTEXT);
+  ck_assert_uint_eq (ntohs (pIe->l), nb_ies * (4 + sizeof (value)));
+
+  /*
+   * A received message gets a buffer of its size class, larger ones are rejected
+   */
+  hRxMsg = receive (hMsg);
+  ck_assert_uint_eq (((NwGtpv2cMsgT *) hRxMsg)->msgBufSize, bufSize);
+  nwGtpv2cMsgDelete (stack, hRxMsg);
+  ck_assert_int_ne (nwGtpv2cMsgFromBufferNew (stack, ((NwGtpv2cMsgT *) hMsg)->msgBuf, NW_GTPV2C_MAX_MSG_LEN + 1, &hRxMsg), NW_OK);
+  ck_assert_int_eq (nwGtpv2cMsgFromBufferNew (stack, ((NwGtpv2cMsgT *) hMsg)->msgBuf, 100, &hRxMsg), NW_OK);
+  ck_assert_uint_eq (((NwGtpv2cMsgT *) hRxMsg)->msgBufSize, NW_GTPV2C_MSG_BUF_MIN_SIZE);
+  nwGtpv2cMsgDelete (stack, hRxMsg);
+  nwGtpv2cMsgDelete (stack, hMsg);
+}
+END_TEST
+
+START_TEST(gtpv2c_msg_pool_test)
+{
+  NwGtpv2cMsgHandleT                      hMsg = 0;
+  uint8_t                                *pBuf;
+
+  /*
+   * The buffers of the deleted messages are reused by their size class
+   */
+  ck_assert_int_eq (nwGtpv2cMsgNew (stack, NW_FALSE, NW_GTP_ECHO_REQ, 0, 3, &hMsg), NW_OK);
+  pBuf = ((NwGtpv2cMsgT *) hMsg)->msgBuf;
+  nwGtpv2cMsgDelete (stack, hMsg);
+  ck_assert_int_eq (nwGtpv2cMsgNew (stack, NW_FALSE, NW_GTP_ECHO_REQ, 0, 4, &hMsg), NW_OK);
+  ck_assert_ptr_eq (((NwGtpv2cMsgT *) hMsg)->msgBuf, pBuf);
+  ck_assert_int_eq (nwGtpv2cMsgAddIeTV1 (hMsg, NW_GTPV2C_IE_RECOVERY, 0, 1), NW_OK);
+  ck_assert_uint_eq (nwGtpv2cMsgGetLength (hMsg), NW_GTPV2C_EPC_SPECIFIC_HEADER_SIZE - 4 + 5);
+  nwGtpv2cMsgDelete (stack, hMsg);
+}
+END_TEST
+
+static void
+setup (
+  void)
+{
+  ck_assert_int_eq (nwGtpv2cInitialize (&stack), NW_OK);
+}
+
+static void
+teardown (
+  void)
+{
+  nwGtpv2cFinalize (stack);
+}
+
+Suite * gtpv2c_msg_suite(void)
+{
+    Suite *s;
+    TCase *tc_core;
+
+    s = suite_create("GTPv2-C message");
+
+    tc_core = tcase_create("GTPv2-C message buffer test");
+    tcase_add_checked_fixture(tc_core, setup, teardown);
+    tcase_add_test(tc_core, gtpv2c_msg_multi_bearer_test);
+    tcase_add_test(tc_core, gtpv2c_msg_size_class_test);
+    tcase_add_test(tc_core, gtpv2c_msg_pool_test);
+
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
+
+int main(void)
+{
+    int number_failed;
+    Suite *s;
+    SRunner *sr;
+
+    log_init (LOG_MME_ENV, OAILOG_LEVEL_ERROR, 1);
+    s = gtpv2c_msg_suite();
+    sr = srunner_create(s);
+
+    srunner_run_all(sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,288 @@
+#include <check.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "bstrlib.h"
+#include "log.h"
+#include "intertask_interface.h"
+#include "intertask_interface_init.h"
+#include "TLVDecoder.h"
+#include "nas_message.h"
+#include "emm_msg.h"
+#include "esm_msg.h"
+#include "nas_test_util.h"
+
+/* Per-message decode arena of the NAS codecs: the variable length IEs, and
+ * the deciphered copy of a security protected message, are allocated from
+ * the arena instead of the heap. The heap allocations made by the decoding
+ * thread are counted by nas_test_util; the same message is decoded with and
+ * without an arena, the difference is the allocations of its IEs.
+ */
+
+#define ESM_CONTAINER_LARGE_LEN 3000
+
+/* Integrity protected attach complete, activate default EPS bearer context accept */
+static const uint8_t                    protected_attach_complete[] = {
+  0x17, 0x11, 0x22, 0x33, 0x44, 0x01,
+  0x07, 0x43, 0x00, 0x03, 0x52, 0x00, 0xc2
+};
+
+static const nas_pdu_t                 *pdn_connectivity_request = NULL;
+static const nas_pdu_t                 *authentication_response = NULL;
+static const nas_pdu_t                 *attach_request = NULL;
+static uint8_t                          large_attach_request[ESM_CONTAINER_LARGE_LEN + 32];
+static int                              large_attach_request_len = 0;
+
+/* Decodes a NAS message, returns the heap allocations made by the decoder */
+static int
+decode (
+  const uint8_t * pdu,
+  const int len,
+  nas_message_t * msg,
+  tlv_decode_arena_t * arena)
+{
+  nas_message_decode_status_t             status = {0};
+  uint64_t                                allocs = 0;
+  int                                     rc = 0;
+
+  memset (msg, 0, sizeof (*msg));
+  allocs = nas_test_nb_allocs;
+  rc = nas_message_decode (pdu, msg, len, NULL, &status, arena);
+  allocs = nas_test_nb_allocs - allocs;
+  ck_assert_int_gt (rc, 0);
+  return allocs;
+}
+
+static int
+decode_esm (
+  const uint8_t * pdu,
+  const int len,
+  ESM_msg * msg,
+  tlv_decode_arena_t * arena)
+{
+  uint64_t                                allocs = 0;
+  int                                     rc = 0;
+
+  memset (msg, 0, sizeof (*msg));
+  allocs = nas_test_nb_allocs;
+  rc = esm_msg_decode (msg, (uint8_t *) pdu, len, arena);
+  allocs = nas_test_nb_allocs - allocs;
+  ck_assert_int_eq (rc, len);
+  return allocs;
+}
+
+static void
+ck_assert_in_arena (
+  const_bstring b,
+  const tlv_decode_arena_t * arena)
+{
+  ck_assert_ptr_ne (b, NULL);
+  ck_assert ((const uint8_t *)b >= arena->block);
+  ck_assert ((const uint8_t *)b < (arena->block + TLV_DECODE_ARENA_BLOCK_SIZE));
+  ck_assert (biswriteprotected (*b));
+  ck_assert_int_eq (bdestroy ((bstring) b), BSTR_ERR);
+}
+
+START_TEST (nas_decode_arena_esm_test)
+{
+  tlv_decode_arena_t                      arena;
+  ESM_msg                                 heap_msg;
+  ESM_msg                                 msg;
+  pdn_connectivity_request_msg           *pdn = &msg.pdn_connectivity_request;
+  int                                     heap_allocs = 0;
+  int                                     arena_allocs = 0;
+
+  tlv_decode_arena_init (&arena);
+  heap_allocs = decode_esm (pdn_connectivity_request->buffer, pdn_connectivity_request->buf_len, &heap_msg, NULL);
+  arena_allocs = decode_esm (pdn_connectivity_request->buffer, pdn_connectivity_request->buf_len, &msg, &arena);
+  /*
+   * APN and IPCP container, the empty containers are not allocated
+   */
+  ck_assert_int_eq (heap_allocs - arena_allocs, 2 * 2);
+  ck_assert_uint_eq (arena.nb_chunks, 0);
+  ck_assert_int_eq (pdn->protocolconfigurationoptions.num_protocol_or_container_id, 3);
+  ck_assert_in_arena (pdn->accesspointname, &arena);
+  ck_assert_in_arena (pdn->protocolconfigurationoptions.protocol_or_container_ids[0].contents, &arena);
+  ck_assert_int_eq (biseq (pdn->accesspointname, heap_msg.pdn_connectivity_request.accesspointname), 1);
+  ck_assert_int_eq (biseq (pdn->protocolconfigurationoptions.protocol_or_container_ids[0].contents,
+                           heap_msg.pdn_connectivity_request.protocolconfigurationoptions.protocol_or_container_ids[0].contents), 1);
+  ck_assert_int_eq (pdn->accesspointname->data[blength (pdn->accesspointname)], '\0');
+  /*
+   * A consumer keeping an IE copies it
+   */
+  bstring apn = bstrcpy (pdn->accesspointname);
+
+  tlv_decode_arena_release (&arena);
+  ck_assert_int_eq (biseq (apn, heap_msg.pdn_connectivity_request.accesspointname), 1);
+  bdestroy (apn);
+  bdestroy (heap_msg.pdn_connectivity_request.accesspointname);
+  bdestroy (heap_msg.pdn_connectivity_request.protocolconfigurationoptions.protocol_or_container_ids[0].contents);
+}
+END_TEST
+
+START_TEST (nas_decode_arena_emm_test)
+{
+  tlv_decode_arena_t                      arena;
+  nas_message_t                           heap_msg;
+  nas_message_t                           msg;
+  int                                     heap_allocs = 0;
+  int                                     arena_allocs = 0;
+
+  tlv_decode_arena_init (&arena);
+  /*
+   * Attach request: ESM message container
+   */
+  heap_allocs = decode (attach_request->buffer, attach_request->buf_len, &heap_msg, NULL);
+  arena_allocs = decode (attach_request->buffer, attach_request->buf_len, &msg, &arena);
+  ck_assert_int_eq (heap_allocs - arena_allocs, 2);
+  ck_assert_in_arena (msg.plain.emm.attach_request.esmmessagecontainer, &arena);
+  ck_assert_int_eq (blength (msg.plain.emm.attach_request.esmmessagecontainer), pdn_connectivity_request->buf_len);
+  ck_assert_int_eq (memcmp (bdata (msg.plain.emm.attach_request.esmmessagecontainer), pdn_connectivity_request->buffer, pdn_connectivity_request->buf_len), 0);
+  bdestroy (heap_msg.plain.emm.attach_request.esmmessagecontainer);
+  /*
+   * Authentication response: RES
+   */
+  heap_allocs = decode (authentication_response->buffer, authentication_response->buf_len, &heap_msg, NULL);
+  arena_allocs = decode (authentication_response->buffer, authentication_response->buf_len, &msg, &arena);
+  ck_assert_int_eq (heap_allocs - arena_allocs, 2);
+  ck_assert_in_arena (msg.plain.emm.authentication_response.authenticationresponseparameter, &arena);
+  ck_assert_int_eq (blength (msg.plain.emm.authentication_response.authenticationresponseparameter), 8);
+  bdestroy (heap_msg.plain.emm.authentication_response.authenticationresponseparameter);
+  /*
+   * Integrity protected attach complete: deciphered copy and ESM message container
+   */
+  heap_allocs = decode (protected_attach_complete, sizeof (protected_attach_complete), &heap_msg, NULL);
+  arena_allocs = decode (protected_attach_complete, sizeof (protected_attach_complete), &msg, &arena);
+  ck_assert_int_eq (heap_allocs - arena_allocs, 1 + 2);
+  ck_assert_int_eq (msg.plain.emm.header.message_type, ATTACH_COMPLETE);
+  ck_assert_in_arena (msg.plain.emm.attach_complete.esmmessagecontainer, &arena);
+  ck_assert_int_eq (blength (msg.plain.emm.attach_complete.esmmessagecontainer), 3);
+  bdestroy (heap_msg.plain.emm.attach_complete.esmmessagecontainer);
+
+  ck_assert_uint_eq (arena.nb_chunks, 0);
+  tlv_decode_arena_release (&arena);
+}
+END_TEST
+
+START_TEST (nas_decode_arena_chunk_test)
+{
+  tlv_decode_arena_t                      arena;
+  nas_message_t                           heap_msg;
+  nas_message_t                           msg;
+  int                                     heap_allocs = 0;
+  int                                     arena_allocs = 0;
+
+  /*
+   * An ESM message container larger than the arena block takes one heap chunk
+   */
+  tlv_decode_arena_init (&arena);
+  heap_allocs = decode (large_attach_request, large_attach_request_len, &heap_msg, NULL);
+  arena_allocs = decode (large_attach_request, large_attach_request_len, &msg, &arena);
+  ck_assert_int_eq (heap_allocs - arena_allocs, 2 - 1);
+  ck_assert_uint_eq (arena.nb_chunks, 1);
+  ck_assert_ptr_ne (arena.chunks, NULL);
+  ck_assert_int_eq (blength (msg.plain.emm.attach_request.esmmessagecontainer), ESM_CONTAINER_LARGE_LEN);
+  ck_assert_int_eq (biseq (msg.plain.emm.attach_request.esmmessagecontainer, heap_msg.plain.emm.attach_request.esmmessagecontainer), 1);
+  ck_assert_int_eq (bdestroy (msg.plain.emm.attach_request.esmmessagecontainer), BSTR_ERR);
+  bdestroy (heap_msg.plain.emm.attach_request.esmmessagecontainer);
+  /*
+   * Released in one shot, the arena is reused for the next message
+   */
+  tlv_decode_arena_release (&arena);
+  ck_assert_ptr_eq (arena.chunks, NULL);
+  ck_assert_uint_eq (arena.used, 0);
+  arena_allocs = decode (attach_request->buffer, attach_request->buf_len, &msg, &arena);
+  heap_allocs = decode (attach_request->buffer, attach_request->buf_len, &heap_msg, NULL);
+  ck_assert_int_eq (heap_allocs - arena_allocs, 2);
+  ck_assert_uint_eq (arena.nb_chunks, 1);
+  bdestroy (heap_msg.plain.emm.attach_request.esmmessagecontainer);
+  tlv_decode_arena_release (&arena);
+}
+END_TEST
+
+START_TEST (nas_decode_arena_attach_test)
+{
+  tlv_decode_arena_t                      arena;
+  tlv_decode_arena_t                      nested_arena;
+  bstring                                 b = NULL;
+
+  /*
+   * The arena is attached to the decoding thread for the duration of a decode
+   */
+  tlv_decode_arena_init (&arena);
+  tlv_decode_arena_init (&nested_arena);
+  ck_assert_ptr_eq (tlv_decode_arena_attach (&arena), NULL);
+  ck_assert_int_eq (decode_bstring (&b, 3, (const uint8_t *)"abc", 3), 3);
+  ck_assert_in_arena (b, &arena);
+  ck_assert_ptr_eq (tlv_decode_arena_attach (&nested_arena), &arena);
+  ck_assert_int_eq (decode_bstring (&b, 3, (const uint8_t *)"def", 3), 3);
+  ck_assert_in_arena (b, &nested_arena);
+  ck_assert_ptr_eq (tlv_decode_arena_attach (&arena), &nested_arena);
+  ck_assert_ptr_eq (tlv_decode_arena_attach (NULL), &arena);
+  ck_assert_int_eq (decode_bstring (&b, 3, (const uint8_t *)"ghi", 3), 3);
+  ck_assert (!biswriteprotected (*b));
+  ck_assert_int_eq (bdestroy (b), BSTR_OK);
+  tlv_decode_arena_release (&nested_arena);
+  tlv_decode_arena_release (&arena);
+}
+END_TEST
+
+static void
+setup (
+  void)
+{
+  uint8_t                                 esm[ESM_CONTAINER_LARGE_LEN];
+  tlv_decode_arena_t                      arena;
+  nas_message_t                           msg;
+
+  pdn_connectivity_request = nas_test_corpus_find ("PDN connectivity request");
+  authentication_response = nas_test_corpus_find ("Authentication response");
+  attach_request = nas_test_corpus_find ("Attach request");
+  memset (esm, 0x5a, sizeof (esm));
+  large_attach_request_len = nas_test_build_attach_request (large_attach_request, esm, sizeof (esm));
+  /*
+   * Let the one time allocations of the thread (logging state) happen before counting
+   */
+  tlv_decode_arena_init (&arena);
+  decode (attach_request->buffer, attach_request->buf_len, &msg, &arena);
+  tlv_decode_arena_release (&arena);
+}
+
+Suite * nas_decode_arena_suite(void)
+{
+    Suite *s;
+    TCase *tc_core;
+
+    s = suite_create("NAS decode arena");
+
+    tc_core = tcase_create("NAS decode arena test");
+    tcase_add_checked_fixture(tc_core, setup, NULL);
+    tcase_add_test(tc_core, nas_decode_arena_esm_test);
+    tcase_add_test(tc_core, nas_decode_arena_emm_test);
+    tcase_add_test(tc_core, nas_decode_arena_chunk_test);
+    tcase_add_test(tc_core, nas_decode_arena_attach_test);
+
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
+
+int main(void)
+{
+    int number_failed;
+    Suite *s;
+    SRunner *sr;
+
+    log_init (LOG_MME_ENV, OAILOG_LEVEL_ERROR, 1);
+    itti_init (TASK_MAX, THREAD_MAX, MESSAGES_ID_MAX, tasks_info, messages_info, NULL, NULL);
+    s = nas_decode_arena_suite();
+    sr = srunner_create(s);
+
+    srunner_run_all(sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,265 @@
+#include <check.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "intertask_interface.h"
+#include "timer.h"
+#include "nas_timer.h"
+
+/* Load test of the NAS timer database: one NAS timer per UE for a million
+ * UEs. The ITTI timer API is stubbed, expiries are delivered to the NAS
+ * timer database the way TASK_NAS_MME does on TIMER_HAS_EXPIRED.
+ */
+
+#define NB_UES              (1000 * 1000)
+
+typedef struct {
+  int                                     timer_id;
+  uint32_t                                nb_expiries;
+} test_ue_t;
+
+typedef struct {
+  void                                   *arg;
+  int                                     armed;
+} test_itti_timer_t;
+
+static test_ue_t                       *ues;
+static test_itti_timer_t               *itti_timers;
+static long                             nb_itti_timers;
+static long                             max_itti_timers;
+
+int
+timer_setup (
+  uint32_t interval_sec,
+  uint32_t interval_us,
+  task_id_t task_id,
+  int32_t instance,
+  timer_type_t type,
+  void *timer_arg,
+  long *timer_id)
+{
+  if (nb_itti_timers == max_itti_timers) {
+    max_itti_timers = max_itti_timers ? 2 * max_itti_timers : 1024;
+    itti_timers = realloc (itti_timers, max_itti_timers * sizeof (test_itti_timer_t));
+    ck_assert (itti_timers != NULL);
+  }
+
+  itti_timers[nb_itti_timers].arg = timer_arg;
+  itti_timers[nb_itti_timers].armed = 1;
+  /*
+   * ITTI timer ids are never 0
+   */
+  *timer_id = ++nb_itti_timers;
+  return 0;
+}
+
+int
+timer_remove (
+  long timer_id)
+{
+  ck_assert (timer_id > 0 && timer_id <= nb_itti_timers);
+  ck_assert (itti_timers[timer_id - 1].armed);
+  itti_timers[timer_id - 1].armed = 0;
+  return 0;
+}
+
+static void                            *
+ue_timer_expired (
+  void *args)
+{
+  test_ue_t                              *ue = (test_ue_t *) args;
+
+  ue->nb_expiries++;
+  return NULL;
+}
+
+/* Deliver the expiry of every ITTI timer in [first, last), stopped ones included
+ * to emulate a TIMER_HAS_EXPIRED message already queued when the timer is stopped.
+ */
+static void
+fire_itti_timers (
+  long first,
+  long last)
+{
+  for (long i = first; i < last; i++) {
+    itti_timers[i].armed = 0;
+    nas_timer_handle_signal_expiry (i + 1, itti_timers[i].arg);
+  }
+}
+
+static double
+elapsed_ns (
+  struct timespec *start)
+{
+  struct timespec                         end;
+
+  clock_gettime (CLOCK_MONOTONIC, &end);
+  return (double)(end.tv_sec - start->tv_sec) * 1e9 + (double)(end.tv_nsec - start->tv_nsec);
+}
+
+static void
+setup (
+  void)
+{
+  ues = calloc (NB_UES, sizeof (test_ue_t));
+  ck_assert (ues != NULL);
+  nb_itti_timers = 0;
+  ck_assert_int_eq (nas_timer_init (), RETURNok);
+}
+
+static void
+teardown (
+  void)
+{
+  free (ues);
+  free (itti_timers);
+  itti_timers = NULL;
+  max_itti_timers = 0;
+}
+
+START_TEST(nas_timer_start_stop_test)
+{
+  struct timespec start;
+  uint8_t *seen;
+
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  for (int i = 0; i < NB_UES; i++) {
+    ues[i].timer_id = nas_timer_start (6, ue_timer_expired, &ues[i]);
+    ck_assert (ues[i].timer_id != NAS_TIMER_INACTIVE_ID);
+  }
+  printf ("start   %d timers: %6.1f ns/timer\n", NB_UES, elapsed_ns (&start) / NB_UES);
+
+  /* Identifiers of active timers are unique */
+  seen = calloc (1 << 24, 1);
+  ck_assert (seen != NULL);
+  for (int i = 0; i < NB_UES; i++) {
+    ck_assert (ues[i].timer_id > 0);
+    ck_assert (seen[ues[i].timer_id & 0xFFFFFF] == 0);
+    seen[ues[i].timer_id & 0xFFFFFF] = 1;
+  }
+  free (seen);
+
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  for (int i = 0; i < NB_UES; i++) {
+    ck_assert_int_eq (nas_timer_stop (ues[i].timer_id), NAS_TIMER_INACTIVE_ID);
+  }
+  printf ("stop    %d timers: %6.1f ns/timer\n", NB_UES, elapsed_ns (&start) / NB_UES);
+
+  for (long i = 0; i < nb_itti_timers; i++) {
+    ck_assert (!itti_timers[i].armed);
+  }
+
+  /* Stopping twice the same timer fails */
+  ck_assert_int_eq (nas_timer_stop (ues[0].timer_id), ues[0].timer_id);
+  ck_assert_int_eq (nas_timer_restart (ues[0].timer_id), NAS_TIMER_INACTIVE_ID);
+}
+END_TEST
+
+START_TEST(nas_timer_stale_id_test)
+{
+  int old_id;
+
+  /* Entries are reused once the database is fully populated */
+  for (int i = 0; i < NB_UES; i++) {
+    ues[i].timer_id = nas_timer_start (6, ue_timer_expired, &ues[i]);
+  }
+
+  old_id = ues[0].timer_id;
+  ck_assert_int_eq (nas_timer_stop (old_id), NAS_TIMER_INACTIVE_ID);
+
+  for (int i = 1; i < NB_UES; i++) {
+    ck_assert_int_eq (nas_timer_stop (ues[i].timer_id), NAS_TIMER_INACTIVE_ID);
+    ues[i].timer_id = nas_timer_start (6, ue_timer_expired, &ues[i]);
+    ck_assert (ues[i].timer_id != old_id);
+  }
+
+  /* The identifier of a stopped timer does not refer to another timer */
+  ck_assert_int_eq (nas_timer_stop (old_id), old_id);
+  ck_assert_int_eq (nas_timer_restart (old_id), NAS_TIMER_INACTIVE_ID);
+}
+END_TEST
+
+START_TEST(nas_timer_expiry_test)
+{
+  struct timespec start;
+  long first;
+
+  for (int i = 0; i < NB_UES; i++) {
+    ues[i].timer_id = nas_timer_start (6, ue_timer_expired, &ues[i]);
+  }
+
+  /* Most procedures complete before their timer expires */
+  for (int i = 0; i < NB_UES; i += 2) {
+    nas_timer_stop (ues[i].timer_id);
+  }
+
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  fire_itti_timers (0, nb_itti_timers);
+  printf ("expire  %d timers: %6.1f ns/timer\n", NB_UES / 2, elapsed_ns (&start) / (NB_UES / 2));
+
+  for (int i = 0; i < NB_UES; i++) {
+    ck_assert_uint_eq (ues[i].nb_expiries, i & 1);
+  }
+
+  /* Expired timers stay allocated until restarted (retransmission) or stopped */
+  first = nb_itti_timers;
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  for (int i = 1; i < NB_UES; i += 2) {
+    ck_assert_int_eq (nas_timer_restart (ues[i].timer_id), ues[i].timer_id);
+  }
+  printf ("restart %d timers: %6.1f ns/timer\n", NB_UES / 2, elapsed_ns (&start) / (NB_UES / 2));
+
+  /* Restarting a running timer cancels its ITTI timer */
+  ck_assert_int_eq (nas_timer_restart (ues[1].timer_id), ues[1].timer_id);
+  ck_assert (!itti_timers[first].armed);
+
+  /* Expiries of ITTI timers released by the restarts are discarded */
+  fire_itti_timers (0, nb_itti_timers);
+
+  for (int i = 0; i < NB_UES; i++) {
+    ck_assert_uint_eq (ues[i].nb_expiries, (i & 1) ? 2 : 0);
+  }
+
+  for (int i = 1; i < NB_UES; i += 2) {
+    ck_assert_int_eq (nas_timer_stop (ues[i].timer_id), NAS_TIMER_INACTIVE_ID);
+  }
+}
+END_TEST
+
+Suite * nas_timer_suite(void)
+{
+    Suite *s;
+    TCase *tc_core;
+
+    s = suite_create("NAS timer tests");
+
+    /* Core test case */
+    tc_core = tcase_create("NAS timer test");
+    tcase_add_checked_fixture(tc_core, setup, teardown);
+    tcase_set_timeout(tc_core, 60);
+    tcase_add_test(tc_core, nas_timer_start_stop_test);
+    tcase_add_test(tc_core, nas_timer_stale_id_test);
+    tcase_add_test(tc_core, nas_timer_expiry_test);
+
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
+
+int main(void)
+{
+    int number_failed;
+    Suite *s;
+    SRunner *sr;
+
+    s = nas_timer_suite();
+    sr = srunner_create(s);
+
+    srunner_run_all(sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,217 @@
+#include <check.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "intertask_interface.h"
+#include "intertask_interface_init.h"
+#include "log.h"
+#include "mme_config.h"
+#include "mme_app_defs.h"
+#include "s1ap_common.h"
+#include "s1ap_mme.h"
+#include "s1ap_mme_handlers.h"
+
+/* S1 Setup storm: NB_ENBS eNBs are associated and set up through
+ * s1ap_mme_handle_s1_setup_request(), on an MME sized for MAX_UES UEs.
+ * The UE lists of the eNBs must be sized for their own UEs, not for the
+ * MME, and their memory must be reported in the MME statistics.
+ * The S1 Setup Responses sent to TASK_SCTP are polled and freed.
+ */
+
+#define NB_ENBS             (10 * 1000)
+#define MAX_UES             (1000 * 1000)
+#define NB_UES_PER_ENB      1000
+#define MAX_UE_LIST_MEMORY  1024
+
+static uint8_t                          plmn[] = {0x02, 0xF8, 0x39};      // 208.93
+static uint8_t                          tac[] = {0x00, 0x01};
+static uint8_t                          enb_id[3];
+static uint16_t                         served_mcc[] = {208};
+static uint16_t                         served_mnc[] = {93};
+static uint16_t                         served_mnc_len[] = {2};
+static uint16_t                         served_tac[] = {1};
+static struct s1ap_message_s            s1_setup_request;
+static S1ap_SupportedTAs_Item_t         supported_ta;
+static S1ap_PLMNidentity_t              broadcast_plmn;
+
+static double
+elapsed_ns (
+  struct timespec *start)
+{
+  struct timespec                         end;
+
+  clock_gettime (CLOCK_MONOTONIC, &end);
+  return (double)(end.tv_sec - start->tv_sec) * 1e9 + (double)(end.tv_nsec - start->tv_nsec);
+}
+
+static void
+drain_sctp_queue (
+  void)
+{
+  MessageDef                             *message_p = NULL;
+
+  for (;;) {
+    itti_poll_msg (TASK_SCTP, &message_p);
+    if (message_p == NULL) {
+      break;
+    }
+    itti_free (ITTI_MSG_ORIGIN_ID (message_p), message_p);
+    message_p = NULL;
+  }
+}
+
+static int
+setup_enb (
+  sctp_assoc_id_t assoc_id,
+  uint32_t macro_enb_id)
+{
+  sctp_new_peer_t                         new_peer = {.instreams = 2, .outstreams = 2, .assoc_id = assoc_id};
+  int                                     rc;
+
+  ck_assert (s1ap_handle_new_association (&new_peer) == RETURNok);
+  // macro eNB id, 20 bits
+  enb_id[0] = (macro_enb_id >> 12) & 0xFF;
+  enb_id[1] = (macro_enb_id >> 4) & 0xFF;
+  enb_id[2] = (macro_enb_id << 4) & 0xF0;
+  rc = s1ap_mme_handle_s1_setup_request (assoc_id, 0, &s1_setup_request);
+  drain_sctp_queue ();
+  return rc;
+}
+
+static void
+setup (
+  void)
+{
+  S1ap_S1SetupRequestIEs_t               *ies = &s1_setup_request.msg.s1ap_S1SetupRequestIEs;
+
+  log_init (LOG_MME_ENV, OAILOG_LEVEL_ERROR, 1);
+  ck_assert (itti_init (TASK_MAX, THREAD_MAX, MESSAGES_ID_MAX, tasks_info, messages_info, NULL, NULL) == 0);
+  mme_config.max_enbs = NB_ENBS + 1;
+  mme_config.max_ues = MAX_UES;
+  mme_config.served_tai.nb_tai = 1;
+  mme_config.served_tai.plmn_mcc = served_mcc;
+  mme_config.served_tai.plmn_mnc = served_mnc;
+  mme_config.served_tai.plmn_mnc_len = served_mnc_len;
+  mme_config.served_tai.tac = served_tac;
+  mme_config.gummei.nb = 1;
+  mme_config.gummei.gummei[0].mme_gid = 1;
+  mme_config.gummei.gummei[0].mme_code = 1;
+  ck_assert (s1ap_mme_init_lists () == RETURNok);
+  hss_associated = true;
+
+  memset (&s1_setup_request, 0, sizeof (s1_setup_request));
+  s1_setup_request.procedureCode = S1ap_ProcedureCode_id_S1Setup;
+  s1_setup_request.direction = S1AP_PDU_PR_initiatingMessage;
+  ies->global_ENB_ID.eNB_ID.present = S1ap_ENB_ID_PR_macroENB_ID;
+  ies->global_ENB_ID.eNB_ID.choice.macroENB_ID.buf = enb_id;
+  ies->global_ENB_ID.eNB_ID.choice.macroENB_ID.size = sizeof (enb_id);
+  ies->global_ENB_ID.eNB_ID.choice.macroENB_ID.bits_unused = 4;
+  ies->global_ENB_ID.pLMNidentity.buf = plmn;
+  ies->global_ENB_ID.pLMNidentity.size = sizeof (plmn);
+  supported_ta.tAC.buf = tac;
+  supported_ta.tAC.size = sizeof (tac);
+  broadcast_plmn.buf = plmn;
+  broadcast_plmn.size = sizeof (plmn);
+  ASN_SEQUENCE_ADD (&supported_ta.broadcastPLMNs, &broadcast_plmn);
+  ASN_SEQUENCE_ADD (&ies->supportedTAs, &supported_ta);
+  ies->defaultPagingDRX = S1ap_PagingDRX_v64;
+}
+
+static void
+teardown (
+  void)
+{
+}
+
+START_TEST(s1ap_s1_setup_storm_test)
+{
+  struct timespec                         start;
+  enb_description_t                      *enb_ref = NULL;
+
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  for (uint32_t i = 0; i < NB_ENBS; i++) {
+    ck_assert_msg (setup_enb (i + 1, i) == RETURNok, "S1 Setup of eNB %u failed", i);
+  }
+  printf ("S1 Setup of %d eNBs: %6.1f us/eNB, UE lists %zu KB, %zu bytes per eNB\n", NB_ENBS, elapsed_ns (&start) / NB_ENBS / 1e3,
+          mme_app_desc.enb_ue_lists_memory / 1024, mme_app_desc.enb_ue_lists_memory / mme_app_desc.nb_enb_ue_lists);
+
+  ck_assert_uint_eq (mme_app_desc.nb_enb_ue_lists, NB_ENBS);
+  ck_assert (mme_app_desc.enb_ue_lists_memory <= NB_ENBS * MAX_UE_LIST_MEMORY);
+  for (uint32_t i = 0; i < NB_ENBS; i++) {
+    ck_assert ((enb_ref = s1ap_is_enb_id_in_list (i)) != NULL);
+    ck_assert_int_eq (enb_ref->sctp_assoc_id, i + 1);
+    ck_assert_int_eq (enb_ref->s1_state, S1AP_READY);
+  }
+
+  for (uint32_t i = 0; i < NB_ENBS; i++) {
+    s1ap_remove_enb (s1ap_is_enb_assoc_id_in_list (i + 1));
+  }
+  ck_assert_uint_eq (mme_app_desc.nb_enb_ue_lists, 0);
+  ck_assert_uint_eq (mme_app_desc.enb_ue_lists_memory, 0);
+}
+END_TEST
+
+START_TEST(s1ap_ue_list_growth_test)
+{
+  enb_description_t                      *enb_ref = NULL;
+  size_t                                  initial_memory;
+
+  ck_assert (setup_enb (1, 1) == RETURNok);
+  ck_assert ((enb_ref = s1ap_is_enb_assoc_id_in_list (1)) != NULL);
+  initial_memory = mme_app_desc.enb_ue_lists_memory;
+  ck_assert_uint_eq (initial_memory, enb_ref->ue_coll_memory);
+
+  for (uint32_t i = 0; i < NB_UES_PER_ENB; i++) {
+    ue_description_t                       *ue_ref = s1ap_new_ue (1, i + 1);
+
+    ck_assert (ue_ref != NULL);
+    ue_ref->s1ap_ue_context_rel_timer.id = S1AP_TIMER_INACTIVE_ID;
+  }
+  for (uint32_t i = 0; i < NB_UES_PER_ENB; i++) {
+    ck_assert (s1ap_is_ue_enb_id_in_list (enb_ref, i + 1) != NULL);
+  }
+  printf ("UE list of %d UEs: %zu bytes\n", NB_UES_PER_ENB, enb_ref->ue_coll_memory);
+  ck_assert (enb_ref->ue_coll_memory > initial_memory);
+  ck_assert_uint_eq (mme_app_desc.enb_ue_lists_memory, enb_ref->ue_coll_memory);
+
+  s1ap_remove_enb (enb_ref);
+  ck_assert_uint_eq (mme_app_desc.nb_enb_ue_lists, 0);
+  ck_assert_uint_eq (mme_app_desc.enb_ue_lists_memory, 0);
+}
+END_TEST
+
+Suite * s1ap_enb_setup_suite(void)
+{
+    Suite *s;
+    TCase *tc_core;
+
+    s = suite_create("S1AP eNB setup");
+
+    tc_core = tcase_create("S1AP eNB setup test");
+    tcase_add_checked_fixture(tc_core, setup, teardown);
+    tcase_set_timeout(tc_core, 60);
+    tcase_add_test(tc_core, s1ap_s1_setup_storm_test);
+    tcase_add_test(tc_core, s1ap_ue_list_growth_test);
+
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
+
+int main(void)
+{
+    int number_failed;
+    Suite *s;
+    SRunner *sr;
+
+    s = s1ap_enb_setup_suite();
+    sr = srunner_create(s);
+
+    srunner_run_all(sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
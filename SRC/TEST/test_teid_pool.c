@@ -0,0 +1,284 @@
+#include <check.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "common_defs.h"
+#include "teid_pool.h"
+
+/* TEID allocator: NB_CHURNS random releases and allocations on NB_LIVE live
+ * tunnels must never hand out a live TEID, nor 0, nor a TEID released less
+ * than TEID_POOL_REUSE_DELAY releases ago, and the memory must follow the
+ * live tunnels. Then NB_SHARDS threads churn their own shard in parallel.
+ */
+
+#define NB_LIVE         (100 * 1000)
+#define NB_CHURNS       (20 * 1000 * 1000)
+#define NB_SHARDS       4
+#define SHARD_BITS      2
+#define MAX_INDEX       (1 << 24)
+
+typedef struct {
+  pthread_t                               thread;
+  uint32_t                                shard_id;
+  uint32_t                                nb_errors;
+} shard_t;
+
+static uint32_t                        *live;
+
+static double
+elapsed_ns (
+  struct timespec *start)
+{
+  struct timespec                         end;
+
+  clock_gettime (CLOCK_MONOTONIC, &end);
+  return (double)(end.tv_sec - start->tv_sec) * 1e9 + (double)(end.tv_nsec - start->tv_nsec);
+}
+
+static uint32_t
+xorshift (
+  uint64_t * state)
+{
+  *state ^= *state << 13;
+  *state ^= *state >> 7;
+  *state ^= *state << 17;
+  return (uint32_t)*state;
+}
+
+/* Churns the pool, returns the number of TEIDs handed out while live, out of the shard or 0 */
+static uint32_t
+churn (
+  teid_pool_t * pool,
+  uint32_t shard_id,
+  uint32_t * teids,
+  uint32_t nb_churns,
+  uint64_t seed)
+{
+  uint8_t                                *is_live = calloc (MAX_INDEX / 8, 1);
+  uint32_t                                nb_errors = 0;
+
+  ck_assert (is_live != NULL);
+  for (uint32_t i = 0; i < NB_LIVE; i++) {
+    teids[i] = teid_pool_allocate (pool);
+    is_live[(teids[i] & (MAX_INDEX - 1)) / 8] |= 1 << (teids[i] & 7);
+  }
+  for (uint32_t i = 0; i < nb_churns; i++) {
+    uint32_t                                j = xorshift (&seed) % NB_LIVE;
+    uint32_t                                index = teids[j] & (MAX_INDEX - 1);
+
+    if (teid_pool_release (pool, teids[j]) != RETURNok) {
+      nb_errors++;
+    }
+    is_live[index / 8] &= ~(1 << (index % 8));
+    teids[j] = teid_pool_allocate (pool);
+    index = teids[j] & (MAX_INDEX - 1);
+    if ((teids[j] == INVALID_TEID) || (teid_pool_shard (teids[j], pool->shard_bits) != shard_id)
+        || ((teids[j] & (0xFFFFFFFF >> pool->shard_bits)) >= MAX_INDEX) || (is_live[index / 8] & (1 << (index % 8)))) {
+      nb_errors++;
+    }
+    is_live[index / 8] |= 1 << (index % 8);
+  }
+  free (is_live);
+  return nb_errors;
+}
+
+static void                            *
+shard_thread (
+  void *args)
+{
+  shard_t                                *shard = (shard_t *)args;
+  teid_pool_t                             pool;
+  uint32_t                               *teids = calloc (NB_LIVE, sizeof (uint32_t));
+
+  teid_pool_init (&pool, SHARD_BITS, shard->shard_id);
+  shard->nb_errors = churn (&pool, shard->shard_id, teids, NB_CHURNS / NB_SHARDS, 0x9E3779B97F4A7C15ull + shard->shard_id);
+  teid_pool_free (&pool);
+  free (teids);
+  return NULL;
+}
+
+static void
+setup (
+  void)
+{
+  live = calloc (NB_LIVE, sizeof (uint32_t));
+  ck_assert (live != NULL);
+}
+
+static void
+teardown (
+  void)
+{
+  free (live);
+}
+
+START_TEST(teid_pool_churn_test)
+{
+  teid_pool_t                             pool;
+  struct timespec                         start;
+
+  ck_assert_int_eq (teid_pool_init (&pool, 0, 0), RETURNok);
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  ck_assert_uint_eq (churn (&pool, 0, live, NB_CHURNS, 88172645463325252ull), 0);
+  printf ("churn %d release + allocate on %d live TEIDs: %6.1f ns/pair, highest index %u\n", NB_CHURNS, NB_LIVE,
+          elapsed_ns (&start) / NB_CHURNS, pool.nb_used);
+  ck_assert_uint_eq (pool.nb_allocated, NB_LIVE);
+  ck_assert (pool.nb_used <= NB_LIVE + TEID_POOL_REUSE_DELAY);
+  for (uint32_t i = 0; i < NB_LIVE; i++) {
+    ck_assert (teid_pool_is_allocated (&pool, live[i]));
+    ck_assert_int_eq (teid_pool_release (&pool, live[i]), RETURNok);
+  }
+  ck_assert_uint_eq (pool.nb_allocated, 0);
+  teid_pool_free (&pool);
+}
+END_TEST
+
+START_TEST(teid_pool_reuse_delay_test)
+{
+  teid_pool_t                             pool;
+  uint32_t                                old_teid;
+
+  ck_assert_int_eq (teid_pool_init (&pool, 0, 0), RETURNok);
+  for (uint32_t i = 0; i < 2 * TEID_POOL_REUSE_DELAY; i++) {
+    live[i] = teid_pool_allocate (&pool);
+  }
+  old_teid = live[0];
+  ck_assert_int_eq (teid_pool_release (&pool, old_teid), RETURNok);
+
+  /* A released TEID is not live, and not released again */
+  ck_assert (!teid_pool_is_allocated (&pool, old_teid));
+  ck_assert_int_eq (teid_pool_release (&pool, old_teid), RETURNerror);
+  ck_assert_int_eq (teid_pool_release (&pool, INVALID_TEID), RETURNerror);
+  ck_assert_int_eq (teid_pool_release (&pool, pool.nb_used + 1), RETURNerror);
+
+  /* It is reused only once TEID_POOL_REUSE_DELAY TEIDs wait for reuse */
+  for (uint32_t i = 1; i < TEID_POOL_REUSE_DELAY - 1; i++) {
+    ck_assert_int_eq (teid_pool_release (&pool, live[i]), RETURNok);
+    live[i] = teid_pool_allocate (&pool);
+    ck_assert (live[i] != old_teid);
+  }
+  ck_assert_int_eq (teid_pool_release (&pool, live[TEID_POOL_REUSE_DELAY - 1]), RETURNok);
+  ck_assert_uint_eq (teid_pool_allocate (&pool), old_teid);
+  teid_pool_free (&pool);
+}
+END_TEST
+
+START_TEST(teid_pool_shard_test)
+{
+  teid_pool_t                             pools[2];
+  shard_t                                 shards[NB_SHARDS];
+  struct timespec                         start;
+  uint32_t                                teid;
+
+  ck_assert_int_eq (teid_pool_init (&pools[0], SHARD_BITS, NB_SHARDS), RETURNerror);
+  ck_assert_int_eq (teid_pool_init (&pools[0], TEID_POOL_MAX_SHARD_BITS + 1, 0), RETURNerror);
+
+  /* A shard does not release the TEIDs of another shard */
+  ck_assert_int_eq (teid_pool_init (&pools[0], SHARD_BITS, 1), RETURNok);
+  ck_assert_int_eq (teid_pool_init (&pools[1], SHARD_BITS, 2), RETURNok);
+  teid = teid_pool_allocate (&pools[0]);
+  ck_assert_uint_eq (teid_pool_shard (teid, SHARD_BITS), 1);
+  ck_assert_uint_eq (teid_pool_allocate (&pools[1]) & (0xFFFFFFFF >> SHARD_BITS), teid & (0xFFFFFFFF >> SHARD_BITS));
+  ck_assert_int_eq (teid_pool_release (&pools[1], teid), RETURNerror);
+  ck_assert_int_eq (teid_pool_release (&pools[0], teid), RETURNok);
+  teid_pool_free (&pools[0]);
+  teid_pool_free (&pools[1]);
+
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  for (uint32_t i = 0; i < NB_SHARDS; i++) {
+    shards[i].shard_id = i;
+    pthread_create (&shards[i].thread, NULL, shard_thread, &shards[i]);
+  }
+  for (uint32_t i = 0; i < NB_SHARDS; i++) {
+    pthread_join (shards[i].thread, NULL);
+    ck_assert_uint_eq (shards[i].nb_errors, 0);
+  }
+  printf ("churn %d release + allocate in %d shards: %6.1f ns/pair\n", NB_CHURNS, NB_SHARDS, elapsed_ns (&start) / NB_CHURNS);
+}
+END_TEST
+
+START_TEST(teid_pool_exhaustion_test)
+{
+  teid_pool_t                             pool;
+  uint32_t                                size;
+
+  ck_assert_int_eq (teid_pool_init (&pool, TEID_POOL_MAX_SHARD_BITS, 1), RETURNok);
+  size = pool.size;
+  for (uint32_t i = 0; i < size; i++) {
+    ck_assert (teid_pool_allocate (&pool) != INVALID_TEID);
+  }
+  ck_assert_uint_eq (teid_pool_allocate (&pool), INVALID_TEID);
+
+  /* Once the shard is exhausted a released TEID is reused at once */
+  ck_assert_int_eq (teid_pool_release (&pool, pool.prefix | 7), RETURNok);
+  ck_assert_uint_eq (teid_pool_allocate (&pool), pool.prefix | 7);
+  ck_assert_uint_eq (teid_pool_allocate (&pool), INVALID_TEID);
+  teid_pool_free (&pool);
+}
+END_TEST
+
+START_TEST(teid_shards_test)
+{
+  teid_shards_t                           shards;
+  uint32_t                                teids[2 * NB_SHARDS];
+
+  ck_assert_int_eq (teid_shards_init (&shards, 3), RETURNerror);
+  ck_assert_int_eq (teid_shards_init (&shards, TEID_SHARDS_MAX * 2), RETURNerror);
+
+  /* The shards are allocated in turn, a TEID is released in its shard */
+  ck_assert_int_eq (teid_shards_init (&shards, NB_SHARDS), RETURNok);
+  for (uint32_t i = 0; i < 2 * NB_SHARDS; i++) {
+    teids[i] = teid_shards_allocate (&shards);
+    ck_assert (teids[i] != INVALID_TEID);
+    ck_assert_uint_eq (teid_pool_shard (teids[i], SHARD_BITS), i % NB_SHARDS);
+  }
+  for (uint32_t i = 0; i < 2 * NB_SHARDS; i++) {
+    ck_assert_int_eq (teid_shards_release (&shards, teids[i]), RETURNok);
+    ck_assert_int_eq (teid_shards_release (&shards, teids[i]), RETURNerror);
+  }
+  for (uint32_t i = 0; i < NB_SHARDS; i++) {
+    ck_assert_uint_eq (shards.pools[i].nb_allocated, 0);
+  }
+  teid_shards_free (&shards);
+}
+END_TEST
+
+Suite * teid_pool_suite(void)
+{
+    Suite *s;
+    TCase *tc_core;
+
+    s = suite_create("TEID pool");
+
+    tc_core = tcase_create("TEID pool test");
+    tcase_add_checked_fixture(tc_core, setup, teardown);
+    tcase_set_timeout(tc_core, 60);
+    tcase_add_test(tc_core, teid_pool_churn_test);
+    tcase_add_test(tc_core, teid_pool_reuse_delay_test);
+    tcase_add_test(tc_core, teid_pool_shard_test);
+    tcase_add_test(tc_core, teid_pool_exhaustion_test);
+    tcase_add_test(tc_core, teid_shards_test);
+
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
+
+int main(void)
+{
+    int number_failed;
+    Suite *s;
+    SRunner *sr;
+
+    s = teid_pool_suite();
+    sr = srunner_create(s);
+
+    srunner_run_all(sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
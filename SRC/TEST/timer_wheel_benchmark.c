@@ -0,0 +1,129 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "timer_wheel.h"
+
+/* Arms and cancels millions of timers on the ITTI timing wheel, then lets the
+ * remaining ones expire, reporting the cost per operation.
+ * usage: timer_wheel_benchmark [nb_timers]
+ */
+
+#define DEFAULT_NB_TIMERS   (4 * 1000 * 1000)
+/* NAS/S1AP/GTPv2-C timers: from a few ms up to one hour, tick is 1ms */
+#define MAX_DELAY_TICKS     (3600 * 1000)
+
+static uint64_t                         nb_expired = 0;
+
+static double
+elapsed_ns (
+  struct timespec *start,
+  struct timespec *end)
+{
+  return (double)(end->tv_sec - start->tv_sec) * 1e9 + (double)(end->tv_nsec - start->tv_nsec);
+}
+
+static void
+expiry_cb (
+  __attribute__((unused)) long timer_id,
+  __attribute__((unused)) uint32_t task_id,
+  __attribute__((unused)) int32_t instance,
+  __attribute__((unused)) void *arg,
+  __attribute__((unused)) void *cb_data)
+{
+  nb_expired++;
+}
+
+int
+main (
+  int argc,
+  char *argv[])
+{
+  uint32_t                                nb_timers = DEFAULT_NB_TIMERS;
+  long                                   *timer_ids;
+  timer_wheel_t                          *tw;
+  struct timespec                         start, end;
+  uint64_t                                now = 0;
+  uint32_t                                removed = 0;
+
+  if (argc > 1) {
+    nb_timers = strtoul (argv[1], NULL, 0);
+  }
+
+  timer_ids = calloc (nb_timers, sizeof (long));
+  tw = timer_wheel_create (1024, now);
+
+  if ((timer_ids == NULL) || (tw == NULL)) {
+    fprintf (stderr, "Allocation failed\n");
+    return EXIT_FAILURE;
+  }
+
+  srand (1);
+  clock_gettime (CLOCK_MONOTONIC, &start);
+
+  for (uint32_t i = 0; i < nb_timers; i++) {
+    if (timer_wheel_add (tw, now + 1 + (rand () % MAX_DELAY_TICKS), 0, 0, 0, NULL, &timer_ids[i]) < 0) {
+      fprintf (stderr, "timer_wheel_add failed at %u\n", i);
+      return EXIT_FAILURE;
+    }
+  }
+
+  clock_gettime (CLOCK_MONOTONIC, &end);
+  printf ("arm     %10u timers: %8.1f ns/timer\n", nb_timers, elapsed_ns (&start, &end) / nb_timers);
+
+  /*
+   * Cancel every other timer, as most protocol timers are stopped before expiry
+   */
+  clock_gettime (CLOCK_MONOTONIC, &start);
+
+  for (uint32_t i = 0; i < nb_timers; i += 2) {
+    if (timer_wheel_remove (tw, timer_ids[i], NULL) == 0) {
+      removed++;
+    }
+  }
+
+  clock_gettime (CLOCK_MONOTONIC, &end);
+  printf ("cancel  %10u timers: %8.1f ns/timer\n", removed, elapsed_ns (&start, &end) / (removed ? removed : 1));
+
+  /*
+   * Stale handles must be rejected
+   */
+  if ((nb_timers > 0) && (timer_wheel_remove (tw, timer_ids[0], NULL) == 0)) {
+    fprintf (stderr, "Removed twice the same timer\n");
+    return EXIT_FAILURE;
+  }
+
+  /*
+   * Re-arm the cancelled half (free entries reuse)
+   */
+  clock_gettime (CLOCK_MONOTONIC, &start);
+
+  for (uint32_t i = 0; i < nb_timers; i += 2) {
+    timer_wheel_add (tw, now + 1 + (rand () % MAX_DELAY_TICKS), 0, 0, 0, NULL, &timer_ids[i]);
+  }
+
+  clock_gettime (CLOCK_MONOTONIC, &end);
+  printf ("re-arm  %10u timers: %8.1f ns/timer\n", removed, elapsed_ns (&start, &end) / (removed ? removed : 1));
+
+  /*
+   * Run the wheel tick by tick as TASK_TIMER would
+   */
+  clock_gettime (CLOCK_MONOTONIC, &start);
+
+  for (now = 0; now <= MAX_DELAY_TICKS; now++) {
+    timer_wheel_advance (tw, now, expiry_cb, NULL);
+  }
+
+  clock_gettime (CLOCK_MONOTONIC, &end);
+  printf ("expire  %10lu timers: %8.1f ns/timer (%u ticks)\n", nb_expired, elapsed_ns (&start, &end) / (nb_expired ? nb_expired : 1), MAX_DELAY_TICKS + 1);
+
+  if ((nb_expired != nb_timers) || (timer_wheel_count (tw) != 0)) {
+    fprintf (stderr, "Expired %lu timers, expected %u (%u still armed)\n", nb_expired, nb_timers, timer_wheel_count (tw));
+    return EXIT_FAILURE;
+  }
+
+  timer_wheel_destroy (tw);
+  free (timer_ids);
+  return EXIT_SUCCESS;
+}
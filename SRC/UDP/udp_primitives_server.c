@@ -26,6 +26,7 @@
   \email: lionel.gauthier@eurecom.fr
 */
 
+#define _GNU_SOURCE             // required for recvmmsg() and sendmmsg()
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -47,8 +48,15 @@
 #include "udp_primitives_server.h"
 
 
+#define UDP_RECV_BUFFER_SIZE  4096    /* Datagram received in place in the ITTI buffer */
+#define UDP_MAX_DATAGRAM_SIZE 65507   /* Largest datagram received, the larger part goes to an overflow */
+#define UDP_RECV_OVERFLOW_SIZE (UDP_MAX_DATAGRAM_SIZE - UDP_RECV_BUFFER_SIZE)
+#define UDP_RECV_BATCH_SIZE   8       /* Datagrams received by a recvmmsg(), each with an overflow slot */
+#define UDP_SEND_BATCH_SIZE   32      /* Datagrams sent by a sendmmsg() */
+
 struct udp_socket_desc_s {
-  uint8_t                                 buffer[4096];
+  uint8_t                                *buffers[UDP_RECV_BATCH_SIZE];    /* ITTI buffers for the next datagrams, handed over to task_id */
+  uint8_t                                *overflow;     /* Ends of the datagrams larger than UDP_RECV_BUFFER_SIZE, UDP_RECV_OVERFLOW_SIZE bytes per datagram of a batch */
   int                                     sd;   /* Socket descriptor to use */
 
   pthread_t                               listener_thread;      /* Thread affected to recv */
@@ -57,6 +65,8 @@ struct udp_socket_desc_s {
   uint16_t                                local_port;   /* Local port to use */
 
   task_id_t                               task_id;      /* Task who has requested the new endpoint */
+  uint32_t                                nb_tasks;     /* Tasks sharing the endpoint, task_id and the next ones */
+  udp_steer_t                             steer;        /* Task of a received datagram among the nb_tasks */
 
                                           STAILQ_ENTRY (
   udp_socket_desc_s)                      entries;
@@ -69,11 +79,24 @@ STAILQ_HEAD (
      static pthread_mutex_t                  udp_socket_list_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 
+/* UDP_DATA_REQ of a socket waiting for a sendmmsg() */
+struct udp_send_batch_s {
+  int                                     sd;
+  unsigned int                            nb_datagrams;
+  struct mmsghdr                          datagrams[UDP_SEND_BATCH_SIZE];
+  struct iovec                            iovecs[UDP_SEND_BATCH_SIZE];
+  struct sockaddr_in                      peer_addrs[UDP_SEND_BATCH_SIZE];
+  uint8_t                                *buffers[UDP_SEND_BATCH_SIZE];
+  task_id_t                               task_ids[UDP_SEND_BATCH_SIZE];
+};
+
+static struct udp_send_batch_s          udp_send_batch = {.sd = -1};
+
 static void                             udp_server_receive_and_process (
   struct udp_socket_desc_s *udp_sock_pP);
 
 
-/* @brief Retrieve the descriptor associated with the task_id
+/* @brief Retrieve the descriptor shared by the task_id
 */
 static
 struct udp_socket_desc_s               *
@@ -84,7 +107,7 @@ udp_server_get_socket_desc (
 
   OAILOG_DEBUG (LOG_UDP, "Looking for task %d\n", task_id);
   STAILQ_FOREACH (udp_sock_p, &udp_socket_list, entries) {
-    if (udp_sock_p->task_id == task_id) {
+    if ((task_id >= udp_sock_p->task_id) && (task_id < udp_sock_p->task_id + udp_sock_p->nb_tasks)) {
       OAILOG_DEBUG (LOG_UDP, "Found matching task desc\n");
       break;
     }
@@ -114,7 +137,9 @@ static
 udp_server_create_socket (
   int port,
   char *address,
-  task_id_t task_id)
+  task_id_t task_id,
+  uint32_t nb_tasks,
+  udp_steer_t steer)
 {
   struct sockaddr_in                      addr;
   int                                     sd;
@@ -161,11 +186,15 @@ udp_server_create_socket (
 
   socket_desc_p = calloc (1, sizeof (struct udp_socket_desc_s));
   DevAssert (socket_desc_p != NULL);
+  socket_desc_p->overflow = malloc (UDP_RECV_BATCH_SIZE * UDP_RECV_OVERFLOW_SIZE);
+  DevAssert (socket_desc_p->overflow != NULL);
   socket_desc_p->sd = sd;
   socket_desc_p->local_address = address;
   socket_desc_p->local_port = port;
   socket_desc_p->task_id = task_id;
-  OAILOG_DEBUG (LOG_UDP, "Inserting new descriptor for task %d, sd %d\n", socket_desc_p->task_id, socket_desc_p->sd);
+  socket_desc_p->nb_tasks = (nb_tasks > 1) && steer ? nb_tasks : 1;
+  socket_desc_p->steer = steer;
+  OAILOG_DEBUG (LOG_UDP, "Inserting new descriptor for %u tasks from task %d, sd %d\n", socket_desc_p->nb_tasks, socket_desc_p->task_id, socket_desc_p->sd);
   pthread_mutex_lock (&udp_socket_list_mutex);
   STAILQ_INSERT_TAIL (&udp_socket_list, socket_desc_p, entries);
   pthread_mutex_unlock (&udp_socket_list_mutex);
@@ -206,47 +235,142 @@ static void
 udp_server_receive_and_process (
   struct udp_socket_desc_s *udp_sock_pP)
 {
-  OAILOG_DEBUG (LOG_UDP, "Inserting new descriptor for task %d, sd %d\n", udp_sock_pP->task_id, udp_sock_pP->sd);
-  {
-    int                                     bytes_received = 0;
-    socklen_t                               from_len;
-    struct sockaddr_in                      addr;
-
-    from_len = (socklen_t) sizeof (struct sockaddr_in);
-
-    if ((bytes_received = recvfrom (udp_sock_pP->sd, udp_sock_pP->buffer, sizeof (udp_sock_pP->buffer), 0, (struct sockaddr *)&addr, &from_len)) <= 0) {
-      OAILOG_ERROR (LOG_UDP, "Recvfrom failed %s\n", strerror (errno));
-      //break;
-    } else {
+  struct mmsghdr                          datagrams[UDP_RECV_BATCH_SIZE];
+  struct iovec                            iovecs[UDP_RECV_BATCH_SIZE][2];
+  struct sockaddr_in                      addrs[UDP_RECV_BATCH_SIZE];
+  int                                     nb_datagrams,
+                                          i;
+
+  OAILOG_DEBUG (LOG_UDP, "Receiving on descriptor for task %d, sd %d\n", udp_sock_pP->task_id, udp_sock_pP->sd);
+
+  /*
+   * The datagrams are received in ITTI buffers given to the task with the
+   * UDP_DATA_IND, the socket is non-blocking, read it until it is empty.
+   * The rare datagrams larger than an ITTI buffer continue in the overflow
+   * slot of their rank in the batch and are copied to a buffer of their size.
+   * The batch is capped at the number of overflow slots so that no datagram
+   * is lost.
+   */
+  do {
+    for (i = 0; i < UDP_RECV_BATCH_SIZE; i++) {
+      if (udp_sock_pP->buffers[i] == NULL) {
+        udp_sock_pP->buffers[i] = itti_malloc (TASK_UDP, udp_sock_pP->task_id, UDP_RECV_BUFFER_SIZE);
+      }
+      iovecs[i][0].iov_base = udp_sock_pP->buffers[i];
+      iovecs[i][0].iov_len = UDP_RECV_BUFFER_SIZE;
+      iovecs[i][1].iov_base = &udp_sock_pP->overflow[i * UDP_RECV_OVERFLOW_SIZE];
+      iovecs[i][1].iov_len = UDP_RECV_OVERFLOW_SIZE;
+      memset (&datagrams[i].msg_hdr, 0, sizeof (datagrams[i].msg_hdr));
+      datagrams[i].msg_hdr.msg_name = &addrs[i];
+      datagrams[i].msg_hdr.msg_namelen = sizeof (struct sockaddr_in);
+      datagrams[i].msg_hdr.msg_iov = iovecs[i];
+      datagrams[i].msg_hdr.msg_iovlen = 2;
+    }
+
+    if ((nb_datagrams = recvmmsg (udp_sock_pP->sd, datagrams, UDP_RECV_BATCH_SIZE, 0, NULL)) < 0) {
+      if ((errno != EAGAIN) && (errno != EWOULDBLOCK)) {
+        OAILOG_ERROR (LOG_UDP, "Recvmmsg failed %s\n", strerror (errno));
+      }
+      break;
+    }
+
+    for (i = 0; i < nb_datagrams; i++) {
       MessageDef                             *message_p = NULL;
       udp_data_ind_t                         *udp_data_ind_p;
-      uint8_t                                *forwarded_buffer = NULL;
+      task_id_t                               task_id = udp_sock_pP->task_id;
+
+      if (datagrams[i].msg_hdr.msg_flags & MSG_TRUNC) {
+        OAILOG_ERROR (LOG_UDP, "Datagram from %s:%u larger than %d bytes, discarded\n", inet_ntoa (addrs[i].sin_addr), ntohs (addrs[i].sin_port), UDP_MAX_DATAGRAM_SIZE);
+        continue;
+      }
+      if (datagrams[i].msg_len > UDP_RECV_BUFFER_SIZE) {
+        uint8_t                                *buffer = itti_malloc (TASK_UDP, udp_sock_pP->task_id, datagrams[i].msg_len);
 
-      AssertFatal (sizeof (udp_sock_pP->buffer) >= bytes_received, "UDP BUFFER OVERFLOW");
-      forwarded_buffer = itti_malloc (TASK_UDP, udp_sock_pP->task_id, bytes_received);
-      DevAssert (forwarded_buffer != NULL);
-      memcpy (forwarded_buffer, udp_sock_pP->buffer, bytes_received);
+        memcpy (buffer, udp_sock_pP->buffers[i], UDP_RECV_BUFFER_SIZE);
+        memcpy (&buffer[UDP_RECV_BUFFER_SIZE], iovecs[i][1].iov_base, datagrams[i].msg_len - UDP_RECV_BUFFER_SIZE);
+        itti_free (TASK_UDP, udp_sock_pP->buffers[i]);
+        udp_sock_pP->buffers[i] = buffer;
+      }
       message_p = itti_alloc_new_message (TASK_UDP, UDP_DATA_IND);
       DevAssert (message_p != NULL);
       udp_data_ind_p = &message_p->ittiMsg.udp_data_ind;
-      udp_data_ind_p->buffer = forwarded_buffer;
-      udp_data_ind_p->buffer_length = bytes_received;
-      udp_data_ind_p->peer_port = htons (addr.sin_port);
-      udp_data_ind_p->peer_address = addr.sin_addr.s_addr;
-      OAILOG_DEBUG (LOG_UDP, "Msg of length %d received from %s:%u\n", bytes_received, inet_ntoa (addr.sin_addr), ntohs (addr.sin_port));
-
-      if (itti_send_msg_to_task (udp_sock_pP->task_id, INSTANCE_DEFAULT, message_p) < 0) {
-        OAILOG_DEBUG (LOG_UDP, "Failed to send message %d to task %d\n", UDP_DATA_IND, udp_sock_pP->task_id);
-        //break;
+      udp_data_ind_p->buffer = udp_sock_pP->buffers[i];
+      udp_data_ind_p->buffer_length = datagrams[i].msg_len;
+      udp_data_ind_p->peer_port = htons (addrs[i].sin_port);
+      udp_data_ind_p->peer_address = addrs[i].sin_addr.s_addr;
+      udp_sock_pP->buffers[i] = NULL;
+      OAILOG_DEBUG (LOG_UDP, "Msg of length %u received from %s:%u\n", datagrams[i].msg_len, inet_ntoa (addrs[i].sin_addr), ntohs (addrs[i].sin_port));
+
+      if (udp_sock_pP->nb_tasks > 1) {
+        task_id += udp_sock_pP->steer (udp_data_ind_p->buffer, udp_data_ind_p->buffer_length, udp_sock_pP->nb_tasks) % udp_sock_pP->nb_tasks;
+      }
+
+      if (itti_send_msg_to_task (task_id, INSTANCE_DEFAULT, message_p) < 0) {
+        OAILOG_DEBUG (LOG_UDP, "Failed to send message %d to task %d\n", UDP_DATA_IND, task_id);
       }
     }
+  } while (nb_datagrams == UDP_RECV_BATCH_SIZE);
+}
+
+/* @brief Sends the datagrams of the batch and frees their buffers
+*/
+static void
+udp_server_flush_send_batch (
+  void)
+{
+  struct udp_send_batch_s                *batch = &udp_send_batch;
+  unsigned int                            nb_sent = 0;
+  int                                     rc;
+
+  while (nb_sent < batch->nb_datagrams) {
+    if ((rc = sendmmsg (batch->sd, &batch->datagrams[nb_sent], batch->nb_datagrams - nb_sent, 0)) < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      OAILOG_ERROR (LOG_UDP, "There was an error while writing to socket " "(%d:%s)\n", errno, strerror (errno));
+      // skip the datagram in error, send the others
+      rc = 1;
+    }
+    nb_sent += rc;
   }
-  //close(udp_sock_pP->sd);
-  //udp_sock_pP->sd = -1;
-  //pthread_mutex_lock(&udp_socket_list_mutex);
-  //STAILQ_REMOVE(&udp_socket_list, udp_sock_pP, udp_socket_desc_s, entries);
-  //pthread_mutex_unlock(&udp_socket_list_mutex);
-  //return NULL;
+
+  for (unsigned int i = 0; i < batch->nb_datagrams; i++) {
+    itti_free (batch->task_ids[i], batch->buffers[i]);
+  }
+  batch->nb_datagrams = 0;
+  batch->sd = -1;
+}
+
+/* @brief Adds an UDP_DATA_REQ to the batch, the datagrams of a batch go to
+ * the same socket
+*/
+static void
+udp_server_queue_data_req (
+  int sd,
+  task_id_t task_id,
+  udp_data_req_t * udp_data_req_p)
+{
+  struct udp_send_batch_s                *batch = &udp_send_batch;
+  unsigned int                            i;
+
+  if ((batch->sd != sd) || (batch->nb_datagrams == UDP_SEND_BATCH_SIZE)) {
+    udp_server_flush_send_batch ();
+  }
+  batch->sd = sd;
+  i = batch->nb_datagrams++;
+  memset (&batch->peer_addrs[i], 0, sizeof (struct sockaddr_in));
+  batch->peer_addrs[i].sin_family = AF_INET;
+  batch->peer_addrs[i].sin_port = htons (udp_data_req_p->peer_port);
+  batch->peer_addrs[i].sin_addr.s_addr = udp_data_req_p->peer_address;
+  batch->iovecs[i].iov_base = &udp_data_req_p->buffer[udp_data_req_p->buffer_offset];
+  batch->iovecs[i].iov_len = udp_data_req_p->buffer_length;
+  memset (&batch->datagrams[i], 0, sizeof (batch->datagrams[i]));
+  batch->datagrams[i].msg_hdr.msg_name = &batch->peer_addrs[i];
+  batch->datagrams[i].msg_hdr.msg_namelen = sizeof (struct sockaddr_in);
+  batch->datagrams[i].msg_hdr.msg_iov = &batch->iovecs[i];
+  batch->datagrams[i].msg_hdr.msg_iovlen = 1;
+  batch->buffers[i] = udp_data_req_p->buffer;
+  batch->task_ids[i] = task_id;
 }
 
 
@@ -256,64 +380,55 @@ udp_intertask_interface (
 {
   int                                     rc = 0;
   int                                     nb_events = 0;
+  int                                     nb_messages = 0;
   struct epoll_event                     *events = NULL;
+  MessageDef                             *received_messages[UDP_SEND_BATCH_SIZE];
 
   itti_mark_task_ready (TASK_UDP);
   OAILOG_START_USE ();
   MSC_START_USE ();
 
   while (1) {
-    MessageDef                             *received_message_p = NULL;
+    /*
+     * The UDP_DATA_REQ received together are sent by batches
+     */
+    nb_messages = itti_receive_msgs (TASK_UDP, received_messages, UDP_SEND_BATCH_SIZE);
 
-    itti_receive_msg (TASK_UDP, &received_message_p);
+    for (int m = 0; m < nb_messages; m++) {
+      MessageDef                             *received_message_p = received_messages[m];
 
-    if (received_message_p != NULL) {
       switch (ITTI_MSG_ID (received_message_p)) {
       case UDP_INIT:{
           udp_init_t                             *udp_init_p = &received_message_p->ittiMsg.udp_init;
-          rc = udp_server_create_socket (udp_init_p->port, udp_init_p->address, ITTI_MSG_ORIGIN_ID (received_message_p));
+          rc = udp_server_create_socket (udp_init_p->port, udp_init_p->address, ITTI_MSG_ORIGIN_ID (received_message_p), udp_init_p->nb_tasks, udp_init_p->steer);
         }
         break;
 
       case UDP_DATA_REQ:{
           int                                     udp_sd = -1;
-          ssize_t                                 bytes_written;
           struct udp_socket_desc_s               *udp_sock_p = NULL;
           udp_data_req_t                         *udp_data_req_p;
-          struct sockaddr_in                      peer_addr;
 
           udp_data_req_p = &received_message_p->ittiMsg.udp_data_req;
-          //UDP_DEBUG("-- UDP_DATA_REQ -----------------------------------------------------\n%s :\n",
-          //        __FUNCTION__);
-          //udp_print_hex_octets(&udp_data_req_p->buffer[udp_data_req_p->buffer_offset],
-          //        udp_data_req_p->buffer_length);
-          memset (&peer_addr, 0, sizeof (struct sockaddr_in));
-          peer_addr.sin_family = AF_INET;
-          peer_addr.sin_port = htons (udp_data_req_p->peer_port);
-          peer_addr.sin_addr.s_addr = udp_data_req_p->peer_address;
           pthread_mutex_lock (&udp_socket_list_mutex);
           udp_sock_p = udp_server_get_socket_desc (ITTI_MSG_ORIGIN_ID (received_message_p));
 
           if (udp_sock_p == NULL) {
             OAILOG_ERROR (LOG_UDP, "Failed to retrieve the udp socket descriptor " "associated with task %d\n", ITTI_MSG_ORIGIN_ID (received_message_p));
             pthread_mutex_unlock (&udp_socket_list_mutex);
-            // no free udp_data_req_p->buffer, statically allocated
-            goto on_error;
+            itti_free (ITTI_MSG_ORIGIN_ID (received_message_p), udp_data_req_p->buffer);
+            break;
           }
 
           udp_sd = udp_sock_p->sd;
           pthread_mutex_unlock (&udp_socket_list_mutex);
           OAILOG_DEBUG (LOG_UDP, "[%d] Sending message of size %u to " IPV4_ADDR " and port %u\n", udp_sd, udp_data_req_p->buffer_length, IPV4_ADDR_FORMAT (udp_data_req_p->peer_address), udp_data_req_p->peer_port);
-          bytes_written = sendto (udp_sd, &udp_data_req_p->buffer[udp_data_req_p->buffer_offset], udp_data_req_p->buffer_length, 0, (struct sockaddr *)&peer_addr, sizeof (struct sockaddr_in));
-          // no free udp_data_req_p->buffer, statically allocated
-
-          if (bytes_written != udp_data_req_p->buffer_length) {
-            OAILOG_ERROR (LOG_UDP, "There was an error while writing to socket " "(%d:%s)\n", errno, strerror (errno));
-          }
+          udp_server_queue_data_req (udp_sd, ITTI_MSG_ORIGIN_ID (received_message_p), udp_data_req_p);
         }
         break;
 
       case TERMINATE_MESSAGE:{
+          udp_server_flush_send_batch ();
           itti_exit_task ();
         }
         break;
@@ -328,12 +443,11 @@ udp_intertask_interface (
         break;
       }
 
-    on_error:
       rc = itti_free (ITTI_MSG_ORIGIN_ID (received_message_p), received_message_p);
       AssertFatal (rc == EXIT_SUCCESS, "Failed to free memory (%d)!\n", rc);
-      received_message_p = NULL;
     }
 
+    udp_server_flush_send_batch ();
     nb_events = itti_get_events (TASK_UDP, &events);
 
     if ((nb_events > 0) && (events != NULL)) {
@@ -31,6 +31,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <inttypes.h>
+#include <sched.h>
 #include "dynamic_memory_check.h"
 #include "hashtable.h"
 #include "assertions.h"
@@ -85,12 +86,19 @@ void hash_free_int_func (void **memoryP) {}
 /*
    Default hash function
    def_hashfunc() is the default used by hashtable_create() when the user didn't specify one.
-   This is a simple/naive hash function which adds the key's ASCII char values. It will probably generate lots of collisions on large hash tables.
+   Keys are often small integers (S1AP ids, TEIDs) or IMSIs differing only in their last digits, the key bits are mixed
+   (finalizer of MurmurHash3) so that they spread over all buckets, which open addressing requires.
 */
-
 static inline hash_size_t def_hashfunc (const uint64_t keyP)
 {
-  return (hash_size_t) keyP;
+  uint64_t                                h = keyP;
+
+  h ^= h >> 33;
+  h *= UINT64_C(0xff51afd7ed558ccd);
+  h ^= h >> 33;
+  h *= UINT64_C(0xc4ceb9fe1a85ec53);
+  h ^= h >> 33;
+  return (hash_size_t) h;
 }
 
 //------------------------------------------------------------------------------
@@ -179,104 +187,6 @@ hashtable_create (
   return hashtbl;
 }
 
-//------------------------------------------------------------------------------
-/*
-   Initialization
-   hashtable_ts_create() sets up the initial structure of the thread safe hash table. The user specified size will be allocated and initialized to NULL.
-   The user can also specify a hash function. If the hashfunc argument is NULL, a default hash function is used.
-   If an error occurred, NULL is returned. All other values in the returned hash_table_t pointer should be released with hashtable_destroy().
-*/
-hash_table_ts_t * hashtable_ts_init (hash_table_ts_t * const hashtblP,
-    const hash_size_t sizeP,
-    hash_size_t (*hashfuncP) (const hash_key_t),
-    void (*freefuncP) (void **),
-    bstring display_name_pP)
-{
-  hash_size_t size = sizeP;
-  // upper power of two: http://graphics.stanford.edu/~seander/bithacks.html#RoundUpPowerOf2Float
-  //  By Sean Eron Anderson
-  // seander@cs.stanford.edu
-  // Individually, the code snippets here are in the public domain (unless otherwise noted) — feel free to use them however you please.
-  // The aggregate collection and descriptions are © 1997-2005 Sean Eron Anderson. The code and descriptions are distributed in the hope
-  // that they will be useful, but WITHOUT ANY WARRANTY and without even the implied warranty of merchantability or fitness for a particular
-  // purpose. As of May 5, 2005, all the code has been tested thoroughly. Thousands of people have read it. Moreover, Professor Randal Bryant,
-  // the Dean of Computer Science at Carnegie Mellon University, has personally tested almost everything with his Uclid code verification system.
-  // What he hasn't tested, I have checked against all possible inputs on a 32-bit machine. To the first person to inform me of a legitimate bug
-  // in the code, I'll pay a bounty of US$10 (by check or Paypal). If directed to a charity, I'll pay US$20.
-  size--;
-  size |= size >> 1;
-  size |= size >> 2;
-  size |= size >> 4;
-  size |= size >> 8;
-  size |= size >> 16;
-  size++;
-
-  memset(hashtblP, 0, sizeof(*hashtblP));
-
-  if (!(hashtblP->nodes = calloc (size, sizeof (hash_node_t *)))) {
-    free_wrapper((void **) &hashtblP);
-    return NULL;
-  }
-
-  if (!(hashtblP->lock_nodes = calloc (size, sizeof (pthread_mutex_t)))) {
-    free_wrapper((void **) &hashtblP->nodes);
-    free_wrapper((void **) &hashtblP->name);
-    free_wrapper((void **) &hashtblP);
-    return NULL;
-  }
-
-  pthread_mutex_init(&hashtblP->mutex, NULL);
-  for (int i = 0; i < size; i++) {
-    pthread_mutex_init(&hashtblP->lock_nodes[i], NULL);
-  }
-
-  hashtblP->size = size;
-
-  if (hashfuncP)
-    hashtblP->hashfunc = hashfuncP;
-  else
-    hashtblP->hashfunc = def_hashfunc;
-
-  if (freefuncP)
-    hashtblP->freefunc = freefuncP;
-  else
-    hashtblP->freefunc = free_wrapper;
-
-  if (display_name_pP) {
-    hashtblP->name = bstrcpy(display_name_pP);
-  } else {
-    hashtblP->name = bfromcstr ("hashtable@0123456789ABCDEF");
-    btrunc(hashtblP->name, 0);
-    bassignformat(hashtblP->name,"hashtable@%p", hashtblP);
-  }
-  hashtblP->is_allocated_by_malloc = false;
-  hashtblP->log_enabled = true;
-  return hashtblP;
-}
-//------------------------------------------------------------------------------
-/*
-   Initialization
-   hashtable_ts_create() allocate and sets up the initial structure of the thread safe hash table. The user specified size will be allocated and initialized to NULL.
-   The user can also specify a hash function. If the hashfunc argument is NULL, a default hash function is used.
-   If an error occurred, NULL is returned. All other values in the returned hash_table_t pointer should be released with hashtable_destroy().
-*/
-hash_table_ts_t                           *
-hashtable_ts_create (
-  const hash_size_t sizeP,
-  hash_size_t (*hashfuncP) (const hash_key_t),
-  void (*freefuncP) (void **),
-  bstring display_name_pP)
-{
-  hash_table_ts_t                           *hashtbl = NULL;
-
-  if (!(hashtbl = calloc (1, sizeof (hash_table_ts_t)))) {
-    return NULL;
-  }
-  hashtbl =  hashtable_ts_init(hashtbl, sizeP, hashfuncP, freefuncP, display_name_pP);
-  hashtbl->is_allocated_by_malloc = true;
-  return hashtbl;
-}
-
 //------------------------------------------------------------------------------
 /*
    Cleanup
@@ -317,52 +227,6 @@ hashtable_destroy (
   return HASH_TABLE_OK;
 }
 
-//------------------------------------------------------------------------------
-/*
-   Cleanup
-   The hashtable_destroy() walks through the linked lists for each possible hash value, and releases the elements. It also releases the nodes array and the hash_table_t.
-*/
-hashtable_rc_t
-hashtable_ts_destroy (
-  hash_table_ts_t * hashtblP)
-{
-  hash_size_t                             n = 0;
-  hash_node_t                            *node = NULL,
-                                         *oldnode = NULL;
-
-  if (!hashtblP) {
-    return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
-  }
-
-  for (n = 0; n < hashtblP->size; ++n) {
-    pthread_mutex_lock (&hashtblP->lock_nodes[n]);
-    node = hashtblP->nodes[n];
-
-    while (node) {
-      oldnode = node;
-      node = node->next;
-
-      if (oldnode->data) {
-        hashtblP->freefunc (&oldnode->data);
-      }
-
-      free_wrapper((void **) &oldnode);
-    }
-
-    pthread_mutex_unlock (&hashtblP->lock_nodes[n]);
-    pthread_mutex_destroy (&hashtblP->lock_nodes[n]);
-  }
-
-  free_wrapper((void **) &hashtblP->nodes);
-  free_wrapper((void **) &hashtblP->name);
-  if (hashtblP->is_allocated_by_malloc) {
-    free_wrapper((void **) &hashtblP);
-  }
-  return HASH_TABLE_OK;
-}
-
-
-
 //------------------------------------------------------------------------------
 hashtable_rc_t
 hashtable_is_key_exists (
@@ -393,39 +257,6 @@ hashtable_is_key_exists (
 
 
 
-//------------------------------------------------------------------------------
-hashtable_rc_t
-hashtable_ts_is_key_exists (
-  const hash_table_ts_t * const hashtblP,
-  const hash_key_t keyP)
-{
-  hash_node_t                            *node = NULL;
-  hash_size_t                             hash = 0;
-
-  if (!hashtblP) {
-    return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
-  }
-
-  hash = hashtblP->hashfunc (keyP) % hashtblP->size;
-  pthread_mutex_lock (&hashtblP->lock_nodes[hash]);
-  node = hashtblP->nodes[hash];
-
-  while (node) {
-    if (node->key == keyP) {
-      pthread_mutex_unlock (&hashtblP->lock_nodes[hash]);
-      PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP);
-      return HASH_TABLE_OK;
-    }
-
-    node = node->next;
-  }
-  pthread_mutex_unlock (&hashtblP->lock_nodes[hash]);
-  PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return KEY_NOT_EXISTS\n", __FUNCTION__, bdata(hashtblP->name), keyP);
-  return HASH_TABLE_KEY_NOT_EXISTS;
-}
-
-
-
 //------------------------------------------------------------------------------
 // may cost a lot CPU...
 // Also useful if we want to find an element in the collection based on compare criteria different than the single key
@@ -466,50 +297,6 @@ hashtable_apply_callback_on_elements (
   return HASH_TABLE_OK;
 }
 
-//------------------------------------------------------------------------------
-// may cost a lot CPU...
-// Also useful if we want to find an element in the collection based on compare criteria different than the single key
-// The compare criteria in implemented in the funct_cb function
-hashtable_rc_t
-hashtable_ts_apply_callback_on_elements (
-  hash_table_ts_t * const hashtblP,
-  bool funct_cb (const hash_key_t keyP,
-               void * const dataP,
-               void *parameterP,
-               void ** resultP),
-  void *parameterP,
-  void** resultP)
-{
-  hash_node_t                            *node = NULL;
-  unsigned int                            i = 0;
-  unsigned int                            num_elements = 0;
-
-  if (!hashtblP) {
-    return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
-  }
-
-  while ((num_elements < hashtblP->num_elements) && (i < hashtblP->size)) {
-    pthread_mutex_lock(&hashtblP->lock_nodes[i]);
-    if (hashtblP->nodes[i] != NULL) {
-      node = hashtblP->nodes[i];
-
-      while (node) {
-        num_elements++;
-        if (funct_cb (node->key, node->data, parameterP, resultP)) {
-          pthread_mutex_unlock(&hashtblP->lock_nodes[i]);
-          return HASH_TABLE_OK;
-        }
-        node = node->next;
-      }
-    }
-    pthread_mutex_unlock(&hashtblP->lock_nodes[i]);
-    i++;
-  }
-
-  return HASH_TABLE_OK;
-}
-
-
 //------------------------------------------------------------------------------
 hashtable_rc_t
 hashtable_dump_content (
@@ -545,45 +332,6 @@ hashtable_dump_content (
   return HASH_TABLE_OK;
 }
 
-//------------------------------------------------------------------------------
-hashtable_rc_t
-hashtable_ts_dump_content (
-  const hash_table_ts_t * const hashtblP,
-  bstring str)
-{
-  hash_node_t                            *node = NULL;
-  unsigned int                            i = 0;
-
-  if (!hashtblP) {
-    bcatcstr(str, "HASH_TABLE_BAD_PARAMETER_HASHTABLE");
-    return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
-  }
-
-  while (i < hashtblP->size) {
-    if (hashtblP->nodes[i] != NULL) {
-      pthread_mutex_lock(&hashtblP->lock_nodes[i]);
-      node = hashtblP->nodes[i];
-
-      while (node) {
-        bstring b0 = bformat ("Key 0x%"PRIx64" Element %p Node %p Next %p\n", node->key, node->data, node, node->next);
-        if (!b0) {
-          PRINT_HASHTABLE (hashtblP, "Error while dumping hashtable content");
-        } else {
-          bconcat(str, b0);
-          bdestroy(b0);
-        }
-        node = node->next;
-
-      }
-      pthread_mutex_unlock(&hashtblP->lock_nodes[i]);
-    }
-    i += 1;
-  }
-  return HASH_TABLE_OK;
-}
-
-
-
 //------------------------------------------------------------------------------
 /*
    Adding a new element
@@ -641,79 +389,16 @@ hashtable_insert (
 
 //------------------------------------------------------------------------------
 /*
-   Adding a new element
-   To make sure the hash value is not bigger than size, the result of the user provided hash function is used modulo size.
+   To free_wrapper an element from the hash table, we just search for it in the linked list for that hash value,
+   and free_wrapper it if it is found. If it was not found, it is an error and -1 is returned.
 */
 hashtable_rc_t
-hashtable_ts_insert (
-  hash_table_ts_t * const hashtblP,
-  const hash_key_t keyP,
-  void *dataP)
+hashtable_free (
+  hash_table_t * const hashtblP,
+  const hash_key_t keyP)
 {
-  hash_node_t                            *node = NULL;
-  hash_size_t                             hash = 0;
-
-  if (!hashtblP) {
-    return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
-  }
-
-  hash = hashtblP->hashfunc (keyP) % hashtblP->size;
-  pthread_mutex_lock(&hashtblP->lock_nodes[hash]);
-  node = hashtblP->nodes[hash];
-
-  while (node) {
-    if (node->key == keyP) {
-      if (node->data) {
-        hashtblP->freefunc (&node->data);
-      }
-      node->data = dataP;
-      pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
-      PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64" data %p) return INSERT_OVERWRITTEN_DATA\n", __FUNCTION__, bdata(hashtblP->name), keyP, dataP);
-      return HASH_TABLE_INSERT_OVERWRITTEN_DATA;
-    }
-
-    node = node->next;
-  }
-
-  if (!(node = malloc (sizeof (hash_node_t))))
-    return -1;
-
-  node->key = keyP;
-  node->data = dataP;
-
-  if (hashtblP->nodes[hash]) {
-    node->next = hashtblP->nodes[hash];
-  } else {
-    node->next = NULL;
-  }
-
-  hashtblP->nodes[hash] = node;
-  __sync_fetch_and_add (&hashtblP->num_elements, 1);
-  pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
-  PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64" data %p) next %p return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP, dataP, node->next);
-#define TEMPORARY_DEBUG 1
-#if TEMPORARY_DEBUG
-  bstring b = bfromcstr(" ");
-  hashtable_ts_dump_content(hashtblP, b);
-  PRINT_HASHTABLE (hashtblP, "%s:%s\n", bdata(hashtblP->name), bdata(b));
-#endif
-  return HASH_TABLE_OK;
-}
-
-
-
-//------------------------------------------------------------------------------
-/*
-   To free_wrapper an element from the hash table, we just search for it in the linked list for that hash value,
-   and free_wrapper it if it is found. If it was not found, it is an error and -1 is returned.
-*/
-hashtable_rc_t
-hashtable_free (
-  hash_table_t * const hashtblP,
-  const hash_key_t keyP)
-{
-  hash_node_t                            *node,
-                                         *prevnode = NULL;
+  hash_node_t                            *node,
+                                         *prevnode = NULL;
   hash_size_t                             hash = 0;
 
   if (!hashtblP) {
@@ -749,57 +434,6 @@ hashtable_free (
 }
 
 
-//------------------------------------------------------------------------------
-/*
-   To free_wrapper an element from the hash table, we just search for it in the linked list for that hash value,
-   and free_wrapper it if it is found. If it was not found, it is an error and -1 is returned.
-*/
-hashtable_rc_t
-hashtable_ts_free (
-  hash_table_ts_t * const hashtblP,
-  const hash_key_t keyP)
-{
-  hash_node_t                            *node,
-                                         *prevnode = NULL;
-  hash_size_t                             hash = 0;
-
-  if (!hashtblP) {
-    return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
-  }
-
-  hash = hashtblP->hashfunc (keyP) % hashtblP->size;
-  pthread_mutex_lock(&hashtblP->lock_nodes[hash]);
-  node = hashtblP->nodes[hash];
-
-  while (node) {
-    if (node->key == keyP) {
-      if (prevnode)
-        prevnode->next = node->next;
-      else
-        hashtblP->nodes[hash] = node->next;
-
-      if (node->data) {
-        hashtblP->freefunc (&node->data);
-      }
-
-      free_wrapper((void **) &node);
-      __sync_fetch_and_sub (&hashtblP->num_elements, 1);
-      pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
-      PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP);
-      return HASH_TABLE_OK;
-    }
-
-    prevnode = node;
-    node = node->next;
-  }
-
-   pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
-   PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return KEY_NOT_EXISTS\n", __FUNCTION__, bdata(hashtblP->name), keyP);
-  return HASH_TABLE_KEY_NOT_EXISTS;
-}
-
-
-
 //------------------------------------------------------------------------------
 /*
    To remove an element from the hash table, we just search for it in the linked list for that hash value,
@@ -845,54 +479,6 @@ hashtable_remove (
 }
 
 
-//------------------------------------------------------------------------------
-/*
-   To remove an element from the hash table, we just search for it in the linked list for that hash value,
-   and remove it if it is found. If it was not found, it is an error and -1 is returned.
-*/
-hashtable_rc_t
-hashtable_ts_remove (
-  hash_table_ts_t * const hashtblP,
-  const hash_key_t keyP,
-  void **dataP)
-{
-  hash_node_t                            *node,
-                                         *prevnode = NULL;
-  hash_size_t                             hash = 0;
-
-  if (!hashtblP) {
-    return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
-  }
-
-  hash = hashtblP->hashfunc (keyP) % hashtblP->size;
-  pthread_mutex_lock(&hashtblP->lock_nodes[hash]);
-  node = hashtblP->nodes[hash];
-
-  while (node) {
-    if (node->key == keyP) {
-      if (prevnode)
-        prevnode->next = node->next;
-      else
-        hashtblP->nodes[hash] = node->next;
-
-      *dataP = node->data;
-      free_wrapper((void **) &node);
-      __sync_fetch_and_sub (&hashtblP->num_elements, 1);
-      pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
-      PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP);
-      return HASH_TABLE_OK;
-    }
-
-    prevnode = node;
-    node = node->next;
-  }
-  pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
-
-  PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return KEY_NOT_EXISTS\n", __FUNCTION__, bdata(hashtblP->name), keyP);
-  return HASH_TABLE_KEY_NOT_EXISTS;
-}
-
-
 //------------------------------------------------------------------------------
 /*
    Searching for an element is easy. We just search through the linked list for the corresponding hash value.
@@ -930,52 +516,6 @@ hashtable_get (
 }
 
 
-//------------------------------------------------------------------------------
-/*
-   Searching for an element is easy. We just search through the linked list for the corresponding hash value.
-   NULL is returned if we didn't find it.
-*/
-hashtable_rc_t
-hashtable_ts_get (
-  const hash_table_ts_t * const hashtblP,
-  const hash_key_t keyP,
-  void **dataP)
-{
-  hash_node_t                            *node = NULL;
-  hash_size_t                             hash = 0;
-
-  *dataP = NULL;
-  if (!hashtblP) {
-    return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
-  }
-
-  hash = hashtblP->hashfunc (keyP) % hashtblP->size;
-
-  pthread_mutex_lock(&hashtblP->lock_nodes[hash]);
-  node = hashtblP->nodes[hash];
-
-  while (node) {
-    if (node->key == keyP) {
-      *dataP = node->data;
-      pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
-      PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64" data %p) return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP, *dataP);
-      return HASH_TABLE_OK;
-    }
-
-    node = node->next;
-  }
-  pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
-  PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return KEY_NOT_EXISTS\n", __FUNCTION__, bdata(hashtblP->name), keyP);
-
-#define TEMPORARY_DEBUG 1
-#if TEMPORARY_DEBUG
-  bstring b = bfromcstr(" ");
-  hashtable_ts_dump_content(hashtblP, b);
-  PRINT_HASHTABLE (hashtblP, "%s:%s\n", bdata(hashtblP->name), bdata(b));
-#endif
-  return HASH_TABLE_KEY_NOT_EXISTS;
-}
-
 //------------------------------------------------------------------------------
 /*
    Resizing
@@ -1043,80 +583,724 @@ hashtable_resize (
 }
 
 
+
+
 //------------------------------------------------------------------------------
 /*
-   Resizing
-   The number of elements in a hash table is not always known when creating the table.
-   If the number of elements grows too large, it will seriously reduce the performance of most hash table operations.
-   If the number of elements are reduced, the hash table will waste memory. That is why we provide a function for resizing the table.
-   Resizing a hash table is not as easy as a realloc(). All hash values must be recalculated and each element must be inserted into its new position.
-   We create a temporary hash_table_t object (newtbl) to be used while building the new hashes.
-   This allows us to reuse hashtable_insert() and hashtable_free(), when moving the elements to the new table.
-   After that, we can just free_wrapper the old table and copy the elements from newtbl to hashtbl.
-   Dangerous not really thread safe.
+   Thread safe hash table
+   Open addressing with linear probing over arrays of inline {key, data} slots, no allocation per element.
+   Writers take the table mutex and make the sequence counter odd while they modify slots, readers never lock:
+   they read the slots with atomic loads and restart their lookup if the sequence counter changed meanwhile.
+   When the load factor exceeds HASH_TABLE_TS_MAX_LOAD_PERCENT, a slot array twice as large is allocated and
+   each following write operation migrates HASH_TABLE_TS_MIGRATE_STEP slots of the previous array, lookups
+   search both arrays until the migration completes, so that no single operation pays for a full rehash.
 */
+#define HASH_TABLE_TS_MAX_LOAD_PERCENT   75
+#define HASH_TABLE_TS_MIN_SIZE           8
+#define HASH_TABLE_TS_MIGRATE_STEP       64
+#define HASH_TABLE_TS_TOMBSTONE          ((void*)1)
 
-hashtable_rc_t
-hashtable_ts_resize (
-  hash_table_ts_t * const hashtblP,
-  const hash_size_t sizeP)
+#define HASH_TABLE_TS_LOAD(lOcAtIoN)         __atomic_load_n(&(lOcAtIoN), __ATOMIC_RELAXED)
+#define HASH_TABLE_TS_STORE(lOcAtIoN, vAlUe) __atomic_store_n(&(lOcAtIoN), (vAlUe), __ATOMIC_RELAXED)
+
+//------------------------------------------------------------------------------
+static hash_size_t
+hashtable_ts_slots_for (
+  const hash_size_t num_elements)
 {
-  hash_table_ts_t                         newtbl = {.mutex = PTHREAD_MUTEX_INITIALIZER, 0};
-  hash_size_t                             n      = 0;
-  hash_node_t                            *node   = NULL,
-                                         *next   = NULL;
-  void                                   *dummy  = NULL;
+  hash_size_t                             size = HASH_TABLE_TS_MIN_SIZE;
 
-  if (!hashtblP) {
-    return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
+  while ((size * HASH_TABLE_TS_MAX_LOAD_PERCENT) / 100 < num_elements) {
+    size <<= 1;
   }
-  hash_size_t size = sizeP;
-  // upper power of two: http://graphics.stanford.edu/~seander/bithacks.html#RoundUpPowerOf2Float
-  //  By Sean Eron Anderson
-  // seander@cs.stanford.edu
-  // Individually, the code snippets here are in the public domain (unless otherwise noted) — feel free to use them however you please.
-  // The aggregate collection and descriptions are © 1997-2005 Sean Eron Anderson. The code and descriptions are distributed in the hope
-  // that they will be useful, but WITHOUT ANY WARRANTY and without even the implied warranty of merchantability or fitness for a particular
-  // purpose. As of May 5, 2005, all the code has been tested thoroughly. Thousands of people have read it. Moreover, Professor Randal Bryant,
-  // the Dean of Computer Science at Carnegie Mellon University, has personally tested almost everything with his Uclid code verification system.
-  // What he hasn't tested, I have checked against all possible inputs on a 32-bit machine. To the first person to inform me of a legitimate bug
-  // in the code, I'll pay a bounty of US$10 (by check or Paypal). If directed to a charity, I'll pay US$20.
-  size--;
-  size |= size >> 1;
-  size |= size >> 2;
-  size |= size >> 4;
-  size |= size >> 8;
-  size |= size >> 16;
-  size++;
-
-  newtbl.size = size;
-  newtbl.hashfunc = hashtblP->hashfunc;
+  return size;
+}
 
-  if (!(newtbl.nodes = calloc (size, sizeof (hash_node_t *))))
-    return HASH_TABLE_SYSTEM_ERROR;
+//------------------------------------------------------------------------------
+static hash_slots_t *
+hashtable_ts_alloc_slots (
+  const hash_size_t size)
+{
+  hash_slots_t                           *table = malloc (sizeof (hash_slots_t) + size * sizeof (hash_slot_t));
 
-  if (!(newtbl.lock_nodes = calloc (size, sizeof (pthread_mutex_t)))) {
-    free_wrapper((void **) &newtbl.nodes);
-    return HASH_TABLE_SYSTEM_ERROR;
+  if (!table) {
+    return NULL;
   }
-  for (n = 0; n < hashtblP->size; ++n) {
-    pthread_mutex_init(&newtbl.lock_nodes[n], NULL);
+  table->size = size;
+  table->retired = NULL;
+  for (hash_size_t i = 0; i < size; i++) {
+    table->slots[i].key = HASHTABLE_NOT_A_KEY_VALUE;
+    table->slots[i].data = NULL;
   }
+  return table;
+}
 
-  pthread_mutex_lock(&hashtblP->mutex);
-  for (n = 0; n < hashtblP->size; ++n) {
-    for (node = hashtblP->nodes[n]; node; node = next) {
-      next = node->next;
-      hashtable_ts_remove (hashtblP, node->key, &dummy);
-      hashtable_ts_insert (&newtbl, node->key, node->data);
-    }
+//------------------------------------------------------------------------------
+static void
+hashtable_ts_free_slots (
+  hash_slots_t * table)
+{
+  while (table) {
+    hash_slots_t                           *retired = table->retired;
+
+    free_wrapper ((void **) &table);
+    table = retired;
   }
+}
 
-  free_wrapper((void **) &hashtblP->nodes);
-  free_wrapper((void **) &hashtblP->lock_nodes);
-  hashtblP->size = newtbl.size;
-  hashtblP->nodes = newtbl.nodes;
-  hashtblP->lock_nodes = newtbl.lock_nodes;
-  pthread_mutex_unlock(&hashtblP->mutex);
-  return HASH_TABLE_OK;
+//------------------------------------------------------------------------------
+static inline void
+hashtable_ts_write_lock (
+  hash_table_ts_t * const hashtblP)
+{
+  pthread_mutex_lock (&hashtblP->mutex);
+  HASH_TABLE_TS_STORE (hashtblP->seq, hashtblP->seq + 1);
+  __atomic_thread_fence (__ATOMIC_RELEASE);
+}
+
+//------------------------------------------------------------------------------
+static inline void
+hashtable_ts_write_unlock (
+  hash_table_ts_t * const hashtblP)
+{
+  __atomic_store_n (&hashtblP->seq, hashtblP->seq + 1, __ATOMIC_RELEASE);
+  pthread_mutex_unlock (&hashtblP->mutex);
+}
+
+//------------------------------------------------------------------------------
+static inline uint32_t
+hashtable_ts_read_begin (
+  const hash_table_ts_t * const hashtblP)
+{
+  uint32_t                                seq;
+
+  while ((seq = __atomic_load_n (&hashtblP->seq, __ATOMIC_ACQUIRE)) & 1) {
+    // a writer is modifying the table, let it run if it shares our CPU
+    sched_yield ();
+  }
+  return seq;
+}
+
+//------------------------------------------------------------------------------
+static inline bool
+hashtable_ts_read_retry (
+  const hash_table_ts_t * const hashtblP,
+  const uint32_t seq)
+{
+  __atomic_thread_fence (__ATOMIC_ACQUIRE);
+  return HASH_TABLE_TS_LOAD (hashtblP->seq) != seq;
+}
+
+//------------------------------------------------------------------------------
+/*
+   Returns the slot holding keyP in table, NULL if not found. Tombstones do not end the probe sequence.
+*/
+static inline hash_slot_t *
+hashtable_ts_lookup_slot (
+  hash_slots_t * const table,
+  const hash_size_t hash,
+  const hash_key_t keyP)
+{
+  const hash_size_t                       mask = table->size - 1;
+  hash_size_t                             i = hash & mask;
+
+  for (hash_size_t n = 0; n < table->size; n++) {
+    hash_key_t                              key = HASH_TABLE_TS_LOAD (table->slots[i].key);
+
+    if (key == keyP) {
+      return &table->slots[i];
+    }
+    if ((key == HASHTABLE_NOT_A_KEY_VALUE) && (HASH_TABLE_TS_LOAD (table->slots[i].data) == NULL)) {
+      return NULL;
+    }
+    i = (i + 1) & mask;
+  }
+  return NULL;
+}
+
+//------------------------------------------------------------------------------
+/*
+   Lock free lookup, returns true if keyP was found.
+*/
+static bool
+hashtable_ts_read (
+  const hash_table_ts_t * const hashtblP,
+  const hash_key_t keyP,
+  void **dataP)
+{
+  const hash_size_t                       hash = hashtblP->hashfunc (keyP);
+  hash_slots_t                           *table = NULL;
+  hash_slot_t                            *slot = NULL;
+  void                                   *data = NULL;
+  uint32_t                                seq = 0;
+
+  do {
+    seq = hashtable_ts_read_begin (hashtblP);
+    data = NULL;
+    table = HASH_TABLE_TS_LOAD (hashtblP->table);
+    slot = hashtable_ts_lookup_slot (table, hash, keyP);
+    if (!slot) {
+      table = HASH_TABLE_TS_LOAD (hashtblP->old_table);
+      if (table) {
+        slot = hashtable_ts_lookup_slot (table, hash, keyP);
+      }
+    }
+    if (slot) {
+      data = HASH_TABLE_TS_LOAD (slot->data);
+    }
+  } while (hashtable_ts_read_retry (hashtblP, seq));
+
+  if (dataP) {
+    *dataP = data;
+  }
+  return slot != NULL;
+}
+
+//------------------------------------------------------------------------------
+/*
+   Stores a key known to be absent in table (write lock held). The current table never contains tombstones.
+*/
+static void
+hashtable_ts_insert_slot (
+  const hash_table_ts_t * const hashtblP,
+  hash_slots_t * const table,
+  const hash_key_t keyP,
+  void *dataP)
+{
+  const hash_size_t                       mask = table->size - 1;
+  hash_size_t                             i = hashtblP->hashfunc (keyP) & mask;
+
+  while (table->slots[i].key != HASHTABLE_NOT_A_KEY_VALUE) {
+    i = (i + 1) & mask;
+  }
+  HASH_TABLE_TS_STORE (table->slots[i].data, dataP);
+  HASH_TABLE_TS_STORE (table->slots[i].key, keyP);
+}
+
+//------------------------------------------------------------------------------
+/*
+   Empties a slot of the current table (write lock held): following entries of the cluster are shifted back so
+   that the table stays free of tombstones and lookups of absent keys stop at the first empty slot.
+*/
+static void
+hashtable_ts_delete_slot (
+  const hash_table_ts_t * const hashtblP,
+  hash_slots_t * const table,
+  hash_slot_t * const slot)
+{
+  const hash_size_t                       mask = table->size - 1;
+  hash_size_t                             i = (hash_size_t)(slot - table->slots);
+  hash_size_t                             j = i;
+
+  for (;;) {
+    hash_key_t                              key;
+    hash_size_t                             home;
+
+    j = (j + 1) & mask;
+    key = table->slots[j].key;
+    if (key == HASHTABLE_NOT_A_KEY_VALUE) {
+      break;
+    }
+    home = hashtblP->hashfunc (key) & mask;
+    // move the entry unless its home slot lies cyclically in ]i, j]
+    if ((j > i) ? ((home <= i) || (home > j)) : ((home <= i) && (home > j))) {
+      HASH_TABLE_TS_STORE (table->slots[i].data, table->slots[j].data);
+      HASH_TABLE_TS_STORE (table->slots[i].key, key);
+      i = j;
+    }
+  }
+  HASH_TABLE_TS_STORE (table->slots[i].key, HASHTABLE_NOT_A_KEY_VALUE);
+  HASH_TABLE_TS_STORE (table->slots[i].data, NULL);
+}
+
+//------------------------------------------------------------------------------
+/*
+   Moves up to max_slots slots of the table being migrated to the current table (write lock held).
+*/
+static void
+hashtable_ts_migrate (
+  hash_table_ts_t * const hashtblP,
+  const hash_size_t max_slots)
+{
+  hash_slots_t                           *old_table = hashtblP->old_table;
+
+  for (hash_size_t n = 0; old_table && (n < max_slots); n++) {
+    hash_slot_t                            *slot = &old_table->slots[hashtblP->migrate_index];
+
+    if (slot->key != HASHTABLE_NOT_A_KEY_VALUE) {
+      hashtable_ts_insert_slot (hashtblP, hashtblP->table, slot->key, slot->data);
+      HASH_TABLE_TS_STORE (slot->key, HASHTABLE_NOT_A_KEY_VALUE);
+      HASH_TABLE_TS_STORE (slot->data, HASH_TABLE_TS_TOMBSTONE);
+    }
+    if (++hashtblP->migrate_index == old_table->size) {
+      // readers may still be walking the old slots, release them with the table
+      hashtblP->table->retired = old_table;
+      HASH_TABLE_TS_STORE (hashtblP->old_table, NULL);
+      old_table = NULL;
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+/*
+   Starts the migration to a new slot array of sizeP slots (write lock held).
+*/
+static hashtable_rc_t
+hashtable_ts_grow (
+  hash_table_ts_t * const hashtblP,
+  const hash_size_t sizeP)
+{
+  hash_slots_t                           *table = NULL;
+
+  if (hashtblP->old_table) {
+    hashtable_ts_migrate (hashtblP, hashtblP->old_table->size);
+  }
+  if (!(table = hashtable_ts_alloc_slots (sizeP))) {
+    return HASH_TABLE_SYSTEM_ERROR;
+  }
+  hashtblP->migrate_index = 0;
+  HASH_TABLE_TS_STORE (hashtblP->old_table, hashtblP->table);
+  HASH_TABLE_TS_STORE (hashtblP->table, table);
+  hashtblP->size = sizeP;
+  PRINT_HASHTABLE (hashtblP, "%s(%s) resized to %zu slots\n", __FUNCTION__, bdata(hashtblP->name), sizeP);
+  return HASH_TABLE_OK;
+}
+
+//------------------------------------------------------------------------------
+/*
+   Lookup in both slot arrays (write lock held).
+*/
+static hash_slot_t *
+hashtable_ts_find (
+  hash_table_ts_t * const hashtblP,
+  const hash_key_t keyP,
+  hash_slots_t ** const tableP)
+{
+  const hash_size_t                       hash = hashtblP->hashfunc (keyP);
+  hash_slot_t                            *slot = hashtable_ts_lookup_slot (hashtblP->table, hash, keyP);
+
+  *tableP = hashtblP->table;
+  if (!slot && hashtblP->old_table) {
+    slot = hashtable_ts_lookup_slot (hashtblP->old_table, hash, keyP);
+    *tableP = hashtblP->old_table;
+  }
+  return slot;
+}
+
+//------------------------------------------------------------------------------
+/*
+   Removes the entry held by slot from table (write lock held).
+*/
+static void
+hashtable_ts_remove_slot (
+  hash_table_ts_t * const hashtblP,
+  hash_slots_t * const table,
+  hash_slot_t * const slot)
+{
+  if (table == hashtblP->old_table) {
+    HASH_TABLE_TS_STORE (slot->key, HASHTABLE_NOT_A_KEY_VALUE);
+    HASH_TABLE_TS_STORE (slot->data, HASH_TABLE_TS_TOMBSTONE);
+  } else {
+    hashtable_ts_delete_slot (hashtblP, table, slot);
+  }
+  hashtblP->num_elements -= 1;
+}
+
+//------------------------------------------------------------------------------
+/*
+   Initialization
+   hashtable_ts_init() sets up the initial structure of the thread safe hash table, sized to hold sizeP elements
+   without being resized. The user can also specify a hash function. If the hashfunc argument is NULL, a default
+   hash function is used; a user hash function must spread keys over all the bits of its result.
+   If an error occurred, NULL is returned. All other values in the returned hash_table_t pointer should be released with hashtable_destroy().
+*/
+hash_table_ts_t * hashtable_ts_init (hash_table_ts_t * const hashtblP,
+    const hash_size_t sizeP,
+    hash_size_t (*hashfuncP) (const hash_key_t),
+    void (*freefuncP) (void **),
+    bstring display_name_pP)
+{
+  hash_size_t size = hashtable_ts_slots_for (sizeP);
+
+  memset(hashtblP, 0, sizeof(*hashtblP));
+
+  if (!(hashtblP->table = hashtable_ts_alloc_slots (size))) {
+    return NULL;
+  }
+
+  pthread_mutex_init(&hashtblP->mutex, NULL);
+  hashtblP->size = size;
+
+  if (hashfuncP)
+    hashtblP->hashfunc = hashfuncP;
+  else
+    hashtblP->hashfunc = def_hashfunc;
+
+  if (freefuncP)
+    hashtblP->freefunc = freefuncP;
+  else
+    hashtblP->freefunc = free_wrapper;
+
+  if (display_name_pP) {
+    hashtblP->name = bstrcpy(display_name_pP);
+  } else {
+    hashtblP->name = bfromcstr ("hashtable@0123456789ABCDEF");
+    btrunc(hashtblP->name, 0);
+    bassignformat(hashtblP->name,"hashtable@%p", hashtblP);
+  }
+  hashtblP->is_allocated_by_malloc = false;
+  hashtblP->log_enabled = true;
+  return hashtblP;
+}
+
+//------------------------------------------------------------------------------
+/*
+   Initialization
+   hashtable_ts_create() allocate and sets up the initial structure of the thread safe hash table.
+   If an error occurred, NULL is returned. All other values in the returned hash_table_t pointer should be released with hashtable_destroy().
+*/
+hash_table_ts_t                           *
+hashtable_ts_create (
+  const hash_size_t sizeP,
+  hash_size_t (*hashfuncP) (const hash_key_t),
+  void (*freefuncP) (void **),
+  bstring display_name_pP)
+{
+  hash_table_ts_t                           *hashtbl = NULL;
+
+  if (!(hashtbl = calloc (1, sizeof (hash_table_ts_t)))) {
+    return NULL;
+  }
+  if (!hashtable_ts_init(hashtbl, sizeP, hashfuncP, freefuncP, display_name_pP)) {
+    free_wrapper((void **) &hashtbl);
+    return NULL;
+  }
+  hashtbl->is_allocated_by_malloc = true;
+  return hashtbl;
+}
+
+//------------------------------------------------------------------------------
+/*
+   Cleanup
+   The hashtable_ts_destroy() releases the elements, the slot arrays and the hash_table_ts_t.
+*/
+hashtable_rc_t
+hashtable_ts_destroy (
+  hash_table_ts_t * hashtblP)
+{
+  hash_slots_t                           *tables[2] = {NULL, NULL};
+
+  if (!hashtblP) {
+    return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
+  }
+
+  pthread_mutex_lock (&hashtblP->mutex);
+  tables[0] = hashtblP->table;
+  tables[1] = hashtblP->old_table;
+  for (int t = 0; t < 2; t++) {
+    for (hash_size_t n = 0; tables[t] && (n < tables[t]->size); ++n) {
+      if ((tables[t]->slots[n].key != HASHTABLE_NOT_A_KEY_VALUE) && (tables[t]->slots[n].data)) {
+        hashtblP->freefunc (&tables[t]->slots[n].data);
+      }
+    }
+    hashtable_ts_free_slots (tables[t]);
+  }
+  hashtblP->table = NULL;
+  hashtblP->old_table = NULL;
+  hashtblP->num_elements = 0;
+  pthread_mutex_unlock (&hashtblP->mutex);
+  pthread_mutex_destroy (&hashtblP->mutex);
+
+  bdestroy(hashtblP->name);
+  hashtblP->name = NULL;
+  if (hashtblP->is_allocated_by_malloc) {
+    free_wrapper((void **) &hashtblP);
+  }
+  return HASH_TABLE_OK;
+}
+
+//------------------------------------------------------------------------------
+hashtable_rc_t
+hashtable_ts_is_key_exists (
+  const hash_table_ts_t * const hashtblP,
+  const hash_key_t keyP)
+{
+  if (!hashtblP) {
+    return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
+  }
+
+  if ((keyP != HASHTABLE_NOT_A_KEY_VALUE) && (hashtable_ts_read (hashtblP, keyP, NULL))) {
+    PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP);
+    return HASH_TABLE_OK;
+  }
+  PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return KEY_NOT_EXISTS\n", __FUNCTION__, bdata(hashtblP->name), keyP);
+  return HASH_TABLE_KEY_NOT_EXISTS;
+}
+
+//------------------------------------------------------------------------------
+// may cost a lot CPU...
+// Also useful if we want to find an element in the collection based on compare criteria different than the single key
+// The compare criteria in implemented in the funct_cb function
+// The table is not locked while funct_cb runs, funct_cb may thus access the table. Elements inserted or removed
+// during the walk, or moved by a concurrent resize, may be missed.
+hashtable_rc_t
+hashtable_ts_apply_callback_on_elements (
+  hash_table_ts_t * const hashtblP,
+  bool funct_cb (const hash_key_t keyP,
+               void * const dataP,
+               void *parameterP,
+               void ** resultP),
+  void *parameterP,
+  void** resultP)
+{
+  hash_slots_t                           *tables[2] = {NULL, NULL};
+  uint32_t                                seq = 0;
+
+  if (!hashtblP) {
+    return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
+  }
+
+  do {
+    seq = hashtable_ts_read_begin (hashtblP);
+    // elements not migrated yet are in the old slots
+    tables[0] = HASH_TABLE_TS_LOAD (hashtblP->old_table);
+    tables[1] = HASH_TABLE_TS_LOAD (hashtblP->table);
+  } while (hashtable_ts_read_retry (hashtblP, seq));
+
+  for (int t = 0; t < 2; t++) {
+    for (hash_size_t i = 0; tables[t] && (i < tables[t]->size); i++) {
+      hash_key_t                              key;
+      void                                   *data;
+
+      do {
+        seq = hashtable_ts_read_begin (hashtblP);
+        key = HASH_TABLE_TS_LOAD (tables[t]->slots[i].key);
+        data = HASH_TABLE_TS_LOAD (tables[t]->slots[i].data);
+      } while (hashtable_ts_read_retry (hashtblP, seq));
+
+      if ((key != HASHTABLE_NOT_A_KEY_VALUE) && (funct_cb (key, data, parameterP, resultP))) {
+        return HASH_TABLE_OK;
+      }
+    }
+  }
+
+  return HASH_TABLE_OK;
+}
+
+//------------------------------------------------------------------------------
+hashtable_rc_t
+hashtable_ts_dump_content (
+  const hash_table_ts_t * const hashtblP,
+  bstring str)
+{
+  hash_slots_t                           *tables[2] = {NULL, NULL};
+
+  if (!hashtblP) {
+    bcatcstr(str, "HASH_TABLE_BAD_PARAMETER_HASHTABLE");
+    return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
+  }
+
+  pthread_mutex_lock((pthread_mutex_t *)&hashtblP->mutex);
+  tables[0] = hashtblP->old_table;
+  tables[1] = hashtblP->table;
+  for (int t = 0; t < 2; t++) {
+    for (hash_size_t i = 0; tables[t] && (i < tables[t]->size); i++) {
+      if (tables[t]->slots[i].key != HASHTABLE_NOT_A_KEY_VALUE) {
+        bstring b0 = bformat ("Key 0x%"PRIx64" Element %p Slot %zu%s\n", tables[t]->slots[i].key, tables[t]->slots[i].data,
+                              i, (t == 0) ? " (old)" : "");
+        if (!b0) {
+          PRINT_HASHTABLE (hashtblP, "Error while dumping hashtable content");
+        } else {
+          bconcat(str, b0);
+          bdestroy(b0);
+        }
+      }
+    }
+  }
+  pthread_mutex_unlock((pthread_mutex_t *)&hashtblP->mutex);
+  return HASH_TABLE_OK;
+}
+
+//------------------------------------------------------------------------------
+/*
+   Adding a new element
+   If the key already exists, its data is freed and replaced.
+*/
+hashtable_rc_t
+hashtable_ts_insert (
+  hash_table_ts_t * const hashtblP,
+  const hash_key_t keyP,
+  void *dataP)
+{
+  hash_slots_t                           *table = NULL;
+  hash_slot_t                            *slot = NULL;
+
+  if (!hashtblP) {
+    return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
+  }
+  if (keyP == HASHTABLE_NOT_A_KEY_VALUE) {
+    return HASH_TABLE_BAD_PARAMETER_KEY;
+  }
+
+  hashtable_ts_write_lock (hashtblP);
+  hashtable_ts_migrate (hashtblP, HASH_TABLE_TS_MIGRATE_STEP);
+
+  if ((slot = hashtable_ts_find (hashtblP, keyP, &table))) {
+    if (slot->data) {
+      hashtblP->freefunc (&slot->data);
+    }
+    HASH_TABLE_TS_STORE (slot->data, dataP);
+    hashtable_ts_write_unlock (hashtblP);
+    PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64" data %p) return INSERT_OVERWRITTEN_DATA\n", __FUNCTION__, bdata(hashtblP->name), keyP, dataP);
+    return HASH_TABLE_INSERT_OVERWRITTEN_DATA;
+  }
+
+  if ((hashtblP->num_elements + 1) * 100 > hashtblP->table->size * HASH_TABLE_TS_MAX_LOAD_PERCENT) {
+    if ((hashtable_ts_grow (hashtblP, hashtblP->table->size << 1) != HASH_TABLE_OK) &&
+        (hashtblP->num_elements + 1 >= hashtblP->table->size)) {
+      hashtable_ts_write_unlock (hashtblP);
+      return HASH_TABLE_SYSTEM_ERROR;
+    }
+  }
+
+  hashtable_ts_insert_slot (hashtblP, hashtblP->table, keyP, dataP);
+  hashtblP->num_elements += 1;
+  hashtable_ts_write_unlock (hashtblP);
+  PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64" data %p) return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP, dataP);
+  return HASH_TABLE_OK;
+}
+
+//------------------------------------------------------------------------------
+/*
+   To free_wrapper an element from the hash table, we just search for it in the slots for that hash value,
+   and free_wrapper it if it is found.
+*/
+hashtable_rc_t
+hashtable_ts_free (
+  hash_table_ts_t * const hashtblP,
+  const hash_key_t keyP)
+{
+  void                                   *data = NULL;
+  hashtable_rc_t                          rc = hashtable_ts_remove (hashtblP, keyP, &data);
+
+  if ((rc == HASH_TABLE_OK) && (data)) {
+    hashtblP->freefunc (&data);
+  }
+  return rc;
+}
+
+//------------------------------------------------------------------------------
+/*
+   To remove an element from the hash table, we just search for it in the slots for that hash value,
+   and remove it if it is found.
+*/
+hashtable_rc_t
+hashtable_ts_remove (
+  hash_table_ts_t * const hashtblP,
+  const hash_key_t keyP,
+  void **dataP)
+{
+  hash_slots_t                           *table = NULL;
+  hash_slot_t                            *slot = NULL;
+
+  if (!hashtblP) {
+    return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
+  }
+  if (keyP == HASHTABLE_NOT_A_KEY_VALUE) {
+    return HASH_TABLE_KEY_NOT_EXISTS;
+  }
+
+  hashtable_ts_write_lock (hashtblP);
+  hashtable_ts_migrate (hashtblP, HASH_TABLE_TS_MIGRATE_STEP);
+
+  if ((slot = hashtable_ts_find (hashtblP, keyP, &table))) {
+    *dataP = slot->data;
+    hashtable_ts_remove_slot (hashtblP, table, slot);
+    hashtable_ts_write_unlock (hashtblP);
+    PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP);
+    return HASH_TABLE_OK;
+  }
+  hashtable_ts_write_unlock (hashtblP);
+
+  PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return KEY_NOT_EXISTS\n", __FUNCTION__, bdata(hashtblP->name), keyP);
+  return HASH_TABLE_KEY_NOT_EXISTS;
+}
+
+//------------------------------------------------------------------------------
+/*
+   Searching for an element does not lock the table.
+   NULL is returned if we didn't find it.
+*/
+hashtable_rc_t
+hashtable_ts_get (
+  const hash_table_ts_t * const hashtblP,
+  const hash_key_t keyP,
+  void **dataP)
+{
+  *dataP = NULL;
+  if (!hashtblP) {
+    return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
+  }
+
+  if ((keyP != HASHTABLE_NOT_A_KEY_VALUE) && (hashtable_ts_read (hashtblP, keyP, dataP))) {
+    PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64" data %p) return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP, *dataP);
+    return HASH_TABLE_OK;
+  }
+  PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return KEY_NOT_EXISTS\n", __FUNCTION__, bdata(hashtblP->name), keyP);
+  return HASH_TABLE_KEY_NOT_EXISTS;
+}
+
+//------------------------------------------------------------------------------
+/*
+   Resizing
+   The table grows by itself, hashtable_ts_resize() is only useful to presize it before a burst of insertions.
+   The migration to the new slots is completed before returning. The table is never shrunk below its load factor.
+*/
+hashtable_rc_t
+hashtable_ts_resize (
+  hash_table_ts_t * const hashtblP,
+  const hash_size_t sizeP)
+{
+  hashtable_rc_t                          rc = HASH_TABLE_OK;
+  hash_size_t                             size = 0;
+
+  if (!hashtblP) {
+    return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
+  }
+
+  hashtable_ts_write_lock (hashtblP);
+  size = hashtable_ts_slots_for ((sizeP > hashtblP->num_elements) ? sizeP : hashtblP->num_elements);
+  if (size != hashtblP->table->size) {
+    rc = hashtable_ts_grow (hashtblP, size);
+  }
+  if (hashtblP->old_table) {
+    hashtable_ts_migrate (hashtblP, hashtblP->old_table->size);
+  }
+  hashtable_ts_write_unlock (hashtblP);
+  return rc;
+}
+
+//------------------------------------------------------------------------------
+/*
+   Bytes allocated for the slots of the table, the slot arrays retired by resizes included.
+*/
+hash_size_t
+hashtable_ts_memory_size (
+  hash_table_ts_t * const hashtblP)
+{
+  hash_size_t                             size = 0;
+
+  if (!hashtblP) {
+    return 0;
+  }
+
+  pthread_mutex_lock (&hashtblP->mutex);
+  for (hash_slots_t * table = hashtblP->table; table; table = table->retired) {
+    size += sizeof (hash_slots_t) + table->size * sizeof (hash_slot_t);
+  }
+  for (hash_slots_t * table = hashtblP->old_table; table; table = table->retired) {
+    size += sizeof (hash_slots_t) + table->size * sizeof (hash_slot_t);
+  }
+  pthread_mutex_unlock (&hashtblP->mutex);
+  return size;
 }
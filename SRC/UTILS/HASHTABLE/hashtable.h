@@ -76,12 +76,37 @@ typedef struct hash_table_s {
     bool                log_enabled;
 } hash_table_t;
 
+/* Slot of a thread safe hash table, keys are stored inline (open addressing).
+ * A slot is free when its key is HASHTABLE_NOT_A_KEY_VALUE (which thus cannot
+ * be inserted), its data is then NULL for an empty slot or a tombstone marker
+ * for a slot already moved out of a slot array being migrated.
+ */
+typedef struct hash_slot_s {
+    hash_key_t          key;
+    void               *data;
+} hash_slot_t;
+
+typedef struct hash_slots_s {
+    hash_size_t          size;       ///< Number of slots, power of 2
+    struct hash_slots_s *retired;    ///< Slot arrays replaced by a resize, freed at destroy time
+    hash_slot_t          slots[];
+} hash_slots_t;
+
+/* Thread safe hash table.
+ * Writers are serialized by mutex, readers do not lock: they retry their
+ * lookup if seq changed meanwhile (seqlock). Slot arrays replaced by a resize
+ * are kept until the table is destroyed so that a reader never touches freed
+ * memory. When the load factor is exceeded, a larger slot array is allocated
+ * and entries are migrated a few slots at a time by each write operation.
+ */
 typedef struct hash_table_ts_s {
     pthread_mutex_t     mutex;
+    uint32_t            seq;          ///< Odd while a writer modifies the table
     hash_size_t         size;
     hash_size_t         num_elements;
-    struct hash_node_s **nodes;
-    pthread_mutex_t     *lock_nodes;
+    hash_slots_t       *table;        ///< Slot array new entries are inserted in
+    hash_slots_t       *old_table;    ///< Slot array being migrated to table, if any
+    hash_size_t         migrate_index;///< Next slot of old_table to be migrated
     hash_size_t       (*hashfunc)(const hash_key_t);
     void              (*freefunc)(void**);
     bstring             name;
@@ -125,6 +150,7 @@ hashtable_rc_t  hashtable_ts_free (hash_table_ts_t * const hashtbl, const hash_k
 hashtable_rc_t  hashtable_ts_remove(hash_table_ts_t * const hashtbl, const hash_key_t key, void** element);
 hashtable_rc_t  hashtable_ts_get    (const hash_table_ts_t * const hashtbl, const hash_key_t key, void **element) __attribute__ ((hot));
 hashtable_rc_t  hashtable_ts_resize (hash_table_ts_t * const hashtbl, const hash_size_t size);
+hash_size_t     hashtable_ts_memory_size (hash_table_ts_t * const hashtbl);
 
 #endif
 
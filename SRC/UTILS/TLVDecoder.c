@@ -27,6 +27,84 @@
 
 int                                     errorCodeDecoder = 0;
 
+static __thread tlv_decode_arena_t     *tlv_decode_arena = NULL;
+
+//------------------------------------------------------------------------------
+void tlv_decode_arena_init (tlv_decode_arena_t * const arena)
+{
+  arena->used = 0;
+  arena->nb_chunks = 0;
+  arena->chunks = NULL;
+}
+
+//------------------------------------------------------------------------------
+void *tlv_decode_arena_alloc (tlv_decode_arena_t * const arena, const size_t size)
+{
+  size_t                                  aligned_size = (size + sizeof (void *) - 1) & ~(sizeof (void *) - 1);
+  tlv_decode_arena_chunk_t               *chunk = arena->chunks;
+  void                                   *p = NULL;
+
+  if (aligned_size <= (TLV_DECODE_ARENA_BLOCK_SIZE - arena->used)) {
+    p = &arena->block[arena->used];
+    arena->used += aligned_size;
+    return p;
+  }
+  if ((!chunk) || (aligned_size > (chunk->size - chunk->used))) {
+    size_t chunk_size = (aligned_size > TLV_DECODE_ARENA_CHUNK_SIZE) ? aligned_size : TLV_DECODE_ARENA_CHUNK_SIZE;
+
+    chunk = malloc (sizeof (tlv_decode_arena_chunk_t) + chunk_size);
+    if (!chunk) {
+      return NULL;
+    }
+    chunk->size = chunk_size;
+    chunk->used = 0;
+    chunk->next = arena->chunks;
+    arena->chunks = chunk;
+    arena->nb_chunks += 1;
+  }
+  p = &chunk->data[chunk->used];
+  chunk->used += aligned_size;
+  return p;
+}
+
+//------------------------------------------------------------------------------
+void tlv_decode_arena_release (tlv_decode_arena_t * const arena)
+{
+  while (arena->chunks) {
+    tlv_decode_arena_chunk_t             *chunk = arena->chunks;
+
+    arena->chunks = chunk->next;
+    free (chunk);
+  }
+  arena->used = 0;
+}
+
+//------------------------------------------------------------------------------
+tlv_decode_arena_t *tlv_decode_arena_attach (tlv_decode_arena_t * const arena)
+{
+  tlv_decode_arena_t                     *previous = tlv_decode_arena;
+
+  tlv_decode_arena = arena;
+  return previous;
+}
+
+//------------------------------------------------------------------------------
+static bstring tlv_decode_arena_blk2bstr (tlv_decode_arena_t * const arena, const uint8_t * const blk, const uint16_t len)
+{
+  bstring                                 b = tlv_decode_arena_alloc (arena, sizeof (struct tagbstring) + len + 1);
+
+  if (b) {
+    b->data = (unsigned char *)(b + 1);
+    memcpy (b->data, blk, len);
+    b->data[len] = '\0';
+    b->slen = len;
+    b->mlen = len + 1;
+    bwriteprotect (*b);
+  }
+  return b;
+}
+
+//------------------------------------------------------------------------------
 int decode_bstring (
   bstring * bstr,
   const uint16_t pdulen,
@@ -38,7 +116,11 @@ int decode_bstring (
   }
 
   if ((bstr ) && (buffer )) {
-    *bstr = blk2bstr(buffer, pdulen);
+    if (tlv_decode_arena) {
+      *bstr = tlv_decode_arena_blk2bstr (tlv_decode_arena, buffer, pdulen);
+    } else {
+      *bstr = blk2bstr(buffer, pdulen);
+    }
     return pdulen;
   } else {
     *bstr = NULL;
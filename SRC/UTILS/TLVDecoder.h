@@ -22,6 +22,8 @@
 #ifndef FILE_TLV_DECODER_SEEN
 #define FILE_TLV_DECODER_SEEN
 
+#include <stdint.h>
+#include <stddef.h>
 #include "bstrlib.h"
 #include "log.h"
 #include "common_defs.h"
@@ -45,6 +47,39 @@
 
 extern int errorCodeDecoder;
 
+/*
+ * Per-message decode arena.
+ * While an arena is attached to the decoding thread, decode_bstring() takes
+ * the bstring and its contents from the arena instead of two heap allocations
+ * per IE. The strings of the arena are write protected (bdestroy() on them is
+ * a no-op) and are all released at once by tlv_decode_arena_release(): a
+ * consumer keeping an IE beyond the processing of the message bstrcpy() it.
+ * The first TLV_DECODE_ARENA_BLOCK_SIZE bytes come from the arena itself
+ * (usually on the stack), the remainder from heap chunks.
+ */
+#define TLV_DECODE_ARENA_BLOCK_SIZE 2048
+#define TLV_DECODE_ARENA_CHUNK_SIZE 4096
+
+typedef struct tlv_decode_arena_chunk_s {
+  struct tlv_decode_arena_chunk_s *next;
+  uint32_t                          size;
+  uint32_t                          used;
+  uint8_t                           data[];
+} tlv_decode_arena_chunk_t;
+
+typedef struct tlv_decode_arena_s {
+  uint32_t                          used;          // bytes used in block
+  uint32_t                          nb_chunks;     // heap chunks allocated since init
+  tlv_decode_arena_chunk_t         *chunks;        // heap chunks, current one first
+  uint8_t                           block[TLV_DECODE_ARENA_BLOCK_SIZE] __attribute__((aligned(sizeof(void*))));
+} tlv_decode_arena_t;
+
+void                tlv_decode_arena_init    (tlv_decode_arena_t * const arena);
+void               *tlv_decode_arena_alloc   (tlv_decode_arena_t * const arena, const size_t size);
+void                tlv_decode_arena_release (tlv_decode_arena_t * const arena);
+/* Attach arena (NULL: heap allocations) to the calling thread, return the previous one */
+tlv_decode_arena_t *tlv_decode_arena_attach  (tlv_decode_arena_t * const arena);
+
 int decode_bstring (
   bstring * octetstring,
   const uint16_t pdulen,
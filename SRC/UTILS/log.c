@@ -48,12 +48,11 @@
 #include <ctype.h>
 #include <fcntl.h>
 
-#include "liblfds611.h"
 #include "intertask_interface.h"
 #include "timer.h"
-#include "hashtable.h"
 
 #include "log.h"
+#include "log_binary.h"
 #include "assertions.h"
 #include "dynamic_memory_check.h"
 
@@ -62,7 +61,7 @@
 #endif
 
 //-------------------------------
-#define LOG_MAX_QUEUE_ELEMENTS                1024
+#define LOG_MAX_QUEUE_ELEMENTS                4096 // per thread
 #define LOG_MAX_PROTO_NAME_LENGTH               16
 #define LOG_MESSAGE_MIN_ALLOC_SIZE             256
 
@@ -72,14 +71,16 @@
 #define LOG_FLUSH_PERIOD_SEC                     0
 #define LOG_FLUSH_PERIOD_MICRO_SEC           50000
 
-#define LOG_DISPLAYED_FILENAME_MAX_LENGTH       32
-#define LOG_DISPLAYED_LOG_LEVEL_NAME_MAX_LENGTH  5
-#define LOG_DISPLAYED_PROTO_NAME_MAX_LENGTH      6
 #define LOG_FUNC_INDENT_SPACES                   3
 #define LOG_LEVEL_NAME_MAX_LENGTH               10
 #define LOG_ANSI_CODE_MAX_LENGTH                15
 #define LOG_MAX_SERVER_ADDRESS_LENGTH           96
 #define LOG_MAX_PORT_NUM_LENGTH                  6
+#define LOG_BINARY_STRINGS_CACHE_BITS           10
+#define LOG_BINARY_MAX_CACHED_ARGS              15
+#define LOG_BINARY_ARGS_NOT_CACHED            0xFF
+#define LOG_BINARY_ARG_WIDTH_IS_STAR          0x10
+#define LOG_BINARY_ARG_PRECISION_IS_STAR      0x20
 //-------------------------------
 
 typedef unsigned long                   log_message_number_t;
@@ -93,6 +94,36 @@ typedef enum {
   MAX_LOG_TCP_STATE
 } log_tcp_state_t;
 
+/*! \struct  log_binary_string_cache_t
+* \brief A string already sent on the output stream by a thread and, for a format, the types of its arguments
+* (log_binary_arg_type_t | LOG_BINARY_ARG_WIDTH_IS_STAR | LOG_BINARY_ARG_PRECISION_IS_STAR) so that it is parsed once.
+*/
+typedef struct log_binary_string_cache_s {
+  const char                             *string;
+  uint8_t                                 nb_args;                     /*!< \brief LOG_BINARY_ARGS_NOT_CACHED: parse the format for each message */
+  uint8_t                                 args[LOG_BINARY_MAX_CACHED_ARGS];
+} log_binary_string_cache_t;
+
+
+/*! \struct  log_thread_t
+* \brief Logging state of a thread, reached through a thread local pointer.
+* Messages are formatted by the thread in the items of its ring (single producer),
+* TASK_LOG writes them to the output (single consumer).
+*/
+typedef struct log_thread_s {
+  log_thread_ctxt_t                       ctxt;                                                 /*!< \brief Must stay first, see LOG_THREAD() */
+  struct log_thread_s                    *next;                                                 /*!< \brief Threads that ever logged something */
+  volatile uint32_t                       head;                                                 /*!< \brief Next item to be written, owned by the thread */
+  volatile uint32_t                       tail;                                                 /*!< \brief Next item to be flushed, owned by TASK_LOG */
+  volatile uint32_t                       dropped;                                              /*!< \brief Messages lost because the ring was full */
+  uint32_t                                dropped_reported;
+  log_queue_item_t                        unbuffered_item;                                      /*!< \brief When output is not thread safe */
+  uint32_t                                binary_generation;                                    /*!< \brief Output stream binary_strings refer to */
+  log_binary_string_cache_t               binary_strings[1 << LOG_BINARY_STRINGS_CACHE_BITS];   /*!< \brief Strings already sent on the output stream */
+  log_queue_item_t                        items[LOG_MAX_QUEUE_ELEMENTS];
+} log_thread_t;
+
+#define LOG_THREAD(tHrEaD_cTxT)  ((log_thread_t *)(tHrEaD_cTxT))
 
 /*! \struct  oai_log_t
 * \brief Structure containing all the logging utility internal variables.
@@ -103,6 +134,7 @@ typedef struct oai_log_s {
   FILE                                   *log_fd;                                               /*!< \brief output stream */
   bool                                    is_output_is_fd;                                      /* We may want to not use syslog even if exe is a daemon */
   bool                                    is_output_fd_buffered;                                /* We way want no buffering */
+  bool                                    is_output_binary;                                     /*!< \brief Binary records instead of text, see log_binary.h */
   bstring                                 bserver_address;                                      /*!< \brief TCP remote (or local) server hostname */
   bstring                                 bserver_port ;                                        /*!< \brief TCP remote (or local) server port     */
   log_tcp_state_t                         tcp_state;                                            /*!< \brief State of the client TCP connection           */
@@ -113,16 +145,17 @@ typedef struct oai_log_s {
   log_level_t                             log_level[MAX_LOG_PROTOS];                                   /*!< \brief Loglevel id of each client (protocol/layer) */
 
   log_message_number_t                    log_message_number;                                          /*!< \brief Counter of log message        */
-  struct lfds611_queue_state             *log_message_queue_p;                                         /*!< \brief Thread safe log message queue */
-  struct lfds611_stack_state             *log_free_message_queue_p;                                          /*!< \brief Thread safe memory pool       */
-
-  hash_table_ts_t                           *thread_context_htbl;                                         /*!< \brief Container for log_thread_ctxt_t */
+  log_thread_t * volatile                 threads;                                                     /*!< \brief Rings of all threads, flushed by TASK_LOG */
+  pthread_mutex_t                         flush_mutex;                                                 /*!< \brief Only one thread flushes the rings */
+  volatile uint32_t                       binary_generation;                                           /*!< \brief Incremented on each new binary output stream */
 } oai_log_t;
 
 static oai_log_t g_oai_log={0};    /*!< \brief  logging utility internal variables global var definition*/
 
-inline static void log_reuse_item(log_queue_item_t * item_p) __attribute__((always_inline));
+static __thread log_thread_t *log_thread = NULL; /*!< \brief  logging state of the current thread */
+
 static log_queue_item_t * new_queue_item(void);
+static void log_get_elapsed_time_since_start(struct timeval * const elapsed_time);
 
 
 //------------------------------------------------------------------------------
@@ -132,27 +165,9 @@ int log_get_start_time_sec (void)
 }
 
 //------------------------------------------------------------------------------
-static void log_reuse_item(log_queue_item_t * item_p)
+bool log_is_enabled (const log_level_t log_levelP, const log_proto_t protoP)
 {
-  int         rv = 0;
-#if LOG_OAI_CLEAN_HARD
-  if (item_p->bstr) {
-    bdestroy(item_p->bstr);
-  }
-  memset((void*)item_p, 0, sizeof(* item_p));
-  item_p->bstr = bfromcstralloc(LOG_MESSAGE_MIN_ALLOC_SIZE, "");
-#else
-  if (item_p->bstr) {
-    if (512 < item_p->bstr->mlen) {
-      bdestroy(item_p->bstr);
-      item_p->bstr = bfromcstralloc(LOG_MESSAGE_MIN_ALLOC_SIZE, "");
-    }
-  }
-#endif
-  rv = lfds611_stack_guaranteed_push (g_oai_log.log_free_message_queue_p, item_p);
-  if (0 == rv) {
-    free_wrapper ((void**) &item_p);
-  }
+  return (log_levelP <= g_oai_log.log_level[protoP]);
 }
 
 //------------------------------------------------------------------------------
@@ -165,6 +180,347 @@ static log_queue_item_t * new_queue_item(void)
   return item_p;
 }
 
+//------------------------------------------------------------------------------
+// Logging state of the calling thread, created on first use
+static inline log_thread_t * log_get_thread(void)
+{
+  log_thread_t  *thread = log_thread;
+
+  if (NULL == thread) {
+    thread = calloc(1, sizeof(log_thread_t));
+    AssertFatal(NULL != thread, "Error Could not create log thread context\n");
+    thread->ctxt.tid = pthread_self();
+    thread->unbuffered_item.bstr = bfromcstralloc(LOG_MESSAGE_MIN_ALLOC_SIZE, "");
+    // the thread state is never freed, TASK_LOG may flush it after the thread exit
+    do {
+      thread->next = g_oai_log.threads;
+    } while (!__sync_bool_compare_and_swap (&g_oai_log.threads, thread->next, thread));
+    log_thread = thread;
+  }
+  return thread;
+}
+
+//------------------------------------------------------------------------------
+// Item where to format the next message of the thread, NULL if its ring is full
+static inline log_queue_item_t * log_get_item(log_thread_t * const thread)
+{
+  log_queue_item_t  *item_p = NULL;
+
+  if (!g_oai_log.is_output_fd_buffered) {
+    item_p = &thread->unbuffered_item;
+  } else {
+    if ((thread->head - __atomic_load_n (&thread->tail, __ATOMIC_ACQUIRE)) >= LOG_MAX_QUEUE_ELEMENTS) {
+      thread->dropped++;
+      return NULL;
+    }
+    item_p = &thread->items[thread->head % LOG_MAX_QUEUE_ELEMENTS];
+    if (NULL == item_p->bstr) {
+      item_p->bstr = bfromcstralloc(LOG_MESSAGE_MIN_ALLOC_SIZE, "");
+      AssertFatal((item_p->bstr), "Allocation of buf in log container failed");
+    }
+  }
+  btrunc(item_p->bstr, 0);
+  return item_p;
+}
+
+//------------------------------------------------------------------------------
+// Writes an item to the output, returns a negative value on error
+static int log_write_item(log_queue_item_t * const item_p)
+{
+  int rv_put = 0;
+
+  if (blength(item_p->bstr) > 0) {
+    if (g_oai_log.is_output_is_fd) {
+      if (g_oai_log.is_output_binary) {
+        rv_put = (1 == fwrite (item_p->bstr->data, blength(item_p->bstr), 1, g_oai_log.log_fd)) ? 0 : -1;
+      } else {
+        rv_put = fputs ((const char *)item_p->bstr->data, g_oai_log.log_fd);
+      }
+    } else {
+      syslog (item_p->log_level ,"%s", bdata(item_p->bstr));
+    }
+  }
+  return rv_put;
+}
+
+//------------------------------------------------------------------------------
+// Item formatted, queue it for TASK_LOG or write it now
+static inline void log_send_item(log_thread_t * const thread, log_queue_item_t * const item_p)
+{
+  if (g_oai_log.is_output_fd_buffered) {
+    __atomic_store_n (&thread->head, thread->head + 1, __ATOMIC_RELEASE);
+  } else {
+    log_write_item(item_p);
+    btrunc(item_p->bstr, 0);
+  }
+}
+
+//------------------------------------------------------------------------------
+static int log_format_header(
+  log_thread_t * const thread,
+  log_queue_item_t * const item_p,
+  const log_level_t log_levelP,
+  const log_proto_t protoP,
+  const char *const source_fileP,
+  const unsigned int line_numP)
+{
+  struct timeval elapsed_time;
+  int            filename_length = strlen(source_fileP);
+
+  item_p->log_level = log_levelP;
+  log_get_elapsed_time_since_start(&elapsed_time);
+  if (filename_length > LOG_DISPLAYED_FILENAME_MAX_LENGTH) {
+    filename_length -= LOG_DISPLAYED_FILENAME_MAX_LENGTH;
+  } else {
+    filename_length = 0;
+  }
+  return bformata (item_p->bstr, LOG_HEADER_FORMAT,
+      (uint64_t)__sync_fetch_and_add (&g_oai_log.log_message_number, 1), elapsed_time.tv_sec, elapsed_time.tv_usec,
+      thread->ctxt.tid,
+      LOG_DISPLAYED_LOG_LEVEL_NAME_MAX_LENGTH, LOG_DISPLAYED_LOG_LEVEL_NAME_MAX_LENGTH, &g_oai_log.log_level2str[log_levelP][0],
+      LOG_DISPLAYED_PROTO_NAME_MAX_LENGTH, LOG_DISPLAYED_PROTO_NAME_MAX_LENGTH, &g_oai_log.log_proto2str[protoP][0],
+      LOG_DISPLAYED_FILENAME_MAX_LENGTH, LOG_DISPLAYED_FILENAME_MAX_LENGTH, &source_fileP[filename_length], line_numP,
+      thread->ctxt.indent, " ");
+}
+
+//------------------------------------------------------------------------------
+// Start of a new binary output stream, strings have to be sent again
+static void log_binary_start_output(void)
+{
+  log_binary_file_header_t   file_header = {.magic = LOG_BINARY_MAGIC};
+  log_binary_record_header_t header = {0};
+  int                        i = 0;
+
+  file_header.byte_order = LOG_BINARY_BYTE_ORDER;
+  file_header.header_length = sizeof(file_header);
+  file_header.start_time_sec = g_oai_log.log_start_time_second;
+  fwrite (&file_header, sizeof(file_header), 1, g_oai_log.log_fd);
+
+  for (i = MIN_LOG_LEVEL; i < MAX_LOG_LEVEL; i++) {
+    header.length = sizeof(header) + strlen(g_oai_log.log_level2str[i]);
+    header.type = LOG_BINARY_RECORD_LEVEL_NAME;
+    header.level = i;
+    fwrite (&header, sizeof(header), 1, g_oai_log.log_fd);
+    fwrite (g_oai_log.log_level2str[i], header.length - sizeof(header), 1, g_oai_log.log_fd);
+  }
+  header.level = 0;
+  for (i = MIN_LOG_PROTOS; i < MAX_LOG_PROTOS; i++) {
+    header.length = sizeof(header) + strlen(g_oai_log.log_proto2str[i]);
+    header.type = LOG_BINARY_RECORD_PROTO_NAME;
+    header.proto = i;
+    fwrite (&header, sizeof(header), 1, g_oai_log.log_fd);
+    fwrite (g_oai_log.log_proto2str[i], header.length - sizeof(header), 1, g_oai_log.log_fd);
+  }
+  __sync_fetch_and_add (&g_oai_log.binary_generation, 1);
+}
+
+//------------------------------------------------------------------------------
+// Types of the arguments of a format, LOG_BINARY_ARGS_NOT_CACHED if they do not fit in the cache entry
+static void log_binary_parse_args(log_binary_string_cache_t * const entry, const char *format)
+{
+  log_binary_conversion_t conversion;
+
+  entry->nb_args = 0;
+  while ((format = log_binary_next_conversion(format, &conversion))) {
+    if ((LOG_BINARY_ARG_NONE == conversion.type) && (!conversion.width_is_star) && (!conversion.precision_is_star)) {
+      continue;
+    }
+    if ((LOG_BINARY_MAX_CACHED_ARGS == entry->nb_args) ||
+        ((LOG_BINARY_ARG_STRING == conversion.type) && (0 <= conversion.precision))) {
+      entry->nb_args = LOG_BINARY_ARGS_NOT_CACHED;
+      return;
+    }
+    entry->args[entry->nb_args++] = conversion.type |
+        ((conversion.width_is_star) ? LOG_BINARY_ARG_WIDTH_IS_STAR : 0) |
+        ((conversion.precision_is_star) ? LOG_BINARY_ARG_PRECISION_IS_STAR : 0);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Sends a string in a LOG_BINARY_RECORD_STRING record unless this thread already did it,
+// returns its cache entry or NULL if it could not be sent
+static const log_binary_string_cache_t * log_binary_send_string(log_thread_t * const thread, const char * const string, const bool is_format)
+{
+  log_queue_item_t          *item_p = NULL;
+  log_binary_string_t        record = {.header = {.type = LOG_BINARY_RECORD_STRING}};
+  uint32_t                   index = (uint32_t)(((uintptr_t)string * UINT64_C(0x9E3779B97F4A7C15)) >> (64 - LOG_BINARY_STRINGS_CACHE_BITS));
+  log_binary_string_cache_t *entry = &thread->binary_strings[index];
+
+  if (thread->binary_generation != g_oai_log.binary_generation) {
+    memset(thread->binary_strings, 0, sizeof(thread->binary_strings));
+    thread->binary_generation = g_oai_log.binary_generation;
+  }
+  if (string == entry->string) {
+    return entry;
+  }
+  item_p = log_get_item(thread);
+  if (NULL == item_p) {
+    return NULL;
+  }
+  record.id = (uintptr_t)string;
+  record.header.length = sizeof(record) + strlen(string);
+  bassignblk(item_p->bstr, &record, sizeof(record));
+  bcatblk(item_p->bstr, string, record.header.length - sizeof(record));
+  log_send_item(thread, item_p);
+  entry->string = string;
+  entry->nb_args = LOG_BINARY_ARGS_NOT_CACHED;
+  if (is_format) {
+    log_binary_parse_args(entry, string);
+  }
+  return entry;
+}
+
+//------------------------------------------------------------------------------
+// Appends the raw value of an argument (and of its '*' width and precision), see log_binary_message_t
+static inline void log_binary_add_arg(bstring bstr, const uint8_t arg, int precision, va_list * const args)
+{
+  int64_t                 value = 0;
+  double                  dvalue = 0;
+  const char             *string = NULL;
+  uint32_t                length = 0;
+
+  if (arg & LOG_BINARY_ARG_WIDTH_IS_STAR) {
+    value = va_arg(*args, int);
+    bcatblk(bstr, &value, sizeof(value));
+  }
+  if (arg & LOG_BINARY_ARG_PRECISION_IS_STAR) {
+    value = va_arg(*args, int);
+    precision = value;
+    bcatblk(bstr, &value, sizeof(value));
+  }
+  switch (arg & 0x0F) {
+  case LOG_BINARY_ARG_NONE:
+    return;
+  case LOG_BINARY_ARG_INT:
+    value = va_arg(*args, int);
+    break;
+  case LOG_BINARY_ARG_LONG:
+    value = va_arg(*args, long);
+    break;
+  case LOG_BINARY_ARG_LONG_LONG:
+    value = va_arg(*args, long long);
+    break;
+  case LOG_BINARY_ARG_SIZE:
+    value = va_arg(*args, size_t);
+    break;
+  case LOG_BINARY_ARG_PTRDIFF:
+    value = va_arg(*args, ptrdiff_t);
+    break;
+  case LOG_BINARY_ARG_INTMAX:
+    value = va_arg(*args, intmax_t);
+    break;
+  case LOG_BINARY_ARG_DOUBLE:
+    dvalue = va_arg(*args, double);
+    memcpy(&value, &dvalue, sizeof(value));
+    break;
+  case LOG_BINARY_ARG_LONG_DOUBLE:
+    dvalue = va_arg(*args, long double);
+    memcpy(&value, &dvalue, sizeof(value));
+    break;
+  case LOG_BINARY_ARG_POINTER:
+    value = (uintptr_t)va_arg(*args, void *);
+    break;
+  case LOG_BINARY_ARG_STRING:
+    string = va_arg(*args, const char *);
+    if (NULL == string) {
+      length = LOG_BINARY_STRING_NULL;
+      bcatblk(bstr, &length, sizeof(length));
+    } else {
+      if ((0 > precision) || (LOG_BINARY_STRING_MAX_LENGTH < precision)) {
+        precision = LOG_BINARY_STRING_MAX_LENGTH;
+      }
+      length = strnlen(string, precision);
+      bcatblk(bstr, &length, sizeof(length));
+      bcatblk(bstr, string, length);
+    }
+    return;
+  }
+  bcatblk(bstr, &value, sizeof(value));
+}
+
+//------------------------------------------------------------------------------
+// Appends the raw values of the arguments, see log_binary_message_t
+static void log_binary_add_args(bstring bstr, const log_binary_string_cache_t * const entry, const char *format, va_list args)
+{
+  log_binary_conversion_t conversion;
+  va_list                 args_copy;
+
+  // a va_list can only be passed by address portably once copied
+  va_copy(args_copy, args);
+  if ((entry) && (LOG_BINARY_ARGS_NOT_CACHED != entry->nb_args)) {
+    for (int i = 0; i < entry->nb_args; i++) {
+      log_binary_add_arg(bstr, entry->args[i], -1, &args_copy);
+    }
+  } else {
+    while ((format = log_binary_next_conversion(format, &conversion))) {
+      log_binary_add_arg(bstr, conversion.type |
+          ((conversion.width_is_star) ? LOG_BINARY_ARG_WIDTH_IS_STAR : 0) |
+          ((conversion.precision_is_star) ? LOG_BINARY_ARG_PRECISION_IS_STAR : 0),
+          conversion.precision, &args_copy);
+    }
+  }
+  va_end(args_copy);
+}
+
+//------------------------------------------------------------------------------
+// Binary counterpart of log_message(): no formatting, the raw arguments are recorded
+static void log_binary_message(
+  log_thread_t * const thread,
+  const log_level_t log_levelP,
+  const log_proto_t protoP,
+  const char *const source_fileP,
+  const unsigned int line_numP,
+  const char *format,
+  va_list args)
+{
+  log_queue_item_t     *item_p = NULL;
+  log_binary_message_t  record = {.header = {.type = LOG_BINARY_RECORD_MESSAGE}};
+  struct timeval        elapsed_time;
+  const log_binary_string_cache_t *format_entry = NULL;
+
+  log_binary_send_string(thread, source_fileP, false);
+  format_entry = log_binary_send_string(thread, format, true);
+  item_p = log_get_item(thread);
+  if (NULL == item_p) {
+    return;
+  }
+  log_get_elapsed_time_since_start(&elapsed_time);
+  record.header.level = log_levelP;
+  record.header.proto = protoP;
+  record.number = __sync_fetch_and_add (&g_oai_log.log_message_number, 1);
+  record.time_us = (uint64_t)elapsed_time.tv_sec * 1000000 + elapsed_time.tv_usec;
+  record.tid = thread->ctxt.tid;
+  record.file_id = (uintptr_t)source_fileP;
+  record.format_id = (uintptr_t)format;
+  record.line = line_numP;
+  record.indent = thread->ctxt.indent;
+  bassignblk(item_p->bstr, &record, sizeof(record));
+  log_binary_add_args(item_p->bstr, format_entry, format, args);
+  ((log_binary_record_header_t *)item_p->bstr->data)->length = blength(item_p->bstr);
+  log_send_item(thread, item_p);
+}
+
+//------------------------------------------------------------------------------
+// Sends an already formatted message
+static void log_send_text(log_thread_t * const thread, log_queue_item_t * const messageP)
+{
+  log_queue_item_t          *item_p = log_get_item(thread);
+  log_binary_record_header_t header = {.type = LOG_BINARY_RECORD_TEXT};
+
+  if (item_p) {
+    item_p->log_level = messageP->log_level;
+    if (g_oai_log.is_output_binary) {
+      header.length = sizeof(header) + blength(messageP->bstr);
+      header.level = messageP->log_level;
+      bassignblk(item_p->bstr, &header, sizeof(header));
+      bconcat(item_p->bstr, messageP->bstr);
+    } else {
+      bassign(item_p->bstr, messageP->bstr);
+    }
+    log_send_item(thread, item_p);
+  }
+}
+
 //------------------------------------------------------------------------------
 void* log_task (__attribute__ ((unused)) void *args_p)
 {
@@ -282,6 +638,9 @@ void log_connect_to_server(void)
      return;
    }
    OAI_FPRINTF_INFO("Connected to log server %s:%s\n", bdata(g_oai_log.bserver_address), bdata(g_oai_log.bserver_port));
+   if (g_oai_log.is_output_binary) {
+     log_binary_start_output();
+   }
    g_oai_log.tcp_state = LOG_TCP_STATE_CONNECTED;
 }
 
@@ -308,6 +667,7 @@ void log_set_config(const log_config_t * const config)
     if ((MAX_LOG_LEVEL > config->itti_log_level) && (MIN_LOG_LEVEL <= config->itti_log_level))         g_oai_log.log_level[LOG_ITTI]     = config->itti_log_level;
 
     g_oai_log.is_output_fd_buffered = config->is_output_thread_safe;
+    g_oai_log.is_output_binary = false;
 
     if (config->output) {
       if (1 != biseqcstrcaseless(config->output, LOG_CONFIG_STRING_OUTPUT_CONSOLE)) {
@@ -317,6 +677,10 @@ void log_set_config(const log_config_t * const config)
             g_oai_log.log_fd = fopen (bdata(config->output), "w");
             AssertFatal (NULL != g_oai_log.log_fd, "Could not open log file %s : %s", bdata(config->output), strerror (errno));
             g_oai_log.is_output_is_fd = true;
+            if (config->is_output_binary) {
+              g_oai_log.is_output_binary = true;
+              log_binary_start_output();
+            }
           } else {
             // may be a TCP server address host:portnum
             g_oai_log.bserver_address = bstrcpy(config->output);
@@ -332,6 +696,7 @@ void log_set_config(const log_config_t * const config)
             AssertFatal(65535 >= server_port, "Invalid Server TCP port %d/%s", server_port, bdata(g_oai_log.bserver_port));
             g_oai_log.tcp_state = LOG_TCP_STATE_NOT_CONNECTED;
             g_oai_log.is_output_is_fd = true;
+            g_oai_log.is_output_binary = config->is_output_binary;
             log_connect_to_server();
           }
         } else {
@@ -354,6 +719,9 @@ void log_set_config(const log_config_t * const config)
 #endif
       }
     }
+    if ((config->is_output_binary) && (!g_oai_log.is_output_binary)) {
+      OAI_FPRINTF_ERR("Binary log output is only available for file and TCP outputs, using text\n");
+    }
   }
 }
 
@@ -406,11 +774,10 @@ int
 log_init (
   __attribute__ ((unused))const log_env_t envP,
   const log_level_t default_log_levelP,
-  const int max_threadsP)
+  __attribute__ ((unused))const int max_threadsP)
 {
   int                                     i = 0;
   int                                     rv = 0;
-  log_queue_item_t                       *item_p = NULL;
   struct timeval                          start_time = {.tv_sec=0, .tv_usec=0};
 
   signal(SIGPIPE, log_signal_callback_handler);
@@ -418,45 +785,15 @@ log_init (
   g_oai_log.log_fd = NULL;
 
   rv = gettimeofday(&start_time, NULL);
+  AssertFatal(0 == rv, "gettimeofday failed: %s\n", strerror(errno));
   g_oai_log.log_start_time_second = start_time.tv_sec;
 
 
   OAI_FPRINTF_INFO("Initializing OAI Logging\n");
 
-  bstring b = bfromcstr("Logging thread context hashtable");
-  g_oai_log.thread_context_htbl = hashtable_ts_create (LOG_MESSAGE_MIN_ALLOC_SIZE, NULL, free_wrapper, b);
-  bdestroy(b);
-  AssertFatal (NULL != g_oai_log.thread_context_htbl, "Could not create hashtable for Log!\n");
-  g_oai_log.thread_context_htbl->log_enabled = false;
-
-
-  log_thread_ctxt_t *thread_ctxt = calloc(1, sizeof(log_thread_ctxt_t));
-  AssertFatal(NULL != thread_ctxt, "Error Could not create log thread context\n");
-  pthread_t p = pthread_self();
-  thread_ctxt->tid = p;
-  hashtable_rc_t hash_rc = hashtable_ts_insert(g_oai_log.thread_context_htbl, (hash_key_t) p, thread_ctxt);
-  if (HASH_TABLE_OK != hash_rc) {
-    OAI_FPRINTF_ERR("Error Could not register log thread context\n");
-    free_wrapper((void**) &thread_ctxt);
-  }
-
-  rv = lfds611_stack_new (&g_oai_log.log_free_message_queue_p, (lfds611_atom_t) max_threadsP + 2);
-
-  if (0 >= rv) {
-    AssertFatal (0, "lfds611_stack_new failed!\n");
-  }
-
-  rv = lfds611_queue_new (&g_oai_log.log_message_queue_p, (lfds611_atom_t) LOG_MAX_QUEUE_ELEMENTS);
-  AssertFatal (rv, "lfds611_queue_new failed!\n");
-  AssertFatal (g_oai_log.log_message_queue_p != NULL, "g_oai_log.log_message_queue_p is NULL!\n");
+  pthread_mutex_init (&g_oai_log.flush_mutex, NULL);
   log_start_use ();
 
-  for (i = 0; i < max_threadsP * 30; i++) {
-    item_p = new_queue_item();
-    rv = lfds611_stack_guaranteed_push (g_oai_log.log_free_message_queue_p, item_p);
-    AssertFatal (rv, "lfds611_stack_guaranteed_push failed for item %u\n", i);
-  }
-
   rv = snprintf (&g_oai_log.log_proto2str[LOG_SCTP][0], LOG_MAX_PROTO_NAME_LENGTH, "SCTP");
   rv = snprintf (&g_oai_log.log_proto2str[LOG_UDP][0], LOG_MAX_PROTO_NAME_LENGTH, "UDP");
   rv = snprintf (&g_oai_log.log_proto2str[LOG_GTPV1U][0], LOG_MAX_PROTO_NAME_LENGTH, "GTPv1-U");
@@ -492,7 +829,7 @@ log_init (
     g_oai_log.log_level2str[i][LOG_LEVEL_NAME_MAX_LENGTH-1]     = '\0';
   }
 
-  log_message (thread_ctxt, OAILOG_LEVEL_INFO, LOG_UTIL, __FILE__, __LINE__, "Initializing OAI logging Done\n");
+  log_message (NULL, OAILOG_LEVEL_INFO, LOG_UTIL, __FILE__, __LINE__, "Initializing OAI logging Done\n");
   return 0;
 }
 
@@ -513,23 +850,7 @@ void
 log_start_use (
   void)
 {
-  pthread_t      p       = pthread_self();
-  hashtable_rc_t hash_rc = hashtable_ts_is_key_exists (g_oai_log.thread_context_htbl, (hash_key_t) p);
-  if (HASH_TABLE_KEY_NOT_EXISTS == hash_rc) {
-    lfds611_queue_use (g_oai_log.log_message_queue_p);
-    lfds611_stack_use (g_oai_log.log_free_message_queue_p);
-    log_thread_ctxt_t *thread_ctxt = calloc(1, sizeof(log_thread_ctxt_t));
-    if (thread_ctxt) {
-      thread_ctxt->tid = p;
-      hash_rc = hashtable_ts_insert(g_oai_log.thread_context_htbl, (hash_key_t) p, thread_ctxt);
-      if (HASH_TABLE_OK != hash_rc) {
-        OAI_FPRINTF_ERR("Error Could not register log thread context\n");
-        free_wrapper((void**) &thread_ctxt);
-      }
-    } else {
-      OAI_FPRINTF_ERR("Error Could not create log thread context\n");
-    }
-  }
+  log_get_thread();
 }
 
 //------------------------------------------------------------------------------
@@ -539,36 +860,50 @@ log_flush_messages (
 {
   int                                     rv = 0;
   int                                     rv_put = 0;
+  uint32_t                                head = 0;
+  uint32_t                                dropped = 0;
   log_queue_item_t                       *item_p = NULL;
-
-  if (g_oai_log.log_fd) {
-    while ((rv = lfds611_queue_dequeue (g_oai_log.log_message_queue_p, (void **)&item_p)) == 1) {
-      rv_put = 0;
-      if (blength(item_p->bstr) > 0) {
-        if (g_oai_log.is_output_is_fd) {
-          rv_put = fputs ((const char *)item_p->bstr->data, g_oai_log.log_fd);
-        } else {
-          syslog (item_p->log_level ,"%s", bdata(item_p->bstr));
-        }
-      }
-      btrunc(item_p->bstr, 0);
-      rv = lfds611_stack_guaranteed_push (g_oai_log.log_free_message_queue_p, item_p);
-      if (rv_put < 0) {
-        // error occured
-        OAI_FPRINTF_ERR("Error while writing log %d\n", rv_put);
-        rv = fclose (g_oai_log.log_fd);
-        if (rv != 0) {
-          OAI_FPRINTF_ERR("Error while closing Log file stream: %s\n", strerror (errno));
+  log_thread_t                           *thread = NULL;
+
+  if ((g_oai_log.log_fd) || (!g_oai_log.is_output_is_fd)) {
+    pthread_mutex_lock (&g_oai_log.flush_mutex);
+    for (thread = g_oai_log.threads; thread; thread = thread->next) {
+      head = __atomic_load_n (&thread->head, __ATOMIC_ACQUIRE);
+      while (thread->tail != head) {
+        item_p = &thread->items[thread->tail % LOG_MAX_QUEUE_ELEMENTS];
+        rv_put = log_write_item(item_p);
+        if (512 < item_p->bstr->mlen) {
+          bdestroy(item_p->bstr);
+          item_p->bstr = NULL;
         }
-        // do not exit
-        if (LOG_TCP_STATE_DISABLED != g_oai_log.tcp_state) {
-          // Let ITTI LOG Timer do the reconnection
-          g_oai_log.tcp_state = LOG_TCP_STATE_NOT_CONNECTED;
+        __atomic_store_n (&thread->tail, thread->tail + 1, __ATOMIC_RELEASE);
+        if (rv_put < 0) {
+          // error occured
+          OAI_FPRINTF_ERR("Error while writing log %d\n", rv_put);
+          rv = fclose (g_oai_log.log_fd);
+          if (rv != 0) {
+            OAI_FPRINTF_ERR("Error while closing Log file stream: %s\n", strerror (errno));
+          }
+          g_oai_log.log_fd = NULL;
+          // do not exit
+          if (LOG_TCP_STATE_DISABLED != g_oai_log.tcp_state) {
+            // Let ITTI LOG Timer do the reconnection
+            g_oai_log.tcp_state = LOG_TCP_STATE_NOT_CONNECTED;
+          }
+          pthread_mutex_unlock (&g_oai_log.flush_mutex);
           return;
         }
       }
+      dropped = thread->dropped;
+      if (dropped != thread->dropped_reported) {
+        OAI_FPRINTF_ERR("Thread %08lX: %u log messages dropped, log ring full\n", thread->ctxt.tid, dropped - thread->dropped_reported);
+        thread->dropped_reported = dropped;
+      }
     }
-    fflush (g_oai_log.log_fd);
+    if (g_oai_log.log_fd) {
+      fflush (g_oai_log.log_fd);
+    }
+    pthread_mutex_unlock (&g_oai_log.flush_mutex);
   }
 }
 
@@ -593,6 +928,7 @@ log_exit (
     if (rv != 0) {
       OAI_FPRINTF_ERR("Error while closing Log file: %s", strerror (errno));
     }
+    g_oai_log.log_fd = NULL;
   }
 #if DAEMONIZE
   closelog();
@@ -617,17 +953,7 @@ void log_stream_hex(
   log_queue_item_t  * message = NULL;
   size_t              octet_index = 0;
   int                 rv = 0;
-  log_thread_ctxt_t  *thread_ctxt = NULL;
-  hashtable_rc_t      hash_rc = HASH_TABLE_OK;
-
-  pthread_t             p           = pthread_self();
-  hash_rc = hashtable_ts_get (g_oai_log.thread_context_htbl, (hash_key_t) p, (void **)&thread_ctxt);
-  if (HASH_TABLE_KEY_NOT_EXISTS == hash_rc) {
-    // make the thread safe LFDS collections usable by this thread
-    log_start_use();
-  }
-  hash_rc = hashtable_ts_get (g_oai_log.thread_context_htbl, (hash_key_t) p, (void **)&thread_ctxt);
-  AssertFatal(NULL != thread_ctxt, "Could not get new log thread context\n");
+  log_thread_ctxt_t  *thread_ctxt = &log_get_thread()->ctxt;
   if (messageP) {
     log_message_start(thread_ctxt, log_levelP, protoP, &message, source_fileP, line_numP, "%s (%ld bytes)", messageP, sizeP);
   } else {
@@ -659,17 +985,7 @@ void log_stream_hex_array(
   log_queue_item_t *  message = NULL;
   size_t              octet_index = 0;
   size_t              index = 0;
-  log_thread_ctxt_t  *thread_ctxt = NULL;
-  hashtable_rc_t      hash_rc = HASH_TABLE_OK;
-
-  pthread_t             p           = pthread_self();
-  hash_rc = hashtable_ts_get (g_oai_log.thread_context_htbl, (hash_key_t) p, (void **)&thread_ctxt);
-  if (HASH_TABLE_KEY_NOT_EXISTS == hash_rc) {
-    // make the thread safe LFDS collections usable by this thread
-    log_start_use();
-  }
-  hash_rc = hashtable_ts_get (g_oai_log.thread_context_htbl, (hash_key_t) p, (void **)&thread_ctxt);
-  AssertFatal(NULL != thread_ctxt, "Could not get new log thread context\n");
+  log_thread_ctxt_t  *thread_ctxt = &log_get_thread()->ctxt;
 
   if (messageP) {
     log_message(thread_ctxt, log_levelP, protoP, source_fileP, line_numP, "%s", messageP);
@@ -737,26 +1053,9 @@ log_message_finish (
     if (BSTR_ERR == rv) {
       OAI_FPRINTF_ERR("Error while logging message\n");
     }
-    // send message
-    if (g_oai_log.is_output_fd_buffered) {
-      rv = lfds611_queue_enqueue (g_oai_log.log_message_queue_p, messageP);
-    } else {
-      if (g_oai_log.is_output_is_fd) {
-        fprintf(g_oai_log.log_fd, "%s", bdata(messageP->bstr));
-      } else {
-        syslog (messageP->log_level ,"%s", bdata(messageP->bstr));
-      }
-      rv = 0;
-    }
-
-    if (0 == rv) {
-      btrunc(messageP->bstr, 0);
-      rv = lfds611_stack_guaranteed_push (g_oai_log.log_free_message_queue_p, messageP);
-      if (0 == rv) {
-        bdestroy(messageP->bstr);
-        free_wrapper ((void**) &messageP);
-      }
-    }
+    log_send_text(log_get_thread(), messageP);
+    bdestroy(messageP->bstr);
+    free_wrapper ((void**) &messageP);
   }
 }
 
@@ -774,9 +1073,7 @@ log_message_start (
 {
   va_list                                 args;
   int                                     rv              = 0;
-  int                                     filename_length = 0;
-  log_thread_ctxt_t                      *thread_ctxt     = thread_ctxtP;
-  hashtable_rc_t                          hash_rc         = HASH_TABLE_OK;
+  log_thread_t                           *thread          = NULL;
 
   if ((MIN_LOG_PROTOS > protoP) || (MAX_LOG_PROTOS <= protoP)) {
     return;
@@ -788,76 +1085,31 @@ log_message_start (
     return;
   }
 
-  if (NULL == thread_ctxt){
-    pthread_t             p           = pthread_self();
-    hash_rc = hashtable_ts_get (g_oai_log.thread_context_htbl, (hash_key_t) p, (void **)&thread_ctxt);
-    if (HASH_TABLE_KEY_NOT_EXISTS == hash_rc) {
-      // make the thread safe LFDS collections usable by this thread
-      log_start_use();
-      hash_rc = hashtable_ts_get (g_oai_log.thread_context_htbl, (hash_key_t) p, (void **)&thread_ctxt);
-      AssertFatal(NULL != thread_ctxt, "Could not get new log thread context\n");
-    }
-  }
+  thread = (thread_ctxtP) ? LOG_THREAD(thread_ctxtP) : log_get_thread();
 
   if (! *messageP) {
-    rv = lfds611_stack_pop (g_oai_log.log_free_message_queue_p, (void **)messageP);
+    // the message is composed out of the ring, see log_message_finish()
+    *messageP = new_queue_item();
 
-    if (0 == rv) {
-      *messageP = new_queue_item();
-      AssertFatal(*messageP, "Out of memory error");
-      OAI_FPRINTF_ERR("Warning allocating an extra log_queue_item_t in LOG\n");
-      rv = 1;
-    } else {
-      btrunc((*messageP)->bstr, 0);
+    rv = log_format_header(thread, *messageP, log_levelP, protoP, source_fileP, line_numP);
+    if (BSTR_ERR == rv) {
+      OAI_FPRINTF_ERR("Error while logging message : %s", &g_oai_log.log_proto2str[protoP][0]);
+      goto error_event_start;
     }
 
-    if (1 == rv) {
-      struct timeval elapsed_time;
-
-#if DAEMONIZE
-      (*messageP)->log_level = log_levelP;
-#endif
-      log_get_elapsed_time_since_start(&elapsed_time);
-      filename_length = strlen(source_fileP);
-      if (filename_length > LOG_DISPLAYED_FILENAME_MAX_LENGTH) {
-        rv = bformata ((*messageP)->bstr, "%06" PRIu64 " %05ld:%06ld %08lX %-*.*s %-*.*s %-*.*s:%04u   %*s",
-            __sync_fetch_and_add (&g_oai_log.log_message_number, 1), elapsed_time.tv_sec, elapsed_time.tv_usec,
-            thread_ctxt->tid,
-            LOG_DISPLAYED_LOG_LEVEL_NAME_MAX_LENGTH, LOG_DISPLAYED_LOG_LEVEL_NAME_MAX_LENGTH, &g_oai_log.log_level2str[log_levelP][0],
-            LOG_DISPLAYED_PROTO_NAME_MAX_LENGTH, LOG_DISPLAYED_PROTO_NAME_MAX_LENGTH, &g_oai_log.log_proto2str[protoP][0],
-            LOG_DISPLAYED_FILENAME_MAX_LENGTH, LOG_DISPLAYED_FILENAME_MAX_LENGTH, &source_fileP[filename_length-LOG_DISPLAYED_FILENAME_MAX_LENGTH], line_numP,
-            thread_ctxt->indent, " ");
-      } else {
-        rv = bformata ((*messageP)->bstr, "%06" PRIu64 " %05ld:%06ld %08lX %-*.*s %-*.*s %-*.*s:%04u   %*s",
-            __sync_fetch_and_add (&g_oai_log.log_message_number, 1), elapsed_time.tv_sec, elapsed_time.tv_usec,
-            thread_ctxt->tid,
-            LOG_DISPLAYED_LOG_LEVEL_NAME_MAX_LENGTH, LOG_DISPLAYED_LOG_LEVEL_NAME_MAX_LENGTH, &g_oai_log.log_level2str[log_levelP][0],
-            LOG_DISPLAYED_PROTO_NAME_MAX_LENGTH, LOG_DISPLAYED_PROTO_NAME_MAX_LENGTH, &g_oai_log.log_proto2str[protoP][0],
-            LOG_DISPLAYED_FILENAME_MAX_LENGTH, LOG_DISPLAYED_FILENAME_MAX_LENGTH, source_fileP, line_numP,
-            thread_ctxt->indent, " ");
-      }
-
-      if (BSTR_ERR == rv) {
-        OAI_FPRINTF_ERR("Error while logging message : %s", &g_oai_log.log_proto2str[protoP][0]);
-        goto error_event_start;
-      }
-
-      va_start (args, format);
-      rv = bformata ((*messageP)->bstr, format, args);
-      va_end (args);
+    va_start (args, format);
+    rv = bvcformata ((*messageP)->bstr, 4096, format, args); // big number, see bvcformata
+    va_end (args);
 
-      if (BSTR_ERR == rv) {
-        OAI_FPRINTF_ERR("Error while logging message : %s", &g_oai_log.log_proto2str[protoP][0]);
-        goto error_event_start;
-      }
-      return;
+    if (BSTR_ERR == rv) {
+      OAI_FPRINTF_ERR("Error while logging message : %s", &g_oai_log.log_proto2str[protoP][0]);
+      goto error_event_start;
     }
   }
   return;
 error_event_start:
-  // put in memory pool the message buffer
-  btrunc((*messageP)->bstr, 0);
-  rv = lfds611_stack_guaranteed_push (g_oai_log.log_free_message_queue_p, *messageP);
+  bdestroy((*messageP)->bstr);
+  free_wrapper ((void**) messageP);
   return;
 }
 
@@ -871,17 +1123,7 @@ log_func (
   const unsigned int line_numP,
   const char *const functionP)
 {
-  log_thread_ctxt_t        *thread_ctxt = NULL;
-  hashtable_rc_t            hash_rc     = HASH_TABLE_OK;
-  pthread_t                 p           = pthread_self();
-
-  hash_rc = hashtable_ts_get (g_oai_log.thread_context_htbl, (hash_key_t) p, (void **)&thread_ctxt);
-  if (HASH_TABLE_KEY_NOT_EXISTS == hash_rc) {
-    // make the thread safe LFDS collections usable by this thread
-    log_start_use();
-  }
-  hash_rc = hashtable_ts_get (g_oai_log.thread_context_htbl, (hash_key_t) p, (void **)&thread_ctxt);
-  AssertFatal(NULL != thread_ctxt, "Could not get new log thread context\n");
+  log_thread_ctxt_t        *thread_ctxt = &log_get_thread()->ctxt;
   if (is_enteringP) {
     log_message(thread_ctxt, OAILOG_LEVEL_TRACE, protoP, source_fileP, line_numP, "Entering %s()\n", functionP);
     thread_ctxt->indent += LOG_FUNC_INDENT_SPACES;
@@ -901,17 +1143,7 @@ log_func_return (
   const char *const functionP,
   const long return_codeP)
 {
-  log_thread_ctxt_t        *thread_ctxt = NULL;
-  hashtable_rc_t            hash_rc     = HASH_TABLE_OK;
-  pthread_t                 p           = pthread_self();
-
-  hash_rc = hashtable_ts_get (g_oai_log.thread_context_htbl, (hash_key_t) p, (void **)&thread_ctxt);
-  if (HASH_TABLE_KEY_NOT_EXISTS == hash_rc) {
-    // make the thread safe LFDS collections usable by this thread
-    log_start_use();
-  }
-  hash_rc = hashtable_ts_get (g_oai_log.thread_context_htbl, (hash_key_t) p, (void **)&thread_ctxt);
-  AssertFatal(NULL != thread_ctxt, "Could not get new log thread context\n");
+  log_thread_ctxt_t        *thread_ctxt = &log_get_thread()->ctxt;
   thread_ctxt->indent -= LOG_FUNC_INDENT_SPACES;
   if (thread_ctxt->indent < 0) thread_ctxt->indent = 0;
   log_message(thread_ctxt, OAILOG_LEVEL_TRACE, protoP, source_fileP, line_numP, "Leaving %s() (rc=%ld)\n", functionP, return_codeP);
@@ -929,10 +1161,8 @@ log_message (
 {
   va_list                                 args;
   int                                     rv              = 0;
-  int                                     filename_length = 0;
   log_queue_item_t                       *new_item_p      = NULL;
-  log_thread_ctxt_t                      *thread_ctxt     = thread_ctxtP;
-  hashtable_rc_t                          hash_rc         = HASH_TABLE_OK;
+  log_thread_t                           *thread          = NULL;
 
   if ((MIN_LOG_PROTOS > protoP) || (MAX_LOG_PROTOS <= protoP)) {
     return;
@@ -943,98 +1173,36 @@ log_message (
   if (log_levelP > g_oai_log.log_level[protoP]) {
     return;
   }
-  if (NULL == thread_ctxt){
-    pthread_t             p           = pthread_self();
-    hash_rc = hashtable_ts_get (g_oai_log.thread_context_htbl, (hash_key_t) p, (void **)&thread_ctxt);
-    if (HASH_TABLE_KEY_NOT_EXISTS == hash_rc) {
-      // make the thread safe LFDS collections usable by this thread
-      log_start_use();
-      hash_rc = hashtable_ts_get (g_oai_log.thread_context_htbl, (hash_key_t) p, (void **)&thread_ctxt);
-      AssertFatal(NULL != thread_ctxt, "Could not get new log thread context\n");
-    }
-  }
 
-  rv = lfds611_stack_pop (g_oai_log.log_free_message_queue_p, (void **)&new_item_p);
+  thread = (thread_ctxtP) ? LOG_THREAD(thread_ctxtP) : log_get_thread();
 
-  if (0 == rv) {
-    new_item_p = new_queue_item();
-    AssertFatal(new_item_p, "Out of memory error");
-    OAI_FPRINTF_ERR("Warning allocating an extra log_queue_item_t in LOG\n");
-    rv = 1;
-  } else {
-    btrunc(new_item_p->bstr, 0); // you never know
+  if (g_oai_log.is_output_binary) {
+    va_start (args, format);
+    log_binary_message(thread, log_levelP, protoP, source_fileP, line_numP, format, args);
+    va_end (args);
+    return;
   }
 
-  if (new_item_p) {
-    if (1 == rv) {
-      struct timeval elapsed_time;
-      log_get_elapsed_time_since_start(&elapsed_time);
-      filename_length = strlen(source_fileP);
-      if (filename_length > LOG_DISPLAYED_FILENAME_MAX_LENGTH) {
-        rv = bassignformat (new_item_p->bstr, "%06" PRIu64 " %05ld:%06ld %08lX %-*.*s %-*.*s %-*.*s:%04u   %*s",
-            __sync_fetch_and_add (&g_oai_log.log_message_number, 1), elapsed_time.tv_sec, elapsed_time.tv_usec,
-            thread_ctxt->tid,
-            LOG_DISPLAYED_LOG_LEVEL_NAME_MAX_LENGTH, LOG_DISPLAYED_LOG_LEVEL_NAME_MAX_LENGTH, &g_oai_log.log_level2str[log_levelP][0],
-            LOG_DISPLAYED_PROTO_NAME_MAX_LENGTH, LOG_DISPLAYED_PROTO_NAME_MAX_LENGTH, &g_oai_log.log_proto2str[protoP][0],
-            LOG_DISPLAYED_FILENAME_MAX_LENGTH, LOG_DISPLAYED_FILENAME_MAX_LENGTH, &source_fileP[filename_length-LOG_DISPLAYED_FILENAME_MAX_LENGTH], line_numP,
-            thread_ctxt->indent, " ");
-      } else {
-        rv = bassignformat (new_item_p->bstr, "%06" PRIu64 " %05ld:%06ld %08lX %-*.*s %-*.*s %-*.*s:%04u   %*s",
-            __sync_fetch_and_add (&g_oai_log.log_message_number, 1), elapsed_time.tv_sec, elapsed_time.tv_usec,
-            thread_ctxt->tid,
-            LOG_DISPLAYED_LOG_LEVEL_NAME_MAX_LENGTH, LOG_DISPLAYED_LOG_LEVEL_NAME_MAX_LENGTH, &g_oai_log.log_level2str[log_levelP][0],
-            LOG_DISPLAYED_PROTO_NAME_MAX_LENGTH, LOG_DISPLAYED_PROTO_NAME_MAX_LENGTH, &g_oai_log.log_proto2str[protoP][0],
-            LOG_DISPLAYED_FILENAME_MAX_LENGTH, LOG_DISPLAYED_FILENAME_MAX_LENGTH, source_fileP, line_numP,
-            thread_ctxt->indent, " ");
-      }
-
-      if (BSTR_ERR == rv) {
-        OAI_FPRINTF_ERR("Error while logging LOG message : %s", &g_oai_log.log_proto2str[protoP][0]);
-        goto error_event;
-      }
-      va_start (args, format);
-      rv = bvcformata (new_item_p->bstr, 4096, format, args); // big number
-      va_end (args);
-
-      if (BSTR_ERR == rv) {
-        OAI_FPRINTF_ERR("Error while logging LOG message : %s", &g_oai_log.log_proto2str[protoP][0]);
-        goto error_event;
-      }
+  new_item_p = log_get_item(thread);
+  if (NULL == new_item_p) {
+    // ring full, counted in thread->dropped
+    return;
+  }
 
-      if (g_oai_log.is_output_fd_buffered) {
-        rv = lfds611_queue_enqueue (g_oai_log.log_message_queue_p, new_item_p);
-      } else {
-        if (g_oai_log.is_output_is_fd) {
-          fprintf(g_oai_log.log_fd, "%s", bdata(new_item_p->bstr));
-        } else {
-          syslog (new_item_p->log_level ,"%s", bdata(new_item_p->bstr));
-        }
-        rv = 0;
-      }
-      if (0 == rv) {
-        btrunc(new_item_p->bstr, 0);
-        rv = lfds611_stack_guaranteed_push (g_oai_log.log_free_message_queue_p, new_item_p);
-        if (0 == rv) {
-          OAI_FPRINTF_ERR("Error while logging LOG message : lfds611_stack_guaranteed_push %s", &g_oai_log.log_proto2str[protoP][0]);
-          bdestroy (new_item_p->bstr);
-          free_wrapper ((void**) &new_item_p);
-        }
-      }
-    } else {
-      AssertFatal(0, "Should not go here");
-      bdestroy (new_item_p->bstr);
-      free_wrapper ((void**) &new_item_p);
-      OAI_FPRINTF_ERR("Error while lfds611_stack_pop()\n");
-    }
+  rv = log_format_header(thread, new_item_p, log_levelP, protoP, source_fileP, line_numP);
+  if (BSTR_ERR == rv) {
+    OAI_FPRINTF_ERR("Error while logging LOG message : %s", &g_oai_log.log_proto2str[protoP][0]);
+    btrunc(new_item_p->bstr, 0);
+    return;
   }
+  va_start (args, format);
+  rv = bvcformata (new_item_p->bstr, 4096, format, args); // big number
+  va_end (args);
 
-  return;
-error_event:
-  btrunc(new_item_p->bstr, 0);
-  rv = lfds611_stack_guaranteed_push (g_oai_log.log_free_message_queue_p, new_item_p);
-  if (0 == rv) {
-    bdestroy (new_item_p->bstr);
-    free_wrapper ((void**) &new_item_p);
+  if (BSTR_ERR == rv) {
+    OAI_FPRINTF_ERR("Error while logging LOG message : %s", &g_oai_log.log_proto2str[protoP][0]);
+    btrunc(new_item_p->bstr, 0);
+    return;
   }
+  log_send_item(thread, new_item_p);
 }
-
@@ -49,6 +49,7 @@ extern int fd_g_debug_lvl;
 #define LOG_CONFIG_STRING_LOGGING                        "LOGGING"
 #define LOG_CONFIG_STRING_OUTPUT                         "OUTPUT"
 #define LOG_CONFIG_STRING_OUTPUT_THREAD_SAFE             "THREAD_SAFE"
+#define LOG_CONFIG_STRING_OUTPUT_BINARY                  "BINARY"
 #define LOG_CONFIG_STRING_COLOR                          "COLOR"
 #define LOG_CONFIG_STRING_OUTPUT_CONSOLE                 "CONSOLE"
 #define LOG_CONFIG_STRING_OUTPUT_SYSLOG                  "SYSLOG"
@@ -135,6 +136,7 @@ typedef struct log_queue_item_s {
 typedef struct log_config_s {
   bstring       output;             /*!< \brief Where logs go, choice in { "CONSOLE", "`path to file`", "`IPv4@`:`TCP port num`"} . */
   bool          is_output_thread_safe; /*!< \brief Is final string goes in a thread safe buffer of is flushed without care . */
+  bool          is_output_binary;   /*!< \brief Binary records (see log_binary.h) instead of text, for file and TCP outputs, read them with oai_log_decoder . */
   log_level_t   udp_log_level;      /*!< \brief UDP ITTI task log level starting from OAILOG_LEVEL_EMERGENCY up to MAX_LOG_LEVEL (no log) */
   log_level_t   gtpv1u_log_level;   /*!< \brief GTPv1-U ITTI task log level starting from OAILOG_LEVEL_EMERGENCY up to MAX_LOG_LEVEL (no log) */
   log_level_t   gtpv2c_log_level;   /*!< \brief GTPv2-C ITTI task log level starting from OAILOG_LEVEL_EMERGENCY up to MAX_LOG_LEVEL (no log) */
@@ -232,6 +234,8 @@ void log_message (
 
 int log_get_start_time_sec (void);
 
+bool log_is_enabled (const log_level_t log_levelP, const log_proto_t protoP);
+
 #    define OAILOG_SET_CONFIG                                           log_set_config
 #    define OAILOG_LEVEL_STR2INT                                        log_level_str2int
 #    define OAILOG_LEVEL_INT2STR                                        log_level_int2str
@@ -239,6 +243,7 @@ int log_get_start_time_sec (void);
 #    define OAILOG_START_USE                                            log_start_use
 #    define OAILOG_ITTI_CONNECT                                         log_itti_connect
 #    define OAILOG_EXIT()                                               log_exit()
+#    define OAILOG_IS_ENABLED(lOgLeVeL, pRoTo)                          log_is_enabled(lOgLeVeL, pRoTo) /*!< \brief test before building costly log content */
 #    define OAILOG_SPEC(pRoTo, ...)                                     do { log_message(NULL, OAILOG_LEVEL_NOTICE,   pRoTo, __FILE__, __LINE__, ##__VA_ARGS__); } while(0)/*!< \brief 3GPP trace on specifications */
 #    define OAILOG_EMERGENCY(pRoTo, ...)                                do { log_message(NULL, OAILOG_LEVEL_EMERGENCY,pRoTo, __FILE__, __LINE__, ##__VA_ARGS__); } while(0)/*!< \brief system is unusable */
 #    define OAILOG_ALERT(pRoTo, ...)                                    do { log_message(NULL, OAILOG_LEVEL_ALERT,    pRoTo, __FILE__, __LINE__, ##__VA_ARGS__); } while(0) /*!< \brief action must be taken immediately */
@@ -275,6 +280,7 @@ int log_get_start_time_sec (void);
 #    define OAILOG_START_USE()
 #    define OAILOG_ITTI_CONNECT()
 #    define OAILOG_EXIT()
+#    define OAILOG_IS_ENABLED(lOgLeVeL, pRoTo)                          (false)
 #    define OAILOG_EMERGENCY(...)
 #    define OAILOG_ALERT(...)
 #    define OAILOG_CRITICAL(...)
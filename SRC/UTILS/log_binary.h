@@ -0,0 +1,223 @@
+/*
+ * Copyright (c) 2015, EURECOM (www.eurecom.fr)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those
+ * of the authors and should not be interpreted as representing official policies,
+ * either expressed or implied, of the FreeBSD Project.
+ */
+
+/*! \file log_binary.h
+   \brief Binary log records, written by log.c when BINARY output is configured and read back by oai_log_decoder.
+   A binary log starts with a log_binary_file_header_t followed by records, each one starting with a
+   log_binary_record_header_t. Messages carry the address of their format string and source file name
+   plus the raw values of their arguments, strings are sent once per thread in LOG_BINARY_RECORD_STRING records.
+   Records are in host byte order, decode them on a host with the same byte order.
+*/
+
+#ifndef FILE_LOG_BINARY_SEEN
+#define FILE_LOG_BINARY_SEEN
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <ctype.h>
+#include <string.h>
+
+#define LOG_DISPLAYED_FILENAME_MAX_LENGTH       32
+#define LOG_DISPLAYED_LOG_LEVEL_NAME_MAX_LENGTH  5
+#define LOG_DISPLAYED_PROTO_NAME_MAX_LENGTH      6
+
+/* message number, elapsed time, thread id, level, proto, file:line, indentation */
+#define LOG_HEADER_FORMAT                       "%06" PRIu64 " %05ld:%06ld %08lX %-*.*s %-*.*s %-*.*s:%04u   %*s"
+
+#define LOG_BINARY_MAGIC                        "OAILOGB1"
+#define LOG_BINARY_BYTE_ORDER                   0x01020304
+#define LOG_BINARY_RECORD_MAX_LENGTH            (1024 * 1024)
+#define LOG_BINARY_STRING_MAX_LENGTH            4096
+#define LOG_BINARY_STRING_NULL                  UINT32_MAX
+
+typedef struct log_binary_file_header_s {
+  char                                    magic[8];             /*!< \brief LOG_BINARY_MAGIC */
+  uint32_t                                byte_order;           /*!< \brief LOG_BINARY_BYTE_ORDER in host byte order */
+  uint32_t                                header_length;        /*!< \brief sizeof(log_binary_file_header_t) */
+  int64_t                                 start_time_sec;       /*!< \brief log_get_start_time_sec() */
+} log_binary_file_header_t;
+
+typedef enum {
+  LOG_BINARY_RECORD_LEVEL_NAME = 1,     /*!< \brief header.level + name */
+  LOG_BINARY_RECORD_PROTO_NAME,         /*!< \brief header.proto + name */
+  LOG_BINARY_RECORD_STRING,             /*!< \brief log_binary_string_t: format string or source file name */
+  LOG_BINARY_RECORD_MESSAGE,            /*!< \brief log_binary_message_t followed by the arguments */
+  LOG_BINARY_RECORD_TEXT,               /*!< \brief already formatted message (OAILOG_MESSAGE_START/ADD/FINISH, hex dumps) */
+} log_binary_record_type_t;
+
+typedef struct log_binary_record_header_s {
+  uint32_t                                length;               /*!< \brief length of the record, this header included */
+  uint8_t                                 type;                 /*!< \brief log_binary_record_type_t */
+  uint8_t                                 level;
+  uint8_t                                 proto;
+  uint8_t                                 reserved;
+} log_binary_record_header_t;
+
+typedef struct log_binary_string_s {
+  log_binary_record_header_t              header;
+  uint64_t                                id;                   /*!< \brief address of the string in the logging process */
+  char                                    string[0];            /*!< \brief not NULL terminated */
+} log_binary_string_t;
+
+/*
+ * The arguments follow, one by conversion of the format string, in order:
+ * the '*' width and precision then the value, 8 bytes each, as int64_t
+ * (integers, pointers) or double (floating point values). A string is a
+ * uint32_t length (or LOG_BINARY_STRING_NULL) followed by its characters.
+ */
+typedef struct log_binary_message_s {
+  log_binary_record_header_t              header;
+  uint64_t                                number;               /*!< \brief message number */
+  uint64_t                                time_us;              /*!< \brief microseconds since start_time_sec */
+  uint64_t                                tid;
+  uint64_t                                file_id;              /*!< \brief log_binary_string_t id of the source file name */
+  uint64_t                                format_id;            /*!< \brief log_binary_string_t id of the format */
+  uint32_t                                line;
+  uint32_t                                indent;
+  uint8_t                                 args[0];
+} log_binary_message_t;
+
+typedef enum {
+  LOG_BINARY_ARG_NONE = 0,              /*!< \brief "%%", "%m" */
+  LOG_BINARY_ARG_INT,
+  LOG_BINARY_ARG_LONG,
+  LOG_BINARY_ARG_LONG_LONG,
+  LOG_BINARY_ARG_SIZE,
+  LOG_BINARY_ARG_PTRDIFF,
+  LOG_BINARY_ARG_INTMAX,
+  LOG_BINARY_ARG_DOUBLE,
+  LOG_BINARY_ARG_LONG_DOUBLE,
+  LOG_BINARY_ARG_POINTER,               /*!< \brief "%p", "%n" (not written), "%ls" (not decoded) */
+  LOG_BINARY_ARG_STRING,
+} log_binary_arg_type_t;
+
+typedef struct log_binary_conversion_s {
+  const char                             *start;                /*!< \brief '%' of the conversion in the format */
+  int                                     length;               /*!< \brief from '%' to the conversion character included */
+  bool                                    width_is_star;
+  bool                                    precision_is_star;
+  int                                     precision;            /*!< \brief -1 if not specified */
+  char                                    conversion;
+  log_binary_arg_type_t                   type;
+} log_binary_conversion_t;
+
+//------------------------------------------------------------------------------
+/* Finds the next printf conversion of format, returns the position after it or NULL if there is none */
+static inline const char *
+log_binary_next_conversion (
+  const char *format,
+  log_binary_conversion_t * conversion)
+{
+  char                                    length_modifier;
+
+  while (*format) {
+    if ('%' != *format++) {
+      continue;
+    }
+
+    conversion->start = format - 1;
+    conversion->width_is_star = false;
+    conversion->precision_is_star = false;
+    conversion->precision = -1;
+    conversion->type = LOG_BINARY_ARG_NONE;
+    length_modifier = 0;
+
+    while (*format && strchr ("-+ #0'I", *format)) {
+      format++;
+    }
+
+    if ('*' == *format) {
+      conversion->width_is_star = true;
+      format++;
+    } else {
+      while (isdigit (*format)) format++;
+    }
+
+    if ('.' == *format) {
+      format++;
+      if ('*' == *format) {
+        conversion->precision_is_star = true;
+        format++;
+      } else {
+        conversion->precision = 0;
+        while (isdigit (*format)) conversion->precision = 10 * conversion->precision + (*format++ - '0');
+      }
+    }
+
+    while (*format && strchr ("hlLqjzZt", *format)) {
+      // "ll" and "q" are both long long
+      length_modifier = (('l' == length_modifier) && ('l' == *format)) ? 'q' : *format;
+      format++;
+    }
+
+    conversion->conversion = *format;
+    if (*format) {
+      format++;
+    }
+    conversion->length = format - conversion->start;
+
+    switch (conversion->conversion) {
+    case 'd': case 'i': case 'o': case 'u': case 'x': case 'X':
+      switch (length_modifier) {
+      case 'l': conversion->type = LOG_BINARY_ARG_LONG; break;
+      case 'q': case 'L': conversion->type = LOG_BINARY_ARG_LONG_LONG; break;
+      case 'z': case 'Z': conversion->type = LOG_BINARY_ARG_SIZE; break;
+      case 't': conversion->type = LOG_BINARY_ARG_PTRDIFF; break;
+      case 'j': conversion->type = LOG_BINARY_ARG_INTMAX; break;
+      default: conversion->type = LOG_BINARY_ARG_INT; break;
+      }
+      break;
+
+    case 'c':
+      conversion->type = LOG_BINARY_ARG_INT;
+      break;
+
+    case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case 'a': case 'A':
+      conversion->type = ('L' == length_modifier) ? LOG_BINARY_ARG_LONG_DOUBLE : LOG_BINARY_ARG_DOUBLE;
+      break;
+
+    case 's':
+      conversion->type = ('l' == length_modifier) ? LOG_BINARY_ARG_POINTER : LOG_BINARY_ARG_STRING;
+      break;
+
+    case 'p': case 'n':
+      conversion->type = LOG_BINARY_ARG_POINTER;
+      break;
+
+    default:
+      conversion->type = LOG_BINARY_ARG_NONE;
+      break;
+    }
+    return format;
+  }
+  return NULL;
+}
+
+#endif /* FILE_LOG_BINARY_SEEN */
@@ -0,0 +1,388 @@
+/*
+ * Copyright (c) 2015, EURECOM (www.eurecom.fr)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those
+ * of the authors and should not be interpreted as representing official policies,
+ * either expressed or implied, of the FreeBSD Project.
+ */
+
+/*! \file log_decoder.c
+   \brief Converts a binary log (BINARY = "yes" in the LOGGING section of the configuration file) into the text log.
+   usage: oai_log_decoder [binary log file], reads the standard input by default.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "log_binary.h"
+
+#define LOG_DECODER_MAX_NAMES         256
+#define LOG_DECODER_MAX_SPEC_LENGTH   64
+
+typedef struct log_decoder_string_s {
+  uint64_t                                id;
+  char                                   *string;
+} log_decoder_string_t;
+
+typedef struct log_decoder_s {
+  FILE                                   *input;
+  char                                   *level_names[LOG_DECODER_MAX_NAMES];
+  char                                   *proto_names[LOG_DECODER_MAX_NAMES];
+  // open addressing, id 0 means free
+  log_decoder_string_t                   *strings;
+  uint64_t                                strings_size;
+  uint64_t                                strings_number;
+  uint8_t                                *record;
+} log_decoder_t;
+
+//------------------------------------------------------------------------------
+static log_decoder_string_t *
+log_decoder_find_string (
+  log_decoder_t * decoder,
+  uint64_t id)
+{
+  uint64_t                                i = (id * UINT64_C(0x9E3779B97F4A7C15)) & (decoder->strings_size - 1);
+
+  while ((decoder->strings[i].id) && (decoder->strings[i].id != id)) {
+    i = (i + 1) & (decoder->strings_size - 1);
+  }
+  return &decoder->strings[i];
+}
+
+//------------------------------------------------------------------------------
+static const char *
+log_decoder_get_string (
+  log_decoder_t * decoder,
+  uint64_t id)
+{
+  log_decoder_string_t                   *entry = log_decoder_find_string (decoder, id);
+
+  return (entry->id) ? entry->string : NULL;
+}
+
+//------------------------------------------------------------------------------
+static void
+log_decoder_add_string (
+  log_decoder_t * decoder,
+  uint64_t id,
+  const char *string,
+  size_t length)
+{
+  log_decoder_string_t                   *entry = NULL;
+  log_decoder_string_t                   *old_strings = decoder->strings;
+  uint64_t                                old_size = decoder->strings_size;
+
+  if (2 * (decoder->strings_number + 1) > decoder->strings_size) {
+    decoder->strings_size = (old_size) ? 2 * old_size : 1024;
+    decoder->strings = calloc (decoder->strings_size, sizeof (log_decoder_string_t));
+    if (NULL == decoder->strings) {
+      fprintf (stderr, "Out of memory\n");
+      exit (EXIT_FAILURE);
+    }
+    for (uint64_t i = 0; i < old_size; i++) {
+      if (old_strings[i].id) {
+        *log_decoder_find_string (decoder, old_strings[i].id) = old_strings[i];
+      }
+    }
+    free (old_strings);
+  }
+
+  // the same address may be sent by each thread, or reused by another string after a dlclose()
+  entry = log_decoder_find_string (decoder, id);
+  if (entry->id) {
+    free (entry->string);
+  } else {
+    decoder->strings_number++;
+  }
+  entry->id = id;
+  entry->string = strndup (string, length);
+}
+
+//------------------------------------------------------------------------------
+static bool
+log_decoder_get_arg (
+  const uint8_t ** args,
+  const uint8_t * end,
+  void *value,
+  size_t size)
+{
+  if ((size_t)(end - *args) < size) {
+    return false;
+  }
+  memcpy (value, *args, size);
+  *args += size;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+/* Prints the message the way log_message() would have formatted it */
+static void
+log_decoder_print_message (
+  log_decoder_t * decoder,
+  const log_binary_message_t * message)
+{
+  const uint8_t                          *args = message->args;
+  const uint8_t                          *end = (const uint8_t *)message + message->header.length;
+  const char                             *file = log_decoder_get_string (decoder, message->file_id);
+  const char                             *format = log_decoder_get_string (decoder, message->format_id);
+  const char                             *level = decoder->level_names[message->header.level];
+  const char                             *proto = decoder->proto_names[message->header.proto];
+  const char                             *next = NULL;
+  log_binary_conversion_t                 conversion;
+  char                                    spec[LOG_DECODER_MAX_SPEC_LENGTH];
+  int64_t                                 stars[2];
+  int                                     nb_stars = 0;
+  int64_t                                 value = 0;
+  double                                  dvalue = 0;
+  uint32_t                                length = 0;
+  char                                   *string = NULL;
+  size_t                                  file_length = 0;
+
+  file = (file) ? file : "<unknown file>";
+  file_length = strlen (file);
+  if (file_length > LOG_DISPLAYED_FILENAME_MAX_LENGTH) {
+    file = &file[file_length - LOG_DISPLAYED_FILENAME_MAX_LENGTH];
+  }
+  printf (LOG_HEADER_FORMAT,
+      message->number, (long)(message->time_us / 1000000), (long)(message->time_us % 1000000),
+      (unsigned long)message->tid,
+      LOG_DISPLAYED_LOG_LEVEL_NAME_MAX_LENGTH, LOG_DISPLAYED_LOG_LEVEL_NAME_MAX_LENGTH, (level) ? level : "?",
+      LOG_DISPLAYED_PROTO_NAME_MAX_LENGTH, LOG_DISPLAYED_PROTO_NAME_MAX_LENGTH, (proto) ? proto : "?",
+      LOG_DISPLAYED_FILENAME_MAX_LENGTH, LOG_DISPLAYED_FILENAME_MAX_LENGTH, file, message->line,
+      (int)message->indent, " ");
+
+  if (NULL == format) {
+    // the string record was lost (ring full)
+    printf ("<format of message %" PRIu64 " not received>\n", message->number);
+    return;
+  }
+
+  while ((next = log_binary_next_conversion (format, &conversion))) {
+    fwrite (format, conversion.start - format, 1, stdout);
+    format = next;
+
+    if ((LOG_DECODER_MAX_SPEC_LENGTH <= conversion.length) || ('\0' == conversion.conversion)) {
+      fwrite (conversion.start, conversion.length, 1, stdout);
+      continue;
+    }
+    memcpy (spec, conversion.start, conversion.length);
+    spec[conversion.length] = '\0';
+
+    nb_stars = 0;
+    if ((conversion.width_is_star) && (!log_decoder_get_arg (&args, end, &stars[nb_stars++], sizeof (int64_t)))) {
+      goto truncated;
+    }
+    if ((conversion.precision_is_star) && (!log_decoder_get_arg (&args, end, &stars[nb_stars++], sizeof (int64_t)))) {
+      goto truncated;
+    }
+
+    if (LOG_BINARY_ARG_STRING == conversion.type) {
+      if (!log_decoder_get_arg (&args, end, &length, sizeof (length))) {
+        goto truncated;
+      }
+      if (LOG_BINARY_STRING_NULL == length) {
+        string = strdup ("(null)");
+      } else if ((size_t)(end - args) < length) {
+        goto truncated;
+      } else {
+        string = strndup ((const char *)args, length);
+        args += length;
+      }
+      if (2 == nb_stars) printf (spec, (int)stars[0], (int)stars[1], string);
+      else if (1 == nb_stars) printf (spec, (int)stars[0], string);
+      else printf (spec, string);
+      free (string);
+      continue;
+    }
+
+    if (LOG_BINARY_ARG_NONE == conversion.type) {
+      // "%%", or something log_message() would not have handled either
+      if ('%' == conversion.conversion) {
+        putchar ('%');
+      } else {
+        fputs (spec, stdout);
+      }
+      continue;
+    }
+
+    if (!log_decoder_get_arg (&args, end, &value, sizeof (value))) {
+      goto truncated;
+    }
+    memcpy (&dvalue, &value, sizeof (dvalue));
+
+#define LOG_DECODER_PRINTF(vAlUe) do {                                           \
+      if (2 == nb_stars) printf (spec, (int)stars[0], (int)stars[1], vAlUe);     \
+      else if (1 == nb_stars) printf (spec, (int)stars[0], vAlUe);               \
+      else printf (spec, vAlUe);                                                 \
+    } while (0)
+
+    switch (conversion.type) {
+    case LOG_BINARY_ARG_INT:         LOG_DECODER_PRINTF ((int)value); break;
+    case LOG_BINARY_ARG_LONG:        LOG_DECODER_PRINTF ((long)value); break;
+    case LOG_BINARY_ARG_LONG_LONG:   LOG_DECODER_PRINTF ((long long)value); break;
+    case LOG_BINARY_ARG_SIZE:        LOG_DECODER_PRINTF ((size_t)value); break;
+    case LOG_BINARY_ARG_PTRDIFF:     LOG_DECODER_PRINTF ((ptrdiff_t)value); break;
+    case LOG_BINARY_ARG_INTMAX:      LOG_DECODER_PRINTF ((intmax_t)value); break;
+    case LOG_BINARY_ARG_DOUBLE:      LOG_DECODER_PRINTF (dvalue); break;
+    case LOG_BINARY_ARG_LONG_DOUBLE: LOG_DECODER_PRINTF ((long double)dvalue); break;
+    case LOG_BINARY_ARG_POINTER:
+      if ('n' == conversion.conversion) {
+        // nothing printed
+      } else if ('s' == conversion.conversion) {
+        printf ("<wide string %p>", (void *)(uintptr_t)value);
+      } else {
+        LOG_DECODER_PRINTF ((void *)(uintptr_t)value);
+      }
+      break;
+    default:
+      break;
+    }
+#undef LOG_DECODER_PRINTF
+  }
+  fputs (format, stdout);
+  return;
+
+truncated:
+  printf ("<truncated message %" PRIu64 ">\n", message->number);
+}
+
+//------------------------------------------------------------------------------
+static bool
+log_decoder_read_file_header (
+  log_decoder_t * decoder,
+  const uint8_t * first_bytes)
+{
+  log_binary_file_header_t                file_header;
+
+  memcpy (&file_header, first_bytes, sizeof (log_binary_record_header_t));
+  if (1 != fread ((uint8_t *)&file_header + sizeof (log_binary_record_header_t), sizeof (file_header) - sizeof (log_binary_record_header_t), 1, decoder->input)) {
+    return false;
+  }
+  if (memcmp (file_header.magic, LOG_BINARY_MAGIC, sizeof (file_header.magic))) {
+    fprintf (stderr, "Not a binary log\n");
+    return false;
+  }
+  if (LOG_BINARY_BYTE_ORDER != file_header.byte_order) {
+    fprintf (stderr, "Binary log written by a host with a different byte order\n");
+    return false;
+  }
+  if (sizeof (file_header) > file_header.header_length) {
+    fprintf (stderr, "Unsupported binary log header length %u\n", file_header.header_length);
+    return false;
+  }
+  // fields added by newer versions, the input may be a pipe
+  for (uint32_t i = sizeof (file_header); i < file_header.header_length; i++) {
+    if (EOF == fgetc (decoder->input)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+int
+main (
+  int argc,
+  char *argv[])
+{
+  log_decoder_t                           decoder = {0};
+  log_binary_record_header_t             *header = NULL;
+  const char                             *payload = NULL;
+  size_t                                  payload_length = 0;
+  char                                  **names = NULL;
+
+  if (argc > 2) {
+    fprintf (stderr, "usage: %s [binary log file]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+  decoder.input = (argc > 1) ? fopen (argv[1], "r") : stdin;
+  if (NULL == decoder.input) {
+    perror (argv[1]);
+    return EXIT_FAILURE;
+  }
+  decoder.record = malloc (LOG_BINARY_RECORD_MAX_LENGTH);
+  if (NULL == decoder.record) {
+    fprintf (stderr, "Out of memory\n");
+    return EXIT_FAILURE;
+  }
+  header = (log_binary_record_header_t *) decoder.record;
+
+  while (1 == fread (header, sizeof (*header), 1, decoder.input)) {
+    // a new output stream starts (log file reopened, TCP reconnection)
+    if (0 == memcmp (header, LOG_BINARY_MAGIC, sizeof (*header))) {
+      if (!log_decoder_read_file_header (&decoder, decoder.record)) {
+        return EXIT_FAILURE;
+      }
+      continue;
+    }
+    if ((sizeof (*header) > header->length) || (LOG_BINARY_RECORD_MAX_LENGTH < header->length)) {
+      fprintf (stderr, "Corrupted binary log, record length %u\n", header->length);
+      return EXIT_FAILURE;
+    }
+    if ((header->length > sizeof (*header)) && (1 != fread (header + 1, header->length - sizeof (*header), 1, decoder.input))) {
+      fprintf (stderr, "Truncated binary log\n");
+      break;
+    }
+    payload = (const char *)(header + 1);
+    payload_length = header->length - sizeof (*header);
+
+    switch (header->type) {
+    case LOG_BINARY_RECORD_LEVEL_NAME:
+    case LOG_BINARY_RECORD_PROTO_NAME:
+      names = (LOG_BINARY_RECORD_LEVEL_NAME == header->type) ? &decoder.level_names[header->level] : &decoder.proto_names[header->proto];
+      free (*names);
+      *names = strndup (payload, payload_length);
+      break;
+
+    case LOG_BINARY_RECORD_STRING:
+      if (header->length >= sizeof (log_binary_string_t)) {
+        log_binary_string_t *string = (log_binary_string_t *) header;
+
+        log_decoder_add_string (&decoder, string->id, string->string, header->length - sizeof (log_binary_string_t));
+      }
+      break;
+
+    case LOG_BINARY_RECORD_MESSAGE:
+      if (header->length >= sizeof (log_binary_message_t)) {
+        log_decoder_print_message (&decoder, (log_binary_message_t *) header);
+      }
+      break;
+
+    case LOG_BINARY_RECORD_TEXT:
+      fwrite (payload, payload_length, 1, stdout);
+      break;
+
+    default:
+      // record type unknown by this version of the decoder, skip it
+      break;
+    }
+  }
+  free (decoder.record);
+  return EXIT_SUCCESS;
+}
@@ -55,6 +55,13 @@
 
 #define S6A_CONF_FILE "../S6A/freediameter/s6a.conf"
 
+/*******************************************************************************
+ * NAS Constants
+ ******************************************************************************/
+
+#define NAS_AUTH_VECTORS_PER_REQUEST (1)   ///< E-UTRAN vectors requested by AIR
+#define NAS_AUTH_VECTORS_TTL         (600) ///< Lifetime of a prefetched vector (s)
+
 /*******************************************************************************
  * SCTP Constants
  ******************************************************************************/
@@ -63,6 +70,15 @@
 #define SCTP_OUT_STREAMS      (32)
 #define SCTP_IN_STREAMS       (32)
 #define SCTP_MAX_ATTEMPTS     (5)
+#define SCTP_RECEIVE_THREADS  (1)     ///< Threads receiving on the SCTP associations
+#define SCTP_MAX_RECEIVE_THREADS (16) ///< Upper bound of the configured receive threads
+
+/*******************************************************************************
+ * S11 Constants
+ ******************************************************************************/
+
+#define S11_SHARDS            (1)     ///< GTPv2-C stack instances (tasks) of the S11 interface
+#define S11_MAX_SHARDS        (4)     ///< Upper bound of the configured S11 shards, TASK_S11 and TASK_S11_SHARD_x
 
 /*******************************************************************************
  * MME global definitions
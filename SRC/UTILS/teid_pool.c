@@ -0,0 +1,201 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under 
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.  
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file teid_pool.c
+  \brief Allocator of unique local TEIDs (S11, S1-U)
+*/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common_defs.h"
+#include "teid_pool.h"
+
+#define WORD_BITS 64
+#define WORD_BIT(iNDEX) (1ull << ((iNDEX) & (WORD_BITS - 1)))
+
+//------------------------------------------------------------------------------
+static uint32_t _teid_pool_index (const teid_pool_t * const pool, const uint32_t teid)
+{
+  if (teid_pool_shard (teid, pool->shard_bits) != teid_pool_shard (pool->prefix, pool->shard_bits)) {
+    return 0;
+  }
+  return teid & pool->size;
+}
+
+//------------------------------------------------------------------------------
+/* Extends the bitmap of the live TEIDs to index */
+static int _teid_pool_grow_allocated (teid_pool_t * const pool, const uint32_t index)
+{
+  uint32_t                                nb_words = pool->nb_words ? pool->nb_words : 16;
+  uint64_t                               *allocated = NULL;
+
+  while ((uint64_t)nb_words * WORD_BITS <= index) {
+    nb_words *= 2;
+  }
+  if ((allocated = realloc (pool->allocated, nb_words * sizeof (uint64_t))) == NULL) {
+    return RETURNerror;
+  }
+  memset (&allocated[pool->nb_words], 0, (nb_words - pool->nb_words) * sizeof (uint64_t));
+  pool->allocated = allocated;
+  pool->nb_words = nb_words;
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+/* Doubles the ring of the released indexes, unwrapped */
+static int _teid_pool_grow_released (teid_pool_t * const pool)
+{
+  uint32_t                                capacity = pool->released_capacity ? 2 * pool->released_capacity : TEID_POOL_REUSE_DELAY;
+  uint32_t                               *released = NULL;
+
+  if ((released = malloc (capacity * sizeof (uint32_t))) == NULL) {
+    return RETURNerror;
+  }
+  for (uint32_t i = 0; i < pool->nb_released; i++) {
+    released[i] = pool->released[(pool->released_first + i) % pool->released_capacity];
+  }
+  free (pool->released);
+  pool->released = released;
+  pool->released_capacity = capacity;
+  pool->released_first = 0;
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+int teid_pool_init (teid_pool_t * const pool, const uint8_t shard_bits, const uint32_t shard_id)
+{
+  memset (pool, 0, sizeof (*pool));
+  if ((shard_bits > TEID_POOL_MAX_SHARD_BITS) || ((uint64_t)shard_id >= (1ull << shard_bits))) {
+    return RETURNerror;
+  }
+  pool->shard_bits = shard_bits;
+  pool->prefix = shard_bits ? (shard_id << (32 - shard_bits)) : 0;
+  pool->size = 0xFFFFFFFF >> shard_bits;
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+void teid_pool_free (teid_pool_t * const pool)
+{
+  free (pool->allocated);
+  free (pool->released);
+  memset (pool, 0, sizeof (*pool));
+}
+
+//------------------------------------------------------------------------------
+uint32_t teid_pool_allocate (teid_pool_t * const pool)
+{
+  uint32_t                                index = 0;
+
+  if ((pool->nb_released >= TEID_POOL_REUSE_DELAY) || ((pool->nb_used == pool->size) && (pool->nb_released > 0))) {
+    index = pool->released[pool->released_first];
+    pool->released_first = (pool->released_first + 1) % pool->released_capacity;
+    pool->nb_released--;
+  } else if (pool->nb_used < pool->size) {
+    if (((uint64_t)pool->nb_used + 1 >= (uint64_t)pool->nb_words * WORD_BITS) && (_teid_pool_grow_allocated (pool, pool->nb_used + 1) != RETURNok)) {
+      return INVALID_TEID;
+    }
+    index = ++pool->nb_used;
+  } else {
+    return INVALID_TEID;
+  }
+  pool->allocated[index / WORD_BITS] |= WORD_BIT (index);
+  pool->nb_allocated++;
+  return pool->prefix | index;
+}
+
+//------------------------------------------------------------------------------
+int teid_pool_release (teid_pool_t * const pool, const uint32_t teid)
+{
+  uint32_t                                index = _teid_pool_index (pool, teid);
+
+  if (!teid_pool_is_allocated (pool, teid)) {
+    return RETURNerror;
+  }
+  if ((pool->nb_released == pool->released_capacity) && (_teid_pool_grow_released (pool) != RETURNok)) {
+    return RETURNerror;
+  }
+  pool->allocated[index / WORD_BITS] &= ~WORD_BIT (index);
+  pool->released[(pool->released_first + pool->nb_released) % pool->released_capacity] = index;
+  pool->nb_released++;
+  pool->nb_allocated--;
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+bool teid_pool_is_allocated (const teid_pool_t * const pool, const uint32_t teid)
+{
+  uint32_t                                index = _teid_pool_index (pool, teid);
+
+  if ((index == 0) || (index > pool->nb_used)) {
+    return false;
+  }
+  return (pool->allocated[index / WORD_BITS] & WORD_BIT (index)) != 0;
+}
+
+//------------------------------------------------------------------------------
+int teid_shards_init (teid_shards_t * const shards, const uint32_t nb_shards)
+{
+  memset (shards, 0, sizeof (*shards));
+  if ((nb_shards == 0) || (nb_shards > TEID_SHARDS_MAX) || (nb_shards & (nb_shards - 1))) {
+    return RETURNerror;
+  }
+  shards->nb_shards = nb_shards;
+  for (uint32_t i = 0; i < nb_shards; i++) {
+    teid_pool_init (&shards->pools[i], teid_pool_shard_bits (nb_shards), i);
+  }
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+void teid_shards_free (teid_shards_t * const shards)
+{
+  for (uint32_t i = 0; i < shards->nb_shards; i++) {
+    teid_pool_free (&shards->pools[i]);
+  }
+  memset (shards, 0, sizeof (*shards));
+}
+
+//------------------------------------------------------------------------------
+uint32_t teid_shards_allocate (teid_shards_t * const shards)
+{
+  // the shards are used in turn, an exhausted shard is skipped
+  for (uint32_t i = 0; i < shards->nb_shards; i++) {
+    uint32_t                                teid = teid_pool_allocate (&shards->pools[shards->next_shard]);
+
+    shards->next_shard = (shards->next_shard + 1) & (shards->nb_shards - 1);
+    if (teid != INVALID_TEID) {
+      return teid;
+    }
+  }
+  return INVALID_TEID;
+}
+
+//------------------------------------------------------------------------------
+int teid_shards_release (teid_shards_t * const shards, const uint32_t teid)
+{
+  if (shards->nb_shards == 0) {
+    return RETURNerror;
+  }
+  return teid_pool_release (&shards->pools[teid_pool_shard (teid, teid_pool_shard_bits (shards->nb_shards))], teid);
+}
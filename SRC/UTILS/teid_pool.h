@@ -0,0 +1,91 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under 
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.  
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file teid_pool.h
+  \brief Allocator of unique local TEIDs (S11, S1-U)
+
+  A pool hands out the TEIDs of one shard: the shard id is in the
+  shard_bits high bits of the TEID, the other bits index the TEID in the
+  shard, so the owner of a TEID is found with teid_pool_shard() without a
+  lookup. A pool is used by a single thread or task, one pool per thread
+  gives lock-free allocations; TEID 0 is never allocated.
+  Allocation and release are O(1). The live TEIDs are tracked in a bitmap
+  sized by the highest index handed out, released TEIDs are reused oldest
+  first once TEID_POOL_REUSE_DELAY TEIDs wait for reuse, so that a late
+  packet of a deleted tunnel does not hit the next one, and the memory
+  follows the peak of live TEIDs instead of the TEID space.
+  The teid_shards_t group the pools of all the shards of an interface when a
+  single thread allocates the TEIDs of several shards.
+*/
+#ifndef FILE_TEID_POOL_SEEN
+#define FILE_TEID_POOL_SEEN
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define TEID_POOL_MAX_SHARD_BITS 16
+#define TEID_POOL_REUSE_DELAY    1024
+#define INVALID_TEID             0
+#define TEID_SHARDS_MAX          16
+
+typedef struct teid_pool_s {
+  uint8_t          shard_bits;
+  uint32_t         prefix;          // shard id in the high bits
+  uint32_t         size;            // TEIDs of the shard, indexes 1..size
+  uint32_t         nb_used;         // highest index handed out
+  uint32_t         nb_allocated;    // live TEIDs
+  uint64_t        *allocated;       // bit per index of the live TEIDs, up to nb_used
+  uint32_t         nb_words;
+  uint32_t        *released;        // ring of the released indexes, oldest first
+  uint32_t         released_capacity;
+  uint32_t         released_first;
+  uint32_t         nb_released;
+} teid_pool_t;
+
+typedef struct teid_shards_s {
+  uint32_t         nb_shards;       // power of 2
+  uint32_t         next_shard;      // shard of the next teid_shards_allocate()
+  teid_pool_t      pools[TEID_SHARDS_MAX];
+} teid_shards_t;
+
+int      teid_pool_init         (teid_pool_t * const pool, const uint8_t shard_bits, const uint32_t shard_id);
+void     teid_pool_free         (teid_pool_t * const pool);
+uint32_t teid_pool_allocate     (teid_pool_t * const pool);
+int      teid_pool_release      (teid_pool_t * const pool, const uint32_t teid);
+bool     teid_pool_is_allocated (const teid_pool_t * const pool, const uint32_t teid);
+
+int      teid_shards_init       (teid_shards_t * const shards, const uint32_t nb_shards);
+void     teid_shards_free       (teid_shards_t * const shards);
+uint32_t teid_shards_allocate   (teid_shards_t * const shards);
+int      teid_shards_release    (teid_shards_t * const shards, const uint32_t teid);
+
+static inline uint32_t teid_pool_shard (const uint32_t teid, const uint8_t shard_bits)
+{
+  return shard_bits ? (teid >> (32 - shard_bits)) : 0;
+}
+
+/* Shard bits of nb_shards shards, nb_shards is a power of 2 */
+static inline uint8_t teid_pool_shard_bits (const uint32_t nb_shards)
+{
+  return (nb_shards > 1) ? (uint8_t)__builtin_ctz (nb_shards) : 0;
+}
+
+#endif /* FILE_TEID_POOL_SEEN */